@@ -0,0 +1,335 @@
+#include "algebra/AdaptiveFilter.h"
+#include "algebra/Pipeline.h"
+#include "algebra/suboperators/ColumnFilter.h"
+#include "algebra/suboperators/sinks/CountingSink.h"
+#include "storage/Relation.h"
+#include <algorithm>
+#include <numeric>
+#include <stdexcept>
+#include <unordered_map>
+#include <unordered_set>
+
+namespace inkfuse {
+
+namespace {
+
+using Node = ExpressionOp::Node;
+using IURefNode = ExpressionOp::IURefNode;
+using ComputeNode = ExpressionOp::ComputeNode;
+
+/// Clone an expression DAG, replacing every referenced IU through the given mapping.
+Node* cloneNode(Node* node, const std::unordered_map<const IU*, const IU*>& ius, std::unordered_map<Node*, Node*>& cloned, std::vector<ExpressionOp::NodePtr>& nodes) {
+   if (auto it = cloned.find(node); it != cloned.end()) {
+      return it->second;
+   }
+   ExpressionOp::NodePtr result;
+   if (auto ref_node = dynamic_cast<IURefNode*>(node)) {
+      result = std::make_unique<IURefNode>(ius.at(ref_node->child));
+   } else {
+      auto compute_node = dynamic_cast<ComputeNode*>(node);
+      assert(compute_node);
+      std::vector<Node*> children;
+      for (auto child : compute_node->children) {
+         children.push_back(cloneNode(child, ius, cloned, nodes));
+      }
+      if (compute_node->code == ComputeNode::Type::Cast) {
+         result = std::make_unique<ComputeNode>(compute_node->output_type, children[0]);
+      } else if (compute_node->opt_runtime_param) {
+         result = std::make_unique<ComputeNode>(compute_node->code, (*compute_node->opt_runtime_param)->copy(), children[0]);
+      } else {
+         result = std::make_unique<ComputeNode>(compute_node->code, std::move(children));
+      }
+   }
+   auto raw = result.get();
+   nodes.push_back(std::move(result));
+   cloned[node] = raw;
+   return raw;
+}
+
+}
+
+ConjunctStatistics::ConjunctStatistics(size_t num_conjuncts_)
+   : rows_in(num_conjuncts_, 0), rows_out(num_conjuncts_, 0), cost_rows(num_conjuncts_, 0), cost_nanos(num_conjuncts_, 0) {
+}
+
+std::vector<size_t> ConjunctStatistics::order(const std::vector<double>& estimated_costs) {
+   assert(estimated_costs.size() == rows_in.size());
+   std::unique_lock lock(mut);
+   if (learned_order) {
+      return *learned_order;
+   }
+   std::vector<size_t> result(rows_in.size());
+   std::iota(result.begin(), result.end(), 0);
+   // Until the statistics settled, the conjuncts are evaluated in the specified order.
+   // The first conjunct thus always sees all rows.
+   if (rows_in.empty() || rows_in[0] < SETTLE_ROWS) {
+      return result;
+   }
+   // Measured and estimated costs have different units, only use the measurements if all conjuncts have one.
+   const bool measured = std::all_of(cost_rows.begin(), cost_rows.end(), [](size_t rows) { return rows > 0; });
+   std::vector<double> costs = estimated_costs;
+   if (measured) {
+      for (size_t k = 0; k < costs.size(); ++k) {
+         // Guard against timer resolution turning a cheap conjunct into a free one.
+         costs[k] = std::max(static_cast<double>(cost_nanos[k]) / cost_rows[k], 0.01);
+      }
+   }
+   // Rank the conjuncts by the fraction of rows they eliminate per unit of cost.
+   std::vector<double> rank(rows_in.size());
+   for (size_t k = 0; k < rows_in.size(); ++k) {
+      const double selectivity = rows_in[k] ? static_cast<double>(rows_out[k]) / rows_in[k] : 1.0;
+      rank[k] = (1.0 - selectivity) / costs[k];
+   }
+   std::stable_sort(result.begin(), result.end(), [&](size_t lhs, size_t rhs) {
+      return rank[lhs] > rank[rhs];
+   });
+   learned_order = result;
+   return result;
+}
+
+bool ConjunctStatistics::settled() const {
+   std::unique_lock lock(mut);
+   return learned_order.has_value();
+}
+
+void ConjunctStatistics::recordInput(size_t conjunct, size_t rows) {
+   std::unique_lock lock(mut);
+   rows_in[conjunct] += rows;
+}
+
+void ConjunctStatistics::recordOutput(size_t conjunct, size_t rows) {
+   std::unique_lock lock(mut);
+   rows_out[conjunct] += rows;
+}
+
+void ConjunctStatistics::recordCost(size_t conjunct, size_t rows, uint64_t nanos) {
+   std::unique_lock lock(mut);
+   cost_rows[conjunct] += rows;
+   cost_nanos[conjunct] += nanos;
+}
+
+std::optional<double> ConjunctStatistics::measuredCost(size_t conjunct) const {
+   std::unique_lock lock(mut);
+   if (cost_rows[conjunct] == 0) {
+      return {};
+   }
+   return static_cast<double>(cost_nanos[conjunct]) / cost_rows[conjunct];
+}
+
+double ConjunctStatistics::selectivity(size_t conjunct) const {
+   std::unique_lock lock(mut);
+   if (rows_in[conjunct] == 0) {
+      return 1.0;
+   }
+   return static_cast<double>(rows_out[conjunct]) / rows_in[conjunct];
+}
+
+std::unique_ptr<AdaptiveFilter> AdaptiveFilter::build(
+   std::vector<std::unique_ptr<RelAlgOp>> children_,
+   std::string op_name_,
+   std::vector<const IU*> redefined_,
+   std::vector<Conjunct> conjuncts_,
+   ConjunctStatisticsArc stats_) {
+   return std::unique_ptr<AdaptiveFilter>(new AdaptiveFilter(std::move(children_), std::move(op_name_), std::move(redefined_), std::move(conjuncts_), std::move(stats_)));
+}
+
+double AdaptiveFilter::estimateCost(const Conjunct& conjunct) {
+   double cost = 0.0;
+   for (const auto& node : conjunct.nodes) {
+      if (auto compute_node = dynamic_cast<const ComputeNode*>(node.get())) {
+         switch (compute_node->code) {
+            case ComputeNode::Type::StrEquals:
+            case ComputeNode::Type::InList:
+            case ComputeNode::Type::NotLikeTokens:
+            case ComputeNode::Type::Like:
+               // String processing touches every character of the row.
+               cost += 4.0;
+               break;
+            default:
+               cost += 1.0;
+         }
+      }
+   }
+   return std::max(cost, 1.0);
+}
+
+AdaptiveFilter::AdaptiveFilter(
+   std::vector<std::unique_ptr<RelAlgOp>> children_,
+   std::string op_name_,
+   std::vector<const IU*> redefined_,
+   std::vector<Conjunct> conjuncts_,
+   ConjunctStatisticsArc stats_)
+   : RelAlgOp(std::move(children_), std::move(op_name_)), stats(std::move(stats_)), to_redefine(std::move(redefined_)) {
+   if (conjuncts_.empty() || to_redefine.empty()) {
+      throw std::runtime_error("AdaptiveFilter needs conjuncts and redefined IUs");
+   }
+   if (!stats) {
+      stats = std::make_shared<ConjunctStatistics>(conjuncts_.size());
+   }
+   std::vector<double> costs;
+   for (const auto& conjunct : conjuncts_) {
+      costs.push_back(estimateCost(conjunct));
+   }
+   order = stats->order(costs);
+   count_rows = !stats->settled();
+
+   // Define the output IUs which we will use.
+   std::unordered_map<const IU*, const IU*> final_ius;
+   for (const IU* iu : to_redefine) {
+      assert(iu);
+      auto& new_iu = redefined.emplace_back(iu->type);
+      if (iu->null_indicator) {
+         // IUs can share indicators, which are only redefined once.
+         auto it = final_ius.find(iu->null_indicator);
+         if (it == final_ius.end()) {
+            it = final_ius.emplace(iu->null_indicator, &redefined_indicators.emplace_back(IR::Bool::build())).first;
+         }
+         new_iu.null_indicator = it->second;
+      }
+      final_ius[iu] = &new_iu;
+      output_ius.push_back(&new_iu);
+   }
+
+   // Every stage has to pass on the redefined IUs and the ones the later conjuncts depend on.
+   // `tracked` fixes the order of the IUs, `needed[pos]` are the ones required behind stage `pos`.
+   std::vector<const IU*> tracked;
+   std::unordered_set<const IU*> seen;
+   auto track = [&](const IU* iu, std::unordered_set<const IU*>& needed) {
+      for (const IU* tracked_iu : {iu, iu->null_indicator}) {
+         if (tracked_iu && seen.insert(tracked_iu).second) {
+            tracked.push_back(tracked_iu);
+         }
+         if (tracked_iu) {
+            needed.insert(tracked_iu);
+         }
+      }
+   };
+   std::vector<std::unordered_set<const IU*>> needed(order.size());
+   for (const IU* iu : to_redefine) {
+      track(iu, needed.back());
+   }
+   for (size_t pos = order.size() - 1; pos > 0; --pos) {
+      // Behind stage `pos - 1`, the conjunct of stage `pos` and everything after it is needed.
+      needed[pos - 1] = needed[pos];
+      for (const auto& node : conjuncts_[order[pos]].nodes) {
+         if (auto ref_node = dynamic_cast<const IURefNode*>(node.get())) {
+            track(ref_node->child, needed[pos - 1]);
+         }
+      }
+   }
+   // The first conjunct reads the input IUs directly.
+   for (const auto& node : conjuncts_[order[0]].nodes) {
+      if (auto ref_node = dynamic_cast<const IURefNode*>(node.get())) {
+         seen.insert(ref_node->child);
+      }
+   }
+
+   // Build the stages. The IUs flowing into the next stage are stored in `current`.
+   std::unordered_map<const IU*, const IU*> current;
+   for (const IU* iu : seen) {
+      current[iu] = iu;
+   }
+   for (size_t pos = 0; pos < order.size(); ++pos) {
+      const Conjunct& conjunct = conjuncts_[order[pos]];
+      std::vector<ExpressionOp::NodePtr> nodes;
+      std::unordered_map<Node*, Node*> cloned;
+      Node* root = cloneNode(conjunct.root, current, cloned, nodes);
+      auto& stage = stages.emplace_back(Stage{
+         .conjunct = order[pos],
+         .expression = ExpressionOp::build({}, op_name + "_conjunct_" + std::to_string(order[pos]), {root}, std::move(nodes)),
+         .pseudo_iu = IU(IR::Void::build()),
+      });
+      std::unordered_map<const IU*, const IU*> next;
+      if (pos + 1 == order.size()) {
+         // The last stage produces the outputs.
+         for (const IU* iu : tracked) {
+            if (auto it = final_ius.find(iu); it != final_ius.end()) {
+               stage.copies.emplace_back(current.at(iu), it->second);
+            }
+         }
+         next = final_ius;
+      } else {
+         std::vector<std::pair<const IU*, IU*>> created;
+         for (const IU* iu : tracked) {
+            if (!needed[pos].contains(iu)) {
+               continue;
+            }
+            auto& new_iu = intermediate_ius.emplace_back(iu->type);
+            stage.copies.emplace_back(current.at(iu), &new_iu);
+            created.emplace_back(iu, &new_iu);
+            next[iu] = &new_iu;
+         }
+         for (auto [iu, new_iu] : created) {
+            if (iu->null_indicator) {
+               new_iu->null_indicator = next.at(iu->null_indicator);
+            }
+         }
+      }
+      stage.counted = next.at(to_redefine[0]);
+      current = std::move(next);
+   }
+}
+
+std::optional<ValueRange> AdaptiveFilter::valueRange(const IU& iu) const {
+   size_t k = 0;
+   for (const IU& out : redefined) {
+      if (&out == &iu) {
+         return children[0]->valueRange(*to_redefine[k]);
+      }
+      k++;
+   }
+   return RelAlgOp::valueRange(iu);
+}
+
+void AdaptiveFilter::decay(PipelineDAG& dag) const {
+   // First decay the children.
+   assert(children.size() == 1);
+   children[0]->decay(dag);
+   auto& pipe = dag.getCurrentPipeline();
+   if (count_rows) {
+      // Count the rows entering the first conjunct.
+      pipe.attachSuboperator(CountingSink::build(*to_redefine[0], [stats = stats, conjunct = stages.front().conjunct](size_t rows) {
+         stats->recordInput(conjunct, rows);
+      }));
+   }
+   for (auto it = stages.begin(); it != stages.end(); ++it) {
+      const Stage& stage = *it;
+      // Evaluate the conjunct on the IUs that passed the previous stages.
+      const size_t first_subop = pipe.getSubops().size();
+      stage.expression->decay(dag);
+      if (count_rows) {
+         // Time the interpreted primitives of the conjunct. All of them see the same rows, only count these once.
+         for (size_t k = first_subop; k < pipe.getSubops().size(); ++k) {
+            pipe.getSubops()[k]->setCostCallback([stats = stats, conjunct = stage.conjunct, count = k == first_subop](size_t rows, uint64_t nanos) {
+               stats->recordCost(conjunct, count ? rows : 0, nanos);
+            });
+         }
+      }
+      const IU& filter_iu = *stage.expression->getOutput()[0];
+      // Attach the control flow sub-operator.
+      auto& scope_supop = pipe.attachSuboperator(ColumnFilterScope::build(this, filter_iu, stage.pseudo_iu));
+      auto& scope = reinterpret_cast<ColumnFilterScope&>(scope_supop);
+      // Attach the logic operators performing the copies.
+      for (auto [old_iu, new_iu] : stage.copies) {
+         auto logic = ColumnFilterLogic::build(this, stage.pseudo_iu, *old_iu, *new_iu);
+         scope.attachFilterLogicDependency(*logic, *old_iu);
+         pipe.attachSuboperator(std::move(logic));
+      }
+      if (count_rows) {
+         // The rows leaving this conjunct enter the next one.
+         auto next = std::next(it);
+         std::optional<size_t> next_conjunct;
+         if (next != stages.end()) {
+            next_conjunct = next->conjunct;
+         }
+         pipe.attachSuboperator(CountingSink::build(*stage.counted, [stats = stats, conjunct = stage.conjunct, next_conjunct](size_t rows) {
+            stats->recordOutput(conjunct, rows);
+            if (next_conjunct) {
+               stats->recordInput(*next_conjunct, rows);
+            }
+         }));
+      }
+   }
+}
+
+}
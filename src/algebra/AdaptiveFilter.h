@@ -0,0 +1,141 @@
+#ifndef INKFUSE_ADAPTIVEFILTER_H
+#define INKFUSE_ADAPTIVEFILTER_H
+
+#include "algebra/ExpressionOp.h"
+#include "algebra/RelAlgOp.h"
+#include <list>
+#include <memory>
+#include <mutex>
+#include <optional>
+
+namespace inkfuse {
+
+/// Observed selectivities of the conjuncts of an AdaptiveFilter. The statistics outlive a single
+/// query instance: every instance that evaluates the same filter records into them, and instances
+/// created later evaluate the conjuncts in the learned order.
+struct ConjunctStatistics {
+   explicit ConjunctStatistics(size_t num_conjuncts_);
+
+   /// Number of rows the first evaluated conjunct has to see before the order is fixed.
+   static constexpr size_t SETTLE_ROWS = 10'000;
+
+   /// Get the order in which the conjuncts should be evaluated. Until the statistics settled
+   /// this is the order in which the conjuncts were specified. Afterwards, the conjuncts are
+   /// ranked by the rows they eliminate per unit of cost, and the order is frozen.
+   /// The cost is the measured time per row if every conjunct was interpreted at least once,
+   /// otherwise the `estimated_costs` are used.
+   std::vector<size_t> order(const std::vector<double>& estimated_costs);
+   /// Did the statistics settle, i.e. is the evaluation order final?
+   bool settled() const;
+
+   /// Record that `rows` rows were evaluated by the given conjunct.
+   void recordInput(size_t conjunct, size_t rows);
+   /// Record that `rows` rows passed the given conjunct.
+   void recordOutput(size_t conjunct, size_t rows);
+   /// Record that interpreting the given conjunct on `rows` rows took `nanos` nanoseconds.
+   void recordCost(size_t conjunct, size_t rows, uint64_t nanos);
+   /// Observed selectivity of a conjunct. 1.0 if it did not see any rows yet.
+   double selectivity(size_t conjunct) const;
+   /// Measured nanoseconds per row of a conjunct. Empty if it was never interpreted.
+   std::optional<double> measuredCost(size_t conjunct) const;
+
+   private:
+   mutable std::mutex mut;
+   /// Rows evaluated by every conjunct.
+   std::vector<size_t> rows_in;
+   /// Rows that passed every conjunct.
+   std::vector<size_t> rows_out;
+   /// Rows on which the cost of every conjunct was measured.
+   std::vector<size_t> cost_rows;
+   /// Nanoseconds spent interpreting every conjunct.
+   std::vector<uint64_t> cost_nanos;
+   /// The frozen order once the statistics settled.
+   std::optional<std::vector<size_t>> learned_order;
+};
+
+using ConjunctStatisticsArc = std::shared_ptr<ConjunctStatistics>;
+
+/// Filter on a conjunction of boolean expressions. The conjuncts are evaluated one after another,
+/// every conjunct only sees the rows that passed the previous ones. Cheap and selective conjuncts
+/// should thus go first - which depends on the data and is rarely known when building the plan.
+///
+/// The filter counts the rows entering and leaving every conjunct and records them into
+/// the shared ConjunctStatistics. Morsels of the conjuncts that get interpreted are timed as
+/// well, which yields their cost per row. Once the statistics settled, new instances of the
+/// filter evaluate the conjuncts in the learned order and no longer count rows or time morsels.
+/// The order is fixed when the operator is built: a running instance never reorders its
+/// conjuncts, not even between interpreted morsels. The learned order takes effect when the
+/// query is planned again (e.g. through the PreparedQuery), which also generates the fused
+/// code for it.
+struct AdaptiveFilter : public RelAlgOp {
+   /// A single boolean conjunct evaluated on the input IUs.
+   struct Conjunct {
+      /// Expression nodes of the conjunct.
+      std::vector<ExpressionOp::NodePtr> nodes;
+      /// Node computing the boolean result.
+      ExpressionOp::Node* root;
+   };
+
+   static std::unique_ptr<AdaptiveFilter> build(
+      std::vector<std::unique_ptr<RelAlgOp>> children_,
+      std::string op_name_,
+      std::vector<const IU*> redefined_,
+      std::vector<Conjunct> conjuncts_,
+      ConjunctStatisticsArc stats_ = nullptr);
+
+   void decay(PipelineDAG& dag) const override;
+
+   /// Redefined IUs have the value range of the original IU.
+   std::optional<ValueRange> valueRange(const IU& iu) const override;
+
+   /// Get the order in which this instance evaluates the conjuncts.
+   const std::vector<size_t>& getOrder() const { return order; };
+
+   /// Estimate the relative cost of evaluating a conjunct on a single row. Only used if
+   /// the conjuncts were never interpreted, e.g. because the query only ran fused code.
+   static double estimateCost(const Conjunct& conjunct);
+
+   private:
+   AdaptiveFilter(
+      std::vector<std::unique_ptr<RelAlgOp>> children_,
+      std::string op_name_,
+      std::vector<const IU*> redefined_,
+      std::vector<Conjunct> conjuncts_,
+      ConjunctStatisticsArc stats_);
+
+   /// A single filter stage evaluating one conjunct.
+   struct Stage {
+      /// Index of the evaluated conjunct.
+      size_t conjunct;
+      /// Expression computing the conjunct on the IUs flowing into the stage.
+      std::unique_ptr<ExpressionOp> expression;
+      /// Pseudo IU passed between scoping and logic operator.
+      IU pseudo_iu;
+      /// (input, output) IUs which are copied by the filter of this stage. Only the IUs needed
+      /// by the later stages or the consumers of the filter are copied.
+      std::vector<std::pair<const IU*, const IU*>> copies;
+      /// IU whose rows are counted behind the stage.
+      const IU* counted;
+   };
+
+   /// Statistics shared between all instances of the filter.
+   ConjunctStatisticsArc stats;
+   /// Order in which the conjuncts are evaluated.
+   std::vector<size_t> order;
+   /// Should the rows flowing through the stages be counted?
+   bool count_rows;
+   /// IUs which have to be redefined.
+   std::vector<const IU*> to_redefine;
+   /// The filter stages in evaluation order.
+   std::list<Stage> stages;
+   /// IUs passed between the stages.
+   std::list<IU> intermediate_ius;
+   /// Redefined IUs after the filter.
+   std::list<IU> redefined;
+   /// Redefined NULL indicators after the filter.
+   std::list<IU> redefined_indicators;
+};
+
+}
+
+#endif //INKFUSE_ADAPTIVEFILTER_H
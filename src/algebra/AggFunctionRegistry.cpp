@@ -1,9 +1,16 @@
 #include "algebra/AggFunctionRegisty.h"
 #include "algebra/suboperators/aggregation/AggComputeAvg.h"
+#include "algebra/suboperators/aggregation/AggComputeHyperLogLog.h"
+#include "algebra/suboperators/aggregation/AggComputeQuantile.h"
 #include "algebra/suboperators/aggregation/AggComputeUnpack.h"
 #include "algebra/suboperators/aggregation/AggStateCount.h"
+#include "algebra/suboperators/aggregation/AggStateHyperLogLog.h"
+#include "algebra/suboperators/aggregation/AggStateMinMax.h"
+#include "algebra/suboperators/aggregation/AggStateQuantile.h"
 #include "algebra/suboperators/aggregation/AggStateSum.h"
 #include "algebra/suboperators/row_layout/KeyUnpackerSubop.h"
+#include <algorithm>
+#include <cmath>
 
 namespace inkfuse::AggregateFunctions {
 
@@ -26,13 +33,68 @@ RegistryEntry resolveCount(const IU& agg_iu) {
    return result;
 }
 
+/// Make the result of the aggregate NULL for groups without non-NULL input. The non-NULL
+/// inputs are counted in an additional granule, which is shared with count(x).
+void countNonNullInputs(const IU& agg_iu, RegistryEntry& result) {
+   if (agg_iu.null_indicator) {
+      result.non_null_count_granule = result.granules.size();
+      result.granules.push_back(std::make_unique<AggStateCount>());
+   }
+}
+
+/// Decimal sums are computed on 16 bytes with the full precision to not overflow.
+IR::TypeArc decimalSumType(const IR::Decimal& decimal) {
+   return IR::Decimal::build(IR::Decimal::MAX_PRECISION, decimal.getScale());
+}
+
 RegistryEntry resolveSum(const IU& agg_iu) {
+   RegistryEntry result;
+   if (auto decimal = dynamic_cast<IR::Decimal*>(agg_iu.type.get())) {
+      auto sum_type = decimalSumType(*decimal);
+      result = computeAsUnpack(sum_type);
+      result.granules.push_back(std::make_unique<AggStateSum>(agg_iu.type, std::move(sum_type)));
+   } else {
+      result = computeAsUnpack(agg_iu.type);
+      result.granules.push_back(std::make_unique<AggStateSum>(agg_iu.type));
+   }
+   // The sum over only NULLs is NULL.
+   countNonNullInputs(agg_iu, result);
+   return result;
+}
+
+RegistryEntry resolveMin(const IU& agg_iu) {
+   // The value is at the start of the state, reading it is a simple unpack.
    auto result = computeAsUnpack(agg_iu.type);
-   result.granules.push_back(std::make_unique<AggStateSum>(agg_iu.type));
+   result.granules.push_back(std::make_unique<AggStateMin>(agg_iu.type));
+   // The min over only NULLs is NULL.
+   countNonNullInputs(agg_iu, result);
+   return result;
+}
+
+RegistryEntry resolveMax(const IU& agg_iu) {
+   auto result = computeAsUnpack(agg_iu.type);
+   result.granules.push_back(std::make_unique<AggStateMax>(agg_iu.type));
+   // The max over only NULLs is NULL.
+   countNonNullInputs(agg_iu, result);
    return result;
 }
 
 RegistryEntry resolveAvg(const IU& agg_iu) {
+   if (auto decimal = dynamic_cast<IR::Decimal*>(agg_iu.type.get())) {
+      // Decimal averages are exact with a few more fractional digits.
+      const size_t scale = std::min(decimal->getScale() + AggComputeAvg::AVG_EXTRA_SCALE, IR::Decimal::MAX_PRECISION);
+      auto sum_type = decimalSumType(*decimal);
+      RegistryEntry result;
+      result.result_type = IR::Decimal::build(IR::Decimal::MAX_PRECISION, scale);
+      result.agg_reader = std::make_unique<AggComputeAvg>(sum_type);
+      result.granules.push_back(std::make_unique<AggStateSum>(agg_iu.type, std::move(sum_type)));
+      result.granules.push_back(std::make_unique<AggStateCount>());
+      // The average over only NULLs is NULL, the count granule already counts the non-NULL inputs.
+      if (agg_iu.null_indicator) {
+         result.non_null_count_granule = 1;
+      }
+      return result;
+   }
    RegistryEntry result;
    // Avg always returns a double in InkFuse.
    result.result_type = IR::Float::build(8);
@@ -41,6 +103,42 @@ RegistryEntry resolveAvg(const IU& agg_iu) {
    // the count state.
    result.granules.push_back(std::make_unique<AggStateSum>(agg_iu.type));
    result.granules.push_back(std::make_unique<AggStateCount>());
+   if (agg_iu.null_indicator) {
+      result.non_null_count_granule = 1;
+   }
+   return result;
+}
+
+RegistryEntry resolveApproxCountDistinct(const IU& agg_iu) {
+   RegistryEntry result;
+   result.result_type = IR::SignedInt::build(8);
+   result.agg_reader = std::make_unique<AggComputeHyperLogLog>();
+   result.granules.push_back(std::make_unique<AggStateHyperLogLog>(agg_iu.type));
+   return result;
+}
+
+RegistryEntry resolveMedian(const IU& agg_iu) {
+   RegistryEntry result;
+   result.result_type = IR::Float::build(8);
+   result.agg_reader = std::make_unique<AggComputeMedian>();
+   result.granules.push_back(std::make_unique<AggStateMedian>(agg_iu.type));
+   // The median over only NULLs is NULL.
+   countNonNullInputs(agg_iu, result);
+   return result;
+}
+
+RegistryEntry resolveApproxQuantile(const IU& agg_iu, double quantile) {
+   // The interpreter has fragments for every whole percentile.
+   const double percentile = std::round(quantile * 100);
+   if (percentile < 0 || percentile > 100 || std::abs(quantile * 100 - percentile) > 1e-6) {
+      throw std::runtime_error("Approximate quantiles have to be whole percentiles between 0 and 1");
+   }
+   RegistryEntry result;
+   result.result_type = IR::Float::build(8);
+   result.agg_reader = std::make_unique<AggComputeTDigest>(static_cast<uint8_t>(percentile));
+   result.granules.push_back(std::make_unique<AggStateTDigest>(agg_iu.type));
+   // The quantile over only NULLs is NULL.
+   countNonNullInputs(agg_iu, result);
    return result;
 }
 
@@ -48,7 +146,8 @@ RegistryEntry resolveAvg(const IU& agg_iu) {
 
 RegistryEntry lookupSubops(const Description& description) {
    if (description.distinct) {
-      throw std::runtime_error("Distinct aggregate functions not implemented.");
+      // The Aggregation rewrites distinct aggregates into regular ones over a deduplicated input.
+      throw std::runtime_error("Distinct aggregate functions have to be rewritten before the registry lookup.");
    } else {
       switch (description.code) {
          case Opcode::Count:
@@ -58,9 +157,15 @@ RegistryEntry lookupSubops(const Description& description) {
          case Opcode::Avg:
             return resolveAvg(description.agg_iu);
          case Opcode::Min:
+            return resolveMin(description.agg_iu);
          case Opcode::Max:
+            return resolveMax(description.agg_iu);
+         case Opcode::ApproxCountDistinct:
+            return resolveApproxCountDistinct(description.agg_iu);
          case Opcode::Median:
-            throw std::runtime_error("Aggregate function not implemented.");
+            return resolveMedian(description.agg_iu);
+         case Opcode::ApproxQuantile:
+            return resolveApproxQuantile(description.agg_iu, description.quantile);
       }
    }
 }
@@ -19,14 +19,20 @@ namespace inkfuse {
 namespace AggregateFunctions {
 
 /// Which aggregate function should be implemented. Distinct combinator is provided
-/// during lookups on the agg registry.
+/// during lookups on the agg registry. Distinct aggregates are rewritten into a
+/// two-level aggregation by the Aggregation operator before the registry is consulted.
 enum class Opcode {
    Min,
    Max,
    Sum,
    Count,
    Avg,
+   /// Exact median through out-of-line per-group value lists.
    Median,
+   /// Approximate quantile through a t-digest sketch. The quantile is given in the description.
+   ApproxQuantile,
+   /// Approximate count of the distinct non-NULL values through a HyperLogLog sketch.
+   ApproxCountDistinct,
 };
 
 /// High-level description of an aggreagte function.
@@ -34,6 +40,8 @@ struct Description {
    const IU& agg_iu;
    const Opcode code;
    const bool distinct = false;
+   /// Quantile in [0, 1] estimated by ApproxQuantile. Has to be a whole percentile.
+   const double quantile = 0.5;
 };
 
 /// Result of an agg function lookup.
@@ -45,6 +53,9 @@ struct RegistryEntry {
    /// Function that operates on the granules to compute the output of the aggregate function.
    /// Runtime params need to be attached to find state granule locations.
    AggComputePtr agg_reader;
+   /// Index of the granule counting the non-NULL inputs. If set, the result is NULL
+   /// for groups without any non-NULL input.
+   std::optional<size_t> non_null_count_granule;
 };
 
 /// Generate low-level computational description for the given aggregate.
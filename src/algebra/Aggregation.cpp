@@ -5,9 +5,13 @@
 #include "algebra/suboperators/aggregation/AggReaderSubop.h"
 #include "algebra/suboperators/aggregation/AggregatorSubop.h"
 #include "algebra/suboperators/expressions/ExpressionSubop.h"
+#include "algebra/suboperators/expressions/RuntimeExpressionSubop.h"
+#include "algebra/suboperators/row_layout/KeyNormalizerSubop.h"
 #include "algebra/suboperators/row_layout/KeyUnpackerSubop.h"
 #include "algebra/suboperators/sources/HashTableSource.h"
 #include "algebra/suboperators/sources/ScratchPadIUProvider.h"
+#include "storage/Relation.h"
+#include <algorithm>
 #include <functional>
 #include <map>
 #include <numeric>
@@ -17,7 +21,7 @@ namespace inkfuse {
 
 Aggregation::Aggregation(std::vector<std::unique_ptr<RelAlgOp>> children_, std::string op_name_, std::vector<const IU*> group_by_, std::vector<AggregateFunctions::Description> aggregates_)
    : RelAlgOp(std::move(children_), std::move(op_name_)), group_by(std::move(group_by_)),
-     agg_pointer_result(IR::Pointer::build(IR::Char::build())), ht_scan_result(IR::Pointer::build(IR::Char::build())) {
+     key_hash(IR::UnsignedInt::build(8)), agg_pointer_result(IR::Pointer::build(IR::Char::build())), ht_scan_result(IR::Pointer::build(IR::Char::build())) {
    plan(std::move(aggregates_));
 }
 
@@ -25,17 +29,101 @@ std::unique_ptr<Aggregation> Aggregation::build(std::vector<std::unique_ptr<RelA
    return std::make_unique<Aggregation>(std::move(children_), std::move(op_name_), std::move(group_by_), std::move(aggregates_));
 }
 
+std::vector<AggregateFunctions::Description> Aggregation::planDistinct(std::vector<AggregateFunctions::Description> description) {
+   using Opcode = AggregateFunctions::Opcode;
+   // Find the column over which distinct aggregates are computed.
+   const IU* distinct_iu = nullptr;
+   for (const auto& func : description) {
+      if (!func.distinct) {
+         continue;
+      }
+      if (distinct_iu && distinct_iu != &func.agg_iu) {
+         throw std::runtime_error("Distinct aggregates have to be computed over the same column");
+      }
+      distinct_iu = &func.agg_iu;
+   }
+   if (!distinct_iu) {
+      return description;
+   }
+   if (children.size() != 1) {
+      throw std::runtime_error("Distinct aggregates need exactly one child");
+   }
+
+   // Inner aggregation: group by the keys and the distinct column.
+   std::vector<const IU*> inner_group_by = group_by;
+   const size_t distinct_idx = std::distance(group_by.begin(), std::find(group_by.begin(), group_by.end(), distinct_iu));
+   if (distinct_idx == group_by.size()) {
+      inner_group_by.push_back(distinct_iu);
+   }
+   // Regular aggregates are pre-aggregated in the inner aggregation and combined in the outer one.
+   // Duplicate insensitive aggregates over the distinct column behave like distinct aggregates.
+   auto on_distinct_column = [&](const AggregateFunctions::Description& func) {
+      return func.distinct || (&func.agg_iu == distinct_iu && func.code == Opcode::ApproxCountDistinct);
+   };
+   std::vector<AggregateFunctions::Description> inner_aggregates;
+   for (const auto& func : description) {
+      if (on_distinct_column(func)) {
+         continue;
+      }
+      const bool combinable = func.code == Opcode::Count || func.code == Opcode::Sum ||
+         // Partial min/max over only NULLs can't be told apart from a real value.
+         ((func.code == Opcode::Min || func.code == Opcode::Max) && !func.agg_iu.null_indicator);
+      if (!combinable) {
+         throw std::runtime_error("Aggregate function cannot be combined with distinct aggregates");
+      }
+      inner_aggregates.push_back({.agg_iu = func.agg_iu, .code = func.code});
+   }
+   const size_t inner_keys = inner_group_by.size();
+   auto inner = Aggregation::build(std::move(children), op_name + "_distinct", std::move(inner_group_by), std::move(inner_aggregates));
+   const auto inner_out = inner->getOutput();
+   children.clear();
+   children.push_back(std::move(inner));
+
+   // Outer aggregation over the deduplicated rows.
+   group_by.assign(inner_out.begin(), inner_out.begin() + group_by.size());
+   std::vector<AggregateFunctions::Description> outer;
+   size_t inner_aggregate = inner_keys;
+   for (const auto& func : description) {
+      if (on_distinct_column(func)) {
+         outer.push_back({.agg_iu = *inner_out[distinct_idx], .code = func.code});
+      } else {
+         // Partial counts are summed up, the other partial aggregates are combined with themselves.
+         const Opcode code = func.code == Opcode::Count ? Opcode::Sum : func.code;
+         outer.push_back({.agg_iu = *inner_out[inner_aggregate++], .code = code});
+      }
+   }
+   return outer;
+}
+
 void Aggregation::plan(std::vector<AggregateFunctions::Description> description) {
-   // Compute the hash table required by this aggregation?
+   description = planDistinct(std::move(description));
+   if (group_by.empty() && description.empty()) {
+      throw std::runtime_error("Aggregation needs a key or an aggregate function");
+   }
+   // Compute the hash table required by this aggregation? The NULL indicator of a
+   // nullable string key becomes the simple key behind the string.
    if (group_by.size() == 1 && dynamic_cast<IR::String*>(group_by[0]->type.get())) {
       requires_complex_ht = true;
    }
    // We pack the aggregation keys first.
    for (const IU* key : group_by) {
-      key_size += key->type->numBytes();
-      const auto& out = out_key_ius.emplace_back(key->type);
+      auto& out = out_key_ius.emplace_back(key->type);
       output_ius.push_back(&out);
-      if (group_by.size() != 1) {
+      if (!key->null_indicator) {
+         packed_keys.push_back(key);
+         continue;
+      }
+      auto& nullable = nullable_keys.emplace_back(NullableKey{
+         .key = key,
+         .normalized = IU(key->type),
+      });
+      packed_keys.push_back(&nullable.normalized);
+      packed_keys.push_back(key->null_indicator);
+      out.null_indicator = &out_key_indicators.emplace_back(IR::Bool::build());
+   }
+   for (const IU* key : packed_keys) {
+      key_size += key->type->numBytes();
+      if (packed_keys.size() != 1) {
          // If there is more than one key, we will need a pseudo IU later
          // to indicate that key packing needs to happen before the hash table insert.
          pseudo_ius.emplace_back(IR::Void::build());
@@ -43,6 +131,7 @@ void Aggregation::plan(std::vector<AggregateFunctions::Description> description)
    }
    // We know the key size - so we can now create the properly sized byte array.
    packed_ht_key.emplace(IR::ByteArray::build(key_size));
+   planDirectLookup();
 
    // Plan the aggregate key. We perform the following optimizations when optimizing aggregate state:
    // - An aggregate function is divided into a 'compute' and 'extract' step.
@@ -75,10 +164,10 @@ void Aggregation::plan(std::vector<AggregateFunctions::Description> description)
    }
    granules.resize(to_compute.size());
 
-   assert(!to_compute.empty());
    // The `granules` set did all the heavy lifting for us - now we just have to extract them
    // and re-attach the correct offsets to the aggregate functions.
-   const size_t largest_state = std::get<0>(*to_compute.rbegin());
+   // Granules are at most 8 byte aligned, larger ones (e.g. HyperLogLog registers) are byte arrays.
+   const size_t largest_state = to_compute.empty() ? 1 : std::min<size_t>(std::get<0>(*to_compute.begin()), 8);
    // Find the starting offset for serializing the payload state.
    // This is the first aligned offset after the key.
    payload_offset = 0;
@@ -105,18 +194,83 @@ void Aggregation::plan(std::vector<AggregateFunctions::Description> description)
          // Last writer wins - all granules are the same, so it doesn't matter which `AggStatePtr` we use.
          granules[idx] = {iu, std::move(granule)};
       }
+      std::optional<size_t> non_null_count_offset;
+      if (entry.non_null_count_granule) {
+         non_null_count_offset = granule_offsets[*entry.non_null_count_granule];
+      }
       // Construct plan for this aggregate function.
       compute.push_back(PlannedAggCompute{
          .compute = std::move(entry.agg_reader),
          .granule_offsets = std::move(granule_offsets),
+         .non_null_count_offset = non_null_count_offset,
       });
       // And set up the output iu.
       assert(entry.result_type.get());
       auto& out_iu = out_aggregate_ius.emplace_back(entry.result_type);
       output_ius.push_back(&out_iu);
+      if (non_null_count_offset) {
+         out_non_null_counts.emplace_back(IR::SignedInt::build(8));
+         out_iu.null_indicator = &out_aggregate_indicators.emplace_back(IR::Bool::build());
+      }
    }
 }
 
+void Aggregation::planDirectLookup() {
+   if (requires_complex_ht || key_size == 0 || children.size() != 1) {
+      return;
+   }
+   auto is_integer = [](const IU& iu) {
+      const auto* type = iu.type.get();
+      return dynamic_cast<const IR::SignedInt*>(type) || dynamic_cast<const IR::UnsignedInt*>(type) ||
+         dynamic_cast<const IR::Date*>(type) || dynamic_cast<const IR::Bool*>(type);
+   };
+   // Resolve the value range of every packed key.
+   std::vector<ValueRange> ranges;
+   for (const IU* key : group_by) {
+      if (!is_integer(*key)) {
+         return;
+      }
+      auto range = children[0]->valueRange(*key);
+      if (!range) {
+         return;
+      }
+      if (key->null_indicator) {
+         // NULL rows are normalized to zero and the NULL indicator is packed behind the key.
+         ranges.push_back({.min = std::min<int64_t>(range->min, 0), .max = std::max<int64_t>(range->max, 0)});
+         ranges.push_back({.min = 0, .max = 1});
+      } else {
+         ranges.push_back(*range);
+      }
+   }
+   assert(ranges.size() == packed_keys.size());
+   std::vector<HashTableDirectLookup::KeyColumn> columns;
+   uint64_t slots = 1;
+   uint16_t offset = 0;
+   for (size_t k = 0; k < packed_keys.size(); ++k) {
+      // The number of values in the range. The difference can exceed int64_t, but not uint64_t.
+      const uint64_t cardinality = static_cast<uint64_t>(ranges[k].max) - static_cast<uint64_t>(ranges[k].min) + 1;
+      if (cardinality == 0 || cardinality > HashTableDirectLookup::MAX_SLOTS || slots * cardinality > HashTableDirectLookup::MAX_SLOTS) {
+         return;
+      }
+      slots *= cardinality;
+      const auto width = static_cast<uint8_t>(packed_keys[k]->type->numBytes());
+      columns.push_back({.offset = offset, .width = width, .min = static_cast<uint64_t>(ranges[k].min), .cardinality = cardinality});
+      offset += width;
+   }
+   direct_lookup_keys = std::move(columns);
+}
+
+std::optional<ValueRange> Aggregation::valueRange(const IU& iu) const {
+   auto out_key = out_key_ius.begin();
+   for (const IU* key : group_by) {
+      if (&(*out_key) == &iu) {
+         return children[0]->valueRange(*key);
+      }
+      out_key++;
+   }
+   return {};
+}
+
 void Aggregation::decay(PipelineDAG& dag) const {
    for (const auto& child : children) {
       child->decay(dag);
@@ -134,9 +288,13 @@ void Aggregation::decay(PipelineDAG& dag) const {
    // pipeline which reads from the aggregation is done.
    DefferredStateInitializer* hash_table = nullptr;
    if (requires_complex_ht) {
-      auto& deferred = dag.attachHashTableComplexKey(dag.getPipelines().size(), 1, payload_size);
+      auto& deferred = dag.attachHashTableComplexKey(dag.getPipelines().size(), 1, key_size - 8, payload_size);
       deferred.state_merger.reset(new AggregationMerger<HashTableComplexKey>(*this, deferred));
       hash_table = &deferred;
+   } else if (!direct_lookup_keys.empty()) {
+      auto& deferred = dag.attachHashTableDirectLookup(dag.getPipelines().size(), direct_lookup_keys, key_size, payload_size);
+      deferred.state_merger.reset(new AggregationMerger<HashTableDirectLookup>(*this, deferred));
+      hash_table = &deferred;
    } else {
       auto& deferred = dag.attachHashTableSimpleKey(dag.getPipelines().size(), key_size, payload_size);
       deferred.state_merger.reset(new AggregationMerger<HashTableSimpleKey>(*this, deferred));
@@ -145,11 +303,16 @@ void Aggregation::decay(PipelineDAG& dag) const {
    assert(hash_table);
 
    auto& curr_pipe = dag.getCurrentPipeline();
+   // Step 0: Normalize nullable keys, all NULL rows have to end up in the same group.
+   for (const auto& nullable : nullable_keys) {
+      curr_pipe.attachSuboperator(KeyNormalizerSubop::build(this, *nullable.key, *nullable.key->null_indicator, nullable.normalized));
+   }
+
    // Step 1: Pack the aggregation key (if it needs to be packed)
    const IU* packed_key_iu;
-   if (group_by.size() == 1) {
+   if (packed_keys.size() == 1) {
       // There is only a single key, we can use that directly.
-      packed_key_iu = group_by[0];
+      packed_key_iu = packed_keys[0];
    } else {
       // We have to pack the aggregation key. First provide a scratch pad IU.
       curr_pipe.attachSuboperator(ScratchPadIUProvider::build(this, *packed_ht_key));
@@ -157,7 +320,7 @@ void Aggregation::decay(PipelineDAG& dag) const {
       // Now pack the key into the provided scratch pad IU.
       size_t key_offset = 0;
       auto pseudo = pseudo_ius.begin();
-      for (const auto& key : group_by) {
+      for (const auto& key : packed_keys) {
          auto& packer = curr_pipe.attachSuboperator(KeyPackerSubop::build(this, *key, *packed_ht_key, {&(*pseudo)}));
          // Attach the runtime parameter that represents the state offset.
          KeyPackingRuntimeParams param;
@@ -176,11 +339,18 @@ void Aggregation::decay(PipelineDAG& dag) const {
       pseudo.push_back(&pseudo_iu);
    }
 
-   // Dispatch the correct lookup function.
+   // Dispatch the correct lookup function. Without aggregate state (plain GROUP BY), the insert is the sink.
+   // Hash tables hash the key in a separate step. This way the interpreter hashes and prefetches a whole
+   // morsel before the lookups, and the lookup or insert reuses the hash.
+   const IU* pointer_result = granules.empty() ? nullptr : &agg_pointer_result;
    if (key_size && requires_complex_ht) {
-      curr_pipe.attachSuboperator(RuntimeFunctionSubop::htLookupOrInsert<HashTableComplexKey>(this, &agg_pointer_result, *packed_key_iu, std::move(pseudo), hash_table));
+      curr_pipe.attachSuboperator(RuntimeFunctionSubop::htHashAndPrefetch<HashTableComplexKey>(this, key_hash, *packed_key_iu, std::move(pseudo), /* key_width = */ {}, hash_table));
+      curr_pipe.attachSuboperator(RuntimeFunctionSubop::htLookupOrInsertWithHash<HashTableComplexKey>(this, pointer_result, *packed_key_iu, key_hash, hash_table));
+   } else if (!direct_lookup_keys.empty()) {
+      curr_pipe.attachSuboperator(RuntimeFunctionSubop::htLookupOrInsert<HashTableDirectLookup>(this, pointer_result, *packed_key_iu, std::move(pseudo), hash_table));
    } else if (key_size != 0) {
-      curr_pipe.attachSuboperator(RuntimeFunctionSubop::htLookupOrInsert<HashTableSimpleKey>(this, &agg_pointer_result, *packed_key_iu, std::move(pseudo), hash_table));
+      curr_pipe.attachSuboperator(RuntimeFunctionSubop::htHashAndPrefetch<HashTableSimpleKey>(this, key_hash, *packed_key_iu, std::move(pseudo), /* key_width = */ {}, hash_table));
+      curr_pipe.attachSuboperator(RuntimeFunctionSubop::htLookupOrInsertWithHash<HashTableSimpleKey>(this, pointer_result, *packed_key_iu, key_hash, hash_table));
    } else {
       // The key size is zero - so we just aggregate a single group.
       // We use an optimized code path for this. We need to htNoKeyLookup to reference an
@@ -210,6 +380,8 @@ void Aggregation::decay(PipelineDAG& dag) const {
          casted->state_merger->prepareState(ctx, total_threads);
       } else if (auto casted = dynamic_cast<HashTableComplexKeyState*>(hash_table)) {
          casted->state_merger->prepareState(ctx, total_threads);
+      } else if (auto casted = dynamic_cast<HashTableDirectLookupState*>(hash_table)) {
+         casted->state_merger->prepareState(ctx, total_threads);
       } else {
           throw std::runtime_error("Dispatch to invalid hash table state in aggregate rt prepare.");
       } },
@@ -219,6 +391,8 @@ void Aggregation::decay(PipelineDAG& dag) const {
          casted->state_merger->mergeTables(ctx, thread_id);
       } else if (auto casted = dynamic_cast<HashTableComplexKeyState*>(hash_table)) {
          casted->state_merger->mergeTables(ctx, thread_id);
+      } else if (auto casted = dynamic_cast<HashTableDirectLookupState*>(hash_table)) {
+         casted->state_merger->mergeTables(ctx, thread_id);
       } else {
           throw std::runtime_error("Dispatch to invalid hash table state in aggregate rt worker.");
       } },
@@ -230,24 +404,34 @@ void Aggregation::decay(PipelineDAG& dag) const {
    // Dispatch the correct reader depending on the layout.
    if (requires_complex_ht) {
       read_pipe.attachSuboperator(ComplexHashTableSource::build(this, ht_scan_result, hash_table));
+   } else if (!direct_lookup_keys.empty()) {
+      read_pipe.attachSuboperator(DirectLookupHashTableSource::build(this, ht_scan_result, hash_table));
    } else {
       read_pipe.attachSuboperator(SimpleHashTableSource::build(this, ht_scan_result, hash_table));
    }
 
    // Produce the readers for the materialized keys.
    size_t key_offset = 0;
-   for (const auto& out_key_iu : out_key_ius) {
-      auto& unpacker = read_pipe.attachSuboperator(KeyUnpackerSubop::build(this, ht_scan_result, out_key_iu));
+   auto unpack_key = [&](const IU& out_iu) {
+      auto& unpacker = read_pipe.attachSuboperator(KeyUnpackerSubop::build(this, ht_scan_result, out_iu));
       // Attach the runtime parameter that represents the state offset.
       KeyPackingRuntimeParams param;
       param.offsetSet(IR::UI<2>::build(key_offset));
       reinterpret_cast<KeyUnpackerSubop&>(unpacker).attachRuntimeParams(std::move(param));
       // Update the key offset by the size of the IU.
-      key_offset += out_key_iu.type->numBytes();
+      key_offset += out_iu.type->numBytes();
+   };
+   for (const auto& out_key_iu : out_key_ius) {
+      unpack_key(out_key_iu);
+      if (out_key_iu.null_indicator) {
+         // The NULL indicator was packed right after the key.
+         unpack_key(*out_key_iu.null_indicator);
+      }
    }
 
    // Produce the actual operators that computes the aggregate functions.
    auto out_compute = compute.cbegin();
+   auto non_null_count = out_non_null_counts.cbegin();
    for (const auto& out_agg_iu : out_aggregate_ius) {
       auto& reader = reinterpret_cast<AggReaderSubop&>(read_pipe.attachSuboperator(AggReaderSubop::build(this, ht_scan_result, out_agg_iu, *out_compute->compute)));
       // Attach the runtime parameter that represents the state offset.
@@ -259,6 +443,18 @@ void Aggregation::decay(PipelineDAG& dag) const {
          param.offset_2Set(IR::UI<2>::build(key_size + g_offsets[1]));
       }
       reader.attachRuntimeParams(std::move(param));
+      if (out_compute->non_null_count_offset) {
+         // The result is NULL if the group never saw a non-NULL input.
+         auto& count_reader = reinterpret_cast<AggReaderSubop&>(read_pipe.attachSuboperator(AggReaderSubop::build(this, ht_scan_result, *non_null_count, non_null_count_reader)));
+         KeyPackingRuntimeParamsTwo count_param;
+         count_param.offset_1Set(IR::UI<2>::build(key_size + *out_compute->non_null_count_offset));
+         count_reader.attachRuntimeParams(std::move(count_param));
+         auto& is_null = read_pipe.attachSuboperator(RuntimeExpressionSubop::build(this, {out_agg_iu.null_indicator}, {&*non_null_count}, ExpressionOp::ComputeNode::Type::Eq, IR::SignedInt::build(8)));
+         RuntimeExpressionParams is_null_param;
+         is_null_param.dataSet(IR::SI<8>::build(0));
+         reinterpret_cast<RuntimeExpressionSubop&>(is_null).attachRuntimeParams(std::move(is_null_param));
+         non_null_count++;
+      }
       out_compute++;
    }
 }
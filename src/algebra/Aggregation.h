@@ -4,21 +4,33 @@
 #include "algebra/AggFunctionRegisty.h"
 #include "algebra/AggregationMerger.h"
 #include "algebra/RelAlgOp.h"
+#include "algebra/suboperators/aggregation/AggComputeUnpack.h"
 #include <list>
 #include <optional>
 
 namespace inkfuse {
 
 /// Relational algebra operator for aggregations.
+/// Without aggregate functions this is a plain GROUP BY, i.e. a SELECT DISTINCT over the keys.
 struct Aggregation : public RelAlgOp {
    Aggregation(std::vector<std::unique_ptr<RelAlgOp>> children_, std::string op_name_, std::vector<const IU*> group_by_, std::vector<AggregateFunctions::Description> aggregates_);
    static std::unique_ptr<Aggregation> build(std::vector<std::unique_ptr<RelAlgOp>> children_, std::string op_name_, std::vector<const IU*> group_by_, std::vector<AggregateFunctions::Description> aggregates_);
 
    void decay(PipelineDAG& dag) const override;
 
+   /// The output keys have the value range of the group-by keys.
+   std::optional<ValueRange> valueRange(const IU& iu) const override;
+
    private:
    /// Plan the aggregation by splitting it into granules.
    void plan(std::vector<AggregateFunctions::Description> description);
+   /// Plan a direct lookup table if the value ranges of all packed keys are known and small.
+   /// Every group then gets a dedicated slot in a dense array, skipping hashing and probing.
+   void planDirectLookup();
+   /// Rewrite distinct aggregates into a two-level aggregation. The child becomes an aggregation grouping by
+   /// the keys and the distinct column, which deduplicates the input and pre-aggregates the regular aggregates.
+   /// Returns the aggregates this aggregation has to compute over the output of the new child.
+   std::vector<AggregateFunctions::Description> planDistinct(std::vector<AggregateFunctions::Description> description);
 
    /// A planned aggregate computation.
    struct PlannedAggCompute {
@@ -26,23 +38,48 @@ struct Aggregation : public RelAlgOp {
       AggComputePtr compute;
       /// Offsets of the granules within the packed hash table payload.
       std::vector<size_t> granule_offsets;
+      /// Offset of the granule counting the non-NULL inputs, see RegistryEntry::non_null_count_granule.
+      std::optional<size_t> non_null_count_offset;
+   };
+
+   /// A nullable group-by key. The key is normalized for NULL rows and the NULL
+   /// indicator is packed as an additional key. This way all NULLs form a single group.
+   struct NullableKey {
+      /// The original key.
+      const IU* key;
+      /// The normalized key, see KeyNormalizerSubop.
+      IU normalized;
    };
 
    /// By what should we aggregate?
    std::vector<const IU*> group_by;
+   /// The nullable group-by keys.
+   std::list<NullableKey> nullable_keys;
+   /// The IUs that are actually packed into the hash table key.
+   std::vector<const IU*> packed_keys;
    /// The granules that are used to update the internal aggregate state.
    std::vector<std::pair<const IU*, AggStatePtr>> granules;
    /// The compute granules that will be turned into AggReaderSubops.
    std::vector<PlannedAggCompute> compute;
    /// The output IUs for the aggregated keys.
    std::list<IU> out_key_ius;
+   /// The NULL indicators of nullable output keys.
+   std::list<IU> out_key_indicators;
    /// The result IUs that are produced by the aggregate functions.
    std::list<IU> out_aggregate_ius;
+   /// The non-NULL input counts of aggregate results that can be NULL.
+   std::list<IU> out_non_null_counts;
+   /// The NULL indicators of aggregate results, true if the group saw no non-NULL input.
+   std::list<IU> out_aggregate_indicators;
+   /// Reads the non-NULL input counts from the hash table.
+   AggComputeUnpack non_null_count_reader{IR::SignedInt::build(8)};
    /// Void-typed pseudo-IUs that connect the key packing operators with the hash table insert. 
    std::list<IU> pseudo_ius;
    /// Char[]-typed IU to represent the optional packed key of the hash table.
    /// Need an optional as we need to plan the key layout before we can initialize it.
    std::optional<IU> packed_ht_key;
+   /// UI8-typed IU carrying the hash of the packed key into the hash table lookup/insert.
+   IU key_hash;
    /// Char*-typed IU to get the result of a hash table lookup/insert.
    IU agg_pointer_result;
    /// Char*-typed IU produced by reading from the hash table.
@@ -55,6 +92,8 @@ struct Aggregation : public RelAlgOp {
    size_t payload_size = 0;
    /// Does this aggregation require a complex hash table?
    bool requires_complex_ht = false;
+   /// The packed key columns of the direct lookup table. Empty if the aggregation uses a hash table.
+   std::vector<HashTableDirectLookup::KeyColumn> direct_lookup_keys;
 
    friend class AggregationMerger<HashTableSimpleKey>;
    friend class AggregationMerger<HashTableComplexKey>;
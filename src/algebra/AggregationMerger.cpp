@@ -1,7 +1,12 @@
 #include "algebra/AggregationMerger.h"
 #include "algebra/Aggregation.h"
+#include "algebra/suboperators/aggregation/AggStateSum.h"
 #include "exec/DeferredState.h"
 #include "runtime/HashTables.h"
+#include "runtime/HyperLogLog.h"
+#include "runtime/Quantiles.h"
+#include <cstring>
+#include <type_traits>
 #include <vector>
 
 namespace inkfuse {
@@ -18,6 +23,158 @@ void mergeSum(std::vector<std::pair<const char*, char*>> pairs, size_t offset) {
    }
 }
 
+// Merge primitive for decimal sums, which fail the query on overflow like the generated code.
+template <typename T>
+void mergeCheckedSum(std::vector<std::pair<const char*, char*>> pairs, size_t offset) {
+   for (size_t k = 0; k < pairs.size(); ++k) {
+      const T* src = reinterpret_cast<const T*>(pairs[k].first + offset);
+      T* dest = reinterpret_cast<T*>(pairs[k].second + offset);
+      if (__builtin_add_overflow(*dest, *src, dest)) {
+         throw std::runtime_error("Decimal overflow or division by zero");
+      }
+   }
+}
+
+// Merge primitive for aggregate min and max state laid out as [value | initialized flag].
+template <typename T, bool is_min>
+void mergeMinMax(std::vector<std::pair<const char*, char*>> pairs, size_t offset) {
+   for (size_t k = 0; k < pairs.size(); ++k) {
+      const T* src = reinterpret_cast<const T*>(pairs[k].first + offset);
+      T* dest = reinterpret_cast<T*>(pairs[k].second + offset);
+      const bool src_init = *reinterpret_cast<const uint8_t*>(src + 1);
+      uint8_t* dest_init = reinterpret_cast<uint8_t*>(dest + 1);
+      if (!src_init) {
+         // The source group only saw NULL values.
+         continue;
+      }
+      if (!*dest_init || (is_min ? *src < *dest : *src > *dest)) {
+         *dest = *src;
+      }
+      *dest_init = 1;
+   }
+}
+
+// Min and max merge over strings.
+template <bool is_min>
+void mergeMinMaxString(std::vector<std::pair<const char*, char*>> pairs, size_t offset) {
+   for (size_t k = 0; k < pairs.size(); ++k) {
+      char* const* src = reinterpret_cast<char* const*>(pairs[k].first + offset);
+      char** dest = reinterpret_cast<char**>(pairs[k].second + offset);
+      const bool src_init = *reinterpret_cast<const uint8_t*>(src + 1);
+      uint8_t* dest_init = reinterpret_cast<uint8_t*>(dest + 1);
+      if (!src_init) {
+         continue;
+      }
+      if (!*dest_init || (is_min ? std::strcmp(*src, *dest) < 0 : std::strcmp(*src, *dest) > 0)) {
+         *dest = *src;
+      }
+      *dest_init = 1;
+   }
+}
+
+// Merge primitive for HyperLogLog sketches.
+void mergeHyperLogLog(std::vector<std::pair<const char*, char*>> pairs, size_t offset) {
+   for (size_t k = 0; k < pairs.size(); ++k) {
+      const auto* src = reinterpret_cast<const uint8_t*>(pairs[k].first + offset);
+      auto* dest = reinterpret_cast<uint8_t*>(pairs[k].second + offset);
+      HyperLogLog::merge(dest, src);
+   }
+}
+
+// Merge primitive for exact median value lists.
+void mergeMedian(std::vector<std::pair<const char*, char*>> pairs, size_t offset) {
+   for (size_t k = 0; k < pairs.size(); ++k) {
+      ExactQuantile::merge(pairs[k].second + offset, pairs[k].first + offset);
+   }
+}
+
+// Merge primitive for t-digests.
+void mergeTDigest(std::vector<std::pair<const char*, char*>> pairs, size_t offset) {
+   for (size_t k = 0; k < pairs.size(); ++k) {
+      TDigest::merge(pairs[k].second + offset, pairs[k].first + offset);
+   }
+}
+
+// Dispatch the min or max merge onto the type of the aggregated IU.
+template <bool is_min>
+void mergeMinMaxDispatch(const std::string& type_id, std::vector<std::pair<const char*, char*>> pairs, size_t offset) {
+   if (type_id == "UI1") {
+      mergeMinMax<uint8_t, is_min>(std::move(pairs), offset);
+   } else if (type_id == "UI2") {
+      mergeMinMax<uint16_t, is_min>(std::move(pairs), offset);
+   } else if (type_id == "UI4") {
+      mergeMinMax<uint32_t, is_min>(std::move(pairs), offset);
+   } else if (type_id == "UI8") {
+      mergeMinMax<uint64_t, is_min>(std::move(pairs), offset);
+   } else if (type_id == "I1") {
+      mergeMinMax<int8_t, is_min>(std::move(pairs), offset);
+   } else if (type_id == "I2") {
+      mergeMinMax<int16_t, is_min>(std::move(pairs), offset);
+   } else if (type_id == "I4" || type_id == "Date") {
+      // Dates are days since the epoch in a 4 byte signed integer.
+      mergeMinMax<int32_t, is_min>(std::move(pairs), offset);
+   } else if (type_id == "I8" || type_id == "Dec8") {
+      // Decimals are compared on their scaled integers, all values of an IU share the scale.
+      mergeMinMax<int64_t, is_min>(std::move(pairs), offset);
+   } else if (type_id == "Dec16") {
+      mergeMinMax<__int128, is_min>(std::move(pairs), offset);
+   } else if (type_id == "F4") {
+      mergeMinMax<float, is_min>(std::move(pairs), offset);
+   } else if (type_id == "F8") {
+      mergeMinMax<double, is_min>(std::move(pairs), offset);
+   } else if (type_id == "String") {
+      mergeMinMaxString<is_min>(std::move(pairs), offset);
+   } else {
+      throw std::runtime_error("Unsupported min/max merge type for aggregate hash table");
+   }
+}
+
+}
+
+void mergeAggregateGranules(const std::vector<std::pair<const IU*, AggStatePtr>>& granules, const std::vector<std::pair<const char*, char*>>& merge_pairs, size_t offset) {
+   size_t curr_offset = offset;
+   for (const auto& [agg_iu, agg_state] : granules) {
+      const IR::TypeArc& agg_type = agg_iu->type;
+      // Dispatch onto the right merge primitive.
+      const std::string state_id = agg_state->id();
+      // Sums are merged on their state type, which can be wider than the aggregated type.
+      const auto* sum_state = dynamic_cast<const AggStateSum*>(agg_state.get());
+      const std::string sum_id = sum_state ? sum_state->getStateType()->id() : "";
+      if (state_id == "agg_state_count") {
+         // Count can go over any type - it always has a summable 8 byte integer state.
+         mergeSum<int64_t>(merge_pairs, curr_offset);
+      } else if (state_id.starts_with("agg_state_hll_")) {
+         mergeHyperLogLog(merge_pairs, curr_offset);
+      } else if (state_id.starts_with("agg_state_median_")) {
+         mergeMedian(merge_pairs, curr_offset);
+      } else if (state_id.starts_with("agg_state_tdigest_")) {
+         mergeTDigest(merge_pairs, curr_offset);
+      } else if (state_id.starts_with("agg_state_min_")) {
+         mergeMinMaxDispatch<true>(agg_type->id(), merge_pairs, curr_offset);
+      } else if (state_id.starts_with("agg_state_max_")) {
+         mergeMinMaxDispatch<false>(agg_type->id(), merge_pairs, curr_offset);
+      } else if (sum_id == "UI4") {
+         mergeSum<uint32_t>(merge_pairs, curr_offset);
+      } else if (sum_id == "UI8") {
+         mergeSum<uint64_t>(merge_pairs, curr_offset);
+      } else if (sum_id == "I4") {
+         mergeSum<int32_t>(merge_pairs, curr_offset);
+      } else if (sum_id == "I8") {
+         mergeSum<int64_t>(merge_pairs, curr_offset);
+      } else if (sum_id == "Dec8") {
+         mergeCheckedSum<int64_t>(merge_pairs, curr_offset);
+      } else if (sum_id == "Dec16") {
+         mergeCheckedSum<__int128>(merge_pairs, curr_offset);
+      } else if (sum_id == "F4") {
+         mergeSum<float>(merge_pairs, curr_offset);
+      } else if (sum_id == "F8") {
+         mergeSum<double>(merge_pairs, curr_offset);
+      } else {
+         throw std::runtime_error("Unsupported merge type for aggregate hash table");
+      }
+      // Update the offset - the next aggregation state granule lives next to this one.
+      curr_offset += agg_state->getStateSize();
+   }
 }
 
 template <class HashTableType>
@@ -54,6 +211,12 @@ void AggregationMerger<HashTableType>::mergeTables(ExecutionContext& ctx, size_t
    for (auto& merge_from : pre_merge) {
       // Merge every non-partitioned source table into the target.
       mergeSingleTable(ctx, *merge_from, *merge_into, thread_id);
+      if constexpr (std::is_same_v<HashTableType, HashTableSimpleKey>) {
+         if (merge_from->isPassThrough()) {
+            // The rows after the table stopped pre-aggregating are already partitioned by thread.
+            mergePassThroughPartition(ctx, merge_from->getPassThroughPartition(thread_id), *merge_into, thread_id);
+         }
+      }
    }
 }
 
@@ -81,31 +244,29 @@ void AggregationMerger<HashTableType>::mergeSingleTable(ExecutionContext& ctx, H
    } while (ExecutionContext::getInstalledRestartFlag());
    ExecutionContext::getInstalledRestartFlag() = false;
    // Now perform the actual merge based on the previously identified pointers.
-   size_t curr_offset = agg.key_size + agg.payload_offset;
-   for (const auto& [agg_iu, agg_state] : agg.granules) {
-      const IR::TypeArc& agg_type = agg_iu->type;
-      // Dispatch onto the right merge primitive.
-      if (agg_type->id() == "UI4") {
-         mergeSum<uint32_t>(merge_pairs, curr_offset);
-      } else if (agg_type->id() == "UI8") {
-         mergeSum<uint64_t>(merge_pairs, curr_offset);
-      } else if (agg_type->id() == "I4") {
-         mergeSum<int32_t>(merge_pairs, curr_offset);
-      } else if (agg_type->id() == "I8") {
-         mergeSum<int64_t>(merge_pairs, curr_offset);
-      } else if (agg_type->id() == "F4") {
-         mergeSum<float>(merge_pairs, curr_offset);
-      } else if (agg_type->id() == "F8") {
-         mergeSum<double>(merge_pairs, curr_offset);
-      } else if (agg_state->id() == "agg_state_count") {
-         // Count can go over any type - it always has a summable 8 byte integer state.
-         mergeSum<int64_t>(merge_pairs, curr_offset);
-      } else {
-         throw std::runtime_error("Unsupported merge type for aggregate hash table");
-      }
-      // Update the offset - the next aggregation state granule lives next to this one.
-      curr_offset += agg_state->getStateSize();
+   mergeAggregateGranules(agg.granules, merge_pairs, agg.key_size + agg.payload_offset);
+}
+
+template <class HashTableType>
+void AggregationMerger<HashTableType>::mergePassThroughPartition(ExecutionContext& ctx, const TupleMaterializer& src, HashTableType& target, size_t thread_id) {
+   const size_t slot_size = agg.key_size + agg.payload_size;
+   auto handle = src.getReadHandle();
+   std::vector<std::pair<const char*, char*>> merge_pairs;
+   ExecutionContext::RuntimeGuard guard{ctx, thread_id};
+   assert(!ExecutionContext::getInstalledRestartFlag());
+   while (const TupleMaterializer::MatChunk* chunk = handle->pullChunk()) {
+      const char* chunk_start = reinterpret_cast<const char*>(chunk->data.get());
+      do {
+         // A resize of the target invalidates the pointers found so far, look up the chunk again.
+         ExecutionContext::getInstalledRestartFlag() = false;
+         merge_pairs.clear();
+         for (const char* row = chunk_start; row < chunk->end_ptr; row += slot_size) {
+            merge_pairs.emplace_back(row, target.lookupOrInsert(row));
+         }
+      } while (ExecutionContext::getInstalledRestartFlag());
+      mergeAggregateGranules(agg.granules, merge_pairs, agg.key_size + agg.payload_offset);
    }
+   ExecutionContext::getInstalledRestartFlag() = false;
 }
 
 // Declare all specializations.
@@ -1,14 +1,17 @@
 #ifndef INKFUSE_AGGREGATIONMERGER_H
 #define INKFUSE_AGGREGATIONMERGER_H
 
+#include "algebra/suboperators/aggregation/AggState.h"
 #include "exec/ExecutionContext.h"
 #include "runtime/HashTables.h"
 #include <deque>
+#include <vector>
 
 namespace inkfuse {
 
 struct DefferredStateInitializer;
 struct Aggregation;
+struct IU;
 
 template <class HashTableType>
 struct ExclusiveHashTableState;
@@ -19,6 +22,10 @@ struct ExclusiveHashTableState<HashTableComplexKey>;
 template <>
 struct ExclusiveHashTableState<HashTableDirectLookup>;
 
+/// Merge the aggregate states of every `pair.first` into `pair.second`. The granules are laid out
+/// back to back, starting at `offset` from the paired pointers.
+void mergeAggregateGranules(const std::vector<std::pair<const IU*, AggStatePtr>>& granules, const std::vector<std::pair<const char*, char*>>& pairs, size_t offset);
+
 /// The aggregation merger takes a set of aggregate hash tables and merges them.
 /// In InkFuse aggregations are multithreaded by doing a thread-local pre-aggregation.
 /// Since the same key can be stored in multiple thread-local hash tables, we need
@@ -42,6 +49,9 @@ struct AggregationMerger {
 
    private:
    void mergeSingleTable(ExecutionContext& ctx, HashTableType& src, HashTableType& target, size_t thread_id);
+   /// Merge the rows a thread-local table scattered into a pass-through partition (see adaptive
+   /// pre-aggregation in HashTableSimpleKey). The partition is owned by exactly one merging thread.
+   void mergePassThroughPartition(ExecutionContext& ctx, const TupleMaterializer& src, HashTableType& target, size_t thread_id);
 
    const Aggregation& agg;
    ExclusiveHashTableState<HashTableType>& rt_state;
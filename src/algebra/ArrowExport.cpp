@@ -0,0 +1,328 @@
+#include "algebra/ArrowExport.h"
+#include "algebra/suboperators/sinks/FuseChunkSink.h"
+#include "exec/ExecutionContext.h"
+#include <array>
+#include <bit>
+#include <cstring>
+#include <deque>
+#include <unordered_map>
+#include <unordered_set>
+
+namespace inkfuse {
+
+namespace {
+
+/// Resolve the Arrow format string for a given type.
+std::string arrowFormat(const IR::Type& type) {
+   if (dynamic_cast<const IR::SignedInt*>(&type)) {
+      switch (type.numBytes()) {
+         case 1:
+            return "c";
+         case 2:
+            return "s";
+         case 4:
+            return "i";
+         case 8:
+            return "l";
+      }
+   } else if (dynamic_cast<const IR::UnsignedInt*>(&type)) {
+      switch (type.numBytes()) {
+         case 1:
+            return "C";
+         case 2:
+            return "S";
+         case 4:
+            return "I";
+         case 8:
+            return "L";
+      }
+   } else if (dynamic_cast<const IR::Float*>(&type)) {
+      return type.numBytes() == 4 ? "f" : "g";
+   } else if (dynamic_cast<const IR::Bool*>(&type)) {
+      return "b";
+   } else if (dynamic_cast<const IR::Char*>(&type)) {
+      // Fixed-size binary of width one has exactly our layout.
+      return "w:1";
+   } else if (dynamic_cast<const IR::Date*>(&type)) {
+      // Days since the epoch, same as our representation.
+      return "tdD";
+   } else if (dynamic_cast<const IR::String*>(&type)) {
+      return "u";
+   }
+   throw std::runtime_error("ArrowExporter cannot export type " + type.id());
+}
+
+/// Pack a byte-per-row column into an Arrow bitmap.
+/// @return the number of set bits.
+size_t packBits(const char* bytes, size_t rows, bool invert, uint8_t* out) {
+   const uint8_t flip = invert ? 0xFF : 0x00;
+   size_t set = 0;
+   size_t row = 0;
+   for (; row + 8 <= rows; row += 8) {
+      uint8_t packed = 0;
+      for (size_t bit = 0; bit < 8; ++bit) {
+         packed |= static_cast<uint8_t>(bytes[row + bit] != 0) << bit;
+      }
+      out[row / 8] = packed ^ flip;
+      set += std::popcount(out[row / 8]);
+   }
+   if (row < rows) {
+      // Trailing bits, the padding stays zero.
+      uint8_t packed = 0;
+      for (size_t bit = 0; row + bit < rows; ++bit) {
+         packed |= static_cast<uint8_t>((bytes[row + bit] != 0) != invert) << bit;
+      }
+      out[row / 8] = packed;
+      set += std::popcount(packed);
+   }
+   return set;
+}
+
+/// Frees column memory handed over by a FuseChunk.
+struct FreeDeleter {
+   void operator()(char* ptr) const { std::free(ptr); }
+};
+
+/// Memory backing an exported record batch. Shared by the batch and its children, this way
+/// single children can be moved out of the batch as allowed by the C Data Interface.
+struct ExportedBatch {
+   std::vector<ArrowArray> children;
+   std::vector<ArrowArray*> child_ptrs;
+   /// Buffers of the children: validity, values and for strings the string data.
+   std::vector<std::array<const void*, 3>> buffers;
+   /// The struct array itself never contains NULLs.
+   std::array<const void*, 1> parent_buffers = {nullptr};
+   /// Buffers built for the export, freed once the last array referencing the batch is released.
+   /// A deque, the buffers of a column are set up while further ones get added.
+   std::deque<std::vector<uint8_t>> owned;
+   /// Column memory taken over from the FuseChunk, freed together with the batch.
+   std::vector<std::unique_ptr<char, FreeDeleter>> handed_over;
+};
+
+using ExportedBatchRef = std::shared_ptr<ExportedBatch>;
+
+void releaseArray(ArrowArray* array) {
+   for (int64_t k = 0; k < array->n_children; ++k) {
+      // Children that were moved out are already marked as released.
+      ArrowArray* child = array->children[k];
+      if (child->release) {
+         child->release(child);
+      }
+   }
+   delete static_cast<ExportedBatchRef*>(array->private_data);
+   array->release = nullptr;
+}
+
+/// Memory backing an exported schema.
+struct ExportedSchema {
+   std::vector<std::string> names;
+   std::vector<std::string> formats;
+   std::vector<ArrowSchema> children;
+   std::vector<ArrowSchema*> child_ptrs;
+};
+
+using ExportedSchemaRef = std::shared_ptr<ExportedSchema>;
+
+void releaseSchema(ArrowSchema* schema) {
+   for (int64_t k = 0; k < schema->n_children; ++k) {
+      ArrowSchema* child = schema->children[k];
+      if (child->release) {
+         child->release(child);
+      }
+   }
+   delete static_cast<ExportedSchemaRef*>(schema->private_data);
+   schema->release = nullptr;
+}
+
+}
+
+ArrowExporter::ArrowExporter(std::vector<const IU*> ius_, std::vector<std::string> colnames_, std::optional<size_t> limit)
+   : ius(std::move(ius_)), colnames(std::move(colnames_)), limit(limit) {
+   if (ius.empty()) {
+      throw std::runtime_error("ArrowExporter must produce at least one column");
+   }
+   if (ius.size() != colnames.size()) {
+      throw std::runtime_error("ArrowExporter name/iu schema must have the same number of entries");
+   }
+   formats.reserve(ius.size());
+   for (const IU* iu : ius) {
+      formats.push_back(arrowFormat(*iu->type));
+   }
+}
+
+void ArrowExporter::setCallback(BatchCallback callback_) {
+   callback = std::move(callback_);
+}
+
+void ArrowExporter::exportSchema(ArrowSchema* out) const {
+   auto schema = std::make_shared<ExportedSchema>();
+   schema->names = colnames;
+   schema->formats = formats;
+   schema->children.resize(ius.size());
+   for (size_t k = 0; k < ius.size(); ++k) {
+      schema->children[k] = ArrowSchema{
+         .format = schema->formats[k].c_str(),
+         .name = schema->names[k].c_str(),
+         .metadata = nullptr,
+         .flags = ius[k]->null_indicator ? ARROW_FLAG_NULLABLE : 0,
+         .n_children = 0,
+         .children = nullptr,
+         .dictionary = nullptr,
+         .release = &releaseSchema,
+         .private_data = new ExportedSchemaRef(schema),
+      };
+      schema->child_ptrs.push_back(&schema->children[k]);
+   }
+   *out = ArrowSchema{
+      .format = "+s",
+      .name = "",
+      .metadata = nullptr,
+      .flags = 0,
+      .n_children = static_cast<int64_t>(ius.size()),
+      .children = schema->child_ptrs.data(),
+      .dictionary = nullptr,
+      .release = &releaseSchema,
+      .private_data = new ExportedSchemaRef(schema),
+   };
+}
+
+bool ArrowExporter::markMorselDone(ExecutionContext& ctx, size_t thread_id) {
+   // How many rows are we allowed to export until we hit the limit?
+   const size_t chunk_size = ctx.getColumn(*ius[0], thread_id).size;
+   size_t rows = chunk_size;
+   bool closed = false;
+   {
+      std::unique_lock lock(limit_mut);
+      if (limit) {
+         rows = std::min(rows, *limit);
+         *limit = *limit - rows;
+         closed = *limit == 0;
+      }
+      num_rows += rows;
+      num_batches += rows > 0;
+   }
+   if (rows == 0 || !callback) {
+      return closed;
+   }
+
+   auto batch = std::make_shared<ExportedBatch>();
+   batch->children.resize(ius.size());
+   batch->buffers.resize(ius.size());
+   batch->child_ptrs.reserve(ius.size());
+   // Column memory handed over to this batch, an IU might be exported more than once.
+   std::unordered_map<const IU*, const char*> taken;
+   for (size_t k = 0; k < ius.size(); ++k) {
+      const IU& iu = *ius[k];
+      Column& col = ctx.getColumn(iu, thread_id);
+      const char* data = taken.count(&iu) ? taken.at(&iu) : col.raw_data;
+      const char* nulls = iu.null_indicator ? ctx.getColumn(*iu.null_indicator, thread_id).raw_data : nullptr;
+      auto& buffers = batch->buffers[k];
+      buffers = {nullptr, nullptr, nullptr};
+      ArrowArray& child = batch->children[k];
+      child = ArrowArray{
+         .length = static_cast<int64_t>(rows),
+         .null_count = 0,
+         .offset = 0,
+         .n_buffers = 2,
+         .n_children = 0,
+         .buffers = buffers.data(),
+         .children = nullptr,
+         .dictionary = nullptr,
+         .release = &releaseArray,
+         .private_data = new ExportedBatchRef(batch),
+      };
+      batch->child_ptrs.push_back(&child);
+
+      if (nulls) {
+         // NULL indicators become the validity bitmap.
+         auto& validity = batch->owned.emplace_back((rows + 7) / 8);
+         child.null_count = static_cast<int64_t>(rows - packBits(nulls, rows, /* invert = */ true, validity.data()));
+         buffers[0] = validity.data();
+      }
+      if (formats[k] == "b") {
+         // Bools are bit-packed in Arrow.
+         auto& bits = batch->owned.emplace_back((rows + 7) / 8);
+         packBits(data, rows, /* invert = */ false, bits.data());
+         buffers[1] = bits.data();
+      } else if (formats[k] == "u") {
+         // Strings are pointers to zero-terminated strings in the FuseChunk, Arrow wants offsets into one data buffer.
+         auto strings = reinterpret_cast<const char* const*>(data);
+         auto& offsets_raw = batch->owned.emplace_back((rows + 1) * sizeof(int32_t));
+         auto offsets = reinterpret_cast<int32_t*>(offsets_raw.data());
+         offsets[0] = 0;
+         for (size_t row = 0; row < rows; ++row) {
+            // The value of NULL rows is undefined, don't touch it.
+            const bool is_null = nulls && nulls[row];
+            offsets[row + 1] = offsets[row] + (is_null ? 0 : static_cast<int32_t>(std::strlen(strings[row])));
+         }
+         auto& chars = batch->owned.emplace_back(offsets[rows]);
+         for (size_t row = 0; row < rows; ++row) {
+            std::memcpy(chars.data() + offsets[row], strings[row], offsets[row + 1] - offsets[row]);
+         }
+         child.n_buffers = 3;
+         buffers[1] = offsets_raw.data();
+         buffers[2] = chars.data();
+      } else if (taken.count(&iu)) {
+         // Exported before, share the memory taken over from the column.
+         buffers[1] = data;
+      } else if (col.raw_data == col.owned_data) {
+         // Same layout as Arrow. Take over the column memory, the FuseChunk continues on fresh memory.
+         buffers[1] = batch->handed_over.emplace_back(col.releaseData()).get();
+         taken[&iu] = static_cast<const char*>(buffers[1]);
+      } else {
+         // Same layout as Arrow, but the column points into memory we don't own (e.g. a zero copy table scan).
+         const size_t bytes = rows * iu.type->numBytes();
+         auto& values = batch->owned.emplace_back(bytes);
+         std::memcpy(values.data(), data, bytes);
+         buffers[1] = values.data();
+      }
+   }
+
+   ArrowArray out{
+      .length = static_cast<int64_t>(rows),
+      .null_count = 0,
+      .offset = 0,
+      .n_buffers = 1,
+      .n_children = static_cast<int64_t>(ius.size()),
+      .buffers = batch->parent_buffers.data(),
+      .children = batch->child_ptrs.data(),
+      .dictionary = nullptr,
+      .release = &releaseArray,
+      .private_data = new ExportedBatchRef(batch),
+   };
+   callback(thread_id, &out);
+   if (out.release) {
+      // The callback neither released nor moved the batch.
+      out.release(&out);
+   }
+   return closed;
+}
+
+std::unique_ptr<ArrowExport> ArrowExport::build(std::vector<std::unique_ptr<RelAlgOp>> children_, std::vector<const IU*> ius, std::vector<std::string> colnames, std::string op_name_, std::optional<size_t> limit) {
+   return std::unique_ptr<ArrowExport>{new ArrowExport(std::move(children_), std::move(ius), std::move(colnames), std::move(op_name_), limit)};
+}
+
+ArrowExport::ArrowExport(std::vector<std::unique_ptr<RelAlgOp>> children_, std::vector<const IU*> ius, std::vector<std::string> colnames, std::string op_name_, std::optional<size_t> limit)
+   : RelAlgOp(std::move(children_), std::move(op_name_)), exporter(std::make_unique<ArrowExporter>(std::move(ius), std::move(colnames), limit)) {
+}
+
+void ArrowExport::decay(PipelineDAG& dag) const {
+   for (auto& child : children) {
+      child->decay(dag);
+   }
+
+   auto& pipe = dag.getCurrentPipeline();
+   // Build a FuseChunkSink to materialize each output IU. The exported buffers point into these.
+   std::unordered_set<const IU*> sunk;
+   for (auto& out : exporter->ius) {
+      if (sunk.insert(out).second) {
+         pipe.attachSuboperator(FuseChunkSink::build(this, *out));
+      }
+      if (out->null_indicator && sunk.insert(out->null_indicator).second) {
+         pipe.attachSuboperator(FuseChunkSink::build(this, *out->null_indicator));
+      }
+   }
+   pipe.setResultSink(*exporter);
+}
+
+}
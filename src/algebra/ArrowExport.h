@@ -0,0 +1,88 @@
+#ifndef INKFUSE_ARROWEXPORT_H
+#define INKFUSE_ARROWEXPORT_H
+
+#include "algebra/Pipeline.h"
+#include "algebra/RelAlgOp.h"
+#include "common/ArrowCData.h"
+#include <functional>
+#include <mutex>
+#include <optional>
+
+namespace inkfuse {
+
+/// Result sink handing finished morsels to the caller as Arrow C Data Interface record batches.
+/// In contrast to the PrettyPrinter there is no row-wise formatting and no global lock around
+/// the output: every worker thread exports its own FuseChunk and invokes the callback directly.
+///
+/// A record batch is a struct array with one child per column. The FuseChunk of the producing
+/// thread is reused for the next morsel, so every batch owns its buffers. Columns whose FuseChunk
+/// layout matches the Arrow layout (integers, floats, dates, chars) hand their memory to the batch
+/// and continue on fresh memory. They are only copied if they point into memory the FuseChunk
+/// doesn't own, e.g. after a zero copy table scan. Bools are bit-packed, strings get an offset and
+/// data buffer, and NULL indicators become validity bitmaps.
+struct ArrowExporter : public ResultSink {
+   /// Callback receiving a record batch produced by the given thread. Called concurrently.
+   /// The callback owns the batch and has to release it. The buffers stay valid until the
+   /// batch and all children moved out of it are released.
+   using BatchCallback = std::function<void(size_t thread_id, ArrowArray* batch)>;
+
+   ArrowExporter(std::vector<const IU*> ius, std::vector<std::string> colnames, std::optional<size_t> limit);
+
+   /// Set the callback receiving the record batches.
+   void setCallback(BatchCallback callback);
+
+   /// Export the schema of the produced record batches. The caller owns the schema and has to release it.
+   void exportSchema(ArrowSchema* out) const;
+
+   /// Export the morsel in the FuseChunk of the given thread and hand it to the callback.
+   /// @return true if the output is closed.
+   bool markMorselDone(ExecutionContext& ctx, size_t thread_id) override;
+
+   /// How many rows did we produce?
+   size_t num_rows = 0;
+   /// How many record batches did we produce?
+   size_t num_batches = 0;
+
+   private:
+   friend class ArrowExport;
+
+   /// Mutex protecting the limit and row counters. Not held while exporting.
+   std::mutex limit_mut;
+   /// The IUs we produce - in the given order.
+   std::vector<const IU*> ius;
+   /// The column names.
+   std::vector<std::string> colnames;
+   /// Arrow format strings of the columns. Resolved in the constructor.
+   std::vector<std::string> formats;
+   /// Row limit - the output is closed once this limit is reached.
+   std::optional<size_t> limit;
+   /// The callback into which to hand the batches.
+   BatchCallback callback;
+};
+
+/// ArrowExport operator. Is hooked into an ArrowExporter that streams the
+/// result rows to the caller as Arrow record batches.
+struct ArrowExport : public RelAlgOp {
+   static std::unique_ptr<ArrowExport> build(
+      std::vector<std::unique_ptr<RelAlgOp>> children_,
+      std::vector<const IU*> ius,
+      std::vector<std::string> colnames,
+      std::string op_name_ = "",
+      std::optional<size_t> limit = {});
+
+   void decay(PipelineDAG& dag) const override;
+
+   /// The actual backing exporter.
+   std::unique_ptr<ArrowExporter> exporter;
+
+   private:
+   ArrowExport(std::vector<std::unique_ptr<RelAlgOp>> children_,
+               std::vector<const IU*> ius,
+               std::vector<std::string> colnames,
+               std::string op_name_,
+               std::optional<size_t> limit);
+};
+
+}
+
+#endif //INKFUSE_ARROWEXPORT_H
@@ -170,6 +170,10 @@ const OptimizationHints& CompilationContext::getOptimizationHints() const {
    return optimization_hints;
 }
 
+const Pipeline& CompilationContext::getPipeline() const {
+   return pipeline;
+}
+
 CompilationContext::Builder::Builder(IR::Program& program, std::string fct_name)
    : ir_builder(program.getIRBuilder()), fct_builder(createFctBuilder(ir_builder, std::move(fct_name))) {
 }
@@ -67,6 +67,8 @@ struct CompilationContext {
 
    /// Get the optimization hints for the generated program.
    const OptimizationHints& getOptimizationHints() const;
+   /// Get the pipeline for which code is generated.
+   const Pipeline& getPipeline() const;
 
    private:
    static IR::FunctionBuilder createFctBuilder(IR::IRBuilder& program, std::string fct_name);
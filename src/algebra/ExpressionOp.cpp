@@ -3,10 +3,304 @@
 #include "algebra/suboperators/expressions/ExpressionSubop.h"
 #include "algebra/suboperators/expressions/RuntimeExpressionSubop.h"
 
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+#include <sstream>
 #include <unordered_set>
 
 namespace inkfuse {
 
+namespace {
+
+using Type = ExpressionOp::ComputeNode::Type;
+
+/// Build the constant one in the given integer type. Returns nullptr for non-integer types.
+IR::ValuePtr integerOne(const IR::TypeArc& type) {
+   const bool is_signed = dynamic_cast<const IR::SignedInt*>(type.get());
+   const bool is_unsigned = dynamic_cast<const IR::UnsignedInt*>(type.get());
+   if (!is_signed && !is_unsigned) {
+      return nullptr;
+   }
+   switch (type->numBytes()) {
+      case 1:
+         return is_signed ? IR::SI<1>::build(1) : IR::UI<1>::build(1);
+      case 2:
+         return is_signed ? IR::SI<2>::build(1) : IR::UI<2>::build(1);
+      case 4:
+         return is_signed ? IR::SI<4>::build(1) : IR::UI<4>::build(1);
+      default:
+         return is_signed ? IR::SI<8>::build(1) : IR::UI<8>::build(1);
+   }
+}
+
+/// Read the bits of an integer constant. Returns an empty optional for all other values, including
+/// parameters of prepared queries whose value changes between runs.
+std::optional<uint64_t> integerBits(IR::Value& value) {
+   std::optional<uint64_t> result;
+   auto try_read = [&]<class V>(V*) {
+      if (auto casted = dynamic_cast<V*>(&value)) {
+         result = static_cast<uint64_t>(casted->value);
+      }
+   };
+   try_read(static_cast<IR::UI<1>*>(nullptr));
+   try_read(static_cast<IR::UI<2>*>(nullptr));
+   try_read(static_cast<IR::UI<4>*>(nullptr));
+   try_read(static_cast<IR::UI<8>*>(nullptr));
+   try_read(static_cast<IR::SI<1>*>(nullptr));
+   try_read(static_cast<IR::SI<2>*>(nullptr));
+   try_read(static_cast<IR::SI<4>*>(nullptr));
+   try_read(static_cast<IR::SI<8>*>(nullptr));
+   return result;
+}
+
+/// Build an integer constant of the same type as `like` from the given bits.
+IR::ValuePtr integerWithBits(IR::Value& like, uint64_t bits) {
+   IR::ValuePtr result;
+   auto try_build = [&]<class V>(V*) {
+      if (dynamic_cast<V*>(&like)) {
+         result = V::build(static_cast<decltype(V::value)>(bits));
+      }
+   };
+   try_build(static_cast<IR::UI<1>*>(nullptr));
+   try_build(static_cast<IR::UI<2>*>(nullptr));
+   try_build(static_cast<IR::UI<4>*>(nullptr));
+   try_build(static_cast<IR::UI<8>*>(nullptr));
+   try_build(static_cast<IR::SI<1>*>(nullptr));
+   try_build(static_cast<IR::SI<2>*>(nullptr));
+   try_build(static_cast<IR::SI<4>*>(nullptr));
+   try_build(static_cast<IR::SI<8>*>(nullptr));
+   return result;
+}
+
+/// Key identifying a type. Decimals of all precisions and scales share their type id.
+std::string typeKey(const IR::Type& type) {
+   if (auto decimal = dynamic_cast<const IR::Decimal*>(&type)) {
+      return type.id() + "(" + std::to_string(decimal->getPrecision()) + "," + std::to_string(decimal->getScale()) + ")";
+   }
+   return type.id();
+}
+
+/// 10^exponent as a scaled decimal integer.
+__int128 powerOfTen(size_t exponent) {
+   __int128 result = 1;
+   for (size_t k = 0; k < exponent; ++k) {
+      result *= 10;
+   }
+   return result;
+}
+
+/// Derive the result type of an operation on decimals. nullptr if no decimal is involved.
+/// Results get enough digits to never overflow, operations which would need more than
+/// the maximum precision are rejected.
+IR::TypeArc deriveDecimal(Type code, const std::vector<IR::TypeArc>& types) {
+   if (types.size() != 2 || code == Type::Constant) {
+      return nullptr;
+   }
+   auto l = dynamic_cast<const IR::Decimal*>(types[0].get());
+   auto r = dynamic_cast<const IR::Decimal*>(types[1].get());
+   if (!l && !r) {
+      return nullptr;
+   }
+   if (!l || !r) {
+      throw std::runtime_error("Decimals can only be combined with decimals, cast the other operand first");
+   }
+   auto same_scale = [&]() {
+      if (l->getScale() != r->getScale()) {
+         throw std::runtime_error("Decimal operands need the same scale, cast them first");
+      }
+   };
+   auto checked = [](size_t precision, size_t scale) {
+      if (precision > IR::Decimal::MAX_PRECISION) {
+         throw std::runtime_error("Decimal result would exceed " + std::to_string(IR::Decimal::MAX_PRECISION) + " digits");
+      }
+      return IR::Decimal::build(precision, scale);
+   };
+   switch (code) {
+      case Type::Add:
+      case Type::Subtract: {
+         same_scale();
+         const size_t integer_digits = std::max(l->getPrecision() - l->getScale(), r->getPrecision() - r->getScale());
+         return checked(integer_digits + l->getScale() + 1, l->getScale());
+      }
+      case Type::Multiply:
+         return checked(l->getPrecision() + r->getPrecision(), l->getScale() + r->getScale());
+      case Type::Divide: {
+         // Integer division of the scaled values, the quotient has the difference of the scales.
+         // The dividend is scaled up first, the quotient gets DECIMAL_DIVIDE_EXTRA_SCALE more
+         // fractional digits than the dividend as long as the precision allows it.
+         const size_t shift = std::min(r->getScale() + ExpressionOp::DECIMAL_DIVIDE_EXTRA_SCALE, IR::Decimal::MAX_PRECISION - l->getPrecision());
+         if (l->getScale() + shift < r->getScale()) {
+            throw std::runtime_error("Decimal division needs more than " + std::to_string(IR::Decimal::MAX_PRECISION) + " digits to keep the scale of the divisor");
+         }
+         // Mixed width operands are divided on 16 bytes, so the quotient keeps the wider precision.
+         return IR::Decimal::build(std::max(l->getPrecision() + shift, r->getPrecision()), l->getScale() + shift - r->getScale());
+      }
+      case Type::Eq:
+      case Type::Neq:
+      case Type::Less:
+      case Type::LessEqual:
+      case Type::Greater:
+      case Type::GreaterEqual:
+         same_scale();
+         return IR::Bool::build();
+      default:
+         throw std::runtime_error("Operation not supported on decimals");
+   }
+}
+
+/// Key identifying the value of an inlined constant. Empty if equal values cannot be detected.
+std::optional<std::string> constantKey(IR::Value& value) {
+   if (!value.supportsInlining()) {
+      return std::nullopt;
+   }
+   if (auto bits = integerBits(value)) {
+      return value.getType()->id() + ":" + std::to_string(*bits);
+   }
+   if (auto casted = dynamic_cast<IR::F8*>(&value)) {
+      uint64_t bits;
+      std::memcpy(&bits, &casted->value, sizeof(bits));
+      return value.getType()->id() + ":" + std::to_string(bits);
+   }
+   return std::nullopt;
+}
+
+/// Rewrites an expression DAG into a DAG of distinct nodes, see ExpressionOp::simplify.
+struct Simplifier {
+   explicit Simplifier(std::vector<ExpressionOp::NodePtr>& nodes_) : nodes(nodes_) {}
+
+   /// Rewrite an output node. Outputs always stay compute nodes, as they define the output IUs.
+   ExpressionOp::Node* rewriteOutput(ExpressionOp::Node* node) {
+      auto result = rewrite(node, false);
+      if (dynamic_cast<ExpressionOp::ComputeNode*>(result)) {
+         return result;
+      }
+      return rewrite(node, true);
+   }
+
+   private:
+   ExpressionOp::Node* rewrite(ExpressionOp::Node* node, bool keep_compute) {
+      if (auto it = rewritten.find(node); !keep_compute && it != rewritten.end()) {
+         return it->second;
+      }
+      ExpressionOp::Node* result;
+      if (auto ref_node = dynamic_cast<ExpressionOp::IURefNode*>(node)) {
+         std::stringstream key;
+         key << "ref:" << ref_node->child;
+         result = distinct.emplace(key.str(), node).first->second;
+      } else {
+         result = rewriteCompute(static_cast<ExpressionOp::ComputeNode*>(node), keep_compute);
+      }
+      if (!keep_compute) {
+         rewritten[node] = result;
+      }
+      return result;
+   }
+
+   /// Rewrite a compute node. If `keep_distinct` is set, the node is never merged with an equal one.
+   ExpressionOp::Node* rewriteCompute(ExpressionOp::ComputeNode* node, bool keep_compute, bool keep_distinct = false) {
+      std::vector<ExpressionOp::Node*> children;
+      for (auto child : node->children) {
+         children.push_back(rewrite(child, false));
+      }
+      for (size_t k = 1; k < children.size(); ++k) {
+         // A suboperator can't consume the same IU twice. Children that only became equal
+         // through the rewrite stay separate nodes.
+         const bool merged = std::find(children.begin(), children.begin() + k, children[k]) != children.begin() + k;
+         if (merged && children[k] != node->children[k] && dynamic_cast<ExpressionOp::ComputeNode*>(children[k])) {
+            children[k] = rewriteCompute(static_cast<ExpressionOp::ComputeNode*>(node->children[k]), true, true);
+         }
+      }
+      Type code = node->code;
+      std::optional<IR::ValuePtr> param;
+      if (node->opt_runtime_param) {
+         param = (*node->opt_runtime_param)->copy();
+      }
+      bool changed = children != node->children;
+
+      // Fold chains of integer constants: c_1 OP (c_2 OP x) = (c_1 OP c_2) OP x.
+      while (param && (code == Type::Add || code == Type::Multiply)) {
+         auto inner = dynamic_cast<ExpressionOp::ComputeNode*>(children[0]);
+         if (!inner || inner->code != code || !inner->opt_runtime_param || (*param)->getType()->id() != (*inner->opt_runtime_param)->getType()->id()) {
+            break;
+         }
+         auto outer_bits = integerBits(**param);
+         auto inner_bits = integerBits(**inner->opt_runtime_param);
+         if (!outer_bits || !inner_bits) {
+            break;
+         }
+         // Unsigned arithmetic wraps around just like the generated code does.
+         const uint64_t folded = code == Type::Add ? *outer_bits + *inner_bits : *outer_bits * *inner_bits;
+         param = integerWithBits(**param, folded);
+         children = inner->children;
+         changed = true;
+      }
+
+      if (!keep_compute && !keep_distinct) {
+         // Drop operations that don't change their input.
+         if (param && children[0]->output_type->id() == (*param)->getType()->id()) {
+            auto bits = integerBits(**param);
+            if (bits && ((code == Type::Add && *bits == 0) || (code == Type::Multiply && *bits == 1))) {
+               return children[0];
+            }
+         }
+         if (code == Type::Cast && typeKey(*children[0]->output_type) == typeKey(*node->output_type)) {
+            return children[0];
+         }
+      }
+
+      // Hash-cons the node on its operation and (already distinct) children.
+      std::stringstream key;
+      key << static_cast<int>(code) << ":" << typeKey(*node->output_type);
+      if (param) {
+         if (auto param_key = constantKey(**param)) {
+            key << ":" << *param_key;
+         } else {
+            // Parameters that can't be compared keep their node distinct.
+            key << ":node" << node;
+         }
+      }
+      for (auto child : children) {
+         key << ":" << child;
+      }
+      if (auto it = distinct.find(key.str()); !keep_distinct && it != distinct.end()) {
+         return it->second;
+      }
+
+      ExpressionOp::Node* result = node;
+      if (changed) {
+         ExpressionOp::NodePtr rebuilt;
+         if (code == Type::Cast) {
+            rebuilt = std::make_unique<ExpressionOp::ComputeNode>(node->output_type, children[0]);
+         } else if (param) {
+            rebuilt = std::make_unique<ExpressionOp::ComputeNode>(code, std::move(*param), children[0]);
+         } else {
+            rebuilt = std::make_unique<ExpressionOp::ComputeNode>(code, std::move(children));
+         }
+         result = nodes.emplace_back(std::move(rebuilt)).get();
+      }
+      distinct.emplace(key.str(), result);
+      return result;
+   }
+
+   /// The node storage of the ExpressionOp, rebuilt nodes are added to it.
+   std::vector<ExpressionOp::NodePtr>& nodes;
+   /// Rewritten version of every visited node.
+   std::unordered_map<ExpressionOp::Node*, ExpressionOp::Node*> rewritten;
+   /// The distinct nodes by their structural key.
+   std::unordered_map<std::string, ExpressionOp::Node*> distinct;
+};
+
+/// The IU a node writes its result into.
+const IU* valueIU(ExpressionOp::Node* node) {
+   if (auto ref_node = dynamic_cast<ExpressionOp::IURefNode*>(node)) {
+      return ref_node->child;
+   }
+   return &static_cast<ExpressionOp::ComputeNode*>(node)->out;
+}
+
+}
+
 IR::TypeArc ExpressionOp::derive(ComputeNode::Type code, const std::vector<Node*>& nodes) {
    std::vector<IR::TypeArc> types;
    std::for_each(nodes.begin(), nodes.end(), [&](Node* node) {
@@ -16,13 +310,17 @@ IR::TypeArc ExpressionOp::derive(ComputeNode::Type code, const std::vector<Node*
 }
 
 IR::TypeArc ExpressionOp::derive(ComputeNode::Type code, const std::vector<IR::TypeArc>& types) {
+   if (auto decimal = deriveDecimal(code, types)) {
+      return decimal;
+   }
    // Operations that return a boolean as result.
    static std::unordered_set<ComputeNode::Type> bool_returning{
       ComputeNode::Type::Eq, ComputeNode::Type::Neq,
       ComputeNode::Type::Less, ComputeNode::Type::LessEqual,
       ComputeNode::Type::Greater, ComputeNode::Type::GreaterEqual,
       ComputeNode::Type::StrEquals, ComputeNode::Type::And,
-      ComputeNode::Type::Or, ComputeNode::Type::InList, ComputeNode::Type::NotLikeTokens};
+      ComputeNode::Type::Or, ComputeNode::Type::InList, ComputeNode::Type::NotLikeTokens,
+      ComputeNode::Type::Like, ComputeNode::Type::IsNull};
    if (bool_returning.contains(code)) {
       return IR::Bool::build();
    }
@@ -32,6 +330,7 @@ IR::TypeArc ExpressionOp::derive(ComputeNode::Type code, const std::vector<IR::T
 
 ExpressionOp::ExpressionOp(std::vector<std::unique_ptr<RelAlgOp>> children_, std::string op_name_, std::vector<Node*> out_, std::vector<NodePtr> nodes_)
    : RelAlgOp(std::move(children_), std::move(op_name_)), out(std::move(out_)), nodes(std::move(nodes_)) {
+   simplify();
    for (auto node : out) {
       auto casted = dynamic_cast<ComputeNode*>(node);
       assert(casted);
@@ -43,22 +342,245 @@ std::unique_ptr<ExpressionOp> ExpressionOp::build(std::vector<std::unique_ptr<Re
    return std::make_unique<ExpressionOp>(std::move(children_), std::move(op_name_), std::move(out_), std::move(nodes_));
 }
 
+void ExpressionOp::simplify() {
+   Simplifier simplifier(nodes);
+   for (auto& node : out) {
+      node = simplifier.rewriteOutput(node);
+   }
+}
+
 ExpressionOp::IURefNode::IURefNode(const IU* child_)
    : Node(child_->type), child(child_) {
 }
 
+const IU* ExpressionOp::IURefNode::nullIndicator() const {
+   return child->null_indicator;
+}
+
 ExpressionOp::ComputeNode::ComputeNode(Type code_, std::vector<Node*> children_)
    : Node(derive(code_, children_)), code(code_), out(output_type), children(std::move(children_)) {
    assert(code != Type::Constant && code != Type::Cast);
+   assert(code != Type::IsNull || children.size() == 1);
+   planDecimalDivide();
+   planNulls();
 }
 
 ExpressionOp::ComputeNode::ComputeNode(IR::TypeArc casted, Node* child)
    : Node(casted), code(Type::Cast), out(std::move(casted)), children({child}) {
+   planRescale();
+   planNulls();
 }
 
 ExpressionOp::ComputeNode::ComputeNode(Type code_, IR::ValuePtr arg_1, Node* arg_2)
-   : Node(derive(code_, {arg_1->getType()})), code(code_), out(output_type), children({arg_2}), opt_runtime_param(std::move(arg_1)) {
-   assert(code != Type::Cast);
+   : Node(derive(code_, {arg_1->getType(), arg_2->output_type})), code(code_), out(output_type), children({arg_2}), opt_runtime_param(std::move(arg_1)) {
+   assert(code != Type::Cast && code != Type::IsNull);
+   planDecimalDivide();
+   planNulls();
+}
+
+const IU* ExpressionOp::ComputeNode::nullIndicator() const {
+   return out.null_indicator;
+}
+
+void ExpressionOp::ComputeNode::planRescale() {
+   const auto& source = children[0]->output_type;
+   auto from = dynamic_cast<const IR::Decimal*>(source.get());
+   auto to = dynamic_cast<const IR::Decimal*>(output_type.get());
+   if (!from && !to) {
+      return;
+   }
+   const IU* value = valueIU(children[0]);
+   if (dynamic_cast<const IR::Float*>(source.get())) {
+      // Scale the floating point value up before the cast truncates it.
+      const IU* as_double = value;
+      if (source->numBytes() != 8) {
+         as_double = &null_ius.emplace_back(IR::Float::build(8));
+         pre_helpers.push_back(NullHelper{Type::Cast, as_double, {value}});
+      }
+      auto& scaled = null_ius.emplace_back(IR::Float::build(8));
+      pre_helpers.push_back(NullHelper{Type::Multiply, &scaled, {as_double}, IR::F8::build(std::pow(10.0, to->getScale()))});
+      replaced_sources[0] = &scaled;
+      return;
+   }
+   if (dynamic_cast<const IR::Float*>(output_type.get())) {
+      // Cast the scaled integer and divide it by the scale afterwards.
+      auto& as_double = null_ius.emplace_back(IR::Float::build(8));
+      auto& divisor = null_ius.emplace_back(IR::Float::build(8));
+      const IU* result = output_type->numBytes() == 8 ? &out : &null_ius.emplace_back(IR::Float::build(8));
+      raw_out = &as_double;
+      post_helpers.push_back(NullHelper{Type::Constant, &divisor, {&as_double}, IR::F8::build(std::pow(10.0, from->getScale()))});
+      post_helpers.push_back(NullHelper{Type::Divide, result, {&as_double, &divisor}});
+      if (result != &out) {
+         post_helpers.push_back(NullHelper{Type::Cast, &out, {result}});
+      }
+      return;
+   }
+   // Casts between decimals and integers.
+   const size_t from_scale = from ? from->getScale() : 0;
+   const size_t to_scale = to ? to->getScale() : 0;
+   if (to_scale > from_scale) {
+      // Cast into the target first and scale up afterwards.
+      auto& casted = null_ius.emplace_back(output_type);
+      raw_out = &casted;
+      post_helpers.push_back(NullHelper{Type::Multiply, &out, {&casted}, IR::DecimalVal::build(output_type, powerOfTen(to_scale - from_scale))});
+   } else if (from_scale > to_scale) {
+      // Scale down first, the cast can then narrow the value.
+      auto& divisor = null_ius.emplace_back(source);
+      auto& scaled = null_ius.emplace_back(source);
+      pre_helpers.push_back(NullHelper{Type::Constant, &divisor, {value}, IR::DecimalVal::build(source, powerOfTen(from_scale - to_scale))});
+      pre_helpers.push_back(NullHelper{Type::Divide, &scaled, {value, &divisor}});
+      replaced_sources[0] = &scaled;
+   }
+}
+
+void ExpressionOp::ComputeNode::planDecimalDivide() {
+   auto result = dynamic_cast<const IR::Decimal*>(output_type.get());
+   if (code != Type::Divide || !result) {
+      return;
+   }
+   // A runtime parameter is the dividend.
+   const auto& dividend_type = opt_runtime_param ? (*opt_runtime_param)->getType() : children[0]->output_type;
+   const auto& divisor_type = opt_runtime_param ? children[0]->output_type : children[1]->output_type;
+   auto dividend = static_cast<const IR::Decimal*>(dividend_type.get());
+   auto divisor = static_cast<const IR::Decimal*>(divisor_type.get());
+   const size_t shift = result->getScale() + divisor->getScale() - dividend->getScale();
+   if (shift == 0) {
+      return;
+   }
+   auto scaled_type = IR::Decimal::build(dividend->getPrecision() + shift, dividend->getScale() + shift);
+   auto& scaled = null_ius.emplace_back(scaled_type);
+   if (opt_runtime_param) {
+      // Materialize the scaled constant and divide in a helper. The runtime parameter itself
+      // stays unscaled, the simplifier rebuilds nodes from it.
+      const IU* value = valueIU(children[0]);
+      const auto constant = static_cast<IR::DecimalVal&>(**opt_runtime_param).value * powerOfTen(shift);
+      pre_helpers.push_back(NullHelper{Type::Constant, &scaled, {value}, IR::DecimalVal::build(scaled_type, constant)});
+      pre_helpers.push_back(NullHelper{Type::Divide, &out, {&scaled, value}});
+      raw_out = nullptr;
+      return;
+   }
+   const IU* value = valueIU(children[0]);
+   if (scaled_type->numBytes() != dividend_type->numBytes()) {
+      // Widen first, the scaled dividend needs 16 bytes.
+      auto& widened = null_ius.emplace_back(IR::Decimal::build(dividend->getPrecision() + shift, dividend->getScale()));
+      pre_helpers.push_back(NullHelper{Type::Cast, &widened, {value}});
+      value = &widened;
+   }
+   pre_helpers.push_back(NullHelper{Type::Multiply, &scaled, {value}, IR::DecimalVal::build(value->type, powerOfTen(shift))});
+   replaced_sources[0] = &scaled;
+}
+
+void ExpressionOp::ComputeNode::planNulls() {
+   // NULL indicators are Bool IUs. The value of a NULL row is undefined apart from Bools,
+   // where it is always false. This invariant allows filters and boolean logic to ignore
+   // NULLs in most cases.
+   std::vector<const IU*> values;
+   std::vector<const IU*> indicators;
+   for (auto child : children) {
+      values.push_back(valueIU(child));
+      indicators.push_back(child->nullIndicator());
+   }
+
+   if (code == Type::IsNull) {
+      // IS NULL is fully evaluated by helpers and never NULL itself.
+      raw_out = nullptr;
+      if (indicators[0]) {
+         pre_helpers.push_back(NullHelper{Type::Cast, &out, {indicators[0]}});
+      } else {
+         // Not nullable, the result is constant false.
+         auto& constant = null_ius.emplace_back(IR::UnsignedInt::build(1));
+         pre_helpers.push_back(NullHelper{Type::Constant, &constant, {values[0]}, IR::UI<1>::build(0)});
+         pre_helpers.push_back(NullHelper{Type::Cast, &out, {&constant}});
+      }
+      return;
+   }
+
+   if (code == Type::Constant || std::all_of(indicators.begin(), indicators.end(), [](const IU* ind) { return ind == nullptr; })) {
+      // No NULLs can be produced by this node - no overhead.
+      return;
+   }
+
+   auto bool_iu = [&]() -> const IU* {
+      return &null_ius.emplace_back(IR::Bool::build());
+   };
+
+   if (code == Type::Divide && !opt_runtime_param && indicators[1]) {
+      if (auto one = integerOne(values[1]->type)) {
+         // Integer division by a NULL divisor must not trap. NULL divisors become one:
+         // safe = value * (1 - null) + null.
+         auto& as_int = null_ius.emplace_back(values[1]->type);
+         auto& valid = null_ius.emplace_back(values[1]->type);
+         auto& masked = null_ius.emplace_back(values[1]->type);
+         auto& safe = null_ius.emplace_back(values[1]->type);
+         pre_helpers.push_back(NullHelper{Type::Cast, &as_int, {indicators[1]}});
+         pre_helpers.push_back(NullHelper{Type::Subtract, &valid, {&as_int}, std::move(one)});
+         pre_helpers.push_back(NullHelper{Type::Multiply, &masked, {values[1], &valid}});
+         pre_helpers.push_back(NullHelper{Type::Add, &safe, {&masked, &as_int}});
+         replaced_sources[1] = &safe;
+      }
+   }
+
+   if (code == Type::And || code == Type::Or) {
+      // Three-valued logic on the masked inputs.
+      const IU* a_null = indicators[0];
+      const IU* b_null = indicators[1];
+      const IU* null;
+      if (code == Type::Or) {
+         // NULL if any input is NULL and the result isn't true.
+         const IU* any_null = a_null ? a_null : b_null;
+         if (a_null && b_null) {
+            any_null = bool_iu();
+            post_helpers.push_back(NullHelper{Type::Or, any_null, {a_null, b_null}});
+         }
+         null = bool_iu();
+         post_helpers.push_back(NullHelper{Type::Greater, null, {any_null, &out}});
+      } else if (a_null && b_null) {
+         // NULL if no input is false and any input is NULL.
+         auto a_not_false = bool_iu();
+         auto b_not_false = bool_iu();
+         auto no_false = bool_iu();
+         auto any_null = bool_iu();
+         null = bool_iu();
+         post_helpers.push_back(NullHelper{Type::Or, a_not_false, {a_null, values[0]}});
+         post_helpers.push_back(NullHelper{Type::Or, b_not_false, {b_null, values[1]}});
+         post_helpers.push_back(NullHelper{Type::And, no_false, {a_not_false, b_not_false}});
+         post_helpers.push_back(NullHelper{Type::Or, any_null, {a_null, b_null}});
+         post_helpers.push_back(NullHelper{Type::And, null, {no_false, any_null}});
+      } else {
+         // NULL if the nullable input is NULL and the other one is true.
+         null = bool_iu();
+         if (a_null) {
+            post_helpers.push_back(NullHelper{Type::And, null, {a_null, values[1]}});
+         } else {
+            post_helpers.push_back(NullHelper{Type::And, null, {b_null, values[0]}});
+         }
+      }
+      out.null_indicator = null;
+      return;
+   }
+
+   // Regular operations are NULL if any input is NULL.
+   const IU* null = nullptr;
+   for (const IU* indicator : indicators) {
+      if (!indicator) {
+         continue;
+      }
+      if (!null) {
+         // A single nullable input can simply share its indicator.
+         null = indicator;
+      } else {
+         auto combined = bool_iu();
+         post_helpers.push_back(NullHelper{Type::Or, combined, {null, indicator}});
+         null = combined;
+      }
+   }
+   out.null_indicator = null;
+
+   if (dynamic_cast<const IR::Bool*>(output_type.get())) {
+      // Bool results have to be false for NULL rows: out = raw && !null.
+      raw_out = bool_iu();
+      post_helpers.push_back(NullHelper{Type::Greater, &out, {raw_out, null}});
+   }
 }
 
 void ExpressionOp::decay(PipelineDAG& dag) const {
@@ -90,21 +612,36 @@ void ExpressionOp::decayNode(Node* node, std::unordered_map<Node*, const IU*>& b
          decayNode(child, built, dag);
          source_ius.push_back(built[child]);
       }
-      std::vector<const IU*> out_ius{&compute_node->out};
-      SuboperatorArc subop;
-      if (!compute_node->opt_runtime_param) {
-         // Add a regular ExpressionSubop for this node.
-         subop = std::make_shared<ExpressionSubop>(this, std::move(out_ius), std::move(source_ius), compute_node->code);
-      } else {
-         // Add a RuntimeExpressionSubop for this node.
-         subop = std::make_shared<RuntimeExpressionSubop>(this, std::move(out_ius), std::move(source_ius), compute_node->code, (*compute_node->opt_runtime_param)->getType());
-         // Add the runtime parameters needed for the runtime expression.
-         RuntimeExpressionParams params;
-         params.dataSet((*compute_node->opt_runtime_param)->copy());
-         static_cast<RuntimeExpressionSubop&>(*subop).attachRuntimeParams(std::move(params));
+      for (const auto& helper : compute_node->pre_helpers) {
+         attachExpression(helper.code, *helper.out, helper.sources, helper.runtime_param, dag);
+      }
+      for (const auto& [idx, replaced] : compute_node->replaced_sources) {
+         source_ius[idx] = replaced;
+      }
+      if (compute_node->raw_out) {
+         attachExpression(compute_node->code, *compute_node->raw_out, std::move(source_ius), compute_node->opt_runtime_param, dag);
+      }
+      for (const auto& helper : compute_node->post_helpers) {
+         attachExpression(helper.code, *helper.out, helper.sources, helper.runtime_param, dag);
       }
-      dag.getCurrentPipeline().attachSuboperator(std::move(subop));
    }
 }
 
+void ExpressionOp::attachExpression(ComputeNode::Type code, const IU& out_iu, std::vector<const IU*> source_ius, const std::optional<IR::ValuePtr>& runtime_param, PipelineDAG& dag) const {
+   std::vector<const IU*> out_ius{&out_iu};
+   SuboperatorArc subop;
+   if (!runtime_param) {
+      // Add a regular ExpressionSubop for this node.
+      subop = std::make_shared<ExpressionSubop>(this, std::move(out_ius), std::move(source_ius), code);
+   } else {
+      // Add a RuntimeExpressionSubop for this node.
+      subop = std::make_shared<RuntimeExpressionSubop>(this, std::move(out_ius), std::move(source_ius), code, (*runtime_param)->getType());
+      // Add the runtime parameters needed for the runtime expression.
+      RuntimeExpressionParams params;
+      params.dataSet((*runtime_param)->copy());
+      static_cast<RuntimeExpressionSubop&>(*subop).attachRuntimeParams(std::move(params));
+   }
+   dag.getCurrentPipeline().attachSuboperator(std::move(subop));
+}
+
 } // namespace inkfuse
@@ -3,6 +3,7 @@
 
 #include "algebra/RelAlgOp.h"
 #include "codegen/Value.h"
+#include <list>
 #include <optional>
 #include <unordered_map>
 #include <unordered_set>
@@ -11,11 +12,18 @@
 namespace inkfuse {
 
 /// Relational algebra operator for evaluating a set of expressions.
+///
+/// Before the output IUs are defined, the expression DAG is simplified: identical compute nodes are
+/// merged (hash-consing), chains of integer constants are folded (`(x + 1) + 2` becomes `x + 3`) and
+/// operations with neutral constants are dropped. Every distinct value is computed once per chunk.
 struct ExpressionOp : public RelAlgOp {
    struct Node {
       virtual ~Node() = default;
       Node(IR::TypeArc output_type_) : output_type(std::move(output_type_)){};
 
+      /// Get the NULL indicator of the node's output. nullptr if the output can never be NULL.
+      virtual const IU* nullIndicator() const = 0;
+
       const IR::TypeArc output_type;
    };
 
@@ -25,6 +33,8 @@ struct ExpressionOp : public RelAlgOp {
    struct IURefNode : public Node {
       IURefNode(const IU* child_);
 
+      const IU* nullIndicator() const override;
+
       const IU* child;
    };
 
@@ -49,6 +59,17 @@ struct ExpressionOp : public RelAlgOp {
          StrEquals,
          InList,
          NotLikeTokens,
+         /// LIKE and ILIKE with an `IR::LikePattern` runtime parameter.
+         Like,
+         IsNull,
+      };
+
+      /// Additional expression that has to be evaluated to propagate NULLs through this node.
+      struct NullHelper {
+         Type code;
+         const IU* out;
+         std::vector<const IU*> sources;
+         std::optional<IR::ValuePtr> runtime_param = std::nullopt;
       };
 
       // Constructor for regular binary operations.
@@ -58,6 +79,8 @@ struct ExpressionOp : public RelAlgOp {
       // Constructor for operation with runtime parameter.
       ComputeNode(Type code, IR::ValuePtr arg_1, Node* arg_2);
 
+      const IU* nullIndicator() const override;
+
       // Which expression?
       Type code;
       // Output IU on this node.
@@ -66,6 +89,29 @@ struct ExpressionOp : public RelAlgOp {
       std::vector<Node*> children;
       // Optional constant second argument if this is turns into a RuntimeExpressionSubop.
       std::optional<IR::ValuePtr> opt_runtime_param;
+
+      // IU the expression itself writes into. Differs from `out` if a Bool result has to be
+      // masked for NULL rows. nullptr if the node is evaluated by the helpers alone.
+      const IU* raw_out = &out;
+      // Helpers evaluated before the expression, e.g. to turn NULL divisors into safe values.
+      std::vector<NullHelper> pre_helpers;
+      // Helpers evaluated after the expression, computing the NULL indicator and the masked result.
+      std::vector<NullHelper> post_helpers;
+      // Children whose source IU is replaced by the result of a pre helper.
+      std::unordered_map<size_t, const IU*> replaced_sources;
+      // Intermediate IUs of the helpers.
+      std::list<IU> null_ius;
+
+      private:
+      /// Set up the rescaling of casts from and into decimals. The cast itself only converts
+      /// the scaled integer, helpers multiply or divide by the difference of the scales.
+      void planRescale();
+      /// Set up the decimal division. Helpers scale the dividend up so that the quotient
+      /// keeps the fractional digits of the derived result type.
+      void planDecimalDivide();
+      /// Set up NULL propagation for this node based on the NULL indicators of the children.
+      /// Nodes without nullable children don't get any helpers.
+      void planNulls();
    };
 
    ExpressionOp(
@@ -86,6 +132,9 @@ struct ExpressionOp : public RelAlgOp {
 
    void decay(PipelineDAG& dag) const override;
 
+   /// Additional fractional digits of decimal quotients, as long as the precision allows them.
+   static constexpr size_t DECIMAL_DIVIDE_EXTRA_SCALE = 4;
+
    /// Derive the output type of an expression.
    static IR::TypeArc derive(ComputeNode::Type code, const std::vector<Node*>& nodes);
    /// Derive the output type of an expression.
@@ -97,8 +146,18 @@ struct ExpressionOp : public RelAlgOp {
       Node* node,
       std::unordered_map<Node*, const IU*>& built,
       PipelineDAG& dag) const;
+   /// Attach a single expression suboperator to the current pipeline.
+   void attachExpression(
+      ComputeNode::Type code,
+      const IU& out_iu,
+      std::vector<const IU*> source_ius,
+      const std::optional<IR::ValuePtr>& runtime_param,
+      PipelineDAG& dag) const;
 
    private:
+   /// Rewrite the expression DAG before decay, see the struct comment.
+   void simplify();
+
    // Output nodes which actually generate columns.
    std::vector<Node*> out;
    /// Compute nodes which have to be evaluated.
@@ -1,6 +1,8 @@
 #include "algebra/Filter.h"
 #include "algebra/Pipeline.h"
 #include "algebra/suboperators/ColumnFilter.h"
+#include "storage/Relation.h"
+#include <unordered_map>
 
 namespace inkfuse {
 
@@ -14,9 +16,20 @@ Filter::Filter(std::vector<std::unique_ptr<RelAlgOp>> children_, std::string nam
       redefined.reserve(to_redefine.size());
       output_ius.reserve(to_redefine.size());
       // Define the output IUs which we will use.
+      std::unordered_map<const IU*, const IU*> indicator_map;
       for (const IU* iu : to_redefine) {
          assert(iu);
-         redefined.emplace_back(iu->type);
+         auto& new_iu = redefined.emplace_back(iu->type);
+         if (iu->null_indicator) {
+            // Nullable IUs carry their NULL indicator through the filter. IUs can share indicators,
+            // which are only redefined once.
+            auto it = indicator_map.find(iu->null_indicator);
+            if (it == indicator_map.end()) {
+               indicators_to_redefine.push_back(iu->null_indicator);
+               it = indicator_map.emplace(iu->null_indicator, &redefined_indicators.emplace_back(IR::Bool::build())).first;
+            }
+            new_iu.null_indicator = it->second;
+         }
       }
       // Set up output structure.
       for (const IU& iu : redefined) {
@@ -25,6 +38,15 @@ Filter::Filter(std::vector<std::unique_ptr<RelAlgOp>> children_, std::string nam
    }
 }
 
+std::optional<ValueRange> Filter::valueRange(const IU& iu) const {
+   for (size_t k = 0; k < redefined.size(); ++k) {
+      if (&redefined[k] == &iu) {
+         return children[0]->valueRange(*to_redefine[k]);
+      }
+   }
+   return RelAlgOp::valueRange(iu);
+}
+
 void Filter::decay(PipelineDAG& dag) const
 {
    // First decay the children.
@@ -35,14 +57,20 @@ void Filter::decay(PipelineDAG& dag) const
    auto& scope_supop = pipe.attachSuboperator(ColumnFilterScope::build(this, filter_iu, pseudo_iu));
    auto& scope = reinterpret_cast<ColumnFilterScope&>(scope_supop);
    // Attach the logic operators performing the copies.
-   for (size_t k = 0; k < redefined.size(); ++k) {
-      const IU& old_iu = *to_redefine[k];
-      const IU& new_iu = redefined[k];
+   auto attach_logic = [&](const IU& old_iu, const IU& new_iu) {
       auto logic = ColumnFilterLogic::build(this, pseudo_iu, old_iu, new_iu);
       // Attach filter dependency to the scope suboperator. This makes sure the source IUs
       // are generated before the filter.
       scope.attachFilterLogicDependency(*logic, old_iu);
       pipe.attachSuboperator(std::move(logic));
+   };
+   for (size_t k = 0; k < redefined.size(); ++k) {
+      attach_logic(*to_redefine[k], redefined[k]);
+   }
+   auto redefined_indicator = redefined_indicators.begin();
+   for (const IU* indicator : indicators_to_redefine) {
+      attach_logic(*indicator, *redefined_indicator);
+      redefined_indicator++;
    }
 }
 
@@ -2,6 +2,7 @@
 #define INKFUSE_FILTER_H
 
 #include "algebra/RelAlgOp.h"
+#include <list>
 
 namespace inkfuse {
 
@@ -13,6 +14,9 @@ struct Filter : RelAlgOp {
 
    void decay(PipelineDAG& dag) const override;
 
+   /// Redefined IUs have the value range of the original IU.
+   std::optional<ValueRange> valueRange(const IU& iu) const override;
+
    private:
    Filter(std::vector<std::unique_ptr<RelAlgOp>> children_, std::string name, std::vector<const IU*> redefined_, const IU& filter_iu_);
 
@@ -24,6 +28,10 @@ struct Filter : RelAlgOp {
    std::vector<const IU*> to_redefine;
    /// Redefined IUs after the filter.
    std::vector<IU> redefined;
+   /// NULL indicators of the redefined IUs. These have to pass through the filter as well.
+   std::vector<const IU*> indicators_to_redefine;
+   /// Redefined NULL indicators after the filter.
+   std::list<IU> redefined_indicators;
 };
 
 }
@@ -0,0 +1,361 @@
+#include "algebra/GroupJoin.h"
+#include "algebra/AggregationMerger.h"
+#include "algebra/Pipeline.h"
+#include "algebra/suboperators/ColumnFilter.h"
+#include "algebra/suboperators/RuntimeFunctionSubop.h"
+#include "algebra/suboperators/aggregation/AggReaderSubop.h"
+#include "algebra/suboperators/aggregation/AggregatorSubop.h"
+#include "algebra/suboperators/row_layout/KeyPackerSubop.h"
+#include "algebra/suboperators/row_layout/KeyUnpackerSubop.h"
+#include "algebra/suboperators/sources/HashTableSource.h"
+#include "algebra/suboperators/sources/ScratchPadIUProvider.h"
+#include <algorithm>
+#include <cstring>
+#include <functional>
+#include <numeric>
+#include <set>
+
+namespace inkfuse {
+
+namespace {
+
+/// Number of slots whose partial states get merged by a thread at once.
+const uint64_t MERGE_RANGE_SLOTS = 1 << 16;
+
+/// Insert the materialized build rows into the group join hash table.
+void materializedTupleToGroups(size_t key_size, size_t row_size, TupleMaterializerState& mat, AtomicHashTable<SimpleKeyComparator>& hash_table) {
+   assert(mat.handles.size() == mat.materializers.size());
+   // Hash and prefetch batches of rows before inserting them, as in the join build.
+   const size_t batch_size = 256;
+   std::vector<uint64_t> hashes(batch_size);
+   for (auto& read_handle : mat.handles) {
+      while (const TupleMaterializer::MatChunk* chunk = read_handle->pullChunk()) {
+         const char* row = reinterpret_cast<const char*>(chunk->data.get());
+         while (row < chunk->end_ptr) {
+            const size_t curr_batch_size = std::min(batch_size, (chunk->end_ptr - row) / row_size);
+            hash_table.compute_hash_and_prefetch_batch(row, row_size, /* indirect = */ false, curr_batch_size, hashes.data());
+            for (size_t batch_idx = 0; batch_idx < curr_batch_size; ++batch_idx) {
+               // Groups use the outer join tags. Probe rows mark the groups they hit.
+               char* slot = hash_table.insertOuter<true>(row, hashes[batch_idx]);
+               // The slot is larger than the row, only copy the payload behind the key.
+               // The aggregate state behind the row stays zero-initialized.
+               std::memcpy(slot + key_size, row + key_size, row_size - key_size);
+               row += row_size;
+            }
+         }
+      }
+   }
+}
+
+/// Merge the thread-local partial states into the hash table slots. Threads claim slot ranges until all were merged.
+void mergePartialStates(const std::vector<std::pair<const IU*, AggStatePtr>>& granules, size_t state_offset, GroupJoinState& state) {
+   auto& hash_table = *state.ht_state.hash_table;
+   std::vector<std::pair<const char*, char*>> merge_pairs;
+   for (uint64_t range = state.next_merge_range.fetch_add(1); range * MERGE_RANGE_SLOTS < hash_table.capacity(); range = state.next_merge_range.fetch_add(1)) {
+      const uint64_t end = std::min(hash_table.capacity(), (range + 1) * MERGE_RANGE_SLOTS);
+      merge_pairs.clear();
+      uint64_t it_idx = hash_table.iteratorMorsel(range * MERGE_RANGE_SLOTS, end, MERGE_RANGE_SLOTS).first;
+      char* it_data = it_idx < end ? hash_table.iteratorData(it_idx) : nullptr;
+      while (it_idx < end) {
+         for (const auto& partials : state.partials) {
+            merge_pairs.emplace_back(partials.at(it_idx), it_data + state_offset);
+         }
+         hash_table.iteratorAdvance(&it_data, &it_idx, end);
+      }
+      // The partial states have the same layout as the state within the slot.
+      mergeAggregateGranules(granules, merge_pairs, 0);
+   }
+}
+
+}
+
+GroupJoin::GroupJoin(
+   std::vector<std::unique_ptr<RelAlgOp>> children_,
+   std::string op_name_,
+   std::vector<const IU*> keys_left_,
+   std::vector<const IU*> payload_left_,
+   std::vector<const IU*> keys_right_,
+   std::vector<AggregateFunctions::Description> aggregates_,
+   JoinType type_)
+   : RelAlgOp(std::move(children_), std::move(op_name_)),
+     type(type_),
+     keys_left(std::move(keys_left_)),
+     payload_left(std::move(payload_left_)),
+     keys_right(std::move(keys_right_)),
+     build_row(IR::Pointer::build(IR::Char::build())),
+     hash_right(IR::UnsignedInt::build(8)),
+     lookup_right(IR::Pointer::build(IR::Char::build())),
+     filter_pseudo_iu(IR::Void::build()),
+     filtered_slot(IR::Pointer::build(IR::Char::build())),
+     partial_state(IR::Pointer::build(IR::Char::build())),
+     ht_scan_result(IR::Pointer::build(IR::Char::build())) {
+   if (children.size() != 2) {
+      throw std::runtime_error("GroupJoin needs to have two children");
+   }
+   plan(std::move(aggregates_));
+}
+
+std::unique_ptr<GroupJoin> GroupJoin::build(
+   std::vector<std::unique_ptr<RelAlgOp>> children_,
+   std::string op_name_,
+   std::vector<const IU*> keys_left_,
+   std::vector<const IU*> payload_left_,
+   std::vector<const IU*> keys_right_,
+   std::vector<AggregateFunctions::Description> aggregates_,
+   JoinType type_) {
+   return std::unique_ptr<GroupJoin>(new GroupJoin(std::move(children_), std::move(op_name_), std::move(keys_left_), std::move(payload_left_), std::move(keys_right_), std::move(aggregates_), type_));
+}
+
+void GroupJoin::plan(std::vector<AggregateFunctions::Description> description) {
+   if (type == JoinType::LeftSemi) {
+      throw std::runtime_error("GroupJoin only supports inner and left outer joins");
+   }
+   if (keys_left.empty() || keys_left.size() != keys_right.size()) {
+      throw std::runtime_error("GroupJoin needs the same number of keys on both sides");
+   }
+   if (description.empty()) {
+      throw std::runtime_error("GroupJoin needs at least one aggregate function");
+   }
+
+   // The build row layout: [keys | payload | payload NULL indicators].
+   // The keys are a primary key of the build side, so the build row is the group.
+   for (size_t k = 0; k < keys_left.size(); ++k) {
+      if (keys_left[k]->null_indicator || keys_right[k]->null_indicator) {
+         throw std::runtime_error("GroupJoin does not support nullable keys");
+      }
+      if (keys_left[k]->type->numBytes() != keys_right[k]->type->numBytes()) {
+         throw std::runtime_error("GroupJoin keys have to be of the same type");
+      }
+      key_size += keys_left[k]->type->numBytes();
+   }
+   auto add_column = [&](const IU* in) {
+      auto& out = out_ius.emplace_back(in->type);
+      output_ius.push_back(&out);
+      full_row_left.push_back(in);
+      full_row_out.push_back(&out);
+      return &out;
+   };
+   for (const IU* key : keys_left) {
+      add_column(key);
+   }
+   std::vector<IU*> payload_out;
+   for (const IU* payload : payload_left) {
+      payload_out.push_back(add_column(payload));
+   }
+   for (size_t k = 0; k < payload_left.size(); ++k) {
+      if (const IU* indicator = payload_left[k]->null_indicator) {
+         auto& out = out_indicators.emplace_back(IR::Bool::build());
+         payload_out[k]->null_indicator = &out;
+         full_row_left.push_back(indicator);
+         full_row_out.push_back(&out);
+      }
+   }
+   for (const IU* col : full_row_left) {
+      row_size += col->type->numBytes();
+   }
+
+   // The probe key gets packed into a scratch pad for the lookup.
+   scratch_pad_right.emplace(IR::ByteArray::build(key_size));
+   for (size_t k = 0; k < keys_right.size(); ++k) {
+      right_pseudo_ius.emplace_back(IR::Void::build());
+   }
+
+   // Aggregated probe columns have to be filtered on the rows that found a group.
+   auto filter_column = [&](const IU& in) -> const IU& {
+      auto existing = std::find_if(filtered.begin(), filtered.end(), [&](const FilteredColumn& col) { return col.in == &in; });
+      if (existing != filtered.end()) {
+         return existing->out;
+      }
+      auto& col = filtered.emplace_back(FilteredColumn{.in = &in, .out = IU(in.type)});
+      if (in.null_indicator) {
+         col.indicator_out.emplace(IR::Bool::build());
+         col.out.null_indicator = &*col.indicator_out;
+      }
+      return col.out;
+   };
+
+   // Plan the aggregate state the same way as the Aggregation: a minimal set of granules, sorted by their
+   // size to keep the state updates aligned.
+   using GranuleDescription = std::tuple<size_t, const IU*, std::string>;
+   std::set<GranuleDescription, std::greater<>> to_compute;
+   std::vector<std::pair<const IU*, AggregateFunctions::RegistryEntry>> functions;
+   functions.reserve(description.size());
+   for (const auto& func : description) {
+      if (func.distinct) {
+         throw std::runtime_error("GroupJoin does not support distinct aggregates");
+      }
+      const IU& agg_iu = filter_column(func.agg_iu);
+      const auto& [iu, entry] = functions.emplace_back(&agg_iu, AggregateFunctions::lookupSubops(func));
+      for (const auto& granule : entry.granules) {
+         to_compute.insert({granule->getStateSize(), iu, granule->id()});
+      }
+   }
+   granules.resize(to_compute.size());
+   auto offset_accumulator = [](size_t sum, const GranuleDescription& desc) {
+      return sum + std::get<0>(desc);
+   };
+   state_size = std::accumulate(to_compute.begin(), to_compute.end(), static_cast<size_t>(0), offset_accumulator);
+   // The aggregate state starts at the first aligned offset behind the build row.
+   const size_t largest_state = std::min<size_t>(std::get<0>(*to_compute.begin()), 8);
+   state_offset = (row_size + largest_state - 1) / largest_state * largest_state;
+   if (state_offset + state_size > std::numeric_limits<uint16_t>::max()) {
+      throw std::runtime_error("GroupJoin hash table slots are too large");
+   }
+
+   for (auto& [iu, entry] : functions) {
+      std::vector<size_t> offsets;
+      offsets.reserve(entry.granules.size());
+      for (auto& granule : entry.granules) {
+         auto granule_it = to_compute.find({granule->getStateSize(), iu, granule->id()});
+         auto idx = std::distance(to_compute.begin(), granule_it);
+         offsets.push_back(std::accumulate(to_compute.begin(), granule_it, static_cast<size_t>(0), offset_accumulator));
+         granules[idx] = {iu, std::move(granule)};
+      }
+      compute.push_back(PlannedAggCompute{
+         .compute = std::move(entry.agg_reader),
+         .granule_offsets = std::move(offsets),
+      });
+      auto& out_iu = out_aggregate_ius.emplace_back(entry.result_type);
+      output_ius.push_back(&out_iu);
+   }
+}
+
+void GroupJoin::decay(PipelineDAG& dag) const {
+   auto& mat_state = dag.attachTupleMaterializers(0, row_size);
+   auto& ht_state = dag.attachAtomicHashTable<SimpleKeyComparator>(0, mat_state);
+   auto& gj_state = dag.attachGroupJoinState(0, ht_state);
+   const size_t slot_size = state_offset + state_size;
+
+   // Step 1: Materialize the build rows.
+   {
+      children[0]->decay(dag);
+      auto& build_pipe = dag.getCurrentPipeline();
+      build_pipe.attachSuboperator(RuntimeFunctionSubop::materializeTuple(this, build_row, full_row_left, &mat_state));
+      size_t offset = 0;
+      for (const IU* col : full_row_left) {
+         auto& packer = build_pipe.attachSuboperator(KeyPackerSubop::build(this, *col, build_row, {}));
+         KeyPackingRuntimeParams param;
+         param.offsetSet(IR::UI<2>::build(offset));
+         reinterpret_cast<KeyPackerSubop&>(packer).attachRuntimeParams(std::move(param));
+         offset += col->type->numBytes();
+      }
+   }
+
+   // Runtime task: build the hash table with room for the aggregate states and set up the partial states.
+   dag.addRuntimeTask(PipelineDAG::RuntimeTask{
+      .after_pipe = dag.getPipelines().size() - 1,
+      .prepare_function = [this, slot_size, &mat_state, &ht_state, &gj_state](ExecutionContext&, size_t total_threads) {
+         size_t total_rows = 0;
+         for (const auto& materializer : mat_state.materializers) {
+            total_rows += materializer.getNumTuples();
+         }
+         // Same sizing as the join: at least 2x capacity, rounded to the next power of two.
+         const size_t min_capacity = std::max(static_cast<size_t>(2), 2 * total_rows);
+         const size_t total_slots = 1ull << (64 - __builtin_clzl(min_capacity - 1));
+         ht_state.hash_table = std::make_unique<AtomicHashTable<SimpleKeyComparator>>(SimpleKeyComparator(key_size), slot_size, total_slots);
+         gj_state.prepare(total_threads);
+         for (auto& partials : gj_state.partials) {
+            partials.allocate(ht_state.hash_table->iteratorData(0), slot_size, state_size, total_slots);
+         }
+      },
+      .worker_function = [this, &mat_state, &ht_state](ExecutionContext&, size_t) {
+         materializedTupleToGroups(key_size, row_size, mat_state, *ht_state.hash_table);
+      },
+   });
+
+   // Step 2: Probe and update the thread-local aggregate state of the groups.
+   {
+      children[1]->decay(dag);
+      auto& probe_pipe = dag.getCurrentPipeline();
+
+      // 2.1 Pack the probe key.
+      probe_pipe.attachSuboperator(ScratchPadIUProvider::build(this, *scratch_pad_right));
+      size_t key_offset = 0;
+      auto probe_pseudo = right_pseudo_ius.begin();
+      for (const IU* key : keys_right) {
+         auto& packer = probe_pipe.attachSuboperator(KeyPackerSubop::build(this, *key, *scratch_pad_right, {&(*probe_pseudo)}));
+         KeyPackingRuntimeParams param;
+         param.offsetSet(IR::UI<2>::build(key_offset));
+         reinterpret_cast<KeyPackerSubop&>(packer).attachRuntimeParams(std::move(param));
+         key_offset += key->type->numBytes();
+         probe_pseudo++;
+      }
+
+      // 2.2 Find the group. The lookup marks the group as having a probe row.
+      {
+         Pipeline::ROFScopeGuard rof_guard{probe_pipe};
+         std::vector<const IU*> pseudo;
+         for (const auto& pseudo_iu : right_pseudo_ius) {
+            pseudo.push_back(&pseudo_iu);
+         }
+         probe_pipe.attachSuboperator(RuntimeFunctionSubop::htHashAndPrefetch<AtomicHashTable<SimpleKeyComparator>>(this, hash_right, *scratch_pad_right, std::move(pseudo), key_size, &ht_state));
+         probe_pipe.attachSuboperator(RuntimeFunctionSubop::htLookupWithHash<AtomicHashTable<SimpleKeyComparator>, false, true>(this, lookup_right, *scratch_pad_right, hash_right, /* prefetch_pseudo = */ nullptr, &ht_state));
+      }
+
+      // 2.3 Filter on rows that found a group.
+      auto& filter_scope_subop = probe_pipe.attachSuboperator(ColumnFilterScope::build(this, lookup_right, filter_pseudo_iu));
+      auto& filter_scope = reinterpret_cast<ColumnFilterScope&>(filter_scope_subop);
+      auto& filter_slot = probe_pipe.attachSuboperator(ColumnFilterLogic::build(this, filter_pseudo_iu, lookup_right, filtered_slot, /* filter_type= */ lookup_right.type, /* filters_itself= */ true));
+      filter_scope.attachFilterLogicDependency(filter_slot, lookup_right);
+      for (const auto& col : filtered) {
+         auto& filter_col = probe_pipe.attachSuboperator(ColumnFilterLogic::build(this, filter_pseudo_iu, *col.in, col.out, /* filter_type= */ lookup_right.type));
+         filter_scope.attachFilterLogicDependency(filter_col, *col.in);
+         if (col.indicator_out) {
+            auto& filter_indicator = probe_pipe.attachSuboperator(ColumnFilterLogic::build(this, filter_pseudo_iu, *col.in->null_indicator, *col.indicator_out, /* filter_type= */ lookup_right.type));
+            filter_scope.attachFilterLogicDependency(filter_indicator, *col.in->null_indicator);
+         }
+      }
+
+      // 2.4 Update the partial aggregate state of the group.
+      probe_pipe.attachSuboperator(RuntimeFunctionSubop::gjPartialState(this, partial_state, filtered_slot, &gj_state));
+      size_t curr_offset = 0;
+      for (const auto& [agg_iu, agg_state] : granules) {
+         auto& aggregator = reinterpret_cast<AggregatorSubop&>(probe_pipe.attachSuboperator(AggregatorSubop::build(this, *agg_state, partial_state, *agg_iu)));
+         KeyPackingRuntimeParams param;
+         param.offsetSet(IR::UI<2>::build(curr_offset));
+         aggregator.attachRuntimeParams(std::move(param));
+         curr_offset += agg_state->getStateSize();
+      }
+   }
+
+   // Runtime task: merge the partial states into the hash table slots.
+   dag.addRuntimeTask(PipelineDAG::RuntimeTask{
+      .after_pipe = dag.getPipelines().size() - 1,
+      .prepare_function = [this, &ht_state, &gj_state](ExecutionContext&, size_t) {
+         // Inner group joins only produce the groups that were marked by a probe row.
+         using IteratorSlots = AtomicHashTable<SimpleKeyComparator>::IteratorSlots;
+         ht_state.hash_table->setIteratorSlots(type == JoinType::LeftOuter ? IteratorSlots::All : IteratorSlots::Marked);
+         gj_state.next_merge_range = 0;
+      },
+      .worker_function = [this, &gj_state](ExecutionContext&, size_t) {
+         mergePartialStates(granules, state_offset, gj_state);
+      },
+   });
+
+   // Step 3: Read the groups in a new pipeline.
+   auto& read_pipe = dag.buildNewPipeline();
+   read_pipe.attachSuboperator(AtomicHashTableSource::build(this, ht_scan_result, &ht_state));
+   size_t row_offset = 0;
+   for (size_t k = 0; k < full_row_left.size(); ++k) {
+      auto& unpacker = read_pipe.attachSuboperator(KeyUnpackerSubop::build(this, ht_scan_result, *full_row_out[k]));
+      KeyPackingRuntimeParams param;
+      param.offsetSet(IR::UI<2>::build(row_offset));
+      reinterpret_cast<KeyUnpackerSubop&>(unpacker).attachRuntimeParams(std::move(param));
+      row_offset += full_row_left[k]->type->numBytes();
+   }
+   auto out_compute = compute.cbegin();
+   for (const auto& out_agg_iu : out_aggregate_ius) {
+      auto& reader = reinterpret_cast<AggReaderSubop&>(read_pipe.attachSuboperator(AggReaderSubop::build(this, ht_scan_result, out_agg_iu, *out_compute->compute)));
+      const auto& g_offsets = out_compute->granule_offsets;
+      KeyPackingRuntimeParamsTwo param;
+      param.offset_1Set(IR::UI<2>::build(state_offset + g_offsets[0]));
+      if (out_compute->compute->requiredGranules() == 2) {
+         assert(g_offsets.size() == 2);
+         param.offset_2Set(IR::UI<2>::build(state_offset + g_offsets[1]));
+      }
+      reader.attachRuntimeParams(std::move(param));
+      out_compute++;
+   }
+}
+
+}
@@ -0,0 +1,125 @@
+#ifndef INKFUSE_GROUPJOIN_H
+#define INKFUSE_GROUPJOIN_H
+
+#include "algebra/AggFunctionRegisty.h"
+#include "algebra/Join.h"
+#include "algebra/RelAlgOp.h"
+#include <list>
+#include <optional>
+
+namespace inkfuse {
+
+/// A group join computes `SELECT keys, payload, aggregates(probe) FROM build JOIN probe ON keys GROUP BY keys`
+/// in a single hash table when the join keys are a primary key of the build side. A join followed by an
+/// aggregation on the same keys would hash and materialize every row twice.
+///
+/// The group join decays as follows:
+/// - The build pipeline materializes [keys | payload] rows. A runtime task inserts them into an atomic hash
+///   table whose slots reserve zero-initialized space for the aggregate state behind the row.
+/// - The probe pipeline looks up the probe keys, filters on rows with a group and updates the aggregates.
+///   Probe rows of different threads can hit the same group, so every thread updates its own partial state
+///   of the slot (see GroupJoinPartials). The updates are the regular AggregatorSubops, giving both fused
+///   and interpreted implementations.
+/// - A runtime task merges the partial states of all threads into the slots in parallel.
+/// - A new pipeline reads the groups from the hash table. Inner group joins only produce groups with at
+///   least one probe row, left outer group joins produce every build row.
+/// The output consists of the build keys, the build payload and then the aggregate results.
+struct GroupJoin : public RelAlgOp {
+   static std::unique_ptr<GroupJoin> build(
+      std::vector<std::unique_ptr<RelAlgOp>> children_,
+      std::string op_name_,
+      std::vector<const IU*> keys_left_,
+      std::vector<const IU*> payload_left_,
+      std::vector<const IU*> keys_right_,
+      std::vector<AggregateFunctions::Description> aggregates_,
+      JoinType type_ = JoinType::Inner);
+
+   void decay(PipelineDAG& dag) const override;
+
+   private:
+   GroupJoin(
+      std::vector<std::unique_ptr<RelAlgOp>> children_,
+      std::string op_name_,
+      std::vector<const IU*> keys_left_,
+      std::vector<const IU*> payload_left_,
+      std::vector<const IU*> keys_right_,
+      std::vector<AggregateFunctions::Description> aggregates_,
+      JoinType type_);
+
+   /// Plan the row layout and the aggregate granules.
+   void plan(std::vector<AggregateFunctions::Description> description);
+
+   /// A probe-side column that gets aggregated. It has to be filtered on rows that found a group.
+   struct FilteredColumn {
+      const IU* in;
+      IU out;
+      /// The filtered NULL indicator of nullable columns.
+      std::optional<IU> indicator_out;
+   };
+
+   /// A planned aggregate computation.
+   struct PlannedAggCompute {
+      /// The actual computation.
+      AggComputePtr compute;
+      /// Offsets of the granules within the aggregate state.
+      std::vector<size_t> granule_offsets;
+   };
+
+   /// Does the group join produce groups without probe rows?
+   JoinType type;
+   /// The build side keys.
+   std::vector<const IU*> keys_left;
+   /// The build side payload.
+   std::vector<const IU*> payload_left;
+   /// The probe side keys.
+   std::vector<const IU*> keys_right;
+   /// The materialized build row: keys, payload and then the payload NULL indicators.
+   std::vector<const IU*> full_row_left;
+   /// Output IU for every column of the build row.
+   std::vector<const IU*> full_row_out;
+   /// The aggregated probe columns.
+   std::list<FilteredColumn> filtered;
+   /// The granules that are used to update the aggregate state.
+   std::vector<std::pair<const IU*, AggStatePtr>> granules;
+   /// The compute granules that will be turned into AggReaderSubops.
+   std::vector<PlannedAggCompute> compute;
+
+   /// Size of the packed key.
+   size_t key_size = 0;
+   /// Size of the materialized build row.
+   size_t row_size = 0;
+   /// Offset of the aggregate state within a hash table slot.
+   size_t state_offset = 0;
+   /// Size of the aggregate state.
+   size_t state_size = 0;
+
+   /// Materialized build row. Char* typed.
+   IU build_row;
+   /// Packed probe key. ByteArray typed.
+   std::optional<IU> scratch_pad_right;
+   /// Void-typed pseudo-IUs that connect the probe key packing with the hash table lookup.
+   std::list<IU> right_pseudo_ius;
+   /// Computed hash on the probe side.
+   IU hash_right;
+   /// Lookup result on the probe side. Char* typed.
+   IU lookup_right;
+   /// Void-typed pseudo IU for the filter on rows that have no group.
+   IU filter_pseudo_iu;
+   /// Slot of the rows that found a group. Char* typed.
+   IU filtered_slot;
+   /// Thread-local partial aggregate state of the slot. Char* typed.
+   IU partial_state;
+   /// Slot produced by the hash table source. Char* typed.
+   IU ht_scan_result;
+
+   /// The output IUs of the build row.
+   std::list<IU> out_ius;
+   /// The result IUs that are produced by the aggregate functions.
+   std::list<IU> out_aggregate_ius;
+   /// The output NULL indicators.
+   std::list<IU> out_indicators;
+};
+
+}
+
+#endif //INKFUSE_GROUPJOIN_H
@@ -23,6 +23,10 @@ struct IU {
    IR::TypeArc type;
    /// The name for this IU.
    std::string name;
+   /// If the IU is nullable, a Bool-typed IU which is true for all rows in which this IU is NULL.
+   /// The value of a NULL row is undefined, apart from Bool-typed IUs where it is always false.
+   /// IUs that can never be NULL don't have an indicator, meaning they don't incur any overhead.
+   const IU* null_indicator = nullptr;
 };
 
 }
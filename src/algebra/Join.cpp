@@ -1,16 +1,27 @@
 #include "algebra/Join.h"
 #include "algebra/suboperators/ColumnFilter.h"
 #include "algebra/suboperators/RuntimeFunctionSubop.h"
+#include "algebra/suboperators/expressions/ExpressionSubop.h"
+#include "algebra/suboperators/expressions/RuntimeExpressionSubop.h"
 #include "algebra/suboperators/row_layout/KeyPackerSubop.h"
 #include "algebra/suboperators/row_layout/KeyUnpackerSubop.h"
 #include "algebra/suboperators/sources/HashTableSource.h"
 #include "algebra/suboperators/sources/ScratchPadIUProvider.h"
 #include <algorithm>
+#include <cstring>
 
 namespace inkfuse {
 
 namespace {
 
+/// Attach a RuntimeExpressionSubop producing a constant byte. `source` only serves as input dependency.
+void attachConstantByte(const RelAlgOp* op, Pipeline& pipe, const IU& source, const IU& out, uint8_t value) {
+   auto& subop = pipe.attachSuboperator(RuntimeExpressionSubop::build(op, {&out}, {&source}, ExpressionOp::ComputeNode::Type::Constant, IR::UnsignedInt::build(1)));
+   RuntimeExpressionParams params;
+   params.dataSet(IR::UI<1>::build(value));
+   reinterpret_cast<RuntimeExpressionSubop&>(subop).attachRuntimeParams(std::move(params));
+}
+
 void allocHashTable(
    size_t key_size,
    size_t slot_size,
@@ -35,7 +46,10 @@ void allocHashTable(
 }
 
 void materializedTupleToHashTable(
-   size_t slot_size,
+   bool outer,
+   bool late_materialize,
+   size_t key_size,
+   size_t row_size,
    size_t thread_id,
    TupleMaterializerState& mat,
    AtomicHashTableState<SimpleKeyComparator>& ht_state) {
@@ -52,15 +66,21 @@ void materializedTupleToHashTable(
          // engine would. For large hash tables this increases throughput significantly.
          const char* curr_tuple = reinterpret_cast<const char*>(chunk->data.get());
          while (curr_tuple < chunk->end_ptr) {
-            size_t curr_batch_size = std::min(batch_size, (chunk->end_ptr - curr_tuple) / slot_size);
-            const char* curr_tuple_hash_it = curr_tuple;
+            size_t curr_batch_size = std::min(batch_size, (chunk->end_ptr - curr_tuple) / row_size);
+            ht_state.hash_table->compute_hash_and_prefetch_batch(curr_tuple, row_size, /* indirect = */ false, curr_batch_size, hashes.data());
             for (size_t batch_idx = 0; batch_idx < curr_batch_size; ++batch_idx) {
-               hashes[batch_idx] = ht_state.hash_table->compute_hash_and_prefetch(curr_tuple_hash_it);
-               curr_tuple_hash_it += slot_size;
-            }
-            for (size_t batch_idx = 0; batch_idx < curr_batch_size; ++batch_idx) {
-               ht_state.hash_table->insert<false>(curr_tuple, hashes[batch_idx]);
-               curr_tuple += slot_size;
+               if (late_materialize) {
+                  // Only copy the key, the slot references the row within the materializer. The materializer
+                  // chunks stay alive until the query finishes.
+                  char* slot = outer ? ht_state.hash_table->insertOuter<true>(curr_tuple, hashes[batch_idx]) : ht_state.hash_table->insert<true>(curr_tuple, hashes[batch_idx]);
+                  std::memcpy(slot + key_size, &curr_tuple, sizeof(curr_tuple));
+               } else if (outer) {
+                  // Outer joins need the marking bit in the slot tags.
+                  ht_state.hash_table->insertOuter<false>(curr_tuple, hashes[batch_idx]);
+               } else {
+                  ht_state.hash_table->insert<false>(curr_tuple, hashes[batch_idx]);
+               }
+               curr_tuple += row_size;
             }
             // Move to the next tuple.
          }
@@ -69,10 +89,11 @@ void materializedTupleToHashTable(
 }
 }
 
-Join::Join(std::vector<std::unique_ptr<RelAlgOp>> children_, std::string op_name_, std::vector<const IU*> keys_left_, std::vector<const IU*> payload_left_, std::vector<const IU*> keys_right_, std::vector<const IU*> payload_right_, JoinType type_, bool is_pk_join_)
+Join::Join(std::vector<std::unique_ptr<RelAlgOp>> children_, std::string op_name_, std::vector<const IU*> keys_left_, std::vector<const IU*> payload_left_, std::vector<const IU*> keys_right_, std::vector<const IU*> payload_right_, JoinType type_, bool is_pk_join_, bool late_materialize_)
    : RelAlgOp(std::move(children_), std::move(op_name_)),
      type(type_),
      is_pk_join(is_pk_join_),
+     late_materialize(late_materialize_),
      keys_left(std::move(keys_left_)),
      payload_left(std::move(payload_left_)),
      keys_right(std::move(keys_right_)),
@@ -80,66 +101,153 @@ Join::Join(std::vector<std::unique_ptr<RelAlgOp>> children_, std::string op_name
    if (children.size() != 2) {
       throw std::runtime_error("Join needs to have two children");
    }
-   full_row_left.reserve(keys_left.size() + payload_left.size());
-   for (const IU* left_key : keys_left) {
-      full_row_left.push_back(left_key);
-   }
-   for (const IU* left_payload : payload_left) {
-      full_row_left.push_back(left_payload);
-   }
    plan();
 }
 
-std::unique_ptr<Join> Join::build(std::vector<std::unique_ptr<RelAlgOp>> children_, std::string op_name_, std::vector<const IU*> keys_left_, std::vector<const IU*> payload_left_, std::vector<const IU*> keys_right_, std::vector<const IU*> payload_right_, JoinType type_, bool is_pk_join_) {
-   return std::make_unique<Join>(std::move(children_), std::move(op_name_), std::move(keys_left_), std::move(payload_left_), std::move(keys_right_), std::move(payload_right_), type_, is_pk_join_);
+std::unique_ptr<Join> Join::build(std::vector<std::unique_ptr<RelAlgOp>> children_, std::string op_name_, std::vector<const IU*> keys_left_, std::vector<const IU*> payload_left_, std::vector<const IU*> keys_right_, std::vector<const IU*> payload_right_, JoinType type_, bool is_pk_join_, bool late_materialize_) {
+   return std::make_unique<Join>(std::move(children_), std::move(op_name_), std::move(keys_left_), std::move(payload_left_), std::move(keys_right_), std::move(payload_right_), type_, is_pk_join_, late_materialize_);
 }
 
 void Join::plan() {
-   // We need to pack the entire left side into a dense row layout.
-   // We then insert that into the TupleMaterializer. So both key and
-   // payload columns get a pseudo IU.
+   if (type == JoinType::LeftSemi) {
+      // A left semi join should not have any payload on the probe side.
+      assert(payload_right.empty());
+   }
+   assert(keys_left.size() == keys_right.size());
+
+   // Set up the output IUs.
+   std::vector<IU*> left_outs;
+   std::vector<IU*> right_outs;
    for (const IU* key : keys_left) {
       auto& iu = keys_left_out.emplace_back(key->type);
       output_ius.push_back(&iu);
-      key_size_left += iu.type->numBytes();
+      left_outs.push_back(&iu);
    }
    for (const IU* payload : payload_left) {
       auto& iu = payload_left_out.emplace_back(payload->type);
       output_ius.push_back(&iu);
-      payload_size_left += iu.type->numBytes();
-   }
-
-   if (type == JoinType::LeftSemi) {
-      // A left semi join should not have any payload on the probe side.
-      assert(payload_right.empty());
+      left_outs.push_back(&iu);
    }
-
-   // Set up the right side output IUs.
    for (const IU* key : keys_right) {
+      IU* out = nullptr;
       if (type != JoinType::LeftSemi) {
-         auto& iu = keys_right_out.emplace_back(key->type);
-         output_ius.push_back(&iu);
+         out = &keys_right_out.emplace_back(key->type);
+         output_ius.push_back(out);
       }
-      right_pseudo_ius.emplace_back(IR::Void::build());
-      key_size_right += key->type->numBytes();
+      right_outs.push_back(out);
    }
    for (const IU* payload : payload_right) {
       auto& iu = payload_right_out.emplace_back(payload->type);
-      // We need pseudo IUs for the payload of the probe side. The return IU of the probe
-      // gets used for re-unpacking the joined row later. When we touch that return IU we
-      // need to make sure the entire key is present already.
-      right_pseudo_ius.emplace_back(IR::Void::build());
       output_ius.push_back(&iu);
-      payload_size_right += iu.type->numBytes();
+      right_outs.push_back(&iu);
    }
 
+   // We need to pack both sides into a dense row layout:
+   // [keys | key NULL bytes | payload | payload NULL indicators | probe marker]
+   // The build side gets inserted into the TupleMaterializer, the probe side is packed
+   // into a scratch pad IU. Key and payload columns get a pseudo IU on the probe side.
+   // 1. Keys.
+   for (size_t k = 0; k < keys_left.size(); ++k) {
+      packed_left.push_back({keys_left[k], left_outs[k]});
+      packed_right.push_back({keys_right[k], right_outs[k]});
+   }
+   // 2. Key NULL bytes. Keys without NULLs don't pay anything.
+   for (size_t k = 0; k < keys_left.size(); ++k) {
+      if (!keys_left[k]->null_indicator && !keys_right[k]->null_indicator) {
+         continue;
+      }
+      auto& null_byte = key_null_bytes.emplace_back(KeyNullByte{
+         .key_idx = k,
+         .left_byte = IU(IR::UnsignedInt::build(1)),
+         .right_indicator_byte = IU(IR::UnsignedInt::build(1)),
+         .right_byte = IU(IR::UnsignedInt::build(1)),
+      });
+      const IU* left_indicator = nullptr;
+      if (keys_left[k]->null_indicator) {
+         // NULL build keys only make it into the output for outer join rows without a partner.
+         left_indicator = &indicators_out.emplace_back(IR::Bool::build());
+         left_outs[k]->null_indicator = left_indicator;
+      }
+      packed_left.push_back({&null_byte.left_byte, left_indicator});
+      packed_right.push_back({&null_byte.right_byte, nullptr});
+   }
+   for (const auto& col : packed_left) {
+      key_size_left += col.in->type->numBytes();
+   }
+   for (const auto& col : packed_right) {
+      key_size_right += col.in->type->numBytes();
+   }
    assert(key_size_left == key_size_right);
 
+   // 3. Payload and the NULL indicators of nullable payload columns.
+   auto pack_payload = [&](std::vector<PackedColumn>& packed, const std::vector<const IU*>& payload, IU** outs) {
+      for (size_t k = 0; k < payload.size(); ++k) {
+         packed.push_back({payload[k], outs[k]});
+      }
+      for (size_t k = 0; k < payload.size(); ++k) {
+         if (payload[k]->null_indicator) {
+            auto& indicator = indicators_out.emplace_back(IR::Bool::build());
+            outs[k]->null_indicator = &indicator;
+            packed.push_back({payload[k]->null_indicator, &indicator, /* set_in_null_row = */ true});
+         }
+      }
+   };
+   pack_payload(packed_left, payload_left, left_outs.data() + keys_left.size());
+   pack_payload(packed_right, payload_right, right_outs.data() + keys_right.size());
+
+   // 4. Outer joins mark rows without join partner. The marker is the NULL indicator
+   // of all probe side columns that don't have their own.
+   if (type == JoinType::LeftOuter) {
+      probe_marker.emplace(IR::UnsignedInt::build(1));
+      probe_marker_out.emplace(IR::Bool::build());
+      packed_right.push_back({&*probe_marker, &*probe_marker_out, /* set_in_null_row = */ true});
+      for (IU* out : right_outs) {
+         if (!out->null_indicator) {
+            out->null_indicator = &*probe_marker_out;
+         }
+      }
+   }
+
+   for (size_t k = 0; k < packed_left.size(); ++k) {
+      full_row_left.push_back(packed_left[k].in);
+      if (k >= keys_left.size() + key_null_bytes.size()) {
+         payload_size_left += packed_left[k].in->type->numBytes();
+      }
+   }
+   // Late materialization only pays off if the row reference is smaller than the payload it replaces.
+   late_materialize = late_materialize && payload_size_left > sizeof(char*);
+   slot_size_left = key_size_left + (late_materialize ? sizeof(char*) : payload_size_left);
+   for (size_t k = 0; k < packed_right.size(); ++k) {
+      right_pseudo_ius.emplace_back(IR::Void::build());
+      if (k >= keys_right.size() + key_null_bytes.size()) {
+         payload_size_right += packed_right[k].in->type->numBytes();
+      }
+   }
+
+   if (type == JoinType::LeftOuter) {
+      // Set up the probe row produced for build rows without join partner.
+      static const char* empty_string = "";
+      null_row.resize(key_size_right + payload_size_right, 0);
+      size_t offset = 0;
+      for (const auto& col : packed_right) {
+         if (col.set_in_null_row) {
+            null_row[offset] = 1;
+         } else if (dynamic_cast<IR::String*>(col.in->type.get())) {
+            // Strings need to stay valid pointers for downstream string functions.
+            std::memcpy(&null_row[offset], &empty_string, sizeof(empty_string));
+         }
+         offset += col.in->type->numBytes();
+      }
+   }
+
    scratch_pad_left.emplace(IR::ByteArray::build(key_size_left + payload_size_right));
    scratch_pad_right.emplace(IR::ByteArray::build(key_size_right + payload_size_right));
    filtered_build.emplace(IR::Pointer::build(IR::Char::build()));
    // The filtered probe column consists of Char* into the contiguous ByteArray column `filtered_build`.
    filtered_probe.emplace(IR::Pointer::build(IR::Char::build()));
+   if (late_materialize) {
+      build_row.emplace(IR::Pointer::build(IR::Char::build()));
+   }
    lookup_left.emplace(IR::Pointer::build(IR::Char::build()));
    lookup_right.emplace(IR::Pointer::build(IR::Char::build()));
    filter_pseudo_iu.emplace(IR::Void::build());
@@ -150,6 +258,32 @@ void Join::plan() {
    prefetch_pseudo.emplace(IR::Void::build());
 }
 
+void Join::attachKeyNullBytes(Pipeline& pipe, bool build_side) const {
+   using Type = ExpressionOp::ComputeNode::Type;
+   for (const auto& null_byte : key_null_bytes) {
+      if (build_side) {
+         const IU* key = keys_left[null_byte.key_idx];
+         if (key->null_indicator) {
+            pipe.attachSuboperator(ExpressionSubop::build(this, {&null_byte.left_byte}, {key->null_indicator}, Type::Cast));
+         } else {
+            attachConstantByte(this, pipe, *key, null_byte.left_byte, 0);
+         }
+      } else {
+         const IU* key = keys_right[null_byte.key_idx];
+         if (key->null_indicator) {
+            // NULL probe keys pack a two, they can never match a build key byte.
+            pipe.attachSuboperator(ExpressionSubop::build(this, {&null_byte.right_indicator_byte}, {key->null_indicator}, Type::Cast));
+            auto& multiply = pipe.attachSuboperator(RuntimeExpressionSubop::build(this, {&null_byte.right_byte}, {&null_byte.right_indicator_byte}, Type::Multiply, IR::UnsignedInt::build(1)));
+            RuntimeExpressionParams params;
+            params.dataSet(IR::UI<1>::build(2));
+            reinterpret_cast<RuntimeExpressionSubop&>(multiply).attachRuntimeParams(std::move(params));
+         } else {
+            attachConstantByte(this, pipe, *key, null_byte.right_byte, 0);
+         }
+      }
+   }
+}
+
 void Join::decay(inkfuse::PipelineDAG& dag) const {
    if (is_pk_join) {
       decayPkJoin(dag);
@@ -172,7 +306,8 @@ void Join::decayPkJoin(inkfuse::PipelineDAG& dag) const {
    // 1. Pack both the probe key and the probe payload into a scratch pad IU
    // 2. Lookup the scratch pad IU
    // 3. Filter the rows whether the lookup returned a non-null pointer
-   // 4. Unpack all the rows again into individual IUs
+   // 4. Unpack all the rows again into individual IUs. With late materialization the build
+   //    side payload is unpacked from the materialized row referenced by the slot.
 
    auto& mat_state = dag.attachTupleMaterializers(0, key_size_left + payload_size_left);
    auto& ht_state = dag.attachAtomicHashTable<SimpleKeyComparator>(0, mat_state);
@@ -182,6 +317,7 @@ void Join::decayPkJoin(inkfuse::PipelineDAG& dag) const {
       // 1.0: Decay build pipeline.
       children[0]->decay(dag);
       auto& build_pipe = dag.getCurrentPipeline();
+      attachKeyNullBytes(build_pipe, /* build_side = */ true);
 
       // 1.1 Materialize state. Maybe somewhat surprisingly we don't do an insert here at all.
       // Rather we follow the Hyper paper and have the following protocol:
@@ -212,11 +348,14 @@ void Join::decayPkJoin(inkfuse::PipelineDAG& dag) const {
          .after_pipe = dag.getPipelines().size() - 1,
          .prepare_function = [&](ExecutionContext&, size_t total_threads) { allocHashTable(
                                                                                key_size_left,
-                                                                               key_size_left + payload_size_left,
+                                                                               slot_size_left,
                                                                                total_threads,
                                                                                mat_state,
                                                                                ht_state); },
          .worker_function = [&](ExecutionContext&, size_t thread_id) { materializedTupleToHashTable(
+                                                                          type == JoinType::LeftOuter,
+                                                                          late_materialize,
+                                                                          key_size_left,
                                                                           key_size_left + payload_size_left,
                                                                           thread_id,
                                                                           mat_state,
@@ -228,31 +367,24 @@ void Join::decayPkJoin(inkfuse::PipelineDAG& dag) const {
       // 2.0 : Decay probe pipeline.
       children[1]->decay(dag);
       auto& probe_pipe = dag.getCurrentPipeline();
+      attachKeyNullBytes(probe_pipe, /* build_side = */ false);
+      if (probe_marker) {
+         // Rows with a join partner are never NULL.
+         attachConstantByte(this, probe_pipe, *keys_right[0], *probe_marker, 0);
+      }
 
       // 2.1 Pack the probe key and the probe payload.
       probe_pipe.attachSuboperator(ScratchPadIUProvider::build(this, *scratch_pad_right));
       size_t probe_offset = 0;
       auto probe_pseudo = right_pseudo_ius.begin();
-      // Pack keys.
-      for (const IU* key_right : keys_right) {
-         auto& packer = probe_pipe.attachSuboperator(KeyPackerSubop::build(this, *key_right, *scratch_pad_right, {&(*probe_pseudo)}));
+      for (const auto& col : packed_right) {
+         auto& packer = probe_pipe.attachSuboperator(KeyPackerSubop::build(this, *col.in, *scratch_pad_right, {&(*probe_pseudo)}));
          // Attach the runtime parameter that represents the state offset.
          KeyPackingRuntimeParams param;
          param.offsetSet(IR::UI<2>::build(probe_offset));
          reinterpret_cast<KeyPackerSubop&>(packer).attachRuntimeParams(std::move(param));
          // Update the key offset by the size of the IU.
-         probe_offset += key_right->type->numBytes();
-         probe_pseudo++;
-      }
-      // Pack payload.
-      for (const IU* payload_r : payload_right) {
-         auto& packer = probe_pipe.attachSuboperator(KeyPackerSubop::build(this, *payload_r, *scratch_pad_right, {&(*probe_pseudo)}));
-         // Attach the runtime parameter that represents the state offset.
-         KeyPackingRuntimeParams param;
-         param.offsetSet(IR::UI<2>::build(probe_offset));
-         reinterpret_cast<KeyPackerSubop&>(packer).attachRuntimeParams(std::move(param));
-         // Update the key offset by the size of the IU.
-         probe_offset += payload_r->type->numBytes();
+         probe_offset += col.in->type->numBytes();
          probe_pseudo++;
       }
 
@@ -270,7 +402,10 @@ void Join::decayPkJoin(inkfuse::PipelineDAG& dag) const {
          probe_pipe.attachSuboperator(RuntimeFunctionSubop::htHashAndPrefetch<AtomicHashTable<SimpleKeyComparator>>(this, *hash_right, *scratch_pad_right, std::move(pseudo), key_size_left, &ht_state));
 
          // 2.2.2 Perfom the lookup.
-         if (type == JoinType::LeftSemi) {
+         if (type == JoinType::LeftOuter) {
+            // Lookup marks the slot, the unmarked slots are produced by the continuation.
+            probe_pipe.attachSuboperator(RuntimeFunctionSubop::htLookupWithHash<AtomicHashTable<SimpleKeyComparator>, false, true>(this, *lookup_right, *scratch_pad_right, *hash_right, /* prefetch_pseudo = */ nullptr, &ht_state));
+         } else if (type == JoinType::LeftSemi) {
             // Lookup on a slot disables the slot, giving semi-join behaviour.
             probe_pipe.attachSuboperator(RuntimeFunctionSubop::htLookupWithHash<AtomicHashTable<SimpleKeyComparator>, true>(this, *lookup_right, *scratch_pad_right, *hash_right, /* prefetch_pseudo = */ nullptr, &ht_state));
          } else {
@@ -284,7 +419,7 @@ void Join::decayPkJoin(inkfuse::PipelineDAG& dag) const {
          // We will have to replicate all suboperators after this one down the line and attach
          // a new HashTableSouce.
          Pipeline& continuation = dag.attachContinuation();
-         continuation.attachSuboperator(AtomicHashTableSource::buildForOuterJoin(this, *lookup_right, *scratch_pad_right, &ht_state));
+         continuation.attachSuboperator(AtomicHashTableSource::buildForOuterJoin(this, *lookup_right, *scratch_pad_right, null_row.data(), &ht_state));
       }
 
       // 2.3 Filter on probe matches.
@@ -302,39 +437,35 @@ void Join::decayPkJoin(inkfuse::PipelineDAG& dag) const {
       }
 
       // 2.4 Unpack everything.
+      // Keys are always unpacked from `row`, the payload from `payload_row`.
+      auto unpack = [&](const std::vector<PackedColumn>& packed, const IU& row, const IU& payload_row) {
+         size_t unpack_offset = 0;
+         for (size_t k = 0; k < packed.size(); ++k) {
+            const auto& col = packed[k];
+            if (col.out) {
+               const IU& source = k < keys_left.size() + key_null_bytes.size() ? row : payload_row;
+               auto& unpacker = probe_pipe.attachSuboperator(KeyUnpackerSubop::build(this, source, *col.out));
+               KeyPackingRuntimeParams param;
+               param.offsetSet(IR::UI<2>::build(unpack_offset));
+               reinterpret_cast<KeyUnpackerSubop&>(unpacker).attachRuntimeParams(std::move(param));
+            }
+            unpack_offset += col.in->type->numBytes();
+         }
+      };
       // 2.4.1 Unpack Build Side IUs
-      size_t build_unpack_offset = 0;
-      for (const auto& iu : keys_left_out) {
-         auto& unpacker = probe_pipe.attachSuboperator(KeyUnpackerSubop::build(this, *filtered_build, iu));
-         KeyPackingRuntimeParams param;
-         param.offsetSet(IR::UI<2>::build(build_unpack_offset));
-         reinterpret_cast<KeyUnpackerSubop&>(unpacker).attachRuntimeParams(std::move(param));
-         build_unpack_offset += iu.type->numBytes();
-      }
-      for (const auto& iu : payload_left_out) {
-         auto& unpacker = probe_pipe.attachSuboperator(KeyUnpackerSubop::build(this, *filtered_build, iu));
+      if (late_materialize) {
+         // Resolve the build row behind the key. The materialized row has the same layout as a regular slot.
+         auto& unpacker = probe_pipe.attachSuboperator(KeyUnpackerSubop::build(this, *filtered_build, *build_row));
          KeyPackingRuntimeParams param;
-         param.offsetSet(IR::UI<2>::build(build_unpack_offset));
+         param.offsetSet(IR::UI<2>::build(key_size_left));
          reinterpret_cast<KeyUnpackerSubop&>(unpacker).attachRuntimeParams(std::move(param));
-         build_unpack_offset += iu.type->numBytes();
+         unpack(packed_left, *filtered_build, *build_row);
+      } else {
+         unpack(packed_left, *filtered_build, *filtered_build);
       }
-      // 2.4.1 Unpack Probe Side IUs. Not needed for semi joins.
+      // 2.4.2 Unpack Probe Side IUs. Not needed for semi joins.
       if (type != JoinType::LeftSemi) {
-         size_t probe_unpack_offset = 0;
-         for (const auto& iu : keys_right_out) {
-            auto& unpacker = probe_pipe.attachSuboperator(KeyUnpackerSubop::build(this, *filtered_probe, iu));
-            KeyPackingRuntimeParams param;
-            param.offsetSet(IR::UI<2>::build(probe_unpack_offset));
-            reinterpret_cast<KeyUnpackerSubop&>(unpacker).attachRuntimeParams(std::move(param));
-            probe_unpack_offset += iu.type->numBytes();
-         }
-         for (const auto& iu : payload_right_out) {
-            auto& unpacker = probe_pipe.attachSuboperator(KeyUnpackerSubop::build(this, *filtered_probe, iu));
-            KeyPackingRuntimeParams param;
-            param.offsetSet(IR::UI<2>::build(probe_unpack_offset));
-            reinterpret_cast<KeyUnpackerSubop&>(unpacker).attachRuntimeParams(std::move(param));
-            probe_unpack_offset += iu.type->numBytes();
-         }
+         unpack(packed_right, *filtered_probe, *filtered_probe);
       }
    }
 }
@@ -1,6 +1,7 @@
 #ifndef INKFUSE_JOIN_H
 #define INKFUSE_JOIN_H
 
+#include "algebra/Pipeline.h"
 #include "algebra/RelAlgOp.h"
 #include <list>
 #include <optional>
@@ -20,6 +21,11 @@ enum class JoinType {
 /// This means that we can create an optimzied suboperator layout for this type of join.
 /// For non-PK joins we need to pack a much more complex join state and take care of potentially
 /// growing chunks.
+///
+/// By default the hash table slots contain the full build row. With late materialization the slots only
+/// contain the key and a pointer to the build row within the TupleMaterializer. The build side payload
+/// is then only fetched for rows which need it after probing. This keeps the hash table small for wide
+/// build sides, at the cost of an additional indirection per produced payload column.
 struct Join : public RelAlgOp {
 
    static std::unique_ptr<Join> build(
@@ -30,7 +36,8 @@ struct Join : public RelAlgOp {
       std::vector<const IU*> keys_right_,
       std::vector<const IU*> payload_right_,
       JoinType type_,
-      bool is_pk_join_);
+      bool is_pk_join_,
+      bool late_materialize_ = false);
 
    Join(
       std::vector<std::unique_ptr<RelAlgOp>> children_,
@@ -40,23 +47,55 @@ struct Join : public RelAlgOp {
       std::vector<const IU*> keys_right_,
       std::vector<const IU*> payload_right_,
       JoinType type_,
-      bool is_pk_join_);
+      bool is_pk_join_,
+      bool late_materialize_ = false);
 
    void decay(PipelineDAG& dag) const override;
 
    private:
+   /// A column within the packed row of one join side.
+   struct PackedColumn {
+      /// The IU which gets packed.
+      const IU* in;
+      /// The IU which gets unpacked after the join. nullptr if the column is not unpacked.
+      const IU* out;
+      /// Is this a NULL indicator that has to be set within the `null_row`?
+      bool set_in_null_row = false;
+   };
+
+   /// A key where at least one side is nullable. Both sides pack an additional key byte:
+   /// the build side packs one for NULL keys, the probe side packs two. This way NULL
+   /// keys never find a join partner, and rows without NULLs compare equal as before.
+   struct KeyNullByte {
+      /// Index of the key.
+      size_t key_idx;
+      /// Key byte on the build side.
+      IU left_byte;
+      /// NULL indicator on the probe side cast to a byte.
+      IU right_indicator_byte;
+      /// Key byte on the probe side.
+      IU right_byte;
+   };
+
    void plan();
    void decayPkJoin(PipelineDAG& dag) const;
+   /// Attach the expressions computing the key NULL bytes of the given side.
+   void attachKeyNullBytes(Pipeline& pipe, bool build_side) const;
 
    /// What join type is this?
    JoinType type;
    /// Is the left (build) side of the hash join a PK?
    bool is_pk_join;
+   /// Do the hash table slots only reference the materialized build rows?
+   /// Only enabled if the build side payload is wider than the row reference.
+   bool late_materialize;
 
    size_t key_size_left = 0;
    size_t payload_size_left = 0;
    size_t key_size_right = 0;
    size_t payload_size_right = 0;
+   /// Size of a hash table slot.
+   size_t slot_size_left = 0;
 
    /// Packed scratch pad IU left.
    std::optional<IU> scratch_pad_left;
@@ -83,12 +122,26 @@ struct Join : public RelAlgOp {
    std::optional<IU> filtered_build;
    /// Filtered probe side in the probe phase. Byte[] typed.
    std::optional<IU> filtered_probe;
+   /// Materialized build row referenced by the hash table slot for late materialization. Char* typed.
+   std::optional<IU> build_row;
 
    /// The left input IUs.
    std::vector<const IU*> keys_left;
    std::vector<const IU*> payload_left;
    /// The left key/payload input IUs together.
    std::vector<const IU*> full_row_left;
+   /// Packed row layouts of both sides. The first columns make up the key.
+   std::vector<PackedColumn> packed_left;
+   std::vector<PackedColumn> packed_right;
+   /// NULL bytes of nullable keys.
+   std::list<KeyNullByte> key_null_bytes;
+   /// Constant zero byte packed into the probe row of outer joins. It is one within the `null_row`.
+   std::optional<IU> probe_marker;
+   /// The unpacked probe marker, NULL indicator of probe side columns for outer joins.
+   std::optional<IU> probe_marker_out;
+   /// The probe row that gets produced for build rows without join partner in outer joins.
+   /// NULL indicators are set, strings point to an empty string.
+   std::vector<char> null_row;
    /// The right input IUs.
    std::vector<const IU*> keys_right;
    std::vector<const IU*> payload_right;
@@ -98,6 +151,8 @@ struct Join : public RelAlgOp {
    std::list<IU> payload_left_out;
    std::list<IU> keys_right_out;
    std::list<IU> payload_right_out;
+   /// The output NULL indicators.
+   std::list<IU> indicators_out;
 };
 
 }
@@ -230,13 +230,13 @@ const std::vector<SuboperatorArc>& Pipeline::getSubops() const {
    return suboperators;
 }
 
-void Pipeline::setPrettyPrinter(PrettyPrinter& printer_) {
-   assert(!printer);
-   printer = &printer_;
+void Pipeline::setResultSink(ResultSink& sink) {
+   assert(!result_sink);
+   result_sink = &sink;
 }
 
-PrettyPrinter* Pipeline::getPrettyPrinter() {
-   return printer;
+ResultSink* Pipeline::getResultSink() {
+   return result_sink;
 }
 
 TupleMaterializerState& PipelineDAG::attachTupleMaterializers(size_t discard_after, size_t tuple_size) {
@@ -246,13 +246,33 @@ TupleMaterializerState& PipelineDAG::attachTupleMaterializers(size_t discard_aft
    return static_cast<TupleMaterializerState&>(*inserted.second);
 }
 
+GroupJoinState& PipelineDAG::attachGroupJoinState(size_t discard_after, AtomicHashTableState<SimpleKeyComparator>& ht_state) {
+   auto& inserted = runtime_state.emplace_back(discard_after, std::make_unique<GroupJoinState>(ht_state));
+   return static_cast<GroupJoinState&>(*inserted.second);
+}
+
+SortState& PipelineDAG::attachSortState(size_t discard_after, TupleMaterializerState& materialize_, std::vector<SortKey> keys) {
+   auto& inserted = runtime_state.emplace_back(discard_after, std::make_unique<SortState>(materialize_, std::move(keys)));
+   return static_cast<SortState&>(*inserted.second);
+}
+
+TopKState& PipelineDAG::attachTopKState(size_t discard_after, std::vector<SortKey> keys, size_t row_size, size_t k) {
+   auto& inserted = runtime_state.emplace_back(discard_after, std::make_unique<TopKState>(std::move(keys), row_size, k));
+   return static_cast<TopKState&>(*inserted.second);
+}
+
+WindowState& PipelineDAG::attachWindowState(size_t discard_after, TupleMaterializerState& materialize_, std::vector<SortKey> partition_keys, std::vector<SortKey> order_keys, std::vector<WindowFunction> functions) {
+   auto& inserted = runtime_state.emplace_back(discard_after, std::make_unique<WindowState>(materialize_, std::move(partition_keys), std::move(order_keys), std::move(functions)));
+   return static_cast<WindowState&>(*inserted.second);
+}
+
 HashTableSimpleKeyState& PipelineDAG::attachHashTableSimpleKey(size_t discard_after, size_t key_size, size_t payload_size) {
    auto& inserted = runtime_state.emplace_back(discard_after, std::make_unique<HashTableSimpleKeyState>(key_size, payload_size));
    return static_cast<HashTableSimpleKeyState&>(*inserted.second);
 }
 
-HashTableComplexKeyState& PipelineDAG::attachHashTableComplexKey(size_t discard_after, uint16_t slots, size_t payload_size) {
-   auto& inserted = runtime_state.emplace_back(discard_after, std::make_unique<HashTableComplexKeyState>(slots, payload_size));
+HashTableComplexKeyState& PipelineDAG::attachHashTableComplexKey(size_t discard_after, uint16_t slots, uint16_t simple_key_size, size_t payload_size) {
+   auto& inserted = runtime_state.emplace_back(discard_after, std::make_unique<HashTableComplexKeyState>(slots, simple_key_size, payload_size));
    return static_cast<HashTableComplexKeyState&>(*inserted.second);
 }
 
@@ -261,6 +281,11 @@ HashTableDirectLookupState& PipelineDAG::attachHashTableDirectLookup(size_t disc
    return static_cast<HashTableDirectLookupState&>(*inserted.second);
 }
 
+HashTableDirectLookupState& PipelineDAG::attachHashTableDirectLookup(size_t discard_after, std::vector<HashTableDirectLookup::KeyColumn> key_columns, size_t key_size, size_t payload_size) {
+   auto& inserted = runtime_state.emplace_back(discard_after, std::make_unique<HashTableDirectLookupState>(std::move(key_columns), key_size, payload_size));
+   return static_cast<HashTableDirectLookupState&>(*inserted.second);
+}
+
 Pipeline& PipelineDAG::getCurrentPipeline() const {
    assert(!pipelines.empty());
    return *pipelines.back();
@@ -300,6 +325,11 @@ Pipeline& PipelineDAG::attachContinuation() {
 }
 
 void PipelineDAG::addRuntimeTask(PipelineDAG::RuntimeTask task) {
+   if (!continuations.empty() && task.after_pipe == pipelines.size() - 1) {
+      // Continuations get inserted right behind the current pipeline and still feed the
+      // same sinks. Tasks consuming the pipeline result may only run once they are done.
+      task.after_pipe += continuations.size();
+   }
    runtime_tasks.push_back(std::move(task));
 }
 
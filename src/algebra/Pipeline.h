@@ -13,7 +13,17 @@
 
 namespace inkfuse {
 
-struct PrettyPrinter;
+struct ExecutionContext;
+
+/// Consumer of the rows a pipeline produces, e.g. the PrettyPrinter behind a Print operator.
+struct ResultSink {
+   virtual ~ResultSink() = default;
+
+   /// Tell the sink that a morsel is materialized in the FuseChunk of a specific
+   /// thread and can be consumed. Called concurrently by all worker threads.
+   /// @return true if the output is closed.
+   virtual bool markMorselDone(ExecutionContext& ctx, size_t thread_id) = 0;
+};
 
 /// Pipelines are DAG structured through IU dependencies. The PipelineGraph explicitly
 /// models the edges induced by IU dependencies between sub-operators.
@@ -81,8 +91,8 @@ struct Pipeline {
    /// Get the sub-operators in this pipeline.
    const std::vector<SuboperatorArc>& getSubops() const;
 
-   void setPrettyPrinter(PrettyPrinter& printer);
-   PrettyPrinter* getPrettyPrinter();
+   void setResultSink(ResultSink& sink);
+   ResultSink* getResultSink();
 
    void disallowParallelCodegen() { parallel_codegen = false; };
    bool supportsParallelCodegen() const { return parallel_codegen; };
@@ -105,8 +115,8 @@ struct Pipeline {
    /// case this is not possible is if the pipeline has or is a continuation.
    bool parallel_codegen = true;
 
-   /// An optional PrettyPrinter that can be used to render the pipeline results.
-   PrettyPrinter* printer;
+   /// An optional ResultSink that consumes the pipeline results.
+   ResultSink* result_sink = nullptr;
 };
 
 using PipelinePtr = std::unique_ptr<Pipeline>;
@@ -147,12 +157,21 @@ struct PipelineDAG {
       return static_cast<AtomicHashTableState<Comparator>&>(*inserted.second);
    };
 
+   /// Attach the thread-local partial aggregate states of a group join over the given hash table.
+   GroupJoinState& attachGroupJoinState(size_t discard_after, AtomicHashTableState<SimpleKeyComparator>& ht_state);
+   /// Attach the state of a sort over the rows within the given tuple materializers.
+   SortState& attachSortState(size_t discard_after, TupleMaterializerState& materialize_, std::vector<SortKey> keys);
+   /// Attach the state of a Top-K keeping the first k rows.
+   TopKState& attachTopKState(size_t discard_after, std::vector<SortKey> keys, size_t row_size, size_t k);
+   /// Attach the state of a window operator over the rows within the given tuple materializers.
+   WindowState& attachWindowState(size_t discard_after, TupleMaterializerState& materialize_, std::vector<SortKey> partition_keys, std::vector<SortKey> order_keys, std::vector<WindowFunction> functions);
    /// Attach a simple hash table to the runtime state of the PipelineDAG.
    HashTableSimpleKeyState& attachHashTableSimpleKey(size_t discard_after, size_t key_size, size_t payload_size);
-   /// Attach a complex hash table to the runtime state of the PipelineDAG.
-   HashTableComplexKeyState& attachHashTableComplexKey(size_t discard_after, uint16_t slots, size_t payload_size);
+   /// Attach a complex hash table to the runtime state of the PipelineDAG. The simple key is packed behind the complex key slots.
+   HashTableComplexKeyState& attachHashTableComplexKey(size_t discard_after, uint16_t slots, uint16_t simple_key_size, size_t payload_size);
    /// Attach a direct lookup hash table to the runtime state of the PipelineDAG.
    HashTableDirectLookupState& attachHashTableDirectLookup(size_t discard_after, size_t payload_size);
+   HashTableDirectLookupState& attachHashTableDirectLookup(size_t discard_after, std::vector<HashTableDirectLookup::KeyColumn> key_columns, size_t key_size, size_t payload_size);
 
    private:
    /// Internally the PipelineDAG is represented as a vector of pipelines within a topological order.
@@ -2,6 +2,7 @@
 #include "algebra/Pipeline.h"
 #include "algebra/suboperators/sinks/FuseChunkSink.h"
 #include "exec/ExecutionContext.h"
+#include <unordered_set>
 
 namespace inkfuse {
 
@@ -43,11 +44,14 @@ bool PrettyPrinter::markMorselDone(inkfuse::ExecutionContext& ctx, size_t thread
 
    // Get the raw pointers to the data.
    std::vector<char*> data;
+   std::vector<char*> null_data;
    data.reserve(ius.size());
+   null_data.reserve(ius.size());
    for (const IU* iu: ius) {
       auto& col = ctx.getColumn(*iu, thread_id);
       assert(col.size == chunk_size);
       data.push_back(col.raw_data);
+      null_data.push_back(iu->null_indicator ? ctx.getColumn(*iu->null_indicator, thread_id).raw_data : nullptr);
    }
    // Write out the actual chunk.
    for (size_t row = 0; row < write; ++row) {
@@ -56,6 +60,10 @@ bool PrettyPrinter::markMorselDone(inkfuse::ExecutionContext& ctx, size_t thread
             *out << ",";
          }
          const IU& iu = *ius[col];
+         if (null_data[col] && null_data[col][row]) {
+            *out << "NULL";
+            continue;
+         }
          char* ptr = data[col];
          iu.type->print(*out, ptr + row * iu.type->numBytes());
       }
@@ -89,11 +97,18 @@ void Print::decay(inkfuse::PipelineDAG& dag) const
 
    auto& pipe = dag.getCurrentPipeline();
    // Build a FuseChunkSink to materialize each output IU.
+   std::unordered_set<const IU*> sunk;
    for (auto& out: printer->ius) {
-      pipe.attachSuboperator(FuseChunkSink::build(this, *out));
+      if (sunk.insert(out).second) {
+         pipe.attachSuboperator(FuseChunkSink::build(this, *out));
+      }
+      // NULL indicators have to be materialized as well.
+      if (out->null_indicator && sunk.insert(out->null_indicator).second) {
+         pipe.attachSuboperator(FuseChunkSink::build(this, *out->null_indicator));
+      }
    }
    // And attach the pretty-printer to the pipeline DAG.
-   pipe.setPrettyPrinter(*printer);
+   pipe.setResultSink(*printer);
 }
 
 }
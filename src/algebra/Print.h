@@ -1,6 +1,7 @@
 #ifndef INKFUSE_PRINT_H
 #define INKFUSE_PRINT_H
 
+#include "algebra/Pipeline.h"
 #include "algebra/RelAlgOp.h"
 #include <mutex>
 #include <optional>
@@ -8,16 +9,14 @@
 
 namespace inkfuse {
 
-struct ExecutionContext;
-
 /// The pretty printer that gets created by a Print operator.
-struct PrettyPrinter {
+struct PrettyPrinter : public ResultSink {
    PrettyPrinter(std::vector<const IU*> ius, std::vector<std::string> colnames, std::optional<size_t> limit);
 
    /// Tell the pretty printer that a morsel is materialized in the sink of a specific
    /// thread and can be written out.
    /// @return true if the output is closed.
-   bool markMorselDone(ExecutionContext& ctx, size_t thread_id);
+   bool markMorselDone(ExecutionContext& ctx, size_t thread_id) override;
 
    /// Set the output stream for this PrettyPrinter.
    void setOstream(std::ostream& ostream);
@@ -1,4 +1,5 @@
 #include "algebra/RelAlgOp.h"
+#include "storage/Relation.h"
 
 namespace inkfuse {
 
@@ -7,6 +8,16 @@ const std::vector<const IU *> & RelAlgOp::getOutput() const
    return output_ius;
 }
 
+std::optional<ValueRange> RelAlgOp::valueRange(const IU& iu) const
+{
+   for (const auto& child : children) {
+      if (auto range = child->valueRange(iu)) {
+         return range;
+      }
+   }
+   return {};
+}
+
 const std::vector<std::unique_ptr<RelAlgOp>>& RelAlgOp::getChildren() const
 {
    return children;
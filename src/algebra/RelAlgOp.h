@@ -2,12 +2,14 @@
 #define INKFUSE_RELALGOP_H
 
 #include "algebra/IU.h"
+#include <optional>
 #include <vector>
 #include <unordered_set>
 
 namespace inkfuse {
 
 struct PipelineDAG;
+struct ValueRange;
 
 /// Relational algebra operator producing a set of IUs.
 /// As we prepare a relational algebra query for execution, it "decays" into a DAG suitable of suboperators.
@@ -28,6 +30,10 @@ struct RelAlgOp {
    /// Get the operator output.
    const std::vector<const IU*>& getOutput() const;
 
+   /// Get the value range of an IU within the subtree of this operator, if it is known.
+   /// By default IUs are passed through unchanged, so the children are asked.
+   virtual std::optional<ValueRange> valueRange(const IU& iu) const;
+
    /// Get the children of this operator.
    const std::vector<std::unique_ptr<RelAlgOp>>& getChildren() const;
    const std::string& getName() const;
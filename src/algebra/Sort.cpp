@@ -0,0 +1,230 @@
+#include "algebra/Sort.h"
+#include "algebra/Pipeline.h"
+#include "algebra/suboperators/ColumnFilter.h"
+#include "algebra/suboperators/RuntimeFunctionSubop.h"
+#include "algebra/suboperators/TopKThresholdSubop.h"
+#include "algebra/suboperators/row_layout/KeyPackerSubop.h"
+#include "algebra/suboperators/row_layout/KeyUnpackerSubop.h"
+#include "algebra/suboperators/sources/ScratchPadIUProvider.h"
+#include "algebra/suboperators/sources/SortSource.h"
+#include "algebra/suboperators/sources/TableScanSource.h"
+
+namespace inkfuse {
+
+namespace {
+
+/// Can the Top-K threshold filter compare on the given key? Needs a non-nullable number.
+bool supportsThreshold(const IU& key) {
+   const IR::Type& type = *key.type;
+   if (key.null_indicator) {
+      return false;
+   }
+   return dynamic_cast<const IR::SignedInt*>(&type) || dynamic_cast<const IR::UnsignedInt*>(&type) || dynamic_cast<const IR::Float*>(&type) || dynamic_cast<const IR::Date*>(&type);
+}
+
+}
+
+SortKey::Kind sortKind(const IR::Type& type) {
+   if (dynamic_cast<const IR::SignedInt*>(&type) || dynamic_cast<const IR::Date*>(&type)) {
+      return SortKey::Kind::Signed;
+   } else if (dynamic_cast<const IR::UnsignedInt*>(&type) || dynamic_cast<const IR::Bool*>(&type) || dynamic_cast<const IR::Char*>(&type)) {
+      return SortKey::Kind::Unsigned;
+   } else if (dynamic_cast<const IR::Float*>(&type)) {
+      return SortKey::Kind::Float;
+   } else if (dynamic_cast<const IR::String*>(&type)) {
+      return SortKey::Kind::String;
+   }
+   throw std::runtime_error("Sort cannot order on type " + type.id());
+}
+
+std::unique_ptr<Sort> Sort::build(std::vector<std::unique_ptr<RelAlgOp>> children_, std::string op_name_, std::vector<Key> keys_, std::vector<const IU*> payload_, std::optional<size_t> limit_) {
+   return std::unique_ptr<Sort>(new Sort(std::move(children_), std::move(op_name_), std::move(keys_), std::move(payload_), limit_));
+}
+
+Sort::Sort(std::vector<std::unique_ptr<RelAlgOp>> children_, std::string op_name_, std::vector<Key> keys_, std::vector<const IU*> payload_, std::optional<size_t> limit_)
+   : RelAlgOp(std::move(children_), std::move(op_name_)),
+     keys(std::move(keys_)),
+     payload(std::move(payload_)),
+     mat_row(IR::Pointer::build(IR::Char::build())),
+     sorted_row(IR::Pointer::build(IR::Char::build())),
+     limit(limit_) {
+   if (children.size() != 1) {
+      throw std::runtime_error("Sort needs to have exactly one child");
+   }
+   if (keys.empty()) {
+      throw std::runtime_error("Sort needs at least one key");
+   }
+
+   // Row layout: [keys | payload | NULL indicators].
+   std::vector<IU*> outs;
+   auto add_packed = [&](const IU* in) {
+      auto& out = out_ius.emplace_back(in->type);
+      output_ius.push_back(&out);
+      packed.push_back(in);
+      packed_out.push_back(&out);
+      outs.push_back(&out);
+   };
+   for (const auto& key : keys) {
+      add_packed(key.iu);
+   }
+   for (const IU* iu : payload) {
+      add_packed(iu);
+   }
+   std::vector<size_t> offsets;
+   for (const IU* iu : packed) {
+      offsets.push_back(row_size);
+      row_size += iu->type->numBytes();
+   }
+   std::vector<std::optional<uint16_t>> null_offsets(outs.size());
+   for (size_t k = 0; k < outs.size(); ++k) {
+      if (const IU* indicator = packed[k]->null_indicator) {
+         auto& out_indicator = out_indicators.emplace_back(IR::Bool::build());
+         outs[k]->null_indicator = &out_indicator;
+         packed.push_back(indicator);
+         packed_out.push_back(&out_indicator);
+         null_offsets[k] = row_size;
+         row_size += 1;
+      }
+   }
+
+   for (size_t k = 0; k < keys.size(); ++k) {
+      const IR::Type& type = *keys[k].iu->type;
+      sort_keys.push_back(SortKey{
+         .kind = sortKind(type),
+         .width = static_cast<uint16_t>(type.numBytes()),
+         .offset = static_cast<uint16_t>(offsets[k]),
+         .null_offset = null_offsets[k],
+         .ascending = keys[k].ascending,
+      });
+   }
+
+   if (limit) {
+      topk_row.emplace(IR::ByteArray::build(row_size));
+      for (size_t k = 0; k < packed.size(); ++k) {
+         topk_pseudo.emplace_back(IR::Void::build());
+      }
+      if (supportsThreshold(*keys[0].iu)) {
+         threshold_pass.emplace(IR::Bool::build());
+         threshold_pseudo.emplace(IR::Void::build());
+         for (const IU* iu : packed) {
+            threshold_filtered.emplace_back(iu->type);
+         }
+      }
+   }
+}
+
+void Sort::decay(PipelineDAG& dag) const {
+   if (limit) {
+      decayTopK(dag);
+   } else {
+      decaySort(dag);
+   }
+}
+
+void Sort::decaySort(PipelineDAG& dag) const {
+   auto& mat_state = dag.attachTupleMaterializers(0, row_size);
+   auto& sort_state = dag.attachSortState(0, mat_state, sort_keys);
+
+   // Step 1: Materialize all rows.
+   children[0]->decay(dag);
+   auto& mat_pipe = dag.getCurrentPipeline();
+   mat_pipe.attachSuboperator(RuntimeFunctionSubop::materializeTuple(this, mat_row, packed, &mat_state));
+   size_t pack_offset = 0;
+   for (const IU* iu : packed) {
+      auto& packer = mat_pipe.attachSuboperator(KeyPackerSubop::build(this, *iu, mat_row, {}));
+      KeyPackingRuntimeParams param;
+      param.offsetSet(IR::UI<2>::build(pack_offset));
+      reinterpret_cast<KeyPackerSubop&>(packer).attachRuntimeParams(std::move(param));
+      pack_offset += iu->type->numBytes();
+   }
+
+   // Step 2: Runtime tasks sorting the thread-local runs and merging them.
+   const size_t mat_pipe_idx = dag.getPipelines().size() - 1;
+   dag.addRuntimeTask(PipelineDAG::RuntimeTask{
+      .after_pipe = mat_pipe_idx,
+      .prepare_function = [&sort_state](ExecutionContext&, size_t total_threads) {
+         sort_state.sorter.prepareRuns(total_threads);
+      },
+      .worker_function = [&sort_state](ExecutionContext&, size_t thread_id) {
+         sort_state.sorter.sortRun(thread_id, *sort_state.materialize.handles[thread_id]);
+      },
+   });
+   dag.addRuntimeTask(PipelineDAG::RuntimeTask{
+      .after_pipe = mat_pipe_idx,
+      .prepare_function = [&sort_state](ExecutionContext&, size_t total_threads) {
+         sort_state.sorter.prepareMerge(total_threads);
+      },
+      .worker_function = [&sort_state](ExecutionContext&, size_t thread_id) {
+         sort_state.sorter.mergePartition(thread_id);
+      },
+   });
+
+   // Step 3: Read the sorted rows in a new pipeline.
+   decayReader(dag, sort_state.sorter.getSortedRows(), sort_state.sorter.getSortedData());
+}
+
+void Sort::decayTopK(PipelineDAG& dag) const {
+   auto& topk_state = dag.attachTopKState(0, sort_keys, row_size, *limit);
+
+   // Step 1: Insert all rows into the thread-local heaps.
+   children[0]->decay(dag);
+   auto& insert_pipe = dag.getCurrentPipeline();
+   std::vector<const IU*> to_pack = packed;
+   if (threshold_pass) {
+      // Reject rows that cannot make it into the heap before packing them.
+      insert_pipe.attachSuboperator(TopKThresholdSubop::build(this, *keys[0].iu, *threshold_pass, keys[0].ascending, &topk_state));
+      auto& scope_subop = insert_pipe.attachSuboperator(ColumnFilterScope::build(this, *threshold_pass, *threshold_pseudo));
+      auto& scope = reinterpret_cast<ColumnFilterScope&>(scope_subop);
+      auto filtered = threshold_filtered.begin();
+      for (size_t k = 0; k < packed.size(); ++k) {
+         auto logic = ColumnFilterLogic::build(this, *threshold_pseudo, *packed[k], *filtered);
+         scope.attachFilterLogicDependency(*logic, *packed[k]);
+         insert_pipe.attachSuboperator(std::move(logic));
+         to_pack[k] = &(*filtered);
+         filtered++;
+      }
+   }
+   insert_pipe.attachSuboperator(ScratchPadIUProvider::build(this, *topk_row));
+   std::vector<const IU*> pseudo;
+   auto pseudo_iu = topk_pseudo.begin();
+   size_t pack_offset = 0;
+   for (const IU* iu : to_pack) {
+      auto& packer = insert_pipe.attachSuboperator(KeyPackerSubop::build(this, *iu, *topk_row, {&(*pseudo_iu)}));
+      KeyPackingRuntimeParams param;
+      param.offsetSet(IR::UI<2>::build(pack_offset));
+      reinterpret_cast<KeyPackerSubop&>(packer).attachRuntimeParams(std::move(param));
+      pack_offset += iu->type->numBytes();
+      pseudo.push_back(&(*pseudo_iu));
+      pseudo_iu++;
+   }
+   insert_pipe.attachSuboperator(RuntimeFunctionSubop::topKInsert(this, *topk_row, std::move(pseudo), &topk_state));
+
+   // Step 2: Merge the heaps. Every heap holds at most k rows, so this is cheap and done single threaded.
+   dag.addRuntimeTask(PipelineDAG::RuntimeTask{
+      .after_pipe = dag.getPipelines().size() - 1,
+      .prepare_function = [&topk_state](ExecutionContext&, size_t) {
+         topk_state.topk.merge();
+      },
+      .worker_function = [](ExecutionContext&, size_t) {},
+   });
+
+   // Step 3: Read the sorted rows in a new pipeline.
+   decayReader(dag, topk_state.topk.getSortedRows(), topk_state.topk.getSortedData());
+}
+
+void Sort::decayReader(PipelineDAG& dag, const std::vector<char*>& sorted_rows, char* const* sorted_data) const {
+   auto& read_pipe = dag.buildNewPipeline();
+   auto& driver = read_pipe.attachSuboperator(SortDriver::build(this, sorted_rows));
+   const IU& driver_iu = *driver.getIUs().front();
+   read_pipe.attachSuboperator(TScanIUProvider::buildDeferred(this, driver_iu, sorted_row, sorted_data));
+   size_t unpack_offset = 0;
+   for (size_t k = 0; k < packed.size(); ++k) {
+      auto& unpacker = read_pipe.attachSuboperator(KeyUnpackerSubop::build(this, sorted_row, *packed_out[k]));
+      KeyPackingRuntimeParams param;
+      param.offsetSet(IR::UI<2>::build(unpack_offset));
+      reinterpret_cast<KeyUnpackerSubop&>(unpacker).attachRuntimeParams(std::move(param));
+      unpack_offset += packed[k]->type->numBytes();
+   }
+}
+
+}
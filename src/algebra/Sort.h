@@ -0,0 +1,82 @@
+#ifndef INKFUSE_SORT_H
+#define INKFUSE_SORT_H
+
+#include "algebra/RelAlgOp.h"
+#include "runtime/Sorter.h"
+#include <list>
+#include <optional>
+
+namespace inkfuse {
+
+/// How does the sorter have to interpret values of the given type? Throws for types that cannot be ordered.
+SortKey::Kind sortKind(const IR::Type& type);
+
+/// Relational sort operator (ORDER BY). Decays into a materializing pipeline and a source pipeline:
+/// - The input pipeline packs the sort keys and payload into rows within thread-local TupleMaterializers.
+/// - Runtime tasks sort the rows of every thread into a run and merge the runs in parallel, see Sorter.
+/// - A new pipeline reads the sorted rows and unpacks them into the output IUs.
+/// The output consists of the keys followed by the payload.
+///
+/// With a limit the Sort becomes a Top-K (ORDER BY ... LIMIT k), which is fused into the input pipeline:
+/// - Every thread packs its rows into a scratch pad and inserts them into a thread-local bounded heap.
+/// - If the first key is a non-nullable number, a threshold filter in front of the packing rejects rows
+///   whose first key sorts behind the k-th row of the heap, see TopKThresholdSubop.
+/// - A runtime task merges the heaps, the sorted rows are read the same way as for a full sort.
+struct Sort : public RelAlgOp {
+   /// A key to sort on.
+   struct Key {
+      const IU* iu;
+      bool ascending = true;
+   };
+
+   static std::unique_ptr<Sort> build(std::vector<std::unique_ptr<RelAlgOp>> children_, std::string op_name_, std::vector<Key> keys_, std::vector<const IU*> payload_, std::optional<size_t> limit_ = {});
+
+   void decay(PipelineDAG& dag) const override;
+
+   private:
+   Sort(std::vector<std::unique_ptr<RelAlgOp>> children_, std::string op_name_, std::vector<Key> keys_, std::vector<const IU*> payload_, std::optional<size_t> limit_);
+
+   /// Decay into a full sort of all rows.
+   void decaySort(PipelineDAG& dag) const;
+   /// Decay into a Top-K keeping the first `limit` rows.
+   void decayTopK(PipelineDAG& dag) const;
+   /// Read the sorted rows in a new pipeline.
+   void decayReader(PipelineDAG& dag, const std::vector<char*>& sorted_rows, char* const* sorted_data) const;
+
+   /// The keys to sort on.
+   std::vector<Key> keys;
+   /// The payload carried along.
+   std::vector<const IU*> payload;
+   /// The IUs packed into the materialized rows: keys, payload and then the NULL indicators.
+   std::vector<const IU*> packed;
+   /// Output IU for every packed IU.
+   std::vector<const IU*> packed_out;
+   /// Description of the keys within the materialized rows.
+   std::vector<SortKey> sort_keys;
+   /// Size of a materialized row.
+   size_t row_size = 0;
+   /// Materialized row while packing. Char* typed.
+   IU mat_row;
+   /// Sorted row while unpacking. Char* typed.
+   IU sorted_row;
+   /// The output IUs.
+   std::list<IU> out_ius;
+   /// The output NULL indicators.
+   std::list<IU> out_indicators;
+   /// Row limit turning the sort into a Top-K.
+   std::optional<size_t> limit;
+   /// Top-K: the packed row on the scratch pad.
+   std::optional<IU> topk_row;
+   /// Top-K: pseudo IUs making sure the row is packed before the heap insert.
+   std::list<IU> topk_pseudo;
+   /// Top-K threshold filter: does the row pass the threshold?
+   std::optional<IU> threshold_pass;
+   /// Top-K threshold filter: pseudo IU connecting the filter scope and logic.
+   std::optional<IU> threshold_pseudo;
+   /// Top-K threshold filter: the packed IUs after the filter.
+   std::list<IU> threshold_filtered;
+};
+
+}
+
+#endif //INKFUSE_SORT_H
@@ -6,7 +6,7 @@
 namespace inkfuse {
 
 TableScan::TableScan(StoredRelation& rel_, std::vector<std::string> cols_, std::string name)
-   : RelAlgOp({}, std::move(name)), rel(rel_) {
+   : RelAlgOp({}, std::move(name)), rel(rel_), snapshot(rel_.snapshot()) {
    for (auto& col : cols_) {
       // Set up the IUs.
       std::string iu_name;
@@ -15,7 +15,12 @@ TableScan::TableScan(StoredRelation& rel_, std::vector<std::string> cols_, std::
       } else {
          iu_name = col;
       }
-      IU iu(rel.getColumn(col).getType(), std::move(iu_name));
+      IU iu(rel.getColumn(col).getType(), iu_name);
+      if (rel.getColumn(col).isNullable()) {
+         // Nullable columns get an additional Bool IU that is scanned from the column's validity bitmap.
+         auto& indicator = null_indicators.emplace_back(col, IU(IR::Bool::build(), iu_name + "_null"));
+         iu.null_indicator = &indicator.second;
+      }
       auto& elem = cols.emplace_back(std::make_pair(std::move(col), std::move(iu)));
       output_ius.push_back(&elem.second);
    }
@@ -26,18 +31,37 @@ std::unique_ptr<TableScan> TableScan::build(inkfuse::StoredRelation& rel_, std::
    return std::make_unique<TableScan>(rel_, std::move(cols), std::move(name));
 }
 
+std::optional<ValueRange> TableScan::valueRange(const IU& iu) const {
+   if (snapshot.segment_count != 0) {
+      // Column statistics only cover the bulk loaded rows.
+      return {};
+   }
+   for (const auto& col : cols) {
+      if (&col.second == &iu) {
+         return rel.getColumn(col.first).valueRange();
+      }
+   }
+   return {};
+}
+
 void TableScan::decay(PipelineDAG& dag) const {
    // Create a new pipeline.
    auto& pipe = dag.buildNewPipeline();
-   // Set up the loop driver.
-   auto rel_size = rel.getColumn(0).second.length();
-   auto& driver = reinterpret_cast<TScanDriver&>(pipe.attachSuboperator(TScanDriver::build(this, rel_size)));
+   // Set up the loop driver. It picks morsels segment by segment in a NUMA-aware fashion.
+   auto& driver = reinterpret_cast<TScanDriver&>(pipe.attachSuboperator(TScanDriver::build(this, rel.getSegments(snapshot))));
    auto driver_iu = *driver.getIUs().begin();
    // Set up the actual column scans.
    for (auto& col : cols) {
       // Attach the operator.
-      auto col_data = rel.getColumn(col.first).getRawData();
-      auto& provider = reinterpret_cast<TScanIUProvider&>(pipe.attachSuboperator(TScanIUProvider::build(this, *driver_iu, col.second, col_data)));
+      auto col_blocks = rel.getColumnBlocks(col.first, snapshot);
+      auto& provider = reinterpret_cast<TScanIUProvider&>(pipe.attachSuboperator(TScanIUProvider::build(this, *driver_iu, col.second, std::move(col_blocks))));
+      driver.attachProvider(provider);
+   }
+   // And the NULL indicators of nullable columns, read from the packed validity bitmaps.
+   for (auto& indicator : null_indicators) {
+      auto validity_blocks = rel.getValidityBlocks(indicator.first, snapshot);
+      auto& provider = reinterpret_cast<TScanIUProvider&>(pipe.attachSuboperator(TScanIUProvider::buildValidity(this, *driver_iu, indicator.second, std::move(validity_blocks))));
+      driver.attachProvider(provider);
    }
 }
 
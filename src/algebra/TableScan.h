@@ -9,17 +9,29 @@ namespace inkfuse {
 
 /// A table scan relational operator. Reads a set of columns from an underlying relation
 /// and makes them available as IUs.
+/// The scan reads the snapshot of the relation taken when the operator is created. Rows
+/// appended concurrently afterwards are not visible.
 struct TableScan : public RelAlgOp {
    TableScan(StoredRelation& rel_, std::vector<std::string> cols, std::string name);
    static std::unique_ptr<TableScan> build(StoredRelation& rel_, std::vector<std::string> cols, std::string name);
 
    void decay(PipelineDAG& dag) const override;
 
+   /// The value range of a scanned column. Unknown if appended rows are visible in the snapshot.
+   std::optional<ValueRange> valueRange(const IU& iu) const override;
+
+   /// Get the snapshot of the relation the scan is reading.
+   const RelationSnapshot& getSnapshot() const { return snapshot; }
+
    private:
    // The relation which to read from.
    StoredRelation& rel;
+   // The rows of the relation visible to the scan.
+   RelationSnapshot snapshot;
    // Columns to be read.
    std::list<std::pair<std::string, IU>> cols;
+   // NULL indicators of the nullable columns, keyed by the column name.
+   std::list<std::pair<std::string, IU>> null_indicators;
 };
 
 }
@@ -0,0 +1,203 @@
+#include "algebra/Window.h"
+#include "algebra/Pipeline.h"
+#include "algebra/suboperators/RuntimeFunctionSubop.h"
+#include "algebra/suboperators/row_layout/KeyPackerSubop.h"
+#include "algebra/suboperators/row_layout/KeyUnpackerSubop.h"
+#include "algebra/suboperators/sources/SortSource.h"
+#include "algebra/suboperators/sources/TableScanSource.h"
+#include <algorithm>
+
+namespace inkfuse {
+
+namespace {
+
+/// Can a window sum be computed over the given type?
+bool supportsSum(const IR::Type& type) {
+   return dynamic_cast<const IR::SignedInt*>(&type) || dynamic_cast<const IR::UnsignedInt*>(&type) || dynamic_cast<const IR::Float*>(&type);
+}
+
+}
+
+std::unique_ptr<Window> Window::build(std::vector<std::unique_ptr<RelAlgOp>> children_, std::string op_name_, std::vector<const IU*> partition_by_, std::vector<Sort::Key> order_by_, std::vector<const IU*> payload_, std::vector<Function> functions_) {
+   return std::unique_ptr<Window>(new Window(std::move(children_), std::move(op_name_), std::move(partition_by_), std::move(order_by_), std::move(payload_), std::move(functions_)));
+}
+
+Window::Window(std::vector<std::unique_ptr<RelAlgOp>> children_, std::string op_name_, std::vector<const IU*> partition_by_, std::vector<Sort::Key> order_by_, std::vector<const IU*> payload_, std::vector<Function> functions_)
+   : RelAlgOp(std::move(children_), std::move(op_name_)),
+     partition_by(std::move(partition_by_)),
+     order_by(std::move(order_by_)),
+     payload(std::move(payload_)),
+     functions(std::move(functions_)),
+     mat_row(IR::Pointer::build(IR::Char::build())),
+     evaluated_row(IR::Pointer::build(IR::Char::build())) {
+   if (children.size() != 1) {
+      throw std::runtime_error("Window needs to have exactly one child");
+   }
+   if (functions.empty()) {
+      throw std::runtime_error("Window needs at least one function");
+   }
+
+   // Row layout: [keys | payload | function arguments | NULL indicators | results | result NULL indicators].
+   for (const IU* iu : partition_by) {
+      addPacked(iu, true);
+   }
+   for (const auto& key : order_by) {
+      addPacked(key.iu, true);
+   }
+   for (const IU* iu : payload) {
+      addPacked(iu, true);
+   }
+   std::vector<size_t> arg_idxs;
+   for (const auto& function : functions) {
+      if (function.kind != WindowFunction::Kind::Sum) {
+         arg_idxs.push_back(0);
+         continue;
+      }
+      if (!function.arg || !supportsSum(*function.arg->type)) {
+         throw std::runtime_error("Window sum needs a numeric argument");
+      }
+      // Arguments that are not packed already get packed without being produced.
+      auto existing = std::find(packed.begin(), packed.end(), function.arg);
+      arg_idxs.push_back(existing != packed.end() ? existing - packed.begin() : addPacked(function.arg, false));
+   }
+
+   const size_t num_values = packed.size();
+   for (const IU* iu : packed) {
+      packed_offsets.push_back(row_size);
+      row_size += iu->type->numBytes();
+   }
+   std::vector<std::optional<uint16_t>> null_offsets(num_values);
+   for (size_t k = 0; k < num_values; ++k) {
+      if (const IU* indicator = packed[k]->null_indicator) {
+         IU* out_indicator = nullptr;
+         if (packed_out[k]) {
+            out_indicator = &out_indicators.emplace_back(IR::Bool::build());
+            packed_out[k]->null_indicator = out_indicator;
+         }
+         packed.push_back(indicator);
+         packed_out.push_back(out_indicator);
+         packed_offsets.push_back(row_size);
+         null_offsets[k] = row_size;
+         row_size += 1;
+      }
+   }
+
+   auto describe = [&](size_t idx, bool ascending) {
+      const IR::Type& type = *packed[idx]->type;
+      return SortKey{
+         .kind = sortKind(type),
+         .width = static_cast<uint16_t>(type.numBytes()),
+         .offset = static_cast<uint16_t>(packed_offsets[idx]),
+         .null_offset = null_offsets[idx],
+         .ascending = ascending,
+      };
+   };
+   for (size_t k = 0; k < partition_by.size(); ++k) {
+      partition_keys.push_back(describe(k, true));
+   }
+   for (size_t k = 0; k < order_by.size(); ++k) {
+      order_keys.push_back(describe(partition_by.size() + k, order_by[k].ascending));
+   }
+
+   // The function results follow the packed IUs.
+   std::vector<IU*> results;
+   for (size_t k = 0; k < functions.size(); ++k) {
+      const auto& function = functions[k];
+      auto& out = out_ius.emplace_back(function.kind == WindowFunction::Kind::Sum ? function.arg->type : IR::SignedInt::build(8));
+      output_ius.push_back(&out);
+      result_out.push_back(&out);
+      result_offsets.push_back(row_size);
+      results.push_back(&out);
+      auto& described = window_functions.emplace_back(WindowFunction{
+         .kind = function.kind,
+         .preceding = function.preceding,
+         .result_offset = static_cast<uint16_t>(row_size),
+      });
+      if (function.kind == WindowFunction::Kind::Sum) {
+         described.arg = describe(arg_idxs[k], true);
+      }
+      row_size += out.type->numBytes();
+   }
+   for (size_t k = 0; k < functions.size(); ++k) {
+      if (window_functions[k].arg && window_functions[k].arg->null_offset) {
+         // Sums over nullable arguments are NULL if the frame contains no values.
+         auto& out = out_indicators.emplace_back(IR::Bool::build());
+         results[k]->null_indicator = &out;
+         result_out.push_back(&out);
+         result_offsets.push_back(row_size);
+         window_functions[k].result_null_offset = row_size;
+         row_size += 1;
+      }
+   }
+}
+
+size_t Window::addPacked(const IU* in, bool produce) {
+   IU* out_ptr = nullptr;
+   if (produce) {
+      auto& out = out_ius.emplace_back(in->type);
+      output_ius.push_back(&out);
+      out_ptr = &out;
+   }
+   packed.push_back(in);
+   packed_out.push_back(out_ptr);
+   return packed.size() - 1;
+}
+
+void Window::decay(PipelineDAG& dag) const {
+   auto& mat_state = dag.attachTupleMaterializers(0, row_size);
+   auto& window_state = dag.attachWindowState(0, mat_state, partition_keys, order_keys, window_functions);
+
+   // Step 1: Materialize all rows.
+   children[0]->decay(dag);
+   auto& mat_pipe = dag.getCurrentPipeline();
+   mat_pipe.attachSuboperator(RuntimeFunctionSubop::materializeTuple(this, mat_row, packed, &mat_state));
+   for (size_t k = 0; k < packed.size(); ++k) {
+      auto& packer = mat_pipe.attachSuboperator(KeyPackerSubop::build(this, *packed[k], mat_row, {}));
+      KeyPackingRuntimeParams param;
+      param.offsetSet(IR::UI<2>::build(packed_offsets[k]));
+      reinterpret_cast<KeyPackerSubop&>(packer).attachRuntimeParams(std::move(param));
+   }
+
+   // Step 2: Runtime tasks partitioning the rows and evaluating the partitions.
+   const size_t mat_pipe_idx = dag.getPipelines().size() - 1;
+   dag.addRuntimeTask(PipelineDAG::RuntimeTask{
+      .after_pipe = mat_pipe_idx,
+      .prepare_function = [&window_state](ExecutionContext&, size_t total_threads) {
+         window_state.evaluator.preparePartitioning(total_threads);
+      },
+      .worker_function = [&window_state](ExecutionContext&, size_t thread_id) {
+         window_state.evaluator.partitionRows(thread_id, *window_state.materialize.handles[thread_id]);
+      },
+   });
+   dag.addRuntimeTask(PipelineDAG::RuntimeTask{
+      .after_pipe = mat_pipe_idx,
+      .prepare_function = [&window_state](ExecutionContext&, size_t) {
+         window_state.evaluator.prepareEvaluation();
+      },
+      .worker_function = [&window_state](ExecutionContext&, size_t) {
+         window_state.evaluator.evaluatePartitions();
+      },
+   });
+
+   // Step 3: Read the evaluated rows in a new pipeline.
+   auto& read_pipe = dag.buildNewPipeline();
+   auto& driver = read_pipe.attachSuboperator(SortDriver::build(this, window_state.evaluator.getRows(), false));
+   const IU& driver_iu = *driver.getIUs().front();
+   read_pipe.attachSuboperator(TScanIUProvider::buildDeferred(this, driver_iu, evaluated_row, window_state.evaluator.getRowData()));
+   auto attach_unpacker = [&](const IU& out, size_t offset) {
+      auto& unpacker = read_pipe.attachSuboperator(KeyUnpackerSubop::build(this, evaluated_row, out));
+      KeyPackingRuntimeParams param;
+      param.offsetSet(IR::UI<2>::build(offset));
+      reinterpret_cast<KeyUnpackerSubop&>(unpacker).attachRuntimeParams(std::move(param));
+   };
+   for (size_t k = 0; k < packed.size(); ++k) {
+      if (packed_out[k]) {
+         attach_unpacker(*packed_out[k], packed_offsets[k]);
+      }
+   }
+   for (size_t k = 0; k < result_out.size(); ++k) {
+      attach_unpacker(*result_out[k], result_offsets[k]);
+   }
+}
+
+}
@@ -0,0 +1,79 @@
+#ifndef INKFUSE_WINDOW_H
+#define INKFUSE_WINDOW_H
+
+#include "algebra/RelAlgOp.h"
+#include "algebra/Sort.h"
+#include "runtime/WindowEvaluator.h"
+#include <list>
+#include <optional>
+
+namespace inkfuse {
+
+/// Relational window operator, evaluating window functions OVER (PARTITION BY ... ORDER BY ...).
+/// Decays into a materializing pipeline and a source pipeline:
+/// - The input pipeline packs the keys, payload and function arguments into rows within thread-local TupleMaterializers.
+///   Every row reserves space for the results of the window functions.
+/// - Runtime tasks hash-partition the rows on the PARTITION BY keys and evaluate the window functions on the
+///   hash partitions in parallel, see WindowEvaluator.
+/// - A new pipeline reads the evaluated rows and unpacks them into the output IUs. Any thread can pick morsels,
+///   the output rows are only ordered within their partition.
+/// The output consists of the PARTITION BY keys, the ORDER BY keys, the payload and then the function results.
+struct Window : public RelAlgOp {
+   /// A window function to evaluate.
+   struct Function {
+      WindowFunction::Kind kind;
+      /// The argument of a sum.
+      const IU* arg = nullptr;
+      /// The frame of a sum: ROWS BETWEEN `preceding` PRECEDING AND CURRENT ROW. Unbounded if not set.
+      std::optional<size_t> preceding = {};
+   };
+
+   static std::unique_ptr<Window> build(std::vector<std::unique_ptr<RelAlgOp>> children_, std::string op_name_, std::vector<const IU*> partition_by_, std::vector<Sort::Key> order_by_, std::vector<const IU*> payload_, std::vector<Function> functions_);
+
+   void decay(PipelineDAG& dag) const override;
+
+   private:
+   Window(std::vector<std::unique_ptr<RelAlgOp>> children_, std::string op_name_, std::vector<const IU*> partition_by_, std::vector<Sort::Key> order_by_, std::vector<const IU*> payload_, std::vector<Function> functions_);
+
+   /// Add an IU to the materialized rows. Returns the index within `packed`.
+   size_t addPacked(const IU* in, bool produce);
+
+   /// The PARTITION BY keys.
+   std::vector<const IU*> partition_by;
+   /// The ORDER BY keys.
+   std::vector<Sort::Key> order_by;
+   /// The payload carried along.
+   std::vector<const IU*> payload;
+   /// The window functions.
+   std::vector<Function> functions;
+   /// The IUs packed into the materialized rows: keys, payload, function arguments and then the NULL indicators.
+   std::vector<const IU*> packed;
+   /// Output IU for every packed IU. Function arguments that are not produced have none.
+   std::vector<IU*> packed_out;
+   /// Offset of every packed IU in the row.
+   std::vector<size_t> packed_offsets;
+   /// Output IU for every function result and result NULL indicator.
+   std::vector<const IU*> result_out;
+   /// Offset of every function result and result NULL indicator in the row.
+   std::vector<size_t> result_offsets;
+   /// Description of the PARTITION BY keys within the materialized rows.
+   std::vector<SortKey> partition_keys;
+   /// Description of the ORDER BY keys within the materialized rows.
+   std::vector<SortKey> order_keys;
+   /// Description of the window functions within the materialized rows.
+   std::vector<WindowFunction> window_functions;
+   /// Size of a materialized row.
+   size_t row_size = 0;
+   /// Materialized row while packing. Char* typed.
+   IU mat_row;
+   /// Evaluated row while unpacking. Char* typed.
+   IU evaluated_row;
+   /// The output IUs.
+   std::list<IU> out_ius;
+   /// The output NULL indicators.
+   std::list<IU> out_indicators;
+};
+
+}
+
+#endif //INKFUSE_WINDOW_H
@@ -1,16 +1,30 @@
 #include "algebra/suboperators/ColumnFilter.h"
 #include "algebra/CompilationContext.h"
+#include "algebra/Pipeline.h"
+#include "algebra/suboperators/sinks/FuseChunkSink.h"
 #include "codegen/Expression.h"
 #include "codegen/Statement.h"
+#include <algorithm>
 
 namespace inkfuse {
 
-SuboperatorArc ColumnFilterScope::build(const RelAlgOp* source_, const IU& filter_iu_, const IU& pseudo) {
-   return SuboperatorArc{new ColumnFilterScope(source_, filter_iu_, pseudo)};
+void FilterSelectivity::record(uint64_t in, uint64_t out) {
+   rows_in.fetch_add(in, std::memory_order_relaxed);
+   rows_out.fetch_add(out, std::memory_order_relaxed);
 }
 
-ColumnFilterScope::ColumnFilterScope(const RelAlgOp* source_, const IU& filter_iu_, const IU& pseudo)
-   : TemplatedSuboperator<EmptyState>(source_, std::vector<const IU*>{&pseudo}, std::vector<const IU*>{&filter_iu_}) {
+bool FilterSelectivity::preferBranchFree() const {
+   const auto in = static_cast<double>(rows_in.load(std::memory_order_relaxed));
+   const auto out = static_cast<double>(rows_out.load(std::memory_order_relaxed));
+   return in > 0 && out >= BRANCH_FREE_MIN_SELECTIVITY * in && out <= BRANCH_FREE_MAX_SELECTIVITY * in;
+}
+
+SuboperatorArc ColumnFilterScope::build(const RelAlgOp* source_, const IU& filter_iu_, const IU& pseudo, bool branch_free_) {
+   return SuboperatorArc{new ColumnFilterScope(source_, filter_iu_, pseudo, branch_free_)};
+}
+
+ColumnFilterScope::ColumnFilterScope(const RelAlgOp* source_, const IU& filter_iu_, const IU& pseudo, bool branch_free_)
+   : TemplatedSuboperator<EmptyState>(source_, std::vector<const IU*>{&pseudo}, std::vector<const IU*>{&filter_iu_}), branch_free(branch_free_) {
 }
 
 void ColumnFilterScope::open(CompilationContext& context) {
@@ -37,6 +51,14 @@ void ColumnFilterScope::consumeAllChildren(CompilationContext& context) {
    auto& builder = context.getFctBuilder();
    const auto& program = context.getProgram();
 
+   // The fused code is predicated on the selectivity the interpreter observed until now.
+   predicated = (branch_free || selectivity->preferBranchFree()) && canPredicate(context);
+   if (predicated) {
+      // All rows flow to the fuse chunk sinks, they only count the qualifying ones.
+      context.notifyIUsReady(*this);
+      return;
+   }
+
    // Resolve incoming operator scope. This is the one where we get source IUs from.
    const auto& decl = context.getIUDeclaration(*source_ius[0]);
    auto expr = IR::VarRefExpr::build(decl);
@@ -53,21 +75,49 @@ void ColumnFilterScope::consumeAllChildren(CompilationContext& context) {
 void ColumnFilterScope::close(CompilationContext& context) {
    // We can now close the sub-operator, this will terminate the if statement
    // and reinstall the original block.
-   opt_if->End();
-   opt_if.reset();
+   if (opt_if) {
+      opt_if->End();
+      opt_if.reset();
+   }
    context.notifyOpClosed(*this);
 }
 
+bool ColumnFilterScope::canPredicate(const CompilationContext& context) const {
+   if (!dynamic_cast<IR::Bool*>(source_ius[0]->type.get())) {
+      return false;
+   }
+   // Every row gets copied, so the consumers must only write qualifying rows into fuse chunks.
+   const auto& subops = context.getPipeline().getSubops();
+   auto consumes = [](const Suboperator& op, const IU* iu) {
+      const auto& sources = op.getSourceIUs();
+      return std::find(sources.begin(), sources.end(), iu) != sources.end();
+   };
+   for (const auto& logic : subops) {
+      if (!consumes(*logic, provided_ius[0])) {
+         continue;
+      }
+      if (!dynamic_cast<ColumnFilterLogic*>(logic.get())) {
+         return false;
+      }
+      for (const auto& consumer : subops) {
+         if (consumes(*consumer, logic->getIUs()[0]) && !dynamic_cast<FuseChunkSink*>(consumer.get())) {
+            return false;
+         }
+      }
+   }
+   return true;
+}
+
 std::string ColumnFilterScope::id() const {
    return "ColumnFilterScope";
 }
 
-SuboperatorArc ColumnFilterLogic::build(const RelAlgOp* source_, const IU& pseudo, const IU& incoming_, const IU& redefined, IR::TypeArc filter_type_, bool filters_itself_) {
-   return SuboperatorArc{new ColumnFilterLogic(source_, pseudo, incoming_, redefined, std::move(filter_type_), filters_itself_)};
+SuboperatorArc ColumnFilterLogic::build(const RelAlgOp* source_, const IU& pseudo, const IU& incoming_, const IU& redefined, IR::TypeArc filter_type_, bool filters_itself_, bool branch_free_) {
+   return SuboperatorArc{new ColumnFilterLogic(source_, pseudo, incoming_, redefined, std::move(filter_type_), filters_itself_, branch_free_)};
 }
 
-ColumnFilterLogic::ColumnFilterLogic(const RelAlgOp* source_, const IU& pseudo, const IU& incoming, const IU& redefined, IR::TypeArc filter_type_, bool filters_itself_)
-   : TemplatedSuboperator<EmptyState>(source_, std::vector<const IU*>{&redefined}, std::vector<const IU*>{&pseudo, &incoming}), filter_type(std::move(filter_type_)), filters_itself(filters_itself_) {
+ColumnFilterLogic::ColumnFilterLogic(const RelAlgOp* source_, const IU& pseudo, const IU& incoming, const IU& redefined, IR::TypeArc filter_type_, bool filters_itself_, bool branch_free_)
+   : TemplatedSuboperator<EmptyState>(source_, std::vector<const IU*>{&redefined}, std::vector<const IU*>{&pseudo, &incoming}), filter_type(std::move(filter_type_)), filters_itself(filters_itself_), branch_free(branch_free_) {
    // When filtering a ByteArray something subtle happens:
    // The result column becomes a char*. This way we don't have to copy the entire byte array, but rather
    // just pointers. An alternative implementation would be to have variable size sinks and to do
@@ -109,11 +159,33 @@ void ColumnFilterLogic::consumeAllChildren(CompilationContext& context) {
 }
 
 std::string ColumnFilterLogic::id() const {
+   return buildId(!branch_free);
+}
+
+std::string ColumnFilterLogic::branchFreeId() const {
+   // Self filters and filters on pointers always run with branches.
+   if (filters_itself || !dynamic_cast<IR::Bool*>(filter_type.get())) {
+      return "";
+   }
+   return buildId(false);
+}
+
+std::string ColumnFilterLogic::buildId(bool with_branches) const {
    if (filters_itself) {
       return "ColumnSelfFilterLogic_" + filter_type->id() + "_" + source_ius[1]->type->id();
+   } else if (!with_branches) {
+      return "ColumnBranchFreeFilterLogic_" + filter_type->id() + "_" + source_ius[1]->type->id();
    } else {
       return "ColumnFilterLogic_" + filter_type->id() + "_" + source_ius[1]->type->id();
    }
 }
 
+const IU* ColumnFilterLogic::getPredicate(const Pipeline& pipe) const {
+   auto scope = dynamic_cast<const ColumnFilterScope*>(pipe.tryGetProvider(*source_ius[0]));
+   if (!scope || !scope->isPredicated()) {
+      return nullptr;
+   }
+   return scope->getSourceIUs()[0];
+}
+
 }
@@ -4,6 +4,8 @@
 #include "algebra/Filter.h"
 #include "algebra/suboperators/Suboperator.h"
 #include "codegen/IRBuilder.h"
+#include <atomic>
+#include <memory>
 #include <optional>
 
 /// This file contains all the sub-operators required to get filters working in ink-fuse.
@@ -14,12 +16,41 @@
 /// of vectorized primitive invocations.
 /// A ColumnFilterScope and a ColumnFilterLogic operator are connected through a void-typed pseudo IU
 /// that is never defined.
+///
+/// Filters can also be generated branch-free: if the redefined IUs are only written into fuse chunks
+/// (as in the vectorized primitives), every row is copied and the chunk size is advanced by the filter
+/// result instead of opening an `if`. This avoids branch mispredictions at mid-range selectivities.
+/// The InterpretedRunner picks between the two primitives based on the observed selectivity. Fused
+/// code generated after the interpreter observed the filter is predicated on the same selectivity.
 namespace inkfuse {
 
+/// Selectivity of a filter observed by the interpreter. Shared between the interpreted primitives
+/// and the code generation of the fused pipeline.
+struct FilterSelectivity {
+   /// Branches on the filter result mispredict at mid-range selectivities. Within
+   /// [MIN, MAX], filters run branch-free instead.
+   static constexpr double BRANCH_FREE_MIN_SELECTIVITY = 0.2;
+   static constexpr double BRANCH_FREE_MAX_SELECTIVITY = 0.8;
+
+   /// Record a morsel with `in` rows of which `out` passed the filter.
+   void record(uint64_t in, uint64_t out);
+   /// Should the filter run branch-free? False as long as no rows were observed.
+   bool preferBranchFree() const;
+
+   private:
+   /// Rows seen by the filter so far.
+   std::atomic<uint64_t> rows_in = 0;
+   /// Rows that passed the filter so far.
+   std::atomic<uint64_t> rows_out = 0;
+};
+
 /// Scoping operator building the if statement needed in a filter.
 struct ColumnFilterScope : public TemplatedSuboperator<EmptyState> {
    /// Set up a ColumnFilterScope that consumes the filter IU and defines a new pseudo IU.
-   static SuboperatorArc build(const RelAlgOp* source_, const IU& filter_iu_, const IU& pseudo);
+   /// A branch-free scope is always predicated, otherwise the observed selectivity decides.
+   /// Either way, the scope falls back to an `if` when its rows are consumed by anything but
+   /// fuse chunk sinks.
+   static SuboperatorArc build(const RelAlgOp* source_, const IU& filter_iu_, const IU& pseudo, bool branch_free_ = false);
 
    /// A ColumnFilterScope sub-operator does not have to be interpreted.
    /// Rather, it will get warped into the primitives of the successive ColumnFilterLogic operator.
@@ -35,11 +66,27 @@ struct ColumnFilterScope : public TemplatedSuboperator<EmptyState> {
    /// Attach a dependency of a future ColumnFilterLogic.
    void attachFilterLogicDependency(Suboperator& subop, const IU& iu);
 
+   /// Did the last code generation produce branch-free code? Then all rows reach the consumers
+   /// and only the filter IU tells which of them qualify.
+   bool isPredicated() const { return predicated; };
+
+   /// The selectivity observed by the interpreted primitives of this filter.
+   FilterSelectivity& getSelectivity() const { return *selectivity; };
+
    std::string id() const override;
 
    private:
-   ColumnFilterScope(const RelAlgOp* source_, const IU& filter_iu_, const IU& pseudo);
+   ColumnFilterScope(const RelAlgOp* source_, const IU& filter_iu_, const IU& pseudo, bool branch_free_);
+
+   /// Can the filter be generated without branches in the given pipeline?
+   bool canPredicate(const CompilationContext& context) const;
 
+   /// Should branch-free code always be generated if possible?
+   bool branch_free;
+   /// Was branch-free code generated?
+   bool predicated = false;
+   /// Selectivity observed by the interpreter.
+   std::shared_ptr<FilterSelectivity> selectivity = std::make_shared<FilterSelectivity>();
    /// In-flight if statement being generated.
    std::optional<IR::If> opt_if;
    /// The `ColumnFilterScope` requests the input IUs for the `ColumnFilterLogic`.
@@ -51,7 +98,7 @@ struct ColumnFilterScope : public TemplatedSuboperator<EmptyState> {
 /// Logic operator redefining the IU as a copy of the old one.
 struct ColumnFilterLogic : public TemplatedSuboperator<EmptyState> {
    /// Set up a ColumnFilterLogic that consumes the ColumnFilterScope pseudo IU and redefines the incoming one.
-   static SuboperatorArc build(const RelAlgOp* source_, const IU& pseudo, const IU& incoming, const IU& redefined, IR::TypeArc filter_type_ = IR::Bool::build(), bool filters_itself = false);
+   static SuboperatorArc build(const RelAlgOp* source_, const IU& pseudo, const IU& incoming, const IU& redefined, IR::TypeArc filter_type_ = IR::Bool::build(), bool filters_itself = false, bool branch_free_ = false);
 
    /// A ColumnFilterLogic sub-operator will wrap the incoming ColumnFilterScope
    /// operator into its vectorized primitive.
@@ -63,15 +110,26 @@ struct ColumnFilterLogic : public TemplatedSuboperator<EmptyState> {
    void consumeAllChildren(CompilationContext& context) override;
 
    std::string id() const override;
+   /// Id of the branch-free primitive for this filter. Empty if the filter can't be evaluated branch-free.
+   std::string branchFreeId() const;
+
+   /// Get the filter IU deciding which rows qualify if the scope generated branch-free code.
+   /// nullptr if only qualifying rows reach the consumers.
+   const IU* getPredicate(const Pipeline& pipe) const;
 
    private:
-   ColumnFilterLogic(const RelAlgOp* source_, const IU& pseudo, const IU& incoming, const IU& redefined, IR::TypeArc filter_type_, bool filters_itself_);
+   ColumnFilterLogic(const RelAlgOp* source_, const IU& pseudo, const IU& incoming, const IU& redefined, IR::TypeArc filter_type_, bool filters_itself_, bool branch_free_);
+
+   /// Build the primitive id.
+   std::string buildId(bool with_branches) const;
 
    /// On what type do we filter?
    IR::TypeArc filter_type;
    /// Does this filter filter itself? I.e. the filter IU is the same one as the
    /// incoming one that gets redefined?
    bool filters_itself;
+   /// Is this the branch-free variant of the primitive?
+   bool branch_free;
 };
 }
 
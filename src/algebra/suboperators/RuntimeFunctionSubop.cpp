@@ -28,6 +28,27 @@ std::unique_ptr<RuntimeFunctionSubop> RuntimeFunctionSubop::materializeTuple(con
          &ptr_out_));
 }
 
+std::unique_ptr<RuntimeFunctionSubop> RuntimeFunctionSubop::topKInsert(const RelAlgOp* source, const IU& row_, std::vector<const IU*> pseudo_ius_, DefferredStateInitializer* state_init_) {
+   std::string fct_name = "topk_insert";
+   std::vector<const IU*> in_ius{&row_};
+   for (auto pseudo : pseudo_ius_) {
+      // Pseudo IUs make sure the row is fully packed before the insert.
+      in_ius.push_back(pseudo);
+   }
+   std::vector<bool> ref{row_.type->id() != "ByteArray" && row_.type->id() != "Ptr_Char"};
+   std::vector<const IU*> args{&row_};
+   return std::unique_ptr<RuntimeFunctionSubop>(
+      new RuntimeFunctionSubop(
+         source,
+         state_init_,
+         std::move(fct_name),
+         std::move(in_ius),
+         std::move(std::vector<const IU*>{}),
+         std::move(args),
+         std::move(ref),
+         nullptr));
+}
+
 std::unique_ptr<RuntimeFunctionSubop> RuntimeFunctionSubop::htInsert(const inkfuse::RelAlgOp* source, const inkfuse::IU* pointers_, const inkfuse::IU& key_, std::vector<const IU*> pseudo_ius_, DefferredStateInitializer* state_init_) {
    std::string fct_name = "ht_sk_insert";
    std::vector<const IU*> in_ius{&key_};
@@ -53,6 +74,25 @@ std::unique_ptr<RuntimeFunctionSubop> RuntimeFunctionSubop::htInsert(const inkfu
          pointers_));
 }
 
+std::unique_ptr<RuntimeFunctionSubop> RuntimeFunctionSubop::gjPartialState(const RelAlgOp* source, const IU& state_, const IU& slot_, DefferredStateInitializer* state_init_) {
+   std::string fct_name = "gj_partial_state";
+   std::vector<const IU*> in_ius{&slot_};
+   std::vector<const IU*> out_ius_{&state_};
+   std::vector<const IU*> args{&slot_};
+   std::vector<bool> ref{false};
+   const IU* out = &state_;
+   return std::unique_ptr<RuntimeFunctionSubop>(
+      new RuntimeFunctionSubop(
+         source,
+         state_init_,
+         std::move(fct_name),
+         std::move(in_ius),
+         std::move(out_ius_),
+         std::move(args),
+         std::move(ref),
+         out));
+}
+
 std::unique_ptr<RuntimeFunctionSubop> RuntimeFunctionSubop::htNoKeyLookup(const RelAlgOp* source, const IU& pointers_, const IU& input_dependency, DefferredStateInitializer* state_init_) {
    std::string fct_name = "ht_nk_lookup";
    std::vector<const IU*> in_ius{&input_dependency};
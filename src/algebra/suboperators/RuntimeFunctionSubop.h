@@ -27,6 +27,9 @@ struct RuntimeFunctionSubop : public TemplatedSuboperator<RuntimeFunctionSubopSt
    /// Materialize a tuple in a dense tuplebuffer.
    static std::unique_ptr<RuntimeFunctionSubop> materializeTuple(const RelAlgOp* source, const IU& ptr_out_, std::vector<const IU*> inputs, DefferredStateInitializer* state_init_ = nullptr);
 
+   /// Insert a packed row into the thread-local heap of a Top-K.
+   static std::unique_ptr<RuntimeFunctionSubop> topKInsert(const RelAlgOp* source, const IU& row_, std::vector<const IU*> pseudo_ius_, DefferredStateInitializer* state_init_ = nullptr);
+
    /// Build an insert function for a hash table.
    static std::unique_ptr<RuntimeFunctionSubop> htInsert(const RelAlgOp* source, const IU* pointers_, const IU& key_, std::vector<const IU*> pseudo_ius_, DefferredStateInitializer* state_init_ = nullptr);
 
@@ -62,13 +65,17 @@ struct RuntimeFunctionSubop : public TemplatedSuboperator<RuntimeFunctionSubopSt
             out));
    }
 
-   /// Build a hash table lookup function.
-   template <class HashTable, bool disable_slot>
+   /// Build a hash table lookup function. Outer lookups mark the found slot as having a join partner.
+   template <class HashTable, bool disable_slot, bool outer = false>
    static std::unique_ptr<RuntimeFunctionSubop> htLookupWithHash(const RelAlgOp* source, const IU& pointers_, const IU& key_, const IU& hash_, const IU* prefetch_pseudo_, DefferredStateInitializer* state_init_ = nullptr) {
+      static_assert(!disable_slot || !outer);
       std::string fct_name = "ht_" + HashTable::ID + "_lookup_with_hash";
       if constexpr (disable_slot) {
          fct_name += "_disable";
       }
+      if constexpr (outer) {
+         fct_name += "_outer";
+      }
       std::vector<const IU*> in_ius{&key_, &hash_};
       if (prefetch_pseudo_) {
          in_ius.push_back(prefetch_pseudo_);
@@ -142,6 +149,33 @@ struct RuntimeFunctionSubop : public TemplatedSuboperator<RuntimeFunctionSubopSt
             pointers_));
    }
 
+   /// Build a hash table lookup or insert function for a key with precomputed hash.
+   template <class HashTable>
+   static std::unique_ptr<RuntimeFunctionSubop> htLookupOrInsertWithHash(const RelAlgOp* source, const IU* pointers_, const IU& key_, const IU& hash_, DefferredStateInitializer* state_init_ = nullptr) {
+      std::string fct_name = "ht_" + HashTable::ID + "_lookup_or_insert_with_hash";
+      std::vector<const IU*> in_ius{&key_, &hash_};
+      // The argument needs to be referenced if we directly use a non-packed IU as argument.
+      std::vector<bool> ref{key_.type->id() != "ByteArray" && key_.type->id() != "Ptr_Char", false};
+      std::vector<const IU*> out_ius_;
+      if (pointers_) {
+         out_ius_.push_back(pointers_);
+      }
+      std::vector<const IU*> args{&key_, &hash_};
+      return std::unique_ptr<RuntimeFunctionSubop>(
+         new RuntimeFunctionSubop(
+            source,
+            state_init_,
+            std::move(fct_name),
+            std::move(in_ius),
+            std::move(out_ius_),
+            std::move(args),
+            std::move(ref),
+            pointers_));
+   }
+
+   /// Resolve the thread-local partial aggregate state of a group join hash table slot.
+   static std::unique_ptr<RuntimeFunctionSubop> gjPartialState(const RelAlgOp* source, const IU& state_, const IU& slot_, DefferredStateInitializer* state_init_ = nullptr);
+
    /// Build a lookup function for a hash table with a 0-byte key.
    static std::unique_ptr<RuntimeFunctionSubop> htNoKeyLookup(const RelAlgOp* source, const IU& pointers_, const IU& input_dependency, DefferredStateInitializer* state_init_ = nullptr);
 
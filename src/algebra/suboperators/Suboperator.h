@@ -4,6 +4,7 @@
 #include "algebra/IU.h"
 #include "exec/ExecutionContext.h"
 #include <cstddef>
+#include <functional>
 #include <memory>
 #include <optional>
 #include <set>
@@ -105,6 +106,10 @@ struct Suboperator {
    virtual PickMorselResult pickMorsel(size_t thread_id) {
       throw std::runtime_error("Operator does not support picking morsels");
    }
+   /// Estimate how many rows the source produces. Only relevant for source operators.
+   /// Returns std::nullopt if the rows are not known while planning the query, e.g. because
+   /// they are produced by previous pipelines.
+   virtual std::optional<size_t> estimateRows() const { return std::nullopt; }
 
    /// Build a unique identifier for this suboperator (unique given the parameter set).
    /// This is neded to effectively use the fragment cache during vectorized interpretation.
@@ -143,11 +148,17 @@ struct Suboperator {
       };
       /// ROF Strategy for this suboperator.
       ROFStrategy rof_strategy = ROFStrategy::Default;
+      /// Runtime property. When set, the vectorized backend measures every morsel it interprets
+      /// for the suboperator and reports the rows of the morsel and the elapsed nanoseconds.
+      std::function<void(size_t rows, uint64_t nanos)> rt_cost_callback;
    };
    const OptimizationProperties& getOptimizationProperties() const { return optimization_properties; };
    void setROFStrategy(OptimizationProperties::ROFStrategy strategy) {
       optimization_properties.rof_strategy = strategy;
    };
+   void setCostCallback(std::function<void(size_t rows, uint64_t nanos)> callback) {
+      optimization_properties.rt_cost_callback = std::move(callback);
+   };
 
    protected:
    /// The operator which decayed into this Suboperator.
@@ -0,0 +1,74 @@
+#include "algebra/suboperators/TopKThresholdSubop.h"
+#include "algebra/CompilationContext.h"
+#include "codegen/IRBuilder.h"
+#include "runtime/Runtime.h"
+#include <sstream>
+
+namespace inkfuse {
+
+const char* TopKThresholdState::name = "TopKThresholdState";
+
+void TopKThresholdSubop::registerRuntime() {
+   RuntimeStructBuilder{TopKThresholdState::name}
+      .addMember("threshold", IR::Pointer::build(IR::Void::build()));
+}
+
+SuboperatorArc TopKThresholdSubop::build(const RelAlgOp* source_, const IU& key_, const IU& out_, bool ascending_, TopKState* state_init_) {
+   return SuboperatorArc{new TopKThresholdSubop(source_, key_, out_, ascending_, state_init_)};
+}
+
+TopKThresholdSubop::TopKThresholdSubop(const RelAlgOp* source_, const IU& key_, const IU& out_, bool ascending_, TopKState* state_init_)
+   : TemplatedSuboperator<TopKThresholdState>(source_, {&out_}, {&key_}), ascending(ascending_), state_init(state_init_) {
+}
+
+void TopKThresholdSubop::setUpStateImpl(const ExecutionContext& context) {
+   assert(state_init);
+   state_init->prepare(context.getNumThreads());
+   for (size_t thread_id = 0; thread_id < context.getNumThreads(); ++thread_id) {
+      (*states)[thread_id].threshold = &state_init->topk.getHeap(thread_id).threshold;
+   }
+}
+
+void TopKThresholdSubop::consumeAllChildren(CompilationContext& context) {
+   auto& builder = context.getFctBuilder();
+   const auto& program = context.getProgram();
+   const IU& key = *source_ius[0];
+   const IU& out = *provided_ius[0];
+
+   // Resolve the typed threshold pointer once in the opening scope of the program.
+   // The value behind it changes while the heap fills up, so it is loaded for every row.
+   IR::Stmt* threshold_declare;
+   {
+      auto& root = builder.getRootBlock();
+      auto threshold_name = getVarIdentifier();
+      threshold_name << "_threshold";
+      auto declare = IR::DeclareStmt::build(threshold_name.str(), IR::Pointer::build(key.type));
+      auto state = IR::CastExpr::build(context.accessGlobalState(*this), IR::Pointer::build(program.getStruct(TopKThresholdState::name)));
+      auto threshold = IR::CastExpr::build(IR::StructAccessExpr::build(std::move(state), "threshold"), IR::Pointer::build(key.type));
+      auto assign = IR::AssignmentStmt::build(*declare, std::move(threshold));
+      threshold_declare = declare.get();
+      root.appendStmt(std::move(declare));
+      root.appendStmt(std::move(assign));
+   }
+
+   // Ties with the threshold have to pass, the remaining keys decide on them.
+   auto& declare = builder.appendStmt(IR::DeclareStmt::build(context.buildIUIdentifier(out), out.type));
+   context.declareIU(out, declare);
+   builder.appendStmt(
+      IR::AssignmentStmt::build(
+         declare,
+         IR::ArithmeticExpr::build(
+            IR::DerefExpr::build(IR::VarRefExpr::build(*threshold_declare)),
+            IR::VarRefExpr::build(context.getIUDeclaration(key)),
+            ascending ? IR::ArithmeticExpr::Opcode::GreaterEqual : IR::ArithmeticExpr::Opcode::LessEqual)));
+
+   context.notifyIUsReady(*this);
+}
+
+std::string TopKThresholdSubop::id() const {
+   std::stringstream str;
+   str << "topk_threshold_" << (ascending ? "asc" : "desc") << "_" << source_ius[0]->type->id();
+   return str.str();
+}
+
+}
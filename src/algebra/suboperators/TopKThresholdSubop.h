@@ -0,0 +1,43 @@
+#ifndef INKFUSE_TOPKTHRESHOLDSUBOP_H
+#define INKFUSE_TOPKTHRESHOLDSUBOP_H
+
+#include "algebra/suboperators/Suboperator.h"
+#include "exec/DeferredState.h"
+
+namespace inkfuse {
+
+/// Runtime state of a TopKThresholdSubop.
+struct TopKThresholdState {
+   static const char* name;
+
+   /// Pointer to the threshold of the thread-local TopKHeap.
+   void* threshold;
+};
+
+/// Threshold filter in front of a Top-K. Compares the first sort key against the threshold
+/// of the thread-local heap and produces a boolean IU that is true if the row can still make
+/// it into the heap. The threshold is re-read for every row, so the filter tightens as the
+/// heap fills up.
+struct TopKThresholdSubop : public TemplatedSuboperator<TopKThresholdState> {
+   static SuboperatorArc build(const RelAlgOp* source_, const IU& key_, const IU& out_, bool ascending_, TopKState* state_init_ = nullptr);
+
+   static void registerRuntime();
+
+   void setUpStateImpl(const ExecutionContext& context) override;
+
+   void consumeAllChildren(CompilationContext& context) override;
+
+   std::string id() const override;
+
+   private:
+   TopKThresholdSubop(const RelAlgOp* source_, const IU& key_, const IU& out_, bool ascending_, TopKState* state_init_);
+
+   /// Is the first sort key ascending?
+   bool ascending;
+   /// The Top-K state containing the heaps.
+   TopKState* state_init;
+};
+
+}
+
+#endif //INKFUSE_TOPKTHRESHOLDSUBOP_H
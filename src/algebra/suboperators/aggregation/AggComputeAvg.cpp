@@ -15,12 +15,24 @@ IR::StmtPtr AggComputeAvg::compute(IR::FunctionBuilder& builder, const std::vect
    const auto& count = *granule_ptrs[1];
    // Extract the sum.
    auto expr_sum_ptr = IR::CastExpr::build(IR::VarRefExpr::build(sum), IR::Pointer::build(type));
+   // Extract the count.
+   auto expr_count = IR::DerefExpr::build(IR::CastExpr::build(IR::VarRefExpr::build(count), IR::Pointer::build(IR::UnsignedInt::build(8))));
+   // Groups that only saw NULLs have a zero count. Their result is NULL, but the division
+   // must not trap on them. Clamp the divisor to one, the sum of such groups is zero.
+   auto expr_divisor = IR::ArithmeticExpr::build(std::move(expr_count), IR::ConstExpr::build(IR::UI<8>::build(1)), IR::ArithmeticExpr::Opcode::Max);
+   if (dynamic_cast<IR::Decimal*>(type.get())) {
+      // Decimal averages stay exact: scale the 16 byte sum up by AVG_EXTRA_SCALE digits and truncate.
+      auto scaled_sum = IR::ArithmeticExpr::build(
+         IR::DerefExpr::build(std::move(expr_sum_ptr)),
+         IR::ConstExpr::build(IR::DecimalVal::build(type, AVG_EXTRA_SCALE_FACTOR)),
+         IR::ArithmeticExpr::Opcode::Multiply);
+      auto result = IR::ArithmeticExpr::build(std::move(scaled_sum), IR::CastExpr::build(std::move(expr_divisor), type), IR::ArithmeticExpr::Opcode::Divide);
+      return IR::AssignmentStmt::build(IR::VarRefExpr::build(out_val), std::move(result));
+   }
    // Cast to double.
    auto expr_sum_casted = IR::CastExpr::build(IR::DerefExpr::build(std::move(expr_sum_ptr)), IR::Float::build(8));
-   // Extract the count.
-   auto expr_count_ptr = IR::DerefExpr::build(IR::CastExpr::build(IR::VarRefExpr::build(count), IR::Pointer::build(IR::UnsignedInt::build(8))));
    // Divide and assign.
-   auto result = IR::ArithmeticExpr::build(std::move(expr_sum_casted), std::move(expr_count_ptr), IR::ArithmeticExpr::Opcode::Divide);
+   auto result = IR::ArithmeticExpr::build(std::move(expr_sum_casted), std::move(expr_divisor), IR::ArithmeticExpr::Opcode::Divide);
    return IR::AssignmentStmt::build(IR::VarRefExpr::build(out_val), std::move(result));
 }
 
@@ -7,9 +7,15 @@ namespace inkfuse {
 
 /// Compute an average aggregation result. Takes two granules:
 /// first the sum over the target type and then an 8 byte count.
+/// The average is a double, except for decimal sums. These produce a
+/// 16 byte decimal with AVG_EXTRA_SCALE more fractional digits than the sum.
 struct AggComputeAvg : public AggCompute {
    AggComputeAvg(IR::TypeArc type_);
 
+   /// Additional fractional digits of decimal averages.
+   static constexpr size_t AVG_EXTRA_SCALE = 4;
+   static constexpr int64_t AVG_EXTRA_SCALE_FACTOR = 10'000;
+
    IR::StmtPtr compute(IR::FunctionBuilder& builder, const std::vector<IR::Stmt*>& granule_ptrs, const IR::Stmt& out_val) const override;
 
    size_t requiredGranules() const override { return 2; }
@@ -0,0 +1,24 @@
+#include "algebra/suboperators/aggregation/AggComputeHyperLogLog.h"
+#include "codegen/Expression.h"
+#include "codegen/IRBuilder.h"
+#include "runtime/Runtime.h"
+
+namespace inkfuse {
+
+AggComputeHyperLogLog::AggComputeHyperLogLog()
+   : AggCompute(IR::SignedInt::build(8)) {
+}
+
+IR::StmtPtr AggComputeHyperLogLog::compute(IR::FunctionBuilder& builder, const std::vector<IR::Stmt*>& granule_ptrs, const IR::Stmt& out_val) const {
+   assert(granule_ptrs.size() == 1);
+   std::vector<IR::ExprPtr> args;
+   args.push_back(IR::VarRefExpr::build(*granule_ptrs[0]));
+   const auto fct = global_runtime.program->getFunction("hll_estimate");
+   return IR::AssignmentStmt::build(IR::VarRefExpr::build(out_val), IR::InvokeFctExpr::build(*fct, std::move(args)));
+}
+
+std::string AggComputeHyperLogLog::id() const {
+   return "agg_compute_hll";
+}
+
+}
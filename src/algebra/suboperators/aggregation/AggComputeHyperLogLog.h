@@ -0,0 +1,20 @@
+#ifndef INKFUSE_AGGCOMPUTEHYPERLOGLOG_H
+#define INKFUSE_AGGCOMPUTEHYPERLOGLOG_H
+
+#include "algebra/suboperators/aggregation/AggCompute.h"
+
+namespace inkfuse {
+
+/// Compute the approximate distinct count from a HyperLogLog granule.
+/// Produces an 8 byte signed integer.
+struct AggComputeHyperLogLog : public AggCompute {
+   AggComputeHyperLogLog();
+
+   IR::StmtPtr compute(IR::FunctionBuilder& builder, const std::vector<IR::Stmt*>& granule_ptrs, const IR::Stmt& out_val) const override;
+
+   std::string id() const override;
+};
+
+}
+
+#endif //INKFUSE_AGGCOMPUTEHYPERLOGLOG_H
@@ -0,0 +1,44 @@
+#include "algebra/suboperators/aggregation/AggComputeQuantile.h"
+#include "codegen/Expression.h"
+#include "codegen/IRBuilder.h"
+#include "runtime/Runtime.h"
+
+namespace inkfuse {
+
+AggComputeMedian::AggComputeMedian()
+   : AggCompute(IR::Float::build(8)) {
+}
+
+IR::StmtPtr AggComputeMedian::compute(IR::FunctionBuilder& builder, const std::vector<IR::Stmt*>& granule_ptrs, const IR::Stmt& out_val) const {
+   assert(granule_ptrs.size() == 1);
+   std::vector<IR::ExprPtr> args;
+   args.push_back(IR::VarRefExpr::build(*granule_ptrs[0]));
+   const auto fct = global_runtime.program->getFunction("median_compute");
+   return IR::AssignmentStmt::build(IR::VarRefExpr::build(out_val), IR::InvokeFctExpr::build(*fct, std::move(args)));
+}
+
+std::string AggComputeMedian::id() const {
+   return "agg_compute_median";
+}
+
+AggComputeTDigest::AggComputeTDigest(uint8_t percentile_)
+   : AggCompute(IR::Float::build(8)), percentile(percentile_) {
+   if (percentile > 100) {
+      throw std::runtime_error("Quantile has to be between 0 and 100 percent");
+   }
+}
+
+IR::StmtPtr AggComputeTDigest::compute(IR::FunctionBuilder& builder, const std::vector<IR::Stmt*>& granule_ptrs, const IR::Stmt& out_val) const {
+   assert(granule_ptrs.size() == 1);
+   std::vector<IR::ExprPtr> args;
+   args.push_back(IR::VarRefExpr::build(*granule_ptrs[0]));
+   args.push_back(IR::ConstExpr::build(IR::F8::build(percentile / 100.0)));
+   const auto fct = global_runtime.program->getFunction("tdigest_quantile");
+   return IR::AssignmentStmt::build(IR::VarRefExpr::build(out_val), IR::InvokeFctExpr::build(*fct, std::move(args)));
+}
+
+std::string AggComputeTDigest::id() const {
+   return "agg_compute_tdigest_p" + std::to_string(percentile);
+}
+
+}
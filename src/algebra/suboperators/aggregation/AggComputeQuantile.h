@@ -0,0 +1,34 @@
+#ifndef INKFUSE_AGGCOMPUTEQUANTILE_H
+#define INKFUSE_AGGCOMPUTEQUANTILE_H
+
+#include "algebra/suboperators/aggregation/AggCompute.h"
+
+namespace inkfuse {
+
+/// Compute the exact median from an AggStateMedian granule. Produces an 8 byte float.
+struct AggComputeMedian : public AggCompute {
+   AggComputeMedian();
+
+   IR::StmtPtr compute(IR::FunctionBuilder& builder, const std::vector<IR::Stmt*>& granule_ptrs, const IR::Stmt& out_val) const override;
+
+   std::string id() const override;
+};
+
+/// Estimate a quantile from an AggStateTDigest granule. Produces an 8 byte float.
+/// The quantile is a whole percentile that is baked into the code, so that the
+/// interpreter can provide a fragment for every supported quantile.
+struct AggComputeTDigest : public AggCompute {
+   AggComputeTDigest(uint8_t percentile_);
+
+   IR::StmtPtr compute(IR::FunctionBuilder& builder, const std::vector<IR::Stmt*>& granule_ptrs, const IR::Stmt& out_val) const override;
+
+   std::string id() const override;
+
+   private:
+   /// The estimated quantile in percent.
+   uint8_t percentile;
+};
+
+}
+
+#endif //INKFUSE_AGGCOMPUTEQUANTILE_H
@@ -4,5 +4,9 @@ namespace inkfuse {
 
 AggState::AggState(IR::TypeArc type_): type(std::move(type_)) {}
 
+void AggState::updateStateNullable(IR::FunctionBuilder& builder, const IR::Stmt& ptr, const IR::Stmt& val, const IR::Stmt& null) const {
+   throw std::runtime_error(id() + " does not support nullable inputs.");
+}
+
 }
 
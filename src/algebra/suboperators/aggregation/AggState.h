@@ -32,6 +32,10 @@ struct AggState {
    /// Update the aggregate state.
    virtual void updateState(IR::FunctionBuilder& builder, const IR::Stmt& ptr, const IR::Stmt& val) const = 0;
 
+   /// Update the aggregate state with a nullable value. `null` is the Bool NULL indicator of the value,
+   /// rows where it is set must not change the state.
+   virtual void updateStateNullable(IR::FunctionBuilder& builder, const IR::Stmt& ptr, const IR::Stmt& val, const IR::Stmt& null) const;
+
    /// Get the size of the backing aggregate state.
    virtual size_t getStateSize() const = 0;
 
@@ -19,6 +19,17 @@ void AggStateCount::updateState(IR::FunctionBuilder& builder, const IR::Stmt& pt
    builder.appendStmt(IR::AssignmentStmt::build(IR::DerefExpr::build(std::move(casted_ptr_expr_assign)), std::move(new_val)));
 }
 
+void AggStateCount::updateStateNullable(IR::FunctionBuilder& builder, const IR::Stmt& ptr, const IR::Stmt&, const IR::Stmt& null) const {
+   // Branch-free NULL skipping: *ptr = (*ptr + 1) - (I8) null.
+   auto casted_ptr_expr_curr = IR::CastExpr::build(IR::VarRefExpr::build(ptr), IR::Pointer::build(IR::SignedInt::build(8)));
+   auto casted_ptr_expr_assign = IR::CastExpr::build(IR::VarRefExpr::build(ptr), IR::Pointer::build(IR::SignedInt::build(8)));
+   auto incremented = IR::ArithmeticExpr::build(
+      IR::ConstExpr::build(IR::SI<8>::build(1)), IR::DerefExpr::build(std::move(casted_ptr_expr_curr)), IR::ArithmeticExpr::Opcode::Add);
+   auto new_val = IR::ArithmeticExpr::build(
+      std::move(incremented), IR::CastExpr::build(IR::VarRefExpr::build(null), IR::SignedInt::build(8)), IR::ArithmeticExpr::Opcode::Subtract);
+   builder.appendStmt(IR::AssignmentStmt::build(IR::DerefExpr::build(std::move(casted_ptr_expr_assign)), std::move(new_val)));
+}
+
 size_t AggStateCount::getStateSize() const {
    return 8;
 }
@@ -0,0 +1,55 @@
+#include "algebra/suboperators/aggregation/AggStateHyperLogLog.h"
+#include "codegen/IRBuilder.h"
+#include "codegen/Statement.h"
+#include "runtime/HyperLogLog.h"
+#include "runtime/Runtime.h"
+
+namespace inkfuse {
+
+AggStateHyperLogLog::AggStateHyperLogLog(IR::TypeArc type_)
+   : ZeroInitializedAggState(std::move(type_)) {
+   if (!dynamic_cast<IR::String*>(type.get()) && type->numBytes() > 8) {
+      throw std::runtime_error("HyperLogLog aggregate not supported on type " + type->id());
+   }
+}
+
+void AggStateHyperLogLog::updateState(IR::FunctionBuilder& builder, const IR::Stmt& ptr, const IR::Stmt& val) const {
+   std::vector<IR::ExprPtr> args;
+   args.push_back(IR::VarRefExpr::build(ptr));
+   std::string fct_name;
+   if (dynamic_cast<IR::String*>(type.get())) {
+      fct_name = "hll_add_str";
+      args.push_back(IR::VarRefExpr::build(val));
+   } else {
+      // Reinterpret the value as an unsigned integer of the same width. A value cast would
+      // put floats with the same integer part into the same bucket.
+      fct_name = "hll_add_bits";
+      auto bits_ptr = IR::CastExpr::build(IR::RefExpr::build(IR::VarRefExpr::build(val)), IR::Pointer::build(IR::UnsignedInt::build(type->numBytes())));
+      args.push_back(IR::CastExpr::build(IR::DerefExpr::build(std::move(bits_ptr)), IR::UnsignedInt::build(8)));
+   }
+   const auto fct = global_runtime.program->getFunction(fct_name);
+   builder.appendStmt(IR::InvokeFctStmt::build(IR::InvokeFctExpr::build(*fct, std::move(args))));
+}
+
+void AggStateHyperLogLog::updateStateNullable(IR::FunctionBuilder& builder, const IR::Stmt& ptr, const IR::Stmt& val, const IR::Stmt& null) const {
+   // NULL values are not counted.
+   auto is_valid = IR::ArithmeticExpr::build(
+      IR::CastExpr::build(IR::VarRefExpr::build(null), IR::UnsignedInt::build(1)),
+      IR::ConstExpr::build(IR::UI<1>::build(0)),
+      IR::ArithmeticExpr::Opcode::Eq);
+   auto if_valid = builder.buildIf(std::move(is_valid));
+   {
+      updateState(builder, ptr, val);
+   }
+   if_valid.End();
+}
+
+size_t AggStateHyperLogLog::getStateSize() const {
+   return HyperLogLog::num_registers;
+}
+
+std::string AggStateHyperLogLog::id() const {
+   return "agg_state_hll_" + type->id();
+}
+
+}
@@ -0,0 +1,25 @@
+#ifndef INKFUSE_AGGSTATEHYPERLOGLOG_H
+#define INKFUSE_AGGSTATEHYPERLOGLOG_H
+
+#include "algebra/suboperators/aggregation/AggState.h"
+
+namespace inkfuse {
+
+/// HyperLogLog sketch state for approximate distinct counts, see runtime/HyperLogLog.h.
+/// The registers live directly in the aggregate payload and start out zero-initialized.
+/// Numbers and dates are added through their bit pattern, strings through their contents.
+struct AggStateHyperLogLog : public ZeroInitializedAggState {
+   AggStateHyperLogLog(IR::TypeArc type_);
+
+   void updateState(IR::FunctionBuilder& builder, const IR::Stmt& ptr, const IR::Stmt& val) const override;
+
+   void updateStateNullable(IR::FunctionBuilder& builder, const IR::Stmt& ptr, const IR::Stmt& val, const IR::Stmt& null) const override;
+
+   size_t getStateSize() const override;
+
+   std::string id() const override;
+};
+
+}
+
+#endif //INKFUSE_AGGSTATEHYPERLOGLOG_H
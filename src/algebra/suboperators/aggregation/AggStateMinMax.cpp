@@ -0,0 +1,80 @@
+#include "algebra/suboperators/aggregation/AggStateMinMax.h"
+#include "algebra/CompilationContext.h"
+#include "codegen/Statement.h"
+
+namespace inkfuse {
+
+namespace {
+
+/// Pointer to the initialized flag of the state.
+IR::ExprPtr flagPtr(const IR::Stmt& ptr, const IR::Type& type) {
+   auto flag_loc = IR::ArithmeticExpr::build(
+      IR::VarRefExpr::build(ptr), IR::ConstExpr::build(IR::UI<2>::build(AggStateMinMax::flagOffset(type))), IR::ArithmeticExpr::Opcode::Add);
+   return IR::CastExpr::build(std::move(flag_loc), IR::Pointer::build(IR::UnsignedInt::build(1)));
+}
+
+}
+
+AggStateMinMax::AggStateMinMax(IR::TypeArc type_, bool is_min_)
+   : AggState(std::move(type_)), is_min(is_min_) {
+   if (!dynamic_cast<IR::SignedInt*>(type.get()) && !dynamic_cast<IR::UnsignedInt*>(type.get()) && !dynamic_cast<IR::Float*>(type.get()) && !dynamic_cast<IR::Date*>(type.get()) && !dynamic_cast<IR::Decimal*>(type.get()) && !dynamic_cast<IR::String*>(type.get())) {
+      throw std::runtime_error("Min/max aggregate not supported on type " + type->id());
+   }
+}
+
+void AggStateMinMax::initState(IR::FunctionBuilder& builder, const IR::Stmt& ptr, const IR::Stmt& val) const {
+   // Materialize the first value and mark the state as initialized.
+   auto casted_ptr_expr = IR::CastExpr::build(IR::VarRefExpr::build(ptr), IR::Pointer::build(type));
+   builder.appendStmt(IR::AssignmentStmt::build(IR::DerefExpr::build(std::move(casted_ptr_expr)), IR::VarRefExpr::build(val)));
+   builder.appendStmt(IR::AssignmentStmt::build(IR::DerefExpr::build(flagPtr(ptr, *type)), IR::ConstExpr::build(IR::UI<1>::build(1))));
+}
+
+void AggStateMinMax::updateState(IR::FunctionBuilder& builder, const IR::Stmt& ptr, const IR::Stmt& val) const {
+   // Only the first row of every group takes the else branch, making it well predictable.
+   auto if_initialized = builder.buildIf(IR::DerefExpr::build(flagPtr(ptr, *type)));
+   {
+      // Branch-free compare and swap: *ptr = min(*ptr, val).
+      auto casted_ptr_expr_curr = IR::CastExpr::build(IR::VarRefExpr::build(ptr), IR::Pointer::build(type));
+      auto casted_ptr_expr_assign = IR::CastExpr::build(IR::VarRefExpr::build(ptr), IR::Pointer::build(type));
+      auto new_val = IR::ArithmeticExpr::build(
+         IR::DerefExpr::build(std::move(casted_ptr_expr_curr)),
+         IR::VarRefExpr::build(val),
+         is_min ? IR::ArithmeticExpr::Opcode::Min : IR::ArithmeticExpr::Opcode::Max);
+      builder.appendStmt(IR::AssignmentStmt::build(IR::DerefExpr::build(std::move(casted_ptr_expr_assign)), std::move(new_val)));
+   }
+   if_initialized.Else();
+   {
+      initState(builder, ptr, val);
+   }
+   if_initialized.End();
+}
+
+void AggStateMinMax::updateStateNullable(IR::FunctionBuilder& builder, const IR::Stmt& ptr, const IR::Stmt& val, const IR::Stmt& null) const {
+   // NULL values must neither initialize nor change the state.
+   auto is_valid = IR::ArithmeticExpr::build(
+      IR::CastExpr::build(IR::VarRefExpr::build(null), IR::UnsignedInt::build(1)),
+      IR::ConstExpr::build(IR::UI<1>::build(0)),
+      IR::ArithmeticExpr::Opcode::Eq);
+   auto if_valid = builder.buildIf(std::move(is_valid));
+   {
+      updateState(builder, ptr, val);
+   }
+   if_valid.End();
+}
+
+size_t AggStateMinMax::getStateSize() const {
+   // Value followed by the padded initialized flag.
+   return 2 * type->numBytes();
+}
+
+std::string AggStateMinMax::id() const {
+   return std::string{is_min ? "agg_state_min_" : "agg_state_max_"} + type->id();
+}
+
+AggStateMin::AggStateMin(IR::TypeArc type_) : AggStateMinMax(std::move(type_), true) {
+}
+
+AggStateMax::AggStateMax(IR::TypeArc type_) : AggStateMinMax(std::move(type_), false) {
+}
+
+}
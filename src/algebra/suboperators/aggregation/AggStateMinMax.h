@@ -0,0 +1,51 @@
+#ifndef INKFUSE_AGGSTATEMINMAX_H
+#define INKFUSE_AGGSTATEMINMAX_H
+
+#include "algebra/suboperators/aggregation/AggState.h"
+
+namespace inkfuse {
+
+/// Shared state logic for min and max aggregates over numbers, dates and strings.
+/// A zero-initialized state cannot be told apart from a real value, so the state
+/// is laid out as [value | initialized flag]. The flag is padded to the width of the
+/// value to keep the next granule aligned.
+/// The first value of a group is materialized through initState, successive values
+/// are folded in with a branch-free select.
+/// Groups that only saw NULL values keep an uninitialized state. Their result is NULL through
+/// the count of non-NULL inputs the registry adds for nullable inputs.
+struct AggStateMinMax : public AggState {
+   bool needsStateInit() const override { return true; };
+
+   void initState(IR::FunctionBuilder& builder, const IR::Stmt& ptr, const IR::Stmt& val) const override;
+
+   void updateState(IR::FunctionBuilder& builder, const IR::Stmt& ptr, const IR::Stmt& val) const override;
+
+   void updateStateNullable(IR::FunctionBuilder& builder, const IR::Stmt& ptr, const IR::Stmt& val, const IR::Stmt& null) const override;
+
+   size_t getStateSize() const override;
+
+   std::string id() const override;
+
+   /// Offset of the initialized flag within the state.
+   static size_t flagOffset(const IR::Type& type) { return type.numBytes(); };
+
+   protected:
+   AggStateMinMax(IR::TypeArc type_, bool is_min_);
+
+   /// Is this a min or a max aggregate?
+   bool is_min;
+};
+
+/// Min state for aggregates, same return type as the type being aggregated.
+struct AggStateMin : public AggStateMinMax {
+   AggStateMin(IR::TypeArc type_);
+};
+
+/// Max state for aggregates, same return type as the type being aggregated.
+struct AggStateMax : public AggStateMinMax {
+   AggStateMax(IR::TypeArc type_);
+};
+
+}
+
+#endif //INKFUSE_AGGSTATEMINMAX_H
@@ -0,0 +1,61 @@
+#include "algebra/suboperators/aggregation/AggStateQuantile.h"
+#include "codegen/IRBuilder.h"
+#include "codegen/Statement.h"
+#include "runtime/Quantiles.h"
+#include "runtime/Runtime.h"
+
+namespace inkfuse {
+
+AggStateQuantile::AggStateQuantile(IR::TypeArc type_, std::string add_fct_)
+   : ZeroInitializedAggState(std::move(type_)), add_fct(std::move(add_fct_)) {
+   if (!dynamic_cast<IR::SignedInt*>(type.get()) && !dynamic_cast<IR::UnsignedInt*>(type.get()) && !dynamic_cast<IR::Float*>(type.get())) {
+      throw std::runtime_error("Quantile aggregate not supported on type " + type->id());
+   }
+}
+
+void AggStateQuantile::updateState(IR::FunctionBuilder& builder, const IR::Stmt& ptr, const IR::Stmt& val) const {
+   std::vector<IR::ExprPtr> args;
+   args.push_back(IR::VarRefExpr::build(ptr));
+   args.push_back(IR::CastExpr::build(IR::VarRefExpr::build(val), IR::Float::build(8)));
+   const auto fct = global_runtime.program->getFunction(add_fct);
+   builder.appendStmt(IR::InvokeFctStmt::build(IR::InvokeFctExpr::build(*fct, std::move(args))));
+}
+
+void AggStateQuantile::updateStateNullable(IR::FunctionBuilder& builder, const IR::Stmt& ptr, const IR::Stmt& val, const IR::Stmt& null) const {
+   // NULL values are ignored.
+   auto is_valid = IR::ArithmeticExpr::build(
+      IR::CastExpr::build(IR::VarRefExpr::build(null), IR::UnsignedInt::build(1)),
+      IR::ConstExpr::build(IR::UI<1>::build(0)),
+      IR::ArithmeticExpr::Opcode::Eq);
+   auto if_valid = builder.buildIf(std::move(is_valid));
+   {
+      updateState(builder, ptr, val);
+   }
+   if_valid.End();
+}
+
+AggStateMedian::AggStateMedian(IR::TypeArc type_)
+   : AggStateQuantile(std::move(type_), "median_add") {
+}
+
+size_t AggStateMedian::getStateSize() const {
+   return ExactQuantile::state_size;
+}
+
+std::string AggStateMedian::id() const {
+   return "agg_state_median_" + type->id();
+}
+
+AggStateTDigest::AggStateTDigest(IR::TypeArc type_)
+   : AggStateQuantile(std::move(type_), "tdigest_add") {
+}
+
+size_t AggStateTDigest::getStateSize() const {
+   return TDigest::state_size;
+}
+
+std::string AggStateTDigest::id() const {
+   return "agg_state_tdigest_" + type->id();
+}
+
+}
@@ -0,0 +1,43 @@
+#ifndef INKFUSE_AGGSTATEQUANTILE_H
+#define INKFUSE_AGGSTATEQUANTILE_H
+
+#include "algebra/suboperators/aggregation/AggState.h"
+
+namespace inkfuse {
+
+/// Shared state logic for quantile aggregates over integers and floating points, see runtime/Quantiles.h.
+/// Values are converted to doubles and handed to an extern runtime function that updates the
+/// zero-initialized state.
+struct AggStateQuantile : public ZeroInitializedAggState {
+   void updateState(IR::FunctionBuilder& builder, const IR::Stmt& ptr, const IR::Stmt& val) const override;
+
+   void updateStateNullable(IR::FunctionBuilder& builder, const IR::Stmt& ptr, const IR::Stmt& val, const IR::Stmt& null) const override;
+
+   protected:
+   AggStateQuantile(IR::TypeArc type_, std::string add_fct_);
+
+   /// Runtime function adding a value to the state.
+   std::string add_fct;
+};
+
+/// Exact median state. A pointer to the out-of-line values of the group.
+struct AggStateMedian : public AggStateQuantile {
+   AggStateMedian(IR::TypeArc type_);
+
+   size_t getStateSize() const override;
+
+   std::string id() const override;
+};
+
+/// Approximate quantile state. A fixed-size t-digest within the aggregate payload.
+struct AggStateTDigest : public AggStateQuantile {
+   AggStateTDigest(IR::TypeArc type_);
+
+   size_t getStateSize() const override;
+
+   std::string id() const override;
+};
+
+}
+
+#endif //INKFUSE_AGGSTATEQUANTILE_H
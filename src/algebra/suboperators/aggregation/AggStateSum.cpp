@@ -4,14 +4,14 @@
 
 namespace inkfuse {
 
-AggStateSum::AggStateSum(IR::TypeArc type_)
-   : ZeroInitializedAggState(std::move(type_)) {
+AggStateSum::AggStateSum(IR::TypeArc type_, IR::TypeArc state_type_)
+   : ZeroInitializedAggState(std::move(type_)), state_type(state_type_ ? std::move(state_type_) : type) {
 }
 
 void AggStateSum::updateState(IR::FunctionBuilder& builder, const IR::Stmt& ptr, const IR::Stmt& val) const {
    // Fetch the current sum state.
-   auto casted_ptr_expr_curr = IR::CastExpr::build(IR::VarRefExpr::build(ptr), IR::Pointer::build(type));
-   auto casted_ptr_expr_assign = IR::CastExpr::build(IR::VarRefExpr::build(ptr), IR::Pointer::build(type));
+   auto casted_ptr_expr_curr = IR::CastExpr::build(IR::VarRefExpr::build(ptr), IR::Pointer::build(state_type));
+   auto casted_ptr_expr_assign = IR::CastExpr::build(IR::VarRefExpr::build(ptr), IR::Pointer::build(state_type));
    // Get the thing we want to add.
    auto val_expr = IR::VarRefExpr::build(val);
    // Add them up.
@@ -21,12 +21,30 @@ void AggStateSum::updateState(IR::FunctionBuilder& builder, const IR::Stmt& ptr,
    builder.appendStmt(IR::AssignmentStmt::build(IR::DerefExpr::build(std::move(casted_ptr_expr_assign)), std::move(new_val)));
 }
 
+void AggStateSum::updateStateNullable(IR::FunctionBuilder& builder, const IR::Stmt& ptr, const IR::Stmt& val, const IR::Stmt& null) const {
+   // Branch-free NULL skipping: *ptr = *ptr + val * (T)((UI1) null == 0).
+   auto casted_ptr_expr_curr = IR::CastExpr::build(IR::VarRefExpr::build(ptr), IR::Pointer::build(state_type));
+   auto casted_ptr_expr_assign = IR::CastExpr::build(IR::VarRefExpr::build(ptr), IR::Pointer::build(state_type));
+   auto is_valid = IR::ArithmeticExpr::build(
+      IR::CastExpr::build(IR::VarRefExpr::build(null), IR::UnsignedInt::build(1)),
+      IR::ConstExpr::build(IR::UI<1>::build(0)),
+      IR::ArithmeticExpr::Opcode::Eq);
+   auto masked_val = IR::ArithmeticExpr::build(
+      IR::VarRefExpr::build(val), IR::CastExpr::build(std::move(is_valid), state_type), IR::ArithmeticExpr::Opcode::Multiply);
+   auto new_val = IR::ArithmeticExpr::build(
+      std::move(masked_val), IR::DerefExpr::build(std::move(casted_ptr_expr_curr)), IR::ArithmeticExpr::Opcode::Add);
+   builder.appendStmt(IR::AssignmentStmt::build(IR::DerefExpr::build(std::move(casted_ptr_expr_assign)), std::move(new_val)));
+}
+
 size_t AggStateSum::getStateSize() const {
-   // Aggregate state of sum matches the type being summed.
-   return type->numBytes();
+   // Aggregate state of sum matches the state type.
+   return state_type->numBytes();
 }
 
 std::string AggStateSum::id() const {
+   if (state_type->id() != type->id()) {
+      return "agg_state_sum_" + type->id() + "_" + state_type->id();
+   }
    return "agg_state_sum_" + type->id();
 }
 
@@ -5,17 +5,28 @@
 
 namespace inkfuse {
 
-/// Sum state for aggregates, same return type as the type being
+/// Sum state for aggregates, by default the same return type as the type being
 /// aggregated. Starts out with zero-initialized memory.
 struct AggStateSum : public ZeroInitializedAggState {
 
-   AggStateSum(IR::TypeArc type_);
+   /// Sum values of `type_`. The state can be wider than the aggregated type
+   /// (e.g. 16 byte sums over 8 byte decimals), defaults to `type_`.
+   AggStateSum(IR::TypeArc type_, IR::TypeArc state_type_ = nullptr);
 
    void updateState(IR::FunctionBuilder& builder, const IR::Stmt& ptr, const IR::Stmt& val) const override;
 
+   void updateStateNullable(IR::FunctionBuilder& builder, const IR::Stmt& ptr, const IR::Stmt& val, const IR::Stmt& null) const override;
+
    size_t getStateSize() const override;
 
    std::string id() const override;
+
+   /// Get the type of the running sum.
+   const IR::TypeArc& getStateType() const { return state_type; }
+
+   private:
+   /// Type of the running sum.
+   IR::TypeArc state_type;
 };
 
 }
@@ -9,9 +9,16 @@ SuboperatorArc AggregatorSubop::build(const RelAlgOp* source_, const AggState& a
 
 AggregatorSubop::AggregatorSubop(const RelAlgOp* source_, const AggState& agg_state_, const IU& ptr_iu, const IU& agg_iu)
    : TemplatedSuboperator<KeyPackingRuntimeState>(source_, {}, {&ptr_iu, &agg_iu}), agg_state(agg_state_) {
+   if (agg_iu.null_indicator) {
+      // Nullable inputs also depend on the NULL indicator.
+      source_ius.push_back(agg_iu.null_indicator);
+   }
 }
 
 std::string AggregatorSubop::id() const {
+   if (source_ius.size() == 3) {
+      return agg_state.id() + "_nullable";
+   }
    return agg_state.id();
 }
 
@@ -55,7 +62,12 @@ void AggregatorSubop::consumeAllChildren(CompilationContext& context) {
    builder.appendStmt(IR::AssignmentStmt::build(ptr_declare, std::move(ptr_loc)));
 
    // Call the group update logic.
-   agg_state.updateState(builder, ptr_declare, agg_iu_stmt);
+   if (source_ius.size() == 3) {
+      auto& null_stmt = context.getIUDeclaration(*source_ius[2]);
+      agg_state.updateStateNullable(builder, ptr_declare, agg_iu_stmt, null_stmt);
+   } else {
+      agg_state.updateState(builder, ptr_declare, agg_iu_stmt);
+   }
 }
 
 }
@@ -22,6 +22,7 @@ const std::unordered_map<Type, std::string> expr_names{
    {Type::StrEquals, "streq"},
    {Type::InList, "string_in"},
    {Type::NotLikeTokens, "string_like"},
+   {Type::Like, "string_like_pattern"},
 };
 
 /// Map from algebra expression types to IR expressions in the jitted code.
@@ -40,7 +41,16 @@ const std::unordered_map<Type, IR::ArithmeticExpr::Opcode> code_map{
    {Type::Neq, IR::ArithmeticExpr::Opcode::Neq},
    {Type::StrEquals, IR::ArithmeticExpr::Opcode::StrEquals},
    {Type::InList, IR::ArithmeticExpr::Opcode::StrInList},
-   {Type::NotLikeTokens, IR::ArithmeticExpr::Opcode::NotLikeTokens}};
+   {Type::NotLikeTokens, IR::ArithmeticExpr::Opcode::NotLikeTokens},
+   {Type::Like, IR::ArithmeticExpr::Opcode::StrLike}};
+
+IR::ExprPtr buildOperand(const IR::Stmt& operand, const IR::Type& operand_type, const IR::TypeArc& out) {
+   auto expr = IR::VarRefExpr::build(operand);
+   if (dynamic_cast<const IR::Decimal*>(out.get()) && operand_type.numBytes() < out->numBytes()) {
+      return IR::CastExpr::build(std::move(expr), out);
+   }
+   return expr;
+}
 }
 
 }
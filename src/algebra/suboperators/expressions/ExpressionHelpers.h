@@ -18,6 +18,10 @@ extern const std::unordered_map<Type, std::string> expr_names;
 /// Map from algebra expression types to IR expressions in the jitted code.
 extern const std::unordered_map<Type, IR::ArithmeticExpr::Opcode> code_map;
 
+/// Build the operand of an arithmetic expression producing `out`. Decimal results can be wider than
+/// their operands, the operands are widened first so that the computation can't overflow.
+IR::ExprPtr buildOperand(const IR::Stmt& operand, const IR::Type& operand_type, const IR::TypeArc& out);
+
 }
 
 }
@@ -52,8 +52,8 @@ void ExpressionSubop::consumeAllChildren(CompilationContext& context) {
          IR::AssignmentStmt::build(
             declare,
             IR::ArithmeticExpr::build(
-               IR::VarRefExpr::build(*children[0]),
-               IR::VarRefExpr::build(*children[1]),
+               ExpressionHelpers::buildOperand(*children[0], *source_ius[0]->type, out->type),
+               ExpressionHelpers::buildOperand(*children[1], *source_ius[1]->type, out->type),
                ExpressionHelpers::code_map.at(type))));
    }
    context.notifyIUsReady(*this);
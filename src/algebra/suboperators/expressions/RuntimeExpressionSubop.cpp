@@ -73,8 +73,8 @@ void RuntimeExpressionSubop::consumeAllChildren(CompilationContext& context) {
          IR::AssignmentStmt::build(
             declare,
             IR::ArithmeticExpr::build(
-               IR::VarRefExpr::build(*rt_c_declare),
-               IR::VarRefExpr::build(child),
+               ExpressionHelpers::buildOperand(*rt_c_declare, *runtime_param_type, out->type),
+               ExpressionHelpers::buildOperand(child, *source_ius[0]->type, out->type),
                ExpressionHelpers::code_map.at(type))));
    }
 
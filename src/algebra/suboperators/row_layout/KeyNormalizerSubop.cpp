@@ -0,0 +1,58 @@
+#include "algebra/suboperators/row_layout/KeyNormalizerSubop.h"
+#include "algebra/CompilationContext.h"
+#include "codegen/Statement.h"
+#include "runtime/Runtime.h"
+#include <sstream>
+
+namespace inkfuse {
+
+SuboperatorArc KeyNormalizerSubop::build(const RelAlgOp* source_, const IU& key_, const IU& null_indicator_, const IU& normalized_) {
+   return std::shared_ptr<KeyNormalizerSubop>(new KeyNormalizerSubop{source_, key_, null_indicator_, normalized_});
+}
+
+KeyNormalizerSubop::KeyNormalizerSubop(const RelAlgOp* source_, const IU& key_, const IU& null_indicator_, const IU& normalized_)
+   : TemplatedSuboperator<EmptyState>(source_, {&normalized_}, {&key_, &null_indicator_}) {
+   if (key_.type->id() != normalized_.type->id()) {
+      throw std::runtime_error("KeyNormalizerSubop has to produce the type of the key.");
+   }
+}
+
+void KeyNormalizerSubop::consumeAllChildren(CompilationContext& context) {
+   auto& builder = context.getFctBuilder();
+   const IU& out = *provided_ius[0];
+
+   // Declare the output IU.
+   auto iu_name = context.buildIUIdentifier(out);
+   auto& declare = builder.appendStmt(IR::DeclareStmt::build(iu_name, out.type));
+   context.declareIU(out, declare);
+
+   const IR::Stmt& key = context.getIUDeclaration(*source_ius[0]);
+   const IR::Stmt& null = context.getIUDeclaration(*source_ius[1]);
+
+   // Valid rows keep their key.
+   builder.appendStmt(IR::AssignmentStmt::build(declare, IR::VarRefExpr::build(key)));
+   // NULL rows get the zero value of the key type.
+   IR::ExprPtr zero;
+   if (dynamic_cast<IR::String*>(out.type.get())) {
+      // The empty string lives in the runtime, the key can outlive the generated code.
+      const auto fct = global_runtime.program->getFunction("inkfuse_empty_string");
+      zero = IR::InvokeFctExpr::build(*fct, {});
+   } else {
+      zero = IR::CastExpr::build(IR::ConstExpr::build(IR::UI<1>::build(0)), out.type);
+   }
+   auto if_null = builder.buildIf(IR::VarRefExpr::build(null));
+   {
+      builder.appendStmt(IR::AssignmentStmt::build(declare, std::move(zero)));
+   }
+   if_null.End();
+
+   context.notifyIUsReady(*this);
+}
+
+std::string KeyNormalizerSubop::id() const {
+   std::stringstream res;
+   res << "key_normalizer_" << source_ius[0]->type->id();
+   return res.str();
+}
+
+}
@@ -0,0 +1,24 @@
+#ifndef INKFUSE_KEYNORMALIZERSUBOP_H
+#define INKFUSE_KEYNORMALIZERSUBOP_H
+
+#include "algebra/suboperators/Suboperator.h"
+
+namespace inkfuse {
+
+/// The key normalizer prepares a nullable key for packing. NULL rows are replaced with
+/// the zero value of the key type (the empty string for strings), so that all NULL
+/// rows pack into the same key.
+struct KeyNormalizerSubop : public TemplatedSuboperator<EmptyState> {
+   static SuboperatorArc build(const RelAlgOp* source_, const IU& key_, const IU& null_indicator_, const IU& normalized_);
+
+   void consumeAllChildren(CompilationContext& context) override;
+
+   std::string id() const override;
+
+   private:
+   KeyNormalizerSubop(const RelAlgOp* source_, const IU& key_, const IU& null_indicator_, const IU& normalized_);
+};
+
+}
+
+#endif //INKFUSE_KEYNORMALIZERSUBOP_H
@@ -62,7 +62,8 @@ void CountingSink::registerRuntime() {
 }
 
 void CountingSink::tearDownStateImpl() {
-   if (callback) {
+   // Suboperators of pipelines that never ran don't have any state.
+   if (callback && states) {
       callback(getCount());
    }
 }
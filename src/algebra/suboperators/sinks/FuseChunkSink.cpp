@@ -1,5 +1,7 @@
 #include "algebra/suboperators/sinks/FuseChunkSink.h"
 #include "algebra/CompilationContext.h"
+#include "algebra/Pipeline.h"
+#include "algebra/suboperators/ColumnFilter.h"
 #include "exec/ExecutionContext.h"
 #include "runtime/Runtime.h"
 
@@ -9,7 +11,7 @@ const char* FuseChunkSinkState::name = "FuseChunkSinkState";
 
 void FuseChunkSink::registerRuntime() {
    RuntimeStructBuilder(FuseChunkSinkState::name)
-      .addMember("start", IR::Pointer::build(IR::Void::build()))
+      .addMember("start", IR::Pointer::build(IR::Pointer::build(IR::Void::build())))
       .addMember("size", IR::Pointer::build(IR::UnsignedInt::build(8)));
 }
 
@@ -47,11 +49,11 @@ void FuseChunkSink::consume(const IU& iu, CompilationContext& context) {
       auto target_ptr_type = IR::Pointer::build(iu.type);
       auto decl_data = IR::DeclareStmt::build(data_var_name.str(), target_ptr_type);
       decl_data_ptr = decl_data.get();
-      // And assign the casted raw pointer.
+      // And assign the casted raw pointer the state points to.
       auto assign_data = IR::AssignmentStmt::build(
          *decl_data,
          IR::CastExpr::build(
-            IR::StructAccessExpr::build(std::move(data_cast_expr), "start"),
+            IR::DerefExpr::build(IR::StructAccessExpr::build(std::move(data_cast_expr), "start")),
             target_ptr_type));
       // Build the size variable.
       auto size_var_name = getVarIdentifier();
@@ -121,12 +123,19 @@ void FuseChunkSink::consume(const IU& iu, CompilationContext& context) {
       builder.appendStmt(std::move(assign));
    }
 
-   // And update the size counter.
+   // And update the size counter. Rows of a branch-free filter are always written, but the
+   // counter only moves past the qualifying ones.
+   IR::ExprPtr increment = IR::ConstExpr::build(IR::UI<8>::build(1));
+   auto filter = dynamic_cast<const ColumnFilterLogic*>(context.getPipeline().tryGetProvider(iu));
+   if (const IU* predicate = filter ? filter->getPredicate(context.getPipeline()) : nullptr) {
+      assert(!is_variable_size_type);
+      increment = IR::CastExpr::build(IR::VarRefExpr::build(context.getIUDeclaration(*predicate)), IR::UnsignedInt::build(8));
+   }
    auto update_counter = IR::AssignmentStmt::build(
       IR::DerefExpr::build(IR::VarRefExpr::build(*decl_size_ptr)),
       IR::ArithmeticExpr::build(
          IR::DerefExpr::build(IR::VarRefExpr::build(*decl_size_ptr)),
-         IR::ConstExpr::build(IR::UI<8>::build(1)),
+         std::move(increment),
          IR::ArithmeticExpr::Opcode::Add));
    // Add the statement to the program.
    builder.appendStmt(std::move(update_counter));
@@ -136,7 +145,7 @@ void FuseChunkSink::setUpStateImpl(const ExecutionContext& context) {
    for (size_t thread_id = 0; thread_id < context.getNumThreads(); ++thread_id) {
       auto& state = (*states)[thread_id];
       auto& col = context.getColumn(**source_ius.begin(), thread_id);
-      state.raw_data = col.raw_data;
+      state.raw_data = reinterpret_cast<void**>(&col.owned_data);
       state.size = reinterpret_cast<uint64_t*>(&col.size);
    }
 }
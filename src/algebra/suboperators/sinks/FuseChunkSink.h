@@ -9,15 +9,16 @@ namespace inkfuse {
 struct FuseChunkSinkState {
    static const char* name;
 
-   /// Data sink into which to write.
-   void* raw_data;
+   /// Data sink into which to write. Double indirection, the column might move to
+   /// fresh memory between morsels when its data gets handed out (see Column::releaseData).
+   void** raw_data;
    /// Size of the chunk.
    uint64_t* size;
 };
 
 /// Runtime parameters which are not needed for code generation of the respective operator.
 struct FuseChunkSinkStateRuntimeParams {
-   void* raw_data;
+   void** raw_data;
    uint64_t* size;
 };
 
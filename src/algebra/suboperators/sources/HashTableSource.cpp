@@ -1,6 +1,6 @@
 #include "algebra/suboperators/sources/HashTableSource.h"
-#include "exec/FuseChunk.h"
 #include "runtime/Runtime.h"
+#include <algorithm>
 
 namespace inkfuse {
 
@@ -11,13 +11,13 @@ void HashTableSourceState::registerRuntime() {
       .addMember("hash_table", IR::Pointer::build(IR::Void::build()))
       .addMember("it_ptr_start", IR::Pointer::build(IR::Char::build()))
       .addMember("it_idx_start", IR::UnsignedInt::build(8))
-      .addMember("it_ptr_end", IR::Pointer::build(IR::Char::build()))
-      .addMember("it_idx_end", IR::UnsignedInt::build(8));
+      .addMember("it_idx_end", IR::UnsignedInt::build(8))
+      .addMember("null_row", IR::Pointer::build(IR::Char::build()));
 }
 
 template <class HashTable>
-HashTableSource<HashTable>::HashTableSource(const RelAlgOp* source, const IU& produced_iu, const IU* produced_null_markers, DefferredStateInitializer* deferred_state_)
-   : TemplatedSuboperator<HashTableSourceState>(source, {&produced_iu}, {}), deferred_state(deferred_state_) {
+HashTableSource<HashTable>::HashTableSource(const RelAlgOp* source, const IU& produced_iu, const IU* produced_null_markers, const char* null_row_, DefferredStateInitializer* deferred_state_)
+   : TemplatedSuboperator<HashTableSourceState>(source, {&produced_iu}, {}), deferred_state(deferred_state_), null_row(null_row_) {
    if (produced_null_markers) {
       // If we provide null markers, add this to the provided IUs.
       provided_ius.push_back(produced_null_markers);
@@ -26,43 +26,64 @@ HashTableSource<HashTable>::HashTableSource(const RelAlgOp* source, const IU& pr
 
 template <class HashTable>
 std::string HashTableSource<HashTable>::id() const {
-   std::string id = "hash_table_source_";
-   return id + HashTable::ID;
+   std::string id = "hash_table_source_" + HashTable::ID;
+   if (provided_ius.size() == 2) {
+      // Outer join sources additionally produce the NULL markers.
+      id += "_outer";
+   }
+   return id;
 }
 
 template <class HashTable>
 SuboperatorArc HashTableSource<HashTable>::build(const RelAlgOp* source, const IU& produced_iu, DefferredStateInitializer* deferred_state_) {
-   return std::unique_ptr<HashTableSource>{new HashTableSource(source, produced_iu, nullptr, deferred_state_)};
+   return std::unique_ptr<HashTableSource>{new HashTableSource(source, produced_iu, nullptr, nullptr, deferred_state_)};
 }
 
 template <class HashTable>
-SuboperatorArc HashTableSource<HashTable>::buildForOuterJoin(const RelAlgOp* source, const IU& produced_iu, const IU& null_marker, DefferredStateInitializer* deferred_state_) {
-   return std::unique_ptr<HashTableSource>{new HashTableSource(source, produced_iu, &null_marker, deferred_state_)};
+SuboperatorArc HashTableSource<HashTable>::buildForOuterJoin(const RelAlgOp* source, const IU& produced_iu, const IU& null_marker, const char* null_row, DefferredStateInitializer* deferred_state_) {
+   return std::unique_ptr<HashTableSource>{new HashTableSource(source, produced_iu, &null_marker, null_row, deferred_state_)};
+}
+
+template <class HashTable>
+bool HashTableSource<HashTable>::claimRange(ClaimedRange& range) {
+   const size_t range_idx = next_range.fetch_add(1);
+   if (range_idx >= range_offsets.back()) {
+      return false;
+   }
+   // Find the table the range belongs to.
+   const auto table_idx = std::upper_bound(range_offsets.begin(), range_offsets.end(), range_idx) - range_offsets.begin() - 1;
+   range.table = tables[table_idx];
+   range.cursor = (range_idx - range_offsets[table_idx]) * range_slots;
+   range.end = std::min<uint64_t>(range.cursor + range_slots, range.table->capacity());
+   return true;
 }
 
 template <class HashTable>
 Suboperator::PickMorselResult HashTableSource<HashTable>::pickMorsel(size_t thread_id) {
-   void* ht_ptr = deferred_state->access(thread_id);
-   assert(ht_ptr);
-   HashTable* hash_table = reinterpret_cast<HashTable*>(ht_ptr);
    HashTableSourceState& state = (*states)[thread_id];
-   if (state.it_ptr_end == nullptr) {
-      // The last morsel went until the hash table end. We are done.
-      return Suboperator::NoMoreMorsels{};
-   }
-   // The current end becomes the new start.
-   state.it_ptr_start = state.it_ptr_end;
-   state.it_idx_start = state.it_idx_end;
-   // Advance the end iterator by one morsel.
-   size_t entries_found = 0;
-   while (entries_found < DEFAULT_CHUNK_SIZE && (state.it_ptr_end != nullptr)) {
-      hash_table->iteratorAdvance(&state.it_ptr_end, &state.it_idx_end);
-      entries_found++;
+   ClaimedRange& range = claimed[thread_id];
+   for (;;) {
+      if (range.cursor == range.end && !claimRange(range)) {
+         // All ranges were claimed. We are done.
+         return Suboperator::NoMoreMorsels{};
+      }
+      // Scan the tags for the next morsel within the claimed range.
+      const auto morsel = range.table->iteratorMorsel(range.cursor, range.end, DEFAULT_CHUNK_SIZE);
+      range.cursor = morsel.end;
+      if (morsel.rows == 0) {
+         // Nothing left in this range.
+         continue;
+      }
+      state.hash_table = range.table;
+      state.it_idx_start = morsel.first;
+      state.it_ptr_start = range.table->iteratorData(morsel.first);
+      state.it_idx_end = morsel.end;
+      const size_t claimed_ranges = std::min(next_range.load(), range_offsets.back());
+      return PickedMorsel{
+         .morsel_size = morsel.rows,
+         .pipeline_progress = static_cast<double>(claimed_ranges) / std::max<size_t>(range_offsets.back(), 1),
+      };
    }
-   return PickedMorsel{
-      .morsel_size = entries_found,
-      .pipeline_progress = static_cast<double>(state.it_idx_end) / hash_table->capacity(),
-   };
 }
 
 template <class HashTable>
@@ -72,7 +93,6 @@ void HashTableSource<HashTable>::open(CompilationContext& context) {
    const auto& iu = *provided_ius.front();
 
    IR::Stmt* iu_decl;
-   IR::Stmt* decl_it_end_ptr;
    {
       // Within the preamble, extract the initial iterator state of the morsel.
       // We cannot work on the morsel directly, as otherwise a next vectorized primitive on the
@@ -84,8 +104,8 @@ void HashTableSource<HashTable>::open(CompilationContext& context) {
       auto var_name = this->getVarIdentifier().str();
       auto iu_name = context.buildIUIdentifier(iu);
       iu_decl = p_append(IR::DeclareStmt::build(std::move(iu_name), IR::Pointer::build(IR::Char::build())));
-      decl_it_end_ptr = p_append(IR::DeclareStmt::build(var_name + "_it_ptr_end", IR::Pointer::build(IR::Char::build())));
       decl_it_idx = p_append(IR::DeclareStmt::build(var_name + "_it_idx", IR::UnsignedInt::build(8)));
+      decl_it_idx_end = p_append(IR::DeclareStmt::build(var_name + "_it_idx_end", IR::UnsignedInt::build(8)));
       decl_ht = p_append(IR::DeclareStmt::build(var_name + "_ht", IR::Pointer::build(IR::Void::build())));
       context.declareIU(iu, *iu_decl);
       // Copy values from the global state into local variables.
@@ -98,23 +118,16 @@ void HashTableSource<HashTable>::open(CompilationContext& context) {
 
       if (provided_ius.size() == 2) {
          // We're providing for an outer join. Also create the proper marking IU.
+         // It points to the NULL row for every produced tuple.
          auto& marked_iu = provided_ius[1];
          auto& declare = preamble_stmts.emplace_back(IR::DeclareStmt::build(context.buildIUIdentifier(*marked_iu), marked_iu->type));
          context.declareIU(*marked_iu, *declare);
-         // Allocate backing memory for the target IU.
-         auto fct = context.getRuntimeFunction("inkfuse_malloc");
-         // Warning: this could not be done for a suboperator which supports interpretation,
-         // as the actual number of bytes might be unknown at compilation time.
-         std::vector<IR::ExprPtr> args;
-         // TODO(benjamin): properly resolve the byte count through a runtime parameter.
-         args.push_back(IR::ConstExpr::build(IR::UI<8>::build(5)));
-         auto alloc_call = IR::InvokeFctExpr::build(*fct, std::move(args));
-         preamble_stmts.emplace_back(IR::AssignmentStmt::build(*declare, std::move(alloc_call)));
+         gstate_extract_into("null_row", *declare);
       }
 
       gstate_extract_into("it_ptr_start", *iu_decl);
-      gstate_extract_into("it_ptr_end", *decl_it_end_ptr);
       gstate_extract_into("it_idx_start", *decl_it_idx);
+      gstate_extract_into("it_idx_end", *decl_it_idx_end);
       gstate_extract_into("hash_table", *decl_ht);
       builder.getRootBlock().appendStmts(std::move(preamble_stmts));
    }
@@ -123,9 +136,9 @@ void HashTableSource<HashTable>::open(CompilationContext& context) {
    // Next up we create the driving for-loop.
    this->opt_while = builder.buildWhile(
       IR::ArithmeticExpr::build(
-         IR::VarRefExpr::build(*iu_decl),
-         IR::VarRefExpr::build(*decl_it_end_ptr),
-         IR::ArithmeticExpr::Opcode::Neq));
+         IR::VarRefExpr::build(*decl_it_idx),
+         IR::VarRefExpr::build(*decl_it_idx_end),
+         IR::ArithmeticExpr::Opcode::Less));
    {
       // Generate code for downstream consumers.
       context.notifyIUsReady(*this);
@@ -140,12 +153,14 @@ void HashTableSource<HashTable>::close(CompilationContext& context) {
    // Advance the hash table iterator.
    auto runtime_fct = context.getRuntimeFunction("ht_" + HashTable::ID + "_it_advance").get();
    std::vector<IR::ExprPtr> args_exprs;
-   args_exprs.reserve(3);
+   args_exprs.reserve(4);
    // Hash table gets passed as-is.
    args_exprs.push_back(IR::VarRefExpr::build(*decl_ht));
    // Other arguments get referenced, as they actually get updated.
    args_exprs.push_back(IR::RefExpr::build(IR::VarRefExpr::build(iu_decl)));
    args_exprs.push_back(IR::RefExpr::build(IR::VarRefExpr::build(*decl_it_idx)));
+   // The iterator stops at the end of the morsel.
+   args_exprs.push_back(IR::VarRefExpr::build(*decl_it_idx_end));
    IR::ExprPtr invoke_expr =
       IR::InvokeFctExpr::build(*runtime_fct, std::move(args_exprs));
    auto invoke_stmt = IR::InvokeFctStmt::build(std::move(invoke_expr));
@@ -159,33 +174,31 @@ template <class HashTable>
 void HashTableSource<HashTable>::setUpStateImpl(const ExecutionContext& context) {
    assert(deferred_state);
 
+   tables.clear();
    if constexpr (std::is_same_v<HashTable, AtomicHashTable<SimpleKeyComparator>>) {
-      // Only the first thread produces the null marked tuples.
-      auto& state = (*states)[0];
-      void* ht_ptr = deferred_state->access(0);
-      state.hash_table = ht_ptr;
-      assert(ht_ptr);
-      HashTable* hash_table = reinterpret_cast<HashTable*>(ht_ptr);
-      // Initialize start to point to the first slot of the hash table.
-      hash_table->iteratorStart(&(state.it_ptr_start), &(state.it_idx_start));
-      // Set the end iterator to the same value. This way the first pickMorsel will work.
-      state.it_ptr_end = state.it_ptr_start;
-      state.it_idx_end = state.it_idx_start;
+      // All threads share the hash table of the outer join.
+      tables.push_back(reinterpret_cast<HashTable*>(deferred_state->access(0)));
    } else {
-      // All threads pin themselves to their hash table.
+      // Every thread has its own (partitioned) hash table.
       for (size_t k = 0; k < context.getNumThreads(); ++k) {
-         auto& state = (*states)[k];
-         void* ht_ptr = deferred_state->access(k);
-         state.hash_table = ht_ptr;
-         assert(ht_ptr);
-         HashTable* hash_table = reinterpret_cast<HashTable*>(ht_ptr);
-         // Initialize start to point to the first slot of the hash table.
-         hash_table->iteratorStart(&(state.it_ptr_start), &(state.it_idx_start));
-         // Set the end iterator to the same value. This way the first pickMorsel will work.
-         state.it_ptr_end = state.it_ptr_start;
-         state.it_idx_end = state.it_idx_start;
+         tables.push_back(reinterpret_cast<HashTable*>(deferred_state->access(k)));
       }
    }
+
+   // Split all tables into ranges of range_slots slots.
+   range_offsets.assign(1, 0);
+   for (const HashTable* table : tables) {
+      assert(table);
+      range_offsets.push_back(range_offsets.back() + (table->capacity() + range_slots - 1) / range_slots);
+   }
+   next_range = 0;
+   claimed.assign(context.getNumThreads(), ClaimedRange{});
+
+   for (size_t k = 0; k < context.getNumThreads(); ++k) {
+      auto& state = (*states)[k];
+      state.hash_table = tables.front();
+      state.null_row = null_row;
+   }
 }
 
 // Explicitly instantiate templates.
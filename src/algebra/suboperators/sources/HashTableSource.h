@@ -5,7 +5,10 @@
 #include "algebra/RelAlgOp.h"
 #include "algebra/suboperators/Suboperator.h"
 #include "codegen/IRBuilder.h"
+#include "exec/FuseChunk.h"
+#include "runtime/HashTables.h"
 #include "runtime/NewHashTables.h"
+#include <atomic>
 
 namespace inkfuse {
 
@@ -22,20 +25,23 @@ struct HashTableSourceState {
    char* it_ptr_start = nullptr;
    /// Current iterator index.
    uint64_t it_idx_start;
-   /// Iterator pointer at which to end.
-   char* it_ptr_end = nullptr;
-   /// Iterator end index.
+   /// Slot index behind the last slot of the morsel.
    uint64_t it_idx_end;
+   /// Row providing the NULL values for outer joins.
+   const char* null_row = nullptr;
 };
 
 /// The HashTableSouce allows reading from an underlying hash table. It returns char pointers to the
 /// hash table payloads.
-/// Picks morsels until all hash table payloads were produced. Within a single morsel, produces at most
-/// DEFAULT_CHUNK_SIZE elements.
+/// The slots of all backing hash tables are split into fixed-size ranges that threads claim through
+/// a shared atomic counter. This way all threads help reading the result, even if the payloads are
+/// skewed across the tables. Within a single morsel, produces at most DEFAULT_CHUNK_SIZE elements.
 template <class HashTable>
 struct HashTableSource : public TemplatedSuboperator<HashTableSourceState> {
    static SuboperatorArc build(const RelAlgOp* source, const IU& produced_iu, DefferredStateInitializer* deferred_state_);
-   static SuboperatorArc buildForOuterJoin(const RelAlgOp* source, const IU& produced_iu, const IU& null_marker, DefferredStateInitializer* deferred_state_);
+   /// Build a source for the unmatched rows of an outer join. The `null_marker` IU is produced for every
+   /// row and points to the `null_row`, which has to stay alive until the query finishes.
+   static SuboperatorArc buildForOuterJoin(const RelAlgOp* source, const IU& produced_iu, const IU& null_marker, const char* null_row, DefferredStateInitializer* deferred_state_);
 
    /// Keep running as long as we have cells to read from in the backing hash table.
    PickMorselResult pickMorsel(size_t thread_id) override;
@@ -47,18 +53,44 @@ struct HashTableSource : public TemplatedSuboperator<HashTableSourceState> {
    std::string id() const override;
 
    protected:
-   HashTableSource(const RelAlgOp* source, const IU& produced_iu, const IU* produced_null_markers, DefferredStateInitializer* deferred_state_);
+   HashTableSource(const RelAlgOp* source, const IU& produced_iu, const IU* produced_null_markers, const char* null_row_, DefferredStateInitializer* deferred_state_);
 
    void setUpStateImpl(const ExecutionContext& context) override;
 
    private:
+   /// Number of slots in a range claimed by a thread.
+   static constexpr uint64_t range_slots = 16 * DEFAULT_CHUNK_SIZE;
+
+   /// A slot range claimed by a thread.
+   struct ClaimedRange {
+      HashTable* table = nullptr;
+      /// Next slot to produce a morsel from.
+      uint64_t cursor = 0;
+      /// Slot behind the end of the range.
+      uint64_t end = 0;
+   };
+
+   /// Claim the next slot range. Returns false if all ranges were claimed.
+   bool claimRange(ClaimedRange& range);
+
    /// In-flight while loop being generated between calls to open() and close().
    std::optional<IR::While> opt_while;
    /// Global state copied into the function preamble.
    IR::Stmt* decl_ht;
    IR::Stmt* decl_it_idx;
+   IR::Stmt* decl_it_idx_end;
    /// The hash table we are reading from.
    DefferredStateInitializer* deferred_state;
+   /// All hash tables that have to be read.
+   std::vector<HashTable*> tables;
+   /// Prefix sum over the number of ranges in the tables.
+   std::vector<size_t> range_offsets;
+   /// The next range that can be claimed.
+   std::atomic<size_t> next_range = 0;
+   /// The range every thread is currently working on.
+   std::vector<ClaimedRange> claimed;
+   /// The NULL row for outer joins.
+   const char* null_row;
 };
 
 using SimpleHashTableSource = HashTableSource<HashTableSimpleKey>;
@@ -0,0 +1,37 @@
+#include "algebra/suboperators/sources/SortSource.h"
+#include "exec/FuseChunk.h"
+
+namespace inkfuse {
+
+std::unique_ptr<SortDriver> SortDriver::build(const RelAlgOp* source, const std::vector<char*>& sorted_rows_, bool ordered_) {
+   return std::unique_ptr<SortDriver>(new SortDriver(source, sorted_rows_, ordered_));
+}
+
+SortDriver::SortDriver(const RelAlgOp* source, const std::vector<char*>& sorted_rows_, bool ordered_)
+   : LoopDriver(source), sorted_rows(sorted_rows_), ordered(ordered_) {
+}
+
+Suboperator::PickMorselResult SortDriver::pickMorsel(size_t thread_id) {
+   assert(states);
+   const size_t num_rows = sorted_rows.size();
+   if (ordered && thread_id != 0) {
+      return NoMoreMorsels{};
+   }
+   const size_t start = next_row.fetch_add(DEFAULT_CHUNK_SIZE);
+   if (start >= num_rows) {
+      return NoMoreMorsels{};
+   }
+   LoopDriverState& state = (*states)[thread_id];
+   state.start = start;
+   state.end = std::min(start + DEFAULT_CHUNK_SIZE, num_rows);
+   return PickedMorsel{
+      .morsel_size = state.end - state.start,
+      .pipeline_progress = static_cast<double>(state.end) / num_rows,
+   };
+}
+
+std::string SortDriver::id() const {
+   return "SortDriver";
+}
+
+}
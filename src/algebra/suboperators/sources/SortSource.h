@@ -0,0 +1,36 @@
+#ifndef INKFUSE_SORTSOURCE_H
+#define INKFUSE_SORTSOURCE_H
+
+#include "algebra/suboperators/LoopDriver.h"
+#include <atomic>
+#include <vector>
+
+namespace inkfuse {
+
+/// Loop driver over the sorted rows of a Sorter or TopK. Downstream IUs are provided by a deferred
+/// TScanIUProvider reading the row pointers.
+/// If the order of the rows has to survive until the result sink, all morsels are handed to
+/// the first thread in order. The remaining threads don't pick any morsels.
+/// Unordered drivers (e.g. over the rows of a window operator) hand morsels to any thread.
+struct SortDriver final : public LoopDriver {
+   static std::unique_ptr<SortDriver> build(const RelAlgOp* source, const std::vector<char*>& sorted_rows_, bool ordered_ = true);
+
+   /// Pick the next morsel of sorted rows. Only thread 0 receives morsels if the driver is ordered.
+   PickMorselResult pickMorsel(size_t thread_id) override;
+
+   std::string id() const override;
+
+   private:
+   SortDriver(const RelAlgOp* source, const std::vector<char*>& sorted_rows_, bool ordered_);
+
+   /// The sorted rows we are reading. Populated once the pipeline runs.
+   const std::vector<char*>& sorted_rows;
+   /// Does the order of the rows have to survive until the result sink?
+   bool ordered;
+   /// Index of the next row to produce.
+   std::atomic<size_t> next_row = 0;
+};
+
+}
+
+#endif //INKFUSE_SORTSOURCE_H
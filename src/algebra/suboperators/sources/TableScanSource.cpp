@@ -2,6 +2,7 @@
 #include "algebra/CompilationContext.h"
 #include "algebra/RelAlgOp.h"
 #include "codegen/Type.h"
+#include "common/Numa.h"
 #include "exec/FuseChunk.h"
 #include <algorithm>
 #include <functional>
@@ -9,31 +10,68 @@
 namespace inkfuse {
 
 std::unique_ptr<TScanDriver> TScanDriver::build(const RelAlgOp* source, size_t rel_size_) {
-   return std::unique_ptr<TScanDriver>(new TScanDriver(source, rel_size_));
+   return build(source, {RowSegment{.begin = 0, .end = rel_size_, .node = 0}});
 }
 
-TScanDriver::TScanDriver(const RelAlgOp* source, size_t rel_size_)
-   : LoopDriver(source), rel_size(rel_size_) {
+std::unique_ptr<TScanDriver> TScanDriver::build(const RelAlgOp* source, const std::vector<RowSegment>& segments_) {
+   return std::unique_ptr<TScanDriver>(new TScanDriver(source, segments_));
+}
+
+TScanDriver::TScanDriver(const RelAlgOp* source, const std::vector<RowSegment>& segments_)
+   : LoopDriver(source) {
+   for (const auto& segment : segments_) {
+      segments.emplace_back(segment);
+      rel_size += segment.end - segment.begin;
+   }
+}
+
+bool TScanDriver::tryPick(Segment& segment, LoopDriverState& state) {
+   // Cheap check first - don't keep bumping the counter of exhausted segments.
+   if (segment.start_idx.load(std::memory_order_relaxed) >= segment.end) {
+      return false;
+   }
+   size_t morsel_start = segment.start_idx.fetch_add(DEFAULT_CHUNK_SIZE);
+   if (morsel_start >= segment.end) {
+      // If the starting point advanced beyond the end, then we know there are no more morsels in the segment.
+      return false;
+   }
+   // Go up to the maximum chunk size of the intermediate results or the end of the segment.
+   // Indices are relative to the storage block.
+   state.start = morsel_start - segment.block_begin;
+   state.end = std::min(morsel_start + DEFAULT_CHUNK_SIZE, segment.end) - segment.block_begin;
+   return true;
 }
 
 Suboperator::PickMorselResult TScanDriver::pickMorsel(size_t thread_id) {
    assert(states);
    LoopDriverState& state = (*states).at(thread_id);
 
-   size_t morsel_start = start_idx.fetch_add(DEFAULT_CHUNK_SIZE);
-
-   if (morsel_start >= rel_size) {
-      // If the starting point advanced beyond the end, then we know there are no more morsels to pick.
+   // Prefer morsels residing on the node the worker is currently running on.
+   const size_t node = numa::currentNode();
+   Segment* picked = nullptr;
+   for (auto it = segments.begin(); !picked && it != segments.end(); ++it) {
+      if (it->node == node && tryPick(*it, state)) {
+         picked = &*it;
+      }
+   }
+   // Steal remote morsels once all local ones are exhausted.
+   for (auto it = segments.begin(); !picked && it != segments.end(); ++it) {
+      if (tryPick(*it, state)) {
+         picked = &*it;
+      }
+   }
+   if (!picked) {
       return NoMoreMorsels{};
    }
+   for (TScanIUProvider* provider : providers) {
+      provider->bindBlock(thread_id, picked->block);
+   }
 
-   // Go up to the maximum chunk size of the intermediate results or the total relation size.
-   state.start = morsel_start;
-   state.end = std::min(state.start + DEFAULT_CHUNK_SIZE, rel_size);
-
+   const size_t morsel_size = state.end - state.start;
+   const size_t progress = picked_tuples.fetch_add(morsel_size) + morsel_size;
    return PickedMorsel{
-      .morsel_size = state.end - state.start,
-      .pipeline_progress = static_cast<double>(state.end) / rel_size,
+      .morsel_size = morsel_size,
+      .pipeline_progress = static_cast<double>(progress) / rel_size,
    };
 }
 
@@ -41,22 +79,102 @@ std::string TScanDriver::id() const {
    return "TScanDriver";
 }
 
+void TScanDriver::attachProvider(TScanIUProvider& provider) {
+   providers.push_back(&provider);
+}
+
+void TScanIUProvider::bindBlock(size_t thread_id, size_t block) {
+   assert(thread_id < thread_data.size() && block < blocks.size());
+   thread_data[thread_id] = blocks[block];
+}
+
 void TScanIUProvider::setUpStateImpl(const ExecutionContext& context) {
-   for (auto& state : *states) {
-      state.start = &raw_data;
+   if (deferred_data) {
+      // The column was materialized by now.
+      blocks = {*deferred_data};
+   }
+   // The pipeline can be set up repeatedly (e.g. in hybrid mode) while morsels are in flight.
+   // Don't throw away the blocks the threads are currently bound to.
+   if (thread_data.size() != states->size()) {
+      thread_data.assign(states->size(), blocks.front());
+   }
+   for (size_t k = 0; k < states->size(); ++k) {
+      (*states)[k].start = &thread_data[k];
    }
 }
 
+void TScanIUProvider::consume(const IU& iu, CompilationContext& context) {
+   if (!validity) {
+      IndexedIUProvider::consume(iu, context);
+      return;
+   }
+   auto& builder = context.getFctBuilder();
+   const auto& program = context.getProgram();
+   const auto& loop_idx = context.getIUDeclaration(*source_ius.front());
+   const IU& out_iu = *provided_ius.front();
+
+   // Extract the bitmap into the function preamble.
+   auto bits_name = getVarIdentifier();
+   bits_name << "_bits";
+   auto bits_type = IR::Pointer::build(IR::UnsignedInt::build(8));
+   auto decl_bits = IR::DeclareStmt::build(bits_name.str(), bits_type);
+   const auto& bits = *decl_bits;
+   auto state_expr = IR::CastExpr::build(context.accessGlobalState(*this), IR::Pointer::build(program.getStruct(IndexedIUProviderState::name)));
+   auto assign_bits = IR::AssignmentStmt::build(
+      bits,
+      IR::CastExpr::build(IR::DerefExpr::build(IR::StructAccessExpr::build(std::move(state_expr), "start")), bits_type));
+   std::deque<IR::StmtPtr> preamble_stmts;
+   preamble_stmts.push_back(std::move(decl_bits));
+   preamble_stmts.push_back(std::move(assign_bits));
+   builder.getRootBlock().appendStmts(std::move(preamble_stmts));
+
+   // The row is NULL if its bit is not set: ((bits[idx / 64] >> (idx & 63)) & 1) == 0.
+   const auto& declare_stmt = builder.appendStmt(IR::DeclareStmt::build(context.buildIUIdentifier(out_iu), out_iu.type));
+   context.declareIU(out_iu, declare_stmt);
+   auto word = IR::DerefExpr::build(
+      IR::ArithmeticExpr::build(
+         IR::VarRefExpr::build(bits),
+         IR::ArithmeticExpr::build(IR::VarRefExpr::build(loop_idx), IR::ConstExpr::build(IR::UI<8>::build(64)), IR::ArithmeticExpr::Opcode::Divide),
+         IR::ArithmeticExpr::Opcode::Add));
+   auto shifted = IR::ArithmeticExpr::build(
+      std::move(word),
+      IR::ArithmeticExpr::build(IR::VarRefExpr::build(loop_idx), IR::ConstExpr::build(IR::UI<8>::build(63)), IR::ArithmeticExpr::Opcode::BitAnd),
+      IR::ArithmeticExpr::Opcode::ShiftRight);
+   auto bit = IR::ArithmeticExpr::build(std::move(shifted), IR::ConstExpr::build(IR::UI<8>::build(1)), IR::ArithmeticExpr::Opcode::BitAnd);
+   builder.appendStmt(IR::AssignmentStmt::build(
+      declare_stmt,
+      IR::ArithmeticExpr::build(std::move(bit), IR::ConstExpr::build(IR::UI<8>::build(0)), IR::ArithmeticExpr::Opcode::Eq)));
+
+   context.notifyIUsReady(*this);
+}
+
 std::string TScanIUProvider::providerName() const {
-   return "TScanIUProvider";
+   return validity ? "TScanValidityProvider" : "TScanIUProvider";
 }
 
 std::unique_ptr<TScanIUProvider> TScanIUProvider::build(const RelAlgOp* source, const IU& driver_iu, const IU& produced_iu, char* raw_data_) {
-   return std::unique_ptr<TScanIUProvider>(new TScanIUProvider{source, driver_iu, produced_iu, raw_data_});
+   return build(source, driver_iu, produced_iu, std::vector<char*>{raw_data_});
+}
+
+std::unique_ptr<TScanIUProvider> TScanIUProvider::build(const RelAlgOp* source, const IU& driver_iu, const IU& produced_iu, std::vector<char*> blocks_) {
+   return std::unique_ptr<TScanIUProvider>(new TScanIUProvider{source, driver_iu, produced_iu, std::move(blocks_)});
+}
+
+std::unique_ptr<TScanIUProvider> TScanIUProvider::buildValidity(const RelAlgOp* source, const IU& driver_iu, const IU& produced_iu, std::vector<char*> blocks_) {
+   auto provider = build(source, driver_iu, produced_iu, std::move(blocks_));
+   provider->validity = true;
+   return provider;
+}
+
+std::unique_ptr<TScanIUProvider> TScanIUProvider::buildDeferred(const RelAlgOp* source, const IU& driver_iu, const IU& produced_iu, char* const* deferred_data_) {
+   auto provider = build(source, driver_iu, produced_iu, std::vector<char*>{nullptr});
+   provider->deferred_data = deferred_data_;
+   return provider;
 }
 
-TScanIUProvider::TScanIUProvider(const RelAlgOp* source, const IU& driver_iu, const IU& produced_iu, char* raw_data_)
-   : IndexedIUProvider(source, driver_iu, produced_iu), raw_data(raw_data_) {
+TScanIUProvider::TScanIUProvider(const RelAlgOp* source, const IU& driver_iu, const IU& produced_iu, std::vector<char*> blocks_)
+   : IndexedIUProvider(source, driver_iu, produced_iu), blocks(std::move(blocks_)) {
+   assert(!blocks.empty());
 }
 
 }
@@ -4,36 +4,91 @@
 #include "algebra/suboperators/IndexedIUProvider.h"
 #include "algebra/suboperators/LoopDriver.h"
 #include "algebra/suboperators/Suboperator.h"
+#include "storage/Relation.h"
 #include <atomic>
+#include <deque>
 
 /// This file contains the necessary sub-operators for reading from a base table.
 namespace inkfuse {
 
+struct TScanIUProvider;
+
 /// Loop driver for reading a morsel from an underlying table.
+/// If the relation is partitioned across NUMA nodes, the driver first hands out
+/// morsels from segments local to the node of the picking worker. Only once these are
+/// exhausted it starts stealing morsels from remote segments.
+/// The produced indices are relative to the storage block of the segment, the driver
+/// points the attached IU providers at the right block whenever it picks a morsel.
 struct TScanDriver final : public LoopDriver {
    static std::unique_ptr<TScanDriver> build(const RelAlgOp* source, size_t rel_size_ = 0);
+   static std::unique_ptr<TScanDriver> build(const RelAlgOp* source, const std::vector<RowSegment>& segments_);
 
    /// Pick then next set of tuples from the table scan up to the maximum chunk size.
    PickMorselResult pickMorsel(size_t thread_id) override;
 
+   /// The size of the scanned relation.
+   std::optional<size_t> estimateRows() const override { return rel_size; }
+
    std::string id() const override;
 
+   /// Attach an IU provider reading from the storage blocks of the segments.
+   void attachProvider(TScanIUProvider& provider);
+
    private:
    /// Set up the table scan driver in the respective base pipeline.
-   TScanDriver(const RelAlgOp* source, size_t rel_size_);
+   TScanDriver(const RelAlgOp* source, const std::vector<RowSegment>& segments_);
+
+   /// A segment of the relation from which morsels are picked.
+   struct Segment {
+      Segment(const RowSegment& segment) : start_idx(segment.begin), end(segment.end), node(segment.node), block(segment.block), block_begin(segment.block_begin) {}
+
+      /// What is the index the next morsel should start at? Atomic since
+      /// multiple morsels may pick work at the same time.
+      std::atomic<size_t> start_idx;
+      /// Index of the last row in the segment (exclusive).
+      size_t end;
+      /// NUMA node of the segment.
+      size_t node;
+      /// Storage block backing the segment.
+      size_t block;
+      /// First row of the storage block.
+      size_t block_begin;
+   };
+
+   /// Try to pick the next morsel from the given segment.
+   bool tryPick(Segment& segment, LoopDriverState& state);
 
    /// What is the size of the backing relation?
-   size_t rel_size;
-   /// What is the index the next morsel should start at? Atomic since
-   /// multiple morsels may pick work at the same time.
-   std::atomic<size_t> start_idx = 0;
-   /// Was the first morsel picked already?
-   bool first_picked = false;
+   size_t rel_size = 0;
+   /// The segments of the backing relation.
+   std::deque<Segment> segments;
+   /// How many tuples were handed out so far? Used for reporting pipeline progress.
+   std::atomic<size_t> picked_tuples = 0;
+   /// The IU providers reading from the segments' storage blocks.
+   std::vector<TScanIUProvider*> providers;
 };
 
 /// IU provider when reading from a table scan.
 struct TScanIUProvider final : public IndexedIUProvider {
    static std::unique_ptr<TScanIUProvider> build(const RelAlgOp* source, const IU& driver_iu, const IU& produced_iu, char* raw_data_ = nullptr);
+   /// Build a provider over a column consisting of multiple storage blocks, see RowSegment::block.
+   static std::unique_ptr<TScanIUProvider> build(const RelAlgOp* source, const IU& driver_iu, const IU& produced_iu, std::vector<char*> blocks_);
+
+   /// Build a provider over a column which only exists once the pipeline gets set up, e.g. the sorted rows
+   /// of a sort. `deferred_data` has to point to the column data by then.
+   static std::unique_ptr<TScanIUProvider> buildDeferred(const RelAlgOp* source, const IU& driver_iu, const IU& produced_iu, char* const* deferred_data_);
+
+   /// Build a provider producing the NULL indicators of a nullable column straight from
+   /// the validity bitmaps of its storage blocks, see BaseColumn::getBlockValidity.
+   static std::unique_ptr<TScanIUProvider> buildValidity(const RelAlgOp* source, const IU& driver_iu, const IU& produced_iu, std::vector<char*> blocks_);
+
+   /// Read the next morsel of the given thread from the given storage block.
+   void bindBlock(size_t thread_id, size_t block);
+
+   /// Does the provider read a validity bitmap? These can't be scanned zero-copy.
+   bool readsValidity() const { return validity; }
+
+   void consume(const IU& iu, CompilationContext& context) override;
 
    protected:
    void setUpStateImpl(const ExecutionContext& context) override;
@@ -41,10 +96,16 @@ struct TScanIUProvider final : public IndexedIUProvider {
    std::string providerName() const override;
 
    private:
-   TScanIUProvider(const RelAlgOp* source, const IU& driver_iu, const IU& produced_iu, char* raw_data_);
+   TScanIUProvider(const RelAlgOp* source, const IU& driver_iu, const IU& produced_iu, std::vector<char*> blocks_);
 
-   /// Pointer to the start of the backing stored column.
-   char* raw_data;
+   /// Pointers to the start of the storage blocks of the backing stored column.
+   std::vector<char*> blocks;
+   /// Location of the column data for deferred providers.
+   char* const* deferred_data = nullptr;
+   /// Are the blocks validity bitmaps?
+   bool validity = false;
+   /// The block every thread is currently reading from. The runtime state points into this.
+   std::vector<char*> thread_data;
 };
 
 }
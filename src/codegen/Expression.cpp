@@ -55,6 +55,14 @@ TypeArc ArithmeticExpr::deriveType(const Expr& child_l, const Expr& child_r, Opc
    if (isComparison(code)) {
       return Bool::build();
    }
+   if (auto dec_l = dynamic_cast<Decimal*>(child_l.type.get()), dec_r = dynamic_cast<Decimal*>(child_r.type.get()); dec_l || dec_r) {
+      // Decimal arithmetic happens on the wider of the two operands. Precision and scale
+      // of the result are derived when planning the query, see ExpressionOp::derive.
+      if (dec_l && dec_r && dec_r->numBytes() > dec_l->numBytes()) {
+         return child_r.type;
+      }
+      return dec_l ? child_l.type : child_r.type;
+   }
    if (code == Opcode::HashCombine) {
       assert(dynamic_cast<IR::UnsignedInt*>(child_l.type.get()));
       return UnsignedInt::build(8);
@@ -120,12 +120,22 @@ struct ArithmeticExpr : public BinaryExpr {
       Greater,
       GreaterEqual,
       HashCombine,
+      /// Bitwise and of two unsigned integers.
+      BitAnd,
+      /// Logical right shift of an unsigned integer.
+      ShiftRight,
+      /// Smaller of the two values. Strings are compared lexicographically.
+      Min,
+      /// Larger of the two values. Strings are compared lexicographically.
+      Max,
       /// String equals - not really an arithmetic function, but easiest to put here for now.
       StrEquals,
       /// In list with strings - not really an arithmetic function, but easiest to put here for now.
       StrInList,
       /// Not Like with some tokens - not really an arithmetic function, but easiest to put here for now.
       NotLikeTokens,
+      /// SQL LIKE on a compiled `LikePattern` - not really an arithmetic function, but easiest to put here for now.
+      StrLike,
    };
 
    /// Opcode of this expression.
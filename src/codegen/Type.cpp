@@ -1,6 +1,7 @@
 #include "codegen/Type.h"
 #include "common/Helpers.h"
 #include <algorithm>
+#include <cstring>
 #include <iomanip>
 
 namespace inkfuse {
@@ -72,6 +73,19 @@ void Date::print(std::ostream& stream, char* data) const
    stream << helpers::dateIntToStr(*reinterpret_cast<int32_t*>(data));
 }
 
+void Decimal::print(std::ostream& stream, char* data) const
+{
+   __int128 value;
+   if (numBytes() == 8) {
+      int64_t raw;
+      std::memcpy(&raw, data, sizeof(raw));
+      value = raw;
+   } else {
+      std::memcpy(&value, data, sizeof(value));
+   }
+   stream << helpers::decimalIntToStr(value, scale);
+}
+
 }
 
 }
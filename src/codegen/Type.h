@@ -185,6 +185,45 @@ struct Date : public SQLType {
    void print(std::ostream& stream, char* data) const override;
 };
 
+/// Fixed-point decimal with `precision` digits, `scale` of them after the decimal point.
+/// The value is stored as an integer scaled by 10^scale: in 8 bytes up to 18 digits,
+/// in 16 bytes up to 38 digits. Precision and scale only matter when planning a query,
+/// the generated code works on the raw integers. The type id thus only contains the width,
+/// so that one primitive serves decimals of every scale.
+struct Decimal : public SQLType {
+   /// Maximum number of digits.
+   static constexpr size_t MAX_PRECISION = 38;
+   /// Maximum number of digits stored in 8 bytes.
+   static constexpr size_t MAX_PRECISION_8_BYTES = 18;
+
+   Decimal(size_t precision_, size_t scale_) : precision(precision_), scale(scale_) {
+      if (precision == 0 || precision > MAX_PRECISION || scale > precision) {
+         throw std::runtime_error("Invalid decimal precision " + std::to_string(precision) + " and scale " + std::to_string(scale));
+      }
+   }
+
+   static TypeArc build(size_t precision, size_t scale) {
+      return std::make_shared<Decimal>(precision, scale);
+   }
+
+   size_t numBytes() const override {
+      return precision <= MAX_PRECISION_8_BYTES ? 8 : 16;
+   }
+
+   std::string id() const override {
+      return "Dec" + std::to_string(numBytes());
+   }
+
+   void print(std::ostream& stream, char* data) const override;
+
+   size_t getPrecision() const { return precision; }
+   size_t getScale() const { return scale; }
+
+   private:
+   size_t precision;
+   size_t scale;
+};
+
 /// Void type which is usually wrapped into pointers for a lack of better options.
 struct Void : public Type {
    static TypeArc build() {
@@ -304,6 +343,8 @@ struct TypeVisitor {
          visitString(*elem, arg);
       } else if (auto elem = dynamic_cast<const IR::Date*>(&type)) {
          visitDate(*elem, arg);
+      } else if (auto elem = dynamic_cast<const IR::Decimal*>(&type)) {
+         visitDecimal(*elem, arg);
       } else if (auto elem = dynamic_cast<const IR::ByteArray*>(&type)) {
          visitByteArray(*elem, arg);
       } else if (auto elem = dynamic_cast<const IR::Void*>(&type)) {
@@ -332,6 +373,8 @@ struct TypeVisitor {
 
    virtual void visitDate(const Date& type, Arg arg) {}
 
+   virtual void visitDecimal(const Decimal& type, Arg arg) {}
+
    virtual void visitByteArray(const ByteArray& type, Arg arg) {}
 
    virtual void visitVoid(const Void& type, Arg arg) {}
@@ -1,9 +1,66 @@
 #include "codegen/Value.h"
+#include <algorithm>
 
 namespace inkfuse {
 
 namespace IR {
 
+LikePattern::LikePattern(std::string pattern_, bool case_insensitive_)
+   : pattern(std::move(pattern_)), case_insensitive(case_insensitive_) {
+   // Split the pattern into the segments between the `%`. Empty segments can be dropped.
+   std::string current;
+   for (char c : pattern) {
+      if (c == '%') {
+         if (!current.empty()) {
+            segments.push_back(std::move(current));
+            current.clear();
+         }
+      } else {
+         // ILIKE compares the lower case characters.
+         current.push_back(case_insensitive && c >= 'A' && c <= 'Z' ? static_cast<char>(c | 0x20) : c);
+      }
+   }
+   if (!current.empty()) {
+      segments.push_back(std::move(current));
+   }
+   const bool anchored_start = pattern.empty() || pattern.front() != '%';
+   const bool anchored_end = pattern.empty() || pattern.back() != '%';
+
+   // Pick the specialized matcher. These only work without single character wildcards.
+   const bool wildcards = std::any_of(segments.begin(), segments.end(), [](const std::string& segment) {
+      return segment.find('_') != std::string::npos;
+   });
+   Kind kind = Kind::General;
+   if (segments.size() == 1 && !wildcards) {
+      if (anchored_start && anchored_end) {
+         kind = Kind::Exact;
+      } else if (anchored_start) {
+         kind = Kind::Prefix;
+      } else if (anchored_end) {
+         kind = Kind::Suffix;
+      } else {
+         kind = Kind::Contains;
+      }
+   }
+
+   raw_segments = std::make_unique<const char*[]>(segments.size());
+   raw_lengths = std::make_unique<uint64_t[]>(segments.size());
+   for (size_t k = 0; k < segments.size(); ++k) {
+      raw_segments[k] = segments[k].c_str();
+      raw_lengths[k] = segments[k].size();
+   }
+   raw_view = LikePatternView{
+      .segments = raw_segments.get(),
+      .lengths = raw_lengths.get(),
+      .num_segments = segments.size(),
+      .kind = static_cast<uint8_t>(kind),
+      .anchored_start = anchored_start,
+      .anchored_end = anchored_end,
+      .case_insensitive = case_insensitive,
+   };
+   erased_view = &raw_view;
 }
 
-}
\ No newline at end of file
+}
+
+}
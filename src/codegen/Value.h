@@ -2,7 +2,9 @@
 #define INKFUSE_VALUE_H
 
 #include "codegen/Type.h"
+#include <cstdint>
 #include <memory>
+#include <vector>
 
 namespace inkfuse {
 
@@ -128,6 +130,49 @@ struct F8 : public Value {
    explicit F8(double value_) : value(value_) {}
 };
 
+/// A decimal value, `value` is scaled by 10^scale of the decimal type.
+struct DecimalVal : public Value {
+   static ValuePtr build(TypeArc type_, __int128 value_) {
+      return ValuePtr(new DecimalVal(std::move(type_), value_));
+   }
+
+   TypeArc getType() const override {
+      return type;
+   }
+
+   std::string str() const override {
+      if (value >= INT64_MIN && value <= INT64_MAX) {
+         return "((" + std::string(type->numBytes() == 8 ? "int64_t" : "__int128") + ") " + std::to_string(static_cast<int64_t>(value)) + "ll)";
+      }
+      // C has no 128 bit literals, assemble the value from its halves.
+      const auto bits = static_cast<unsigned __int128>(value);
+      return "((__int128) (((unsigned __int128) " + std::to_string(static_cast<uint64_t>(bits >> 64)) + "ull << 64) | " + std::to_string(static_cast<uint64_t>(bits)) + "ull))";
+   }
+
+   std::unique_ptr<Value> copy() override {
+      return build(type, value);
+   };
+
+   void* rawData() override {
+      if (type->numBytes() == 8) {
+         return &narrow;
+      }
+      return &value;
+   }
+
+   /// The scaled value.
+   __int128 value;
+
+   private:
+   DecimalVal(TypeArc type_, __int128 value_) : value(value_), type(std::move(type_)), narrow(static_cast<int64_t>(value_)) {
+      assert(dynamic_cast<Decimal*>(type.get()));
+   }
+
+   TypeArc type;
+   /// The value for 8 byte decimals.
+   int64_t narrow;
+};
+
 struct DateVal : public Value {
    int32_t value;
 
@@ -190,6 +235,39 @@ struct StringVal : public Value {
    }
 };
 
+/// A query parameter bound to a value. It behaves like the bound value, but never gets
+/// inlined into generated code. Instead, the code reads it from the operator state. This
+/// way, the code generated for a prepared query stays valid when the parameter is rebound.
+struct ParamVal : public Value {
+   static ValuePtr build(ValuePtr bound_) {
+      return ValuePtr(new ParamVal(std::move(bound_)));
+   }
+
+   TypeArc getType() const override {
+      return bound->getType();
+   }
+
+   bool supportsInlining() const override { return false; };
+
+   std::string str() const override {
+      return bound->str();
+   }
+
+   std::unique_ptr<Value> copy() override {
+      return build(bound->copy());
+   };
+
+   void* rawData() override {
+      return bound->rawData();
+   }
+
+   /// The currently bound value.
+   ValuePtr bound;
+
+   private:
+   explicit ParamVal(ValuePtr bound_) : bound(std::move(bound_)) {}
+};
+
 /// A list of strings.Can be extended to a general-purpose value list in the future.
 struct StringList : public Value {
    struct StringListView {
@@ -243,6 +321,80 @@ struct StringList : public Value {
    }
 };
 
+/// A compiled SQL LIKE pattern. `%` matches any sequence of characters, `_` a single character.
+/// The pattern is split at the `%` into segments once. Matching then only has to check the
+/// anchored first and last segments and search the remaining ones from left to right.
+/// The runtime picks specialized matchers for exact, prefix, suffix and substring patterns.
+struct LikePattern : public Value {
+   /// Specialized matcher the runtime uses for the pattern. The C backend exports the values
+   /// as `enum LikePatternKind` to the runtime, so both sides share them.
+   enum class Kind : uint8_t {
+      /// 'abc' - equality.
+      Exact = 0,
+      /// 'abc%' - single memcmp on the prefix.
+      Prefix = 1,
+      /// '%abc' - single memcmp on the suffix.
+      Suffix = 2,
+      /// '%abc%' - substring search.
+      Contains = 3,
+      /// Everything else, e.g. 'a%b_c%d'.
+      General = 4,
+   };
+
+   /// The matcher as it is interpreted by the runtime.
+   struct LikePatternView {
+      const char** segments;
+      const uint64_t* lengths;
+      uint64_t num_segments;
+      uint8_t kind;
+      bool anchored_start;
+      bool anchored_end;
+      bool case_insensitive;
+   };
+
+   /// Compile a LIKE pattern. ILIKE patterns are matched ignoring the case of ASCII characters.
+   static ValuePtr build(std::string pattern_, bool case_insensitive_ = false) {
+      return ValuePtr(new LikePattern(std::move(pattern_), case_insensitive_));
+   }
+
+   TypeArc getType() const override {
+      // Pointer behind which the actual `LikePatternView` hides.
+      return IR::Pointer::build(IR::Char::build());
+   };
+
+   // The pattern cannot be inlined. It needs to stay an abstract char*.
+   bool supportsInlining() const override { return false; };
+
+   std::string str() const override {
+      throw std::runtime_error("str() on LikePattern not implemented");
+   };
+
+   std::unique_ptr<Value> copy() override {
+      return LikePattern::build(pattern, case_insensitive);
+   };
+
+   void* rawData() override {
+      assert(erased_view == &raw_view);
+      return &erased_view;
+   }
+
+   Kind getKind() const { return static_cast<Kind>(raw_view.kind); }
+
+   /// The original pattern.
+   std::string pattern;
+   /// Is this an ILIKE pattern?
+   bool case_insensitive;
+   /// The segments between the `%`.
+   std::vector<std::string> segments;
+   std::unique_ptr<const char*[]> raw_segments;
+   std::unique_ptr<uint64_t[]> raw_lengths;
+   LikePatternView raw_view;
+   void* erased_view;
+
+   private:
+   LikePattern(std::string pattern_, bool case_insensitive_);
+};
+
 }
 
 }
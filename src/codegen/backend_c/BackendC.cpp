@@ -239,6 +239,14 @@ void BackendC::createPreamble(ScopedWriter& writer, bool is_runtime) {
    writer.stmt(false).stream() << "#include <stdbool.h>\n";
 
    if (is_runtime) {
+       // The LIKE matcher kinds are picked by IR::LikePattern, the runtime dispatches on the same values.
+       using LikeKind = IR::LikePattern::Kind;
+       writer.stmt(false).stream() << "enum LikePatternKind {"
+                                   << " LIKE_EXACT = " << static_cast<int>(LikeKind::Exact) << ","
+                                   << " LIKE_PREFIX = " << static_cast<int>(LikeKind::Prefix) << ","
+                                   << " LIKE_SUFFIX = " << static_cast<int>(LikeKind::Suffix) << ","
+                                   << " LIKE_CONTAINS = " << static_cast<int>(LikeKind::Contains) << ","
+                                   << " LIKE_GENERAL = " << static_cast<int>(LikeKind::General) << " };\n";
        writer.stmt(false).stream() << runtime_functions;
    }
 }
@@ -283,6 +291,15 @@ void BackendC::typeDescription(const IR::Type& type, ScopedWriter::Statement& st
          arg.stream() << "int32_t";
       }
 
+      void visitDecimal(const IR::Decimal& type, ScopedWriter::Statement& arg) override {
+         // Decimals are scaled integers.
+         if (type.numBytes() == 8) {
+            arg.stream() << "int64_t";
+         } else {
+            arg.stream() << "__int128";
+         }
+      }
+
       void visitBool(const IR::Bool& type, ScopedWriter::Statement& arg) override {
          arg.stream() << "bool";
       }
@@ -490,9 +507,15 @@ void BackendC::compileExpression(const IR::Expr& expr, ScopedWriter::Statement&
             {IR::ArithmeticExpr::Opcode::Eq, "=="},
             {IR::ArithmeticExpr::Opcode::Neq, "!="},
          };
+         static const std::unordered_map<IR::ArithmeticExpr::Opcode, std::string> checked_builtins{
+            {IR::ArithmeticExpr::Opcode::Add, "__builtin_add_overflow"},
+            {IR::ArithmeticExpr::Opcode::Subtract, "__builtin_sub_overflow"},
+            {IR::ArithmeticExpr::Opcode::Multiply, "__builtin_mul_overflow"},
+         };
          static const std::unordered_map<IR::ArithmeticExpr::Opcode, std::string> function_call_map{
             {IR::ArithmeticExpr::Opcode::StrInList, "in_strlist"},
             {IR::ArithmeticExpr::Opcode::NotLikeTokens, "not_like_tokens"},
+            {IR::ArithmeticExpr::Opcode::StrLike, "str_like"},
          };
          if (type.code == IR::ArithmeticExpr::Opcode::StrEquals) {
             // Strcmp needs to return 0 for two strings to be equal.
@@ -501,12 +524,64 @@ void BackendC::compileExpression(const IR::Expr& expr, ScopedWriter::Statement&
             stmt.stream() << ", ";
             compileExpression(*type.children[1], stmt);
             stmt.stream() << ") == 0)";
+         } else if (type.code == IR::ArithmeticExpr::Opcode::Min || type.code == IR::ArithmeticExpr::Opcode::Max) {
+            // Select without a branch, the C compiler turns this into a conditional move.
+            // Both children are evaluated twice, so they must not have side effects.
+            const char* cmp = type.code == IR::ArithmeticExpr::Opcode::Min ? " < " : " > ";
+            stmt.stream() << "((";
+            if (dynamic_cast<const IR::String*>(type.children[0]->type.get())) {
+               stmt.stream() << "strcmp(";
+               compileExpression(*type.children[0], stmt);
+               stmt.stream() << ", ";
+               compileExpression(*type.children[1], stmt);
+               stmt.stream() << ")" << cmp << "0";
+            } else {
+               compileExpression(*type.children[0], stmt);
+               stmt.stream() << cmp;
+               compileExpression(*type.children[1], stmt);
+            }
+            stmt.stream() << ") ? (";
+            compileExpression(*type.children[0], stmt);
+            stmt.stream() << ") : (";
+            compileExpression(*type.children[1], stmt);
+            stmt.stream() << "))";
+         } else if (type.code == IR::ArithmeticExpr::Opcode::BitAnd || type.code == IR::ArithmeticExpr::Opcode::ShiftRight) {
+            // Bit operators bind weaker than comparisons in C, parenthesize them.
+            stmt.stream() << "((";
+            compileExpression(*type.children[0], stmt);
+            stmt.stream() << (type.code == IR::ArithmeticExpr::Opcode::BitAnd ? ") & (" : ") >> (");
+            compileExpression(*type.children[1], stmt);
+            stmt.stream() << "))";
          } else if (function_call_map.contains(type.code)) {
             stmt.stream() << function_call_map.at(type.code) << "(";
             compileExpression(*type.children[0], stmt);
             stmt.stream() << ", ";
             compileExpression(*type.children[1], stmt);
             stmt.stream() << ")";
+         } else if (dynamic_cast<const IR::Decimal*>(type.type.get()) && checked_builtins.contains(type.code)) {
+            // Decimal arithmetic is checked, overflows get flagged through `inkfuse_overflow`.
+            // The operands were widened to the result type before.
+            stmt.stream() << "({ ";
+            typeDescription(*type.type, stmt);
+            stmt.stream() << " inkfuse_res; if (" << checked_builtins.at(type.code) << "(";
+            compileExpression(*type.children[0], stmt);
+            stmt.stream() << ", ";
+            compileExpression(*type.children[1], stmt);
+            stmt.stream() << ", &inkfuse_res)) { inkfuse_overflow(); } inkfuse_res; })";
+         } else if (dynamic_cast<const IR::Decimal*>(type.type.get()) && type.code == IR::ArithmeticExpr::Opcode::Divide) {
+            // Checked decimal division. Division by zero and the only overflowing quotient
+            // (minimum / -1) get flagged and produce a zero instead of trapping.
+            stmt.stream() << "({ ";
+            typeDescription(*type.type, stmt);
+            stmt.stream() << " inkfuse_l = ";
+            compileExpression(*type.children[0], stmt);
+            stmt.stream() << "; ";
+            typeDescription(*type.type, stmt);
+            stmt.stream() << " inkfuse_r = ";
+            compileExpression(*type.children[1], stmt);
+            stmt.stream() << "; ";
+            typeDescription(*type.type, stmt);
+            stmt.stream() << " inkfuse_res = 0; if (inkfuse_r == 0 || (inkfuse_r == -1 && __builtin_mul_overflow(inkfuse_l, inkfuse_r, &inkfuse_res))) { inkfuse_overflow(); inkfuse_res = 0; } else { inkfuse_res = inkfuse_l / inkfuse_r; } inkfuse_res; })";
          } else {
             // Regular arithmethic operation that's directly supported by C.
             assert(opcode_map.count(type.code));
@@ -534,6 +609,31 @@ void BackendC::compileExpression(const IR::Expr& expr, ScopedWriter::Statement&
       }
 
       void visitCast(const IR::CastExpr& type, ScopedWriter::Statement& stmt) override {
+         const auto& source = *type.children[0]->type;
+         const bool from_decimal = dynamic_cast<const IR::Decimal*>(&source);
+         const bool to_decimal = dynamic_cast<const IR::Decimal*>(type.type.get());
+         auto integral = [](const IR::Type& t) {
+            return dynamic_cast<const IR::Decimal*>(&t) || dynamic_cast<const IR::SignedInt*>(&t) || dynamic_cast<const IR::UnsignedInt*>(&t);
+         };
+         if ((from_decimal || to_decimal) && integral(source) && integral(*type.type)) {
+            // Checked integral cast, flags values not representable in the target.
+            stmt.stream() << "({ ";
+            typeDescription(*type.type, stmt);
+            stmt.stream() << " inkfuse_res; if (__builtin_add_overflow(";
+            compileExpression(*type.children[0], stmt);
+            stmt.stream() << ", 0, &inkfuse_res)) { inkfuse_overflow(); } inkfuse_res; })";
+            return;
+         }
+         if (to_decimal && dynamic_cast<const IR::Float*>(&source)) {
+            // Checked floating point cast, out of range values (and NaN) are flagged and become zero.
+            const char* bound = type.type->numBytes() == 8 ? "0x1p63" : "0x1p127";
+            stmt.stream() << "({ double inkfuse_val = ";
+            compileExpression(*type.children[0], stmt);
+            stmt.stream() << "; if (!(inkfuse_val >= -" << bound << " && inkfuse_val < " << bound << ")) { inkfuse_overflow(); inkfuse_val = 0; } ((";
+            typeDescription(*type.type, stmt);
+            stmt.stream() << ") inkfuse_val); })";
+            return;
+         }
          // Set up cast into target type.
          stmt.stream() << "((";
          typeDescription(*type.type, stmt);
@@ -40,5 +40,139 @@ bool not_like_tokens(const char* strlist, char* arg) {
     // If all tokens were found in the argument, return false 
     return false;
 }
+
+struct LikePattern {
+    const char** segments;
+    const uint64_t* lengths;
+    uint64_t num_segments;
+    // One of the LikePatternKind values.
+    uint8_t kind;
+    bool anchored_start;
+    bool anchored_end;
+    bool case_insensitive;
+};
+
+typedef signed char like_vec __attribute__((vector_size(16)));
+
+static inline char like_lower(char c) {
+    return (c >= 'A' && c <= 'Z') ? (char) (c | 0x20) : c;
+}
+
+// Compare a pattern segment with the string, '_' matches any character.
+static inline bool like_segment_eq(const char* str, const char* segment, uint64_t len, bool ci) {
+    for (uint64_t k = 0; k < len; ++k) {
+        const char c = ci ? like_lower(str[k]) : str[k];
+        if (segment[k] != '_' && segment[k] != c) {
+            return false;
+        }
+    }
+    return true;
+}
+
+// Compare a pattern segment without wildcards with the string.
+static inline bool like_literal_eq(const char* str, const char* segment, uint64_t len, bool ci) {
+    return ci ? like_segment_eq(str, segment, len, ci) : memcmp(str, segment, len) == 0;
+}
+
+static inline like_vec like_load(const char* ptr, bool ci) {
+    like_vec v;
+    memcpy(&v, ptr, 16);
+    if (ci) {
+        const like_vec upper = (v >= 'A') & (v <= 'Z');
+        v |= upper & 0x20;
+    }
+    return v;
+}
+
+// Find the first occurrence of the segment in str[0, n). UINT64_MAX if there is none.
+static uint64_t like_find(const char* str, uint64_t n, const char* segment, uint64_t len, bool ci) {
+    if (len > n) {
+        return UINT64_MAX;
+    }
+    const uint64_t last = n - len;
+    uint64_t pos = 0;
+    if (segment[0] != '_' && segment[len - 1] != '_') {
+        // Check 16 start positions at once on the first and the last character of the segment.
+        // Only the few positions where both match get compared fully.
+        const like_vec first_c = (like_vec){} + (signed char) segment[0];
+        const like_vec last_c = (like_vec){} + (signed char) segment[len - 1];
+        for (; pos + 16 <= last + 1; pos += 16) {
+            const like_vec candidates = (like_load(str + pos, ci) == first_c) & (like_load(str + pos + len - 1, ci) == last_c);
+            uint64_t words[2];
+            memcpy(words, &candidates, 16);
+            for (uint64_t w = 0; w < 2; ++w) {
+                while (words[w]) {
+                    const uint64_t bit = __builtin_ctzll(words[w]);
+                    const uint64_t candidate = pos + 8 * w + bit / 8;
+                    if (like_segment_eq(str + candidate, segment, len, ci)) {
+                        return candidate;
+                    }
+                    words[w] &= ~(0xFFull << (bit & ~7ull));
+                }
+            }
+        }
+    }
+    for (; pos <= last; ++pos) {
+        if (like_segment_eq(str + pos, segment, len, ci)) {
+            return pos;
+        }
+    }
+    return UINT64_MAX;
+}
+
+bool str_like(const char* pattern, char* arg) {
+    const struct LikePattern* like = (const struct LikePattern*) pattern;
+    const uint64_t n = strlen(arg);
+    const bool ci = like->case_insensitive;
+    // Specialized matchers for patterns with a single segment and without wildcards.
+    switch ((enum LikePatternKind) like->kind) {
+        case LIKE_EXACT:
+            return n == like->lengths[0] && like_literal_eq(arg, like->segments[0], n, ci);
+        case LIKE_PREFIX:
+            return n >= like->lengths[0] && like_literal_eq(arg, like->segments[0], like->lengths[0], ci);
+        case LIKE_SUFFIX:
+            return n >= like->lengths[0] && like_literal_eq(arg + n - like->lengths[0], like->segments[0], like->lengths[0], ci);
+        case LIKE_CONTAINS:
+            return like_find(arg, n, like->segments[0], like->lengths[0], ci) != UINT64_MAX;
+        case LIKE_GENERAL:
+            break;
+    }
+
+    // General pattern: check the anchored segments, then search the others from left to right.
+    if (like->num_segments == 0) {
+        return !(like->anchored_start && like->anchored_end) || n == 0;
+    }
+    uint64_t begin = 0;
+    uint64_t end = n;
+    uint64_t first = 0;
+    uint64_t last = like->num_segments;
+    if (like->anchored_start) {
+        if (like->lengths[0] > n || !like_segment_eq(arg, like->segments[0], like->lengths[0], ci)) {
+            return false;
+        }
+        begin = like->lengths[0];
+        first = 1;
+    }
+    if (like->anchored_end) {
+        if (first == last) {
+            // A single segment anchored at both ends has to cover the full string.
+            return begin == n;
+        }
+        const uint64_t len = like->lengths[last - 1];
+        if (len > end - begin || !like_segment_eq(arg + n - len, like->segments[last - 1], len, ci)) {
+            return false;
+        }
+        end = n - len;
+        last--;
+    }
+    for (uint64_t k = first; k < last; ++k) {
+        const uint64_t pos = like_find(arg + begin, end - begin, like->segments[k], like->lengths[k], ci);
+        if (pos == UINT64_MAX) {
+            return false;
+        }
+        begin += pos + like->lengths[k];
+    }
+    return true;
+}
 )PRE";
 };
@@ -1,4 +1,5 @@
 #include "common/Helpers.h"
+#include "common/Numa.h"
 #include "date.h"
 #include <chrono>
 #include <iostream>
@@ -20,6 +21,76 @@ std::string dateIntToStr(int32_t date) {
    return stream.str();
 }
 
+__int128 decimalStrToInt(const char* str, size_t precision, size_t scale) {
+   const char* pos = str;
+   while (*pos == ' ') {
+      pos++;
+   }
+   const bool negative = *pos == '-';
+   if (*pos == '-' || *pos == '+') {
+      pos++;
+   }
+   __int128 value = 0;
+   size_t digits = 0;
+   // Leading zeros don't count towards the precision. Checking every digit keeps the value from overflowing.
+   auto push_digit = [&](int digit) {
+      value = value * 10 + digit;
+      if (value != 0 && ++digits > precision) {
+         throw std::runtime_error(std::string("Decimal literal ") + str + " exceeds " + std::to_string(precision) + " digits");
+      }
+   };
+   size_t fraction_digits = 0;
+   bool fraction = false;
+   bool any_digit = false;
+   for (; *pos; ++pos) {
+      if (*pos == '.' && !fraction) {
+         fraction = true;
+         continue;
+      }
+      if (*pos < '0' || *pos > '9') {
+         break;
+      }
+      any_digit = true;
+      if (fraction && fraction_digits == scale) {
+         // Truncate digits beyond the scale.
+         continue;
+      }
+      push_digit(*pos - '0');
+      fraction_digits += fraction;
+   }
+   if (!any_digit) {
+      throw std::runtime_error(std::string("Invalid decimal literal ") + str);
+   }
+   // Scale up missing fraction digits.
+   for (; fraction_digits < scale; ++fraction_digits) {
+      push_digit(0);
+   }
+   return negative ? -value : value;
+}
+
+std::string decimalIntToStr(__int128 value, size_t scale) {
+   const bool negative = value < 0;
+   // Go through the unsigned representation, the negation of the smallest value overflows.
+   unsigned __int128 abs = negative ? -static_cast<unsigned __int128>(value) : static_cast<unsigned __int128>(value);
+   std::string digits;
+   do {
+      digits.push_back(static_cast<char>('0' + abs % 10));
+      abs /= 10;
+   } while (abs != 0);
+   // At least one digit in front of the decimal point.
+   while (digits.size() <= scale) {
+      digits.push_back('0');
+   }
+   std::string result = negative ? "-" : "";
+   for (size_t k = digits.size(); k > 0; --k) {
+      result.push_back(digits[k - 1]);
+      if (k - 1 == scale && scale != 0) {
+         result.push_back('.');
+      }
+   }
+   return result;
+}
+
 void loadDataInto(Schema& schema, const std::string& path, bool force) {
    for (auto& [tbl_name, tbl]: schema) {
       std::ifstream input;
@@ -29,6 +100,10 @@ void loadDataInto(Schema& schema, const std::string& path, bool force) {
       input.open(path + "/" + tbl_name + ".tbl");
       tbl->loadRows(input);
       input.close();
+      if (numa::numNodes() > 1) {
+         // Spread the rows across the NUMA nodes, scans then prefer node-local morsels.
+         tbl->partitionNuma(numa::numNodes());
+      }
    }
 }
 
@@ -16,8 +16,16 @@ int32_t dateStrToInt(const char* str);
 /// The date is stored as offset to the epoch 1-1-1970.
 std::string dateIntToStr(int32_t date);
 
+/// Transform a decimal literal into the integer scaled by 10^scale represented in the runtime.
+/// Digits beyond the scale are truncated. Throws if the value has more than `precision` digits.
+__int128 decimalStrToInt(const char* str, size_t precision, size_t scale);
+
+/// Transform a decimal scaled by 10^scale into a literal.
+std::string decimalIntToStr(__int128 value, size_t scale);
+
 /// Load data into the backing columns of a schema.
 /// Looks for '|' separated .tbl files within the directory of `path`.
+/// On machines with multiple NUMA nodes the loaded relations are partitioned across them.
 void loadDataInto(Schema& schema, const std::string& path, bool force = false);
 
 } // namespace inkfuse
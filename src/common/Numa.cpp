@@ -0,0 +1,128 @@
+#include "common/Numa.h"
+#include <cassert>
+#include <filesystem>
+#include <fstream>
+#include <pthread.h>
+#include <sched.h>
+#include <string>
+#include <thread>
+
+namespace inkfuse::numa {
+
+namespace {
+
+/// Parse a sysfs list of the form "0-3,8,10-11", used both for CPUs and for nodes.
+std::vector<size_t> parseCpuList(const std::string& list) {
+   std::vector<size_t> result;
+   size_t pos = 0;
+   while (pos < list.size()) {
+      size_t end = list.find(',', pos);
+      if (end == std::string::npos) {
+         end = list.size();
+      }
+      const std::string range = list.substr(pos, end - pos);
+      const size_t dash = range.find('-');
+      if (!range.empty()) {
+         const size_t from = std::stoull(range.substr(0, dash));
+         const size_t to = dash == std::string::npos ? from : std::stoull(range.substr(dash + 1));
+         for (size_t cpu = from; cpu <= to; ++cpu) {
+            result.push_back(cpu);
+         }
+      }
+      pos = end + 1;
+   }
+   return result;
+}
+
+struct Topology {
+   Topology() {
+      const std::filesystem::path base{"/sys/devices/system/node"};
+      // Node IDs can be sparse, e.g. with offline nodes. Enumerate the online ones.
+      std::ifstream online(base / "online");
+      std::string online_list;
+      if (online.good()) {
+         std::getline(online, online_list);
+      }
+      for (size_t node_id : parseCpuList(online_list)) {
+         std::ifstream cpulist(base / ("node" + std::to_string(node_id)) / "cpulist");
+         if (!cpulist.good()) {
+            continue;
+         }
+         std::string line;
+         std::getline(cpulist, line);
+         auto cpus = parseCpuList(line);
+         if (cpus.empty()) {
+            // Memory-only nodes have no CPUs to first-touch their memory from.
+            continue;
+         }
+         const size_t node = node_cpus.size();
+         for (size_t cpu : cpus) {
+            if (cpu >= cpu_to_node.size()) {
+               cpu_to_node.resize(cpu + 1, 0);
+            }
+            cpu_to_node[cpu] = node;
+         }
+         node_cpus.push_back(std::move(cpus));
+      }
+      if (node_cpus.empty()) {
+         // No NUMA information available - treat the machine as a single node with all CPUs.
+         auto& cpus = node_cpus.emplace_back();
+         for (size_t cpu = 0; cpu < std::thread::hardware_concurrency(); ++cpu) {
+            cpus.push_back(cpu);
+         }
+      }
+   }
+
+   /// CPUs of every node. Nodes are numbered densely, independent of their sysfs IDs.
+   std::vector<std::vector<size_t>> node_cpus;
+   /// Reverse mapping from CPU to node.
+   std::vector<size_t> cpu_to_node;
+};
+
+const Topology& getTopology() {
+   static Topology topology;
+   return topology;
+}
+
+}
+
+size_t numNodes() {
+   return getTopology().node_cpus.size();
+}
+
+size_t currentNode() {
+   const auto& topology = getTopology();
+   const int cpu = sched_getcpu();
+   if (cpu < 0 || static_cast<size_t>(cpu) >= topology.cpu_to_node.size()) {
+      return 0;
+   }
+   return topology.cpu_to_node[cpu];
+}
+
+const std::vector<size_t>& cpusOfNode(size_t node) {
+   assert(node < numNodes());
+   return getTopology().node_cpus[node];
+}
+
+void runOnNodes(const std::vector<size_t>& nodes, const std::vector<std::function<void()>>& fns) {
+   assert(nodes.size() == fns.size());
+   std::vector<std::thread> threads;
+   threads.reserve(fns.size());
+   for (size_t k = 0; k < fns.size(); ++k) {
+      threads.emplace_back([&, k]() {
+         cpu_set_t set;
+         CPU_ZERO(&set);
+         for (size_t cpu : cpusOfNode(nodes[k] % numNodes())) {
+            CPU_SET(cpu, &set);
+         }
+         // Pinning is best effort - if it fails the memory just ends up wherever we are running.
+         pthread_setaffinity_np(pthread_self(), sizeof(set), &set);
+         fns[k]();
+      });
+   }
+   for (auto& thread : threads) {
+      thread.join();
+   }
+}
+
+} // namespace inkfuse::numa
@@ -0,0 +1,30 @@
+#ifndef INKFUSE_NUMA_H
+#define INKFUSE_NUMA_H
+
+#include <cstddef>
+#include <functional>
+#include <vector>
+
+/// Minimal NUMA topology helpers. We deliberately don't depend on libnuma:
+/// the topology is read from sysfs and memory placement relies on the
+/// first-touch policy of the kernel.
+/// On machines where the topology cannot be read, everything collapses to a single node.
+/// Nodes are numbered densely from zero, sparse sysfs node IDs are compacted.
+namespace inkfuse::numa {
+
+/// How many NUMA nodes does this machine have?
+size_t numNodes();
+
+/// On which NUMA node is the calling thread currently running?
+size_t currentNode();
+
+/// The CPUs belonging to the given NUMA node.
+const std::vector<size_t>& cpusOfNode(size_t node);
+
+/// Run the functions concurrently, the i-th one on a thread pinned to the CPUs of `nodes[i]`.
+/// Blocks until all functions are done. Used to first-touch memory on a specific node.
+void runOnNodes(const std::vector<size_t>& nodes, const std::vector<std::function<void()>>& fns);
+
+} // namespace inkfuse::numa
+
+#endif // INKFUSE_NUMA_H
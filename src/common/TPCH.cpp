@@ -1,9 +1,12 @@
 #include "common/TPCH.h"
+#include "algebra/AdaptiveFilter.h"
 #include "algebra/Aggregation.h"
 #include "algebra/ExpressionOp.h"
 #include "algebra/Filter.h"
+#include "algebra/GroupJoin.h"
 #include "algebra/Join.h"
 #include "algebra/Print.h"
+#include "algebra/Sort.h"
 #include "algebra/TableScan.h"
 #include "common/Helpers.h"
 
@@ -167,6 +170,14 @@ Schema getTPCHSchema() {
    return schema;
 }
 
+ConjunctStatisticsArc FilterStatistics::get(const std::string& filter, size_t num_conjuncts) {
+   auto& stats = filters[filter];
+   if (!stats) {
+      stats = std::make_shared<ConjunctStatistics>(num_conjuncts);
+   }
+   return stats;
+}
+
 std::unique_ptr<Print> q1(const Schema& schema) {
    // 1. Scan from lineitem.
    auto& rel = schema.at("lineitem");
@@ -283,16 +294,25 @@ std::unique_ptr<Print> q1(const Schema& schema) {
       std::move(group_by),
       std::move(aggregates));
 
-   // TODO(benjamin) ORDER BY
+   // Order by (l_returnflag, l_linestatus).
+   const auto& agg_out = agg->getOutput();
+   std::vector<const IU*> sort_payload(agg_out.begin() + 2, agg_out.end());
+   std::vector<RelAlgOpPtr> sort_children;
+   sort_children.push_back(std::move(agg));
+   auto sort = Sort::build(
+      std::move(sort_children),
+      "sort",
+      {{agg_out[0]}, {agg_out[1]}},
+      std::move(sort_payload));
 
    // Attach the sink for printing.
    std::vector<const IU*> out_ius;
-   out_ius.reserve(agg->getOutput().size());
-   for (const IU* iu : agg->getOutput()) {
+   out_ius.reserve(sort->getOutput().size());
+   for (const IU* iu : sort->getOutput()) {
       out_ius.push_back(iu);
    }
    std::vector<RelAlgOpPtr> print_children;
-   print_children.push_back(std::move(agg));
+   print_children.push_back(std::move(sort));
    std::vector<std::string> colnames = {
       "l_returnflag",
       "l_linestatus",
@@ -509,18 +529,32 @@ std::unique_ptr<Print> q3(const Schema& schema) {
       std::move(group_by),
       std::move(aggregates));
 
-   // 4. Print
+   // 4. Order by (revenue desc, o_orderdate) limit 10.
+   const IU* l_orderkey = agg->getOutput()[0];
+   const IU* o_orderdate = agg->getOutput()[1];
+   const IU* o_shippriority = agg->getOutput()[2];
+   const IU* revenue = agg->getOutput()[3];
+   std::vector<RelAlgOpPtr> sort_children;
+   sort_children.push_back(std::move(agg));
+   auto sort = Sort::build(
+      std::move(sort_children),
+      "sort",
+      {{revenue, false}, {o_orderdate}},
+      {l_orderkey, o_shippriority},
+      10);
+
+   // 5. Print
    std::vector<const IU*> out_ius{
-      agg->getOutput()[0],
-      agg->getOutput()[3],
-      agg->getOutput()[1],
-      agg->getOutput()[2],
+      sort->getOutput()[2],
+      sort->getOutput()[0],
+      sort->getOutput()[1],
+      sort->getOutput()[3],
    };
    std::vector<std::string> colnames = {"l_orderkey", "revenue", "o_orderdate", "o_shippriority"};
    std::vector<RelAlgOpPtr> print_children;
-   print_children.push_back(std::move(agg));
+   print_children.push_back(std::move(sort));
    return Print::build(std::move(print_children),
-                       std::move(out_ius), std::move(colnames), "q3_print", 10);
+                       std::move(out_ius), std::move(colnames), "q3_print");
 }
 
 std::unique_ptr<Print> q4(const Schema& schema) {
@@ -649,14 +683,25 @@ std::unique_ptr<Print> q4(const Schema& schema) {
       std::move(group_by),
       std::move(aggregates));
 
-   // 5. Print.
+   // 5. Order by (o_orderpriority).
+   const IU* priority = agg->getOutput()[0];
+   const IU* order_count = agg->getOutput()[1];
+   std::vector<RelAlgOpPtr> sort_children;
+   sort_children.push_back(std::move(agg));
+   auto sort = Sort::build(
+      std::move(sort_children),
+      "sort",
+      {{priority}},
+      {order_count});
+
+   // 6. Print.
    std::vector<const IU*> out_ius{
-      agg->getOutput()[0],
-      agg->getOutput()[1],
+      sort->getOutput()[0],
+      sort->getOutput()[1],
    };
    std::vector<std::string> colnames = {"o_orderpriority", "order_count"};
    std::vector<RelAlgOpPtr> print_children;
-   print_children.push_back(std::move(agg));
+   print_children.push_back(std::move(sort));
    return Print::build(std::move(print_children),
                        std::move(out_ius), std::move(colnames), "print");
 }
@@ -965,7 +1010,7 @@ std::unique_ptr<Print> q5(const Schema& schema) {
                        std::move(out_ius), std::move(colnames));
 }
 
-std::unique_ptr<Print> q6(const Schema& schema) {
+std::unique_ptr<Print> q6(const Schema& schema, FilterStatistics* stats) {
    // 1. Scan from lineitem.
    auto& rel = schema.at("lineitem");
    std::vector<std::string> cols{
@@ -976,78 +1021,66 @@ std::unique_ptr<Print> q6(const Schema& schema) {
    auto scan = TableScan::build(*rel, cols, "scan");
    auto& scan_ref = *scan;
 
-   // 2. Evaluate the filter predicate.
-   std::vector<RelAlgOpPtr> children_scan;
-   children_scan.push_back(std::move(scan));
-   std::vector<ExpressionOp::NodePtr> pred_nodes;
-
-   auto l_shipdate_ref = pred_nodes.emplace_back(std::make_unique<IURefNode>(
-                                                    scan_ref.getOutput()[getScanIndex("l_shipdate", cols)]))
-                            .get();
-   auto l_discount_ref = pred_nodes.emplace_back(std::make_unique<IURefNode>(
-                                                    scan_ref.getOutput()[getScanIndex("l_discount", cols)]))
-                            .get();
-   auto l_quantity_ref = pred_nodes.emplace_back(std::make_unique<IURefNode>(
-                                                    scan_ref.getOutput()[getScanIndex("l_quantity", cols)]))
-                            .get();
-   auto pred_1 = pred_nodes.emplace_back(std::make_unique<ComputeNode>(
-                                            ComputeNode::Type::LessEqual,
-                                            IR::DateVal::build(helpers::dateStrToInt("1994-01-01")),
-                                            l_shipdate_ref))
-                    .get();
-   auto pred_2 = pred_nodes.emplace_back(std::make_unique<ComputeNode>(
-                                            ComputeNode::Type::Greater,
-                                            IR::DateVal::build(helpers::dateStrToInt("1995-01-01")),
-                                            l_shipdate_ref))
-                    .get();
-   // We have some rounding issues if we don't use 0.01001.
-   auto pred_3 = pred_nodes.emplace_back(std::make_unique<ComputeNode>(
-                                            ComputeNode::Type::LessEqual,
-                                            IR::F8::build(0.06 - 0.01001),
-                                            l_discount_ref))
-                    .get();
-   auto pred_4 = pred_nodes.emplace_back(std::make_unique<ComputeNode>(
-                                            ComputeNode::Type::GreaterEqual,
-                                            IR::F8::build(0.06 + 0.01001),
-                                            l_discount_ref))
-                    .get();
-   auto pred_5 = pred_nodes.emplace_back(std::make_unique<ComputeNode>(
-                                            ComputeNode::Type::Greater,
-                                            IR::F8::build(24),
-                                            l_quantity_ref))
-                    .get();
-   auto and_1 = pred_nodes.emplace_back(std::make_unique<ComputeNode>(
-                                           ComputeNode::Type::And,
-                                           std::vector<Node*>{pred_1, pred_2}))
-                   .get();
-   auto and_2 = pred_nodes.emplace_back(std::make_unique<ComputeNode>(
-                                           ComputeNode::Type::And,
-                                           std::vector<Node*>{pred_3, pred_4}))
-                   .get();
-   auto and_3 = pred_nodes.emplace_back(std::make_unique<ComputeNode>(
-                                           ComputeNode::Type::And,
-                                           std::vector<Node*>{and_1, and_2}))
-                   .get();
-   auto and_4 = pred_nodes.emplace_back(std::make_unique<ComputeNode>(
-                                           ComputeNode::Type::And,
-                                           std::vector<Node*>{and_3, pred_5}))
-                   .get();
-
-   auto expr_node = ExpressionOp::build(
-      std::move(children_scan),
-      "lineitem_filter",
-      std::vector<Node*>{and_4},
-      std::move(pred_nodes));
-   auto& expr_ref = *expr_node;
-   assert(expr_ref.getOutput().size() == 1);
+   // 2. Filter on the conjuncts, the most selective ones are learned while running the query.
+   std::vector<AdaptiveFilter::Conjunct> conjuncts(3);
+   {
+      // l_shipdate >= date '1994-01-01' and l_shipdate < date '1995-01-01'
+      auto& nodes = conjuncts[0].nodes;
+      auto l_shipdate_ref = nodes.emplace_back(std::make_unique<IURefNode>(
+                                                  scan_ref.getOutput()[getScanIndex("l_shipdate", cols)]))
+                               .get();
+      auto pred_1 = nodes.emplace_back(std::make_unique<ComputeNode>(
+                                          ComputeNode::Type::LessEqual,
+                                          IR::DateVal::build(helpers::dateStrToInt("1994-01-01")),
+                                          l_shipdate_ref))
+                       .get();
+      auto pred_2 = nodes.emplace_back(std::make_unique<ComputeNode>(
+                                          ComputeNode::Type::Greater,
+                                          IR::DateVal::build(helpers::dateStrToInt("1995-01-01")),
+                                          l_shipdate_ref))
+                       .get();
+      conjuncts[0].root = Andify(nodes, {pred_1, pred_2});
+   }
+   {
+      // l_discount between 0.06 - 0.01 and 0.06 + 0.01
+      auto& nodes = conjuncts[1].nodes;
+      auto l_discount_ref = nodes.emplace_back(std::make_unique<IURefNode>(
+                                                  scan_ref.getOutput()[getScanIndex("l_discount", cols)]))
+                               .get();
+      // We have some rounding issues if we don't use 0.01001.
+      auto pred_1 = nodes.emplace_back(std::make_unique<ComputeNode>(
+                                          ComputeNode::Type::LessEqual,
+                                          IR::F8::build(0.06 - 0.01001),
+                                          l_discount_ref))
+                       .get();
+      auto pred_2 = nodes.emplace_back(std::make_unique<ComputeNode>(
+                                          ComputeNode::Type::GreaterEqual,
+                                          IR::F8::build(0.06 + 0.01001),
+                                          l_discount_ref))
+                       .get();
+      conjuncts[1].root = Andify(nodes, {pred_1, pred_2});
+   }
+   {
+      // l_quantity < 24
+      auto& nodes = conjuncts[2].nodes;
+      auto l_quantity_ref = nodes.emplace_back(std::make_unique<IURefNode>(
+                                                  scan_ref.getOutput()[getScanIndex("l_quantity", cols)]))
+                               .get();
+      conjuncts[2].root = nodes.emplace_back(std::make_unique<ComputeNode>(
+                                                ComputeNode::Type::Greater,
+                                                IR::F8::build(24),
+                                                l_quantity_ref))
+                             .get();
+   }
+   // Shared by all instances built with the same statistics, later ones evaluate the conjuncts in the learned order.
+   auto filter_stats = stats ? stats->get("q6_filter", conjuncts.size()) : nullptr;
 
-   // 3. Filter
    std::vector<RelAlgOpPtr> children_filter;
-   children_filter.push_back(std::move(expr_node));
+   children_filter.push_back(std::move(scan));
    std::vector<const IU*> redefined{
       scan_ref.getOutput()[getScanIndex("l_extendedprice", cols)],
       scan_ref.getOutput()[getScanIndex("l_discount", cols)]};
-   auto filter = Filter::build(std::move(children_filter), "filter", std::move(redefined), *expr_ref.getOutput()[0]);
+   auto filter = AdaptiveFilter::build(std::move(children_filter), "filter", std::move(redefined), std::move(conjuncts), std::move(filter_stats));
    auto& filter_ref = *filter;
    assert(filter->getOutput().size() == 2);
 
@@ -1112,20 +1145,11 @@ std::unique_ptr<Print> q13(const Schema& schema) {
    auto orders_scan = TableScan::build(*orders_rel, orders_cols, "scan_orders");
    auto& orders_scan_ref = *orders_scan;
 
-   // Evaluate the o_comment expression and project constant NULL byte -> always 0.
+   // Evaluate the o_comment expression.
    std::vector<ExpressionOp::NodePtr> pred_nodes;
-   auto o_custkey_ref = pred_nodes.emplace_back(std::make_unique<IURefNode>(
-                                                   orders_scan_ref.getOutput()[0]))
-                           .get();
    auto o_comment_ref = pred_nodes.emplace_back(std::make_unique<IURefNode>(
                                                    orders_scan_ref.getOutput()[1]))
                            .get();
-   auto p_null_byte = pred_nodes.emplace_back(
-                                   std::make_unique<ComputeNode>(
-                                      ComputeNode::Type::Constant,
-                                      IR::UI<1>::build(0),
-                                      o_custkey_ref))
-                         .get();
    auto p_container_pred = pred_nodes.emplace_back(
                                         std::make_unique<ComputeNode>(
                                            ComputeNode::Type::NotLikeTokens,
@@ -1137,10 +1161,10 @@ std::unique_ptr<Print> q13(const Schema& schema) {
    auto expr_node = ExpressionOp::build(
       std::move(children_expr),
       "orders_filter",
-      std::vector<Node*>{p_container_pred, p_null_byte},
+      std::vector<Node*>{p_container_pred},
       std::move(pred_nodes));
    auto& expr_ref = *expr_node;
-   assert(expr_ref.getOutput().size() == 2);
+   assert(expr_ref.getOutput().size() == 1);
 
    // Filter orders that don't match the predicate.
    std::vector<RelAlgOpPtr> filter_children;
@@ -1148,50 +1172,34 @@ std::unique_ptr<Print> q13(const Schema& schema) {
    auto filter = Filter::build(
       std::move(filter_children),
       "filter_orders",
-      // We need (o_custkey, nullbyte)
+      // We need o_custkey
       {
          orders_scan_ref.getOutput()[0],
-         expr_ref.getOutput()[1],
       },
       *expr_ref.getOutput()[0]);
    auto& filter_ref = *filter;
 
-   // 3. Outer join.
+   // 3. Outer group join counting the orders of every customer. Customers without
+   // orders get a count of zero. The join keys are the primary key of customer, so
+   // the join and the aggregation on c_custkey share a single hash table.
    std::vector<RelAlgOpPtr> join_children;
    join_children.push_back(std::move(c_scan));
    join_children.push_back(std::move(filter));
-   auto join = Join::build(
+   std::vector<AggregateFunctions::Description> aggregates_1{
+      {*filter_ref.getOutput()[0], AggregateFunctions::Opcode::Count}};
+   auto agg_1 = GroupJoin::build(
       std::move(join_children),
-      "join",
+      "group_join",
       // Keys left (c_custkey)
       {c_scan_ref.getOutput()[0]},
       // Payload left (none)
       {},
       // Keys right (o_custkey)
       {filter_ref.getOutput()[0]},
-      // Right payload (nullbyte)
-      {
-         filter_ref.getOutput()[1],
-      },
-      JoinType::LeftOuter,
-      true);
-   auto& join_ref = *join;
-   assert(join_ref.getOutput().size() == 3);
-
-   // 4. Aggregate 1.
-   std::vector<RelAlgOpPtr> agg_1_children;
-   agg_1_children.push_back(std::move(join));
-   std::vector<const IU*> group_by_1{
-      join_ref.getOutput()[0],
-   };
-   std::vector<AggregateFunctions::Description> aggregates_1{
-      {*join_ref.getOutput()[1], AggregateFunctions::Opcode::Count}};
-   auto agg_1 = Aggregation::build(
-      std::move(agg_1_children),
-      "agg",
-      std::move(group_by_1),
-      std::move(aggregates_1));
+      std::move(aggregates_1),
+      JoinType::LeftOuter);
    auto& agg_1_ref = *agg_1;
+   assert(agg_1_ref.getOutput().size() == 2);
 
    // 4. Aggregate 2.
    std::vector<RelAlgOpPtr> agg_2_children;
@@ -1208,15 +1216,25 @@ std::unique_ptr<Print> q13(const Schema& schema) {
       std::move(aggregates_2));
    auto& agg_2_ref = *agg_2;
 
+   // 5. Order by (custdist desc, c_count desc).
+   std::vector<RelAlgOpPtr> sort_children;
+   sort_children.push_back(std::move(agg_2));
+   auto sort = Sort::build(
+      std::move(sort_children),
+      "sort",
+      {{agg_2_ref.getOutput()[1], false}, {agg_2_ref.getOutput()[0], false}},
+      {});
+   auto& sort_ref = *sort;
+
    // And output.
    std::vector<const IU*> out_ius{
-      agg_2_ref.getOutput()[0],
-      agg_2_ref.getOutput()[1],
+      sort_ref.getOutput()[1],
+      sort_ref.getOutput()[0],
    };
 
    std::vector<std::string> colnames = {"c_count", "custdist"};
    std::vector<RelAlgOpPtr> print_children;
-   print_children.push_back(std::move(agg_2));
+   print_children.push_back(std::move(sort));
    return Print::build(std::move(print_children),
                        std::move(out_ius), std::move(colnames));
 }
@@ -1460,7 +1478,8 @@ std::unique_ptr<Print> q18(const Schema& schema) {
    auto& l_o_c_join_ref = *l_o_c_join;
    assert(l_o_c_join_ref.getOutput().size() == 3);
 
-   // 5. Join back on lineitem.
+   // 5. Group join back on lineitem. Every order is unique on the build side, so the
+   // sum(l_quantity) gets aggregated directly within the join hash table.
    std::vector<std::string> l_2_cols{"l_orderkey", "l_quantity"};
    auto l_2_scan = TableScan::build(*l_1_rel, l_2_cols, "scan_lineitem_2");
    auto& l_2_scan_ref = *l_2_scan;
@@ -1468,37 +1487,21 @@ std::unique_ptr<Print> q18(const Schema& schema) {
    std::vector<RelAlgOpPtr> l_o_c_l_join_children;
    l_o_c_l_join_children.push_back(std::move(l_o_c_join));
    l_o_c_l_join_children.push_back(std::move(l_2_scan));
-   auto l_o_c_l_join = Join::build(
+   std::vector<AggregateFunctions::Description> final_aggregates{
+      {*l_2_scan_ref.getOutput()[1], AggregateFunctions::Opcode::Sum}};
+   auto final_agg = GroupJoin::build(
       std::move(l_o_c_l_join_children),
-      "l_o_c_l_join",
+      "l_o_c_l_group_join",
       // Keys left (o_orderkey)
       {l_o_c_join_ref.getOutput()[2]},
       // Payload left (none)
       {},
       // Keys right (l_orderkey)
       {l_2_scan_ref.getOutput()[0]},
-      // Right payload (l_quantity)
-      {
-         l_2_scan_ref.getOutput()[1],
-      },
-      JoinType::Inner,
-      true);
-   auto& l_o_c_l_join_ref = *l_o_c_l_join;
-   assert(l_o_c_l_join_ref.getOutput().size() == 3);
-
-   // 6. Aggregate
-   std::vector<RelAlgOpPtr> agg_children;
-   agg_children.push_back(std::move(l_o_c_l_join));
-   // Group by l_orderkey
-   std::vector<const IU*> group_by{l_o_c_l_join_ref.getOutput()[1]};
-   std::vector<AggregateFunctions::Description> final_aggregates{
-      {*l_o_c_l_join_ref.getOutput()[2], AggregateFunctions::Opcode::Sum}};
-   auto final_agg = Aggregation::build(
-      std::move(agg_children),
-      "l_agg",
-      std::move(group_by),
-      std::move(final_aggregates));
+      std::move(final_aggregates),
+      JoinType::Inner);
    auto& final_agg_ref = *final_agg;
+   assert(final_agg_ref.getOutput().size() == 2);
 
    // 4. Print
    std::vector<const IU*> out_ius{
@@ -1512,7 +1515,7 @@ std::unique_ptr<Print> q18(const Schema& schema) {
                        std::move(out_ius), std::move(colnames));
 }
 
-std::unique_ptr<Print> q19(const Schema& schema) {
+std::unique_ptr<Print> q19(const Schema& schema, FilterStatistics* stats) {
    // Build a branch for a part condition.
    auto build_part_branch = [](
                                std::vector<ExpressionOp::NodePtr>& pred_nodes,
@@ -1676,67 +1679,50 @@ std::unique_ptr<Print> q19(const Schema& schema) {
    auto scan_l = TableScan::build(*rel_l, cols_l, "scan_lineitem");
    auto& scan_l_ref = *scan_l;
 
-   std::vector<ExpressionOp::NodePtr> pred_nodes_l;
-   auto l_partkey_ref = pred_nodes_l.emplace_back(std::make_unique<IURefNode>(
-                                                     scan_l_ref.getOutput()[getScanIndex("l_partkey", cols_l)]))
-                           .get();
-   auto l_shipmode_ref = pred_nodes_l.emplace_back(std::make_unique<IURefNode>(
-                                                      scan_l_ref.getOutput()[getScanIndex("l_shipmode", cols_l)]))
-                            .get();
-   auto l_quantity_ref = pred_nodes_l.emplace_back(std::make_unique<IURefNode>(
-                                                      scan_l_ref.getOutput()[getScanIndex("l_quantity", cols_l)]))
-                            .get();
-   auto l_shipinstruct_ref = pred_nodes_l.emplace_back(std::make_unique<IURefNode>(
-                                                          scan_l_ref.getOutput()[getScanIndex("l_shipinstruct", cols_l)]))
-                                .get();
-
-   auto l_shipinstruct_pred = pred_nodes_l.emplace_back(
-                                             std::make_unique<ComputeNode>(
-                                                ComputeNode::Type::StrEquals,
-                                                IR::StringVal::build("DELIVER IN PERSON"),
-                                                l_shipinstruct_ref))
-                                 .get();
-   auto l_shipmode_pred = pred_nodes_l.emplace_back(
-                                         std::make_unique<ComputeNode>(
-                                            ComputeNode::Type::InList,
-                                            IR::StringList::build({"AIR", "AIR REG"}),
-                                            l_shipmode_ref))
-                             .get();
-
-   // OR branch 1
-   Node* scan_l_branch_1 = build_lineitem_branch(
-      pred_nodes_l,
-      l_quantity_ref,
-      {1, 11});
-   // OR branch 1
-
-   // OR branch 2
-   Node* scan_l_branch_2 = build_lineitem_branch(
-      pred_nodes_l,
-      l_quantity_ref,
-      {10, 20});
-
-   Node* scan_l_branch_3 = build_lineitem_branch(
-      pred_nodes_l,
-      l_quantity_ref,
-      {20, 30});
-
-   auto l_common_or = Orify(pred_nodes_l, {scan_l_branch_1, scan_l_branch_2, scan_l_branch_3});
-
-   auto l_common_and = Andify(pred_nodes_l, {l_shipinstruct_pred, l_shipmode_pred, l_common_or});
-
-   std::vector<RelAlgOpPtr> expr_l_children;
-   expr_l_children.push_back(std::move(scan_l));
-   auto expr_l_node = ExpressionOp::build(
-      std::move(expr_l_children),
-      "lineitem_filter",
-      std::vector<Node*>{l_common_and},
-      std::move(pred_nodes_l));
-   auto& expr_l_ref = *expr_l_node;
-   assert(expr_l_ref.getOutput().size() == 1);
+   // The three conjuncts are evaluated in the order learned while running the query.
+   std::vector<AdaptiveFilter::Conjunct> conjuncts_l(3);
+   {
+      // l_shipinstruct = 'DELIVER IN PERSON'
+      auto& nodes = conjuncts_l[0].nodes;
+      auto l_shipinstruct_ref = nodes.emplace_back(std::make_unique<IURefNode>(
+                                                      scan_l_ref.getOutput()[getScanIndex("l_shipinstruct", cols_l)]))
+                                   .get();
+      conjuncts_l[0].root = nodes.emplace_back(
+                                    std::make_unique<ComputeNode>(
+                                       ComputeNode::Type::StrEquals,
+                                       IR::StringVal::build("DELIVER IN PERSON"),
+                                       l_shipinstruct_ref))
+                               .get();
+   }
+   {
+      // l_shipmode in ('AIR', 'AIR REG')
+      auto& nodes = conjuncts_l[1].nodes;
+      auto l_shipmode_ref = nodes.emplace_back(std::make_unique<IURefNode>(
+                                                  scan_l_ref.getOutput()[getScanIndex("l_shipmode", cols_l)]))
+                               .get();
+      conjuncts_l[1].root = nodes.emplace_back(
+                                    std::make_unique<ComputeNode>(
+                                       ComputeNode::Type::InList,
+                                       IR::StringList::build({"AIR", "AIR REG"}),
+                                       l_shipmode_ref))
+                               .get();
+   }
+   {
+      // The l_quantity ranges of the three branches.
+      auto& nodes = conjuncts_l[2].nodes;
+      auto l_quantity_ref = nodes.emplace_back(std::make_unique<IURefNode>(
+                                                  scan_l_ref.getOutput()[getScanIndex("l_quantity", cols_l)]))
+                               .get();
+      Node* scan_l_branch_1 = build_lineitem_branch(nodes, l_quantity_ref, {1, 11});
+      Node* scan_l_branch_2 = build_lineitem_branch(nodes, l_quantity_ref, {10, 20});
+      Node* scan_l_branch_3 = build_lineitem_branch(nodes, l_quantity_ref, {20, 30});
+      conjuncts_l[2].root = Orify(nodes, {scan_l_branch_1, scan_l_branch_2, scan_l_branch_3});
+   }
+   // Shared by all instances built with the same statistics, later ones evaluate the conjuncts in the learned order.
+   auto stats_l = stats ? stats->get("q19_filter_l", conjuncts_l.size()) : nullptr;
 
    std::vector<RelAlgOpPtr> filter_l_children;
-   filter_l_children.push_back(std::move(expr_l_node));
+   filter_l_children.push_back(std::move(scan_l));
    std::vector<const IU*> filter_l_redefined{
       scan_l_ref.getOutput()[0],
       scan_l_ref.getOutput()[2],
@@ -1744,11 +1730,12 @@ std::unique_ptr<Print> q19(const Schema& schema) {
       scan_l_ref.getOutput()[4],
       scan_l_ref.getOutput()[5],
    };
-   auto filter_l = Filter::build(
+   auto filter_l = AdaptiveFilter::build(
       std::move(filter_l_children),
       "filter_l",
       std::move(filter_l_redefined),
-      *expr_l_ref.getOutput()[0]);
+      std::move(conjuncts_l),
+      std::move(stats_l));
    auto& filter_l_ref = *filter_l;
    assert(filter_l->getOutput().size() == 4);
 
@@ -1776,7 +1763,9 @@ std::unique_ptr<Print> q19(const Schema& schema) {
          filter_l_ref.getOutput()[3],
       },
       JoinType::Inner,
-      true);
+      true,
+      // The wide part payload is only needed for the few rows surviving the join.
+      /* late_materialize = */ true);
    auto& p_l_join_ref = *p_l_join;
 
    // 6. Filter again, we need to make sure the right tuples survived.
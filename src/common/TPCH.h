@@ -2,9 +2,11 @@
 #define INKFUSE_TPCH_H
 
 #include "storage/Relation.h"
+#include "algebra/AdaptiveFilter.h"
 #include "algebra/Pipeline.h"
 #include "algebra/RelAlgOp.h"
 #include "algebra/Print.h"
+#include <unordered_map>
 
 /// TPCH schemas and supported queries.
 namespace inkfuse::tpch {
@@ -12,6 +14,17 @@ namespace inkfuse::tpch {
 /// Get the full TPC-H schema containing all relations with all columns.
 Schema getTPCHSchema();
 
+/// Statistics learned by the adaptive filters of the queries. Queries built with the same
+/// statistics evaluate their filters in the learned order. The caller owns them, e.g. next to
+/// the PreparedQuery running a query, so learned orders never leak between unrelated runs.
+struct FilterStatistics {
+   /// Get the statistics of the filter with the given name, created on first use.
+   ConjunctStatisticsArc get(const std::string& filter, size_t num_conjuncts);
+
+   private:
+   std::unordered_map<std::string, ConjunctStatisticsArc> filters;
+};
+
 /// We implement the physical plans for a subset of interesting TPC-H
 /// queries that allows for representative benchmarking.
 /// Physical plans are taken from Umbra: https://umbra-db.com/interface/
@@ -24,16 +37,16 @@ std::unique_ptr<Print> q3(const Schema& schema);
 std::unique_ptr<Print> q4(const Schema& schema);
 /// Join (moderate build, big probe) up to ~100x difference
 std::unique_ptr<Print> q5(const Schema& schema);
-/// Selective filters
-std::unique_ptr<Print> q6(const Schema& schema);
+/// Selective filters. Without statistics, the filter learns from scratch.
+std::unique_ptr<Print> q6(const Schema& schema, FilterStatistics* stats = nullptr);
 /// Outer join customer <-> order
 std::unique_ptr<Print> q13(const Schema& schema);
 /// Join (moderate build, moderate probe) ~2x difference
 std::unique_ptr<Print> q14(const Schema& schema);
 /// High cardinality aggregation.
 std::unique_ptr<Print> q18(const Schema& schema);
-/// Large computational graphs.
-std::unique_ptr<Print> q19(const Schema& schema);
+/// Large computational graphs. Without statistics, the filter learns from scratch.
+std::unique_ptr<Print> q19(const Schema& schema, FilterStatistics* stats = nullptr);
 
 /// Some interesting custom queries. See /tpch for query text.
 std::unique_ptr<Print> q_bigjoin(const Schema& schema);
@@ -0,0 +1,106 @@
+#include "exec/CompileScheduler.h"
+#include <algorithm>
+#include <cassert>
+#include <thread>
+
+namespace inkfuse {
+
+CompileScheduler::CompileScheduler(size_t slots_) : slots(std::max<size_t>(slots_, 1)) {
+}
+
+CompileScheduler& CompileScheduler::instance() {
+   // Intentionally leaked: detached compilation jobs may still release their slots during static destruction.
+   static auto* scheduler = new CompileScheduler(std::thread::hardware_concurrency() / 2);
+   return *scheduler;
+}
+
+CompileScheduler::Slot::Slot(CompileScheduler& scheduler_, InterruptableJob& job, Priority priority)
+   : scheduler(scheduler_), is_acquired(scheduler.acquire(job, std::move(priority))) {
+}
+
+CompileScheduler::Slot::~Slot() {
+   if (is_acquired) {
+      scheduler.release();
+   }
+}
+
+bool CompileScheduler::acquire(InterruptableJob& job, Priority priority) {
+   std::unique_lock lock(mut);
+   if (job.interrupted()) {
+      // Interrupted before it even started waiting.
+      return false;
+   }
+   auto waiter = waiting.insert(waiting.end(), Waiter{.job = &job, .priority = std::move(priority)});
+   dispatch();
+   cv.wait(lock, [&] { return waiter->granted || waiter->interrupted; });
+   const bool granted = waiter->granted;
+   waiting.erase(waiter);
+   return granted;
+}
+
+void CompileScheduler::release() {
+   std::unique_lock lock(mut);
+   assert(used > 0);
+   used--;
+   dispatch();
+}
+
+void CompileScheduler::dispatch() {
+   bool granted_any = false;
+   while (used < slots) {
+      // Find the pending job with the highest priority. Ties go to the job waiting longest.
+      auto best = waiting.end();
+      double best_priority = 0.0;
+      for (auto it = waiting.begin(); it != waiting.end(); ++it) {
+         if (it->granted || it->interrupted) {
+            continue;
+         }
+         const double priority = it->priority();
+         if (best == waiting.end() || priority > best_priority) {
+            best = it;
+            best_priority = priority;
+         }
+      }
+      if (best == waiting.end()) {
+         break;
+      }
+      best->granted = true;
+      used++;
+      granted_any = true;
+   }
+   if (granted_any) {
+      cv.notify_all();
+   }
+}
+
+void CompileScheduler::interrupt(InterruptableJob& job) {
+   std::unique_lock lock(mut);
+   // Interrupt under the lock, `acquire` checks for interruption before it starts waiting.
+   job.interrupt();
+   for (auto& waiter : waiting) {
+      if (waiter.job == &job && !waiter.granted) {
+         waiter.interrupted = true;
+      }
+   }
+   cv.notify_all();
+}
+
+void CompileScheduler::setSlots(size_t slots_) {
+   std::unique_lock lock(mut);
+   slots = std::max<size_t>(slots_, 1);
+   dispatch();
+}
+
+size_t CompileScheduler::getSlots() const {
+   std::unique_lock lock(mut);
+   return slots;
+}
+
+size_t CompileScheduler::numWaiting() const {
+   std::unique_lock lock(mut);
+   return std::count_if(waiting.begin(), waiting.end(), [](const Waiter& waiter) {
+      return !waiter.granted && !waiter.interrupted;
+   });
+}
+
+}
@@ -0,0 +1,86 @@
+#ifndef INKFUSE_COMPILESCHEDULER_H
+#define INKFUSE_COMPILESCHEDULER_H
+
+#include "exec/InterruptableJob.h"
+#include <condition_variable>
+#include <functional>
+#include <list>
+#include <mutex>
+
+namespace inkfuse {
+
+/// The CompileScheduler runs the background compilation jobs of all queries on a bounded
+/// number of compile slots. Without it, every pipeline and every ROF interval spawns its own
+/// compiler at the same time, competing with the query workers for cores.
+///
+/// Waiting jobs are ordered by their priority, which is evaluated whenever a slot becomes
+/// free. The PipelineExecutor uses the expected remaining work of the pipeline, this way
+/// the code of pipelines that are about to finish is compiled last. Jobs can be interrupted
+/// both while waiting for a slot and while compiling.
+struct CompileScheduler {
+   /// Value of a compilation job. Jobs with a higher value get a slot first.
+   using Priority = std::function<double()>;
+
+   /// Create a scheduler with the given number of compile slots.
+   explicit CompileScheduler(size_t slots_);
+
+   /// Get the process-wide scheduler. Uses half of the hardware threads as compile slots.
+   static CompileScheduler& instance();
+
+   /// A compile slot held for the lifetime of the object.
+   struct Slot {
+      /// Wait for a slot. Gives up if the job gets interrupted while waiting.
+      Slot(CompileScheduler& scheduler_, InterruptableJob& job, Priority priority);
+      ~Slot();
+
+      Slot(const Slot& other) = delete;
+      Slot& operator=(const Slot& other) = delete;
+
+      /// Was a slot acquired? False if the job was interrupted before it got one.
+      bool acquired() const { return is_acquired; };
+
+      private:
+      CompileScheduler& scheduler;
+      bool is_acquired;
+   };
+
+   /// Interrupt a compilation job. Waiting jobs never get a slot, running ones are cancelled.
+   void interrupt(InterruptableJob& job);
+
+   /// Change the number of compile slots. Running jobs keep their slots.
+   void setSlots(size_t slots_);
+   size_t getSlots() const;
+   /// How many jobs are waiting for a slot?
+   size_t numWaiting() const;
+
+   private:
+   /// A job waiting for a slot.
+   struct Waiter {
+      InterruptableJob* job;
+      Priority priority;
+      /// Was a slot granted to the job?
+      bool granted = false;
+      /// Was the job interrupted while waiting?
+      bool interrupted = false;
+   };
+
+   /// Wait for a slot. Returns false if the job was interrupted before getting one.
+   bool acquire(InterruptableJob& job, Priority priority);
+   /// Release a slot held by a job.
+   void release();
+   /// Grant the free slots to the waiting jobs with the highest priority. Requires the lock.
+   void dispatch();
+
+   mutable std::mutex mut;
+   std::condition_variable cv;
+   /// Number of compile slots.
+   size_t slots;
+   /// Number of slots held by compiling jobs.
+   size_t used = 0;
+   /// Jobs waiting for a slot in arrival order.
+   std::list<Waiter> waiting;
+};
+
+}
+
+#endif //INKFUSE_COMPILESCHEDULER_H
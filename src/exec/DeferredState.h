@@ -2,9 +2,14 @@
 #define INKFUSE_DEFERREDSTATE_H
 
 #include "algebra/AggregationMerger.h"
+#include "runtime/GroupJoinPartials.h"
 #include "runtime/HashTables.h"
 #include "runtime/NewHashTables.h"
+#include "runtime/Sorter.h"
+#include "runtime/TopK.h"
 #include "runtime/TupleMaterializer.h"
+#include "runtime/WindowEvaluator.h"
+#include <atomic>
 #include <cassert>
 #include <deque>
 
@@ -53,6 +58,73 @@ struct AtomicHashTableState : public DefferredStateInitializer {
    std::unique_ptr<AtomicHashTable<Comparator>> hash_table;
 };
 
+/// State needed for a group join. Every thread updates its own partial aggregate states,
+/// they get merged into the slots of the shared hash table once the probe side is done.
+struct GroupJoinState : public DefferredStateInitializer {
+   GroupJoinState(AtomicHashTableState<SimpleKeyComparator>& ht_state_) : ht_state(ht_state_){};
+   void prepare(size_t num_threads) override {
+      if (partials.size() < num_threads) {
+         partials.resize(num_threads);
+      }
+   };
+   void* access(size_t thread_id) override {
+      assert(thread_id < partials.size());
+      return &partials[thread_id];
+   };
+
+   /// The hash table containing the groups.
+   AtomicHashTableState<SimpleKeyComparator>& ht_state;
+   /// The thread-local partial aggregate states.
+   std::deque<GroupJoinPartials> partials;
+   /// The next slot range whose partial states get merged.
+   std::atomic<uint64_t> next_merge_range = 0;
+};
+
+/// State needed for a sort. The materialized rows get sorted by runtime tasks.
+struct SortState : public DefferredStateInitializer {
+   SortState(TupleMaterializerState& materialize_, std::vector<SortKey> keys_)
+      : materialize(materialize_), sorter(std::move(keys_), materialize_.tuple_size){};
+   void prepare(size_t num_threads) override{};
+   void* access(size_t thread_id) override {
+      return &sorter;
+   };
+
+   /// The materializer state containing the rows to sort.
+   TupleMaterializerState& materialize;
+   /// The sorter producing the sorted rows.
+   Sorter sorter;
+};
+
+/// State needed for a Top-K. Every thread inserts into its own bounded heap.
+struct TopKState : public DefferredStateInitializer {
+   TopKState(std::vector<SortKey> keys_, size_t row_size_, size_t k_)
+      : topk(std::move(keys_), row_size_, k_){};
+   void prepare(size_t num_threads) override {
+      topk.prepareHeaps(num_threads);
+   };
+   void* access(size_t thread_id) override {
+      return &topk.getHeap(thread_id);
+   };
+
+   /// The Top-K whose heaps get merged once all rows were inserted.
+   TopK topk;
+};
+
+/// State needed for a window operator. The materialized rows get partitioned and evaluated by runtime tasks.
+struct WindowState : public DefferredStateInitializer {
+   WindowState(TupleMaterializerState& materialize_, std::vector<SortKey> partition_keys_, std::vector<SortKey> order_keys_, std::vector<WindowFunction> functions_)
+      : materialize(materialize_), evaluator(std::move(partition_keys_), std::move(order_keys_), std::move(functions_), materialize_.tuple_size){};
+   void prepare(size_t num_threads) override{};
+   void* access(size_t thread_id) override {
+      return &evaluator;
+   };
+
+   /// The materializer state containing the input rows.
+   TupleMaterializerState& materialize;
+   /// The evaluator computing the window functions.
+   WindowEvaluator evaluator;
+};
+
 /// Fake object which doesn't defer anything.
 template <class State>
 struct FakeDefer : public DefferredStateInitializer {
@@ -77,7 +149,11 @@ struct ExclusiveHashTableState<HashTableSimpleKey> : public DefferredStateInitia
 
    void prepare(size_t num_threads) override {
       for (size_t k = 0; k < num_threads; ++k) {
-         hash_tables.push_back(std::make_unique<HashTableSimpleKey>(key_size, payload_size, 8));
+         auto& table = hash_tables.emplace_back(std::make_unique<HashTableSimpleKey>(key_size, payload_size, 8));
+         if (num_threads > 1 && key_size > 0) {
+            // Partition the pass-through rows by the thread that merges them.
+            table->enablePassThrough(num_threads);
+         }
       }
    };
 
@@ -98,11 +174,11 @@ struct ExclusiveHashTableState<HashTableSimpleKey> : public DefferredStateInitia
 /// Complex key hash table.
 template <>
 struct ExclusiveHashTableState<HashTableComplexKey> : public DefferredStateInitializer {
-   ExclusiveHashTableState(uint16_t slots_, size_t payload_size_) : slots(slots_), payload_size(payload_size_){};
+   ExclusiveHashTableState(uint16_t slots_, uint16_t simple_key_size_, size_t payload_size_) : slots(slots_), simple_key_size(simple_key_size_), payload_size(payload_size_){};
 
    void prepare(size_t num_threads) override {
       for (size_t k = 0; k < num_threads; ++k) {
-         hash_tables.push_back(std::make_unique<HashTableComplexKey>(0, 1, payload_size, 8));
+         hash_tables.push_back(std::make_unique<HashTableComplexKey>(simple_key_size, slots, payload_size, 8));
       }
    };
 
@@ -112,6 +188,8 @@ struct ExclusiveHashTableState<HashTableComplexKey> : public DefferredStateIniti
    };
 
    size_t slots;
+   /// Size of the simple key packed behind the complex key slots.
+   size_t simple_key_size;
    size_t payload_size;
    /// The hash tables - first the thread local ones with duplicates, then the
    /// fully merged ones assigned to different threads.
@@ -123,11 +201,13 @@ struct ExclusiveHashTableState<HashTableComplexKey> : public DefferredStateIniti
 /// Direct lookup hash table.
 template <>
 struct ExclusiveHashTableState<HashTableDirectLookup> : public DefferredStateInitializer {
-   ExclusiveHashTableState(uint16_t payload_size_) : payload_size(payload_size_){};
+   ExclusiveHashTableState(uint16_t payload_size_) : key_columns{{.offset = 0, .width = 2, .min = 0, .cardinality = 1 << 16}}, key_size(2), payload_size(payload_size_){};
+   ExclusiveHashTableState(std::vector<HashTableDirectLookup::KeyColumn> key_columns_, uint16_t key_size_, uint16_t payload_size_)
+      : key_columns(std::move(key_columns_)), key_size(key_size_), payload_size(payload_size_){};
 
    void prepare(size_t num_threads) override {
       for (size_t k = 0; k < num_threads; ++k) {
-         hash_tables.push_back(std::make_unique<HashTableDirectLookup>(payload_size));
+         hash_tables.push_back(std::make_unique<HashTableDirectLookup>(key_columns, key_size, payload_size));
       }
    };
 
@@ -136,6 +216,9 @@ struct ExclusiveHashTableState<HashTableDirectLookup> : public DefferredStateIni
       return hash_tables[thread_id].get();
    };
 
+   /// The columns of the packed key.
+   std::vector<HashTableDirectLookup::KeyColumn> key_columns;
+   uint16_t key_size;
    uint16_t payload_size;
    /// The hash tables - first the thread local ones with duplicates, then the
    /// fully merged ones assigned to different threads.
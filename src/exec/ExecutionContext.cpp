@@ -73,4 +73,9 @@ bool* ExecutionContext::tryGetInstalledRestartFlag() {
    return installed_thread_state ? &installed_thread_state->restart_flag : nullptr;
 }
 
+bool& ExecutionContext::getInstalledOverflowFlag() {
+   assert(installed_thread_state);
+   return installed_thread_state->overflow_flag;
+}
+
 }
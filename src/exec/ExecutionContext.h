@@ -44,6 +44,7 @@ struct ExecutionContext {
    static MemoryRuntime::MemoryRegion& getInstalledMemoryContext();
    static bool& getInstalledRestartFlag();
    static bool* tryGetInstalledRestartFlag();
+   static bool& getInstalledOverflowFlag();
 
    private:
    ExecutionContext(std::vector<FuseChunkArc> chunks_, const Pipeline& pipe_, size_t num_threads_);
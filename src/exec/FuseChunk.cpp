@@ -4,14 +4,24 @@
 
 namespace inkfuse {
 
-Column::Column(const IR::Type& type, size_t capacity) {
+Column::Column(const IR::Type& type, size_t capacity) : capacity_bytes(capacity * type.numBytes()) {
    // Allocate raw array, pessimistically choose alignment 8 to respect the size boundary of the backing type.
-   raw_data = static_cast<char*>(std::aligned_alloc(8, capacity * type.numBytes()));
+   owned_data = static_cast<char*>(std::aligned_alloc(8, capacity_bytes));
+   raw_data = owned_data;
 }
 
 Column::~Column() {
    // Drop raw data again.
-   std::free(raw_data);
+   std::free(owned_data);
+}
+
+char* Column::releaseData() {
+   char* released = owned_data;
+   owned_data = static_cast<char*>(std::aligned_alloc(8, capacity_bytes));
+   if (raw_data == released) {
+      raw_data = owned_data;
+   }
+   return released;
 }
 
 FuseChunk::FuseChunk(size_t capacity_) : capacity(capacity_) {
@@ -26,13 +26,24 @@ struct Column {
    Column(Column&& other) = delete;
    Column& operator=(Column&& other) = delete;
 
+   /// Hand the backing memory over to the caller, who has to free it with std::free.
+   /// The column continues on freshly allocated memory of the same capacity.
+   char* releaseData();
+
    /// Raw data stored within the column. Why this representation?
    /// Note that we need to access these columns within the generated code in an efficient way.
    /// For this we need C-style structs with raw members that can be made to "easily" interface
    /// with code generation primitives.
    char* raw_data;
+   /// Memory owned by the column. `raw_data` points to it unless the column was rewired to
+   /// other memory, e.g. by a zero copy table scan. Sinks always write into this memory.
+   char* owned_data;
    /// The size of this column, i.e. how much data it actually contains.
    size_t size = 0;
+
+   private:
+   /// Size of the owned memory in bytes.
+   size_t capacity_bytes;
 };
 
 using ColumnPtr = std::unique_ptr<Column>;
@@ -48,6 +48,12 @@ void InterruptableJob::interrupt() {
    write(fd_event, &update, 8);
 }
 
+bool InterruptableJob::interrupted() const {
+   // The eventfd is never read, it stays readable once the job was interrupted.
+   pollfd descriptor{fd_event, POLLIN, 0};
+   return poll(&descriptor, 1, 0) > 0 && descriptor.revents != 0;
+}
+
 InterruptableJob::Change InterruptableJob::awaitChange() {
    if (fd_process == -1) {
       throw std::runtime_error("Cannot await InterruptableJob without processfd set.");
@@ -43,6 +43,8 @@ struct InterruptableJob {
 
    /// Interrupt the job. Causes the background job to be cancelled.
    void interrupt();
+   /// Was the job interrupted? Does not block.
+   bool interrupted() const;
 
    /// Wait until either the job was interrupted or finished successfully.
    Change awaitChange();
@@ -0,0 +1,46 @@
+#include "exec/ModePlanner.h"
+#include <algorithm>
+
+namespace inkfuse::ModePlanner {
+
+using ExecutionMode = PipelineExecutor::ExecutionMode;
+using ROFStrategy = Suboperator::OptimizationProperties::ROFStrategy;
+
+Decision plan(const Pipeline& pipe, size_t num_threads) {
+   const auto& subops = pipe.getSubops();
+   assert(!subops.empty());
+   Decision decision{
+      .mode = ExecutionMode::Hybrid,
+      .estimated_rows = subops[0]->estimateRows(),
+      .complexity = subops.size(),
+      .staging_points = static_cast<size_t>(std::count_if(subops.begin(), subops.end(), [](const SuboperatorArc& op) {
+         return op->getOptimizationProperties().rof_strategy == ROFStrategy::BeginVectorized;
+      })),
+   };
+
+   if (!decision.estimated_rows) {
+      // Without an estimate only simple pipelines are interpreted right away. Hybrid
+      // execution still picks the faster backend for the complex ones.
+      decision.mode = decision.complexity <= SIMPLE_PIPELINE_SUBOPS ? ExecutionMode::Interpreted : ExecutionMode::Hybrid;
+      return decision;
+   }
+
+   const double compile_micros = COMPILE_MICROS_BASE + COMPILE_MICROS_PER_SUBOP * decision.complexity;
+   // All threads share the interpretation overhead.
+   const double interpretation_micros = INTERPRETATION_NANOS_PER_ROW * static_cast<double>(*decision.estimated_rows) * decision.complexity / (1'000.0 * std::max<size_t>(num_threads, 1));
+   if (interpretation_micros < compile_micros) {
+      // Compilation would take longer than the overhead it saves.
+      decision.mode = ExecutionMode::Interpreted;
+   } else if (interpretation_micros < FUSE_FACTOR * compile_micros) {
+      // Hide the compilation latency behind interpretation.
+      decision.mode = ExecutionMode::Hybrid;
+   } else if (decision.staging_points > 0) {
+      // Hash table probes are vectorized to overlap their cache misses.
+      decision.mode = ExecutionMode::ROF;
+   } else {
+      decision.mode = ExecutionMode::Fused;
+   }
+   return decision;
+}
+
+}
@@ -0,0 +1,50 @@
+#ifndef INKFUSE_MODEPLANNER_H
+#define INKFUSE_MODEPLANNER_H
+
+#include "algebra/Pipeline.h"
+#include "exec/PipelineExecutor.h"
+#include <optional>
+
+namespace inkfuse {
+
+/// Cost model picking the execution mode of a single pipeline in the CostBased mode.
+/// Compilation has a roughly fixed latency growing with the size of the generated code,
+/// while interpretation adds a per-row overhead for every suboperator. Pipelines over
+/// few rows never make up for the compilation latency and are interpreted, large ones
+/// go straight to compiled code. Pipelines in between run in hybrid mode, which hides
+/// the compilation latency behind interpretation.
+namespace ModePlanner {
+
+/// Estimated compilation latency independent of the pipeline.
+constexpr double COMPILE_MICROS_BASE = 20'000.0;
+/// Estimated additional compilation latency for every suboperator.
+constexpr double COMPILE_MICROS_PER_SUBOP = 1'000.0;
+/// Estimated overhead of interpreting a suboperator on a single row.
+constexpr double INTERPRETATION_NANOS_PER_ROW = 1.0;
+/// Pipelines where the interpretation overhead exceeds this multiple of the compilation
+/// latency go straight to compiled code.
+constexpr double FUSE_FACTOR = 4.0;
+/// Pipelines with unknown input and at most this many suboperators are interpreted. These
+/// mostly read the state of previous pipelines, e.g. the merged groups of an aggregation.
+constexpr size_t SIMPLE_PIPELINE_SUBOPS = 8;
+
+/// The planned execution mode of a pipeline and the estimates it is based on.
+struct Decision {
+   /// The chosen execution mode.
+   PipelineExecutor::ExecutionMode mode;
+   /// Estimated input rows of the pipeline, std::nullopt if unknown while planning.
+   std::optional<size_t> estimated_rows;
+   /// Number of suboperators in the pipeline.
+   size_t complexity;
+   /// Number of ROF staging points, i.e. hash table probes that profit from vectorized prefetching.
+   size_t staging_points;
+};
+
+/// Plan the execution mode of a pipeline run by `num_threads` threads.
+Decision plan(const Pipeline& pipe, size_t num_threads);
+
+}
+
+}
+
+#endif //INKFUSE_MODEPLANNER_H
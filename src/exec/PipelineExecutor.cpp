@@ -2,13 +2,16 @@
 #include "algebra/Print.h"
 #include "algebra/suboperators/sinks/FuseChunkSink.h"
 #include "algebra/suboperators/sources/FuseChunkSource.h"
+#include "exec/CompileScheduler.h"
 #include "exec/InterruptableJob.h"
 #include "exec/runners/InterpretedRunner.h"
 #include "runtime/MemoryRuntime.h"
 
+#include <algorithm>
 #include <chrono>
 #include <cstring>
 #include <iostream>
+#include <limits>
 
 namespace inkfuse {
 
@@ -68,9 +71,37 @@ PipelineExecutor::PipelineExecutor(Pipeline& pipe_, size_t num_threads, Executio
      pipe(pipe_),
      mode(mode),
      full_name(std::move(full_name_)),
-     control_block(std::move(control_block_)) {
+     control_block(std::move(control_block_)),
+     progress(std::make_shared<PipelineProgress>()) {
    assert(pipe.getSubops()[0]->isSource());
    assert(pipe.getSubops().back()->isSink());
+   if (mode == ExecutionMode::CostBased) {
+      throw std::runtime_error("The cost based mode has to be resolved into a mode for every pipeline");
+   }
+   progress->estimated_rows = pipe.getSubops()[0]->estimateRows();
+}
+
+double PipelineExecutor::PipelineProgress::remainingWork() const {
+   if (awaited) {
+      // Execution is stalled on the code, nothing is more urgent.
+      return std::numeric_limits<double>::infinity();
+   }
+   const double done = fraction;
+   double total = 0.0;
+   if (done > 0.0) {
+      // Extrapolate from the rows picked so far.
+      total = static_cast<double>(picked_rows) / done;
+   } else if (estimated_rows) {
+      total = static_cast<double>(*estimated_rows);
+   }
+   return total * (1.0 - std::min(done, 1.0));
+}
+
+void PipelineExecutor::recordProgress(const Suboperator::PickMorselResult& morsel) {
+   if (auto picked = std::get_if<Suboperator::PickedMorsel>(&morsel)) {
+      progress->picked_rows += picked->morsel_size;
+      progress->fraction = picked->pipeline_progress;
+   }
 }
 
 PipelineExecutor::~PipelineExecutor() noexcept {
@@ -105,6 +136,28 @@ void PipelineExecutor::preparePipeline(ExecutionMode prep_mode) {
    }
 }
 
+void PipelineExecutor::reuseCompiledFragments(CompiledFragments fragments) {
+   assert(!compiler_setup_started);
+   reused_fragments = std::move(fragments);
+}
+
+PipelineExecutor::CompiledFragments PipelineExecutor::getCompiledFragments() {
+   CompiledFragments fragments;
+   progress->awaited = true;
+   for (auto& job : compilation_jobs) {
+      if (job.joinable()) {
+         job.join();
+      }
+   }
+   for (const auto& state : compile_state) {
+      std::unique_lock lock(state->compiled_lock);
+      if (state->compiled) {
+         fragments[state->jit_interval] = state->compiled->getProgram();
+      }
+   }
+   return fragments;
+}
+
 void PipelineExecutor::threadSwimlane(size_t thread_id, OnceBarrier& compile_prep_barrier) {
    // Set the CPU affinity to make sure the thread doesn't jump across cores.
    setCpuAffinity(thread_id);
@@ -164,6 +217,11 @@ void PipelineExecutor::threadSwimlane(size_t thread_id, OnceBarrier& compile_pre
          terminate = timeAndRunInterpreted();
          std::unique_lock lock(compile_state[0]->compiled_lock);
          fused_ready = compile_state[0]->fused_set_up;
+         if (!fused_ready && progress->fraction >= INTERRUPT_COMPILE_PROGRESS && !progress->compile_interrupted.exchange(true)) {
+            // The interpreter is about to finish, free the compile slot for more valuable jobs.
+            // Only the first worker getting here interrupts.
+            CompileScheduler::instance().interrupt(compile_state[0]->interrupt);
+         }
       }
 
       // Code is ready - set up for compiled execution. All threads synchronize around
@@ -239,6 +297,7 @@ void PipelineExecutor::runSwimlanes() {
 
 PipelineExecutor::PipelineStats PipelineExecutor::runPipeline() {
    PipelineStats result;
+   result.modes.push_back(mode);
    const auto start_execution_ts = std::chrono::steady_clock::now();
 
    if (mode == ExecutionMode::Fused) {
@@ -247,6 +306,7 @@ PipelineExecutor::PipelineStats PipelineExecutor::runPipeline() {
       if (compilation_jobs[0].joinable()) {
          // For compiled execution we need to wait for the compiled code
          // to be ready.
+         progress->awaited = true;
          compilation_jobs[0].join();
       }
       const auto compilation_done_ts = std::chrono::steady_clock::now();
@@ -268,6 +328,7 @@ PipelineExecutor::PipelineStats PipelineExecutor::runPipeline() {
    } else if (mode == ExecutionMode::ROF) {
       // Prepare ROF fragments.
       preparePipeline(ExecutionMode::ROF);
+      progress->awaited = true;
       for (auto& compile_job : compilation_jobs) {
          if (compile_job.joinable()) {
             compile_job.join();
@@ -306,12 +367,17 @@ PipelineExecutor::PipelineStats PipelineExecutor::runPipeline() {
       std::thread([compilation_jobs = std::move(compilation_jobs), compile_state = compile_state]() mutable {
          for (size_t k = 0; k < compilation_jobs.size(); ++k) {
             // Stop the backing compilation job (if not finished) and clean up.
-            compile_state[k]->interrupt.interrupt();
+            CompileScheduler::instance().interrupt(compile_state[k]->interrupt);
             // Detach the thread, it can exceed the lifecycle of this PipelineExecutor.
-            compilation_jobs[k].detach();
+            if (compilation_jobs[k].joinable()) {
+               compilation_jobs[k].detach();
+            }
          }
       }).detach();
    }
+   if (overflowed) {
+      throw std::runtime_error("Decimal overflow or division by zero");
+   }
    return result;
 }
 
@@ -321,16 +387,25 @@ Suboperator::PickMorselResult PipelineExecutor::runMorsel(size_t thread_id) {
    if (mode == ExecutionMode::Fused || (mode == ExecutionMode::Hybrid)) {
       preparePipeline(ExecutionMode::Fused);
       if (compilation_jobs[0].joinable()) {
+         progress->awaited = true;
          compilation_jobs[0].join();
       }
       compile_state[0]->compiled->setUpState();
-      return runFusedMorsel(thread_id);
+      auto morsel = runFusedMorsel(thread_id);
+      if (overflowed) {
+         throw std::runtime_error("Decimal overflow or division by zero");
+      }
+      return morsel;
    } else {
       preparePipeline(ExecutionMode::Interpreted);
       for (auto& interpreter : interpreters) {
          interpreter->setUpState();
       }
-      return runInterpretedMorsel(thread_id);
+      auto morsel = runInterpretedMorsel(thread_id);
+      if (overflowed) {
+         throw std::runtime_error("Decimal overflow or division by zero");
+      }
+      return morsel;
    }
 }
 
@@ -375,6 +450,13 @@ std::vector<std::thread> PipelineExecutor::setUpFusedAsync(ExecutionMode mode) {
       std::string fragment_name = full_name + "_" + std::to_string(start) + "_" + std::to_string(end);
       auto runner = std::make_unique<CompiledRunner>(std::move(repiped), *context, fragment_name);
       compile_state.emplace_back(std::make_shared<AsyncCompileState>(control_block, context, jit_interval));
+      if (auto reused = reused_fragments.find(jit_interval); reused != reused_fragments.end()) {
+         // The machine code exists already, there is nothing to do in the background.
+         runner->reuseProgram(reused->second);
+         compile_state.back()->compiled = std::move(runner);
+         compile_state.back()->fused_set_up = true;
+         return std::thread{};
+      }
       // In the hybrid mode we detach the runner thread so that we don't have to wait on subprocess termination.
       // This makes things much faster, but requires that the async thread does not access any member
       // of this PipelineExecutor. The thread might be alive longer.
@@ -383,7 +465,15 @@ std::vector<std::thread> PipelineExecutor::setUpFusedAsync(ExecutionMode mode) {
          // Compilation cannot be moved into the async thread if parallel compilation is disallowed.
          runner->generateC();
       }
-      return std::thread([runner = std::move(runner), state = compile_state.back(), with_parallel_codegen]() mutable {
+      return std::thread([runner = std::move(runner), state = compile_state.back(), with_parallel_codegen, progress = progress]() mutable {
+         // Wait for a compile slot. Pipelines with more remaining work get compiled first.
+         CompileScheduler::Slot slot(CompileScheduler::instance(), state->interrupt, [progress] {
+            return progress->remainingWork();
+         });
+         if (!slot.acquired()) {
+            // Interrupted before compilation started.
+            return;
+         }
          if (with_parallel_codegen) {
             runner->generateC();
          }
@@ -446,11 +536,15 @@ Suboperator::PickMorselResult PipelineExecutor::runFusedMorsel(size_t thread_id)
    assert(compile_state[0]->fused_set_up);
    // Run the whole compiled executor.
    auto morsel = compile_state[0]->compiled->pickMorsel(thread_id);
+   recordProgress(morsel);
    if (std::holds_alternative<Suboperator::PickedMorsel>(morsel)) {
       compile_state[0]->compiled->runMorsel(thread_id);
-      if (auto printer = pipe.getPrettyPrinter()) {
-         // Tell the printer that a morsel is done.
-         if (printer->markMorselDone(*context, thread_id)) {
+      if (morselOverflowed()) {
+         return Suboperator::NoMoreMorsels{};
+      }
+      if (auto sink = pipe.getResultSink()) {
+         // Tell the result sink that a morsel is done.
+         if (sink->markMorselDone(*context, thread_id)) {
             // Output is closed - no more work to be done.
             return Suboperator::NoMoreMorsels{};
          }
@@ -464,6 +558,7 @@ Suboperator::PickMorselResult PipelineExecutor::runInterpretedMorsel(size_t thre
    // Only the first interpreter is allowed to pick a morsel - the morsel of that source is then
    // fixed for all remaining interpreters in the pipeline.
    auto morsel = interpreters[0]->pickMorsel(thread_id);
+   recordProgress(morsel);
    if (std::holds_alternative<Suboperator::PickedMorsel>(morsel)) {
       runMorselWithRetry(*interpreters[0], thread_id);
       for (auto interpreter = interpreters.begin() + 1; interpreter < interpreters.end(); ++interpreter) {
@@ -472,9 +567,12 @@ Suboperator::PickMorselResult PipelineExecutor::runInterpretedMorsel(size_t thre
          (*interpreter)->pickMorsel(thread_id);
          runMorselWithRetry(**interpreter, thread_id);
       }
-      if (auto printer = pipe.getPrettyPrinter()) {
-         // Tell the printer that a morsel is done.
-         if (printer->markMorselDone(*context, thread_id)) {
+      if (morselOverflowed()) {
+         return Suboperator::NoMoreMorsels{};
+      }
+      if (auto sink = pipe.getResultSink()) {
+         // Tell the result sink that a morsel is done.
+         if (sink->markMorselDone(*context, thread_id)) {
             // Output is closed - no more work to be done.
             return Suboperator::NoMoreMorsels{};
          }
@@ -492,6 +590,7 @@ Suboperator::PickMorselResult PipelineExecutor::runROFMorsel(size_t thread_id) {
 
    // Pick a morsel.
    auto morsel = compile_state[0]->compiled->pickMorsel(thread_id);
+   recordProgress(morsel);
 
    if (std::holds_alternative<Suboperator::PickedMorsel>(morsel)) {
       // Run the first compiled morsel.
@@ -522,9 +621,12 @@ Suboperator::PickMorselResult PipelineExecutor::runROFMorsel(size_t thread_id) {
             ++current_subop_idx;
          }
       }
-      if (auto printer = pipe.getPrettyPrinter()) {
-         // Tell the printer that a morsel is done.
-         if (printer->markMorselDone(*context, thread_id)) {
+      if (morselOverflowed()) {
+         return Suboperator::NoMoreMorsels{};
+      }
+      if (auto sink = pipe.getResultSink()) {
+         // Tell the result sink that a morsel is done.
+         if (sink->markMorselDone(*context, thread_id)) {
             // Output is closed - no more work to be done.
             return Suboperator::NoMoreMorsels{};
          }
@@ -549,4 +651,15 @@ void PipelineExecutor::runMorselWithRetry(PipelineRunner& runner, size_t thread_
       runner.runMorsel(thread_id);
    }
 }
+
+bool PipelineExecutor::morselOverflowed() {
+   bool& overflow_flag = ExecutionContext::getInstalledOverflowFlag();
+   if (!overflow_flag) {
+      return false;
+   }
+   // Stop this thread, the others stop once they overflow or run out of morsels.
+   overflow_flag = false;
+   overflowed = true;
+   return true;
+}
 }
@@ -7,8 +7,10 @@
 #include "exec/InterruptableJob.h"
 #include "exec/runners/CompiledRunner.h"
 #include "exec/runners/PipelineRunner.h"
+#include <atomic>
 #include <future>
 #include <map>
+#include <optional>
 #include <utility>
 
 namespace inkfuse {
@@ -47,8 +49,16 @@ struct PipelineExecutor {
       ROF,
       /// In hybrid mode, we switch between fused and interpreted execution based on runtime statistics.
       Hybrid,
+      /// In cost based mode, the QueryExecutor picks one of the other modes for every pipeline
+      /// through the ModePlanner. A PipelineExecutor itself never runs in this mode.
+      CostBased,
    };
 
+   /// Compiled code of a pipeline, mapping the JIT intervals [start, end[ of the suboperators to
+   /// their programs. Can be reused by a structurally identical pipeline, e.g. when a prepared
+   /// query runs again with new parameter bindings.
+   using CompiledFragments = std::map<std::pair<size_t, size_t>, std::shared_ptr<IR::BackendProgram>>;
+
    /// Create a new pipeline executor.
    /// @param pipe_ the backing pipe to be executed
    /// @param mode_ the execution mode to execute the pipeline in
@@ -65,6 +75,13 @@ struct PipelineExecutor {
    /// off asynchronous preparation work.
    void preparePipeline(ExecutionMode prep_mode);
 
+   /// Reuse previously compiled fragments instead of generating code. Has to be called before
+   /// the pipeline gets prepared. JIT intervals without a fragment are compiled as usual.
+   void reuseCompiledFragments(CompiledFragments fragments);
+   /// Wait for code generation to finish and get the compiled fragments. Has to be called after
+   /// `preparePipeline` and before `runPipeline`.
+   CompiledFragments getCompiledFragments();
+
    /// Statistics about the execution of a finished pipeline.
    struct PipelineStats {
       /// How many microseconds was execution stalled on waiting for code generation?
@@ -73,6 +90,8 @@ struct PipelineExecutor {
       size_t runtime_microseconds_st = 0;
       /// How much time was spent in runtime tasks (multi threaded part)?
       size_t runtime_microseconds_mt = 0;
+      /// The execution mode every pipeline ran in.
+      std::vector<ExecutionMode> modes;
    };
    /// Run the full pipeline to completion.
    PipelineStats runPipeline();
@@ -93,6 +112,9 @@ struct PipelineExecutor {
    // This is needed to defend against e.g. hash table resizes without
    // massively complicating the generated code.
    void runMorselWithRetry(PipelineRunner& runner, size_t thread_id);
+   /// Did checked arithmetic overflow while running the current morsel? Remembers the overflow
+   /// so that the pipeline fails once all threads stopped.
+   bool morselOverflowed();
 
    /// After preparation in `runPipeline`, schedules the worker threads performing
    /// query processing. Waits for all worker threads to be done.
@@ -111,6 +133,31 @@ struct PipelineExecutor {
    /// Clean up the fuse chunks for a new morsel.
    void cleanUp(size_t thread_id);
 
+   /// Interpreted progress beyond which pending compilation of a hybrid pipeline gets interrupted.
+   /// The compiled code would arrive too late to pay off.
+   static constexpr double INTERRUPT_COMPILE_PROGRESS = 0.9;
+
+   /// Progress of the pipeline, shared with the background compilation jobs that may outlive this
+   /// PipelineExecutor. The CompileScheduler prioritizes the jobs by the remaining work.
+   struct PipelineProgress {
+      /// Rows of the source, if they are known before running the pipeline.
+      std::optional<size_t> estimated_rows;
+      /// Rows picked so far.
+      std::atomic<size_t> picked_rows = 0;
+      /// Last reported progress of the source in [0, 1].
+      std::atomic<double> fraction = 0.0;
+      /// Is execution stalled waiting for the compiled code?
+      std::atomic<bool> awaited = false;
+      /// Was the pending compilation interrupted because interpretation is about to finish?
+      std::atomic<bool> compile_interrupted = false;
+
+      /// Expected number of rows that still have to be processed.
+      double remainingWork() const;
+   };
+
+   /// Record the progress of a picked morsel.
+   void recordProgress(const Suboperator::PickMorselResult& morsel);
+
    /// Asynchronous state used for background compilation that may outlive this PipelineExecutor.
    struct AsyncCompileState {
       AsyncCompileState(QueryControlBlockArc control_block_, std::shared_ptr<ExecutionContext> context_, std::pair<size_t, size_t> jit_interval_)
@@ -158,8 +205,14 @@ struct PipelineExecutor {
    /// Was the pipeline set-up started for the compiled mode?
    bool compiler_setup_started = false;
 
+   /// Progress of the pipeline shared with the compilation jobs.
+   std::shared_ptr<PipelineProgress> progress;
+   /// Did checked arithmetic overflow in any of the threads?
+   std::atomic<bool> overflowed = false;
    /// The background thread performing compilation.
    std::vector<std::thread> compilation_jobs;
+   /// Fragments that were compiled for a structurally identical pipeline before.
+   CompiledFragments reused_fragments;
 
    /// Query executor is responsible for running runtime tasks. It needs access to the
    /// ExecutionContext.
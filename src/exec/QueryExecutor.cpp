@@ -1,8 +1,11 @@
 #include "exec/QueryExecutor.h"
+#include "exec/ModePlanner.h"
 
 #include <chrono>
+#include <exception>
 #include <list>
 #include <thread>
+#include <unordered_map>
 #include <vector>
 
 namespace inkfuse::QueryExecutor {
@@ -19,16 +22,28 @@ RuntimeStats runRuntimeTask(ExecutionContext& ctx, const PipelineDAG::RuntimeTas
    auto st_start = std::chrono::steady_clock::now();
    task.prepare_function(ctx, num_threads);
    auto st_stop = std::chrono::steady_clock::now();
-   // Run the parallel workers.
+   // Run the parallel workers. Errors are rethrown on the calling thread once all workers are done.
    std::vector<std::thread> workers;
+   std::vector<std::exception_ptr> errors(num_threads);
    workers.reserve(num_threads);
    for (size_t k = 0; k < num_threads; ++k) {
-      workers.emplace_back(task.worker_function, std::ref(ctx), k);
+      workers.emplace_back([&, k]() {
+         try {
+            task.worker_function(ctx, k);
+         } catch (...) {
+            errors[k] = std::current_exception();
+         }
+      });
    }
    // Wait for them to be done.
    for (auto& worker : workers) {
       worker.join();
    }
+   for (const auto& error : errors) {
+      if (error) {
+         std::rethrow_exception(error);
+      }
+   }
    auto mt_stop = std::chrono::steady_clock::now();
    size_t st_micros = std::chrono::duration_cast<std::chrono::microseconds>(st_stop - st_start).count();
    size_t mt_micros = std::chrono::duration_cast<std::chrono::microseconds>(mt_stop - st_stop).count();
@@ -38,22 +53,65 @@ RuntimeStats runRuntimeTask(ExecutionContext& ctx, const PipelineDAG::RuntimeTas
    };
 }
 
+/// Describe the suboperator structure of every pipeline. Compiled code can only be reused
+/// by plans with the same structure.
+std::vector<std::string> planSignature(const PipelineDAG& dag) {
+   std::vector<std::string> signature;
+   // IUs are identified by the order in which they appear.
+   std::unordered_map<const IU*, size_t> iu_ids;
+   auto iu_id = [&](const IU* iu) {
+      return iu_ids.emplace(iu, iu_ids.size()).first->second;
+   };
+   for (const auto& pipe : dag.getPipelines()) {
+      std::string pipe_signature;
+      for (const auto& op : pipe->getSubops()) {
+         pipe_signature += op->id() + "(";
+         for (const IU* iu : op->getSourceIUs()) {
+            pipe_signature += std::to_string(iu_id(iu)) + ",";
+         }
+         pipe_signature += ")->(";
+         for (const IU* iu : op->getIUs()) {
+            pipe_signature += std::to_string(iu_id(iu)) + ",";
+         }
+         pipe_signature += ");";
+      }
+      signature.push_back(std::move(pipe_signature));
+   }
+   return signature;
+}
+
 } // namespace
 
 StepwiseExecutor::StepwiseExecutor(PipelineExecutor::QueryControlBlockArc control_block_, PipelineExecutor::ExecutionMode mode, const std::string& qname, size_t num_threads_)
    : control_block(std::move(control_block_)), mode(mode), qname(qname), num_threads(num_threads_) {
 }
 
+void StepwiseExecutor::reuseCompiledFragments(std::vector<PipelineExecutor::CompiledFragments> fragments_) {
+   assert(executors.empty());
+   if (!fragments_.empty() && fragments_.size() != control_block->dag.getPipelines().size()) {
+      throw std::runtime_error("Compiled fragments can only be reused for a query with the same pipelines");
+   }
+   fragments = std::move(fragments_);
+}
+
 void StepwiseExecutor::prepareQuery() {
    const auto& pipes = control_block->dag.getPipelines();
    for (size_t idx = 0; idx < pipes.size(); ++idx) {
       // Step 1: Set up the executors for the pipelines.
       const auto& pipe = pipes[idx];
+      auto pipe_mode = mode;
+      if (mode == PipelineExecutor::ExecutionMode::CostBased) {
+         // Let the cost model pick the mode of every pipeline.
+         pipe_mode = ModePlanner::plan(*pipe, num_threads).mode;
+      }
       // TODO(benjamin) - run with multiple threads
-      auto& executor = executors.emplace_back(*pipe, num_threads, mode, qname + "_pipe_" + std::to_string(idx), control_block);
+      auto& executor = executors.emplace_back(*pipe, num_threads, pipe_mode, qname + "_pipe_" + std::to_string(idx), control_block);
+      if (!fragments.empty()) {
+         executor.reuseCompiledFragments(fragments[idx]);
+      }
       // If we have to generate code, already kick off asynchronous compilation.
       // This hides compilation latency much better than kicking it off at the beginning of each pipeline.
-      switch (mode) {
+      switch (pipe_mode) {
          case PipelineExecutor::ExecutionMode::Fused:
             executor.preparePipeline(PipelineExecutor::ExecutionMode::Fused);
             break;
@@ -69,6 +127,15 @@ void StepwiseExecutor::prepareQuery() {
    }
 }
 
+std::vector<PipelineExecutor::CompiledFragments> StepwiseExecutor::getCompiledFragments() {
+   std::vector<PipelineExecutor::CompiledFragments> result;
+   result.reserve(executors.size());
+   for (auto& executor : executors) {
+      result.push_back(executor.getCompiledFragments());
+   }
+   return result;
+}
+
 PipelineExecutor::PipelineStats StepwiseExecutor::runQuery() {
    PipelineExecutor::PipelineStats total_stats;
    size_t pipeline_idx = 0;
@@ -78,6 +145,7 @@ PipelineExecutor::PipelineStats StepwiseExecutor::runQuery() {
       // Step 2: Run the pipelines.
       const auto pipe_stats = executor.runPipeline();
       total_stats.codegen_microseconds += pipe_stats.codegen_microseconds;
+      total_stats.modes.insert(total_stats.modes.end(), pipe_stats.modes.begin(), pipe_stats.modes.end());
       // Run all tasks belonging to this pipeline.
       while (rt_tasks_it != rt_tasks.end() && rt_tasks_it->after_pipe <= pipeline_idx) {
          assert(rt_tasks_it->after_pipe == pipeline_idx);
@@ -100,4 +168,62 @@ PipelineExecutor::PipelineStats runQuery(PipelineExecutor::QueryControlBlockArc
    return executor.runQuery();
 }
 
+void QueryParameters::bind(const std::string& name, IR::ValuePtr value) {
+   values[name] = std::move(value);
+}
+
+IR::ValuePtr QueryParameters::get(const std::string& name) const {
+   auto it = values.find(name);
+   if (it == values.end()) {
+      throw std::runtime_error("Query parameter " + name + " is not bound");
+   }
+   return IR::ParamVal::build(it->second->copy());
+}
+
+PreparedQuery::PreparedQuery(PlanBuilder builder_, QueryParameters bindings_, PipelineExecutor::ExecutionMode mode_, std::string qname_, size_t num_threads_)
+   : builder(std::move(builder_)), bindings(std::move(bindings_)), mode(mode_), qname(std::move(qname_)), num_threads(num_threads_) {
+   auto control_block = std::make_shared<PipelineExecutor::QueryControlBlock>(builder(bindings));
+   signature = planSignature(control_block->dag);
+   StepwiseExecutor executor(std::move(control_block), mode, qname, num_threads);
+   executor.prepareQuery();
+   // Wait for the compiled code, the query itself does not run.
+   fragments = executor.getCompiledFragments();
+}
+
+PipelineExecutor::PipelineStats PreparedQuery::run(const QueryParameters& new_bindings) {
+   QueryParameters run_bindings;
+   for (const auto& [name, value] : bindings.values) {
+      auto rebound = new_bindings.values.find(name);
+      if (rebound == new_bindings.values.end()) {
+         run_bindings.bind(name, value->copy());
+         continue;
+      }
+      // The prepared code interprets the parameter state with the prepared type.
+      if (rebound->second->getType()->id() != value->getType()->id()) {
+         throw std::runtime_error("Query parameter " + name + " has to keep its prepared type");
+      }
+      run_bindings.bind(name, rebound->second->copy());
+   }
+   for (const auto& [name, value] : new_bindings.values) {
+      if (!bindings.values.count(name)) {
+         throw std::runtime_error("Query parameter " + name + " was not prepared");
+      }
+   }
+   auto control_block = std::make_shared<PipelineExecutor::QueryControlBlock>(builder(run_bindings));
+   auto run_signature = planSignature(control_block->dag);
+   StepwiseExecutor executor(std::move(control_block), mode, qname, num_threads);
+   if (run_signature == signature) {
+      executor.reuseCompiledFragments(fragments);
+      executor.prepareQuery();
+      return executor.runQuery();
+   }
+   // The plan changed, e.g. because an adaptive operator picked a different strategy.
+   // Compile the new plan and keep its code for the following runs.
+   executor.prepareQuery();
+   auto stats = executor.runQuery();
+   fragments = executor.getCompiledFragments();
+   signature = std::move(run_signature);
+   return stats;
+}
+
 } // namespace inkfuse
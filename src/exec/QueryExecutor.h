@@ -1,8 +1,13 @@
 #ifndef INKFUSE_QUERYEXECUTOR_H
 #define INKFUSE_QUERYEXECUTOR_H
 
+#include "codegen/Value.h"
 #include "exec/PipelineExecutor.h"
+#include <functional>
 #include <list>
+#include <string>
+#include <unordered_map>
+#include <vector>
 
 namespace inkfuse {
 
@@ -14,8 +19,14 @@ namespace QueryExecutor {
 struct StepwiseExecutor {
    StepwiseExecutor(PipelineExecutor::QueryControlBlockArc control_block_, PipelineExecutor::ExecutionMode mode, const std::string& qname, size_t num_threads_ = 1);
 
+   /// Reuse the code compiled for a structurally identical query instead of generating code.
+   /// Has to be called before `prepareQuery`. Contains the fragments of every pipeline.
+   void reuseCompiledFragments(std::vector<PipelineExecutor::CompiledFragments> fragments_);
    /// Prepare the query, kicking off compilation.
    void prepareQuery();
+   /// Wait for compilation to finish and get the compiled fragments of every pipeline.
+   /// Has to be called between `prepareQuery` and `runQuery`.
+   std::vector<PipelineExecutor::CompiledFragments> getCompiledFragments();
    /// Run the query, perfoming the actual execution. Returns aggregated (summed) pipeline statistics.
    PipelineExecutor::PipelineStats runQuery();
 
@@ -25,6 +36,51 @@ struct StepwiseExecutor {
    const std::string& qname;
    std::list<PipelineExecutor> executors;
    size_t num_threads;
+   /// Previously compiled fragments for every pipeline.
+   std::vector<PipelineExecutor::CompiledFragments> fragments;
+};
+
+/// Named parameter bindings of a prepared query.
+struct QueryParameters {
+   /// Bind the parameter to a new value.
+   void bind(const std::string& name, IR::ValuePtr value);
+   /// Get the value of a bound parameter. The returned value never gets inlined into generated
+   /// code, this way the code can be reused for different bindings.
+   IR::ValuePtr get(const std::string& name) const;
+
+   /// The bound values.
+   std::unordered_map<std::string, IR::ValuePtr> values;
+};
+
+/// A prepared query generates code once and then runs many times with different parameter bindings.
+/// Every run builds and decays a fresh algebra tree - both are cheap. The pipelines of the new tree
+/// are structurally identical to the prepared ones, so they run on the prepared machine code and there
+/// is no code generation on the critical path.
+struct PreparedQuery {
+   /// Builds the algebra tree of the query. All literals that change between runs have to
+   /// be taken from the parameters, literals that are built directly get baked into the code.
+   using PlanBuilder = std::function<RelAlgOpPtr(const QueryParameters&)>;
+
+   /// Prepare the query with the initial parameter bindings. Waits until the code is compiled.
+   PreparedQuery(PlanBuilder builder_, QueryParameters bindings_, PipelineExecutor::ExecutionMode mode_, std::string qname_ = "prepared", size_t num_threads_ = 1);
+
+   /// Run the query with new bindings. Parameters without new binding keep their prepared value.
+   /// If the builder returns a plan with a different structure (e.g. an AdaptiveFilter that
+   /// learned a new conjunct order), the new plan gets compiled and replaces the prepared code.
+   /// Returns aggregated (summed) pipeline statistics.
+   PipelineExecutor::PipelineStats run(const QueryParameters& new_bindings = {});
+
+   private:
+   PlanBuilder builder;
+   /// The prepared bindings. Runs have to bind values of the same types.
+   QueryParameters bindings;
+   PipelineExecutor::ExecutionMode mode;
+   std::string qname;
+   size_t num_threads;
+   /// Compiled fragments for every pipeline.
+   std::vector<PipelineExecutor::CompiledFragments> fragments;
+   /// Suboperator structure of the pipelines the fragments were compiled for.
+   std::vector<std::string> signature;
 };
 
 /// Run a complete query to completion. Returns aggregated (summed) pipeline statistics.
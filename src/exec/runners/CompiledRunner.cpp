@@ -41,4 +41,18 @@ bool CompiledRunner::generateMachineCode(InterruptableJob& interrupt)
    return prepared;
 }
 
+std::shared_ptr<IR::BackendProgram> CompiledRunner::getProgram() const
+{
+   assert(prepared);
+   return program;
+}
+
+void CompiledRunner::reuseProgram(std::shared_ptr<IR::BackendProgram> program_)
+{
+   program = std::move(program_);
+   fct = reinterpret_cast<uint8_t(*)(void**)>(program->getFunction("execute"));
+   assert(fct);
+   prepared = true;
+}
+
 }
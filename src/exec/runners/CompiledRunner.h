@@ -21,11 +21,17 @@ struct CompiledRunner final : public PipelineRunner  {
    void generateC();
    bool generateMachineCode(InterruptableJob& interrupt);
 
+   /// Get the compiled program. Only valid after successful machine code generation.
+   std::shared_ptr<IR::BackendProgram> getProgram() const;
+   /// Run a program that was compiled for a structurally identical pipeline before.
+   /// Replaces both C and machine code generation.
+   void reuseProgram(std::shared_ptr<IR::BackendProgram> program_);
+
    private:
    // The compilation backend.
    BackendC backend;
-   /// The backing program.
-   std::unique_ptr<IR::BackendProgram> program;
+   /// The backing program. Shared with later runners reusing the machine code.
+   std::shared_ptr<IR::BackendProgram> program;
    /// Name of the pipeline/program to be generated.
    std::string name;
 };
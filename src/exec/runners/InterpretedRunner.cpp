@@ -1,14 +1,38 @@
 #include "InterpretedRunner.h"
+#include "algebra/suboperators/ColumnFilter.h"
+#include "algebra/suboperators/RuntimeFunctionSubop.h"
 #include "algebra/suboperators/sources/TableScanSource.h"
 #include "interpreter/FragmentCache.h"
+#include "runtime/HashTables.h"
+#include "runtime/NewHashTables.h"
+#include <algorithm>
+#include <chrono>
+#include <cstring>
 
 namespace inkfuse {
 
+namespace {
+
+/// Batch hash kernel of a hash table with the signature of the BatchHashState.
+template <class HashTable, uint64_t key_width>
+void batchHashKernel(const void* table, const char* keys, size_t stride, bool indirect, size_t count, uint64_t* hashes) {
+   reinterpret_cast<const HashTable*>(table)->template compute_hash_and_prefetch_batch<key_width>(keys, stride, indirect, count, hashes);
+}
+
+/// Batch hash kernel of a thread-local aggregation hash table.
+template <class HashTable>
+void localBatchHashKernel(const void* table, const char* keys, size_t stride, bool indirect, size_t count, uint64_t* hashes) {
+   reinterpret_cast<const HashTable*>(table)->computeHashAndPrefetchBatch(keys, stride, indirect, count, hashes);
+}
+
+}
+
 InterpretedRunner::InterpretedRunner(const Pipeline& backing_pipeline, size_t idx, ExecutionContext& original_context, bool pick_from_source_table_)
    : PipelineRunner(getRepiped(backing_pipeline, idx), original_context), pick_from_source_table(pick_from_source_table_) {
    // Get the unique identifier of the operation which has to be interpreted.
    auto& op = backing_pipeline.getSubops()[idx];
    fragment_id = op->id();
+   cost_callback = op->getOptimizationProperties().rt_cost_callback;
    // Get the function we have to interpret.
    auto& cache = FragmentCache::instance();
    fct = reinterpret_cast<uint8_t (*)(void**)>(cache.getFragment(fragment_id));
@@ -17,7 +41,11 @@ InterpretedRunner::InterpretedRunner(const Pipeline& backing_pipeline, size_t id
    }
    prepared = true;
 
-   if (dynamic_cast<TScanIUProvider*>(op.get())) {
+   if (auto provider = dynamic_cast<TScanIUProvider*>(op.get()); provider && provider->readsValidity()) {
+      // NULL indicators have to be expanded from the packed validity bitmap.
+      mode = ExecutionMode::ValidityScan;
+      validity_scan_iu = op->getIUs().at(0);
+   } else if (provider) {
       // This is actually an IU provider.
       mode = ExecutionMode::ZeroCopyScan;
       zero_copy_state = ZeroCopyScanState{
@@ -27,6 +55,58 @@ InterpretedRunner::InterpretedRunner(const Pipeline& backing_pipeline, size_t id
       };
    }
 
+   if (auto filter = dynamic_cast<const ColumnFilterLogic*>(op.get())) {
+      // Filters can pick between a branching and a branch-free primitive.
+      // Both operate on the same states, so they can be exchanged between morsels.
+      const auto branch_free_id = filter->branchFreeId();
+      auto branch_free_fct = branch_free_id.empty() ? nullptr : cache.getFragment(branch_free_id);
+      auto scope = dynamic_cast<ColumnFilterScope*>(backing_pipeline.tryGetProvider(*filter->getSourceIUs()[0]));
+      if (branch_free_fct && scope) {
+         mode = ExecutionMode::SelectivityFilter;
+         selectivity_filter_state = std::make_unique<SelectivityFilterState>();
+         selectivity_filter_state->input_iu = filter->getSourceIUs()[1];
+         selectivity_filter_state->output_iu = filter->getIUs()[0];
+         selectivity_filter_state->branch_free_fct = reinterpret_cast<uint8_t (*)(void**)>(branch_free_fct);
+         selectivity_filter_state->selectivity = &scope->getSelectivity();
+      }
+   }
+
+   if (auto rt_fct = dynamic_cast<const RuntimeFunctionSubop*>(op.get())) {
+      // Hashing and prefetching can run on the whole morsel at once. The produced
+      // hashes are the same as the ones of the primitive.
+      using SimpleKeyTable = AtomicHashTable<SimpleKeyComparator>;
+      using ComplexKeyTable = AtomicHashTable<ComplexKeyComparator>;
+      const std::string simple_name = "ht_" + SimpleKeyTable::ID + "_compute_hash_and_prefetch";
+      decltype(BatchHashState::kernel) kernel = nullptr;
+      if (rt_fct->fname() == simple_name) {
+         kernel = batchHashKernel<SimpleKeyTable, 0>;
+      } else if (rt_fct->fname() == simple_name + "_fixed_4") {
+         kernel = batchHashKernel<SimpleKeyTable, 4>;
+      } else if (rt_fct->fname() == simple_name + "_fixed_8") {
+         kernel = batchHashKernel<SimpleKeyTable, 8>;
+      } else if (rt_fct->fname() == "ht_" + ComplexKeyTable::ID + "_compute_hash_and_prefetch") {
+         kernel = batchHashKernel<ComplexKeyTable, 0>;
+      } else if (rt_fct->fname() == "ht_" + HashTableSimpleKey::ID + "_compute_hash_and_prefetch") {
+         kernel = localBatchHashKernel<HashTableSimpleKey>;
+      } else if (rt_fct->fname() == "ht_" + HashTableComplexKey::ID + "_compute_hash_and_prefetch") {
+         kernel = localBatchHashKernel<HashTableComplexKey>;
+      }
+      if (kernel) {
+         mode = ExecutionMode::BatchHash;
+         const IU* key_iu = rt_fct->getSourceIUs()[0];
+         // Filtered packed keys become pointers into the original key column.
+         const bool indirect = dynamic_cast<IR::Pointer*>(key_iu->type.get()) != nullptr;
+         batch_hash_state = BatchHashState{
+            .subop = op.get(),
+            .key_iu = key_iu,
+            .hash_iu = rt_fct->getIUs()[0],
+            .stride = indirect ? sizeof(char*) : key_iu->type->numBytes(),
+            .indirect = indirect,
+            .kernel = kernel,
+         };
+      }
+   }
+
    // Extract all key packer IUs as these need special treatment during interpretation.
    for (const auto& subop : pipe->getSubops()) {
       if (auto* as_key_packer = dynamic_cast<KeyPackerSubop*>(subop.get())) {
@@ -48,7 +128,7 @@ InterpretedRunner::~InterpretedRunner() {
 }
 
 Suboperator::PickMorselResult InterpretedRunner::pickMorsel(size_t thread_id) {
-   if (mode == ExecutionMode::ZeroCopyScan && !pick_from_source_table) {
+   if ((mode == ExecutionMode::ZeroCopyScan || mode == ExecutionMode::ValidityScan) && !pick_from_source_table) {
       // If this is a suboperator interpreting a table scan, but not the first one,
       // then we should not pick from the table scan. We need to bind to the original
       // morsel of the first interpreter instead.
@@ -74,6 +154,20 @@ Suboperator::PickMorselResult InterpretedRunner::pickMorsel(size_t thread_id) {
 }
 
 void InterpretedRunner::runMorsel(size_t thread_id) {
+   if (!cost_callback) {
+      dispatchMorsel(thread_id);
+      return;
+   }
+   // Measure how long the primitive takes on the picked morsel.
+   const auto driver_state = reinterpret_cast<LoopDriverState*>(pipe->suboperators[0]->accessState(thread_id));
+   const size_t rows = driver_state->end - driver_state->start;
+   const auto start = std::chrono::steady_clock::now();
+   dispatchMorsel(thread_id);
+   const auto stop = std::chrono::steady_clock::now();
+   cost_callback(rows, std::chrono::duration_cast<std::chrono::nanoseconds>(stop - start).count());
+}
+
+void InterpretedRunner::dispatchMorsel(size_t thread_id) {
    // Dispatch to the right interpretation strategy.
    switch (mode) {
       case ExecutionMode::DefaultRunMorsel:
@@ -84,7 +178,51 @@ void InterpretedRunner::runMorsel(size_t thread_id) {
          // Custom zero-copy scan interpreter.
          runZeroCopyScan(thread_id);
          break;
+      case ExecutionMode::ValidityScan:
+         runValidityScan(thread_id);
+         break;
+      case ExecutionMode::SelectivityFilter:
+         runSelectivityFilter(thread_id);
+         break;
+      case ExecutionMode::BatchHash:
+         runBatchHash(thread_id);
+         break;
+   }
+}
+
+void InterpretedRunner::runBatchHash(size_t thread_id) {
+   auto& state = *batch_hash_state;
+   // The morsel of the key column we have to hash.
+   const auto driver_state = reinterpret_cast<LoopDriverState*>(pipe->suboperators[0]->accessState(thread_id));
+   const auto fct_state = reinterpret_cast<RuntimeFunctionSubopState*>(state.subop->accessState(thread_id));
+   const Column& keys = context.getColumn(*state.key_iu, thread_id);
+   Column& hashes = context.getColumn(*state.hash_iu, thread_id);
+   const size_t count = driver_state->end - driver_state->start;
+   // Append the hashes to the output column, as the FuseChunkSink of the primitive would.
+   state.kernel(
+      fct_state->this_object,
+      keys.raw_data + driver_state->start * state.stride,
+      state.stride,
+      state.indirect,
+      count,
+      reinterpret_cast<uint64_t*>(hashes.raw_data) + hashes.size);
+   hashes.size += count;
+}
+
+void InterpretedRunner::runSelectivityFilter(size_t thread_id) {
+   assert(prepared && fct);
+   auto& state = *selectivity_filter_state;
+   // Pick the primitive based on the selectivity of the previous morsels.
+   const bool branch_free = state.selectivity->preferBranchFree();
+   auto& out_col = context.getColumn(*state.output_iu, thread_id);
+   const size_t out_before = out_col.size;
+   if (branch_free) {
+      state.branch_free_fct(states[thread_id].data());
+   } else {
+      fct(states[thread_id].data());
    }
+   // Track the selectivity for the next morsels.
+   state.selectivity->record(context.getColumn(*state.input_iu, thread_id).size, out_col.size - out_before);
 }
 
 void InterpretedRunner::runZeroCopyScan(size_t thread_id) {
@@ -102,7 +240,8 @@ void InterpretedRunner::runZeroCopyScan(size_t thread_id) {
       zero_copy_state->fuse_chunk_ptrs[thread_id] = context.getColumn(*zero_copy_state->output_iu, thread_id).raw_data;
    }
    // Get the state of the picked morsel.
-   TScanDriver* driver = reinterpret_cast<TScanDriver*>(pipe->suboperators[0].get());
+   // Any loop driver works here, e.g. a SortDriver feeding a TScanIUProvider.
+   LoopDriver* driver = reinterpret_cast<LoopDriver*>(pipe->suboperators[0].get());
    TScanIUProvider* provider = reinterpret_cast<TScanIUProvider*>(pipe->suboperators[1].get());
    const auto driver_state = reinterpret_cast<LoopDriverState*>(driver->accessState(thread_id));
    const auto provider_state = reinterpret_cast<IndexedIUProviderState*>(provider->accessState(thread_id));
@@ -112,6 +251,33 @@ void InterpretedRunner::runZeroCopyScan(size_t thread_id) {
    out_col.raw_data = (*provider_state->start) + (driver_state->start * zero_copy_state->type_width);
 }
 
+void InterpretedRunner::runValidityScan(size_t thread_id) {
+   LoopDriver* driver = reinterpret_cast<LoopDriver*>(pipe->suboperators[0].get());
+   TScanIUProvider* provider = reinterpret_cast<TScanIUProvider*>(pipe->suboperators[1].get());
+   const auto driver_state = reinterpret_cast<LoopDriverState*>(driver->accessState(thread_id));
+   const auto provider_state = reinterpret_cast<IndexedIUProviderState*>(provider->accessState(thread_id));
+   const auto bits = reinterpret_cast<const uint64_t*>(*provider_state->start);
+   Column& out_col = context.getColumn(*validity_scan_iu, thread_id);
+   out_col.size = driver_state->end - driver_state->start;
+   char* out = out_col.raw_data;
+   for (size_t row = driver_state->start; row < driver_state->end;) {
+      // Morsels usually start on a word boundary, only the last word is partial.
+      const size_t offset = row % 64;
+      const size_t count = std::min<size_t>(64 - offset, driver_state->end - row);
+      const uint64_t mask = count == 64 ? ~0ull : (1ull << count) - 1;
+      const uint64_t valid = (bits[row / 64] >> offset) & mask;
+      if (valid == mask) {
+         std::memset(out, 0, count);
+      } else {
+         for (size_t bit = 0; bit < count; ++bit) {
+            out[bit] = !((valid >> bit) & 1);
+         }
+      }
+      out += count;
+      row += count;
+   }
+}
+
 // static
 PipelinePtr InterpretedRunner::getRepiped(const Pipeline& backing_pipeline, size_t idx) {
    auto res = backing_pipeline.repipeAll(idx, idx + 1);
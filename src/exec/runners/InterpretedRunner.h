@@ -10,6 +10,8 @@
 
 namespace inkfuse {
 
+struct FilterSelectivity;
+
 /// The pipeline intepreter receives a single pipeline
 struct InterpretedRunner final : public PipelineRunner {
    /// Create a pipeline interpreter which will interpret the sub-operator at the given index.
@@ -38,9 +40,19 @@ struct InterpretedRunner final : public PipelineRunner {
       DefaultRunMorsel,
       /// Optimized zero-copy path for table scans.
       ZeroCopyScan,
+      /// Table scans of validity bitmaps, expanded a word at a time.
+      ValidityScan,
+      /// Filters picking between the branching and the branch-free primitive.
+      SelectivityFilter,
+      /// Hash table hash-and-prefetch running the batch kernel of the hash table.
+      BatchHash,
    };
    /// Which execution mode `runMorsel` is bound to.
    ExecutionMode mode = ExecutionMode::DefaultRunMorsel;
+   /// Run a morsel in the bound execution mode.
+   void dispatchMorsel(size_t thread_id);
+   /// Cost callback of the interpreted suboperator, invoked after every morsel if set.
+   std::function<void(size_t rows, uint64_t nanos)> cost_callback;
 
    /// State required to make the zero copy scan work.
    struct ZeroCopyScanState {
@@ -57,6 +69,45 @@ struct InterpretedRunner final : public PipelineRunner {
    std::vector<const IU*> key_packer_ius;
    /// Custom interpreter for a zero copy scan.
    void runZeroCopyScan(size_t thread_id);
+   /// NULL indicator IU produced by a validity scan.
+   const IU* validity_scan_iu = nullptr;
+   /// Custom interpreter for a validity scan. Fully valid words of the bitmap become a memset.
+   void runValidityScan(size_t thread_id);
+
+   /// State required to pick the filter primitive from the observed selectivity.
+   struct SelectivityFilterState {
+      /// The filtered input IU.
+      const IU* input_iu;
+      /// The redefined IU after the filter.
+      const IU* output_iu;
+      /// The branch-free primitive.
+      uint8_t (*branch_free_fct)(void**);
+      /// The selectivity of the filter, shared with the code generation of the fused pipeline.
+      FilterSelectivity* selectivity;
+   };
+   std::unique_ptr<SelectivityFilterState> selectivity_filter_state;
+   /// Custom interpreter for filters.
+   void runSelectivityFilter(size_t thread_id);
+
+   /// State required to hash and prefetch all keys of a morsel at once.
+   struct BatchHashState {
+      /// The runtime function whose state references the hash table.
+      const Suboperator* subop;
+      /// The hashed key IU.
+      const IU* key_iu;
+      /// The produced hash IU.
+      const IU* hash_iu;
+      /// Distance between two keys in the key column.
+      size_t stride;
+      /// Does the key column contain pointers to the keys?
+      bool indirect;
+      /// The batch kernel of the hash table.
+      void (*kernel)(const void* table, const char* keys, size_t stride, bool indirect, size_t count, uint64_t* hashes);
+   };
+   std::optional<BatchHashState> batch_hash_state;
+   /// Custom interpreter for hash-and-prefetch primitives. Calling the runtime function
+   /// for every tuple interleaves hashing with the prefetches, the batch kernel separates them.
+   void runBatchHash(size_t thread_id);
 };
 }
 
@@ -1,8 +1,13 @@
 #include "interpreter/AggregationFragmentizer.h"
 #include "algebra/suboperators/aggregation/AggComputeAvg.h"
+#include "algebra/suboperators/aggregation/AggComputeHyperLogLog.h"
+#include "algebra/suboperators/aggregation/AggComputeQuantile.h"
 #include "algebra/suboperators/aggregation/AggComputeUnpack.h"
 #include "algebra/suboperators/aggregation/AggReaderSubop.h"
 #include "algebra/suboperators/aggregation/AggStateCount.h"
+#include "algebra/suboperators/aggregation/AggStateHyperLogLog.h"
+#include "algebra/suboperators/aggregation/AggStateMinMax.h"
+#include "algebra/suboperators/aggregation/AggStateQuantile.h"
 #include "algebra/suboperators/aggregation/AggStateSum.h"
 #include "algebra/suboperators/aggregation/AggregatorSubop.h"
 
@@ -10,7 +15,8 @@ namespace inkfuse {
 
 namespace {
 
-const auto unpacking_types = TypeDecorator{}.attachTypes().produce();
+// Strings are unpacked as the result of min and max aggregates.
+const auto unpacking_types = TypeDecorator{}.attachTypes().attachStringType().produce();
 
 }
 
@@ -20,22 +26,97 @@ AggregationFragmentizer::AggregationFragmentizer() {
 }
 
 void AggregationFragmentizer::fragmentizeAggregators() {
-   // Fragmentize count state over arbitrary types.
-   auto& [name, pipe] = pipes.emplace_back();
-   auto& state = agg_states.emplace_back(std::make_unique<AggStateCount>());
-   auto& ptr_iu = generated_ius.emplace_back(IU{IR::Pointer::build(IR::Char::build())});
-   auto& agg_iu = generated_ius.emplace_back(IU{IR::SignedInt::build(8)});
-   auto& op = pipe.attachSuboperator(AggregatorSubop::build(nullptr, *state, ptr_iu, agg_iu));
-   name = op.id();
-
-   // Fragmentize sum over all numeric types.
-   for (const auto& type : TypeDecorator{}.attachNumeric().produce()) {
+   // Both a regular and a nullable fragment for every aggregate state.
+   for (bool nullable : {false, true}) {
+      const IU* null_indicator = nullptr;
+      if (nullable) {
+         null_indicator = &generated_ius.emplace_back(IU{IR::Bool::build()});
+      }
+
+      // Fragmentize count state over arbitrary types.
       auto& [name, pipe] = pipes.emplace_back();
-      auto& state = agg_states.emplace_back(std::make_unique<AggStateSum>(type));
+      auto& state = agg_states.emplace_back(std::make_unique<AggStateCount>());
       auto& ptr_iu = generated_ius.emplace_back(IU{IR::Pointer::build(IR::Char::build())});
-      auto& agg_iu = generated_ius.emplace_back(IU{type});
+      auto& agg_iu = generated_ius.emplace_back(IU{IR::SignedInt::build(8)});
+      agg_iu.null_indicator = null_indicator;
       auto& op = pipe.attachSuboperator(AggregatorSubop::build(nullptr, *state, ptr_iu, agg_iu));
       name = op.id();
+
+      // Fragmentize sum over all numeric types.
+      for (const auto& type : TypeDecorator{}.attachNumeric().produce()) {
+         auto& [name, pipe] = pipes.emplace_back();
+         auto& state = agg_states.emplace_back(std::make_unique<AggStateSum>(type));
+         auto& ptr_iu = generated_ius.emplace_back(IU{IR::Pointer::build(IR::Char::build())});
+         auto& agg_iu = generated_ius.emplace_back(IU{type});
+         agg_iu.null_indicator = null_indicator;
+         auto& op = pipe.attachSuboperator(AggregatorSubop::build(nullptr, *state, ptr_iu, agg_iu));
+         name = op.id();
+      }
+
+      // Fragmentize 16 byte sums over 8 byte decimals.
+      {
+         auto& [name, pipe] = pipes.emplace_back();
+         auto type = IR::Decimal::build(IR::Decimal::MAX_PRECISION_8_BYTES, 0);
+         auto& state = agg_states.emplace_back(std::make_unique<AggStateSum>(type, IR::Decimal::build(IR::Decimal::MAX_PRECISION, 0)));
+         auto& ptr_iu = generated_ius.emplace_back(IU{IR::Pointer::build(IR::Char::build())});
+         auto& agg_iu = generated_ius.emplace_back(IU{type});
+         agg_iu.null_indicator = null_indicator;
+         auto& op = pipe.attachSuboperator(AggregatorSubop::build(nullptr, *state, ptr_iu, agg_iu));
+         name = op.id();
+      }
+
+      // Fragmentize min and max over all numeric types and strings.
+      for (const auto& type : TypeDecorator{}.attachNumeric().attachStringType().produce()) {
+         for (bool is_min : {true, false}) {
+            auto& [name, pipe] = pipes.emplace_back();
+            AggStatePtr state_ptr;
+            if (is_min) {
+               state_ptr = std::make_unique<AggStateMin>(type);
+            } else {
+               state_ptr = std::make_unique<AggStateMax>(type);
+            }
+            auto& state = agg_states.emplace_back(std::move(state_ptr));
+            auto& ptr_iu = generated_ius.emplace_back(IU{IR::Pointer::build(IR::Char::build())});
+            auto& agg_iu = generated_ius.emplace_back(IU{type});
+            agg_iu.null_indicator = null_indicator;
+            auto& op = pipe.attachSuboperator(AggregatorSubop::build(nullptr, *state, ptr_iu, agg_iu));
+            name = op.id();
+         }
+      }
+
+      // Fragmentize HyperLogLog sketches over all numeric types and strings.
+      for (const auto& type : TypeDecorator{}.attachNumeric().attachStringType().produce()) {
+         if (!dynamic_cast<IR::String*>(type.get()) && type->numBytes() > 8) {
+            // Sketches hash at most 8 bytes of fixed size values.
+            continue;
+         }
+         auto& [name, pipe] = pipes.emplace_back();
+         auto& state = agg_states.emplace_back(std::make_unique<AggStateHyperLogLog>(type));
+         auto& ptr_iu = generated_ius.emplace_back(IU{IR::Pointer::build(IR::Char::build())});
+         auto& agg_iu = generated_ius.emplace_back(IU{type});
+         agg_iu.null_indicator = null_indicator;
+         auto& op = pipe.attachSuboperator(AggregatorSubop::build(nullptr, *state, ptr_iu, agg_iu));
+         name = op.id();
+      }
+
+      // Fragmentize exact and approximate quantiles over integers and floating points.
+      for (const auto& type : TypeDecorator{}.attachIntegers().attachFloatingPoints().produce()) {
+         for (bool exact : {true, false}) {
+            auto& [name, pipe] = pipes.emplace_back();
+            AggStatePtr state_ptr;
+            if (exact) {
+               state_ptr = std::make_unique<AggStateMedian>(type);
+            } else {
+               state_ptr = std::make_unique<AggStateTDigest>(type);
+            }
+            auto& state = agg_states.emplace_back(std::move(state_ptr));
+            auto& ptr_iu = generated_ius.emplace_back(IU{IR::Pointer::build(IR::Char::build())});
+            auto& agg_iu = generated_ius.emplace_back(IU{type});
+            agg_iu.null_indicator = null_indicator;
+            auto& op = pipe.attachSuboperator(AggregatorSubop::build(nullptr, *state, ptr_iu, agg_iu));
+            name = op.id();
+         }
+      }
    }
 }
 
@@ -50,12 +131,44 @@ void AggregationFragmentizer::fragmentizeAggReaders() {
       name = op.id();
    }
 
+   // Fragmentize the HyperLogLog estimate.
+   {
+      auto& [name, pipe] = pipes.emplace_back();
+      auto& compute = agg_computes.emplace_back(std::make_unique<AggComputeHyperLogLog>());
+      auto& ptr_iu = generated_ius.emplace_back(IU{IR::Pointer::build(IR::Char::build())});
+      auto& target_iu = generated_ius.emplace_back(IR::SignedInt::build(8));
+      auto& op = pipe.attachSuboperator(AggReaderSubop::build(nullptr, ptr_iu, target_iu, *compute));
+      name = op.id();
+   }
+
+   // Fragmentize the exact median.
+   {
+      auto& [name, pipe] = pipes.emplace_back();
+      auto& compute = agg_computes.emplace_back(std::make_unique<AggComputeMedian>());
+      auto& ptr_iu = generated_ius.emplace_back(IU{IR::Pointer::build(IR::Char::build())});
+      auto& target_iu = generated_ius.emplace_back(IR::Float::build(8));
+      auto& op = pipe.attachSuboperator(AggReaderSubop::build(nullptr, ptr_iu, target_iu, *compute));
+      name = op.id();
+   }
+
+   // Fragmentize the t-digest quantile estimate for every whole percentile.
+   for (uint8_t percentile = 0; percentile <= 100; ++percentile) {
+      auto& [name, pipe] = pipes.emplace_back();
+      auto& compute = agg_computes.emplace_back(std::make_unique<AggComputeTDigest>(percentile));
+      auto& ptr_iu = generated_ius.emplace_back(IU{IR::Pointer::build(IR::Char::build())});
+      auto& target_iu = generated_ius.emplace_back(IR::Float::build(8));
+      auto& op = pipe.attachSuboperator(AggReaderSubop::build(nullptr, ptr_iu, target_iu, *compute));
+      name = op.id();
+   }
+
    // Fragmentize average unpacking over all numeric types.
    for (const auto& type : TypeDecorator{}.attachNumeric().produce()) {
       auto& [name, pipe] = pipes.emplace_back();
       auto& compute = agg_computes.emplace_back(std::make_unique<AggComputeAvg>(type));
       auto& ptr_iu = generated_ius.emplace_back(IU{IR::Pointer::build(IR::Char::build())});
-      auto& target_iu = generated_ius.emplace_back(IR::Float::build(8));
+      // Decimal averages are decimals themselves.
+      auto target_type = dynamic_cast<IR::Decimal*>(type.get()) ? type : IR::Float::build(8);
+      auto& target_iu = generated_ius.emplace_back(target_type);
       auto& op = pipe.attachSuboperator(AggReaderSubop::build(nullptr, ptr_iu, target_iu, *compute));
       name = op.id();
    }
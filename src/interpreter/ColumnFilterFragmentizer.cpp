@@ -29,6 +29,19 @@ ColumnFilterFragmentizer::ColumnFilterFragmentizer() {
          name = filter_subop.id();
       }
    }
+   // Branch-free filters on boolean conditions.
+   for (auto& type : types) {
+      auto& [name, pipe] = pipes.emplace_back();
+      const auto& filter_iu = generated_ius.emplace_back(IR::Bool::build(), "filter");
+      const auto& pseudo_iu = generated_ius.emplace_back(IR::Void::build(), "");
+      const auto& target_iu = generated_ius.emplace_back(type, "target_iu");
+      const auto& target_iu_out = generated_ius.emplace_back(type, "target_iu_filtered");
+      auto& filter_scope_subop = pipe.attachSuboperator(ColumnFilterScope::build(nullptr, filter_iu, pseudo_iu, true));
+      auto& filter_scope = reinterpret_cast<ColumnFilterScope&>(filter_scope_subop);
+      auto& filter_subop = pipe.attachSuboperator(ColumnFilterLogic::build(nullptr, pseudo_iu, target_iu, target_iu_out, IR::Bool::build(), false, true));
+      filter_scope.attachFilterLogicDependency(filter_subop, target_iu);
+      name = filter_subop.id();
+   }
    // Self filtering.
    for (auto& condition_type : condition_types) {
       auto& [name, pipe] = pipes.emplace_back();
@@ -58,6 +71,17 @@ ColumnFilterFragmentizer::ColumnFilterFragmentizer() {
          filter_scope.attachFilterLogicDependency(filter_subop, target_iu);
          name = filter_subop.id();
       }
+      // And its branch-free variant.
+      auto& [name, pipe] = pipes.emplace_back();
+      const auto& filter_iu = generated_ius.emplace_back(IR::Bool::build(), "filter");
+      const auto& pseudo_iu = generated_ius.emplace_back(IR::Void::build(), "");
+      const auto& target_iu = generated_ius.emplace_back(IR::ByteArray::build(0), "target_iu");
+      const auto& target_iu_out = generated_ius.emplace_back(IR::Pointer::build(IR::Char::build()), "target_iu_filtered");
+      auto& filter_scope_subop = pipe.attachSuboperator(ColumnFilterScope::build(nullptr, filter_iu, pseudo_iu, true));
+      auto& filter_scope = reinterpret_cast<ColumnFilterScope&>(filter_scope_subop);
+      auto& filter_subop = pipe.attachSuboperator(ColumnFilterLogic::build(nullptr, pseudo_iu, target_iu, target_iu_out, IR::Bool::build(), false, true));
+      filter_scope.attachFilterLogicDependency(filter_subop, target_iu);
+      name = filter_subop.id();
    }
 }
 
@@ -46,6 +46,10 @@ void ExpressionFragmentizer::fragmentizeBinary()
 {
    // All binary operations on the same type.
    for (auto& type : types) {
+      if (dynamic_cast<IR::Decimal*>(type.get())) {
+         // The result width of decimals depends on the precision, see fragmentizeDecimals.
+         continue;
+      }
       for (auto operation: op_types) {
          auto& [name, pipe] = pipes.emplace_back();
          auto& iu_1 = generated_ius.emplace_back(type, "");
@@ -57,6 +61,38 @@ void ExpressionFragmentizer::fragmentizeBinary()
    }
 }
 
+void ExpressionFragmentizer::fragmentizeDecimals()
+{
+   // Arithmetic on 8 byte decimals can produce 8 or 16 byte decimals depending on the
+   // precision, and the operands can have different widths. The narrow operands are widened.
+   const auto dec_8 = IR::Decimal::build(IR::Decimal::MAX_PRECISION_8_BYTES, 0);
+   const auto dec_16 = IR::Decimal::build(IR::Decimal::MAX_PRECISION, 0);
+   for (const auto& type_1 : {dec_8, dec_16}) {
+      for (const auto& type_2 : {dec_8, dec_16}) {
+         for (auto operation: op_types) {
+            if (operation == Type::And || operation == Type::Or) {
+               continue;
+            }
+            const bool comparison = operation != Type::Add && operation != Type::Subtract && operation != Type::Multiply && operation != Type::Divide;
+            std::vector<IR::TypeArc> out_types{dec_16};
+            if (comparison) {
+               out_types = {IR::Bool::build()};
+            } else if (type_1 == dec_8 && type_2 == dec_8) {
+               out_types = {dec_8, dec_16};
+            }
+            for (const auto& out_type : out_types) {
+               auto& [name, pipe] = pipes.emplace_back();
+               auto& iu_1 = generated_ius.emplace_back(type_1, "");
+               auto& iu_2 = generated_ius.emplace_back(type_2, "");
+               auto& iu_out = generated_ius.emplace_back(out_type, "");
+               auto& op = pipe.attachSuboperator(ExpressionSubop::build(nullptr, {&iu_out}, {&iu_1, &iu_2}, operation));
+               name = op.id();
+            }
+         }
+      }
+   }
+}
+
 void ExpressionFragmentizer::fragmentizeFunctions()
 {
    {
@@ -75,6 +111,7 @@ ExpressionFragmentizer::ExpressionFragmentizer()
 {
    fragmentizeBinary();
    fragmentizeCasts();
+   fragmentizeDecimals();
    fragmentizeFunctions();
 }
 
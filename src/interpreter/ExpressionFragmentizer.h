@@ -14,6 +14,8 @@ struct ExpressionFragmentizer: public Fragmentizer {
    void fragmentizeCasts();
    /// Fragmentize all binary expressions.
    void fragmentizeBinary();
+   /// Fragmentize binary expressions on decimals.
+   void fragmentizeDecimals();
    /// Fragmentize more complex functions such as strcmp.
    void fragmentizeFunctions();
 
@@ -11,6 +11,7 @@
 #include "interpreter/RuntimeFunctionSubopFragmentizer.h"
 #include "interpreter/RuntimeKeyExpressionFragmentizer.h"
 #include "interpreter/TScanFragmentizer.h"
+#include "interpreter/TopKThresholdFragmentizer.h"
 
 namespace inkfuse {
 
@@ -56,6 +57,10 @@ TypeDecorator& TypeDecorator::attachNumeric() {
    // We also count dates as numeric types. This is because a date internally
    // is represented as a 4 byte signed integer (day offset to the epoch).
    types.push_back(IR::Date::build());
+   // Decimals are scaled integers, their fragments only depend on the width
+   // and not on precision and scale. One representative per width suffices.
+   types.push_back(IR::Decimal::build(IR::Decimal::MAX_PRECISION_8_BYTES, 0));
+   types.push_back(IR::Decimal::build(IR::Decimal::MAX_PRECISION, 0));
    return *this;
 }
 
@@ -100,6 +105,7 @@ IR::ProgramArc FragmentGenerator::build() {
    fragmentizers.push_back(std::make_unique<CountingSinkFragmentizer>());
    fragmentizers.push_back(std::make_unique<ColumnFilterFragmentizer>());
    fragmentizers.push_back(std::make_unique<RuntimeFunctionSubopFragmentizer>());
+   fragmentizers.push_back(std::make_unique<TopKThresholdFragmentizer>());
 
    // Create the IR program.
    auto program = std::make_shared<IR::Program>("fragments", false);
@@ -1,4 +1,5 @@
 #include "interpreter/KeyPackingFragmentizer.h"
+#include "algebra/suboperators/row_layout/KeyNormalizerSubop.h"
 #include "algebra/suboperators/row_layout/KeyPackerSubop.h"
 #include "algebra/suboperators/row_layout/KeyUnpackerSubop.h"
 
@@ -10,6 +11,8 @@ const std::vector<IR::TypeArc> types =
    TypeDecorator()
       .attachTypes()
       .attachStringType()
+      // Late materialized joins unpack the build row reference from the hash table slot.
+      .attachCharPtr()
       .produce();
 
 // We can pack/unpack into raw char* or explicit byte arrays. Size 1 is a placeholder, does not affect the generated code.
@@ -38,6 +41,19 @@ KeyPackingFragmentizer::KeyPackingFragmentizer() {
          name_unpacker = op_unpacker.id();
       }
    }
+   for (auto& type : types) {
+      if (dynamic_cast<IR::Pointer*>(type.get())) {
+         // Row references are never nullable keys.
+         continue;
+      }
+      // Set up key normalizer suboperator fragments.
+      auto& [name_normalizer, pipe_normalizer] = pipes.emplace_back();
+      const auto& key_in = generated_ius.emplace_back(type, "iu_in");
+      const auto& null_in = generated_ius.emplace_back(IR::Bool::build(), "null_in");
+      const auto& key_out = generated_ius.emplace_back(type, "iu_out");
+      const auto& op_normalizer = pipe_normalizer.attachSuboperator(KeyNormalizerSubop::build(nullptr, key_in, null_in, key_out));
+      name_normalizer = op_normalizer.id();
+   }
 }
 
 }
\ No newline at end of file
@@ -12,6 +12,12 @@ const std::vector<IR::TypeArc> types =
       .attachNumeric()
       .produce();
 
+const std::vector<IR::TypeArc> constant_types =
+   TypeDecorator()
+      .attachTypes()
+      .attachStringType()
+      .produce();
+
 const std::vector<Type> op_types {
    Type::Add,
    Type::Subtract,
@@ -30,6 +36,10 @@ RuntimeExpressionFragmentizer::RuntimeExpressionFragmentizer()
 {
    // All binary operations on the same type.
    for (auto& type : types) {
+      if (dynamic_cast<IR::Decimal*>(type.get())) {
+         // The result width of decimals depends on the precision, see below.
+         continue;
+      }
       for (auto operation: op_types) {
          auto& [name, pipe] = pipes.emplace_back();
          auto& iu_1 = generated_ius.emplace_back(type, "");
@@ -37,16 +47,60 @@ RuntimeExpressionFragmentizer::RuntimeExpressionFragmentizer()
          auto& op = pipe.attachSuboperator(RuntimeExpressionSubop::build(nullptr, {&iu_out}, {&iu_1}, operation, type));
          name = op.id();
       }
-      // Null map generator.
-      {
+   }
+   // Rescaling decimals multiplies and divides them by runtime powers of ten.
+   // Arithmetic on 8 byte decimals can produce 8 or 16 byte decimals depending on the
+   // precision, and the constant and the column can have different widths.
+   {
+      const auto dec_8 = IR::Decimal::build(IR::Decimal::MAX_PRECISION_8_BYTES, 0);
+      const auto dec_16 = IR::Decimal::build(IR::Decimal::MAX_PRECISION, 0);
+      for (const auto& type : {dec_8, dec_16}) {
+         for (const auto& type_runtime_param : {dec_8, dec_16}) {
+            for (auto operation : op_types) {
+               const bool comparison = operation != Type::Add && operation != Type::Subtract && operation != Type::Multiply && operation != Type::Divide;
+               std::vector<IR::TypeArc> out_types{dec_16};
+               if (comparison) {
+                  out_types = {IR::Bool::build()};
+               } else if (type == dec_8 && type_runtime_param == dec_8) {
+                  out_types = {dec_8, dec_16};
+               }
+               for (const auto& out_type : out_types) {
+                  auto& [name, pipe] = pipes.emplace_back();
+                  auto& iu_1 = generated_ius.emplace_back(type, "");
+                  auto& iu_out = generated_ius.emplace_back(out_type, "");
+                  auto& op = pipe.attachSuboperator(RuntimeExpressionSubop::build(nullptr, {&iu_out}, {&iu_1}, operation, type_runtime_param));
+                  name = op.id();
+               }
+            }
+         }
+      }
+      // Constant divisors with the type of the rescaled value.
+      for (const auto& type : {dec_8, dec_16, IR::Float::build(8)}) {
+         auto& [name, pipe] = pipes.emplace_back();
+         auto& iu_1 = generated_ius.emplace_back(type, "");
+         auto& iu_out = generated_ius.emplace_back(type, "");
+         auto& op = pipe.attachSuboperator(RuntimeExpressionSubop::build(nullptr, {&iu_out}, {&iu_1}, Type::Constant, type));
+         name = op.id();
+      }
+      // Scaled constant dividends can have a different width than the divisor column.
+      for (const auto& type : {dec_8, dec_16}) {
+         const auto& other = type == dec_8 ? dec_16 : dec_8;
          auto& [name, pipe] = pipes.emplace_back();
          auto& iu_1 = generated_ius.emplace_back(type, "");
-         auto null_target_type = IR::UnsignedInt::build(1);
-         auto& iu_out = generated_ius.emplace_back(null_target_type);
-         auto& op = pipe.attachSuboperator(RuntimeExpressionSubop::build(nullptr, {&iu_out}, {&iu_1}, Type::Constant, null_target_type));
+         auto& iu_out = generated_ius.emplace_back(other, "");
+         auto& op = pipe.attachSuboperator(RuntimeExpressionSubop::build(nullptr, {&iu_out}, {&iu_1}, Type::Constant, other));
          name = op.id();
       }
    }
+   // Null map generator. Also used for IS NULL on columns that can never be NULL.
+   for (auto& type : constant_types) {
+      auto& [name, pipe] = pipes.emplace_back();
+      auto& iu_1 = generated_ius.emplace_back(type, "");
+      auto null_target_type = IR::UnsignedInt::build(1);
+      auto& iu_out = generated_ius.emplace_back(null_target_type);
+      auto& op = pipe.attachSuboperator(RuntimeExpressionSubop::build(nullptr, {&iu_out}, {&iu_1}, Type::Constant, null_target_type));
+      name = op.id();
+   }
    {
       // strcmp
       auto type = IR::String::build();
@@ -76,6 +130,16 @@ RuntimeExpressionFragmentizer::RuntimeExpressionFragmentizer()
       auto& op = pipe.attachSuboperator(RuntimeExpressionSubop::build(nullptr, {&iu_out}, {&iu_1}, Type::NotLikeTokens, type_runtime_param));
       name = op.id();
    }
+   {
+      // like on a compiled pattern
+      auto type_runtime_param = IR::Pointer::build(IR::Char::build());
+      auto type = IR::String::build();
+      auto& [name, pipe] = pipes.emplace_back();
+      auto& iu_1 = generated_ius.emplace_back(type, "");
+      auto& iu_out = generated_ius.emplace_back(ExpressionOp::derive(Type::Like, {type}), "");
+      auto& op = pipe.attachSuboperator(RuntimeExpressionSubop::build(nullptr, {&iu_out}, {&iu_1}, Type::Like, type_runtime_param));
+      name = op.id();
+   }
 }
 
 }
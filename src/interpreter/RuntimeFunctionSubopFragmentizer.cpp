@@ -63,6 +63,14 @@ RuntimeFunctionSubopFragmentizer::RuntimeFunctionSubopFragmentizer() {
          const auto& op = pipe.attachSuboperator(RuntimeFunctionSubop::htHashAndPrefetch<AtomicHashTable<SimpleKeyComparator>>(nullptr, hash, key, {}, /* key_width = */ 8));
          name = op.id();
       }
+      {
+         // Hash and prefetch on the thread-local aggregation tables:
+         auto& [name, pipe] = pipes.emplace_back();
+         const auto& key = generated_ius.emplace_back(in_type);
+         const auto& hash = generated_ius.emplace_back(IR::UnsignedInt::build(8));
+         const auto& op = pipe.attachSuboperator(RuntimeFunctionSubop::htHashAndPrefetch<HashTableSimpleKey>(nullptr, hash, key, {}, /* key_width = */ {}));
+         name = op.id();
+      }
       {
          // Lookup don't disable slot:
          auto& [name, pipe] = pipes.emplace_back();
@@ -81,6 +89,15 @@ RuntimeFunctionSubopFragmentizer::RuntimeFunctionSubopFragmentizer() {
          const auto& op = pipe.attachSuboperator(RuntimeFunctionSubop::htLookupWithHash<AtomicHashTable<SimpleKeyComparator>, true>(nullptr, result, key, hash, nullptr));
          name = op.id();
       }
+      {
+         // Lookup marking the slot for outer joins:
+         auto& [name, pipe] = pipes.emplace_back();
+         const auto& hash = generated_ius.emplace_back(IR::UnsignedInt::build(8));
+         const auto& key = generated_ius.emplace_back(in_type);
+         const auto& result = generated_ius.emplace_back(IR::Pointer::build(IR::Char::build()));
+         const auto& op = pipe.attachSuboperator(RuntimeFunctionSubop::htLookupWithHash<AtomicHashTable<SimpleKeyComparator>, false, true>(nullptr, result, key, hash, nullptr));
+         name = op.id();
+      }
 
       for (const auto& out_type : out_types) {
          // Fragmentize hash table insert.
@@ -119,6 +136,17 @@ RuntimeFunctionSubopFragmentizer::RuntimeFunctionSubopFragmentizer() {
             const auto& op = pipe.attachSuboperator(RuntimeFunctionSubop::htLookupOrInsert<HashTableDirectLookup>(nullptr, out_iu, key, {}));
             name = op.id();
          }
+         {
+            auto& [name, pipe] = pipes.emplace_back();
+            const auto& key = generated_ius.emplace_back(in_type);
+            const auto& hash = generated_ius.emplace_back(IR::UnsignedInt::build(8));
+            const IU* out_iu = nullptr;
+            if (out_type) {
+               out_iu = &generated_ius.emplace_back(out_type);
+            }
+            const auto& op = pipe.attachSuboperator(RuntimeFunctionSubop::htLookupOrInsertWithHash<HashTableSimpleKey>(nullptr, out_iu, key, hash));
+            name = op.id();
+         }
       }
    }
 
@@ -131,37 +159,84 @@ RuntimeFunctionSubopFragmentizer::RuntimeFunctionSubopFragmentizer() {
       name = op.id();
    }
 
-   // Fragmentize no-key hash table lookup/insert. Does not care about
-   // input types at all. The input IU just makes connecting the DAG easier.
-   // We still create a 1-byte input type as that's the only thing that really lets
-   // us guarantee that we don't try to access a fuse chunk out of bounds.
+   // Fragmentize Top-K inserts of packed rows.
    {
       auto& [name, pipe] = pipes.emplace_back();
-      const auto& input = generated_ius.emplace_back(IR::Char::build());
-      const auto& result_ptr = generated_ius.emplace_back(IR::Pointer::build(IR::Char::build()));
-      const auto& op = pipe.attachSuboperator(RuntimeFunctionSubop::htNoKeyLookup(nullptr, result_ptr, input, nullptr));
+      const auto& row = generated_ius.emplace_back(IR::ByteArray::build(0));
+      const auto& op = pipe.attachSuboperator(RuntimeFunctionSubop::topKInsert(nullptr, row, {}));
       name = op.id();
    }
 
-   // Fragmentize string insert on the complex hash table.
+   // Fragmentize the partial state lookup of group joins.
    {
       auto& [name, pipe] = pipes.emplace_back();
-      const auto& key = generated_ius.emplace_back(IR::String::build());
-      const auto& result_ptr = generated_ius.emplace_back(IR::Pointer::build(IR::Char::build()));
-      // No pseudo-IU inputs, these only matter for more complex DAGs.
-      const auto& op = pipe.attachSuboperator(RuntimeFunctionSubop::htLookup<HashTableComplexKey>(nullptr, result_ptr, key, {}));
+      const auto& slot = generated_ius.emplace_back(IR::Pointer::build(IR::Char::build()));
+      const auto& state = generated_ius.emplace_back(IR::Pointer::build(IR::Char::build()));
+      const auto& op = pipe.attachSuboperator(RuntimeFunctionSubop::gjPartialState(nullptr, state, slot));
       name = op.id();
    }
 
-   // Fragmentize hash table lookup that disables the slot (for left semi joins).
+   // Fragmentize no-key hash table lookup/insert. Does not care about
+   // input types at all. The input IU just makes connecting the DAG easier.
+   // We still create a 1-byte input type as that's the only thing that really lets
+   // us guarantee that we don't try to access a fuse chunk out of bounds.
    {
       auto& [name, pipe] = pipes.emplace_back();
-      const auto& key = generated_ius.emplace_back(IR::String::build());
+      const auto& input = generated_ius.emplace_back(IR::Char::build());
       const auto& result_ptr = generated_ius.emplace_back(IR::Pointer::build(IR::Char::build()));
-      // No pseudo-IU inputs, these only matter for more complex DAGs.
-      const auto& op = pipe.attachSuboperator(RuntimeFunctionSubop::htLookupOrInsert<HashTableComplexKey>(nullptr, &result_ptr, key, {}));
+      const auto& op = pipe.attachSuboperator(RuntimeFunctionSubop::htNoKeyLookup(nullptr, result_ptr, input, nullptr));
       name = op.id();
    }
+
+   // Complex hash table keys are either a single string, or a string packed with a simple key
+   // (e.g. the NULL indicator of a nullable string).
+   const auto complex_key_types = std::vector<IR::TypeArc>{IR::String::build(), IR::ByteArray::build(0)};
+   for (const auto& key_type : complex_key_types) {
+      // Fragmentize string insert on the complex hash table.
+      {
+         auto& [name, pipe] = pipes.emplace_back();
+         const auto& key = generated_ius.emplace_back(key_type);
+         const auto& result_ptr = generated_ius.emplace_back(IR::Pointer::build(IR::Char::build()));
+         // No pseudo-IU inputs, these only matter for more complex DAGs.
+         const auto& op = pipe.attachSuboperator(RuntimeFunctionSubop::htLookup<HashTableComplexKey>(nullptr, result_ptr, key, {}));
+         name = op.id();
+      }
+
+      // Fragmentize hash table lookup that disables the slot (for left semi joins).
+      {
+         auto& [name, pipe] = pipes.emplace_back();
+         const auto& key = generated_ius.emplace_back(key_type);
+         const auto& result_ptr = generated_ius.emplace_back(IR::Pointer::build(IR::Char::build()));
+         // No pseudo-IU inputs, these only matter for more complex DAGs.
+         const auto& op = pipe.attachSuboperator(RuntimeFunctionSubop::htLookupOrInsert<HashTableComplexKey>(nullptr, &result_ptr, key, {}));
+         name = op.id();
+      }
+
+      // Fragmentize string insert on the complex hash table without result (plain GROUP BY).
+      {
+         auto& [name, pipe] = pipes.emplace_back();
+         const auto& key = generated_ius.emplace_back(key_type);
+         const auto& op = pipe.attachSuboperator(RuntimeFunctionSubop::htLookupOrInsert<HashTableComplexKey>(nullptr, nullptr, key, {}));
+         name = op.id();
+      }
+
+      // Fragmentize hashing and the lookup or insert with the precomputed hash, with and without result.
+      {
+         auto& [name, pipe] = pipes.emplace_back();
+         const auto& key = generated_ius.emplace_back(key_type);
+         const auto& hash = generated_ius.emplace_back(IR::UnsignedInt::build(8));
+         const auto& op = pipe.attachSuboperator(RuntimeFunctionSubop::htHashAndPrefetch<HashTableComplexKey>(nullptr, hash, key, {}, /* key_width = */ {}));
+         name = op.id();
+      }
+      for (bool with_result : {true, false}) {
+         auto& [name, pipe] = pipes.emplace_back();
+         const auto& key = generated_ius.emplace_back(key_type);
+         const auto& hash = generated_ius.emplace_back(IR::UnsignedInt::build(8));
+         const IU* out_iu = with_result ? &generated_ius.emplace_back(IR::Pointer::build(IR::Char::build())) : nullptr;
+         const auto& op = pipe.attachSuboperator(RuntimeFunctionSubop::htLookupOrInsertWithHash<HashTableComplexKey>(nullptr, out_iu, key, hash));
+         name = op.id();
+      }
+   }
 }
 
 }
@@ -10,6 +10,8 @@ const std::vector<IR::TypeArc> types =
    TypeDecorator()
       .attachTypes()
       .attachStringType()
+      // Sorts read the sorted row pointers through a table scan.
+      .attachCharPtr()
       .produce();
 }
 
@@ -24,6 +26,15 @@ TScanFragmetizer::TScanFragmetizer() {
       // The table scan is uniquely identified by the id of the provider.
       name = iu_op.id();
    }
+   {
+      // NULL indicators are scanned from the validity bitmaps of nullable columns.
+      auto& [name, pipe] = pipes.emplace_back();
+      auto& op = pipe.attachSuboperator(TScanDriver::build(nullptr));
+      const auto& driver_iu = **op.getIUs().begin();
+      auto& provider_iu = generated_ius.emplace_back(IR::Bool::build(), "");
+      auto& iu_op = pipe.attachSuboperator(TScanIUProvider::buildValidity(nullptr, driver_iu, provider_iu, {nullptr}));
+      name = iu_op.id();
+   }
 }
 
 }
\ No newline at end of file
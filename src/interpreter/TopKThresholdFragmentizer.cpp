@@ -0,0 +1,25 @@
+#include "interpreter/TopKThresholdFragmentizer.h"
+#include "algebra/suboperators/TopKThresholdSubop.h"
+
+namespace inkfuse {
+
+namespace {
+const std::vector<IR::TypeArc> types =
+   TypeDecorator()
+      .attachNumeric()
+      .produce();
+}
+
+TopKThresholdFragmentizer::TopKThresholdFragmentizer() {
+   for (const auto& type : types) {
+      for (bool ascending : {true, false}) {
+         auto& [name, pipe] = pipes.emplace_back();
+         const auto& key = generated_ius.emplace_back(type);
+         const auto& out = generated_ius.emplace_back(IR::Bool::build());
+         const auto& op = pipe.attachSuboperator(TopKThresholdSubop::build(nullptr, key, out, ascending));
+         name = op.id();
+      }
+   }
+}
+
+}
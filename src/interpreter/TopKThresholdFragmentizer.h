@@ -0,0 +1,14 @@
+#ifndef INKFUSE_TOPKTHRESHOLDFRAGMENTIZER_H
+#define INKFUSE_TOPKTHRESHOLDFRAGMENTIZER_H
+
+#include "interpreter/FragmentGenerator.h"
+
+namespace inkfuse {
+
+struct TopKThresholdFragmentizer : public Fragmentizer {
+   TopKThresholdFragmentizer();
+};
+
+}
+
+#endif //INKFUSE_TOPKTHRESHOLDFRAGMENTIZER_H
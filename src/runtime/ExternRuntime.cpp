@@ -1,7 +1,11 @@
 #include "runtime/ExternRuntime.h"
 #include "exec/ExecutionContext.h"
+#include "runtime/GroupJoinPartials.h"
 #include "runtime/HashTables.h"
+#include "runtime/HyperLogLog.h"
+#include "runtime/Quantiles.h"
 #include "runtime/NewHashTables.h"
+#include "runtime/TopK.h"
 #include "runtime/TupleMaterializer.h"
 #include "xxhash.h"
 
@@ -39,8 +43,16 @@ extern "C" void HashTableRuntime::ht_sk_lookup_or_insert_with_init(void* table,
    reinterpret_cast<HashTableSimpleKey*>(table)->lookupOrInsert(result, is_new_key, key);
 }
 
-extern "C" void HashTableRuntime::ht_sk_it_advance(void* table, char** it_data, uint64_t* it_idx) {
-   reinterpret_cast<HashTableSimpleKey*>(table)->iteratorAdvance(it_data, it_idx);
+extern "C" uint64_t HashTableRuntime::ht_sk_compute_hash_and_prefetch(void* table, char* key) {
+   return reinterpret_cast<HashTableSimpleKey*>(table)->computeHashAndPrefetch(key);
+}
+
+extern "C" char* HashTableRuntime::ht_sk_lookup_or_insert_with_hash(void* table, char* key, uint64_t hash) {
+   return reinterpret_cast<HashTableSimpleKey*>(table)->lookupOrInsert(key, hash);
+}
+
+extern "C" void HashTableRuntime::ht_sk_it_advance(void* table, char** it_data, uint64_t* it_idx, uint64_t it_end) {
+   reinterpret_cast<HashTableSimpleKey*>(table)->iteratorAdvance(it_data, it_idx, it_end);
 }
 
 extern "C" char* HashTableRuntime::ht_nk_lookup(void* table) {
@@ -55,8 +67,16 @@ extern "C" char* HashTableRuntime::ht_ck_lookup_or_insert(void* table, char* key
    return reinterpret_cast<HashTableComplexKey*>(table)->lookupOrInsert(key);
 }
 
-extern "C" void HashTableRuntime::ht_ck_it_advance(void* table, char** it_data, uint64_t* it_idx) {
-   reinterpret_cast<HashTableComplexKey*>(table)->iteratorAdvance(it_data, it_idx);
+extern "C" uint64_t HashTableRuntime::ht_ck_compute_hash_and_prefetch(void* table, char* key) {
+   return reinterpret_cast<HashTableComplexKey*>(table)->computeHashAndPrefetch(key);
+}
+
+extern "C" char* HashTableRuntime::ht_ck_lookup_or_insert_with_hash(void* table, char* key, uint64_t hash) {
+   return reinterpret_cast<HashTableComplexKey*>(table)->lookupOrInsert(key, hash);
+}
+
+extern "C" void HashTableRuntime::ht_ck_it_advance(void* table, char** it_data, uint64_t* it_idx, uint64_t it_end) {
+   reinterpret_cast<HashTableComplexKey*>(table)->iteratorAdvance(it_data, it_idx, it_end);
 }
 
 extern "C" char* HashTableRuntime::ht_dl_lookup(void* table, char* key) {
@@ -67,8 +87,8 @@ extern "C" char* HashTableRuntime::ht_dl_lookup_or_insert(void* table, char* key
    return reinterpret_cast<HashTableDirectLookup*>(table)->lookupOrInsert(key);
 }
 
-extern "C" void HashTableRuntime::ht_dl_it_advance(void* table, char** it_data, uint64_t* it_idx) {
-   reinterpret_cast<HashTableDirectLookup*>(table)->iteratorAdvance(it_data, it_idx);
+extern "C" void HashTableRuntime::ht_dl_it_advance(void* table, char** it_data, uint64_t* it_idx, uint64_t it_end) {
+   reinterpret_cast<HashTableDirectLookup*>(table)->iteratorAdvance(it_data, it_idx, it_end);
 }
 
 // Atomic hash table.
@@ -80,8 +100,8 @@ extern "C" uint64_t HashTableRuntime::ht_at_sk_compute_hash_and_prefetch_fixed_4
    return reinterpret_cast<AtomicHashTable<SimpleKeyComparator>*>(table)->compute_hash_and_prefetch_fixed<4>(key);
 }
 
-extern "C" void HashTableRuntime::ht_at_sk_it_advance(void* table, char** it_data, uint64_t* it_idx) {
-   reinterpret_cast<AtomicHashTable<SimpleKeyComparator>*>(table)->iteratorAdvance(it_data, it_idx);
+extern "C" void HashTableRuntime::ht_at_sk_it_advance(void* table, char** it_data, uint64_t* it_idx, uint64_t it_end) {
+   reinterpret_cast<AtomicHashTable<SimpleKeyComparator>*>(table)->iteratorAdvance(it_data, it_idx, it_end);
 }
 
 extern "C" uint64_t HashTableRuntime::ht_at_sk_compute_hash_and_prefetch_fixed_8(void* table, char* key) {
@@ -100,6 +120,10 @@ extern "C" char* HashTableRuntime::ht_at_sk_lookup_with_hash_disable(void* table
    return reinterpret_cast<AtomicHashTable<SimpleKeyComparator>*>(table)->lookupDisable(key, hash);
 }
 
+extern "C" char* HashTableRuntime::ht_at_sk_lookup_with_hash_outer(void* table, char* key, uint64_t hash) {
+   return reinterpret_cast<AtomicHashTable<SimpleKeyComparator>*>(table)->lookupOuter(key, hash);
+}
+
 extern "C" uint64_t HashTableRuntime::ht_at_ck_compute_hash_and_prefetch(void* table, char* key) {
    return reinterpret_cast<AtomicHashTable<ComplexKeyComparator>*>(table)->compute_hash_and_prefetch(key);
 }
@@ -132,9 +156,54 @@ extern "C" char* TupleMaterializerRuntime::materialize_tuple(void* materializer)
    return reinterpret_cast<TupleMaterializer*>(materializer)->materialize();
 }
 
+extern "C" void HyperLogLogRuntime::hll_add_bits(char* registers, uint64_t bits) {
+   HyperLogLog::add(reinterpret_cast<uint8_t*>(registers), HyperLogLog::hashBits(bits));
+}
+
+extern "C" void HyperLogLogRuntime::hll_add_str(char* registers, char* str) {
+   HyperLogLog::add(reinterpret_cast<uint8_t*>(registers), HyperLogLog::hashString(str));
+}
+
+extern "C" int64_t HyperLogLogRuntime::hll_estimate(char* registers) {
+   return HyperLogLog::estimate(reinterpret_cast<const uint8_t*>(registers));
+}
+
+extern "C" void QuantileRuntime::median_add(char* state, double val) {
+   ExactQuantile::add(state, val);
+}
+
+extern "C" double QuantileRuntime::median_compute(char* state) {
+   return ExactQuantile::median(state);
+}
+
+extern "C" void QuantileRuntime::tdigest_add(char* digest, double val) {
+   TDigest::add(digest, val);
+}
+
+extern "C" double QuantileRuntime::tdigest_quantile(char* digest, double q) {
+   return TDigest::quantile(digest, q);
+}
+
+extern "C" void TopKRuntime::topk_insert(void* heap, char* row) {
+   reinterpret_cast<TopKHeap*>(heap)->insert(row);
+}
+
+extern "C" char* GroupJoinRuntime::gj_partial_state(void* partials, char* slot) {
+   return reinterpret_cast<GroupJoinPartials*>(partials)->lookup(slot);
+}
+
 extern "C" void* MemoryRuntime::inkfuse_malloc(uint64_t size) {
    auto& context = ExecutionContext::getInstalledMemoryContext();
    return context.alloc(size);
 }
 
+extern "C" void MemoryRuntime::inkfuse_overflow() {
+   ExecutionContext::getInstalledOverflowFlag() = true;
+}
+
+extern "C" char* MemoryRuntime::inkfuse_empty_string() {
+   static char empty[] = "";
+   return empty;
+}
+
 } // namespace infkuse
@@ -19,22 +19,26 @@ extern "C" char* ht_sk_lookup(void* table, char* key);
 extern "C" char* ht_sk_lookup_disable(void* table, char* key);
 extern "C" char* ht_sk_lookup_or_insert(void* table, char* key);
 extern "C" void ht_sk_lookup_or_insert_with_init(void* table, char** result, bool* is_new_key, char* key);
-extern "C" void ht_sk_it_advance(void* table, char** it_data, uint64_t* it_idx);
+extern "C" uint64_t ht_sk_compute_hash_and_prefetch(void* table, char* key);
+extern "C" char* ht_sk_lookup_or_insert_with_hash(void* table, char* key, uint64_t hash);
+extern "C" void ht_sk_it_advance(void* table, char** it_data, uint64_t* it_idx, uint64_t it_end);
 
 extern "C" char* ht_ck_lookup(void* table, char* key);
 extern "C" char* ht_ck_lookup_or_insert(void* table, char* key);
-extern "C" void ht_ck_it_advance(void* table, char** it_data, uint64_t* it_idx);
+extern "C" uint64_t ht_ck_compute_hash_and_prefetch(void* table, char* key);
+extern "C" char* ht_ck_lookup_or_insert_with_hash(void* table, char* key, uint64_t hash);
+extern "C" void ht_ck_it_advance(void* table, char** it_data, uint64_t* it_idx, uint64_t it_end);
 
 extern "C" char* ht_dl_lookup(void* table, char* key);
 extern "C" char* ht_dl_lookup_or_insert(void* table, char* key);
-extern "C" void ht_dl_it_advance(void* table, char** it_data, uint64_t* it_idx);
+extern "C" void ht_dl_it_advance(void* table, char** it_data, uint64_t* it_idx, uint64_t it_end);
 
 /// Atomic hash-table lookup. No insert needed as that's done by the runtime system.
 extern "C" char* ht_at_sk_lookup(void* table, char* key);
 extern "C" char* ht_at_sk_lookup_disable(void* table, char* key);
 extern "C" char* ht_at_ck_lookup(void* table, char* key);
 
-extern "C" void ht_at_sk_it_advance(void* table, char** it_data, uint64_t* it_idx);
+extern "C" void ht_at_sk_it_advance(void* table, char** it_data, uint64_t* it_idx, uint64_t it_end);
 
 /// Hash/prefetch instructions, fixed width specializations exist.
 extern "C" uint64_t ht_at_sk_compute_hash_and_prefetch(void* table, char* key);
@@ -44,6 +48,7 @@ extern "C" uint64_t ht_at_sk_compute_hash_and_prefetch_fixed_8(void* table, char
 extern "C" void ht_at_sk_slot_prefetch(void* table, uint64_t hash);
 extern "C" char* ht_at_sk_lookup_with_hash(void* table, char* key, uint64_t hash);
 extern "C" char* ht_at_sk_lookup_with_hash_disable(void* table, char* key, uint64_t hash);
+extern "C" char* ht_at_sk_lookup_with_hash_outer(void* table, char* key, uint64_t hash);
 
 extern "C" uint64_t ht_at_ck_compute_hash_and_prefetch(void* table, char* key);
 extern "C" void ht_at_ck_slot_prefetch(void* table, uint64_t hash);
@@ -60,8 +65,46 @@ extern "C" char* materialize_tuple(void* materializer);
 
 }
 
+namespace HyperLogLogRuntime {
+/// Add the bit pattern of a fixed-width value to a HyperLogLog sketch.
+extern "C" void hll_add_bits(char* registers, uint64_t bits);
+/// Add a string to a HyperLogLog sketch.
+extern "C" void hll_add_str(char* registers, char* str);
+/// Estimate the distinct count of a HyperLogLog sketch.
+extern "C" int64_t hll_estimate(char* registers);
+}
+
+namespace QuantileRuntime {
+/// Add a value to the value list of an exact median.
+extern "C" void median_add(char* state, double val);
+/// Compute the exact median of a value list.
+extern "C" double median_compute(char* state);
+/// Add a value to a t-digest.
+extern "C" void tdigest_add(char* digest, double val);
+/// Estimate a quantile from a t-digest.
+extern "C" double tdigest_quantile(char* digest, double q);
+}
+
+namespace TopKRuntime {
+
+/// Insert a packed row into a thread-local TopKHeap.
+extern "C" void topk_insert(void* heap, char* row);
+
+}
+
+namespace GroupJoinRuntime {
+
+/// Get the thread-local partial aggregate state of a group join hash table slot.
+extern "C" char* gj_partial_state(void* partials, char* slot);
+
+}
+
 namespace MemoryRuntime {
 extern "C" void* inkfuse_malloc(uint64_t size);
+/// Flag an overflow of checked decimal arithmetic in the generated code.
+extern "C" void inkfuse_overflow();
+/// The empty string. Owned by the runtime, so that keys pointing to it outlive the generated code.
+extern "C" char* inkfuse_empty_string();
 } // namespace MemroyRuntime
 
 } // namespace inkfuse
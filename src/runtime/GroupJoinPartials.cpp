@@ -0,0 +1,17 @@
+#include "runtime/GroupJoinPartials.h"
+#include <new>
+
+namespace inkfuse {
+
+void GroupJoinPartials::allocate(const char* slots_, uint16_t slot_size_, uint16_t state_size_, uint64_t num_slots) {
+   slots = slots_;
+   slot_size = slot_size_;
+   // Keep the partial states eight byte aligned.
+   state_size = (state_size_ + 7) & ~7u;
+   states.reset(static_cast<char*>(std::calloc(num_slots, state_size)));
+   if (!states && num_slots * state_size != 0) {
+      throw std::bad_alloc();
+   }
+}
+
+}
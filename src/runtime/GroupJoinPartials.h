@@ -0,0 +1,46 @@
+#ifndef INKFUSE_GROUPJOINPARTIALS_H
+#define INKFUSE_GROUPJOINPARTIALS_H
+
+#include <cstdint>
+#include <cstdlib>
+#include <memory>
+
+namespace inkfuse {
+
+/// Thread-local partial aggregate states of a group join. Every slot of the group join hash table
+/// has a zero-initialized partial state at the same index. Probe-side rows update the partial state
+/// of the slot they matched, which needs neither atomics nor a second hash table lookup.
+/// The partial states of all threads get merged into the hash table slots once the probe side is done.
+struct GroupJoinPartials {
+   /// Allocate zeroed partial states for every slot of the hash table starting at `slots_`.
+   void allocate(const char* slots_, uint16_t slot_size_, uint16_t state_size_, uint64_t num_slots);
+
+   /// Get the partial state belonging to the given hash table slot.
+   char* lookup(const char* slot) const {
+      return states.get() + static_cast<uint64_t>(slot - slots) / slot_size * state_size;
+   }
+
+   /// Get the partial state of the slot at the given index.
+   char* at(uint64_t idx) const {
+      return states.get() + idx * state_size;
+   }
+
+   private:
+   /// Memory gets allocated through calloc, untouched partial states don't cost physical memory.
+   struct FreeDeleter {
+      void operator()(char* ptr) const { std::free(ptr); }
+   };
+
+   /// The first slot of the hash table.
+   const char* slots = nullptr;
+   /// Size of a hash table slot.
+   uint16_t slot_size = 1;
+   /// Size of a partial state, aligned to eight bytes.
+   uint16_t state_size = 0;
+   /// The partial states.
+   std::unique_ptr<char, FreeDeleter> states;
+};
+
+}
+
+#endif //INKFUSE_GROUPJOINPARTIALS_H
@@ -28,10 +28,20 @@ void HashTableRuntime::registerRuntime() {
       .addArg("is_new_key", IR::Pointer::build(IR::Bool::build()))
       .addArg("key", IR::Pointer::build(IR::Char::build()), true);
 
+   RuntimeFunctionBuilder("ht_sk_compute_hash_and_prefetch", IR::UnsignedInt::build(8))
+      .addArg("table", IR::Pointer::build(IR::Void::build()))
+      .addArg("key", IR::Pointer::build(IR::Char::build()), true);
+
+   RuntimeFunctionBuilder("ht_sk_lookup_or_insert_with_hash", IR::Pointer::build(IR::Char::build()))
+      .addArg("table", IR::Pointer::build(IR::Void::build()))
+      .addArg("key", IR::Pointer::build(IR::Char::build()))
+      .addArg("hash", IR::UnsignedInt::build(8), true);
+
    RuntimeFunctionBuilder("ht_sk_it_advance", IR::Pointer::build(IR::Char::build()))
       .addArg("table", IR::Pointer::build(IR::Void::build()), true)
       .addArg("it_data", IR::Pointer::build(IR::Pointer::build(IR::Char::build())))
-      .addArg("it_idx", IR::Pointer::build(IR::UnsignedInt::build(8)));
+      .addArg("it_idx", IR::Pointer::build(IR::UnsignedInt::build(8)))
+      .addArg("it_end", IR::UnsignedInt::build(8), true);
 
    RuntimeFunctionBuilder("ht_nk_lookup", IR::Pointer::build(IR::Char::build()))
       .addArg("table", IR::Pointer::build(IR::Void::build()), true);
@@ -44,10 +54,20 @@ void HashTableRuntime::registerRuntime() {
       .addArg("table", IR::Pointer::build(IR::Void::build()))
       .addArg("key", IR::Pointer::build(IR::Char::build()), true);
 
+   RuntimeFunctionBuilder("ht_ck_compute_hash_and_prefetch", IR::UnsignedInt::build(8))
+      .addArg("table", IR::Pointer::build(IR::Void::build()))
+      .addArg("key", IR::Pointer::build(IR::Char::build()), true);
+
+   RuntimeFunctionBuilder("ht_ck_lookup_or_insert_with_hash", IR::Pointer::build(IR::Char::build()))
+      .addArg("table", IR::Pointer::build(IR::Void::build()))
+      .addArg("key", IR::Pointer::build(IR::Char::build()))
+      .addArg("hash", IR::UnsignedInt::build(8), true);
+
    RuntimeFunctionBuilder("ht_ck_it_advance", IR::Pointer::build(IR::Char::build()))
       .addArg("table", IR::Pointer::build(IR::Void::build()), true)
       .addArg("it_data", IR::Pointer::build(IR::Pointer::build(IR::Char::build())))
-      .addArg("it_idx", IR::Pointer::build(IR::UnsignedInt::build(8)));
+      .addArg("it_idx", IR::Pointer::build(IR::UnsignedInt::build(8)))
+      .addArg("it_end", IR::UnsignedInt::build(8), true);
 
    RuntimeFunctionBuilder("ht_dl_lookup", IR::Pointer::build(IR::Char::build()))
       .addArg("table", IR::Pointer::build(IR::Void::build()), true)
@@ -60,7 +80,8 @@ void HashTableRuntime::registerRuntime() {
    RuntimeFunctionBuilder("ht_dl_it_advance", IR::Pointer::build(IR::Char::build()))
       .addArg("table", IR::Pointer::build(IR::Void::build()), true)
       .addArg("it_data", IR::Pointer::build(IR::Pointer::build(IR::Char::build())))
-      .addArg("it_idx", IR::Pointer::build(IR::UnsignedInt::build(8)));
+      .addArg("it_idx", IR::Pointer::build(IR::UnsignedInt::build(8)))
+      .addArg("it_end", IR::UnsignedInt::build(8), true);
 
    // Atomic hash table.
    RuntimeFunctionBuilder("ht_at_sk_lookup", IR::Pointer::build(IR::Char::build()))
@@ -101,10 +122,16 @@ void HashTableRuntime::registerRuntime() {
       .addArg("key", IR::Pointer::build(IR::Char::build()))
       .addArg("hash", IR::UnsignedInt::build(8), true);
 
+   RuntimeFunctionBuilder("ht_at_sk_lookup_with_hash_outer", IR::Pointer::build(IR::Char::build()))
+      .addArg("table", IR::Pointer::build(IR::Void::build()))
+      .addArg("key", IR::Pointer::build(IR::Char::build()))
+      .addArg("hash", IR::UnsignedInt::build(8), true);
+
    RuntimeFunctionBuilder("ht_at_sk_it_advance", IR::Pointer::build(IR::Char::build()))
       .addArg("table", IR::Pointer::build(IR::Void::build()), true)
       .addArg("it_data", IR::Pointer::build(IR::Pointer::build(IR::Char::build())))
-      .addArg("it_idx", IR::Pointer::build(IR::UnsignedInt::build(8)));
+      .addArg("it_idx", IR::Pointer::build(IR::UnsignedInt::build(8)))
+      .addArg("it_end", IR::UnsignedInt::build(8), true);
 
    RuntimeFunctionBuilder("ht_at_ck_compute_hash_and_prefetch", IR::UnsignedInt::build(8))
       .addArg("table", IR::Pointer::build(IR::Void::build()))
@@ -132,10 +159,57 @@ void registerRuntime() {
 }
 }
 
+namespace HyperLogLogRuntime {
+void registerRuntime() {
+   RuntimeFunctionBuilder("hll_add_bits", IR::Void::build())
+      .addArg("registers", IR::Pointer::build(IR::Char::build()))
+      .addArg("bits", IR::UnsignedInt::build(8));
+   RuntimeFunctionBuilder("hll_add_str", IR::Void::build())
+      .addArg("registers", IR::Pointer::build(IR::Char::build()))
+      .addArg("str", IR::String::build());
+   RuntimeFunctionBuilder("hll_estimate", IR::SignedInt::build(8))
+      .addArg("registers", IR::Pointer::build(IR::Char::build()));
+}
+}
+
+namespace QuantileRuntime {
+void registerRuntime() {
+   RuntimeFunctionBuilder("median_add", IR::Void::build())
+      .addArg("state", IR::Pointer::build(IR::Char::build()))
+      .addArg("val", IR::Float::build(8));
+   RuntimeFunctionBuilder("median_compute", IR::Float::build(8))
+      .addArg("state", IR::Pointer::build(IR::Char::build()));
+   RuntimeFunctionBuilder("tdigest_add", IR::Void::build())
+      .addArg("digest", IR::Pointer::build(IR::Char::build()))
+      .addArg("val", IR::Float::build(8));
+   RuntimeFunctionBuilder("tdigest_quantile", IR::Float::build(8))
+      .addArg("digest", IR::Pointer::build(IR::Char::build()))
+      .addArg("q", IR::Float::build(8));
+}
+}
+
+namespace TopKRuntime {
+void registerRuntime() {
+   RuntimeFunctionBuilder("topk_insert", IR::Void::build())
+      .addArg("heap", IR::Pointer::build(IR::Void::build()))
+      .addArg("row", IR::Pointer::build(IR::Char::build()), true);
+}
+}
+
+namespace GroupJoinRuntime {
+void registerRuntime() {
+   RuntimeFunctionBuilder("gj_partial_state", IR::Pointer::build(IR::Char::build()))
+      .addArg("partials", IR::Pointer::build(IR::Void::build()), true)
+      .addArg("slot", IR::Pointer::build(IR::Char::build()), true);
+}
+}
+
 namespace MemoryRuntime {
 void registerRuntime() {
    RuntimeFunctionBuilder("inkfuse_malloc", IR::Pointer::build(IR::Void::build()))
       .addArg("size", IR::UnsignedInt::build(8));
+   RuntimeFunctionBuilder("inkfuse_overflow", IR::Void::build());
+   RuntimeFunctionBuilder("inkfuse_empty_string", IR::String::build());
 }
 }
 
@@ -15,6 +15,22 @@ namespace TupleMaterializerRuntime {
 void registerRuntime();
 } // namespace TupleMaterializerRuntime
 
+namespace HyperLogLogRuntime {
+void registerRuntime();
+} // namespace HyperLogLogRuntime
+
+namespace QuantileRuntime {
+void registerRuntime();
+} // namespace QuantileRuntime
+
+namespace TopKRuntime {
+void registerRuntime();
+} // namespace TopKRuntime
+
+namespace GroupJoinRuntime {
+void registerRuntime();
+} // namespace GroupJoinRuntime
+
 namespace MemoryRuntime {
 void registerRuntime();
 } // namespace MemoryRuntime
@@ -14,6 +14,10 @@ const uint8_t tag_fill_mask = 1u << 7u;
 const uint8_t fingerprint_inversion_mask = tag_fill_mask - 1;
 /// Lower order 7 bits in the hash slot store salt of the hash.
 const uint8_t tag_hash_mask = tag_fill_mask - 1;
+/// Iterators visit all slots with the fill bit set.
+const TagScan::Matcher tag_matcher{.mask = tag_fill_mask, .value = tag_fill_mask};
+/// The direct lookup table stores its occupied flags as bools.
+const TagScan::Matcher direct_lookup_matcher{.mask = 1, .value = 1};
 }
 
 const std::string HashTableSimpleKey::ID = "sk";
@@ -47,6 +51,12 @@ void SharedHashTableState::advance(size_t& idx, char*& data_ptr, uint8_t*& tag_p
    }
 }
 
+void SharedHashTableState::prefetch(uint64_t hash) const {
+   const uint64_t idx = hash & mod_mask;
+   __builtin_prefetch(&data[idx * total_slot_size]);
+   __builtin_prefetch(&tags[idx]);
+}
+
 void SharedHashTableState::advanceNoWrap(size_t& idx, char*& data_ptr, uint8_t*& tag_ptr) const {
    // Should not be called after it returned a nullptr.
    assert(data_ptr != nullptr && tag_ptr != nullptr);
@@ -78,7 +88,7 @@ std::deque<std::unique_ptr<HashTableSimpleKey>> HashTableSimpleKey::buildMergeTa
    // Figure out a smart start slot estimate.
    size_t total_keys = 0;
    for (const auto& ht : preagg) {
-      total_keys += ht->size();
+      total_keys += ht->size() + ht->passThroughSize();
    }
    // 2x slack to make sure that we only have half capacity, also 20% capacity for skew.
    const size_t per_thread = 1.2 * 2 * std::max(static_cast<size_t>(8), total_keys / thread_count);
@@ -126,19 +136,57 @@ char* HashTableSimpleKey::lookupDisable(const char* key) {
 }
 
 char* HashTableSimpleKey::lookupOrInsert(const char* key) {
+   return lookupOrInsert(key, computeHash(key));
+}
+
+void HashTableSimpleKey::lookupOrInsert(char** result, bool* is_new_key, const char* key) {
+   lookupOrInsert(result, is_new_key, key, computeHash(key));
+}
+
+uint64_t HashTableSimpleKey::computeHashAndPrefetch(const char* key) const {
+   const uint64_t hash = computeHash(key);
+   state.prefetch(hash);
+   return hash;
+}
+
+void HashTableSimpleKey::computeHashAndPrefetchBatch(const char* keys, size_t stride, bool indirect, size_t count, uint64_t* hashes) const {
+   // Hash the full batch first. The loop does not touch the hash table.
+   if (indirect) {
+      const auto key_ptrs = reinterpret_cast<const char* const*>(keys);
+      for (size_t k = 0; k < count; ++k) {
+         hashes[k] = computeHash(key_ptrs[k]);
+      }
+   } else {
+      for (size_t k = 0; k < count; ++k) {
+         hashes[k] = computeHash(keys + k * stride);
+      }
+   }
+   // And only then issue the prefetches for the whole batch.
+   for (size_t k = 0; k < count; ++k) {
+      state.prefetch(hashes[k]);
+   }
+}
+
+char* HashTableSimpleKey::lookupOrInsert(const char* key, uint64_t hash) {
    char* result;
    bool is_new_key;
-   lookupOrInsert(&result, &is_new_key, key);
+   lookupOrInsert(&result, &is_new_key, key, hash);
    return result;
 }
 
-void HashTableSimpleKey::lookupOrInsert(char** result, bool* is_new_key, const char* key) {
+void HashTableSimpleKey::lookupOrInsert(char** result, bool* is_new_key, const char* key, uint64_t hash) {
    // Double the hash table if we don't have enough space.
    // Strictly speaking a bit too passive, as we might not need the
    // slot of the key already exists. But this is a border-case.
+   // The hash does not depend on the table size, it stays valid across a resize.
    reserveSlot();
-   // First step: hash the key.
-   const uint64_t hash = XXH3_64bits(key, simple_key_size);
+   processed_rows++;
+   if (pass_through) [[unlikely]] {
+      // Pre-aggregation stopped paying off, every row gets its own slot.
+      *result = passThrough(key, hash);
+      *is_new_key = true;
+      return;
+   }
    const auto slot = findSlotOrEmpty(hash, key);
    if (!(*slot.tag)) {
       // Initialize the slot.
@@ -181,24 +229,26 @@ char* HashTableSimpleKey::insert(const char* key) {
 }
 
 void HashTableSimpleKey::iteratorStart(char** it_data, size_t* it_idx) {
-   *it_idx = 0;
-   *it_data = &state.data[0];
-   uint8_t* tag_ptr = &state.tags[0];
-   while (((*tag_ptr & tag_fill_mask) == 0) && *it_data != nullptr) {
-      // Advance iterator to the first occupied slot.
-      state.advanceNoWrap(*it_idx, *it_data, tag_ptr);
-   }
+   *it_idx = TagScan::next(state.tags.get(), tag_matcher, 0, state.mod_mask + 1);
+   *it_data = *it_idx <= state.mod_mask ? &state.data[*it_idx * state.total_slot_size] : nullptr;
 }
 
 void HashTableSimpleKey::iteratorAdvance(char** it_data, size_t* it_idx) {
    assert(*it_data != nullptr);
-   uint8_t* tag_ptr = &state.tags[*it_idx];
-   // Advance once to the next slot.
-   state.advanceNoWrap(*it_idx, *it_data, tag_ptr);
-   while (((*tag_ptr & tag_fill_mask) == 0) && *it_data != nullptr) {
-      // Advance until a free slot was found.
-      state.advanceNoWrap(*it_idx, *it_data, tag_ptr);
-   }
+   iteratorAdvance(it_data, it_idx, state.mod_mask + 1);
+}
+
+void HashTableSimpleKey::iteratorAdvance(char** it_data, uint64_t* it_idx, uint64_t it_end) {
+   *it_idx = TagScan::next(state.tags.get(), tag_matcher, *it_idx + 1, it_end);
+   *it_data = *it_idx < it_end ? &state.data[*it_idx * state.total_slot_size] : nullptr;
+}
+
+TagScan::Morsel HashTableSimpleKey::iteratorMorsel(uint64_t begin, uint64_t end, size_t max_rows) const {
+   return TagScan::morsel(state.tags.get(), tag_matcher, begin, end, max_rows);
+}
+
+char* HashTableSimpleKey::iteratorData(uint64_t idx) const {
+   return &state.data[idx * state.total_slot_size];
 }
 
 size_t HashTableSimpleKey::size() const {
@@ -222,6 +272,38 @@ char* HashTableSimpleKey::lookupOrInsertSingleKey() {
    return elem_ptr;
 }
 
+void HashTableSimpleKey::enablePassThrough(size_t num_partitions) {
+   assert(num_partitions > 0);
+   assert(partitions.empty());
+   for (size_t k = 0; k < num_partitions; ++k) {
+      partitions.emplace_back(state.total_slot_size);
+   }
+}
+
+bool HashTableSimpleKey::isPassThrough() const {
+   return pass_through;
+}
+
+const TupleMaterializer& HashTableSimpleKey::getPassThroughPartition(size_t partition) const {
+   assert(partition < partitions.size());
+   return partitions[partition];
+}
+
+size_t HashTableSimpleKey::passThroughSize() const {
+   size_t total = 0;
+   for (const auto& partition : partitions) {
+      total += partition.getNumTuples();
+   }
+   return total;
+}
+
+char* HashTableSimpleKey::passThrough(const char* key, uint64_t hash) {
+   // The materializer hands out zero-initialized memory, just like a fresh hash table slot.
+   char* slot = partitions[hash % partitions.size()].materialize();
+   std::memcpy(slot, key, simple_key_size);
+   return slot;
+}
+
 HashTableSimpleKey::LookupResult HashTableSimpleKey::findSlotOrEmpty(uint64_t hash, const char* key) {
    // Access the base table at the right index.
    uint64_t idx = hash & state.mod_mask;
@@ -253,7 +335,16 @@ HashTableSimpleKey::LookupResult HashTableSimpleKey::findFirstEmptySlot(uint64_t
 }
 
 void HashTableSimpleKey::reserveSlot() {
-   if (state.inserted < state.max_fill) [[likely]] {
+   if (state.inserted < state.max_fill || pass_through) [[likely]] {
+      return;
+   }
+
+   if (!partitions.empty() && state.inserted >= PASS_THROUGH_MIN_GROUPS &&
+       processed_rows < PASS_THROUGH_MIN_REDUCTION * state.inserted) {
+      // Most rows create a new group. Growing the table further would only build a large
+      // duplicate of the input that the merge phase has to combine again. Keep the current
+      // groups and scatter all following rows into the partitions.
+      pass_through = true;
       return;
    }
 
@@ -288,7 +379,7 @@ void HashTableSimpleKey::reserveSlot() {
 
 HashTableComplexKey::HashTableComplexKey(uint16_t simple_key_size, uint16_t complex_key_slots, uint16_t payload_size, size_t start_slots)
    : state(simple_key_size + 8 * complex_key_slots + payload_size, start_slots), simple_key_size(simple_key_size), complex_key_slots(complex_key_slots), payload_size(payload_size) {
-   if (simple_key_size != 0 || complex_key_slots != 1) {
+   if (complex_key_slots != 1) {
       throw std::runtime_error("InkFuse currently only supports complex hash tables with a single string.");
    }
 }
@@ -320,50 +411,80 @@ std::deque<std::unique_ptr<HashTableComplexKey>> HashTableComplexKey::buildMerge
 }
 
 uint64_t HashTableComplexKey::computeHash(const char* key) const {
-   // The char* of the key represents the packed key. The first slot contains an 8 byte char pointer.
+   // The char* of the key represents the packed key. The first slot contains an 8 byte char pointer,
+   // the simple part of the key follows right after.
    const auto indirection = reinterpret_cast<char* const*>(key);
    const size_t len = std::strlen(*indirection);
    // Compute the hash.
-   return XXH3_64bits(*indirection, len);
+   const uint64_t hash = XXH3_64bits(*indirection, len);
+   if (simple_key_size == 0) {
+      return hash;
+   }
+   return XXH3_64bits_withSeed(key + 8, simple_key_size, hash);
 };
 
 char* HashTableComplexKey::lookup(const char* key) {
-   // The char* of the key represents the packed key. The first slot contains an 8 byte char pointer.
-   const auto indirection = reinterpret_cast<char* const*>(key);
-   const size_t len = std::strlen(*indirection);
-   // First step: hash the string key.
-   const uint64_t hash = XXH3_64bits(*indirection, len);
+   // First step: hash the key.
+   const uint64_t hash = computeHash(key);
    // Find the slot which we belong to.
-   const auto slot = findSlotOrEmpty(hash, *indirection);
+   const auto slot = findSlotOrEmpty(hash, key);
    // Only if the slot was tagged did we actually find the key.
    return (*slot.tag & tag_fill_mask) ? slot.elem : nullptr;
 }
 
 char* HashTableComplexKey::lookupOrInsert(const char* key) {
+   return lookupOrInsert(key, computeHash(key));
+}
+
+void HashTableComplexKey::lookupOrInsert(char** result, bool* is_new_key, const char* key) {
+   lookupOrInsert(result, is_new_key, key, computeHash(key));
+}
+
+uint64_t HashTableComplexKey::computeHashAndPrefetch(const char* key) const {
+   const uint64_t hash = computeHash(key);
+   state.prefetch(hash);
+   return hash;
+}
+
+void HashTableComplexKey::computeHashAndPrefetchBatch(const char* keys, size_t stride, bool indirect, size_t count, uint64_t* hashes) const {
+   // Hash the full batch first. The loop does not touch the hash table.
+   if (indirect) {
+      const auto key_ptrs = reinterpret_cast<const char* const*>(keys);
+      for (size_t k = 0; k < count; ++k) {
+         hashes[k] = computeHash(key_ptrs[k]);
+      }
+   } else {
+      for (size_t k = 0; k < count; ++k) {
+         hashes[k] = computeHash(keys + k * stride);
+      }
+   }
+   // And only then issue the prefetches for the whole batch.
+   for (size_t k = 0; k < count; ++k) {
+      state.prefetch(hashes[k]);
+   }
+}
+
+char* HashTableComplexKey::lookupOrInsert(const char* key, uint64_t hash) {
    char* result;
    bool is_new_key;
-   lookupOrInsert(&result, &is_new_key, key);
+   lookupOrInsert(&result, &is_new_key, key, hash);
    return result;
 }
 
-void HashTableComplexKey::lookupOrInsert(char** result, bool* is_new_key, const char* key) {
+void HashTableComplexKey::lookupOrInsert(char** result, bool* is_new_key, const char* key, uint64_t hash) {
    // Double the hash table if we don't have enough space.
    // Strictly speaking a bit too passive, as we might not need the
    // slot of the key already exists. But this is a border-case.
+   // The hash does not depend on the table size, it stays valid across a resize.
    reserveSlot();
 
-   // First step: hash the key.
-   // The char* of the key represents the packed key. The first slot contains an 8 byte char pointer.
-   const auto indirection = reinterpret_cast<char* const*>(key);
-   const size_t len = std::strlen(*indirection);
-   const uint64_t hash = XXH3_64bits(*indirection, len);
-   const auto slot = findSlotOrEmpty(hash, *indirection);
+   const auto slot = findSlotOrEmpty(hash, key);
    if (!(*slot.tag)) {
       // Initialize the slot.
       auto target_tag = static_cast<uint8_t>(hash >> 56ul);
       *slot.tag = tag_fill_mask | target_tag;
-      // Copy over the pointer into the first slot.
-      *reinterpret_cast<char**>(slot.elem) = *indirection;
+      // Copy over the pointer into the first slot, followed by the simple key.
+      std::memcpy(slot.elem, key, 8 + simple_key_size);
       state.inserted++;
       *is_new_key = true;
    } else {
@@ -373,27 +494,29 @@ void HashTableComplexKey::lookupOrInsert(char** result, bool* is_new_key, const
 }
 
 void HashTableComplexKey::iteratorStart(char** it_data, uint64_t* it_idx) {
-   *it_idx = 0;
-   *it_data = &state.data[0];
-   uint8_t* tag_ptr = &state.tags[0];
-   while (((*tag_ptr & tag_fill_mask) == 0) && *it_data != nullptr) {
-      // Advance iterator to the first occupied slot.
-      state.advanceNoWrap(*it_idx, *it_data, tag_ptr);
-   }
+   *it_idx = TagScan::next(state.tags.get(), tag_matcher, 0, state.mod_mask + 1);
+   *it_data = *it_idx <= state.mod_mask ? &state.data[*it_idx * state.total_slot_size] : nullptr;
 }
 
 void HashTableComplexKey::iteratorAdvance(char** it_data, uint64_t* it_idx) {
    assert(*it_data != nullptr);
-   uint8_t* tag_ptr = &state.tags[*it_idx];
-   // Advance once to the next slot.
-   state.advanceNoWrap(*it_idx, *it_data, tag_ptr);
-   while (((*tag_ptr & tag_fill_mask) == 0) && *it_data != nullptr) {
-      // Advance until a free slot was found.
-      state.advanceNoWrap(*it_idx, *it_data, tag_ptr);
-   }
+   iteratorAdvance(it_data, it_idx, state.mod_mask + 1);
+}
+
+void HashTableComplexKey::iteratorAdvance(char** it_data, uint64_t* it_idx, uint64_t it_end) {
+   *it_idx = TagScan::next(state.tags.get(), tag_matcher, *it_idx + 1, it_end);
+   *it_data = *it_idx < it_end ? &state.data[*it_idx * state.total_slot_size] : nullptr;
+}
+
+TagScan::Morsel HashTableComplexKey::iteratorMorsel(uint64_t begin, uint64_t end, size_t max_rows) const {
+   return TagScan::morsel(state.tags.get(), tag_matcher, begin, end, max_rows);
+}
+
+char* HashTableComplexKey::iteratorData(uint64_t idx) const {
+   return &state.data[idx * state.total_slot_size];
 }
 
-HashTableComplexKey::LookupResult HashTableComplexKey::findSlotOrEmpty(uint64_t hash, const char* string) {
+HashTableComplexKey::LookupResult HashTableComplexKey::findSlotOrEmpty(uint64_t hash, const char* key) {
    // Access the base table at the right index.
    uint64_t idx = hash & state.mod_mask;
    char* elem_ptr = &state.data[idx * state.total_slot_size];
@@ -401,12 +524,13 @@ HashTableComplexKey::LookupResult HashTableComplexKey::findSlotOrEmpty(uint64_t
    // Get the tag from the hash, take the highest order bits as these
    // have the lowest risk of collision (lowest order bits are used to compute the slot).
    auto target_tag = tag_hash_mask & static_cast<uint8_t>(hash >> 56ul);
+   const char* string = *reinterpret_cast<char* const*>(key);
    for (;;) {
       const uint8_t tag_fill = *tag_ptr & tag_fill_mask;
       const uint8_t tag_hash = *tag_ptr & tag_hash_mask;
-      // Compare the actual strings within the slot.
+      // Compare the actual strings within the slot, and then the simple part of the key.
       const char* elem_string = *reinterpret_cast<char**>(elem_ptr);
-      if (!tag_fill || (tag_hash == target_tag && elem_string && (std::strcmp(elem_string, string) == 0))) {
+      if (!tag_fill || (tag_hash == target_tag && elem_string && (std::strcmp(elem_string, string) == 0) && (std::memcmp(elem_ptr + 8, key + 8, simple_key_size) == 0))) {
          // We either found the key or an empty slot indicating the key does not exist.
          return {.elem = elem_ptr, .tag = tag_ptr};
       }
@@ -446,9 +570,7 @@ void HashTableComplexKey::reserveSlot() {
    for (uint64_t idx = 0; idx <= old_max_slot; ++idx) {
       if (*curr_tag) {
          // If it's set, insert hash value into new table. Upper bit does not matter, so don't have to zero it out.
-         const auto indirection = reinterpret_cast<char* const*>(curr_slot);
-         const size_t len = std::strlen(*indirection);
-         const uint64_t hash = XXH3_64bits(*indirection, len);
+         const uint64_t hash = computeHash(curr_slot);
          const auto slot = findFirstEmptySlot(hash);
          // Move over the tag.
          *slot.tag = *curr_tag;
@@ -470,10 +592,18 @@ size_t HashTableComplexKey::capacity() const {
 }
 
 HashTableDirectLookup::HashTableDirectLookup(uint16_t payload_size_)
-   : slot_size(2 + payload_size_) {
+   : HashTableDirectLookup({KeyColumn{.offset = 0, .width = 2, .min = 0, .cardinality = 1 << 16}}, 2, payload_size_) {
+}
+
+HashTableDirectLookup::HashTableDirectLookup(std::vector<KeyColumn> key_columns_, uint16_t key_size_, uint16_t payload_size_)
+   : key_columns(std::move(key_columns_)), num_slots(1), key_size(key_size_), slot_size(key_size_ + payload_size_) {
+   for (const auto& col : key_columns) {
+      assert(col.width <= 8 && col.offset + col.width <= key_size);
+      num_slots *= col.cardinality;
+   }
    // Allocate array for direct lookup.
-   data = std::make_unique<char[]>((1 << 16) * slot_size);
-   tags = std::make_unique<bool[]>(1 << 16);
+   data = std::make_unique<char[]>(num_slots * slot_size);
+   tags = std::make_unique<bool[]>(num_slots);
 }
 
 std::deque<std::unique_ptr<HashTableDirectLookup>> HashTableDirectLookup::buildMergeTables(
@@ -482,51 +612,64 @@ std::deque<std::unique_ptr<HashTableDirectLookup>> HashTableDirectLookup::buildM
    assert(thread_count);
    std::deque<std::unique_ptr<HashTableDirectLookup>> result;
    for (size_t k = 0; k < thread_count; k++) {
-      result.push_back(std::make_unique<HashTableDirectLookup>(preagg[0]->slot_size - 2));
+      result.push_back(std::make_unique<HashTableDirectLookup>(preagg[0]->key_columns, preagg[0]->key_size, preagg[0]->slot_size - preagg[0]->key_size));
    }
    return result;
 }
 
 uint64_t HashTableDirectLookup::computeHash(const char* key) const {
-   const uint16_t idx = *reinterpret_cast<const uint16_t*>(key);
+   uint64_t idx = 0;
+   uint64_t stride = 1;
+   for (const auto& col : key_columns) {
+      // Values are stored little endian, so copying the bytes zero-extends the column.
+      uint64_t val = 0;
+      std::memcpy(&val, key + col.offset, col.width);
+      // Subtracting the minimum modulo the column width works for both signed and unsigned columns.
+      const uint64_t width_mask = col.width == 8 ? ~0ull : (1ull << (8 * col.width)) - 1;
+      const uint64_t col_idx = (val - col.min) & width_mask;
+      assert(col_idx < col.cardinality);
+      idx += col_idx * stride;
+      stride *= col.cardinality;
+   }
    return idx;
 }
 
 char* HashTableDirectLookup::lookup(const char* key) {
-   const uint16_t idx = *reinterpret_cast<const uint16_t*>(key);
+   const uint64_t idx = computeHash(key);
    return tags[idx] ? &data[slot_size * idx] : nullptr;
 }
 
 char* HashTableDirectLookup::lookupOrInsert(const char* key) {
-   const uint16_t idx = *reinterpret_cast<const uint16_t*>(key);
+   const uint64_t idx = computeHash(key);
+   char* ptr = &data[slot_size * idx];
    if (!tags[idx]) {
       num_inserted++;
+      tags[idx] = true;
+      std::memcpy(ptr, key, key_size);
    }
-   tags[idx] = true;
-   char* ptr = &data[slot_size * idx];
-   *reinterpret_cast<uint16_t*>(ptr) = idx;
    return ptr;
 }
 
 void HashTableDirectLookup::iteratorStart(char** it_data, uint64_t* it_idx) {
-   *it_data = &data[0];
-   *it_idx = 0;
-   if (!tags[*it_idx]) {
-      iteratorAdvance(it_data, it_idx);
-   }
+   *it_idx = TagScan::next(reinterpret_cast<const uint8_t*>(tags.get()), direct_lookup_matcher, 0, capacity());
+   *it_data = *it_idx < capacity() ? &data[slot_size * *it_idx] : nullptr;
 }
 
 void HashTableDirectLookup::iteratorAdvance(char** it_data, uint64_t* it_idx) {
-   (*it_idx)++;
-   (*it_data) += slot_size;
-   while (*it_idx < (1 << 16)) {
-      if (tags[*it_idx]) {
-         return;
-      }
-      (*it_idx)++;
-      (*it_data) += slot_size;
-   }
-   *it_data = nullptr;
+   iteratorAdvance(it_data, it_idx, capacity());
+}
+
+void HashTableDirectLookup::iteratorAdvance(char** it_data, uint64_t* it_idx, uint64_t it_end) {
+   *it_idx = TagScan::next(reinterpret_cast<const uint8_t*>(tags.get()), direct_lookup_matcher, *it_idx + 1, it_end);
+   *it_data = *it_idx < it_end ? &data[slot_size * *it_idx] : nullptr;
+}
+
+TagScan::Morsel HashTableDirectLookup::iteratorMorsel(uint64_t begin, uint64_t end, size_t max_rows) const {
+   return TagScan::morsel(reinterpret_cast<const uint8_t*>(tags.get()), direct_lookup_matcher, begin, end, max_rows);
+}
+
+char* HashTableDirectLookup::iteratorData(uint64_t idx) const {
+   return &data[slot_size * idx];
 }
 
 size_t HashTableDirectLookup::size() const {
@@ -534,7 +677,7 @@ size_t HashTableDirectLookup::size() const {
 }
 
 size_t HashTableDirectLookup::capacity() const {
-   return 1 << 16;
+   return num_slots;
 }
 
 }
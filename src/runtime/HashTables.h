@@ -1,9 +1,12 @@
 #ifndef INKFUSE_HASHTABLES_H
 #define INKFUSE_HASHTABLES_H
 
+#include "runtime/TagScan.h"
+#include "runtime/TupleMaterializer.h"
 #include <cstdint>
 #include <deque>
 #include <memory>
+#include <vector>
 
 /// This file contains the single-threaded hash tables used for aggregating data in InkFuse.
 namespace inkfuse {
@@ -19,6 +22,8 @@ struct SharedHashTableState {
    inline void advance(size_t& idx, char*& curr, uint8_t*& tag) const;
    /// Advance an iterator within the hash table. Sets the pointer to nullptr when the end of the hash table is reached.
    inline void advanceNoWrap(size_t& idx, char*& curr, uint8_t*& tag) const;
+   /// Prefetch the slot and tag the given hash maps to.
+   inline void prefetch(uint64_t hash) const;
 
    /// Occupied tags containing parts of the key hash.
    /// Similar approach as in folly f14 (just less fast and generic).
@@ -59,12 +64,29 @@ struct alignas(64) HashTableSimpleKey {
    /// Updates the 'result' and 'is_new_key' arguments to give the caller
    /// insight into whether this key was new.
    void lookupOrInsert(char** result, bool* is_new_key, const char* key);
+   /// Compute the hash of some serialized key and prefetch its slot for a following lookupOrInsert.
+   uint64_t computeHashAndPrefetch(const char* key) const;
+   /// Hash a batch of keys, then prefetch all their slots. Produces the same hashes as computeHashAndPrefetch.
+   /// The keys are either dense with the given stride, or pointers to the keys if `indirect` is set.
+   void computeHashAndPrefetchBatch(const char* keys, size_t stride, bool indirect, size_t count, uint64_t* hashes) const;
+   /// Get the pointer to a given key with precomputed hash, creating a new group if it does not exist yet.
+   char* lookupOrInsert(const char* key, uint64_t hash);
+   /// Get the pointer to a given key with precomputed hash, creating a new group if it does not exist yet.
+   /// Updates the 'result' and 'is_new_key' arguments like the overload without hash.
+   void lookupOrInsert(char** result, bool* is_new_key, const char* key, uint64_t hash);
    /// Get an iterator to the first non-empty element of the hash table.
    /// Sets it_data to nullptr if the iterator is exhausted.
    void iteratorStart(char** it_data, uint64_t* it_idx);
    /// Advance an iterator to the next non-empty element in the hash table.
    /// Sets it_data to nullptr if the iterator is exhausted.
    void iteratorAdvance(char** it_data, uint64_t* it_idx);
+   /// Advance an iterator to the next non-empty element before the slot it_end.
+   /// Sets it_idx to it_end and it_data to nullptr if the iterator is exhausted.
+   void iteratorAdvance(char** it_data, uint64_t* it_idx, uint64_t it_end);
+   /// Find the next morsel of at most max_rows elements in the slot range [begin, end).
+   TagScan::Morsel iteratorMorsel(uint64_t begin, uint64_t end, size_t max_rows) const;
+   /// Get the data of the slot at the given index.
+   char* iteratorData(uint64_t idx) const;
    /// Get the current size. Mainly used for testing.
    size_t size() const;
    /// Get the current capacity. Mainly used for testing.
@@ -73,6 +95,26 @@ struct alignas(64) HashTableSimpleKey {
    /// Special function if we know this hash table is only ever called with a single key.
    char* lookupOrInsertSingleKey();
 
+   /// Adaptive pre-aggregation. Thread-local pre-aggregation only pays off if groups repeat.
+   /// Once the table holds PASS_THROUGH_MIN_GROUPS groups, every resize checks how many rows
+   /// were aggregated per group. If that reduction falls below PASS_THROUGH_MIN_REDUCTION, the
+   /// table stops growing and lookupOrInsert scatters every following row into a fresh,
+   /// zero-initialized slot of one of `num_partitions` hash-partitioned buffers. Partition `k`
+   /// receives the keys with `computeHash(key) % num_partitions == k`, which allows the final
+   /// aggregation phase to merge the partitions without any further coordination.
+   void enablePassThrough(size_t num_partitions);
+   /// Did the table stop pre-aggregating?
+   bool isPassThrough() const;
+   /// Get the slots that were scattered into the given partition.
+   const TupleMaterializer& getPassThroughPartition(size_t partition) const;
+   /// Get the total number of slots scattered into the pass-through partitions.
+   size_t passThroughSize() const;
+
+   /// Number of groups before adaptive pre-aggregation decides whether to keep pre-aggregating.
+   static constexpr size_t PASS_THROUGH_MIN_GROUPS = 1 << 15;
+   /// Minimum number of rows per group for which pre-aggregation is kept.
+   static constexpr double PASS_THROUGH_MIN_REDUCTION = 2.0;
+
    private:
    struct LookupResult {
       char* elem;
@@ -84,18 +126,27 @@ struct alignas(64) HashTableSimpleKey {
    /// Find the first empty slot for the given hash.
    inline LookupResult findFirstEmptySlot(uint64_t hash);
    /// Make sure one more slot can be added to the hash table.
-   /// If not, doubles size.
+   /// If not, doubles size. With adaptive pre-aggregation, may switch to pass-through instead.
    void reserveSlot();
+   /// Scatter the key into a new slot of its pass-through partition.
+   char* passThrough(const char* key, uint64_t hash);
 
    SharedHashTableState state;
    /// Size of the materialized simple key.
    uint16_t simple_key_size;
+   /// Number of rows that went through lookupOrInsert. Used to compute the reduction ratio.
+   size_t processed_rows = 0;
+   /// Is the table scattering rows into the partitions instead of pre-aggregating?
+   bool pass_through = false;
+   /// Hash-partitioned pass-through buffers. Empty if adaptive pre-aggregation is disabled.
+   std::deque<TupleMaterializer> partitions;
 };
 
 /// A hash table with a more complex key. In principle, the key can contain both
 /// a simple part which can just be memcmpared, as well as a set of
 /// successive key slots for more complex data types (such as strings).
-/// Currently we only support using a single string as key.
+/// Currently we only support a single string as key, optionally followed by a simple
+/// part (e.g. the NULL indicator of a nullable string).
 struct alignas(64) HashTableComplexKey {
    /// Unique Hash Table ID.
    static const std::string ID;
@@ -114,6 +165,16 @@ struct alignas(64) HashTableComplexKey {
    /// Updates the 'result' and 'is_new_key' arguments to give the caller
    /// insight into whether this key was new.
    void lookupOrInsert(char** result, bool* is_new_key, const char* key);
+   /// Compute the hash of some serialized key and prefetch its slot for a following lookupOrInsert.
+   uint64_t computeHashAndPrefetch(const char* key) const;
+   /// Hash a batch of keys, then prefetch all their slots. Produces the same hashes as computeHashAndPrefetch.
+   /// The keys are either dense with the given stride, or pointers to the keys if `indirect` is set.
+   void computeHashAndPrefetchBatch(const char* keys, size_t stride, bool indirect, size_t count, uint64_t* hashes) const;
+   /// Get the pointer to a given key with precomputed hash, creating a new group if it does not exist yet.
+   char* lookupOrInsert(const char* key, uint64_t hash);
+   /// Get the pointer to a given key with precomputed hash, creating a new group if it does not exist yet.
+   /// Updates the 'result' and 'is_new_key' arguments like the overload without hash.
+   void lookupOrInsert(char** result, bool* is_new_key, const char* key, uint64_t hash);
 
    /// Get an iterator to the first non-empty element of the hash table.
    /// Sets it_data to nullptr if the iterator is exhausted.
@@ -121,6 +182,13 @@ struct alignas(64) HashTableComplexKey {
    /// Advance an iterator to the next non-empty element in the hash table.
    /// Sets it_data to nullptr if the iterator is exhausted.
    void iteratorAdvance(char** it_data, uint64_t* it_idx);
+   /// Advance an iterator to the next non-empty element before the slot it_end.
+   /// Sets it_idx to it_end and it_data to nullptr if the iterator is exhausted.
+   void iteratorAdvance(char** it_data, uint64_t* it_idx, uint64_t it_end);
+   /// Find the next morsel of at most max_rows elements in the slot range [begin, end).
+   TagScan::Morsel iteratorMorsel(uint64_t begin, uint64_t end, size_t max_rows) const;
+   /// Get the data of the slot at the given index.
+   char* iteratorData(uint64_t idx) const;
 
    /// Get the current size. Mainly used for testing.
    size_t size() const;
@@ -142,7 +210,7 @@ struct alignas(64) HashTableComplexKey {
       uint8_t* tag;
    };
 
-   /// Find the correct slot for the key, or the first one which is empty.
+   /// Find the correct slot for the packed key, or the first one which is empty.
    inline LookupResult findSlotOrEmpty(uint64_t hash, const char* key);
    /// Find the first empty slot for the given hash.
    inline LookupResult findFirstEmptySlot(uint64_t hash);
@@ -152,14 +220,30 @@ struct alignas(64) HashTableComplexKey {
 };
 
 /// A hash table using direct lookup on the key index. No hashing, no nothing.
-/// Should be used for 2 byte keys. Okay - this is a bit micro-optimized for TPC-H Q1,
-/// we should also have a one byte variation. But we don't need it at the moment.
-/// This is not an architectural limitation.
+/// By default this is a table over 2 byte keys. Okay - this is a bit micro-optimized for TPC-H Q1.
+/// Aggregations also use it for small and dense key domains: every column of the packed key has a
+/// known value range, and the slot index is the mixed-radix number of the column offsets within their ranges.
 struct alignas(64) HashTableDirectLookup {
+   /// A column of the packed key.
+   struct KeyColumn {
+      /// Offset of the column within the packed key.
+      uint16_t offset;
+      /// Width of the column in bytes.
+      uint8_t width;
+      /// Smallest value of the column. Only the lower `width` bytes are relevant.
+      uint64_t min;
+      /// Number of values in the column's value range.
+      uint64_t cardinality;
+   };
+
+   /// Largest number of slots the planner should use a direct lookup table for.
+   static constexpr uint64_t MAX_SLOTS = 1 << 16;
+
    /// Unique Hash Table ID.
    static const std::string ID;
 
    HashTableDirectLookup(uint16_t payload_size_);
+   HashTableDirectLookup(std::vector<KeyColumn> key_columns_, uint16_t key_size_, uint16_t payload_size_);
    static std::deque<std::unique_ptr<HashTableDirectLookup>> buildMergeTables(
       std::deque<std::unique_ptr<HashTableDirectLookup>>& preagg, size_t thread_count);
 
@@ -168,7 +252,7 @@ struct alignas(64) HashTableDirectLookup {
    /// Get the pointer to a given key, creating a new group if it does not exist yet.
    char* lookupOrInsert(const char* key);
 
-   /// Compute the hash of some serialized key.
+   /// Compute the hash of some serialized key. This is the slot index of the key.
    uint64_t computeHash(const char* key) const;
    /// Get an iterator to the first non-empty element of the hash table.
    /// Sets it_data to nullptr if the iterator is exhausted.
@@ -176,17 +260,30 @@ struct alignas(64) HashTableDirectLookup {
    /// Advance an iterator to the next non-empty element in the hash table.
    /// Sets it_data to nullptr if the iterator is exhausted.
    void iteratorAdvance(char** it_data, uint64_t* it_idx);
+   /// Advance an iterator to the next non-empty element before the slot it_end.
+   /// Sets it_idx to it_end and it_data to nullptr if the iterator is exhausted.
+   void iteratorAdvance(char** it_data, uint64_t* it_idx, uint64_t it_end);
+   /// Find the next morsel of at most max_rows elements in the slot range [begin, end).
+   TagScan::Morsel iteratorMorsel(uint64_t begin, uint64_t end, size_t max_rows) const;
+   /// Get the data of the slot at the given index.
+   char* iteratorData(uint64_t idx) const;
    /// Get the current size. Mainly used for testing.
    size_t size() const;
    /// Get the current capacity. Mainly used for testing.
    size_t capacity() const;
 
+   /// The columns of the packed key.
+   std::vector<KeyColumn> key_columns;
    /// Data managed by the hash table.
    std::unique_ptr<char[]> data;
    /// Tags indicating which slot contains data.
    std::unique_ptr<bool[]> tags;
    /// How many rows were inserted?
    size_t num_inserted = 0;
+   /// Number of slots, the product of the key column cardinalities.
+   uint64_t num_slots;
+   /// Size of the packed key at the start of every slot.
+   uint16_t key_size;
    /// Total slot size.
    uint16_t slot_size;
 };
@@ -0,0 +1,57 @@
+#include "runtime/HyperLogLog.h"
+#include "xxhash.h"
+#include <algorithm>
+#include <bit>
+#include <cmath>
+#include <cstring>
+
+namespace inkfuse::HyperLogLog {
+
+uint64_t hashBits(uint64_t bits) {
+   // Murmur3 finalizer. Fixed-width values are often dense, so they need proper mixing.
+   bits ^= bits >> 33;
+   bits *= 0xff51afd7ed558ccdull;
+   bits ^= bits >> 33;
+   bits *= 0xc4ceb9fe1a85ec53ull;
+   bits ^= bits >> 33;
+   return bits;
+}
+
+uint64_t hashString(const char* str) {
+   return XXH3_64bits(str, std::strlen(str));
+}
+
+void add(uint8_t* registers, uint64_t hash) {
+   // The upper bits select the register, the rank is the position of the first set bit in the rest.
+   const uint64_t idx = hash >> (64 - precision);
+   // The sentinel bit bounds the rank if all remaining bits are zero.
+   const uint64_t rest = (hash << precision) | (uint64_t{1} << (precision - 1));
+   const auto rank = static_cast<uint8_t>(std::countl_zero(rest) + 1);
+   registers[idx] = std::max(registers[idx], rank);
+}
+
+void merge(uint8_t* target, const uint8_t* source) {
+   for (size_t k = 0; k < num_registers; ++k) {
+      target[k] = std::max(target[k], source[k]);
+   }
+}
+
+int64_t estimate(const uint8_t* registers) {
+   const double m = num_registers;
+   double sum = 0.0;
+   size_t zeros = 0;
+   for (size_t k = 0; k < num_registers; ++k) {
+      sum += std::ldexp(1.0, -registers[k]);
+      zeros += registers[k] == 0;
+   }
+   const double alpha = 0.7213 / (1.0 + 1.079 / m);
+   double result = alpha * m * m / sum;
+   if (result <= 2.5 * m && zeros != 0) {
+      // Linear counting for small cardinalities.
+      result = m * std::log(m / static_cast<double>(zeros));
+   }
+   // 64 bit hashes don't need a large range correction.
+   return std::llround(result);
+}
+
+}
@@ -27,12 +27,18 @@ struct alignas(64) MemoryRegion {
    /// previously accessed pointers, we need to restart the previous lookups in order to ensure that
    /// we don't access deallocated memory of the older (smaller) hash table.
    bool restart_flag = false;
+   /// The overflow flag is set by checked decimal arithmetic in the generated code. Generated code
+   /// cannot throw, the PipelineExecutor checks the flag once a morsel was processed and fails the query.
+   bool overflow_flag = false;
 };
 
 // Allocate memory in the context of this pipeline.
 // Always 8-byte aligned.
 extern "C" void* inkfuse_malloc(uint64_t size);
 
+// Flag an overflow of checked arithmetic in the context of this pipeline.
+extern "C" void inkfuse_overflow();
+
 } // namespace inkfuse::MemoryRuntime
 
 #endif //INKFUSE_MEMORYRUNTIME_H
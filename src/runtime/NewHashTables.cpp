@@ -20,6 +20,12 @@ const uint8_t outer_tag_fill_mask = 1u << 6u;
 const uint8_t outer_tag_fill_mask_inverted = ~outer_tag_fill_mask;
 /// Lower order 6 bits in the hash slot store salt of the hash for outer joins.
 const uint8_t outer_tag_hash_mask = outer_tag_fill_mask - 1;
+/// The outer join iterator visits all filled slots that were not marked.
+const TagScan::Matcher outer_matcher{.mask = tag_fill_mask | outer_tag_fill_mask, .value = tag_fill_mask};
+/// Matcher for the filled slots that were marked.
+const TagScan::Matcher marked_matcher{.mask = tag_fill_mask | outer_tag_fill_mask, .value = tag_fill_mask | outer_tag_fill_mask};
+/// Matcher for all filled slots.
+const TagScan::Matcher filled_matcher{.mask = tag_fill_mask, .value = tag_fill_mask};
 }
 
 template <>
@@ -77,7 +83,8 @@ AtomicHashTable<Comparator>::AtomicHashTable(Comparator comp_, uint16_t total_sl
    : comp(comp_),
      total_slot_size(total_slot_size_),
      num_slots(num_slots_),
-     mod_mask(num_slots_ - 1) {
+     mod_mask(num_slots_ - 1),
+     it_matcher(outer_matcher) {
    if (num_slots < 2 || ((num_slots & (num_slots - 1)) != 0)) {
       throw std::runtime_error(
          "Atomic hash table start size has to power of 2 of at least size 2. Provided " +
@@ -120,6 +127,35 @@ uint64_t AtomicHashTable<Comparator>::compute_hash_and_prefetch_fixed(const char
    return hash;
 }
 
+template <class Comparator>
+template <uint64_t key_width>
+void AtomicHashTable<Comparator>::compute_hash_and_prefetch_batch(const char* keys, size_t stride, bool indirect, size_t count, uint64_t* hashes) const {
+   static_assert(key_width == 0 || std::is_same_v<Comparator, SimpleKeyComparator>);
+   auto hash_key = [&](const char* key) {
+      if constexpr (key_width == 0) {
+         return comp.hash(key);
+      } else {
+         // Static lengths let XXH3 inline its short-input path.
+         return XXH3_64bits(key, key_width);
+      }
+   };
+   // Hash the full batch first. The loop does not touch the hash table.
+   if (indirect) {
+      const auto key_ptrs = reinterpret_cast<const char* const*>(keys);
+      for (size_t k = 0; k < count; ++k) {
+         hashes[k] = hash_key(key_ptrs[k]);
+      }
+   } else {
+      for (size_t k = 0; k < count; ++k) {
+         hashes[k] = hash_key(keys + k * stride);
+      }
+   }
+   // And only then issue the prefetches for the whole batch.
+   for (size_t k = 0; k < count; ++k) {
+      slot_prefetch(hashes[k]);
+   }
+}
+
 template <class Comparator>
 void AtomicHashTable<Comparator>::slot_prefetch(uint64_t hash) const {
    const uint64_t slot_id = hash & mod_mask;
@@ -356,37 +392,52 @@ void AtomicHashTable<Comparator>::itAdvanceNoWrap(IteratorState& it) const {
 
 template <class Comparator>
 void AtomicHashTable<Comparator>::iteratorStart(char** it_data, uint64_t* it_idx) {
-   IteratorState it;
-   it.idx = 0;
-   it.data_ptr = &data[0];
-   it.tag_ptr = &tags[0];
-   uint8_t it_tag = it.tag_ptr->load();
-   while ((((it_tag & tag_fill_mask) == 0) || ((it_tag & outer_tag_fill_mask) != 0)) && it.data_ptr != nullptr) {
-      // Advance iterator to the first occupied slot that was not tagged.
-      itAdvanceNoWrap(it);
-      it_tag = it.tag_ptr->load();
-   }
-   *it_data = it.data_ptr;
-   *it_idx = it.idx;
+   *it_idx = TagScan::next(rawTags(), it_matcher, 0, mod_mask + 1);
+   *it_data = *it_idx <= mod_mask ? &data[*it_idx * total_slot_size] : nullptr;
 }
 
 template <class Comparator>
 void AtomicHashTable<Comparator>::iteratorAdvance(char** it_data, uint64_t* it_idx) {
    assert(*it_data != nullptr);
-   IteratorState it;
-   it.idx = *it_idx;
-   it.data_ptr = *it_data;
-   it.tag_ptr = &tags[it.idx];
-   // Advance once to the next slot.
-   itAdvanceNoWrap(it);
-   uint8_t it_tag = it.tag_ptr->load();
-   while ((((it_tag & tag_fill_mask) == 0) || ((it_tag & outer_tag_fill_mask) != 0)) && it.data_ptr != nullptr) {
-      // Advance until a free slot was found.
-      itAdvanceNoWrap(it);
-      it_tag = it.tag_ptr->load();
+   iteratorAdvance(it_data, it_idx, mod_mask + 1);
+}
+
+template <class Comparator>
+void AtomicHashTable<Comparator>::iteratorAdvance(char** it_data, uint64_t* it_idx, uint64_t it_end) {
+   *it_idx = TagScan::next(rawTags(), it_matcher, *it_idx + 1, it_end);
+   *it_data = *it_idx < it_end ? &data[*it_idx * total_slot_size] : nullptr;
+}
+
+template <class Comparator>
+TagScan::Morsel AtomicHashTable<Comparator>::iteratorMorsel(uint64_t begin, uint64_t end, size_t max_rows) const {
+   return TagScan::morsel(rawTags(), it_matcher, begin, end, max_rows);
+}
+
+template <class Comparator>
+char* AtomicHashTable<Comparator>::iteratorData(uint64_t idx) const {
+   return &data[idx * total_slot_size];
+}
+
+template <class Comparator>
+void AtomicHashTable<Comparator>::setIteratorSlots(IteratorSlots slots) {
+   switch (slots) {
+      case IteratorSlots::Unmarked:
+         it_matcher = outer_matcher;
+         break;
+      case IteratorSlots::Marked:
+         it_matcher = marked_matcher;
+         break;
+      case IteratorSlots::All:
+         it_matcher = filled_matcher;
+         break;
    }
-   *it_data = it.data_ptr;
-   *it_idx = it.idx;
+}
+
+template <class Comparator>
+const uint8_t* AtomicHashTable<Comparator>::rawTags() const {
+   // Iteration only happens once the build side is complete, tags are no longer modified.
+   static_assert(sizeof(std::atomic<uint8_t>) == sizeof(uint8_t));
+   return reinterpret_cast<const uint8_t*>(tags.get());
 }
 
 // Declare all permitted template instantiations.
@@ -409,6 +460,10 @@ template char* AtomicHashTable<ComplexKeyComparator>::insert<false>(const char*
 
 template uint64_t AtomicHashTable<SimpleKeyComparator>::compute_hash_and_prefetch_fixed<4>(const char* key) const;
 template uint64_t AtomicHashTable<SimpleKeyComparator>::compute_hash_and_prefetch_fixed<8>(const char* key) const;
+template void AtomicHashTable<SimpleKeyComparator>::compute_hash_and_prefetch_batch<0>(const char* keys, size_t stride, bool indirect, size_t count, uint64_t* hashes) const;
+template void AtomicHashTable<SimpleKeyComparator>::compute_hash_and_prefetch_batch<4>(const char* keys, size_t stride, bool indirect, size_t count, uint64_t* hashes) const;
+template void AtomicHashTable<SimpleKeyComparator>::compute_hash_and_prefetch_batch<8>(const char* keys, size_t stride, bool indirect, size_t count, uint64_t* hashes) const;
+template void AtomicHashTable<ComplexKeyComparator>::compute_hash_and_prefetch_batch<0>(const char* keys, size_t stride, bool indirect, size_t count, uint64_t* hashes) const;
 
 template class ExclusiveHashTable<SimpleKeyComparator>;
 template class ExclusiveHashTable<ComplexKeyComparator>;
@@ -1,6 +1,7 @@
 #ifndef INKFUSE_NEWHASHTABLES_H
 #define INKFUSE_NEWHASHTABLES_H
 
+#include "runtime/TagScan.h"
 #include <atomic>
 #include <cstdint>
 #include <memory>
@@ -41,6 +42,16 @@ template <class Comparator>
 struct AtomicHashTable {
    static const std::string ID;
 
+   /// The filled slots visited by the iterators.
+   enum class IteratorSlots {
+      /// Slots that were not marked by an outer lookup. Produces the rows without join partner of outer joins.
+      Unmarked,
+      /// Slots that were marked by an outer lookup.
+      Marked,
+      /// All filled slots.
+      All,
+   };
+
    AtomicHashTable(Comparator comp_, uint16_t total_slot_size_, size_t num_slots_);
    size_t capacity() const { return num_slots; };
 
@@ -52,6 +63,15 @@ struct AtomicHashTable {
    template <uint64_t key_width>
    uint64_t compute_hash_and_prefetch_fixed(const char* key) const;
 
+   /// Hash a batch of `count` keys into `hashes` and prefetch their slots afterwards.
+   /// Key k lives at `keys + k * stride`, or behind the pointer `((const char**) keys)[k]`
+   /// if `indirect` is set. Produces the same hashes as `compute_hash_and_prefetch`.
+   /// Splitting hashing and prefetching keeps the hash loop tight, and all prefetches
+   /// are in flight by the time the first lookup of the batch runs.
+   /// @tparam key_width fixed key width of the SimpleKeyComparator (4 or 8), 0 for the comparator's key.
+   template <uint64_t key_width = 0>
+   void compute_hash_and_prefetch_batch(const char* keys, size_t stride, bool indirect, size_t count, uint64_t* hashes) const;
+
    /// Prefetch the tag and data slots for a specific hash.
    void slot_prefetch(uint64_t hash) const;
    /// Get the pointer to a given key, or nullptr if the group does not exist.
@@ -87,6 +107,15 @@ struct AtomicHashTable {
    void iteratorStart(char** it_data, size_t* it_idx);
    /// Hash table outer join iterator advance for the HashTableSource.
    void iteratorAdvance(char** it_data, size_t* it_idx);
+   /// Advance the outer join iterator to the next element before the slot it_end.
+   /// Sets it_idx to it_end and it_data to nullptr if the iterator is exhausted.
+   void iteratorAdvance(char** it_data, uint64_t* it_idx, uint64_t it_end);
+   /// Find the next morsel of at most max_rows outer join elements in the slot range [begin, end).
+   TagScan::Morsel iteratorMorsel(uint64_t begin, uint64_t end, size_t max_rows) const;
+   /// Get the data of the slot at the given index.
+   char* iteratorData(uint64_t idx) const;
+   /// Change the slots visited by the iterators. Defaults to the unmarked slots.
+   void setIteratorSlots(IteratorSlots slots);
 
    private:
    /// An iterator within the atomic hash table.
@@ -107,6 +136,8 @@ struct AtomicHashTable {
    inline void itAdvance(IteratorState& it) const;
    /// Advance an iterator within the hash table. Sets the pointer to nullptr when the end of the hash table is reached.
    inline void itAdvanceNoWrap(IteratorState& it) const;
+   /// The tag array as plain bytes for scanning it once the table is built.
+   const uint8_t* rawTags() const;
 
    /// The key comparator.
    Comparator comp;
@@ -123,6 +154,8 @@ struct AtomicHashTable {
    uint64_t mod_mask;
    /// Total slot size.
    uint16_t total_slot_size;
+   /// Tag matcher of the slots visited by the iterators.
+   TagScan::Matcher it_matcher;
 };
 
 /// A hash table that is owned by just one thread and needs no synchronization.
@@ -0,0 +1,237 @@
+#include "runtime/Quantiles.h"
+#include "runtime/MemoryRuntime.h"
+#include <algorithm>
+#include <array>
+#include <cmath>
+#include <numbers>
+#include <cstring>
+#include <vector>
+
+namespace inkfuse {
+
+namespace ExactQuantile {
+
+namespace {
+
+/// Chunk of values within the value list of a group. The values follow the header directly.
+struct Chunk {
+   Chunk* next;
+   uint32_t count;
+   uint32_t capacity;
+
+   double* values() { return reinterpret_cast<double*>(this + 1); }
+   const double* values() const { return reinterpret_cast<const double*>(this + 1); }
+};
+
+/// The first chunk fills a cache line.
+constexpr uint32_t initial_capacity = 6;
+/// Chunk sizes double until they hit the largest inkfuse_malloc allocation.
+constexpr uint32_t max_capacity = 504;
+
+}
+
+void add(char* state, double value) {
+   Chunk*& head = *reinterpret_cast<Chunk**>(state);
+   if (!head || head->count == head->capacity) [[unlikely]] {
+      const uint32_t capacity = head ? std::min(2 * head->capacity, max_capacity) : initial_capacity;
+      auto chunk = static_cast<Chunk*>(MemoryRuntime::inkfuse_malloc(sizeof(Chunk) + capacity * sizeof(double)));
+      chunk->next = head;
+      chunk->count = 0;
+      chunk->capacity = capacity;
+      head = chunk;
+   }
+   head->values()[head->count++] = value;
+}
+
+void merge(char* target, const char* source) {
+   Chunk* source_head = *reinterpret_cast<Chunk* const*>(source);
+   if (!source_head) {
+      return;
+   }
+   // Splice the source list in front of the target list.
+   Chunk* tail = source_head;
+   while (tail->next) {
+      tail = tail->next;
+   }
+   Chunk*& target_head = *reinterpret_cast<Chunk**>(target);
+   tail->next = target_head;
+   target_head = source_head;
+}
+
+double median(const char* state) {
+   std::vector<double> values;
+   for (const Chunk* chunk = *reinterpret_cast<const Chunk* const*>(state); chunk; chunk = chunk->next) {
+      values.insert(values.end(), chunk->values(), chunk->values() + chunk->count);
+   }
+   if (values.empty()) {
+      return 0.0;
+   }
+   const auto mid = values.begin() + values.size() / 2;
+   std::nth_element(values.begin(), mid, values.end());
+   if (values.size() % 2 == 1) {
+      return *mid;
+   }
+   // The lower middle value is the largest value in front of the upper one.
+   return (*std::max_element(values.begin(), mid) + *mid) / 2;
+}
+
+}
+
+namespace TDigest {
+
+namespace {
+
+struct Centroid {
+   double mean;
+   double weight;
+};
+
+/// Centroids and buffered values of up to two digests.
+using CentroidBuffer = std::array<Centroid, 2 * (max_centroids + buffer_size)>;
+
+bool empty(const Digest& digest) {
+   return digest.num_centroids == 0 && digest.num_buffered == 0;
+}
+
+/// Append the centroids and buffered values of a digest.
+void collect(const Digest& digest, CentroidBuffer& centroids, size_t& count) {
+   for (uint32_t k = 0; k < digest.num_centroids; ++k) {
+      centroids[count++] = {digest.means[k], digest.weights[k]};
+   }
+   for (uint32_t k = 0; k < digest.num_buffered; ++k) {
+      centroids[count++] = {digest.buffer[k], 1.0};
+   }
+}
+
+/// The k_1 scale function of the t-digest.
+double scale(double q, double compression) {
+   return compression / (2 * std::numbers::pi) * std::asin(2 * q - 1);
+}
+
+/// Greedily merge neighbouring centroids while they span at most one unit of the scale
+/// function. Centroids at the tails stay small, which keeps extreme quantiles accurate.
+/// Returns the number of resulting centroids.
+size_t compressWith(const Centroid* sorted, size_t count, double total, double compression, Centroid* out) {
+   size_t result = 0;
+   out[0] = sorted[0];
+   double weight_before = 0.0;
+   for (size_t k = 1; k < count; ++k) {
+      Centroid& current = out[result];
+      const double weight = current.weight + sorted[k].weight;
+      const double q_left = weight_before / total;
+      const double q_right = (weight_before + weight) / total;
+      if (scale(q_right, compression) - scale(q_left, compression) <= 1.0) {
+         current.mean += (sorted[k].mean - current.mean) * sorted[k].weight / weight;
+         current.weight = weight;
+      } else {
+         weight_before += current.weight;
+         out[++result] = sorted[k];
+      }
+   }
+   return result + 1;
+}
+
+/// Compress the collected centroids back into the digest and clear its buffer.
+void compress(Digest& digest, CentroidBuffer& centroids, size_t count) {
+   std::sort(centroids.begin(), centroids.begin() + count, [](const Centroid& lhs, const Centroid& rhs) {
+      return lhs.mean < rhs.mean;
+   });
+   double total = 0.0;
+   for (size_t k = 0; k < count; ++k) {
+      total += centroids[k].weight;
+   }
+   // Tighten the size limit until the centroids fit into the digest.
+   CentroidBuffer compressed;
+   double compression = max_centroids;
+   size_t result = compressWith(centroids.data(), count, total, compression, compressed.data());
+   while (result > max_centroids) {
+      compression /= 2;
+      result = compressWith(centroids.data(), count, total, compression, compressed.data());
+   }
+   for (size_t k = 0; k < result; ++k) {
+      digest.means[k] = compressed[k].mean;
+      digest.weights[k] = compressed[k].weight;
+   }
+   digest.num_centroids = result;
+   digest.num_buffered = 0;
+}
+
+}
+
+void add(char* state, double value) {
+   Digest& digest = *reinterpret_cast<Digest*>(state);
+   if (empty(digest)) {
+      digest.min = value;
+      digest.max = value;
+   } else {
+      digest.min = std::min(digest.min, value);
+      digest.max = std::max(digest.max, value);
+   }
+   digest.buffer[digest.num_buffered++] = value;
+   if (digest.num_buffered == buffer_size) [[unlikely]] {
+      CentroidBuffer centroids;
+      size_t count = 0;
+      collect(digest, centroids, count);
+      compress(digest, centroids, count);
+   }
+}
+
+void merge(char* target, const char* source) {
+   Digest& target_digest = *reinterpret_cast<Digest*>(target);
+   const Digest& source_digest = *reinterpret_cast<const Digest*>(source);
+   if (empty(source_digest)) {
+      return;
+   }
+   if (empty(target_digest)) {
+      std::memcpy(target, source, state_size);
+      return;
+   }
+   target_digest.min = std::min(target_digest.min, source_digest.min);
+   target_digest.max = std::max(target_digest.max, source_digest.max);
+   CentroidBuffer centroids;
+   size_t count = 0;
+   collect(target_digest, centroids, count);
+   collect(source_digest, centroids, count);
+   compress(target_digest, centroids, count);
+}
+
+double quantile(const char* state, double q) {
+   Digest digest;
+   std::memcpy(&digest, state, state_size);
+   if (empty(digest)) {
+      return 0.0;
+   }
+   CentroidBuffer centroids;
+   size_t count = 0;
+   collect(digest, centroids, count);
+   compress(digest, centroids, count);
+
+   double total = 0.0;
+   for (uint32_t k = 0; k < digest.num_centroids; ++k) {
+      total += digest.weights[k];
+   }
+   // Every centroid sits at the middle of the rank range it covers, interpolate between them.
+   // The minimum and maximum bound the interpolation at the tails.
+   const double rank = q * total;
+   const uint32_t last = digest.num_centroids - 1;
+   if (rank <= digest.weights[0] / 2) {
+      return digest.min + (digest.means[0] - digest.min) * rank / (digest.weights[0] / 2);
+   }
+   if (rank >= total - digest.weights[last] / 2) {
+      const double tail = total - rank;
+      return digest.max - (digest.max - digest.means[last]) * tail / (digest.weights[last] / 2);
+   }
+   double mid = digest.weights[0] / 2;
+   for (uint32_t k = 0; k < last; ++k) {
+      const double next_mid = mid + (digest.weights[k] + digest.weights[k + 1]) / 2;
+      if (rank <= next_mid) {
+         return digest.means[k] + (digest.means[k + 1] - digest.means[k]) * (rank - mid) / (next_mid - mid);
+      }
+      mid = next_mid;
+   }
+   return digest.max;
+}
+
+}
+
+}
@@ -0,0 +1,63 @@
+#ifndef INKFUSE_QUANTILES_H
+#define INKFUSE_QUANTILES_H
+
+#include <cstddef>
+#include <cstdint>
+
+namespace inkfuse {
+
+/// Exact medians over the values of a group. The aggregate state is a single pointer to a
+/// list of value chunks, allocated through inkfuse_malloc in the memory context of the pipeline.
+/// A zero pointer is an empty list, so the state needs no initialization. The chunks stay alive
+/// until the query is done, merging splices the chunk lists of two groups without copying.
+namespace ExactQuantile {
+
+/// Size of the aggregate state.
+constexpr size_t state_size = sizeof(void*);
+
+/// Add a value to the group.
+void add(char* state, double value);
+/// Merge the values of the source group into the target group.
+void merge(char* target, const char* source);
+/// Compute the median of the group. Averages the two middle values for even counts.
+/// Empty groups produce 0, the aggregation reports them as NULL through the count of non-NULL inputs.
+double median(const char* state);
+
+}
+
+/// Merging t-digest over the values of a group. The digest is a fixed-size structure that lives
+/// directly in the aggregation payload and can be merged with other digests. Zeroed memory is an
+/// empty digest. Values are buffered and compressed into centroids once the buffer is full.
+namespace TDigest {
+
+/// Maximum number of centroids kept in a digest.
+constexpr size_t max_centroids = 64;
+/// Number of values buffered before compressing.
+constexpr size_t buffer_size = 32;
+
+struct Digest {
+   uint32_t num_centroids;
+   uint32_t num_buffered;
+   double min;
+   double max;
+   double means[max_centroids];
+   double weights[max_centroids];
+   double buffer[buffer_size];
+};
+
+/// Size of the aggregate state.
+constexpr size_t state_size = sizeof(Digest);
+
+/// Add a value to the digest.
+void add(char* digest, double value);
+/// Merge the source digest into the target digest.
+void merge(char* target, const char* source);
+/// Estimate the quantile q in [0, 1] of the values added to the digest.
+/// Empty digests produce 0, the aggregation reports them as NULL through the count of non-NULL inputs.
+double quantile(const char* digest, double q);
+
+}
+
+}
+
+#endif //INKFUSE_QUANTILES_H
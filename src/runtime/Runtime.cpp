@@ -2,6 +2,7 @@
 #include "algebra/suboperators/IndexedIUProvider.h"
 #include "algebra/suboperators/LoopDriver.h"
 #include "algebra/suboperators/RuntimeFunctionSubop.h"
+#include "algebra/suboperators/TopKThresholdSubop.h"
 #include "algebra/suboperators/expressions/RuntimeExpressionSubop.h"
 #include "algebra/suboperators/row_layout/KeyPackingRuntimeState.h"
 #include "algebra/suboperators/sinks/CountingSink.h"
@@ -24,11 +25,16 @@ GlobalRuntime::GlobalRuntime() : program(std::make_unique<IR::Program>("global_r
    CountingSink::registerRuntime();
    RuntimeExpressionSubop::registerRuntime();
    RuntimeFunctionSubop::registerRuntime();
+   TopKThresholdSubop::registerRuntime();
    // Register the actual inkfuse runtime functions.
    HashTableRuntime::registerRuntime();
    MemoryRuntime::registerRuntime();
    HashTableSourceState::registerRuntime();
    TupleMaterializerRuntime::registerRuntime();
+   HyperLogLogRuntime::registerRuntime();
+   QuantileRuntime::registerRuntime();
+   TopKRuntime::registerRuntime();
+   GroupJoinRuntime::registerRuntime();
 }
 
 RuntimeStructBuilder::~RuntimeStructBuilder() {
@@ -0,0 +1,319 @@
+#include "runtime/Sorter.h"
+#include <algorithm>
+#include <cassert>
+#include <cstring>
+#include <stdexcept>
+
+namespace inkfuse {
+
+namespace {
+
+/// Batch size for normalizing keys column-at-a-time.
+const size_t NORMALIZE_BATCH_SIZE = 256;
+
+/// Load an unsigned value of the given width.
+uint64_t loadUnsigned(const char* ptr, size_t width) {
+   switch (width) {
+      case 1:
+         return *reinterpret_cast<const uint8_t*>(ptr);
+      case 2:
+         return *reinterpret_cast<const uint16_t*>(ptr);
+      case 4:
+         return *reinterpret_cast<const uint32_t*>(ptr);
+      default:
+         return *reinterpret_cast<const uint64_t*>(ptr);
+   }
+}
+
+/// Load a signed value of the given width.
+int64_t loadSigned(const char* ptr, size_t width) {
+   switch (width) {
+      case 1:
+         return *reinterpret_cast<const int8_t*>(ptr);
+      case 2:
+         return *reinterpret_cast<const int16_t*>(ptr);
+      case 4:
+         return *reinterpret_cast<const int32_t*>(ptr);
+      default:
+         return *reinterpret_cast<const int64_t*>(ptr);
+   }
+}
+
+/// Store the lower `width` bytes of the value in big-endian order.
+void storeBigEndian(uint64_t value, size_t width, char* out) {
+   for (size_t byte = 0; byte < width; ++byte) {
+      out[byte] = static_cast<char>(value >> (8 * (width - 1 - byte)));
+   }
+}
+
+template <class T>
+int compareValues(T lhs, T rhs) {
+   return (lhs > rhs) - (lhs < rhs);
+}
+
+}
+
+int compareSortRows(const std::vector<SortKey>& keys, const char* lhs, const char* rhs) {
+   for (const auto& key : keys) {
+      int res = 0;
+      const bool lhs_null = key.null_offset && lhs[*key.null_offset];
+      const bool rhs_null = key.null_offset && rhs[*key.null_offset];
+      if (lhs_null || rhs_null) {
+         res = lhs_null - rhs_null;
+      } else {
+         const char* lhs_val = lhs + key.offset;
+         const char* rhs_val = rhs + key.offset;
+         switch (key.kind) {
+            case SortKey::Kind::Unsigned:
+               res = compareValues(loadUnsigned(lhs_val, key.width), loadUnsigned(rhs_val, key.width));
+               break;
+            case SortKey::Kind::Signed:
+               res = compareValues(loadSigned(lhs_val, key.width), loadSigned(rhs_val, key.width));
+               break;
+            case SortKey::Kind::Float:
+               if (key.width == 4) {
+                  res = compareValues(*reinterpret_cast<const float*>(lhs_val), *reinterpret_cast<const float*>(rhs_val));
+               } else {
+                  res = compareValues(*reinterpret_cast<const double*>(lhs_val), *reinterpret_cast<const double*>(rhs_val));
+               }
+               break;
+            case SortKey::Kind::String:
+               res = std::strcmp(*reinterpret_cast<char* const*>(lhs_val), *reinterpret_cast<char* const*>(rhs_val));
+               break;
+         }
+      }
+      if (res != 0) {
+         return key.ascending ? res : -res;
+      }
+   }
+   return 0;
+}
+
+Sorter::Sorter(std::vector<SortKey> keys_, size_t row_size_) : keys(std::move(keys_)), row_size(row_size_) {
+   if (keys.empty()) {
+      throw std::runtime_error("Sorter needs at least one key");
+   }
+   // Keys after the first string can't be normalized, the prefix does not decide their order.
+   for (const auto& key : keys) {
+      num_normalized++;
+      norm_width += key.null_offset ? 1 : 0;
+      if (key.kind == SortKey::Kind::String) {
+         norm_width += STRING_PREFIX_SIZE;
+         needs_tiebreak = true;
+         break;
+      }
+      norm_width += key.width;
+   }
+}
+
+void Sorter::prepareRuns(size_t num_threads) {
+   runs.clear();
+   runs.resize(num_threads);
+}
+
+void Sorter::sortRun(size_t thread_id, TupleMaterializer::ReadHandle& handle) {
+   assert(thread_id < runs.size());
+   Run& run = runs[thread_id];
+   std::vector<char*> rows;
+   while (const TupleMaterializer::MatChunk* chunk = handle.pullChunk()) {
+      for (char* row = reinterpret_cast<char*>(chunk->data.get()); row < chunk->end_ptr; row += row_size) {
+         rows.push_back(row);
+      }
+   }
+
+   // Normalize the keys in batches.
+   run.keys = std::make_unique<char[]>(rows.size() * norm_width);
+   for (size_t batch_start = 0; batch_start < rows.size(); batch_start += NORMALIZE_BATCH_SIZE) {
+      const size_t batch_size = std::min(NORMALIZE_BATCH_SIZE, rows.size() - batch_start);
+      normalize(&rows[batch_start], batch_size, &run.keys[batch_start * norm_width]);
+   }
+
+   // Set up the entries with their inlined key prefixes.
+   const size_t prefix_width = std::min(norm_width, sizeof(uint64_t));
+   run.entries.resize(rows.size());
+   for (size_t idx = 0; idx < rows.size(); ++idx) {
+      const char* key = &run.keys[idx * norm_width];
+      uint64_t prefix = 0;
+      for (size_t byte = 0; byte < prefix_width; ++byte) {
+         prefix |= static_cast<uint64_t>(static_cast<uint8_t>(key[byte])) << (8 * (7 - byte));
+      }
+      run.entries[idx] = Entry{.prefix = prefix, .key = key, .row = rows[idx]};
+   }
+
+   std::sort(run.entries.begin(), run.entries.end(), [&](const Entry& lhs, const Entry& rhs) {
+      return less(lhs, rhs);
+   });
+}
+
+void Sorter::normalize(char* const* rows, size_t num_rows, char* out) const {
+   size_t key_offset = 0;
+   for (size_t key_idx = 0; key_idx < num_normalized; ++key_idx) {
+      const SortKey& key = keys[key_idx];
+      const size_t col_start = key_offset;
+      if (key.null_offset) {
+         // The NULL byte goes first, this way NULLs end up after all other values.
+         for (size_t row = 0; row < num_rows; ++row) {
+            out[row * norm_width + key_offset] = rows[row][*key.null_offset] != 0;
+         }
+         key_offset++;
+      }
+      const size_t value_width = key.kind == SortKey::Kind::String ? STRING_PREFIX_SIZE : key.width;
+      switch (key.kind) {
+         case SortKey::Kind::Unsigned:
+            for (size_t row = 0; row < num_rows; ++row) {
+               storeBigEndian(loadUnsigned(rows[row] + key.offset, key.width), key.width, &out[row * norm_width + key_offset]);
+            }
+            break;
+         case SortKey::Kind::Signed: {
+            // Flipping the sign bit orders negative values before positive ones.
+            const uint64_t sign_bit = 1ull << (8 * key.width - 1);
+            for (size_t row = 0; row < num_rows; ++row) {
+               storeBigEndian(loadUnsigned(rows[row] + key.offset, key.width) ^ sign_bit, key.width, &out[row * norm_width + key_offset]);
+            }
+            break;
+         }
+         case SortKey::Kind::Float: {
+            // Negative floats have all bits flipped, positive ones only the sign bit.
+            const uint64_t sign_bit = 1ull << (8 * key.width - 1);
+            const uint64_t all_bits = key.width == 8 ? ~0ull : (sign_bit << 1) - 1;
+            for (size_t row = 0; row < num_rows; ++row) {
+               const uint64_t bits = loadUnsigned(rows[row] + key.offset, key.width);
+               storeBigEndian((bits & sign_bit) ? (bits ^ all_bits) : (bits | sign_bit), key.width, &out[row * norm_width + key_offset]);
+            }
+            break;
+         }
+         case SortKey::Kind::String:
+            for (size_t row = 0; row < num_rows; ++row) {
+               const char* str = *reinterpret_cast<char* const*>(rows[row] + key.offset);
+               char* dst = &out[row * norm_width + key_offset];
+               // Zero-padded prefix. The tiebreak resolves strings with the same prefix.
+               size_t len = 0;
+               for (; len < STRING_PREFIX_SIZE && str[len] != 0; ++len) {
+                  dst[len] = str[len];
+               }
+               std::memset(dst + len, 0, STRING_PREFIX_SIZE - len);
+            }
+            break;
+      }
+      if (key.null_offset) {
+         // The value of NULL rows is undefined. Zero it, this way all NULLs compare equal.
+         for (size_t row = 0; row < num_rows; ++row) {
+            char* dst = &out[row * norm_width + key_offset];
+            if (dst[-1]) {
+               std::memset(dst, 0, value_width);
+            }
+         }
+      }
+      key_offset += value_width;
+      if (!key.ascending) {
+         for (size_t row = 0; row < num_rows; ++row) {
+            for (size_t byte = col_start; byte < key_offset; ++byte) {
+               out[row * norm_width + byte] = ~out[row * norm_width + byte];
+            }
+         }
+      }
+   }
+   assert(key_offset == norm_width);
+}
+
+bool Sorter::less(const Entry& lhs, const Entry& rhs) const {
+   if (lhs.prefix != rhs.prefix) {
+      return lhs.prefix < rhs.prefix;
+   }
+   if (norm_width > sizeof(uint64_t)) {
+      if (int res = std::memcmp(lhs.key + sizeof(uint64_t), rhs.key + sizeof(uint64_t), norm_width - sizeof(uint64_t))) {
+         return res < 0;
+      }
+   }
+   return needs_tiebreak && compareSortRows(keys, lhs.row, rhs.row) < 0;
+}
+
+void Sorter::prepareMerge(size_t num_partitions) {
+   assert(num_partitions > 0);
+   size_t total_rows = 0;
+   for (const auto& run : runs) {
+      total_rows += run.entries.size();
+   }
+   sorted_rows.resize(total_rows);
+   sorted_data = reinterpret_cast<char*>(sorted_rows.data());
+
+   // Sample splitters from the runs. Every non-empty run contributes num_partitions - 1 samples.
+   std::vector<Entry> samples;
+   for (const auto& run : runs) {
+      for (size_t part = 1; part < num_partitions && !run.entries.empty(); ++part) {
+         samples.push_back(run.entries[(part * run.entries.size()) / num_partitions]);
+      }
+   }
+   auto cmp = [&](const Entry& lhs, const Entry& rhs) {
+      return less(lhs, rhs);
+   };
+   std::sort(samples.begin(), samples.end(), cmp);
+
+   // Find the partition bounds in every run.
+   partition_bounds.assign(num_partitions + 1, std::vector<size_t>(runs.size(), 0));
+   for (size_t run_idx = 0; run_idx < runs.size(); ++run_idx) {
+      const auto& entries = runs[run_idx].entries;
+      for (size_t part = 1; part < num_partitions; ++part) {
+         if (samples.empty()) {
+            partition_bounds[part][run_idx] = entries.size();
+            continue;
+         }
+         const Entry& splitter = samples[(part * samples.size()) / num_partitions];
+         partition_bounds[part][run_idx] = std::lower_bound(entries.begin(), entries.end(), splitter, cmp) - entries.begin();
+      }
+      partition_bounds[num_partitions][run_idx] = entries.size();
+   }
+
+   // And where the partitions go within the result.
+   partition_offsets.assign(num_partitions, 0);
+   for (size_t part = 1; part < num_partitions; ++part) {
+      partition_offsets[part] = partition_offsets[part - 1];
+      for (size_t run_idx = 0; run_idx < runs.size(); ++run_idx) {
+         partition_offsets[part] += partition_bounds[part][run_idx] - partition_bounds[part - 1][run_idx];
+      }
+   }
+}
+
+void Sorter::mergePartition(size_t partition) {
+   assert(partition < partition_offsets.size());
+   char** out = sorted_rows.data() + partition_offsets[partition];
+
+   // Cursor into the partition of a single run.
+   struct Cursor {
+      const Entry* curr;
+      const Entry* end;
+   };
+   std::vector<Cursor> heap;
+   for (size_t run_idx = 0; run_idx < runs.size(); ++run_idx) {
+      const Entry* entries = runs[run_idx].entries.data();
+      const size_t begin = partition_bounds[partition][run_idx];
+      const size_t end = partition_bounds[partition + 1][run_idx];
+      if (begin < end) {
+         heap.push_back(Cursor{entries + begin, entries + end});
+      }
+   }
+
+   // K-way merge through a min-heap on the current cursor entries.
+   auto heap_cmp = [&](const Cursor& lhs, const Cursor& rhs) {
+      return less(*rhs.curr, *lhs.curr);
+   };
+   std::make_heap(heap.begin(), heap.end(), heap_cmp);
+   while (heap.size() > 1) {
+      std::pop_heap(heap.begin(), heap.end(), heap_cmp);
+      Cursor& min = heap.back();
+      *out++ = min.curr->row;
+      if (++min.curr == min.end) {
+         heap.pop_back();
+      } else {
+         std::push_heap(heap.begin(), heap.end(), heap_cmp);
+      }
+   }
+   if (!heap.empty()) {
+      // Only a single run remains, copy it over.
+      for (const Entry* entry = heap[0].curr; entry != heap[0].end; ++entry) {
+         *out++ = entry->row;
+      }
+   }
+}
+
+}
@@ -0,0 +1,117 @@
+#ifndef INKFUSE_SORTER_H
+#define INKFUSE_SORTER_H
+
+#include "runtime/TupleMaterializer.h"
+#include <cstdint>
+#include <memory>
+#include <optional>
+#include <vector>
+
+namespace inkfuse {
+
+/// A sort key within the rows materialized for a sort.
+struct SortKey {
+   /// How the raw value has to be interpreted.
+   enum class Kind {
+      Unsigned,
+      Signed,
+      Float,
+      /// Pointer to a zero-terminated string.
+      String,
+   };
+
+   Kind kind;
+   /// Width of the value in bytes.
+   uint16_t width;
+   /// Offset of the value in the row.
+   uint16_t offset;
+   /// Offset of the NULL indicator byte in the row, if the key is nullable.
+   std::optional<uint16_t> null_offset = {};
+   /// Sort ascending? NULLs come last for ascending keys and first for descending ones.
+   bool ascending = true;
+};
+
+/// Compare two rows on their original key values. Returns a negative value if `lhs` comes first,
+/// a positive value if `rhs` comes first and zero if the rows are equal on all keys.
+int compareSortRows(const std::vector<SortKey>& keys, const char* lhs, const char* rhs);
+
+/// Parallel sorter over rows in thread-local TupleMaterializers. Sorting happens in two runtime tasks:
+/// 1. Every thread normalizes the keys of its own rows into memcmp-able byte strings and sorts them into a run.
+/// 2. The runs are split into key ranges through splitters sampled from the runs. Every thread merges
+///    one key range of all runs into its slice of the result.
+///
+/// Key normalization happens column-at-a-time on small batches of rows. Integers are stored big-endian
+/// with a flipped sign bit, floats get the usual sign-magnitude transformation. Strings contribute a
+/// prefix, keys after the first string are not normalized. If the normalized keys of two rows are equal
+/// and they contain a string prefix, the rows are compared on their original values.
+struct Sorter {
+   Sorter(std::vector<SortKey> keys_, size_t row_size_);
+
+   /// Number of string bytes that are part of the normalized key.
+   static constexpr size_t STRING_PREFIX_SIZE = 8;
+
+   /// Set up the runs for the given number of threads.
+   void prepareRuns(size_t num_threads);
+   /// Sort the rows of one TupleMaterializer into the run of the given thread.
+   void sortRun(size_t thread_id, TupleMaterializer::ReadHandle& handle);
+   /// Split the sorted runs into `num_partitions` key ranges that can be merged independently.
+   void prepareMerge(size_t num_partitions);
+   /// Merge the given key range of all runs into the sorted result.
+   void mergePartition(size_t partition);
+
+   /// Width of the normalized keys.
+   size_t normalizedWidth() const { return norm_width; };
+   /// The sorted rows. Populated once all partitions were merged.
+   const std::vector<char*>& getSortedRows() const { return sorted_rows; };
+   /// Pointer to the data of the sorted rows. Stable once the merge was prepared, the sort source reads from it.
+   char* const* getSortedData() const { return &sorted_data; };
+
+   private:
+   /// A row within a sorted run. The first eight bytes of the normalized key are
+   /// inlined as an integer, this way most comparisons never touch the key buffer.
+   struct Entry {
+      uint64_t prefix;
+      /// The full normalized key.
+      const char* key;
+      /// The materialized row.
+      char* row;
+   };
+
+   /// A sorted run of a single thread.
+   struct Run {
+      /// Buffer containing the normalized keys.
+      std::unique_ptr<char[]> keys;
+      std::vector<Entry> entries;
+   };
+
+   /// Normalize the keys of a batch of rows.
+   void normalize(char* const* rows, size_t num_rows, char* out) const;
+   /// Compare two entries - the actual sort order.
+   bool less(const Entry& lhs, const Entry& rhs) const;
+
+   /// The sort keys.
+   std::vector<SortKey> keys;
+   /// Size of the materialized rows.
+   size_t row_size;
+   /// How many keys take part in the normalized key?
+   size_t num_normalized = 0;
+   /// Width of the normalized key.
+   size_t norm_width = 0;
+   /// Do equal normalized keys have to be compared on the original rows?
+   bool needs_tiebreak = false;
+   /// The sorted runs, one per thread.
+   std::vector<Run> runs;
+   /// Bounds of the merge partitions in every run. partition_bounds[p][r] is the first
+   /// entry in run r belonging to partition p. Has num_partitions + 1 entries.
+   std::vector<std::vector<size_t>> partition_bounds;
+   /// Offset of every partition in the sorted result.
+   std::vector<size_t> partition_offsets;
+   /// The sorted rows.
+   std::vector<char*> sorted_rows;
+   /// Data pointer of `sorted_rows`.
+   char* sorted_data = nullptr;
+};
+
+}
+
+#endif //INKFUSE_SORTER_H
@@ -0,0 +1,84 @@
+#ifndef INKFUSE_TAGSCAN_H
+#define INKFUSE_TAGSCAN_H
+
+#include <bit>
+#include <cstddef>
+#include <cstdint>
+#ifdef __SSE2__
+#include <emmintrin.h>
+#endif
+
+/// Scanning of the tag arrays of the hash tables. Finds occupied slots 16 tags at a time
+/// instead of advancing slot by slot, which makes iterating over sparse hash tables cheap.
+namespace inkfuse::TagScan {
+
+/// A slot is occupied if (tag & mask) == value.
+struct Matcher {
+   uint8_t mask;
+   uint8_t value;
+};
+
+/// A morsel within a slot range.
+struct Morsel {
+   /// First occupied slot of the morsel, the end of the morsel if it is empty.
+   uint64_t first;
+   /// Slot behind the last occupied slot of the morsel.
+   uint64_t end;
+   /// Number of occupied slots within the morsel.
+   size_t rows;
+};
+
+/// Bitmask of the occupied slots among the min(16, end - pos) tags starting at pos.
+inline uint32_t occupied(const uint8_t* tags, Matcher matcher, uint64_t pos, uint64_t end) {
+#ifdef __SSE2__
+   if (pos + 16 <= end) [[likely]] {
+      const __m128i block = _mm_loadu_si128(reinterpret_cast<const __m128i*>(tags + pos));
+      const __m128i masked = _mm_and_si128(block, _mm_set1_epi8(static_cast<char>(matcher.mask)));
+      const __m128i match = _mm_cmpeq_epi8(masked, _mm_set1_epi8(static_cast<char>(matcher.value)));
+      return static_cast<uint32_t>(_mm_movemask_epi8(match));
+   }
+#endif
+   uint32_t result = 0;
+   for (uint64_t k = 0; k < 16 && pos + k < end; ++k) {
+      result |= static_cast<uint32_t>((tags[pos + k] & matcher.mask) == matcher.value) << k;
+   }
+   return result;
+}
+
+/// First occupied slot in [begin, end), or end if there is none.
+inline uint64_t next(const uint8_t* tags, Matcher matcher, uint64_t begin, uint64_t end) {
+   for (uint64_t pos = begin; pos < end; pos += 16) {
+      if (const uint32_t bits = occupied(tags, matcher, pos, end)) {
+         return pos + std::countr_zero(bits);
+      }
+   }
+   return end;
+}
+
+/// Find the next morsel of at most max_rows occupied slots in [begin, end).
+inline Morsel morsel(const uint8_t* tags, Matcher matcher, uint64_t begin, uint64_t end, size_t max_rows) {
+   Morsel result{.first = end, .end = end, .rows = 0};
+   for (uint64_t pos = begin; pos < end; pos += 16) {
+      uint32_t bits = occupied(tags, matcher, pos, end);
+      if (bits && result.rows == 0) {
+         result.first = pos + std::countr_zero(bits);
+      }
+      const auto found = static_cast<size_t>(std::popcount(bits));
+      if (result.rows + found < max_rows) {
+         result.rows += found;
+         continue;
+      }
+      // The morsel is full within this block, it ends behind the last slot that still fits.
+      for (; result.rows + 1 < max_rows; ++result.rows) {
+         bits &= bits - 1;
+      }
+      result.end = pos + std::countr_zero(bits) + 1;
+      result.rows = max_rows;
+      return result;
+   }
+   return result;
+}
+
+}
+
+#endif //INKFUSE_TAGSCAN_H
@@ -0,0 +1,146 @@
+#include "runtime/TopK.h"
+#include <algorithm>
+#include <cassert>
+#include <cstring>
+#include <limits>
+#include <stdexcept>
+
+namespace inkfuse {
+
+namespace {
+
+/// Store a value of type T in the lower bytes of the threshold.
+template <class T>
+uint64_t asThreshold(T value) {
+   uint64_t res = 0;
+   std::memcpy(&res, &value, sizeof(T));
+   return res;
+}
+
+/// The value of the key's type sorting last.
+template <class T>
+uint64_t lastValue(bool ascending) {
+   if constexpr (std::numeric_limits<T>::has_infinity) {
+      return asThreshold<T>(ascending ? std::numeric_limits<T>::infinity() : -std::numeric_limits<T>::infinity());
+   } else {
+      return asThreshold<T>(ascending ? std::numeric_limits<T>::max() : std::numeric_limits<T>::min());
+   }
+}
+
+/// Threshold letting every value of the given key pass.
+uint64_t initialThreshold(const SortKey& key) {
+   switch (key.kind) {
+      case SortKey::Kind::Unsigned:
+         switch (key.width) {
+            case 1:
+               return lastValue<uint8_t>(key.ascending);
+            case 2:
+               return lastValue<uint16_t>(key.ascending);
+            case 4:
+               return lastValue<uint32_t>(key.ascending);
+            default:
+               return lastValue<uint64_t>(key.ascending);
+         }
+      case SortKey::Kind::Signed:
+         switch (key.width) {
+            case 1:
+               return lastValue<int8_t>(key.ascending);
+            case 2:
+               return lastValue<int16_t>(key.ascending);
+            case 4:
+               return lastValue<int32_t>(key.ascending);
+            default:
+               return lastValue<int64_t>(key.ascending);
+         }
+      case SortKey::Kind::Float:
+         return key.width == 4 ? lastValue<float>(key.ascending) : lastValue<double>(key.ascending);
+      case SortKey::Kind::String:
+         // Strings never get a threshold filter.
+         return 0;
+   }
+   return 0;
+}
+
+}
+
+TopKHeap::TopKHeap(const std::vector<SortKey>& keys_, size_t row_size_, size_t k_)
+   : threshold(initialThreshold(keys_[0])), keys(keys_), row_size(row_size_), k(k_), data(std::make_unique<char[]>(k_ * row_size_)) {
+   heap.reserve(k);
+}
+
+bool TopKHeap::less(const char* lhs, const char* rhs) const {
+   return compareSortRows(keys, lhs, rhs) < 0;
+}
+
+void TopKHeap::insert(const char* row) {
+   auto cmp = [&](const char* lhs, const char* rhs) {
+      return less(lhs, rhs);
+   };
+   if (heap.size() < k) {
+      // Still filling up the heap.
+      char* slot = data.get() + heap.size() * row_size;
+      std::memcpy(slot, row, row_size);
+      heap.push_back(slot);
+      std::push_heap(heap.begin(), heap.end(), cmp);
+      if (heap.size() == k) {
+         updateThreshold();
+      }
+      return;
+   }
+   if (k == 0 || !less(row, heap.front())) {
+      return;
+   }
+   // Evict the last row and reuse its slot.
+   std::pop_heap(heap.begin(), heap.end(), cmp);
+   std::memcpy(heap.back(), row, row_size);
+   std::push_heap(heap.begin(), heap.end(), cmp);
+   updateThreshold();
+}
+
+void TopKHeap::updateThreshold() {
+   const SortKey& first = keys[0];
+   if (first.kind == SortKey::Kind::String) {
+      return;
+   }
+   // The value of a NULL first key is undefined. The threshold filter is only used on non-nullable keys.
+   threshold = 0;
+   std::memcpy(&threshold, heap.front() + first.offset, first.width);
+}
+
+TopK::TopK(std::vector<SortKey> keys_, size_t row_size_, size_t k_)
+   : keys(std::move(keys_)), row_size(row_size_), k(k_) {
+   if (keys.empty()) {
+      throw std::runtime_error("TopK needs at least one key");
+   }
+}
+
+void TopK::prepareHeaps(size_t num_threads) {
+   if (!heaps.empty()) {
+      // Both the threshold filter and the insert set up the heaps.
+      assert(heaps.size() == num_threads);
+      return;
+   }
+   for (size_t thread_id = 0; thread_id < num_threads; ++thread_id) {
+      heaps.emplace_back(keys, row_size, k);
+   }
+}
+
+TopKHeap& TopK::getHeap(size_t thread_id) {
+   assert(thread_id < heaps.size());
+   return heaps[thread_id];
+}
+
+void TopK::merge() {
+   sorted_rows.clear();
+   for (const auto& heap : heaps) {
+      sorted_rows.insert(sorted_rows.end(), heap.getRows().begin(), heap.getRows().end());
+   }
+   const size_t result_size = std::min(k, sorted_rows.size());
+   std::partial_sort(sorted_rows.begin(), sorted_rows.begin() + result_size, sorted_rows.end(), [&](const char* lhs, const char* rhs) {
+      return compareSortRows(keys, lhs, rhs) < 0;
+   });
+   sorted_rows.resize(result_size);
+   sorted_data = reinterpret_cast<char*>(sorted_rows.data());
+}
+
+}
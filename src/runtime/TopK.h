@@ -0,0 +1,83 @@
+#ifndef INKFUSE_TOPK_H
+#define INKFUSE_TOPK_H
+
+#include "runtime/Sorter.h"
+#include <cstdint>
+#include <deque>
+#include <memory>
+#include <vector>
+
+namespace inkfuse {
+
+/// Thread-local bounded heap keeping the first k rows in sort order. The heap is a max-heap on the
+/// sort order, its top is the row that gets evicted next.
+/// Once the heap is full, the first key of the top row becomes the threshold. Rows whose first key
+/// sorts behind the threshold can never make it into the heap, which allows the producing pipeline
+/// to reject them with a single comparison before packing them (see TopKThresholdSubop).
+struct TopKHeap {
+   TopKHeap(const std::vector<SortKey>& keys_, size_t row_size_, size_t k_);
+
+   /// Insert a packed row. The row is copied if it is among the first k rows seen so far.
+   void insert(const char* row);
+
+   /// The rows within the heap, in heap order.
+   const std::vector<char*>& getRows() const { return heap; };
+
+   /// Threshold on the first key. Contains a value of the first key's type in its lower bytes.
+   /// Before the heap is full this is the largest (ascending) or smallest (descending) value of the type.
+   uint64_t threshold = 0;
+
+   private:
+   /// Does `lhs` come before `rhs` in the sort order?
+   bool less(const char* lhs, const char* rhs) const;
+   /// Update the threshold from the top of the heap.
+   void updateThreshold();
+
+   /// The sort keys.
+   const std::vector<SortKey>& keys;
+   /// Size of the packed rows.
+   size_t row_size;
+   /// How many rows to keep.
+   size_t k;
+   /// Storage for the k rows.
+   std::unique_ptr<char[]> data;
+   /// Pointers into `data` forming the heap.
+   std::vector<char*> heap;
+};
+
+/// Top-K over the thread-local heaps of all threads. Once the producing pipeline is done,
+/// the heaps are merged into the final k rows in sort order.
+struct TopK {
+   TopK(std::vector<SortKey> keys_, size_t row_size_, size_t k_);
+
+   /// Set up the heaps for the given number of threads. Repeated calls keep the existing heaps.
+   void prepareHeaps(size_t num_threads);
+   /// Get the heap of the given thread.
+   TopKHeap& getHeap(size_t thread_id);
+
+   /// Merge the heaps of all threads into the sorted result.
+   void merge();
+
+   /// The first k rows in sort order. Populated once the heaps were merged.
+   const std::vector<char*>& getSortedRows() const { return sorted_rows; };
+   /// Pointer to the data of the sorted rows. Stable once the heaps were merged, the sort source reads from it.
+   char* const* getSortedData() const { return &sorted_data; };
+
+   private:
+   /// The sort keys.
+   std::vector<SortKey> keys;
+   /// Size of the packed rows.
+   size_t row_size;
+   /// How many rows to produce.
+   size_t k;
+   /// The thread-local heaps.
+   std::deque<TopKHeap> heaps;
+   /// The sorted rows.
+   std::vector<char*> sorted_rows;
+   /// Data pointer of `sorted_rows`.
+   char* sorted_data = nullptr;
+};
+
+}
+
+#endif //INKFUSE_TOPK_H
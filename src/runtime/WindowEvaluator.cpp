@@ -0,0 +1,258 @@
+#include "runtime/WindowEvaluator.h"
+#include "xxhash.h"
+#include <algorithm>
+#include <cassert>
+#include <cstring>
+#include <stdexcept>
+#include <type_traits>
+
+namespace inkfuse {
+
+namespace {
+
+/// Seed for the hash of NULL keys.
+const uint64_t NULL_KEY_HASH = 0x9e3779b97f4a7c15ull;
+
+/// Load the value of a sum argument as the accumulator type.
+template <class T>
+T loadValue(const char* ptr, const SortKey& arg) {
+   if constexpr (std::is_same_v<T, double>) {
+      if (arg.width == 4) {
+         float val;
+         std::memcpy(&val, ptr, 4);
+         return val;
+      }
+      double val;
+      std::memcpy(&val, ptr, 8);
+      return val;
+   } else {
+      switch (arg.width) {
+         case 1:
+            return static_cast<T>(*reinterpret_cast<const std::conditional_t<std::is_signed_v<T>, int8_t, uint8_t>*>(ptr));
+         case 2:
+            return static_cast<T>(*reinterpret_cast<const std::conditional_t<std::is_signed_v<T>, int16_t, uint16_t>*>(ptr));
+         case 4:
+            return static_cast<T>(*reinterpret_cast<const std::conditional_t<std::is_signed_v<T>, int32_t, uint32_t>*>(ptr));
+         default:
+            return *reinterpret_cast<const T*>(ptr);
+      }
+   }
+}
+
+/// Store an accumulated sum with the width of the argument.
+template <class T>
+void storeValue(char* ptr, T value, uint16_t width) {
+   if constexpr (std::is_same_v<T, double>) {
+      if (width == 4) {
+         const float val = static_cast<float>(value);
+         std::memcpy(ptr, &val, 4);
+         return;
+      }
+   }
+   // Integers are truncated to their lower bytes, the same way the sum aggregate wraps around.
+   std::memcpy(ptr, &value, width);
+}
+
+/// Segment tree answering sums over arbitrary ranges of a group in O(log n).
+template <class T>
+struct SegmentTree {
+   explicit SegmentTree(const std::vector<T>& values) : num_leaves(values.size()), tree(2 * values.size()) {
+      std::copy(values.begin(), values.end(), tree.begin() + num_leaves);
+      for (size_t node = num_leaves - 1; node > 0; --node) {
+         tree[node] = tree[2 * node] + tree[2 * node + 1];
+      }
+   }
+
+   /// Sum over the leaves [lo, hi).
+   T query(size_t lo, size_t hi) const {
+      T result{};
+      for (lo += num_leaves, hi += num_leaves; lo < hi; lo >>= 1, hi >>= 1) {
+         if (lo & 1) {
+            result += tree[lo++];
+         }
+         if (hi & 1) {
+            result += tree[--hi];
+         }
+      }
+      return result;
+   }
+
+   private:
+   size_t num_leaves;
+   /// Implicit binary tree, the leaves start at `num_leaves`.
+   std::vector<T> tree;
+};
+
+/// Evaluate a sum over the rows of one group, accumulating in T.
+template <class T>
+void evaluateSum(const WindowFunction& function, char** begin, char** end) {
+   const SortKey& arg = *function.arg;
+   const size_t num_rows = end - begin;
+   std::vector<T> values(num_rows);
+   // valid_prefix[k] is the number of non-NULL values in the first k rows.
+   std::vector<size_t> valid_prefix(num_rows + 1, 0);
+   for (size_t idx = 0; idx < num_rows; ++idx) {
+      const char* row = begin[idx];
+      const bool valid = !arg.null_offset || !row[*arg.null_offset];
+      values[idx] = valid ? loadValue<T>(row + arg.offset, arg) : T{};
+      valid_prefix[idx + 1] = valid_prefix[idx] + valid;
+   }
+
+   auto store = [&](size_t idx, T sum, size_t num_valid) {
+      char* row = begin[idx];
+      storeValue(row + function.result_offset, sum, arg.width);
+      if (function.result_null_offset) {
+         // The sum over a frame without any values is NULL.
+         row[*function.result_null_offset] = num_valid == 0;
+      }
+   };
+
+   if (!function.preceding) {
+      // Unbounded frame: a running prefix sum.
+      T running{};
+      for (size_t idx = 0; idx < num_rows; ++idx) {
+         running += values[idx];
+         store(idx, running, valid_prefix[idx + 1]);
+      }
+      return;
+   }
+   const size_t preceding = *function.preceding;
+   SegmentTree<T> tree(values);
+   for (size_t idx = 0; idx < num_rows; ++idx) {
+      const size_t frame_start = idx >= preceding ? idx - preceding : 0;
+      store(idx, tree.query(frame_start, idx + 1), valid_prefix[idx + 1] - valid_prefix[frame_start]);
+   }
+}
+
+}
+
+WindowEvaluator::WindowEvaluator(std::vector<SortKey> partition_keys_, std::vector<SortKey> order_keys_, std::vector<WindowFunction> functions_, size_t row_size_)
+   : partition_keys(std::move(partition_keys_)), order_keys(std::move(order_keys_)), functions(std::move(functions_)), row_size(row_size_) {
+   sort_keys = partition_keys;
+   sort_keys.insert(sort_keys.end(), order_keys.begin(), order_keys.end());
+   for (const auto& function : functions) {
+      if (function.kind == WindowFunction::Kind::Sum && (!function.arg || function.arg->kind == SortKey::Kind::String)) {
+         throw std::runtime_error("Window sum needs a numeric argument");
+      }
+   }
+}
+
+void WindowEvaluator::preparePartitioning(size_t num_threads) {
+   thread_partitions.clear();
+   thread_partitions.resize(num_threads, std::vector<std::vector<char*>>(NUM_PARTITIONS));
+}
+
+uint64_t WindowEvaluator::hashRow(const char* row) const {
+   uint64_t hash = 0;
+   for (const auto& key : partition_keys) {
+      if (key.null_offset && row[*key.null_offset]) {
+         // All NULLs end up in the same group.
+         hash = XXH3_64bits_withSeed(&NULL_KEY_HASH, sizeof(NULL_KEY_HASH), hash);
+      } else if (key.kind == SortKey::Kind::String) {
+         const char* str = *reinterpret_cast<char* const*>(row + key.offset);
+         hash = XXH3_64bits_withSeed(str, std::strlen(str), hash);
+      } else {
+         hash = XXH3_64bits_withSeed(row + key.offset, key.width, hash);
+      }
+   }
+   return hash;
+}
+
+void WindowEvaluator::partitionRows(size_t thread_id, TupleMaterializer::ReadHandle& handle) {
+   assert(thread_id < thread_partitions.size());
+   auto& partitions = thread_partitions[thread_id];
+   while (const TupleMaterializer::MatChunk* chunk = handle.pullChunk()) {
+      for (char* row = reinterpret_cast<char*>(chunk->data.get()); row < chunk->end_ptr; row += row_size) {
+         // Without PARTITION BY keys the whole input is a single group within the first partition.
+         const size_t partition = partition_keys.empty() ? 0 : hashRow(row) % NUM_PARTITIONS;
+         partitions[partition].push_back(row);
+      }
+   }
+}
+
+void WindowEvaluator::prepareEvaluation() {
+   partition_offsets.assign(NUM_PARTITIONS + 1, 0);
+   for (size_t partition = 0; partition < NUM_PARTITIONS; ++partition) {
+      partition_offsets[partition + 1] = partition_offsets[partition];
+      for (const auto& partitions : thread_partitions) {
+         partition_offsets[partition + 1] += partitions[partition].size();
+      }
+   }
+   rows.resize(partition_offsets.back());
+   row_data = reinterpret_cast<char*>(rows.data());
+   next_partition = 0;
+}
+
+void WindowEvaluator::evaluatePartitions() {
+   for (size_t partition = next_partition.fetch_add(1); partition < NUM_PARTITIONS; partition = next_partition.fetch_add(1)) {
+      // Gather the rows of the partition from all threads.
+      char** out = rows.data() + partition_offsets[partition];
+      for (auto& partitions : thread_partitions) {
+         out = std::copy(partitions[partition].begin(), partitions[partition].end(), out);
+         // The buffer is no longer needed.
+         std::vector<char*>().swap(partitions[partition]);
+      }
+      evaluatePartition(rows.data() + partition_offsets[partition], out);
+   }
+}
+
+void WindowEvaluator::evaluatePartition(char** begin, char** end) const {
+   if (!sort_keys.empty()) {
+      std::sort(begin, end, [&](const char* lhs, const char* rhs) {
+         return compareSortRows(sort_keys, lhs, rhs) < 0;
+      });
+   }
+   // Evaluate every PARTITION BY group on its own.
+   char** group_begin = begin;
+   while (group_begin != end) {
+      char** group_end = group_begin + 1;
+      while (group_end != end && compareSortRows(partition_keys, *group_begin, *group_end) == 0) {
+         group_end++;
+      }
+      for (const auto& function : functions) {
+         evaluateGroup(function, group_begin, group_end);
+      }
+      group_begin = group_end;
+   }
+}
+
+void WindowEvaluator::evaluateGroup(const WindowFunction& function, char** begin, char** end) const {
+   const size_t num_rows = end - begin;
+   switch (function.kind) {
+      case WindowFunction::Kind::RowNumber:
+         for (size_t idx = 0; idx < num_rows; ++idx) {
+            const int64_t row_number = idx + 1;
+            std::memcpy(begin[idx] + function.result_offset, &row_number, sizeof(int64_t));
+         }
+         break;
+      case WindowFunction::Kind::Rank: {
+         int64_t rank = 1;
+         for (size_t idx = 0; idx < num_rows; ++idx) {
+            if (idx > 0 && compareSortRows(order_keys, begin[idx - 1], begin[idx]) != 0) {
+               // A new peer group starts.
+               rank = idx + 1;
+            }
+            std::memcpy(begin[idx] + function.result_offset, &rank, sizeof(int64_t));
+         }
+         break;
+      }
+      case WindowFunction::Kind::Sum:
+         switch (function.arg->kind) {
+            case SortKey::Kind::Signed:
+               evaluateSum<int64_t>(function, begin, end);
+               break;
+            case SortKey::Kind::Unsigned:
+               evaluateSum<uint64_t>(function, begin, end);
+               break;
+            case SortKey::Kind::Float:
+               evaluateSum<double>(function, begin, end);
+               break;
+            case SortKey::Kind::String:
+               assert(false);
+               break;
+         }
+         break;
+   }
+}
+
+}
@@ -0,0 +1,97 @@
+#ifndef INKFUSE_WINDOWEVALUATOR_H
+#define INKFUSE_WINDOWEVALUATOR_H
+
+#include "runtime/Sorter.h"
+#include "runtime/TupleMaterializer.h"
+#include <atomic>
+#include <cstdint>
+#include <optional>
+#include <vector>
+
+namespace inkfuse {
+
+/// A window function evaluated over the rows materialized for a window operator.
+/// The result is written into the materialized row.
+struct WindowFunction {
+   enum class Kind {
+      /// Position of the row within its partition, starting at 1.
+      RowNumber,
+      /// Position of the first row with the same ORDER BY values, starting at 1.
+      Rank,
+      /// Sum of the argument over the frame ROWS BETWEEN `preceding` PRECEDING AND CURRENT ROW.
+      Sum,
+   };
+
+   Kind kind;
+   /// Sum: the argument within the row. Described as a sort key, only its kind, width and offsets are used.
+   std::optional<SortKey> arg = {};
+   /// Sum: number of rows preceding the current one in the frame. Unbounded if not set.
+   std::optional<size_t> preceding = {};
+   /// Offset of the result in the row. Ranking functions produce an int64_t, sums the type of the argument.
+   uint16_t result_offset = 0;
+   /// Offset of the NULL indicator of the result, if the result is nullable.
+   std::optional<uint16_t> result_null_offset = {};
+};
+
+/// Parallel evaluation of window functions over rows in thread-local TupleMaterializers. Evaluation happens
+/// in two runtime tasks:
+/// 1. Every thread hash-partitions its own rows on the PARTITION BY keys into thread-local partition buffers.
+/// 2. The hash partitions become morsels that the threads claim atomically. A thread gathers the rows of the
+///    partition from all thread-local buffers, sorts them on the PARTITION BY and ORDER BY keys and evaluates
+///    the window functions on every PARTITION BY group.
+///
+/// Running sums over an unbounded frame are prefix sums. Sums over a bounded frame are answered through
+/// a segment tree over the group, this way wide frames don't cost more than narrow ones.
+struct WindowEvaluator {
+   WindowEvaluator(std::vector<SortKey> partition_keys_, std::vector<SortKey> order_keys_, std::vector<WindowFunction> functions_, size_t row_size_);
+
+   /// Number of hash partitions. Every partition is a morsel of the evaluation.
+   static constexpr size_t NUM_PARTITIONS = 256;
+
+   /// Set up the thread-local partition buffers for the given number of threads.
+   void preparePartitioning(size_t num_threads);
+   /// Hash-partition the rows of one TupleMaterializer into the buffers of the given thread.
+   void partitionRows(size_t thread_id, TupleMaterializer::ReadHandle& handle);
+   /// Lay out the partitions within the result. Afterwards the partitions can be claimed.
+   void prepareEvaluation();
+   /// Claim and evaluate partitions until all of them were evaluated.
+   void evaluatePartitions();
+
+   /// The evaluated rows, every partition is sorted. Populated once all partitions were evaluated.
+   const std::vector<char*>& getRows() const { return rows; };
+   /// Pointer to the data of the evaluated rows. Stable once the evaluation was prepared, the window source reads from it.
+   char* const* getRowData() const { return &row_data; };
+
+   private:
+   /// Hash the PARTITION BY keys of a row.
+   uint64_t hashRow(const char* row) const;
+   /// Sort a partition and evaluate the window functions on it.
+   void evaluatePartition(char** begin, char** end) const;
+   /// Evaluate a single function on one PARTITION BY group.
+   void evaluateGroup(const WindowFunction& function, char** begin, char** end) const;
+
+   /// The PARTITION BY keys.
+   std::vector<SortKey> partition_keys;
+   /// The ORDER BY keys.
+   std::vector<SortKey> order_keys;
+   /// PARTITION BY keys followed by the ORDER BY keys - the order within a hash partition.
+   std::vector<SortKey> sort_keys;
+   /// The window functions.
+   std::vector<WindowFunction> functions;
+   /// Size of the materialized rows.
+   size_t row_size;
+   /// The thread-local partition buffers. thread_partitions[t][p] contains the rows of thread t in partition p.
+   std::vector<std::vector<std::vector<char*>>> thread_partitions;
+   /// Offset of every partition in the result. Has NUM_PARTITIONS + 1 entries.
+   std::vector<size_t> partition_offsets;
+   /// The next partition that can be claimed.
+   std::atomic<size_t> next_partition = 0;
+   /// The evaluated rows.
+   std::vector<char*> rows;
+   /// Data pointer of `rows`.
+   char* row_data = nullptr;
+};
+
+}
+
+#endif //INKFUSE_WINDOWEVALUATOR_H
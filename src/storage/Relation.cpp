@@ -1,6 +1,12 @@
 #include "storage/Relation.h"
 #include "common/Helpers.h"
+#include "common/Numa.h"
+#include <algorithm>
+#include <cassert>
 #include <cstring>
+#include <limits>
+#include <sys/mman.h>
+#include <unistd.h>
 
 namespace inkfuse {
 
@@ -25,6 +31,33 @@ void loadUint(char* dest, const char* str) {
    *reinterpret_cast<T*>(dest) = val;
 }
 
+/// Compute the value range over the non-NULL rows of a column.
+template <std::integral T>
+std::optional<ValueRange> scanValueRange(const BaseColumn& col, const char* data, size_t rows) {
+   std::optional<T> min;
+   std::optional<T> max;
+   const bool check_null = col.nullCount() != 0;
+   for (size_t row = 0; row < rows; ++row) {
+      if (check_null && col.isNull(row)) {
+         continue;
+      }
+      T val;
+      std::memcpy(&val, data + row * sizeof(T), sizeof(T));
+      min = min ? std::min(*min, val) : val;
+      max = max ? std::max(*max, val) : val;
+   }
+   if (!min) {
+      return {};
+   }
+   if constexpr (std::is_same_v<T, uint64_t>) {
+      if (*max > static_cast<uint64_t>(std::numeric_limits<int64_t>::max())) {
+         // The values don't fit the range.
+         return {};
+      }
+   }
+   return ValueRange{.min = static_cast<int64_t>(*min), .max = static_cast<int64_t>(*max)};
+}
+
 void loadFloat(char* dest, const char* str) {
    auto val = std::stof(str);
    *reinterpret_cast<float*>(dest) = val;
@@ -41,13 +74,115 @@ void loadChar(char* dest, const char* str) {
 
 }
 
+NumaPlacedBuffer::NumaPlacedBuffer(const char* src, size_t width, const std::vector<RowSegment>& segments)
+   : num_rows(segments.empty() ? 0 : segments.back().end) {
+   const size_t page_size = sysconf(_SC_PAGESIZE);
+   // Round up to full pages, we need at least one page for mmap to succeed.
+   mapped_bytes = std::max(page_size, ((num_rows * width + page_size - 1) / page_size) * page_size);
+   // Mapping does not touch the pages yet - they get placed on the node of the first writer.
+   void* res = mmap(nullptr, mapped_bytes, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+   if (res == MAP_FAILED) {
+      throw std::runtime_error("Could not map NUMA placed column memory");
+   }
+   mem = static_cast<char*>(res);
+   std::vector<size_t> nodes;
+   std::vector<std::function<void()>> copies;
+   for (const auto& segment : segments) {
+      nodes.push_back(segment.node);
+      copies.push_back([this, src, width, segment]() {
+         std::memcpy(mem + segment.begin * width, src + segment.begin * width, (segment.end - segment.begin) * width);
+      });
+   }
+   numa::runOnNodes(nodes, copies);
+}
+
+NumaPlacedBuffer::~NumaPlacedBuffer() {
+   munmap(mem, mapped_bytes);
+}
+
 BaseColumn::BaseColumn(bool nullable_) : nullable(nullable_) {
 }
 
-bool BaseColumn::isNullable() {
+bool BaseColumn::isNullable() const {
    return nullable;
 }
 
+void BaseColumn::loadNull() {
+   if (!nullable) {
+      throw std::runtime_error("Cannot load NULL into a non-nullable column");
+   }
+   const size_t row = length();
+   const size_t word = row / 64;
+   if (validity.size() <= word) {
+      validity.resize(word + 1, ~0ull);
+   }
+   validity[word] &= ~(1ull << (row % 64));
+   null_count++;
+   loadDefault();
+}
+
+size_t BaseColumn::nullCount() const {
+   return null_count;
+}
+
+bool BaseColumn::isNull(size_t row) const {
+   const size_t bulk_rows = length();
+   if (row >= bulk_rows) {
+      // Appended row, look at the segment's indicators.
+      const auto& segment = segments.at((row - bulk_rows) / StoredRelation::APPEND_SEGMENT_SIZE);
+      const size_t idx = (row - bulk_rows) % StoredRelation::APPEND_SEGMENT_SIZE;
+      return segment.validity && !((segment.validity[idx / 64] >> (idx % 64)) & 1);
+   }
+   const size_t word = row / 64;
+   return word < validity.size() && !((validity[word] >> (row % 64)) & 1);
+}
+
+char* BaseColumn::getBlockData(size_t block) {
+   if (block == 0) {
+      return getRawData();
+   }
+   assert(block <= segments.size());
+   return segments[block - 1].data.get();
+}
+
+uint64_t* BaseColumn::getBlockValidity(size_t block) {
+   if (block == 0) {
+      // Materialize the implicitly valid words at the end, scans must not read beyond the bitmap.
+      validity.resize((length() + 63) / 64, ~0ull);
+      return validity.data();
+   }
+   assert(block <= segments.size());
+   if (uint64_t* bits = segments[block - 1].validity.get()) {
+      return bits;
+   }
+   // Segments without NULLs all share the same fully valid bitmap.
+   static const std::vector<uint64_t> all_valid(StoredRelation::APPEND_SEGMENT_SIZE / 64, ~0ull);
+   return const_cast<uint64_t*>(all_valid.data());
+}
+
+void BaseColumn::allocateSegment() {
+   // Value-initialized, the values of NULL rows default to zero.
+   segments.push_back(Segment{
+      .data = std::make_unique<char[]>(StoredRelation::APPEND_SEGMENT_SIZE * valueWidth()),
+   });
+}
+
+void BaseColumn::appendValue(size_t idx, const char* str, uint32_t strLen) {
+   storeValue(segments.back().data.get() + idx * valueWidth(), str, strLen);
+}
+
+void BaseColumn::appendNull(size_t idx) {
+   if (!nullable) {
+      throw std::runtime_error("Cannot load NULL into a non-nullable column");
+   }
+   auto& segment = segments.back();
+   assert(segment.validity);
+   // Concurrent scans read the word, only the bit of the unpublished row changes.
+   std::atomic_ref(segment.validity[idx / 64]).fetch_and(~(1ull << (idx % 64)), std::memory_order_relaxed);
+   storeDefault(segment.data.get() + idx * valueWidth());
+   null_count++;
+}
+
 PODColumn::PODColumn(IR::TypeArc type_, bool nullable_)
    : BaseColumn(nullable_), type(std::move(type_)) {
    // Reserve 5 MB of data.
@@ -100,6 +235,16 @@ PODColumn::PODColumn(IR::TypeArc type_, bool nullable_)
          default:
             throw std::runtime_error("Unsupported width for loading floating points");
       }
+   } else if (auto decimal = dynamic_cast<IR::Decimal*>(type.get())) {
+      // Decimals are stored scaled, the loader needs precision and scale.
+      load_val = [precision = decimal->getPrecision(), scale = decimal->getScale(), width = decimal->numBytes()](char* dest, const char* str) {
+         const __int128 val = helpers::decimalStrToInt(str, precision, scale);
+         if (width == 8) {
+            *reinterpret_cast<int64_t*>(dest) = static_cast<int64_t>(val);
+         } else {
+            std::memcpy(dest, &val, sizeof(val));
+         }
+      };
    } else if (dynamic_cast<IR::Char*>(type.get())) {
       load_val = loadChar;
    } else {
@@ -109,11 +254,24 @@ PODColumn::PODColumn(IR::TypeArc type_, bool nullable_)
 
 size_t PODColumn::length() const
 {
+   if (placed) {
+      return placed->rows();
+   }
    return storage.size() / type->numBytes();
 }
 
+void PODColumn::placeSegments(const std::vector<RowSegment>& segments) {
+   assert(segments.empty() || segments.back().end == length());
+   placed = std::make_unique<NumaPlacedBuffer>(storage.data(), type->numBytes(), segments);
+   // Release the old storage, it was allocated wherever the loading thread ran.
+   std::vector<char>().swap(storage);
+}
+
 void PODColumn::loadValue(const char* str, uint32_t strlen)
 {
+   if (placed) {
+      throw std::runtime_error("Cannot load values into a NUMA placed column");
+   }
    // Make sure we have enough space in the backing storage.
    storage.resize(storage_offset + type->numBytes());
    // Load the value - the loading function was resolved in the constructor.
@@ -122,7 +280,77 @@ void PODColumn::loadValue(const char* str, uint32_t strlen)
    storage_offset += type->numBytes();
 }
 
+void PODColumn::invalidateRange() {
+   std::unique_lock lock(range_latch);
+   cached_range.reset();
+}
+
+std::optional<ValueRange> PODColumn::valueRange() const {
+   const size_t rows = length();
+   std::unique_lock lock(range_latch);
+   if (cached_range && cached_range->first == rows) {
+      return cached_range->second;
+   }
+   const char* data = placed ? placed->data() : storage.data();
+   std::optional<ValueRange> range;
+   if (dynamic_cast<IR::Date*>(type.get())) {
+      range = scanValueRange<int32_t>(*this, data, rows);
+   } else if (dynamic_cast<IR::SignedInt*>(type.get())) {
+      switch (type->numBytes()) {
+         case 1:
+            range = scanValueRange<int8_t>(*this, data, rows);
+            break;
+         case 2:
+            range = scanValueRange<int16_t>(*this, data, rows);
+            break;
+         case 4:
+            range = scanValueRange<int32_t>(*this, data, rows);
+            break;
+         case 8:
+            range = scanValueRange<int64_t>(*this, data, rows);
+            break;
+      }
+   } else if (dynamic_cast<IR::UnsignedInt*>(type.get())) {
+      switch (type->numBytes()) {
+         case 1:
+            range = scanValueRange<uint8_t>(*this, data, rows);
+            break;
+         case 2:
+            range = scanValueRange<uint16_t>(*this, data, rows);
+            break;
+         case 4:
+            range = scanValueRange<uint32_t>(*this, data, rows);
+            break;
+         case 8:
+            range = scanValueRange<uint64_t>(*this, data, rows);
+            break;
+      }
+   }
+   cached_range.emplace(rows, range);
+   return range;
+}
+
+void PODColumn::storeValue(char* dest, const char* str, uint32_t strLen) {
+   load_val(dest, str);
+}
+
+void PODColumn::storeDefault(char* dest) {
+   std::memset(dest, 0, type->numBytes());
+}
+
+void PODColumn::loadDefault() {
+   if (placed) {
+      throw std::runtime_error("Cannot load values into a NUMA placed column");
+   }
+   // Resizing value-initializes, NULLs are represented as zero.
+   storage.resize(storage_offset + type->numBytes());
+   storage_offset += type->numBytes();
+}
+
 void StringColumn::loadValue(const char* str, uint32_t strLen) {
+   if (placed) {
+      throw std::runtime_error("Cannot load values into a NUMA placed column");
+   }
    // Need the zero byte at the end of the string - this is not part of the input file.
    auto elem = reinterpret_cast<char*>(storage.alloc(strLen + 1));
    // Copy over the string.
@@ -132,6 +360,34 @@ void StringColumn::loadValue(const char* str, uint32_t strLen) {
    offsets.push_back(elem);
 }
 
+void StringColumn::loadDefault() {
+   if (placed) {
+      throw std::runtime_error("Cannot load values into a NUMA placed column");
+   }
+   // NULL strings point to an empty string. This way, string functions never see invalid pointers.
+   static char empty[] = "";
+   offsets.push_back(empty);
+}
+
+void StringColumn::storeValue(char* dest, const char* str, uint32_t strLen) {
+   auto elem = reinterpret_cast<char*>(storage.alloc(strLen + 1));
+   std::memcpy(elem, str, strLen);
+   elem[strLen] = 0;
+   *reinterpret_cast<char**>(dest) = elem;
+}
+
+void StringColumn::storeDefault(char* dest) {
+   static char empty[] = "";
+   *reinterpret_cast<char**>(dest) = empty;
+}
+
+void StringColumn::placeSegments(const std::vector<RowSegment>& segments) {
+   // Only the offsets get placed. The actual strings stay in the region they were loaded into.
+   assert(segments.empty() || segments.back().end == length());
+   placed = std::make_unique<NumaPlacedBuffer>(reinterpret_cast<const char*>(offsets.data()), sizeof(char*), segments);
+   std::vector<char*>().swap(offsets);
+}
+
 BaseColumn& StoredRelation::getColumn(std::string_view name) const {
    for (const auto& [n, c] : columns) {
       if (n == name) {
@@ -190,7 +446,7 @@ void StoredRelation::loadRows(std::istream& stream) {
    }
 }
 
-void StoredRelation::loadRow(const std::string& str) {
+void StoredRelation::splitRow(const std::string& str, const std::function<void(BaseColumn&, const char*, uint32_t)>& consumer) {
    size_t currPos = 0;
    for (auto& [c_name, c] : columns) {
       if (currPos == str.length()) {
@@ -200,18 +456,145 @@ void StoredRelation::loadRow(const std::string& str) {
       if (end == std::string::npos) {
          end = str.length();
       }
-      c->loadValue(str.data() + currPos, end - currPos);
+      consumer(*c, str.data() + currPos, end - currPos);
       currPos = end + 1;
    }
-   // Row is active.
-   appendRow();
    if (THROW_ON_MISMATCH && currPos != str.length()) {
       // There should be a final closing | in the files.
       throw std::runtime_error("Too many columns in TSV");
    }
 }
 
-void StoredRelation::appendRow() {
+void StoredRelation::loadRow(const std::string& str) {
+   if (appended_rows.load() > 0) {
+      throw std::runtime_error("Cannot bulk load into a StoredRelation after rows were appended");
+   }
+   splitRow(str, [](BaseColumn& col, const char* field, uint32_t len) {
+      if (len == 0 && col.isNullable()) {
+         // Empty fields in nullable columns are NULL.
+         col.loadNull();
+      } else {
+         col.loadValue(field, len);
+      }
+   });
+}
+
+void StoredRelation::appendRows(std::istream& stream) {
+   std::string line;
+   while (stream.peek() != EOF && std::getline(stream, line)) {
+      appendRow(line);
+   }
+}
+
+void StoredRelation::appendRow(const std::string& str) {
+   const size_t row = appended_rows.load(std::memory_order_relaxed);
+   const size_t idx = row % APPEND_SEGMENT_SIZE;
+   if (!columns.empty() && columns[0].second->segments.size() <= row / APPEND_SEGMENT_SIZE) {
+      // The last segment is full, start a new one. Existing segments never move.
+      std::unique_lock lock(segment_latch);
+      for (auto& [_, col] : columns) {
+         col->allocateSegment();
+      }
+      // The appending thread touches the memory first.
+      segment_nodes.push_back(numa::currentNode());
+   }
+   splitRow(str, [&](BaseColumn& col, const char* field, uint32_t len) {
+      if (len == 0 && col.isNullable()) {
+         if (!col.segments.back().validity) {
+            // First NULL in the segment, the bitmap is resolved by concurrent snapshots.
+            auto bits = std::make_unique<uint64_t[]>(APPEND_SEGMENT_SIZE / 64);
+            std::fill_n(bits.get(), APPEND_SEGMENT_SIZE / 64, ~0ull);
+            std::unique_lock lock(segment_latch);
+            col.segments.back().validity = std::move(bits);
+         }
+         col.appendNull(idx);
+      } else {
+         col.appendValue(idx, field, len);
+      }
+   });
+   // Publish the row. Snapshots taken from here on see all of its values.
+   appended_rows.store(row + 1, std::memory_order_release);
+}
+
+void StoredRelation::partitionNuma(size_t num_nodes) {
+   if (!segments.empty()) {
+      throw std::runtime_error("StoredRelation was already partitioned");
+   }
+   if (appended_rows.load() > 0) {
+      throw std::runtime_error("StoredRelation must be partitioned before rows are appended");
+   }
+   if (num_nodes == 0) {
+      throw std::runtime_error("Need at least one NUMA node to partition a StoredRelation");
+   }
+   const size_t rows = columns.empty() ? 0 : columns[0].second->length();
+   // Every node gets an equally sized range of rows, rounded up to the segment granule.
+   size_t rows_per_node = (rows + num_nodes - 1) / num_nodes;
+   rows_per_node = ((rows_per_node + SEGMENT_GRANULE - 1) / SEGMENT_GRANULE) * SEGMENT_GRANULE;
+   for (size_t node = 0; node < num_nodes && node * rows_per_node < rows; ++node) {
+      segments.push_back(RowSegment{
+         .begin = node * rows_per_node,
+         .end = std::min((node + 1) * rows_per_node, rows),
+         .node = node,
+      });
+   }
+   for (auto& [_, col] : columns) {
+      col->placeSegments(segments);
+   }
+}
+
+RelationSnapshot StoredRelation::snapshot() const {
+   const size_t bulk_rows = columns.empty() ? 0 : columns[0].second->length();
+   const size_t rows = appended_rows.load(std::memory_order_acquire);
+   return RelationSnapshot{
+      .segment_count = (rows + APPEND_SEGMENT_SIZE - 1) / APPEND_SEGMENT_SIZE,
+      .row_count = bulk_rows + rows,
+   };
+}
+
+std::vector<RowSegment> StoredRelation::getSegments() const {
+   return getSegments(snapshot());
+}
+
+std::vector<RowSegment> StoredRelation::getSegments(const RelationSnapshot& snapshot) const {
+   const size_t bulk_rows = columns.empty() ? 0 : columns[0].second->length();
+   std::vector<RowSegment> result = segments;
+   if (result.empty()) {
+      result.push_back(RowSegment{.begin = 0, .end = bulk_rows, .node = 0});
+   }
+   std::unique_lock lock(segment_latch);
+   assert(snapshot.segment_count <= segment_nodes.size());
+   for (size_t k = 0; k < snapshot.segment_count; ++k) {
+      const size_t begin = bulk_rows + k * APPEND_SEGMENT_SIZE;
+      result.push_back(RowSegment{
+         .begin = begin,
+         .end = std::min(begin + APPEND_SEGMENT_SIZE, snapshot.row_count),
+         .node = segment_nodes[k],
+         .block = k + 1,
+         .block_begin = begin,
+      });
+   }
+   return result;
+}
+
+std::vector<char*> StoredRelation::getColumnBlocks(std::string_view name, const RelationSnapshot& snapshot) const {
+   auto& col = getColumn(name);
+   std::unique_lock lock(segment_latch);
+   std::vector<char*> blocks;
+   for (size_t block = 0; block <= snapshot.segment_count; ++block) {
+      blocks.push_back(col.getBlockData(block));
+   }
+   return blocks;
+}
+
+std::vector<char*> StoredRelation::getValidityBlocks(std::string_view name, const RelationSnapshot& snapshot) const {
+   auto& col = getColumn(name);
+   // Also serializes padding the bulk loaded bitmap between concurrent queries.
+   std::unique_lock lock(segment_latch);
+   std::vector<char*> blocks;
+   for (size_t block = 0; block <= snapshot.segment_count; ++block) {
+      blocks.push_back(reinterpret_cast<char*>(col.getBlockValidity(block)));
+   }
+   return blocks;
 }
 
 } // namespace inkfuse
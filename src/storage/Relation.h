@@ -3,16 +3,80 @@
 
 #include "codegen/Type.h"
 #include "runtime/MemoryRuntime.h"
+#include <atomic>
 #include <cstddef>
+#include <functional>
 #include <istream>
 #include <memory>
+#include <mutex>
+#include <optional>
 #include <string>
 #include <unordered_map>
 #include <vector>
 
 namespace inkfuse {
 
+/// A contiguous range of rows within a relation that lives on a single NUMA node
+/// and within a single storage block of every column.
+struct RowSegment {
+   /// Index of the first row in the segment (inclusive).
+   size_t begin;
+   /// Index of the last row in the segment (exclusive).
+   size_t end;
+   /// The NUMA node backing the segment.
+   size_t node;
+   /// The storage block backing the segment. Block 0 contains the bulk loaded rows,
+   /// block k > 0 the (k-1)-th append-only segment.
+   size_t block = 0;
+   /// Index of the first row stored in the block.
+   size_t block_begin = 0;
+};
+
+/// A consistent view on a relation that is appended to concurrently.
+/// Rows appended after the snapshot was taken are not visible.
+struct RelationSnapshot {
+   /// Number of append-only segments visible in the snapshot.
+   size_t segment_count = 0;
+   /// Number of rows visible in the snapshot, including the bulk loaded ones.
+   size_t row_count = 0;
+};
+
+/// Smallest and largest non-NULL value of an integer column.
+struct ValueRange {
+   int64_t min;
+   int64_t max;
+};
+
+/// Memory region of a column whose pages are spread across NUMA nodes segment by segment.
+/// The region stays virtually contiguous, meaning that the generated code can still index
+/// into it directly. Physical placement is done by first-touching every segment from a thread
+/// pinned to the segment's node.
+class NumaPlacedBuffer {
+   public:
+   /// Copy the rows covered by `segments`, `width` bytes each, from `src` into the NUMA placed region.
+   NumaPlacedBuffer(const char* src, size_t width, const std::vector<RowSegment>& segments);
+   ~NumaPlacedBuffer();
+
+   NumaPlacedBuffer(const NumaPlacedBuffer&) = delete;
+   NumaPlacedBuffer& operator=(const NumaPlacedBuffer&) = delete;
+
+   char* data() const { return mem; }
+   /// Number of rows stored in the buffer.
+   size_t rows() const { return num_rows; }
+
+   private:
+   /// The mapped memory.
+   char* mem;
+   /// Size of the mapped memory in bytes.
+   size_t mapped_bytes;
+   /// Number of rows stored in the buffer.
+   size_t num_rows;
+};
+
 /// Base column class over a certain type.
+/// A column consists of contiguous storage for bulk loaded rows, followed by append-only
+/// segments of fixed size. Segments are never relocated, meaning that rows can be appended
+/// while queries scan the column.
 class BaseColumn {
    public:
    /// Constructor.
@@ -21,23 +85,80 @@ class BaseColumn {
    /// Virtual base destructor
    virtual ~BaseColumn() = default;
 
-   /// Get number of rows within the column.
+   /// Get number of bulk loaded rows within the column. Appended rows are only visible through a RelationSnapshot.
    virtual size_t length() const = 0;
 
    /// Is the column nullable?
-   bool isNullable();
+   bool isNullable() const;
 
    /// Load a value based on a string representation into the column.
    virtual void loadValue(const char* str, uint32_t strLen) = 0;
 
+   /// Load a NULL into the column. Only valid for nullable columns.
+   void loadNull();
+
+   /// How many NULLs does the column contain?
+   size_t nullCount() const;
+
+   /// Is the given row NULL? Also covers appended rows.
+   bool isNull(size_t row) const;
+
    /// Get a pointer to the backing raw data.
    virtual char* getRawData() = 0;
 
    /// Get the type of this .
    virtual IR::TypeArc getType() const = 0;
 
+   /// Get the value range of the bulk loaded rows. Only known for non-empty integer and date columns.
+   virtual std::optional<ValueRange> valueRange() const { return {}; }
+
+   /// Move the backing data onto the NUMA nodes described by `segments`.
+   /// No more values can be loaded into the column afterwards.
+   virtual void placeSegments(const std::vector<RowSegment>& segments) = 0;
+
+   /// Get the values of a storage block, see RowSegment::block.
+   char* getBlockData(size_t block);
+   /// Get the validity bitmap of a storage block. Bit k of word k / 64 is set if row k of the block
+   /// is not NULL. The bitmap covers all rows of the block, table scans read it directly.
+   uint64_t* getBlockValidity(size_t block);
+
    protected:
+   friend class StoredRelation;
+
+   /// Load the value that represents a NULL in the backing data. Zero for fixed-size types.
+   virtual void loadDefault() = 0;
+   /// Width of a single value in bytes.
+   virtual size_t valueWidth() const = 0;
+   /// Parse a value into the given slot of an append-only segment.
+   virtual void storeValue(char* dest, const char* str, uint32_t strLen) = 0;
+   /// Store the value representing a NULL into the given slot of an append-only segment.
+   virtual void storeDefault(char* dest) = 0;
+
+   /// Allocate a new append-only segment.
+   void allocateSegment();
+   /// Append a value at the given index of the last append-only segment.
+   void appendValue(size_t idx, const char* str, uint32_t strLen);
+   /// Append a NULL at the given index of the last append-only segment.
+   void appendNull(size_t idx);
+
    bool nullable;
+   /// Validity bitmap, bit k of word k / 64 is set if the respective row is not NULL.
+   /// Words beyond the end of the bitmap are implicitly valid, which means that columns
+   /// without NULLs never have to touch the bitmap.
+   std::vector<uint64_t> validity;
+   /// Number of NULLs in the column.
+   size_t null_count = 0;
+
+   /// An append-only segment of the column.
+   struct Segment {
+      /// The values, room for StoredRelation::APPEND_SEGMENT_SIZE rows.
+      std::unique_ptr<char[]> data;
+      /// Validity bitmap, only allocated once the first NULL is appended to the segment.
+      std::unique_ptr<uint64_t[]> validity;
+   };
+   /// The append-only segments. Only modified by the appending thread, the directory itself
+   /// is protected by the latch of the owning StoredRelation.
+   std::vector<Segment> segments;
 };
 
 class StringColumn final : public BaseColumn {
@@ -48,11 +169,11 @@ class StringColumn final : public BaseColumn {
 
    /// Get number of rows within the column.
    size_t length() const override {
-      return offsets.size();
+      return placed ? placed->rows() : offsets.size();
    };
 
    char* getRawData() override {
-      return reinterpret_cast<char*>(offsets.data());
+      return placed ? placed->data() : reinterpret_cast<char*>(offsets.data());
    }
 
    IR::TypeArc getType() const override {
@@ -61,9 +182,19 @@ class StringColumn final : public BaseColumn {
 
    void loadValue(const char* str, uint32_t strLen) override;
 
+   void placeSegments(const std::vector<RowSegment>& segments) override;
+
+   protected:
+   void loadDefault() override;
+   size_t valueWidth() const override { return sizeof(char*); }
+   void storeValue(char* dest, const char* str, uint32_t strLen) override;
+   void storeDefault(char* dest) override;
+
    private:
    /// Actual vector of data that stores the char* that are passed through the runtime.
    std::vector<char*> offsets;
+   /// The NUMA placed offsets once the column was partitioned.
+   std::unique_ptr<NumaPlacedBuffer> placed;
    /// Backing storage for the strings. `offsets` points into this allocator.
    MemoryRuntime::MemoryRegion storage;
 };
@@ -79,31 +210,56 @@ class PODColumn final : public BaseColumn {
    void loadValue(const char* str, uint32_t strlen) override;
 
    char* getRawData() override {
-      return storage.data();
+      return placed ? placed->data() : storage.data();
    }
 
+   void placeSegments(const std::vector<RowSegment>& segments) override;
+
+   /// Get the backing storage. Only valid as long as the column was not placed on NUMA nodes.
    std::vector<char>& getStorage() {
+      // The storage may be written through the reference.
+      invalidateRange();
       return storage;
    }
 
+   std::optional<ValueRange> valueRange() const override;
+
    IR::TypeArc getType() const override {
       return type;
    };
 
+   protected:
+   void loadDefault() override;
+   size_t valueWidth() const override { return type->numBytes(); }
+   void storeValue(char* dest, const char* str, uint32_t strLen) override;
+   void storeDefault(char* dest) override;
+
    private:
+   /// Drop the cached value range after the rows changed.
+   void invalidateRange();
+
    /// Function to load a value. Depends on the nested type.
    std::function<void(char* data ,const char* str)> load_val;
    /// Backing storage.
    std::vector<char> storage;
+   /// The NUMA placed storage once the column was partitioned.
+   std::unique_ptr<NumaPlacedBuffer> placed;
    /// Offset within the backing storage.
    size_t storage_offset = 0;
    /// InkFuse type of this table.
    IR::TypeArc type;
+   /// Latch protecting `cached_range`, concurrently planned queries may ask for the range.
+   mutable std::mutex range_latch;
+   /// Value range computed by valueRange() together with the number of rows it covers.
+   /// Recomputed once more rows were loaded, reset when the storage gets written directly.
+   mutable std::optional<std::pair<size_t, std::optional<ValueRange>>> cached_range;
 };
 
 using BaseColumnPtr = std::unique_ptr<BaseColumn>;
 
 /// Relation (for now) is just a vector containing column names to columns.
+/// Rows are either bulk loaded before the relation is queried, or appended while
+/// queries are running. Every query scans a RelationSnapshot taken at plan time.
 class StoredRelation {
    public:
    // Virtual base destructor.
@@ -131,15 +287,54 @@ class StoredRelation {
    void loadRows(std::istream& stream);
 
    /// Load a single .tbl row into the table, advancing the ifstream past the next newline.
+   /// Bulk loading is only possible until the first row was appended.
    void loadRow(const std::string& str);
 
-   /// Add a row to the back of the active bitvector.
-   void appendRow();
+   /// Append .tbl rows until the stream is exhausted.
+   void appendRows(std::istream& stream);
+
+   /// Append a single .tbl row into the append-only segments. Can run concurrently to queries
+   /// on the relation, but there must only be a single appending thread.
+   void appendRow(const std::string& str);
+
+   /// Split the relation into one segment per NUMA node and move the column data
+   /// onto the respective nodes. The bulk loaded rows become read-only afterwards.
+   void partitionNuma(size_t num_nodes);
+
+   /// Take a snapshot of the rows that are visible right now.
+   RelationSnapshot snapshot() const;
+
+   /// Get the row segments of the relation. The bulk loaded rows are a single segment on node 0
+   /// if the relation was never partitioned. Each visible append-only segment adds one more.
+   std::vector<RowSegment> getSegments() const;
+   std::vector<RowSegment> getSegments(const RelationSnapshot& snapshot) const;
+
+   /// Get the storage blocks of a column visible in the snapshot, indexed by RowSegment::block.
+   std::vector<char*> getColumnBlocks(std::string_view name, const RelationSnapshot& snapshot) const;
+   /// Get the validity bitmap blocks of a nullable column visible in the snapshot.
+   std::vector<char*> getValidityBlocks(std::string_view name, const RelationSnapshot& snapshot) const;
+
+   /// Granularity of segments in rows. Ensures that segments of every column start on a page boundary.
+   static constexpr size_t SEGMENT_GRANULE = 4096;
+   /// Number of rows in an append-only segment.
+   static constexpr size_t APPEND_SEGMENT_SIZE = 16 * SEGMENT_GRANULE;
 
    private:
+   /// Split a .tbl row into its fields and hand them to the consumer together with the respective column.
+   void splitRow(const std::string& str, const std::function<void(BaseColumn&, const char*, uint32_t)>& consumer);
+
    /// Backing columns.
    /// We use a vector to exploit ordering during the scan.
    std::vector<std::pair<std::string, std::unique_ptr<BaseColumn>>> columns;
+   /// The NUMA segments if the relation was partitioned.
+   std::vector<RowSegment> segments;
+   /// Latch protecting the segment directories of the columns. Taken when appending a segment
+   /// and when a snapshot is resolved into storage blocks.
+   mutable std::mutex segment_latch;
+   /// NUMA nodes of the append-only segments.
+   std::vector<size_t> segment_nodes;
+   /// Number of appended rows. Published by the appending thread once a row is complete.
+   std::atomic<size_t> appended_rows = 0;
 };
 
 using StoredRelationPtr = std::unique_ptr<StoredRelation>;
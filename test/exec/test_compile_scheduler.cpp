@@ -0,0 +1,105 @@
+#include "exec/CompileScheduler.h"
+#include "gtest/gtest.h"
+#include <atomic>
+#include <chrono>
+#include <memory>
+#include <mutex>
+#include <optional>
+#include <thread>
+#include <vector>
+
+namespace inkfuse {
+
+namespace {
+
+/// Wait until the given number of jobs are waiting for a slot.
+void awaitWaiting(const CompileScheduler& scheduler, size_t waiting) {
+   while (scheduler.numWaiting() != waiting) {
+      std::this_thread::sleep_for(std::chrono::milliseconds(1));
+   }
+}
+
+TEST(test_compile_scheduler, bounded_slots) {
+   CompileScheduler scheduler(2);
+   std::atomic<size_t> running = 0;
+   std::atomic<size_t> max_running = 0;
+   std::vector<std::thread> jobs;
+   std::vector<std::unique_ptr<InterruptableJob>> interrupts;
+   for (size_t k = 0; k < 8; ++k) {
+      interrupts.push_back(std::make_unique<InterruptableJob>());
+      jobs.emplace_back([&, job = interrupts.back().get()] {
+         CompileScheduler::Slot slot(scheduler, *job, [] { return 1.0; });
+         EXPECT_TRUE(slot.acquired());
+         const size_t now = ++running;
+         size_t seen = max_running;
+         while (now > seen && !max_running.compare_exchange_weak(seen, now)) {}
+         std::this_thread::sleep_for(std::chrono::milliseconds(5));
+         running--;
+      });
+   }
+   for (auto& job : jobs) {
+      job.join();
+   }
+   EXPECT_LE(max_running, 2);
+   EXPECT_EQ(scheduler.numWaiting(), 0);
+}
+
+TEST(test_compile_scheduler, priority_order) {
+   CompileScheduler scheduler(1);
+   InterruptableJob blocker;
+   std::optional<CompileScheduler::Slot> held;
+   held.emplace(scheduler, blocker, [] { return 0.0; });
+   ASSERT_TRUE(held->acquired());
+
+   // Queue jobs with increasing value while the only slot is taken.
+   std::mutex order_mut;
+   std::vector<size_t> order;
+   std::vector<std::thread> jobs;
+   std::vector<std::unique_ptr<InterruptableJob>> interrupts;
+   for (size_t k = 0; k < 3; ++k) {
+      interrupts.push_back(std::make_unique<InterruptableJob>());
+      jobs.emplace_back([&, k, job = interrupts.back().get()] {
+         CompileScheduler::Slot slot(scheduler, *job, [k] { return static_cast<double>(k); });
+         ASSERT_TRUE(slot.acquired());
+         std::unique_lock lock(order_mut);
+         order.push_back(k);
+      });
+      awaitWaiting(scheduler, k + 1);
+   }
+
+   // The most valuable job compiles first.
+   held.reset();
+   for (auto& job : jobs) {
+      job.join();
+   }
+   EXPECT_EQ(order, (std::vector<size_t>{2, 1, 0}));
+}
+
+TEST(test_compile_scheduler, interrupt_waiting) {
+   CompileScheduler scheduler(1);
+   InterruptableJob blocker;
+   CompileScheduler::Slot held(scheduler, blocker, [] { return 0.0; });
+   ASSERT_TRUE(held.acquired());
+
+   // A waiting job gives up once it gets interrupted.
+   InterruptableJob job;
+   std::thread waiter([&] {
+      CompileScheduler::Slot slot(scheduler, job, [] { return 1.0; });
+      EXPECT_FALSE(slot.acquired());
+   });
+   awaitWaiting(scheduler, 1);
+   scheduler.interrupt(job);
+   waiter.join();
+   EXPECT_TRUE(job.interrupted());
+   EXPECT_EQ(scheduler.numWaiting(), 0);
+
+   // Jobs interrupted before they start waiting never get a slot.
+   InterruptableJob early;
+   scheduler.interrupt(early);
+   CompileScheduler::Slot slot(scheduler, early, [] { return 1.0; });
+   EXPECT_FALSE(slot.acquired());
+}
+
+}
+
+}
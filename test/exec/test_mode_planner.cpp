@@ -0,0 +1,116 @@
+#include "algebra/Aggregation.h"
+#include "algebra/Print.h"
+#include "algebra/TableScan.h"
+#include "algebra/suboperators/sinks/FuseChunkSink.h"
+#include "algebra/suboperators/sources/FuseChunkSource.h"
+#include "algebra/suboperators/sources/TableScanSource.h"
+#include "exec/ModePlanner.h"
+#include "exec/QueryExecutor.h"
+#include "gtest/gtest.h"
+#include <sstream>
+
+namespace inkfuse {
+
+namespace {
+
+using ExecutionMode = PipelineExecutor::ExecutionMode;
+
+/// Pipeline scanning a single column of a relation with `rows` rows.
+struct ScanPipeline {
+   explicit ScanPipeline(size_t rows) {
+      auto driver = TScanDriver::build(nullptr, rows);
+      auto& driver_iu = **driver->getIUs().begin();
+      pipe.attachSuboperator(std::move(driver));
+      provider = &pipe.attachSuboperator(TScanIUProvider::build(nullptr, driver_iu, scan_iu));
+      pipe.attachSuboperator(FuseChunkSink::build(nullptr, scan_iu));
+   }
+
+   IU scan_iu{IR::UnsignedInt::build(8), "scan"};
+   Pipeline pipe;
+   Suboperator* provider;
+};
+
+TEST(test_mode_planner, scan_sizes) {
+   // The interpretation overhead grows with the rows, the compilation latency is fixed.
+   const std::vector<std::pair<size_t, ExecutionMode>> expected{
+      {1'000, ExecutionMode::Interpreted},
+      {10'000'000, ExecutionMode::Hybrid},
+      {1'000'000'000, ExecutionMode::Fused},
+   };
+   for (const auto& [rows, mode] : expected) {
+      ScanPipeline scan(rows);
+      const auto decision = ModePlanner::plan(scan.pipe, 1);
+      EXPECT_EQ(decision.mode, mode) << "Rows " << rows;
+      EXPECT_EQ(decision.estimated_rows, rows);
+      EXPECT_EQ(decision.complexity, 3);
+      EXPECT_EQ(decision.staging_points, 0);
+   }
+}
+
+TEST(test_mode_planner, threads) {
+   // More threads share the interpretation overhead.
+   ScanPipeline scan(1'000'000'000);
+   EXPECT_EQ(ModePlanner::plan(scan.pipe, 1).mode, ExecutionMode::Fused);
+   EXPECT_EQ(ModePlanner::plan(scan.pipe, 64).mode, ExecutionMode::Hybrid);
+}
+
+TEST(test_mode_planner, staging_points) {
+   // Large pipelines with hash table probes use relaxed operator fusion.
+   ScanPipeline scan(1'000'000'000);
+   scan.provider->setROFStrategy(Suboperator::OptimizationProperties::ROFStrategy::BeginVectorized);
+   const auto decision = ModePlanner::plan(scan.pipe, 1);
+   EXPECT_EQ(decision.staging_points, 1);
+   EXPECT_EQ(decision.mode, ExecutionMode::ROF);
+}
+
+TEST(test_mode_planner, unknown_rows) {
+   // Pipelines reading intermediate results don't know their rows while planning.
+   Pipeline pipe;
+   IU in_iu(IR::UnsignedInt::build(8), "in");
+   auto driver = FuseChunkSourceDriver::build();
+   auto& driver_iu = **driver->getIUs().begin();
+   pipe.attachSuboperator(std::move(driver));
+   pipe.attachSuboperator(FuseChunkSourceIUProvider::build(driver_iu, in_iu));
+   pipe.attachSuboperator(FuseChunkSink::build(nullptr, in_iu));
+   const auto decision = ModePlanner::plan(pipe, 1);
+   EXPECT_FALSE(decision.estimated_rows);
+   EXPECT_EQ(decision.mode, ExecutionMode::Interpreted);
+}
+
+TEST(test_mode_planner, cost_based_query) {
+   // SELECT g, count(*) FROM t GROUP BY g
+   StoredRelation rel;
+   rel.attachPODColumn("g", IR::UnsignedInt::build(4));
+   for (size_t k = 0; k < 1'000; ++k) {
+      rel.loadRow(std::to_string(k % 4) + "|");
+   }
+   auto scan = TableScan::build(rel, {"g"}, "scan");
+   auto scan_out = scan->getOutput();
+   std::vector<AggregateFunctions::Description> agg_fct;
+   agg_fct.push_back({.agg_iu = *scan_out[0], .code = AggregateFunctions::Opcode::Count});
+   std::vector<RelAlgOpPtr> agg_children;
+   agg_children.push_back(std::move(scan));
+   auto agg = Aggregation::build(std::move(agg_children), "agg", {scan_out[0]}, std::move(agg_fct));
+   auto agg_out = agg->getOutput();
+   std::vector<RelAlgOpPtr> print_children;
+   print_children.push_back(std::move(agg));
+   auto print = Print::build(std::move(print_children), std::move(agg_out), {"g", "count"});
+   std::stringstream results;
+   print->printer->setOstream(results);
+   auto& printer = *print->printer;
+
+   auto control_block = std::make_shared<PipelineExecutor::QueryControlBlock>(std::move(print));
+   const size_t num_pipes = control_block->dag.getPipelines().size();
+   auto stats = QueryExecutor::runQuery(control_block, ExecutionMode::CostBased, "cost_based_query");
+   EXPECT_EQ(printer.num_rows, 4);
+   // The tiny query never compiles.
+   ASSERT_EQ(stats.modes.size(), num_pipes);
+   for (auto mode : stats.modes) {
+      EXPECT_EQ(mode, ExecutionMode::Interpreted);
+   }
+   EXPECT_EQ(stats.codegen_microseconds, 0);
+}
+
+}
+
+}
@@ -0,0 +1,139 @@
+#include "algebra/Aggregation.h"
+#include "algebra/ExpressionOp.h"
+#include "algebra/Filter.h"
+#include "algebra/Print.h"
+#include "algebra/TableScan.h"
+#include "exec/QueryExecutor.h"
+#include "gtest/gtest.h"
+#include <set>
+#include <sstream>
+#include <string>
+
+namespace inkfuse {
+
+namespace {
+
+using ComputeNode = ExpressionOp::ComputeNode;
+using IURefNode = ExpressionOp::IURefNode;
+
+struct PreparedQueryTestT : public ::testing::TestWithParam<PipelineExecutor::ExecutionMode> {
+   PreparedQueryTestT() {
+      rel.attachPODColumn("g", IR::UnsignedInt::build(4));
+      rel.attachPODColumn("k", IR::SignedInt::build(8));
+      for (int64_t k = 0; k < num_rows; ++k) {
+         rel.loadRow(std::to_string(k % 4) + "|" + std::to_string(k) + "|");
+      }
+   }
+
+   /// SELECT g, count(k), sum(k) FROM t WHERE k < :bound GROUP BY g
+   RelAlgOpPtr buildPlan(const QueryExecutor::QueryParameters& params) {
+      auto scan = TableScan::build(rel, {"g", "k"}, "scan");
+      auto& scan_ref = *scan;
+      std::vector<ExpressionOp::NodePtr> nodes;
+      nodes.emplace_back(std::make_unique<IURefNode>(scan_ref.getOutput()[1]));
+      nodes.emplace_back(std::make_unique<ComputeNode>(ComputeNode::Type::Greater, params.get("bound"), nodes[0].get()));
+      auto root = nodes[1].get();
+      std::vector<RelAlgOpPtr> expr_children;
+      expr_children.push_back(std::move(scan));
+      auto expr = ExpressionOp::build(std::move(expr_children), "expr", {root}, std::move(nodes));
+      auto& expr_ref = *expr;
+      std::vector<RelAlgOpPtr> filter_children;
+      filter_children.push_back(std::move(expr));
+      auto filter = Filter::build(std::move(filter_children), "filter", {scan_ref.getOutput()[0], scan_ref.getOutput()[1]}, *expr_ref.getOutput()[0]);
+      auto filter_out = filter->getOutput();
+      std::vector<AggregateFunctions::Description> agg_fct;
+      agg_fct.push_back({.agg_iu = *filter_out[1], .code = AggregateFunctions::Opcode::Count});
+      agg_fct.push_back({.agg_iu = *filter_out[1], .code = AggregateFunctions::Opcode::Sum});
+      std::vector<RelAlgOpPtr> agg_children;
+      agg_children.push_back(std::move(filter));
+      auto agg = Aggregation::build(std::move(agg_children), "agg", {filter_out[0]}, std::move(agg_fct));
+      auto agg_out = agg->getOutput();
+      std::vector<RelAlgOpPtr> print_children;
+      print_children.push_back(std::move(agg));
+      auto print = Print::build(std::move(print_children), std::move(agg_out), {"g", "count", "sum"});
+      results.str("");
+      print->printer->setOstream(results);
+      return print;
+   }
+
+   /// Get the printed result lines without the header.
+   std::set<std::string> resultLines() {
+      std::set<std::string> lines;
+      std::string line;
+      std::getline(results, line);
+      while (std::getline(results, line)) {
+         lines.insert(line);
+      }
+      results.clear();
+      return lines;
+   }
+
+   /// The expected result lines for a bound.
+   static std::set<std::string> expected(int64_t bound) {
+      std::set<std::string> lines;
+      for (int64_t g = 0; g < 4 && g < bound; ++g) {
+         int64_t count = 0;
+         int64_t sum = 0;
+         for (int64_t k = g; k < bound; k += 4) {
+            count++;
+            sum += k;
+         }
+         lines.insert(std::to_string(g) + "," + std::to_string(count) + "," + std::to_string(sum));
+      }
+      return lines;
+   }
+
+   const int64_t num_rows = 10'000;
+   StoredRelation rel;
+   std::stringstream results;
+};
+
+TEST_P(PreparedQueryTestT, rebind) {
+   QueryExecutor::QueryParameters bindings;
+   bindings.bind("bound", IR::SI<8>::build(100));
+   QueryExecutor::PreparedQuery prepared(
+      [&](const QueryExecutor::QueryParameters& params) { return buildPlan(params); },
+      std::move(bindings), GetParam(), "prepared_rebind", 2);
+
+   // Run with the prepared binding.
+   prepared.run();
+   EXPECT_EQ(resultLines(), expected(100));
+
+   // Rebind the parameter, the prepared code has to pick up the new values.
+   for (int64_t bound : {2, 5'000, 10'000}) {
+      QueryExecutor::QueryParameters rebound;
+      rebound.bind("bound", IR::SI<8>::build(bound));
+      prepared.run(rebound);
+      EXPECT_EQ(resultLines(), expected(bound)) << "Bound " << bound;
+   }
+}
+
+TEST_P(PreparedQueryTestT, bad_bindings) {
+   QueryExecutor::QueryParameters bindings;
+   bindings.bind("bound", IR::SI<8>::build(100));
+   QueryExecutor::PreparedQuery prepared(
+      [&](const QueryExecutor::QueryParameters& params) { return buildPlan(params); },
+      std::move(bindings), GetParam(), "prepared_bad_bindings");
+
+   // The prepared code reads an eight byte signed integer.
+   QueryExecutor::QueryParameters wrong_type;
+   wrong_type.bind("bound", IR::UI<4>::build(100));
+   EXPECT_THROW(prepared.run(wrong_type), std::runtime_error);
+   // Unknown parameters are rejected.
+   QueryExecutor::QueryParameters unknown;
+   unknown.bind("other", IR::SI<8>::build(100));
+   EXPECT_THROW(prepared.run(unknown), std::runtime_error);
+}
+
+INSTANTIATE_TEST_CASE_P(
+   PreparedQueryTest,
+   PreparedQueryTestT,
+   ::testing::Values(
+      PipelineExecutor::ExecutionMode::Fused,
+      PipelineExecutor::ExecutionMode::Interpreted,
+      PipelineExecutor::ExecutionMode::ROF,
+      PipelineExecutor::ExecutionMode::Hybrid));
+
+}
+
+}
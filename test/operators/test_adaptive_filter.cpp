@@ -0,0 +1,186 @@
+#include "algebra/AdaptiveFilter.h"
+#include "algebra/ArrowExport.h"
+#include "algebra/TableScan.h"
+#include "algebra/suboperators/ColumnFilter.h"
+#include "exec/QueryExecutor.h"
+#include "gtest/gtest.h"
+#include <algorithm>
+#include <mutex>
+#include <utility>
+
+namespace inkfuse {
+
+namespace {
+
+using ComputeNode = ExpressionOp::ComputeNode;
+using IURefNode = ExpressionOp::IURefNode;
+
+/// An output row (a, b).
+using Row = std::pair<int64_t, int64_t>;
+
+struct AdaptiveFilterTestT : public ::testing::TestWithParam<PipelineExecutor::ExecutionMode> {
+   AdaptiveFilterTestT() {
+      rel.attachPODColumn("a", IR::SignedInt::build(8));
+      rel.attachPODColumn("b", IR::SignedInt::build(8), true);
+      for (int64_t k = 0; k < num_rows; ++k) {
+         const bool b_null = k % 7 == 0;
+         const int64_t b = (k * 7919) % 1000;
+         rel.loadRow(std::to_string(k) + "|" + (b_null ? "" : std::to_string(b)) + "|");
+         if (!b_null && b < 10) {
+            expected.emplace_back(k, b);
+         }
+      }
+   }
+
+   /// SELECT a, b FROM t WHERE a >= 0 AND b < 10
+   /// The first conjunct passes every row, the second one is very selective.
+   RelAlgOpPtr buildPlan(std::vector<size_t>& order) {
+      auto scan = TableScan::build(rel, {"a", "b"}, "scan");
+      auto scan_out = scan->getOutput();
+      std::vector<AdaptiveFilter::Conjunct> conjuncts(2);
+      {
+         auto& nodes = conjuncts[0].nodes;
+         nodes.emplace_back(std::make_unique<IURefNode>(scan_out[0]));
+         nodes.emplace_back(std::make_unique<ComputeNode>(ComputeNode::Type::Less, IR::SI<8>::build(-1), nodes[0].get()));
+         conjuncts[0].root = nodes[1].get();
+      }
+      {
+         auto& nodes = conjuncts[1].nodes;
+         nodes.emplace_back(std::make_unique<IURefNode>(scan_out[1]));
+         nodes.emplace_back(std::make_unique<ComputeNode>(ComputeNode::Type::Greater, IR::SI<8>::build(10), nodes[0].get()));
+         conjuncts[1].root = nodes[1].get();
+      }
+      std::vector<RelAlgOpPtr> filter_children;
+      filter_children.push_back(std::move(scan));
+      auto filter = AdaptiveFilter::build(std::move(filter_children), "filter", {scan_out[0], scan_out[1]}, std::move(conjuncts), stats);
+      order = filter->getOrder();
+      auto filter_out = filter->getOutput();
+      EXPECT_EQ(filter_out.size(), 2);
+      EXPECT_NE(filter_out[1]->null_indicator, nullptr);
+      std::vector<RelAlgOpPtr> export_children;
+      export_children.push_back(std::move(filter));
+      auto root = ArrowExport::build(std::move(export_children), filter_out, {"a", "b"});
+
+      // Batches arrive from all threads, collect the produced rows.
+      root->exporter->setCallback([&](size_t, ArrowArray* batch) {
+         std::unique_lock lock(result_mut);
+         auto a = static_cast<const int64_t*>(batch->children[0]->buffers[1]);
+         auto b = static_cast<const int64_t*>(batch->children[1]->buffers[1]);
+         for (int64_t row = 0; row < batch->length; ++row) {
+            result.emplace_back(a[row], b[row]);
+         }
+         batch->release(batch);
+      });
+      return root;
+   }
+
+   std::vector<Row> runFilter(std::vector<size_t>& order) {
+      auto control_block = std::make_shared<PipelineExecutor::QueryControlBlock>(buildPlan(order));
+      QueryExecutor::runQuery(control_block, GetParam(), "adaptive_filter", 4);
+      return takeResult();
+   }
+
+   std::vector<Row> takeResult() {
+      std::vector<Row> rows = std::move(result);
+      result.clear();
+      std::sort(rows.begin(), rows.end());
+      return rows;
+   }
+
+   const int64_t num_rows = 20'000;
+   StoredRelation rel;
+   std::vector<Row> expected;
+   std::mutex result_mut;
+   std::vector<Row> result;
+   ConjunctStatisticsArc stats = std::make_shared<ConjunctStatistics>(2);
+};
+
+TEST_P(AdaptiveFilterTestT, learns_order) {
+   // The first instance evaluates the conjuncts in the specified order.
+   std::vector<size_t> order;
+   auto result = runFilter(order);
+   EXPECT_EQ(order, (std::vector<size_t>{0, 1}));
+   EXPECT_EQ(result, expected);
+   EXPECT_DOUBLE_EQ(stats->selectivity(0), 1.0);
+   EXPECT_LT(stats->selectivity(1), 0.02);
+   EXPECT_FALSE(stats->settled());
+   // Interpreted conjuncts measure their cost, fused code is not timed.
+   if (GetParam() == PipelineExecutor::ExecutionMode::Interpreted) {
+      EXPECT_TRUE(stats->measuredCost(0));
+      EXPECT_TRUE(stats->measuredCost(1));
+   } else if (GetParam() == PipelineExecutor::ExecutionMode::Fused) {
+      EXPECT_FALSE(stats->measuredCost(0));
+   }
+
+   // Later instances evaluate the selective conjunct first.
+   result = runFilter(order);
+   EXPECT_EQ(order, (std::vector<size_t>{1, 0}));
+   EXPECT_TRUE(stats->settled());
+   EXPECT_EQ(result, expected);
+}
+
+TEST_P(AdaptiveFilterTestT, prepared) {
+   // The prepared query compiles the learned order once the statistics settled.
+   std::vector<size_t> order;
+   QueryExecutor::PreparedQuery prepared(
+      [&](const QueryExecutor::QueryParameters&) { return buildPlan(order); },
+      {}, GetParam(), "adaptive_filter_prepared", 4);
+   for (size_t run = 0; run < 3; ++run) {
+      prepared.run();
+      EXPECT_EQ(takeResult(), expected) << "Run " << run;
+      EXPECT_EQ(order, run == 0 ? (std::vector<size_t>{0, 1}) : (std::vector<size_t>{1, 0}));
+   }
+}
+
+// Stages only copy the IUs needed by later stages or behind the filter.
+TEST(test_adaptive_filter, copies_needed_ius) {
+   StoredRelation rel;
+   rel.attachPODColumn("a", IR::SignedInt::build(8));
+   rel.attachPODColumn("b", IR::SignedInt::build(8), true);
+   auto scan = TableScan::build(rel, {"a", "b"}, "scan");
+   auto scan_out = scan->getOutput();
+   // WHERE a >= 0 AND b < 10, only a is needed behind the filter.
+   std::vector<AdaptiveFilter::Conjunct> conjuncts(2);
+   for (size_t k = 0; k < 2; ++k) {
+      auto& nodes = conjuncts[k].nodes;
+      nodes.emplace_back(std::make_unique<IURefNode>(scan_out[k]));
+      const auto type = k == 0 ? ComputeNode::Type::Less : ComputeNode::Type::Greater;
+      nodes.emplace_back(std::make_unique<ComputeNode>(type, IR::SI<8>::build(k == 0 ? -1 : 10), nodes[0].get()));
+      conjuncts[k].root = nodes[1].get();
+   }
+   // Settle the statistics, the selective conjunct on b goes first.
+   auto stats = std::make_shared<ConjunctStatistics>(2);
+   stats->recordInput(0, ConjunctStatistics::SETTLE_ROWS);
+   stats->recordOutput(0, ConjunctStatistics::SETTLE_ROWS);
+   stats->recordInput(1, ConjunctStatistics::SETTLE_ROWS);
+   stats->recordOutput(1, 10);
+   std::vector<RelAlgOpPtr> children;
+   children.push_back(std::move(scan));
+   auto filter = AdaptiveFilter::build(std::move(children), "filter", {scan_out[0]}, std::move(conjuncts), stats);
+   EXPECT_EQ(filter->getOrder(), (std::vector<size_t>{1, 0}));
+
+   PipelineDAG dag;
+   dag.buildNewPipeline();
+   filter->decay(dag);
+   std::vector<const IU*> copied;
+   for (const auto& op : dag.getCurrentPipeline().getSubops()) {
+      if (dynamic_cast<const ColumnFilterLogic*>(op.get())) {
+         copied.push_back(op->getSourceIUs()[1]);
+      }
+   }
+   // Behind the first stage b is no longer needed, both stages only copy a.
+   ASSERT_EQ(copied.size(), 2);
+   EXPECT_EQ(copied[0], scan_out[0]);
+}
+
+INSTANTIATE_TEST_CASE_P(
+   AdaptiveFilterTest,
+   AdaptiveFilterTestT,
+   ::testing::Values(
+      PipelineExecutor::ExecutionMode::Fused,
+      PipelineExecutor::ExecutionMode::Interpreted,
+      PipelineExecutor::ExecutionMode::ROF,
+      PipelineExecutor::ExecutionMode::Hybrid));
+
+}
+}
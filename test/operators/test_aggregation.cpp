@@ -1,9 +1,17 @@
 #include "algebra/Aggregation.h"
+#include "algebra/ExpressionOp.h"
 #include "algebra/Pipeline.h"
+#include "algebra/Print.h"
 #include "algebra/TableScan.h"
 #include "algebra/suboperators/sinks/CountingSink.h"
+#include "common/Helpers.h"
 #include "exec/QueryExecutor.h"
 #include "gtest/gtest.h"
+#include <algorithm>
+#include <map>
+#include <numeric>
+#include <optional>
+#include <set>
 #include <string>
 
 namespace inkfuse {
@@ -19,6 +27,9 @@ const std::unordered_map<Opcode, std::string> opcode_names{
    {Opcode::Avg, "avg"},
    {Opcode::Min, "min"},
    {Opcode::Max, "max"},
+   {Opcode::ApproxCountDistinct, "approx_count_distinct"},
+   {Opcode::Median, "median"},
+   {Opcode::ApproxQuantile, "approx_quantile"},
 };
 
 const std::vector<std::string> strings{
@@ -123,7 +134,7 @@ using ParamT = std::tuple<OpcodeVec, PipelineExecutor::ExecutionMode>;
 struct SimpleAggTestT : public AggregationTestT, public ::testing::TestWithParam<ParamT> {};
 
 // SELECT col_1, AGG_FCT1(col_2), AGG_FCT2(col_2), ..., AGG_FCT(col_2) FROM t GROUP BY col_1
-// With AGG_FCT in {count, sum, avg}.
+// With AGG_FCT in {count, sum, avg, min, max, approx_count_distinct, median, approx_quantile}.
 TEST_P(SimpleAggTestT, one_key) {
    // Set up the query.
    std::vector<AggregateFunctions::Description> agg_fct;
@@ -151,7 +162,7 @@ TEST_P(SimpleAggTestT, one_key) {
 }
 
 // SELECT col_1, col_2 AGG_FCT1(col_3), AGG_FCT2(col_3), ..., AGG_FCT(col_3) FROM t GROUP BY col_1, col_2
-// With AGG_FCT in {count, sum, avg}.
+// With AGG_FCT in {count, sum, avg, min, max, approx_count_distinct, median, approx_quantile}.
 TEST_P(SimpleAggTestT, two_keys) {
    // Set up the query.
    std::vector<AggregateFunctions::Description> agg_fct;
@@ -186,7 +197,11 @@ INSTANTIATE_TEST_CASE_P(
                         OpcodeVec{Opcode::Sum},
                         OpcodeVec{Opcode::Avg},
                         OpcodeVec{Opcode::Sum, Opcode::Count},
-                        OpcodeVec{Opcode::Avg, Opcode::Sum, Opcode::Count}),
+                        OpcodeVec{Opcode::Avg, Opcode::Sum, Opcode::Count},
+                        OpcodeVec{Opcode::Min, Opcode::Max},
+                        OpcodeVec{Opcode::Min, Opcode::Sum, Opcode::Max, Opcode::Count},
+                        OpcodeVec{Opcode::ApproxCountDistinct, Opcode::Count},
+                        OpcodeVec{Opcode::Median, Opcode::ApproxQuantile, Opcode::Avg}),
       ::testing::Values(
          PipelineExecutor::ExecutionMode::Fused,
          PipelineExecutor::ExecutionMode::Interpreted,
@@ -196,5 +211,787 @@ INSTANTIATE_TEST_CASE_P(
       std::string opcode_names = buildTestCaseName(std::get<0>(info.param));
       return opcode_names + "_" + std::to_string(static_cast<int>(std::get<1>(info.param)));
    });
+
+struct NullAggTestT : public ::testing::TestWithParam<PipelineExecutor::ExecutionMode> {
+   NullAggTestT() {
+      rel.attachPODColumn("key", IR::UnsignedInt::build(4), true);
+      rel.attachPODColumn("val", IR::SignedInt::build(8), true);
+      rel.attachPODColumn("dec", IR::Decimal::build(12, 2), true);
+      for (size_t k = 0; k < num_rows; ++k) {
+         std::string key = k % 5 == 0 ? "" : std::to_string(k % 4);
+         // Key 3 only sees NULL values.
+         const bool val_null = k % 3 == 0 || k % 4 == 3;
+         std::string val = val_null ? "" : std::to_string(k);
+         std::string dec = val_null ? "" : helpers::decimalIntToStr(k, 2);
+         rel.loadRow(key + "|" + val + "|" + dec + "|");
+      }
+   }
+
+   const size_t num_rows = 1000;
+   StoredRelation rel;
+};
+
+// SELECT key, sum(val), count(val), count(val + key) FROM t GROUP BY key
+// With NULLs in both key and val.
+TEST_P(NullAggTestT, nullable_key_and_value) {
+   auto scan = TableScan::build(rel, {"key", "val"}, "scan");
+   const IU* key = scan->getOutput()[0];
+   const IU* val = scan->getOutput()[1];
+   ASSERT_TRUE(key->null_indicator);
+   ASSERT_TRUE(val->null_indicator);
+
+   // val + key, NULL if either side is NULL.
+   std::vector<ExpressionOp::NodePtr> nodes;
+   auto key_ref = nodes.emplace_back(std::make_unique<ExpressionOp::IURefNode>(key)).get();
+   auto val_ref = nodes.emplace_back(std::make_unique<ExpressionOp::IURefNode>(val)).get();
+   auto key_cast = nodes.emplace_back(std::make_unique<ExpressionOp::ComputeNode>(IR::SignedInt::build(8), key_ref)).get();
+   auto add = nodes.emplace_back(std::make_unique<ExpressionOp::ComputeNode>(ExpressionOp::ComputeNode::Type::Add, std::vector<ExpressionOp::Node*>{val_ref, key_cast})).get();
+   std::vector<RelAlgOpPtr> expr_children;
+   expr_children.push_back(std::move(scan));
+   auto expr = ExpressionOp::build(std::move(expr_children), "expr", std::vector<ExpressionOp::Node*>{add}, std::move(nodes));
+   const IU* sum_iu = expr->getOutput()[0];
+   ASSERT_TRUE(sum_iu->null_indicator);
+
+   std::vector<AggregateFunctions::Description> agg_fct;
+   agg_fct.push_back({.agg_iu = *val, .code = Opcode::Sum});
+   agg_fct.push_back({.agg_iu = *val, .code = Opcode::Count});
+   agg_fct.push_back({.agg_iu = *sum_iu, .code = Opcode::Count});
+   std::vector<RelAlgOpPtr> agg_children;
+   agg_children.push_back(std::move(expr));
+   auto agg = Aggregation::build(std::move(agg_children), "aggregator", std::vector<const IU*>{key}, std::move(agg_fct));
+   auto agg_out = agg->getOutput();
+   std::vector<RelAlgOpPtr> print_children;
+   print_children.push_back(std::move(agg));
+   auto root = Print::build(std::move(print_children), std::move(agg_out), {"key", "sum", "count", "count_sum"});
+   auto& printer = root->printer;
+   std::stringstream results;
+   printer->setOstream(results);
+
+   auto control_block = std::make_shared<PipelineExecutor::QueryControlBlock>(std::move(root));
+   QueryExecutor::runQuery(control_block, GetParam(), "null_aggregation");
+
+   // Compute the expected result.
+   std::map<std::string, std::tuple<int64_t, int64_t, int64_t>> expected;
+   for (size_t k = 0; k < num_rows; ++k) {
+      const bool key_null = k % 5 == 0;
+      const bool val_null = k % 3 == 0 || k % 4 == 3;
+      auto& [sum, count, count_sum] = expected[key_null ? "NULL" : std::to_string(k % 4)];
+      if (!val_null) {
+         sum += k;
+         count++;
+         if (!key_null) {
+            count_sum++;
+         }
+      }
+   }
+   std::set<std::string> expected_lines;
+   for (const auto& [k, v] : expected) {
+      // The sum over only NULLs is NULL.
+      const std::string sum = std::get<1>(v) == 0 ? "NULL" : std::to_string(std::get<0>(v));
+      expected_lines.insert(k + "," + sum + "," + std::to_string(std::get<1>(v)) + "," + std::to_string(std::get<2>(v)));
+   }
+   std::set<std::string> lines;
+   std::string line;
+   // Skip the header.
+   std::getline(results, line);
+   while (std::getline(results, line)) {
+      lines.insert(line);
+   }
+   EXPECT_EQ(lines, expected_lines);
+}
+
+// SELECT key, avg(val), avg(dec) FROM t GROUP BY key
+// The average over only NULLs is NULL and must not divide by zero.
+TEST_P(NullAggTestT, avg_over_nulls) {
+   auto scan = TableScan::build(rel, {"key", "val", "dec"}, "scan");
+   const IU* key = scan->getOutput()[0];
+   const IU* val = scan->getOutput()[1];
+   const IU* dec = scan->getOutput()[2];
+
+   std::vector<AggregateFunctions::Description> agg_fct;
+   agg_fct.push_back({.agg_iu = *val, .code = Opcode::Avg});
+   agg_fct.push_back({.agg_iu = *dec, .code = Opcode::Avg});
+   std::vector<RelAlgOpPtr> agg_children;
+   agg_children.push_back(std::move(scan));
+   auto agg = Aggregation::build(std::move(agg_children), "aggregator", std::vector<const IU*>{key}, std::move(agg_fct));
+   auto agg_out = agg->getOutput();
+   ASSERT_TRUE(agg_out[1]->null_indicator);
+   ASSERT_TRUE(agg_out[2]->null_indicator);
+   std::vector<RelAlgOpPtr> print_children;
+   print_children.push_back(std::move(agg));
+   auto root = Print::build(std::move(print_children), std::move(agg_out), {"key", "avg", "avg_dec"});
+   std::stringstream results;
+   root->printer->setOstream(results);
+
+   auto control_block = std::make_shared<PipelineExecutor::QueryControlBlock>(std::move(root));
+   QueryExecutor::runQuery(control_block, GetParam(), "null_avg_aggregation");
+
+   std::map<std::string, std::pair<int64_t, int64_t>> expected;
+   for (size_t k = 0; k < num_rows; ++k) {
+      auto& [sum, count] = expected[k % 5 == 0 ? "NULL" : std::to_string(k % 4)];
+      if (k % 3 != 0 && k % 4 != 3) {
+         sum += k;
+         count++;
+      }
+   }
+   ASSERT_EQ(expected["3"].second, 0);
+
+   std::string line;
+   // Skip the header.
+   std::getline(results, line);
+   size_t num_lines = 0;
+   while (std::getline(results, line)) {
+      num_lines++;
+      std::stringstream stream(line);
+      std::vector<std::string> cols;
+      std::string col;
+      while (std::getline(stream, col, ',')) {
+         cols.push_back(col);
+      }
+      ASSERT_EQ(cols.size(), 3);
+      ASSERT_TRUE(expected.count(cols[0]));
+      const auto [sum, count] = expected[cols[0]];
+      if (count == 0) {
+         EXPECT_EQ(cols[1], "NULL");
+         EXPECT_EQ(cols[2], "NULL");
+         continue;
+      }
+      EXPECT_NEAR(std::stod(cols[1]), static_cast<double>(sum) / count, 1e-6);
+      // Decimal averages keep four more fractional digits.
+      EXPECT_EQ(cols[2], helpers::decimalIntToStr(static_cast<__int128>(sum) * 10'000 / count, 6));
+   }
+   EXPECT_EQ(num_lines, expected.size());
+}
+
+INSTANTIATE_TEST_CASE_P(
+   NullAggregationTest,
+   NullAggTestT,
+   ::testing::Values(
+      PipelineExecutor::ExecutionMode::Fused,
+      PipelineExecutor::ExecutionMode::Interpreted,
+      PipelineExecutor::ExecutionMode::Hybrid));
+
+struct NullKeyAggTestT : public ::testing::TestWithParam<PipelineExecutor::ExecutionMode> {
+   NullKeyAggTestT() {
+      rel.attachPODColumn("date", IR::Date::build(), true);
+      rel.attachPODColumn("char", IR::Char::build(), true);
+      rel.attachStringColumn("str", true);
+      rel.attachPODColumn("val", IR::UnsignedInt::build(4));
+      for (size_t k = 0; k < num_rows; ++k) {
+         const bool null = k % 5 == 0;
+         const std::string group = std::to_string(k % 4);
+         const std::string date = null ? "" : "1996-0" + std::to_string(k % 4 + 1) + "-15";
+         const std::string chr = null ? "" : std::string(1, static_cast<char>('a' + k % 4));
+         const std::string str = null ? "" : "str_" + group;
+         rel.loadRow(date + "|" + chr + "|" + str + "|" + std::to_string(k) + "|");
+      }
+   }
+
+   /// SELECT key, count(val) FROM t GROUP BY key
+   std::set<std::string> groupBy(std::string_view column) {
+      auto scan = TableScan::build(rel, {std::string(column), "val"}, "scan");
+      const IU* key = scan->getOutput()[0];
+      const IU* val = scan->getOutput()[1];
+      EXPECT_TRUE(key->null_indicator);
+      std::vector<AggregateFunctions::Description> agg_fct;
+      agg_fct.push_back({.agg_iu = *val, .code = Opcode::Count});
+      std::vector<RelAlgOpPtr> agg_children;
+      agg_children.push_back(std::move(scan));
+      auto agg = Aggregation::build(std::move(agg_children), "aggregator", std::vector<const IU*>{key}, std::move(agg_fct));
+      auto agg_out = agg->getOutput();
+      std::vector<RelAlgOpPtr> print_children;
+      print_children.push_back(std::move(agg));
+      auto root = Print::build(std::move(print_children), std::move(agg_out), {"key", "count"});
+      std::stringstream results;
+      root->printer->setOstream(results);
+
+      auto control_block = std::make_shared<PipelineExecutor::QueryControlBlock>(std::move(root));
+      QueryExecutor::runQuery(control_block, GetParam(), "null_key_aggregation");
+
+      std::set<std::string> lines;
+      std::string line;
+      // Skip the header.
+      std::getline(results, line);
+      while (std::getline(results, line)) {
+         lines.insert(line);
+      }
+      return lines;
+   }
+
+   /// The expected groups, `keys[g]` is the key of group `g`.
+   std::set<std::string> expected(const std::vector<std::string>& keys) {
+      std::map<std::string, size_t> counts;
+      for (size_t k = 0; k < num_rows; ++k) {
+         counts[k % 5 == 0 ? "NULL" : keys[k % 4]]++;
+      }
+      std::set<std::string> lines;
+      for (const auto& [key, count] : counts) {
+         lines.insert(key + "," + std::to_string(count));
+      }
+      return lines;
+   }
+
+   const size_t num_rows = 1000;
+   StoredRelation rel;
+};
+
+// NULL keys of non-integer types form a single group of their own.
+TEST_P(NullKeyAggTestT, date_key) {
+   EXPECT_EQ(groupBy("date"), expected({"1996-01-15", "1996-02-15", "1996-03-15", "1996-04-15"}));
+}
+
+TEST_P(NullKeyAggTestT, char_key) {
+   EXPECT_EQ(groupBy("char"), expected({"a", "b", "c", "d"}));
+}
+
+TEST_P(NullKeyAggTestT, string_key) {
+   EXPECT_EQ(groupBy("str"), expected({"str_0", "str_1", "str_2", "str_3"}));
+}
+
+INSTANTIATE_TEST_CASE_P(
+   NullKeyAggregationTest,
+   NullKeyAggTestT,
+   ::testing::Values(
+      PipelineExecutor::ExecutionMode::Fused,
+      PipelineExecutor::ExecutionMode::Interpreted,
+      PipelineExecutor::ExecutionMode::Hybrid));
+
+struct MinMaxAggTestT : public ::testing::TestWithParam<PipelineExecutor::ExecutionMode> {
+   MinMaxAggTestT() {
+      rel.attachPODColumn("key", IR::UnsignedInt::build(4));
+      rel.attachPODColumn("val", IR::SignedInt::build(8), true);
+      rel.attachStringColumn("str");
+      for (size_t k = 0; k < num_rows; ++k) {
+         // Key 4 only sees NULL values.
+         const size_t key = k % 5;
+         std::string val = (k % 3 == 0 || key == 4) ? "" : std::to_string(static_cast<int64_t>((k * 7919) % 1000) - 500);
+         std::string str = "s_" + std::to_string((k * 31) % 97);
+         rel.loadRow(std::to_string(key) + "|" + val + "|" + str + "|");
+      }
+   }
+
+   const size_t num_rows = 20'000;
+   StoredRelation rel;
+};
+
+// SELECT key, min(val), max(val), min(str), max(str) FROM t GROUP BY key
+// With NULLs in val, run on multiple threads to merge the thread-local states.
+TEST_P(MinMaxAggTestT, nullable_and_strings) {
+   auto scan = TableScan::build(rel, {"key", "val", "str"}, "scan");
+   const IU* key = scan->getOutput()[0];
+   const IU* val = scan->getOutput()[1];
+   const IU* str = scan->getOutput()[2];
+
+   std::vector<AggregateFunctions::Description> agg_fct;
+   agg_fct.push_back({.agg_iu = *val, .code = Opcode::Min});
+   agg_fct.push_back({.agg_iu = *val, .code = Opcode::Max});
+   agg_fct.push_back({.agg_iu = *str, .code = Opcode::Min});
+   agg_fct.push_back({.agg_iu = *str, .code = Opcode::Max});
+   std::vector<RelAlgOpPtr> agg_children;
+   agg_children.push_back(std::move(scan));
+   auto agg = Aggregation::build(std::move(agg_children), "aggregator", std::vector<const IU*>{key}, std::move(agg_fct));
+   auto agg_out = agg->getOutput();
+   std::vector<RelAlgOpPtr> print_children;
+   print_children.push_back(std::move(agg));
+   auto root = Print::build(std::move(print_children), std::move(agg_out), {"key", "min_val", "max_val", "min_str", "max_str"});
+   auto& printer = root->printer;
+   std::stringstream results;
+   printer->setOstream(results);
+
+   auto control_block = std::make_shared<PipelineExecutor::QueryControlBlock>(std::move(root));
+   QueryExecutor::runQuery(control_block, GetParam(), "min_max_aggregation", 4);
+
+   // Compute the expected result. Groups without non-NULL values produce NULL.
+   std::map<size_t, std::tuple<std::optional<int64_t>, std::optional<int64_t>, std::string, std::string>> expected;
+   for (size_t k = 0; k < num_rows; ++k) {
+      auto& [min_val, max_val, min_str, max_str] = expected[k % 5];
+      if (k % 3 != 0 && k % 5 != 4) {
+         const int64_t val = static_cast<int64_t>((k * 7919) % 1000) - 500;
+         min_val = std::min(min_val.value_or(val), val);
+         max_val = std::max(max_val.value_or(val), val);
+      }
+      std::string str = "s_" + std::to_string((k * 31) % 97);
+      min_str = min_str.empty() ? str : std::min(min_str, str);
+      max_str = std::max(max_str, str);
+   }
+   auto print = [](const std::optional<int64_t>& val) {
+      return val ? std::to_string(*val) : std::string("NULL");
+   };
+   std::set<std::string> expected_lines;
+   for (const auto& [k, v] : expected) {
+      expected_lines.insert(std::to_string(k) + "," + print(std::get<0>(v)) + "," + print(std::get<1>(v)) + "," + std::get<2>(v) + "," + std::get<3>(v));
+   }
+   std::set<std::string> lines;
+   std::string line;
+   // Skip the header.
+   std::getline(results, line);
+   while (std::getline(results, line)) {
+      lines.insert(line);
+   }
+   EXPECT_EQ(lines, expected_lines);
+}
+
+struct DecimalAggTestT : public ::testing::TestWithParam<PipelineExecutor::ExecutionMode> {
+   DecimalAggTestT() {
+      rel.attachPODColumn("key", IR::UnsignedInt::build(4));
+      rel.attachPODColumn("val", IR::Decimal::build(18, 2));
+      for (size_t k = 0; k < num_rows; ++k) {
+         rel.loadRow(std::to_string(k % 3) + "|" + helpers::decimalIntToStr(value(k), 2) + "|");
+      }
+   }
+
+   /// The scaled value of row k, large enough for the sums to exceed 8 bytes.
+   static int64_t value(size_t k) {
+      return static_cast<int64_t>((k * 7919) % 100'000) * 1'000'000'000'000 + static_cast<int64_t>(k % 7);
+   }
+
+   const size_t num_rows = 20'000;
+   StoredRelation rel;
+};
+
+// SELECT key, sum(val), avg(val), min(val), max(val) FROM t GROUP BY key
+// Decimal sums are computed on 16 bytes, the average keeps four more fractional digits.
+TEST_P(DecimalAggTestT, sum_avg_min_max) {
+   auto scan = TableScan::build(rel, {"key", "val"}, "scan");
+   const IU* key = scan->getOutput()[0];
+   const IU* val = scan->getOutput()[1];
+
+   std::vector<AggregateFunctions::Description> agg_fct;
+   for (auto code : {Opcode::Sum, Opcode::Avg, Opcode::Min, Opcode::Max}) {
+      agg_fct.push_back({.agg_iu = *val, .code = code});
+   }
+   std::vector<RelAlgOpPtr> agg_children;
+   agg_children.push_back(std::move(scan));
+   auto agg = Aggregation::build(std::move(agg_children), "aggregator", std::vector<const IU*>{key}, std::move(agg_fct));
+   auto agg_out = agg->getOutput();
+   EXPECT_EQ(agg_out[1]->type->numBytes(), 16);
+   EXPECT_EQ(agg_out[2]->type->numBytes(), 16);
+   std::vector<RelAlgOpPtr> print_children;
+   print_children.push_back(std::move(agg));
+   auto root = Print::build(std::move(print_children), std::move(agg_out), {"key", "sum", "avg", "min", "max"});
+   std::stringstream results;
+   root->printer->setOstream(results);
+
+   auto control_block = std::make_shared<PipelineExecutor::QueryControlBlock>(std::move(root));
+   QueryExecutor::runQuery(control_block, GetParam(), "decimal_aggregation", 4);
+
+   std::map<size_t, std::tuple<__int128, int64_t, int64_t, int64_t>> expected;
+   for (size_t k = 0; k < num_rows; ++k) {
+      auto [it, inserted] = expected.try_emplace(k % 3, 0, 0, value(k), value(k));
+      auto& [sum, count, min, max] = it->second;
+      sum += value(k);
+      count++;
+      min = std::min(min, value(k));
+      max = std::max(max, value(k));
+   }
+   std::set<std::string> expected_lines;
+   for (const auto& [k, v] : expected) {
+      const auto& [sum, count, min, max] = v;
+      expected_lines.insert(std::to_string(k) + "," + helpers::decimalIntToStr(sum, 2) + "," + helpers::decimalIntToStr(sum * 10'000 / count, 6) + "," + helpers::decimalIntToStr(min, 2) + "," + helpers::decimalIntToStr(max, 2));
+   }
+   std::set<std::string> lines;
+   std::string line;
+   // Skip the header.
+   std::getline(results, line);
+   while (std::getline(results, line)) {
+      lines.insert(line);
+   }
+   EXPECT_EQ(lines, expected_lines);
+}
+
+struct DenseKeyAggTestT : public ::testing::TestWithParam<PipelineExecutor::ExecutionMode> {
+   DenseKeyAggTestT() {
+      rel.attachPODColumn("year", IR::SignedInt::build(2));
+      rel.attachPODColumn("flag", IR::UnsignedInt::build(1), true);
+      rel.attachPODColumn("sparse", IR::SignedInt::build(4));
+      rel.attachPODColumn("val", IR::SignedInt::build(8));
+      for (size_t k = 0; k < num_rows; ++k) {
+         // A small domain with negative values and a nullable flag next to a key with a wide range.
+         const int64_t year = static_cast<int64_t>((k * 7919) % 60) - 20;
+         std::string flag = k % 7 == 0 ? "" : std::to_string(k % 2);
+         const int64_t sparse = static_cast<int64_t>((k % 50) * 1'000'003);
+         rel.loadRow(std::to_string(year) + "|" + flag + "|" + std::to_string(sparse) + "|" + std::to_string(k % 100) + "|");
+      }
+   }
+
+   /// SELECT keys, sum(val), count(val) FROM t GROUP BY keys. Returns the printed result lines.
+   std::set<std::string> runAggregation(const std::vector<std::string>& cols) {
+      std::vector<std::string> scan_cols = cols;
+      scan_cols.push_back("val");
+      auto scan = TableScan::build(rel, scan_cols, "scan");
+      auto scan_out = scan->getOutput();
+      std::vector<AggregateFunctions::Description> agg_fct;
+      agg_fct.push_back({.agg_iu = *scan_out.back(), .code = Opcode::Sum});
+      agg_fct.push_back({.agg_iu = *scan_out.back(), .code = Opcode::Count});
+      std::vector<RelAlgOpPtr> agg_children;
+      agg_children.push_back(std::move(scan));
+      auto agg = Aggregation::build(std::move(agg_children), "aggregator", std::vector<const IU*>(scan_out.begin(), scan_out.end() - 1), std::move(agg_fct));
+      auto agg_out = agg->getOutput();
+      std::vector<RelAlgOpPtr> print_children;
+      print_children.push_back(std::move(agg));
+      std::vector<std::string> colnames = cols;
+      colnames.push_back("sum");
+      colnames.push_back("count");
+      auto root = Print::build(std::move(print_children), std::move(agg_out), std::move(colnames));
+      std::stringstream results;
+      root->printer->setOstream(results);
+
+      auto control_block = std::make_shared<PipelineExecutor::QueryControlBlock>(std::move(root));
+      QueryExecutor::runQuery(control_block, GetParam(), "dense_key_aggregation", 4);
+      std::set<std::string> lines;
+      std::string line;
+      // Skip the header.
+      std::getline(results, line);
+      while (std::getline(results, line)) {
+         lines.insert(line);
+      }
+      return lines;
+   }
+
+   const size_t num_rows = 20'000;
+   StoredRelation rel;
+};
+
+// SELECT year, flag, sum(val), count(val) FROM t GROUP BY year, flag
+// The key ranges are small, the aggregation uses a direct lookup table.
+TEST_P(DenseKeyAggTestT, dense_keys) {
+   auto lines = runAggregation({"year", "flag"});
+   std::map<std::pair<int64_t, std::string>, std::pair<int64_t, int64_t>> expected;
+   for (size_t k = 0; k < num_rows; ++k) {
+      const int64_t year = static_cast<int64_t>((k * 7919) % 60) - 20;
+      auto& [sum, count] = expected[{year, k % 7 == 0 ? "NULL" : std::to_string(k % 2)}];
+      sum += k % 100;
+      count++;
+   }
+   std::set<std::string> expected_lines;
+   for (const auto& [key, aggs] : expected) {
+      expected_lines.insert(std::to_string(key.first) + "," + key.second + "," + std::to_string(aggs.first) + "," + std::to_string(aggs.second));
+   }
+   EXPECT_EQ(lines, expected_lines);
+}
+
+// SELECT sparse, sum(val), count(val) FROM t GROUP BY sparse
+// The key range is too large for a direct lookup table, the aggregation falls back to hashing.
+TEST_P(DenseKeyAggTestT, sparse_key) {
+   auto lines = runAggregation({"sparse"});
+   std::set<std::string> expected_lines;
+   for (size_t group = 0; group < 50; ++group) {
+      // Rows k with k % 50 == group have val k % 100, which alternates between group and group + 50.
+      const int64_t rows = num_rows / 50;
+      const int64_t sum = rows / 2 * static_cast<int64_t>(group) + rows / 2 * static_cast<int64_t>(group + 50);
+      expected_lines.insert(std::to_string(group * 1'000'003) + "," + std::to_string(sum) + "," + std::to_string(rows));
+   }
+   EXPECT_EQ(lines, expected_lines);
+}
+
+struct HighCardinalityAggTestT : public ::testing::TestWithParam<PipelineExecutor::ExecutionMode> {
+   HighCardinalityAggTestT() {
+      rel.attachPODColumn("key", IR::UnsignedInt::build(8));
+      rel.attachPODColumn("val", IR::SignedInt::build(8));
+      for (size_t k = 0; k < num_rows; ++k) {
+         rel.loadRow(std::to_string(key(k)) + "|" + std::to_string(k % 100) + "|");
+      }
+   }
+
+   /// Every key appears exactly twice, once in each half of the relation.
+   uint64_t key(size_t k) const {
+      return (k * 7919) % (num_rows / 2);
+   }
+
+   const size_t num_rows = 400'000;
+   StoredRelation rel;
+};
+
+// SELECT key, sum(val), count(val), max(val) FROM t GROUP BY key
+// Almost every row creates a new group in the thread-local tables. They stop pre-aggregating
+// and scatter the remaining rows into the pass-through partitions of the merge phase.
+TEST_P(HighCardinalityAggTestT, pass_through) {
+   auto scan = TableScan::build(rel, {"key", "val"}, "scan");
+   auto scan_out = scan->getOutput();
+   std::vector<AggregateFunctions::Description> agg_fct;
+   agg_fct.push_back({.agg_iu = *scan_out[1], .code = Opcode::Sum});
+   agg_fct.push_back({.agg_iu = *scan_out[1], .code = Opcode::Count});
+   agg_fct.push_back({.agg_iu = *scan_out[1], .code = Opcode::Max});
+   std::vector<RelAlgOpPtr> agg_children;
+   agg_children.push_back(std::move(scan));
+   auto agg = Aggregation::build(std::move(agg_children), "aggregator", {scan_out[0]}, std::move(agg_fct));
+   auto agg_out = agg->getOutput();
+   std::vector<RelAlgOpPtr> print_children;
+   print_children.push_back(std::move(agg));
+   auto root = Print::build(std::move(print_children), std::move(agg_out), {"key", "sum", "count", "max"});
+   std::stringstream results;
+   root->printer->setOstream(results);
+   auto control_block = std::make_shared<PipelineExecutor::QueryControlBlock>(std::move(root));
+   QueryExecutor::runQuery(control_block, GetParam(), "high_cardinality_aggregation", 4);
+
+   std::map<uint64_t, std::tuple<int64_t, int64_t, int64_t>> expected;
+   for (size_t k = 0; k < num_rows; ++k) {
+      auto& [sum, count, max] = expected[key(k)];
+      sum += k % 100;
+      count++;
+      max = std::max(max, static_cast<int64_t>(k % 100));
+   }
+   std::set<std::string> expected_lines;
+   for (const auto& [key, aggs] : expected) {
+      expected_lines.insert(std::to_string(key) + "," + std::to_string(std::get<0>(aggs)) + "," + std::to_string(std::get<1>(aggs)) + "," + std::to_string(std::get<2>(aggs)));
+   }
+   std::set<std::string> lines;
+   std::string line;
+   // Skip the header.
+   std::getline(results, line);
+   size_t num_lines = 0;
+   while (std::getline(results, line)) {
+      lines.insert(line);
+      num_lines++;
+   }
+   // Every group is produced exactly once.
+   EXPECT_EQ(num_lines, num_rows / 2);
+   EXPECT_EQ(lines, expected_lines);
+}
+
+struct DistinctAggTestT : public ::testing::TestWithParam<PipelineExecutor::ExecutionMode> {
+   DistinctAggTestT() {
+      rel.attachPODColumn("key", IR::UnsignedInt::build(4));
+      rel.attachPODColumn("val", IR::SignedInt::build(8), true);
+      rel.attachStringColumn("str");
+      for (size_t k = 0; k < num_rows; ++k) {
+         std::string val = k % 11 == 0 ? "" : std::to_string(value(k));
+         rel.loadRow(std::to_string(k % 7) + "|" + val + "|" + "s_" + std::to_string(k % 1000) + "|");
+      }
+   }
+
+   /// The non-NULL value of row k, has around 1500 distinct values per key.
+   static int64_t value(size_t k) {
+      return static_cast<int64_t>((k * 7919) % 1500);
+   }
+
+   /// Run the query and return the result lines without the header.
+   std::vector<std::string> run(RelAlgOpPtr agg, std::vector<std::string> colnames) {
+      auto agg_out = agg->getOutput();
+      std::vector<RelAlgOpPtr> print_children;
+      print_children.push_back(std::move(agg));
+      auto root = Print::build(std::move(print_children), std::move(agg_out), std::move(colnames));
+      std::stringstream results;
+      root->printer->setOstream(results);
+      auto control_block = std::make_shared<PipelineExecutor::QueryControlBlock>(std::move(root));
+      QueryExecutor::runQuery(control_block, GetParam(), "distinct_aggregation", 4);
+      std::vector<std::string> lines;
+      std::string line;
+      std::getline(results, line);
+      while (std::getline(results, line)) {
+         lines.push_back(line);
+      }
+      return lines;
+   }
+
+   const size_t num_rows = 50'000;
+   StoredRelation rel;
+};
+
+// SELECT key, count(DISTINCT val), sum(DISTINCT val), count(val), sum(val), approx_count_distinct(val) FROM t GROUP BY key
+TEST_P(DistinctAggTestT, grouped) {
+   auto scan = TableScan::build(rel, {"key", "val"}, "scan");
+   const IU* key = scan->getOutput()[0];
+   const IU* val = scan->getOutput()[1];
+   std::vector<AggregateFunctions::Description> agg_fct;
+   agg_fct.push_back({.agg_iu = *val, .code = Opcode::Count, .distinct = true});
+   agg_fct.push_back({.agg_iu = *val, .code = Opcode::Sum, .distinct = true});
+   agg_fct.push_back({.agg_iu = *val, .code = Opcode::Count});
+   agg_fct.push_back({.agg_iu = *val, .code = Opcode::Sum});
+   agg_fct.push_back({.agg_iu = *val, .code = Opcode::ApproxCountDistinct});
+   std::vector<RelAlgOpPtr> children;
+   children.push_back(std::move(scan));
+   auto agg = Aggregation::build(std::move(children), "aggregator", std::vector<const IU*>{key}, std::move(agg_fct));
+   auto lines = run(std::move(agg), {"key", "count_distinct", "sum_distinct", "count", "sum", "approx"});
+
+   std::map<uint32_t, std::set<int64_t>> distinct;
+   std::map<uint32_t, std::pair<int64_t, int64_t>> regular;
+   for (size_t k = 0; k < num_rows; ++k) {
+      if (k % 11 != 0) {
+         distinct[k % 7].insert(value(k));
+         regular[k % 7].first++;
+         regular[k % 7].second += value(k);
+      }
+   }
+   ASSERT_EQ(lines.size(), 7);
+   for (const auto& line : lines) {
+      std::stringstream stream(line);
+      std::vector<int64_t> cols;
+      std::string col;
+      while (std::getline(stream, col, ',')) {
+         cols.push_back(std::stoll(col));
+      }
+      ASSERT_EQ(cols.size(), 6);
+      const auto& values = distinct[cols[0]];
+      EXPECT_EQ(cols[1], values.size());
+      EXPECT_EQ(cols[2], std::accumulate(values.begin(), values.end(), int64_t{0}));
+      EXPECT_EQ(cols[3], regular[cols[0]].first);
+      EXPECT_EQ(cols[4], regular[cols[0]].second);
+      // The sketch has a standard error of around 6.5%.
+      EXPECT_NEAR(cols[5], values.size(), 0.2 * values.size());
+   }
+}
+
+// SELECT count(DISTINCT str), approx_count_distinct(str) FROM t
+TEST_P(DistinctAggTestT, ungrouped_strings) {
+   auto scan = TableScan::build(rel, {"str"}, "scan");
+   const IU* str = scan->getOutput()[0];
+   std::vector<AggregateFunctions::Description> agg_fct;
+   agg_fct.push_back({.agg_iu = *str, .code = Opcode::Count, .distinct = true});
+   agg_fct.push_back({.agg_iu = *str, .code = Opcode::ApproxCountDistinct});
+   std::vector<RelAlgOpPtr> children;
+   children.push_back(std::move(scan));
+   auto agg = Aggregation::build(std::move(children), "aggregator", std::vector<const IU*>{}, std::move(agg_fct));
+   auto lines = run(std::move(agg), {"count_distinct", "approx"});
+   ASSERT_EQ(lines.size(), 1);
+   const auto sep = lines[0].find(',');
+   EXPECT_EQ(std::stoll(lines[0].substr(0, sep)), 1000);
+   EXPECT_NEAR(std::stoll(lines[0].substr(sep + 1)), 1000, 200);
+}
+
+struct QuantileAggTestT : public ::testing::TestWithParam<PipelineExecutor::ExecutionMode> {
+   QuantileAggTestT() {
+      rel.attachPODColumn("key", IR::UnsignedInt::build(4));
+      rel.attachPODColumn("val", IR::SignedInt::build(8), true);
+      for (size_t k = 0; k < num_rows; ++k) {
+         // Key 4 only sees NULL values.
+         const size_t key = k % 5;
+         std::string val;
+         if (k % 7 != 0 && key != 4) {
+            val = std::to_string(value(k));
+            values[key].push_back(value(k));
+         }
+         rel.loadRow(std::to_string(key) + "|" + val + "|");
+      }
+   }
+
+   /// Skewed values, half of the groups have an even number of values.
+   static int64_t value(size_t k) {
+      const int64_t base = static_cast<int64_t>((k * 7919) % 10'007);
+      return base * base / 100;
+   }
+
+   /// Fraction of the values of a group that are smaller than the estimate.
+   double rank(size_t key, double estimate) {
+      const auto& group = values[key];
+      return static_cast<double>(std::count_if(group.begin(), group.end(), [&](int64_t val) { return val < estimate; })) / group.size();
+   }
+
+   const size_t num_rows = 100'001;
+   StoredRelation rel;
+   std::map<size_t, std::vector<int64_t>> values;
+};
+
+// SELECT key, median(val), approx_quantile(val, 0.5), approx_quantile(val, 0.9) FROM t GROUP BY key
+// With NULLs in val, run on multiple threads to merge the thread-local states.
+TEST_P(QuantileAggTestT, median_and_quantiles) {
+   auto scan = TableScan::build(rel, {"key", "val"}, "scan");
+   const IU* key = scan->getOutput()[0];
+   const IU* val = scan->getOutput()[1];
+   std::vector<AggregateFunctions::Description> agg_fct;
+   agg_fct.push_back({.agg_iu = *val, .code = Opcode::Median});
+   agg_fct.push_back({.agg_iu = *val, .code = Opcode::ApproxQuantile, .quantile = 0.5});
+   agg_fct.push_back({.agg_iu = *val, .code = Opcode::ApproxQuantile, .quantile = 0.9});
+   std::vector<RelAlgOpPtr> agg_children;
+   agg_children.push_back(std::move(scan));
+   auto agg = Aggregation::build(std::move(agg_children), "aggregator", std::vector<const IU*>{key}, std::move(agg_fct));
+   auto agg_out = agg->getOutput();
+   std::vector<RelAlgOpPtr> print_children;
+   print_children.push_back(std::move(agg));
+   auto root = Print::build(std::move(print_children), std::move(agg_out), {"key", "median", "p50", "p90"});
+   std::stringstream results;
+   root->printer->setOstream(results);
+   auto control_block = std::make_shared<PipelineExecutor::QueryControlBlock>(std::move(root));
+   QueryExecutor::runQuery(control_block, GetParam(), "quantile_aggregation", 4);
+
+   std::string line;
+   // Skip the header.
+   std::getline(results, line);
+   size_t num_lines = 0;
+   while (std::getline(results, line)) {
+      num_lines++;
+      std::stringstream stream(line);
+      std::vector<std::string> strs;
+      std::string col;
+      while (std::getline(stream, col, ',')) {
+         strs.push_back(col);
+      }
+      ASSERT_EQ(strs.size(), 4);
+      const auto key = std::stoull(strs[0]);
+      if (key == 4) {
+         // Groups without non-NULL values produce NULL.
+         EXPECT_EQ(strs[1], "NULL");
+         EXPECT_EQ(strs[2], "NULL");
+         EXPECT_EQ(strs[3], "NULL");
+         continue;
+      }
+      std::vector<double> cols;
+      for (const auto& str : strs) {
+         cols.push_back(std::stod(str));
+      }
+      auto group = values[key];
+      std::sort(group.begin(), group.end());
+      const size_t mid = group.size() / 2;
+      const double median = group.size() % 2 ? group[mid] : (group[mid - 1] + group[mid]) / 2.0;
+      EXPECT_DOUBLE_EQ(cols[1], median);
+      EXPECT_NEAR(rank(key, cols[2]), 0.5, 0.01);
+      EXPECT_NEAR(rank(key, cols[3]), 0.9, 0.01);
+   }
+   EXPECT_EQ(num_lines, 5);
+}
+
+INSTANTIATE_TEST_CASE_P(
+   QuantileAggregationTest,
+   QuantileAggTestT,
+   ::testing::Values(
+      PipelineExecutor::ExecutionMode::Fused,
+      PipelineExecutor::ExecutionMode::Interpreted,
+      PipelineExecutor::ExecutionMode::ROF,
+      PipelineExecutor::ExecutionMode::Hybrid));
+
+INSTANTIATE_TEST_CASE_P(
+   DistinctAggregationTest,
+   DistinctAggTestT,
+   ::testing::Values(
+      PipelineExecutor::ExecutionMode::Fused,
+      PipelineExecutor::ExecutionMode::Interpreted,
+      PipelineExecutor::ExecutionMode::ROF,
+      PipelineExecutor::ExecutionMode::Hybrid));
+
+INSTANTIATE_TEST_CASE_P(
+   MinMaxAggregationTest,
+   MinMaxAggTestT,
+   ::testing::Values(
+      PipelineExecutor::ExecutionMode::Fused,
+      PipelineExecutor::ExecutionMode::Interpreted,
+      PipelineExecutor::ExecutionMode::ROF,
+      PipelineExecutor::ExecutionMode::Hybrid));
+
+INSTANTIATE_TEST_CASE_P(
+   DecimalAggregationTest,
+   DecimalAggTestT,
+   ::testing::Values(
+      PipelineExecutor::ExecutionMode::Fused,
+      PipelineExecutor::ExecutionMode::Interpreted,
+      PipelineExecutor::ExecutionMode::ROF,
+      PipelineExecutor::ExecutionMode::Hybrid));
+
+INSTANTIATE_TEST_CASE_P(
+   DenseKeyAggregationTest,
+   DenseKeyAggTestT,
+   ::testing::Values(
+      PipelineExecutor::ExecutionMode::Fused,
+      PipelineExecutor::ExecutionMode::Interpreted,
+      PipelineExecutor::ExecutionMode::ROF,
+      PipelineExecutor::ExecutionMode::Hybrid));
+
+INSTANTIATE_TEST_CASE_P(
+   HighCardinalityAggregationTest,
+   HighCardinalityAggTestT,
+   ::testing::Values(
+      PipelineExecutor::ExecutionMode::Fused,
+      PipelineExecutor::ExecutionMode::Interpreted,
+      PipelineExecutor::ExecutionMode::ROF,
+      PipelineExecutor::ExecutionMode::Hybrid));
 }
 }
@@ -0,0 +1,210 @@
+#include "algebra/ArrowExport.h"
+#include "algebra/ExpressionOp.h"
+#include "algebra/TableScan.h"
+#include "exec/QueryExecutor.h"
+#include "gtest/gtest.h"
+#include <cstring>
+#include <mutex>
+
+namespace inkfuse {
+
+namespace {
+
+bool bitSet(const void* bitmap, size_t idx) {
+   return (static_cast<const uint8_t*>(bitmap)[idx / 8] >> (idx % 8)) & 1;
+}
+
+struct ArrowExportTestT : public ::testing::TestWithParam<PipelineExecutor::ExecutionMode> {
+   ArrowExportTestT() {
+      rel.attachPODColumn("id", IR::UnsignedInt::build(8));
+      rel.attachPODColumn("val", IR::SignedInt::build(4), true);
+      rel.attachStringColumn("name", true);
+      rel.attachPODColumn("flag", IR::Char::build());
+      for (size_t k = 0; k < num_rows; ++k) {
+         std::string val = k % 3 == 0 ? "" : std::to_string(k % 100);
+         std::string name = k % 5 == 0 ? "" : "name_" + std::to_string(k);
+         std::string flag(1, static_cast<char>('a' + k % 3));
+         rel.loadRow(std::to_string(k) + "|" + val + "|" + name + "|" + flag + "|");
+      }
+   }
+
+   const size_t num_rows = 5000;
+   StoredRelation rel;
+};
+
+// SELECT id, val, name, flag, 10 < val FROM t, exported as Arrow record batches.
+TEST_P(ArrowExportTestT, export_batches) {
+   auto scan = TableScan::build(rel, {"id", "val", "name", "flag"}, "scan");
+   auto scan_out = scan->getOutput();
+   std::vector<ExpressionOp::NodePtr> nodes;
+   auto val_ref = nodes.emplace_back(std::make_unique<ExpressionOp::IURefNode>(scan_out[1])).get();
+   auto is_big = nodes.emplace_back(std::make_unique<ExpressionOp::ComputeNode>(ExpressionOp::ComputeNode::Type::Less, IR::SI<4>::build(10), val_ref)).get();
+   std::vector<RelAlgOpPtr> expr_children;
+   expr_children.push_back(std::move(scan));
+   auto expr = ExpressionOp::build(std::move(expr_children), "expr", std::vector<ExpressionOp::Node*>{is_big}, std::move(nodes));
+   std::vector<const IU*> out_ius = scan_out;
+   out_ius.push_back(expr->getOutput()[0]);
+   std::vector<RelAlgOpPtr> export_children;
+   export_children.push_back(std::move(expr));
+   auto root = ArrowExport::build(std::move(export_children), out_ius, {"id", "val", "name", "flag", "big"});
+   auto& exporter = *root->exporter;
+
+   ArrowSchema schema;
+   exporter.exportSchema(&schema);
+   ASSERT_STREQ(schema.format, "+s");
+   ASSERT_EQ(schema.n_children, 5);
+   EXPECT_STREQ(schema.children[0]->format, "L");
+   EXPECT_STREQ(schema.children[1]->format, "i");
+   EXPECT_STREQ(schema.children[2]->format, "u");
+   EXPECT_STREQ(schema.children[3]->format, "w:1");
+   EXPECT_STREQ(schema.children[4]->format, "b");
+   EXPECT_STREQ(schema.children[2]->name, "name");
+   EXPECT_EQ(schema.children[0]->flags, 0);
+   EXPECT_EQ(schema.children[1]->flags, ARROW_FLAG_NULLABLE);
+   EXPECT_EQ(schema.children[4]->flags, ARROW_FLAG_NULLABLE);
+   schema.release(&schema);
+   EXPECT_EQ(schema.release, nullptr);
+
+   std::mutex seen_mut;
+   std::vector<bool> seen(num_rows, false);
+   size_t errors = 0;
+   exporter.setCallback([&](size_t, ArrowArray* batch) {
+      std::unique_lock lock(seen_mut);
+      EXPECT_EQ(batch->n_children, 5);
+      auto ids = static_cast<const uint64_t*>(batch->children[0]->buffers[1]);
+      auto vals = batch->children[1];
+      auto names = batch->children[2];
+      auto flags = static_cast<const char*>(batch->children[3]->buffers[1]);
+      auto big = batch->children[4];
+      for (int64_t row = 0; row < batch->length; ++row) {
+         const uint64_t id = ids[row];
+         seen[id] = true;
+         const bool val_null = id % 3 == 0;
+         errors += bitSet(vals->buffers[0], row) == val_null;
+         errors += bitSet(big->buffers[0], row) == val_null;
+         if (!val_null) {
+            errors += static_cast<const int32_t*>(vals->buffers[1])[row] != static_cast<int32_t>(id % 100);
+            errors += bitSet(big->buffers[1], row) != (id % 100 > 10);
+         }
+         auto offsets = static_cast<const int32_t*>(names->buffers[1]);
+         std::string name(static_cast<const char*>(names->buffers[2]) + offsets[row], offsets[row + 1] - offsets[row]);
+         if (id % 5 == 0) {
+            errors += bitSet(names->buffers[0], row);
+         } else {
+            errors += name != "name_" + std::to_string(id);
+         }
+         errors += flags[row] != static_cast<char>('a' + id % 3);
+      }
+      batch->release(batch);
+   });
+
+   auto control_block = std::make_shared<PipelineExecutor::QueryControlBlock>(std::move(root));
+   QueryExecutor::runQuery(control_block, GetParam(), "arrow_export", 4);
+
+   EXPECT_EQ(errors, 0);
+   EXPECT_EQ(exporter.num_rows, num_rows);
+   EXPECT_GT(exporter.num_batches, 0);
+   for (bool s : seen) {
+      EXPECT_TRUE(s);
+   }
+}
+
+// Batches stay valid after the callback returned, until the consumer releases them.
+TEST_P(ArrowExportTestT, batches_outlive_callback) {
+   auto scan = TableScan::build(rel, {"id", "name"}, "scan");
+   auto scan_out = scan->getOutput();
+   std::vector<RelAlgOpPtr> export_children;
+   export_children.push_back(std::move(scan));
+   auto root = ArrowExport::build(std::move(export_children), scan_out, {"id", "name"});
+   auto& exporter = *root->exporter;
+
+   std::mutex batches_mut;
+   std::vector<ArrowArray> batches;
+   exporter.setCallback([&](size_t, ArrowArray* batch) {
+      std::unique_lock lock(batches_mut);
+      // Move the batch out of the callback.
+      batches.push_back(*batch);
+      batch->release = nullptr;
+   });
+
+   auto control_block = std::make_shared<PipelineExecutor::QueryControlBlock>(std::move(root));
+   QueryExecutor::runQuery(control_block, GetParam(), "arrow_export_outlive", 4);
+
+   std::vector<bool> seen(num_rows, false);
+   size_t errors = 0;
+   for (auto& batch : batches) {
+      auto ids = static_cast<const uint64_t*>(batch.children[0]->buffers[1]);
+      auto names = batch.children[1];
+      auto offsets = static_cast<const int32_t*>(names->buffers[1]);
+      for (int64_t row = 0; row < batch.length; ++row) {
+         const uint64_t id = ids[row];
+         ASSERT_LT(id, num_rows);
+         seen[id] = true;
+         std::string name(static_cast<const char*>(names->buffers[2]) + offsets[row], offsets[row + 1] - offsets[row]);
+         errors += id % 5 != 0 && name != "name_" + std::to_string(id);
+      }
+      batch.release(&batch);
+      EXPECT_EQ(batch.release, nullptr);
+   }
+   EXPECT_EQ(errors, 0);
+   for (bool s : seen) {
+      EXPECT_TRUE(s);
+   }
+}
+
+// Computed columns hand their memory to the batch. Later morsels must not write into it.
+TEST_P(ArrowExportTestT, handed_over_buffers) {
+   auto scan = TableScan::build(rel, {"id"}, "scan");
+   auto scan_out = scan->getOutput();
+   std::vector<ExpressionOp::NodePtr> nodes;
+   auto id_ref = nodes.emplace_back(std::make_unique<ExpressionOp::IURefNode>(scan_out[0])).get();
+   auto plus_one = nodes.emplace_back(std::make_unique<ExpressionOp::ComputeNode>(ExpressionOp::ComputeNode::Type::Add, IR::UI<8>::build(1), id_ref)).get();
+   std::vector<RelAlgOpPtr> expr_children;
+   expr_children.push_back(std::move(scan));
+   auto expr = ExpressionOp::build(std::move(expr_children), "expr", std::vector<ExpressionOp::Node*>{plus_one}, std::move(nodes));
+   // Export the computed column twice, both children share the handed over memory.
+   const IU* computed = expr->getOutput()[0];
+   std::vector<RelAlgOpPtr> export_children;
+   export_children.push_back(std::move(expr));
+   auto root = ArrowExport::build(std::move(export_children), {computed, computed}, {"a", "b"});
+   auto& exporter = *root->exporter;
+
+   std::mutex batches_mut;
+   std::vector<ArrowArray> batches;
+   exporter.setCallback([&](size_t, ArrowArray* batch) {
+      std::unique_lock lock(batches_mut);
+      EXPECT_EQ(batch->children[0]->buffers[1], batch->children[1]->buffers[1]);
+      batches.push_back(*batch);
+      batch->release = nullptr;
+   });
+
+   auto control_block = std::make_shared<PipelineExecutor::QueryControlBlock>(std::move(root));
+   QueryExecutor::runQuery(control_block, GetParam(), "arrow_export_handed_over", 4);
+
+   std::vector<bool> seen(num_rows + 1, false);
+   for (auto& batch : batches) {
+      auto vals = static_cast<const uint64_t*>(batch.children[0]->buffers[1]);
+      for (int64_t row = 0; row < batch.length; ++row) {
+         ASSERT_GE(vals[row], 1);
+         ASSERT_LE(vals[row], num_rows);
+         EXPECT_FALSE(seen[vals[row]]);
+         seen[vals[row]] = true;
+      }
+      batch.release(&batch);
+   }
+   EXPECT_EQ(exporter.num_rows, num_rows);
+   for (size_t k = 1; k <= num_rows; ++k) {
+      EXPECT_TRUE(seen[k]);
+   }
+}
+
+INSTANTIATE_TEST_CASE_P(
+   ArrowExportTest,
+   ArrowExportTestT,
+   ::testing::Values(
+      PipelineExecutor::ExecutionMode::Fused,
+      PipelineExecutor::ExecutionMode::Interpreted,
+      PipelineExecutor::ExecutionMode::Hybrid));
+
+}
+}
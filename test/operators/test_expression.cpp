@@ -7,6 +7,7 @@
 #include "exec/FuseChunk.h"
 #include "exec/PipelineExecutor.h"
 #include <gtest/gtest.h>
+#include <limits>
 
 namespace inkfuse {
 
@@ -49,6 +50,112 @@ struct ExpressionT {
    std::optional<ExpressionOp> op;
 };
 
+/// Expression with duplicate subtrees and foldable constants:
+/// out_1 = (in_1 + in_2) * ((in_1 + in_2) - in_1), out_2 = 1 * (3 + (2 + (in_1 + in_2))).
+struct SimplifyT {
+   SimplifyT() : in1(IR::UnsignedInt::build(2), "in_1"),
+                 in2(IR::UnsignedInt::build(2), "in_2") {
+      using ComputeNode = ExpressionOp::ComputeNode;
+      auto r1 = nodes.emplace_back(std::make_unique<ExpressionOp::IURefNode>(&in1)).get();
+      auto r2 = nodes.emplace_back(std::make_unique<ExpressionOp::IURefNode>(&in2)).get();
+      auto r1_dup = nodes.emplace_back(std::make_unique<ExpressionOp::IURefNode>(&in1)).get();
+      auto a1 = nodes.emplace_back(std::make_unique<ComputeNode>(ComputeNode::Type::Add, std::vector<ExpressionOp::Node*>{r1, r2})).get();
+      auto a2 = nodes.emplace_back(std::make_unique<ComputeNode>(ComputeNode::Type::Add, std::vector<ExpressionOp::Node*>{r1_dup, r2})).get();
+      auto sub = nodes.emplace_back(std::make_unique<ComputeNode>(ComputeNode::Type::Subtract, std::vector<ExpressionOp::Node*>{a2, r1})).get();
+      auto m = nodes.emplace_back(std::make_unique<ComputeNode>(ComputeNode::Type::Multiply, std::vector<ExpressionOp::Node*>{a1, sub})).get();
+      auto p1 = nodes.emplace_back(std::make_unique<ComputeNode>(ComputeNode::Type::Add, IR::UI<2>::build(2), a2)).get();
+      auto p2 = nodes.emplace_back(std::make_unique<ComputeNode>(ComputeNode::Type::Add, IR::UI<2>::build(3), p1)).get();
+      auto id = nodes.emplace_back(std::make_unique<ComputeNode>(ComputeNode::Type::Multiply, IR::UI<2>::build(1), p2)).get();
+      op.emplace(
+         std::vector<std::unique_ptr<RelAlgOp>>{},
+         "expression_simplify",
+         std::vector<ExpressionOp::Node*>{m, id},
+         std::move(nodes));
+   }
+
+   IU in1;
+   IU in2;
+   std::vector<ExpressionOp::NodePtr> nodes;
+   std::optional<ExpressionOp> op;
+};
+
+/// LIKE and ILIKE patterns on a string column.
+struct LikeT : public ::testing::TestWithParam<PipelineExecutor::ExecutionMode> {
+   LikeT() : in(IR::String::build(), "in") {
+      using ComputeNode = ExpressionOp::ComputeNode;
+      auto ref = nodes.emplace_back(std::make_unique<ExpressionOp::IURefNode>(&in)).get();
+      std::vector<ExpressionOp::Node*> out;
+      for (auto& [pattern, case_insensitive] : patterns) {
+         out.push_back(nodes.emplace_back(std::make_unique<ComputeNode>(ComputeNode::Type::Like, IR::LikePattern::build(pattern, case_insensitive), ref)).get());
+      }
+      op.emplace(std::vector<std::unique_ptr<RelAlgOp>>{}, "expression_like", std::move(out), std::move(nodes));
+   }
+
+   const std::vector<std::pair<std::string, bool>> patterns{
+      {"abc%", false},
+      {"%xyz", false},
+      {"%over the lazy%", false},
+      {"a%b_c%d", false},
+      {"%WORLD%", true},
+      {"abc%", true},
+   };
+   const std::vector<std::string> strings{
+      "abcdef", "ABCxyz", "xyz", "the quick brown fox jumps over the lazy dog", "a1b2c3d", "", "Hello World", "abc"};
+   /// Expected result for every pattern on the strings.
+   const std::vector<std::vector<bool>> expected{
+      {true, false, false, false, false, false, false, true},
+      {false, true, true, false, false, false, false, false},
+      {false, false, false, true, false, false, false, false},
+      {false, false, false, false, true, false, false, false},
+      {false, false, false, false, false, false, true, false},
+      {true, true, false, false, false, false, false, true},
+   };
+
+   IU in;
+   std::vector<ExpressionOp::NodePtr> nodes;
+   std::optional<ExpressionOp> op;
+};
+
+/// Decimal arithmetic, comparisons and casts. a is a DECIMAL(10, 2), b a DECIMAL(12, 2).
+struct DecimalT : public ::testing::TestWithParam<PipelineExecutor::ExecutionMode> {
+   DecimalT() : a(IR::Decimal::build(10, 2), "a"),
+                b(IR::Decimal::build(12, 2), "b") {
+      using ComputeNode = ExpressionOp::ComputeNode;
+      auto r_a = nodes.emplace_back(std::make_unique<ExpressionOp::IURefNode>(&a)).get();
+      auto r_b = nodes.emplace_back(std::make_unique<ExpressionOp::IURefNode>(&b)).get();
+      auto wide_b = nodes.emplace_back(std::make_unique<ComputeNode>(IR::Decimal::build(30, 2), r_b)).get();
+      std::vector<ExpressionOp::Node*> out{
+         // DECIMAL(13, 2) on 8 bytes.
+         nodes.emplace_back(std::make_unique<ComputeNode>(ComputeNode::Type::Add, std::vector<ExpressionOp::Node*>{r_a, r_b})).get(),
+         // DECIMAL(22, 4) on 16 bytes.
+         nodes.emplace_back(std::make_unique<ComputeNode>(ComputeNode::Type::Multiply, std::vector<ExpressionOp::Node*>{r_a, r_b})).get(),
+         nodes.emplace_back(std::make_unique<ComputeNode>(ComputeNode::Type::Less, std::vector<ExpressionOp::Node*>{r_a, r_b})).get(),
+         nodes.emplace_back(std::make_unique<ComputeNode>(ComputeNode::Type::Add, IR::DecimalVal::build(IR::Decimal::build(10, 2), 150), r_a)).get(),
+         nodes.emplace_back(std::make_unique<ComputeNode>(IR::Decimal::build(12, 4), r_a)).get(),
+         wide_b,
+         nodes.emplace_back(std::make_unique<ComputeNode>(IR::SignedInt::build(8), r_a)).get(),
+         nodes.emplace_back(std::make_unique<ComputeNode>(IR::Float::build(8), r_a)).get(),
+         // DECIMAL(30, 6) on 16 bytes, mixed width operands.
+         nodes.emplace_back(std::make_unique<ComputeNode>(ComputeNode::Type::Divide, std::vector<ExpressionOp::Node*>{r_a, wide_b})).get(),
+      };
+      op.emplace(std::vector<std::unique_ptr<RelAlgOp>>{}, "expression_decimal", std::move(out), std::move(nodes));
+   }
+
+   static int64_t aVal(int64_t k) { return (k - 5) * 125 + 3; }
+   static int64_t bVal(int64_t k) { return 1000 + k * 37 - (k % 3) * 900; }
+
+   IU a;
+   IU b;
+   std::vector<ExpressionOp::NodePtr> nodes;
+   std::optional<ExpressionOp> op;
+};
+
+struct SimplifyTNonParametrized : public SimplifyT, public ::testing::Test {
+};
+
+struct SimplifyTParametrized : public SimplifyT, public ::testing::TestWithParam<PipelineExecutor::ExecutionMode> {
+};
+
 /// Non-parametrized test fixture for decay tests.
 struct ExpressionTNonParametrized : public ExpressionT, public ::testing::Test {
 };
@@ -131,6 +238,272 @@ TEST_P(ExpressionTParametrized, exec) {
    }
 }
 
+TEST_F(SimplifyTNonParametrized, decay) {
+   PipelineDAG dag;
+   dag.buildNewPipeline();
+   op->decay(dag);
+
+   auto& ops = dag.getCurrentPipeline().getSubops();
+   // The addition is computed once, the constants are folded into a single addition.
+   ASSERT_EQ(ops.size(), 4);
+   const IU* sum = ops[0]->getIUs()[0];
+   EXPECT_EQ(ops[0]->getSourceIUs(), (std::vector<const IU*>{&in1, &in2}));
+   EXPECT_EQ(ops[1]->getSourceIUs(), (std::vector<const IU*>{sum, &in1}));
+   EXPECT_EQ(ops[2]->getSourceIUs(), (std::vector<const IU*>{sum, ops[1]->getIUs()[0]}));
+   EXPECT_EQ(ops[3]->getSourceIUs(), (std::vector<const IU*>{sum}));
+   EXPECT_EQ(op->getOutput()[0], ops[2]->getIUs()[0]);
+   EXPECT_EQ(op->getOutput()[1], ops[3]->getIUs()[0]);
+}
+
+TEST_P(SimplifyTParametrized, exec) {
+   PipelineDAG dag;
+   dag.buildNewPipeline();
+   op->decay(dag);
+
+   auto& pipe = dag.getCurrentPipeline();
+   auto repiped = pipe.repipeAll(0, pipe.getSubops().size());
+   PipelineExecutor exec(*repiped, 1, GetParam(), "SimplifyT_exec");
+
+   auto& ctx = exec.getExecutionContext();
+   auto& c_in1 = ctx.getColumn(in1, 0);
+   auto& c_in2 = ctx.getColumn(in2, 0);
+   c_in1.size = 10;
+   c_in2.size = 10;
+   for (uint16_t k = 0; k < 10; ++k) {
+      reinterpret_cast<uint16_t*>(c_in1.raw_data)[k] = k + 1;
+      reinterpret_cast<uint16_t*>(c_in2.raw_data)[k] = k;
+   }
+
+   EXPECT_NO_THROW(exec.runMorsel(0));
+
+   auto& c_out_1 = ctx.getColumn(*op->getOutput()[0], 0);
+   auto& c_out_2 = ctx.getColumn(*op->getOutput()[1], 0);
+   for (uint16_t k = 0; k < 10; ++k) {
+      const uint16_t sum = k + k + 1;
+      EXPECT_EQ(reinterpret_cast<uint16_t*>(c_out_1.raw_data)[k], static_cast<uint16_t>(sum * k));
+      EXPECT_EQ(reinterpret_cast<uint16_t*>(c_out_2.raw_data)[k], sum + 5);
+   }
+}
+
+TEST(LikePattern, specialization) {
+   using Kind = IR::LikePattern::Kind;
+   auto kind = [](std::string pattern) {
+      auto value = IR::LikePattern::build(std::move(pattern));
+      return static_cast<IR::LikePattern&>(*value).getKind();
+   };
+   EXPECT_EQ(kind("abc"), Kind::Exact);
+   EXPECT_EQ(kind("abc%"), Kind::Prefix);
+   EXPECT_EQ(kind("%abc"), Kind::Suffix);
+   EXPECT_EQ(kind("%%abc%"), Kind::Contains);
+   EXPECT_EQ(kind("a%c"), Kind::General);
+   EXPECT_EQ(kind("%a_c%"), Kind::General);
+   EXPECT_EQ(kind("%"), Kind::General);
+}
+
+TEST(Decimal, derivation) {
+   using Type = ExpressionOp::ComputeNode::Type;
+   auto dec = [](size_t precision, size_t scale) { return IR::Decimal::build(precision, scale); };
+   auto check = [](const IR::TypeArc& type, size_t precision, size_t scale) {
+      auto decimal = dynamic_cast<IR::Decimal*>(type.get());
+      ASSERT_NE(decimal, nullptr);
+      EXPECT_EQ(decimal->getPrecision(), precision);
+      EXPECT_EQ(decimal->getScale(), scale);
+   };
+   check(ExpressionOp::derive(Type::Add, {dec(10, 2), dec(5, 1)}), 12, 2);
+   check(ExpressionOp::derive(Type::Add, {dec(10, 2), dec(12, 2)}), 13, 2);
+   check(ExpressionOp::derive(Type::Multiply, {dec(10, 2), dec(12, 3)}), 22, 5);
+   // Quotients get four more fractional digits than the dividend while the precision allows it.
+   check(ExpressionOp::derive(Type::Divide, {dec(10, 4), dec(5, 1)}), 15, 8);
+   check(ExpressionOp::derive(Type::Divide, {dec(10, 2), dec(30, 2)}), 30, 6);
+   check(ExpressionOp::derive(Type::Divide, {dec(12, 2), dec(12, 2)}), 18, 6);
+   check(ExpressionOp::derive(Type::Divide, {dec(12, 0), dec(12, 2)}), 18, 4);
+   check(ExpressionOp::derive(Type::Divide, {dec(36, 2), dec(12, 2)}), 38, 2);
+   check(ExpressionOp::derive(Type::Divide, {dec(38, 2), dec(12, 2)}), 38, 0);
+   EXPECT_EQ(ExpressionOp::derive(Type::Less, {dec(10, 2), dec(18, 2)})->id(), IR::Bool::build()->id());
+   EXPECT_EQ(ExpressionOp::derive(Type::Multiply, {dec(10, 2), dec(12, 3)})->numBytes(), 16);
+   // Mismatching scales, overflowing precision and mixing with other types are rejected.
+   EXPECT_THROW(ExpressionOp::derive(Type::Add, {dec(10, 2), dec(10, 3)}), std::runtime_error);
+   EXPECT_THROW(ExpressionOp::derive(Type::Multiply, {dec(20, 2), dec(20, 2)}), std::runtime_error);
+   EXPECT_THROW(ExpressionOp::derive(Type::Add, {dec(10, 2), IR::SignedInt::build(8)}), std::runtime_error);
+   EXPECT_THROW(ExpressionOp::derive(Type::Divide, {dec(38, 0), dec(12, 2)}), std::runtime_error);
+   EXPECT_THROW(IR::Decimal::build(39, 0), std::runtime_error);
+   EXPECT_THROW(IR::Decimal::build(4, 5), std::runtime_error);
+}
+
+TEST_P(DecimalT, exec) {
+   PipelineDAG dag;
+   dag.buildNewPipeline();
+   op->decay(dag);
+
+   auto& pipe = dag.getCurrentPipeline();
+   auto repiped = pipe.repipeAll(0, pipe.getSubops().size());
+   PipelineExecutor exec(*repiped, 1, GetParam(), "DecimalT_exec");
+
+   auto& ctx = exec.getExecutionContext();
+   auto& c_a = ctx.getColumn(a, 0);
+   auto& c_b = ctx.getColumn(b, 0);
+   c_a.size = 10;
+   c_b.size = 10;
+   for (int64_t k = 0; k < 10; ++k) {
+      reinterpret_cast<int64_t*>(c_a.raw_data)[k] = aVal(k);
+      reinterpret_cast<int64_t*>(c_b.raw_data)[k] = bVal(k);
+   }
+
+   EXPECT_NO_THROW(exec.runMorsel(0));
+
+   auto column = [&](size_t idx) {
+      return ctx.getColumn(*op->getOutput()[idx], 0).raw_data;
+   };
+   for (int64_t k = 0; k < 10; ++k) {
+      const int64_t a_val = aVal(k);
+      const int64_t b_val = bVal(k);
+      EXPECT_EQ(reinterpret_cast<int64_t*>(column(0))[k], a_val + b_val);
+      EXPECT_TRUE(reinterpret_cast<__int128*>(column(1))[k] == static_cast<__int128>(a_val) * b_val);
+      EXPECT_EQ(reinterpret_cast<bool*>(column(2))[k], a_val < b_val);
+      EXPECT_EQ(reinterpret_cast<int64_t*>(column(3))[k], a_val + 150);
+      EXPECT_EQ(reinterpret_cast<int64_t*>(column(4))[k], a_val * 100);
+      EXPECT_TRUE(reinterpret_cast<__int128*>(column(5))[k] == b_val);
+      // Casts to integers truncate the fractional digits.
+      EXPECT_EQ(reinterpret_cast<int64_t*>(column(6))[k], a_val / 100);
+      EXPECT_DOUBLE_EQ(reinterpret_cast<double*>(column(7))[k], a_val / 100.0);
+      // The dividend is scaled up by six digits to keep four more fractional digits.
+      EXPECT_TRUE(reinterpret_cast<__int128*>(column(8))[k] == static_cast<__int128>(a_val) * 1'000'000 / b_val);
+   }
+}
+
+TEST_P(DecimalT, divide) {
+   // x / y, z / y and 1.00 / y, where x and y are DECIMAL(12, 2) and z is a DECIMAL(14, 0).
+   IU x(IR::Decimal::build(12, 2), "x");
+   IU y(IR::Decimal::build(12, 2), "y");
+   IU z(IR::Decimal::build(14, 0), "z");
+   using ComputeNode = ExpressionOp::ComputeNode;
+   std::vector<ExpressionOp::NodePtr> divide_nodes;
+   auto r_x = divide_nodes.emplace_back(std::make_unique<ExpressionOp::IURefNode>(&x)).get();
+   auto r_y = divide_nodes.emplace_back(std::make_unique<ExpressionOp::IURefNode>(&y)).get();
+   auto r_z = divide_nodes.emplace_back(std::make_unique<ExpressionOp::IURefNode>(&z)).get();
+   std::vector<ExpressionOp::Node*> out{
+      // DECIMAL(18, 6) on 8 bytes.
+      divide_nodes.emplace_back(std::make_unique<ComputeNode>(ComputeNode::Type::Divide, std::vector<ExpressionOp::Node*>{r_x, r_y})).get(),
+      // DECIMAL(20, 4) on 16 bytes, the dividend has to be widened before scaling it up.
+      divide_nodes.emplace_back(std::make_unique<ComputeNode>(ComputeNode::Type::Divide, std::vector<ExpressionOp::Node*>{r_z, r_y})).get(),
+      // DECIMAL(18, 6) on 8 bytes with a constant dividend.
+      divide_nodes.emplace_back(std::make_unique<ComputeNode>(ComputeNode::Type::Divide, IR::DecimalVal::build(IR::Decimal::build(12, 2), 100), r_y)).get(),
+   };
+   ExpressionOp divide_op(std::vector<std::unique_ptr<RelAlgOp>>{}, "expression_divide", std::move(out), std::move(divide_nodes));
+   auto scale = [&](size_t idx) {
+      return static_cast<IR::Decimal&>(*divide_op.getOutput()[idx]->type).getScale();
+   };
+   EXPECT_EQ(scale(0), 6);
+   EXPECT_EQ(scale(1), 4);
+   EXPECT_EQ(scale(2), 6);
+   PipelineDAG dag;
+   dag.buildNewPipeline();
+   divide_op.decay(dag);
+
+   auto& pipe = dag.getCurrentPipeline();
+   auto repiped = pipe.repipeAll(0, pipe.getSubops().size());
+   PipelineExecutor exec(*repiped, 1, GetParam(), "DecimalT_divide");
+   auto& ctx = exec.getExecutionContext();
+   auto& c_x = ctx.getColumn(x, 0);
+   auto& c_y = ctx.getColumn(y, 0);
+   auto& c_z = ctx.getColumn(z, 0);
+   c_x.size = 10;
+   c_y.size = 10;
+   c_z.size = 10;
+   for (int64_t k = 0; k < 10; ++k) {
+      reinterpret_cast<int64_t*>(c_x.raw_data)[k] = 100 * (k + 1);
+      reinterpret_cast<int64_t*>(c_y.raw_data)[k] = 300 + k;
+      reinterpret_cast<int64_t*>(c_z.raw_data)[k] = k + 1;
+   }
+
+   EXPECT_NO_THROW(exec.runMorsel(0));
+
+   auto column = [&](size_t idx) {
+      return ctx.getColumn(*divide_op.getOutput()[idx], 0).raw_data;
+   };
+   // 1.00 / 3.00 = 0.333333
+   EXPECT_EQ(reinterpret_cast<int64_t*>(column(0))[0], 333'333);
+   // 1 / 3.00 = 0.3333
+   EXPECT_TRUE(reinterpret_cast<__int128*>(column(1))[0] == 3'333);
+   EXPECT_EQ(reinterpret_cast<int64_t*>(column(2))[0], 333'333);
+   for (int64_t k = 0; k < 10; ++k) {
+      EXPECT_EQ(reinterpret_cast<int64_t*>(column(0))[k], 100 * (k + 1) * 1'000'000 / (300 + k));
+      EXPECT_TRUE(reinterpret_cast<__int128*>(column(1))[k] == (k + 1) * 1'000'000 / (300 + k));
+      EXPECT_EQ(reinterpret_cast<int64_t*>(column(2))[k], 100 * 1'000'000 / (300 + k));
+   }
+}
+
+TEST_P(DecimalT, overflow) {
+   // Scaling a DECIMAL(18, 0) up to two fractional digits overflows its 8 bytes.
+   IU in(IR::Decimal::build(18, 0), "in");
+   std::vector<ExpressionOp::NodePtr> overflow_nodes;
+   auto r_in = overflow_nodes.emplace_back(std::make_unique<ExpressionOp::IURefNode>(&in)).get();
+   std::vector<ExpressionOp::Node*> out{
+      overflow_nodes.emplace_back(std::make_unique<ExpressionOp::ComputeNode>(IR::Decimal::build(18, 2), r_in)).get(),
+   };
+   ExpressionOp overflow_op(std::vector<std::unique_ptr<RelAlgOp>>{}, "expression_overflow", std::move(out), std::move(overflow_nodes));
+   PipelineDAG dag;
+   dag.buildNewPipeline();
+   overflow_op.decay(dag);
+
+   auto& pipe = dag.getCurrentPipeline();
+   auto repiped = pipe.repipeAll(0, pipe.getSubops().size());
+   PipelineExecutor exec(*repiped, 1, GetParam(), "DecimalT_overflow");
+   auto& c_in = exec.getExecutionContext().getColumn(in, 0);
+   c_in.size = 2;
+   reinterpret_cast<int64_t*>(c_in.raw_data)[0] = 5;
+   reinterpret_cast<int64_t*>(c_in.raw_data)[1] = std::numeric_limits<int64_t>::max() / 10;
+   EXPECT_THROW(exec.runMorsel(0), std::runtime_error);
+}
+
+TEST_P(LikeT, exec) {
+   PipelineDAG dag;
+   dag.buildNewPipeline();
+   op->decay(dag);
+
+   auto& pipe = dag.getCurrentPipeline();
+   EXPECT_EQ(pipe.getSubops().size(), patterns.size());
+   auto repiped = pipe.repipeAll(0, pipe.getSubops().size());
+   PipelineExecutor exec(*repiped, 1, GetParam(), "LikeT_exec");
+
+   auto& ctx = exec.getExecutionContext();
+   auto& c_in = ctx.getColumn(in, 0);
+   c_in.size = strings.size();
+   for (size_t k = 0; k < strings.size(); ++k) {
+      reinterpret_cast<const char**>(c_in.raw_data)[k] = strings[k].c_str();
+   }
+
+   EXPECT_NO_THROW(exec.runMorsel(0));
+
+   for (size_t p = 0; p < patterns.size(); ++p) {
+      auto& c_out = ctx.getColumn(*op->getOutput()[p], 0);
+      for (size_t k = 0; k < strings.size(); ++k) {
+         EXPECT_EQ(reinterpret_cast<bool*>(c_out.raw_data)[k], expected[p][k]) << patterns[p].first << " on " << strings[k];
+      }
+   }
+}
+
+INSTANTIATE_TEST_CASE_P(
+   DecimalExecution,
+   DecimalT,
+   ::testing::Values(PipelineExecutor::ExecutionMode::Fused,
+                     PipelineExecutor::ExecutionMode::Interpreted,
+                     PipelineExecutor::ExecutionMode::ROF));
+
+INSTANTIATE_TEST_CASE_P(
+   LikeExecution,
+   LikeT,
+   ::testing::Values(PipelineExecutor::ExecutionMode::Fused,
+                     PipelineExecutor::ExecutionMode::Interpreted,
+                     PipelineExecutor::ExecutionMode::ROF));
+
+INSTANTIATE_TEST_CASE_P(
+   SimplifyExecution,
+   SimplifyTParametrized,
+   ::testing::Values(PipelineExecutor::ExecutionMode::Fused,
+                     PipelineExecutor::ExecutionMode::Interpreted,
+                     PipelineExecutor::ExecutionMode::ROF));
+
 INSTANTIATE_TEST_CASE_P(
    ExpressionExecution,
    ExpressionTParametrized,
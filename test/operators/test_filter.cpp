@@ -135,6 +135,92 @@ TEST_P(FilterTParametrized, exec) {
    }
 }
 
+// The interpreter switches between the branching and the branch-free filter primitive
+// based on the selectivity of the previous morsels. Both have to produce the same rows.
+TEST_F(FilterTNonParametrized, adaptive_selectivities) {
+   PipelineDAG dag;
+   dag.buildNewPipeline();
+   filter->decay(dag);
+
+   auto& pipe = dag.getCurrentPipeline();
+   auto repiped = pipe.repipe(0, pipe.getSubops().size(), std::unordered_set<const IU*>{filter->getOutput()[0], filter->getOutput()[1]});
+   PipelineExecutor exec(*repiped, 1, PipelineExecutor::ExecutionMode::Interpreted, "FilterT_adaptive");
+
+   auto& ctx = exec.getExecutionContext();
+   auto& c_in1 = ctx.getColumn(read_col_1, 0);
+   auto& c_in2 = ctx.getColumn(read_col_2, 0);
+   auto& col_filter_1 = ctx.getColumn(*filter->getOutput()[0], 0);
+   auto& col_filter_2 = ctx.getColumn(*filter->getOutput()[1], 0);
+   const uint16_t rows = 500;
+   // Percentage of qualifying rows in every morsel. Mid-range selectivities run branch-free.
+   for (uint16_t percent : {50, 50, 0, 100, 30, 5, 95, 70, 50}) {
+      c_in1.size = rows;
+      c_in2.size = rows;
+      std::vector<uint16_t> expected;
+      for (uint16_t k = 0; k < rows; ++k) {
+         const bool passes = (k * 37) % 100 < percent;
+         reinterpret_cast<uint16_t*>(c_in1.raw_data)[k] = passes ? k + 1 : k;
+         reinterpret_cast<uint16_t*>(c_in2.raw_data)[k] = passes ? k : k + 1;
+         if (passes) {
+            expected.push_back(k);
+         }
+      }
+      exec.runMorsel(0);
+      // The morsel cleared the chunk sizes, but the filtered values remain.
+      for (size_t k = 0; k < expected.size(); ++k) {
+         ASSERT_EQ(reinterpret_cast<uint16_t*>(col_filter_1.raw_data)[k], expected[k] + 1) << percent << "% row " << k;
+         ASSERT_EQ(reinterpret_cast<uint16_t*>(col_filter_2.raw_data)[k], expected[k]) << percent << "% row " << k;
+      }
+   }
+}
+
+// Fused code is predicated once the interpreter observed a mid-range selectivity.
+TEST_F(FilterTNonParametrized, fused_selectivity) {
+   PipelineDAG dag;
+   dag.buildNewPipeline();
+   filter->decay(dag);
+
+   auto& pipe = dag.getCurrentPipeline();
+   auto repiped = pipe.repipe(0, pipe.getSubops().size(), std::unordered_set<const IU*>{filter->getOutput()[0], filter->getOutput()[1]});
+   const auto& ops = repiped->getSubops();
+   auto scope_it = std::find_if(ops.begin(), ops.end(), [](const SuboperatorArc& op) {
+      return dynamic_cast<ColumnFilterScope*>(op.get()) != nullptr;
+   });
+   ASSERT_NE(scope_it, ops.end());
+   const auto& scope = static_cast<ColumnFilterScope&>(**scope_it);
+
+   const uint16_t rows = 500;
+   // Every second row passes the filter.
+   auto run = [&](PipelineExecutor::ExecutionMode mode, std::string name) {
+      PipelineExecutor exec(*repiped, 1, mode, std::move(name));
+      auto& ctx = exec.getExecutionContext();
+      auto& c_in1 = ctx.getColumn(read_col_1, 0);
+      auto& c_in2 = ctx.getColumn(read_col_2, 0);
+      c_in1.size = rows;
+      c_in2.size = rows;
+      for (uint16_t k = 0; k < rows; ++k) {
+         reinterpret_cast<uint16_t*>(c_in1.raw_data)[k] = k % 2 == 0 ? k + 1 : k;
+         reinterpret_cast<uint16_t*>(c_in2.raw_data)[k] = k % 2 == 0 ? k : k + 1;
+      }
+      exec.runMorsel(0);
+      auto& col_filter_1 = ctx.getColumn(*filter->getOutput()[0], 0);
+      auto& col_filter_2 = ctx.getColumn(*filter->getOutput()[1], 0);
+      for (uint16_t k = 0; k < rows / 2; ++k) {
+         ASSERT_EQ(reinterpret_cast<uint16_t*>(col_filter_1.raw_data)[k], 2 * k + 1);
+         ASSERT_EQ(reinterpret_cast<uint16_t*>(col_filter_2.raw_data)[k], 2 * k);
+      }
+   };
+
+   // Without observations, fused code branches.
+   run(PipelineExecutor::ExecutionMode::Fused, "FilterT_fused_selectivity_1");
+   EXPECT_FALSE(scope.isPredicated());
+   // The interpreter observes 50% selectivity, the next fused code is branch-free.
+   run(PipelineExecutor::ExecutionMode::Interpreted, "FilterT_fused_selectivity_2");
+   EXPECT_TRUE(scope.getSelectivity().preferBranchFree());
+   run(PipelineExecutor::ExecutionMode::Fused, "FilterT_fused_selectivity_3");
+   EXPECT_TRUE(scope.isPredicated());
+}
+
 INSTANTIATE_TEST_CASE_P(
    FilterExecution,
    FilterTParametrized,
@@ -0,0 +1,132 @@
+#include "algebra/ArrowExport.h"
+#include "algebra/GroupJoin.h"
+#include "algebra/TableScan.h"
+#include "exec/QueryExecutor.h"
+#include "gtest/gtest.h"
+#include <algorithm>
+#include <map>
+#include <mutex>
+#include <tuple>
+
+namespace inkfuse {
+
+namespace {
+
+/// An output row (k, b, count(v), sum(v)).
+using Row = std::tuple<int32_t, uint64_t, int64_t, int64_t>;
+
+/// Group join the build relation (k, b) on its primary key k with the probe relation (pk, v).
+/// Only every second build key has probe rows, and some probe rows have no build row.
+struct GroupJoinTestT : public ::testing::TestWithParam<PipelineExecutor::ExecutionMode> {
+   GroupJoinTestT() {
+      build_rel.attachPODColumn("k", IR::SignedInt::build(4));
+      build_rel.attachPODColumn("b", IR::UnsignedInt::build(8));
+      for (int32_t k = 0; k < build_size; ++k) {
+         build_rel.loadRow(std::to_string(k) + "|" + std::to_string(k * 3) + "|");
+      }
+      probe_rel.attachPODColumn("pk", IR::SignedInt::build(4));
+      probe_rel.attachPODColumn("v", IR::SignedInt::build(8));
+      for (size_t row = 0; row < probe_size; ++row) {
+         const int32_t pk = static_cast<int32_t>(2 * ((row * 7919) % (build_size / 2 + 100)));
+         const int64_t v = static_cast<int64_t>(row % 13) - 6;
+         probe_rel.loadRow(std::to_string(pk) + "|" + std::to_string(v) + "|");
+         if (pk < build_size) {
+            auto& [count, sum] = expected_aggs[pk];
+            count++;
+            sum += v;
+         }
+      }
+   }
+
+   /// SELECT k, b, COUNT(v), SUM(v) FROM build [LEFT OUTER] JOIN probe ON k = pk GROUP BY k, b
+   std::vector<Row> runGroupJoin(JoinType type) {
+      auto build_scan = TableScan::build(build_rel, {"k", "b"}, "build_scan");
+      auto build_out = build_scan->getOutput();
+      auto probe_scan = TableScan::build(probe_rel, {"pk", "v"}, "probe_scan");
+      auto probe_out = probe_scan->getOutput();
+      std::vector<RelAlgOpPtr> children;
+      children.push_back(std::move(build_scan));
+      children.push_back(std::move(probe_scan));
+      std::vector<AggregateFunctions::Description> aggregates{
+         {*probe_out[1], AggregateFunctions::Opcode::Count},
+         {*probe_out[1], AggregateFunctions::Opcode::Sum},
+      };
+      auto group_join = GroupJoin::build(std::move(children), "group_join", {build_out[0]}, {build_out[1]}, {probe_out[0]}, std::move(aggregates), type);
+      auto group_join_out = group_join->getOutput();
+      EXPECT_EQ(group_join_out.size(), 4);
+      std::vector<RelAlgOpPtr> export_children;
+      export_children.push_back(std::move(group_join));
+      auto root = ArrowExport::build(std::move(export_children), group_join_out, {"k", "b", "count", "sum"});
+
+      // Batches arrive from all threads, collect the produced rows.
+      std::mutex result_mut;
+      std::vector<Row> result;
+      root->exporter->setCallback([&](size_t, ArrowArray* batch) {
+         std::unique_lock lock(result_mut);
+         auto k = static_cast<const int32_t*>(batch->children[0]->buffers[1]);
+         auto b = static_cast<const uint64_t*>(batch->children[1]->buffers[1]);
+         auto count = static_cast<const int64_t*>(batch->children[2]->buffers[1]);
+         auto sum = static_cast<const int64_t*>(batch->children[3]->buffers[1]);
+         for (int64_t row = 0; row < batch->length; ++row) {
+            result.emplace_back(k[row], b[row], count[row], sum[row]);
+         }
+         batch->release(batch);
+      });
+
+      auto control_block = std::make_shared<PipelineExecutor::QueryControlBlock>(std::move(root));
+      QueryExecutor::runQuery(control_block, GetParam(), "group_join", 4);
+      std::sort(result.begin(), result.end());
+      return result;
+   }
+
+   /// Compute the expected output rows.
+   std::vector<Row> expected(JoinType type) {
+      std::vector<Row> rows;
+      for (int32_t k = 0; k < build_size; ++k) {
+         auto it = expected_aggs.find(k);
+         if (it != expected_aggs.end()) {
+            rows.emplace_back(k, k * 3, it->second.first, it->second.second);
+         } else if (type == JoinType::LeftOuter) {
+            rows.emplace_back(k, k * 3, 0, 0);
+         }
+      }
+      return rows;
+   }
+
+   const int32_t build_size = 20'000;
+   const size_t probe_size = 100'000;
+   StoredRelation build_rel;
+   StoredRelation probe_rel;
+   /// (count, sum) of the build keys with probe rows.
+   std::map<int32_t, std::pair<int64_t, int64_t>> expected_aggs;
+};
+
+TEST_P(GroupJoinTestT, inner) {
+   auto result = runGroupJoin(JoinType::Inner);
+   auto rows = expected(JoinType::Inner);
+   ASSERT_EQ(result.size(), rows.size());
+   for (size_t k = 0; k < rows.size(); ++k) {
+      ASSERT_EQ(result[k], rows[k]) << "Mismatch in row " << k;
+   }
+}
+
+TEST_P(GroupJoinTestT, left_outer) {
+   auto result = runGroupJoin(JoinType::LeftOuter);
+   auto rows = expected(JoinType::LeftOuter);
+   ASSERT_EQ(result.size(), rows.size());
+   for (size_t k = 0; k < rows.size(); ++k) {
+      ASSERT_EQ(result[k], rows[k]) << "Mismatch in row " << k;
+   }
+}
+
+INSTANTIATE_TEST_CASE_P(
+   GroupJoinTest,
+   GroupJoinTestT,
+   ::testing::Values(
+      PipelineExecutor::ExecutionMode::Fused,
+      PipelineExecutor::ExecutionMode::Interpreted,
+      PipelineExecutor::ExecutionMode::ROF,
+      PipelineExecutor::ExecutionMode::Hybrid));
+
+}
+}
@@ -1,9 +1,11 @@
+#include "algebra/ArrowExport.h"
 #include "algebra/Join.h"
 #include "algebra/Pipeline.h"
 #include "algebra/TableScan.h"
 #include "algebra/suboperators/sinks/CountingSink.h"
 #include "exec/QueryExecutor.h"
 #include "gtest/gtest.h"
+#include <mutex>
 
 namespace inkfuse {
 
@@ -134,5 +136,48 @@ TEST_P(PkJoinTestT, two_keys) {
    QueryExecutor::runQuery(control_block, GetParam(), "join_two_keys");
 }
 
+/// PK join with a single int4 key where the build payload is only fetched through the slot's row reference.
+TEST_P(PkJoinTestT, late_materialization) {
+   // Set up the join.
+   std::vector<RelAlgOpPtr> children;
+   children.push_back(std::move(*scan_1));
+   children.push_back(std::move(*scan_2));
+   std::vector<const IU*> keys_left{iu_rel_1_col_1};
+   std::vector<const IU*> payload_left{iu_rel_1_col_1, iu_rel_1_col_2, iu_rel_1_col_3};
+   std::vector<const IU*> keys_right{iu_rel_2_col_1};
+   std::vector<const IU*> payload_right{iu_rel_2_col_3};
+   auto join = Join::build(std::move(children), "join", std::move(keys_left), std::move(payload_left), std::move(keys_right), std::move(payload_right), JoinType::Inner, true, /* late_materialize = */ true);
+   auto join_out = join->getOutput();
+   std::vector<RelAlgOpPtr> export_children;
+   export_children.push_back(std::move(join));
+   auto root = ArrowExport::build(std::move(export_children), join_out, {"key_l", "col_1", "col_2", "col_3", "key_r", "col_3_r"});
+   std::mutex result_mut;
+   size_t errors = 0;
+   root->exporter->setCallback([&](size_t, ArrowArray* batch) {
+      std::unique_lock lock(result_mut);
+      auto keys_l = static_cast<const int32_t*>(batch->children[0]->buffers[1]);
+      auto col_1 = static_cast<const int32_t*>(batch->children[1]->buffers[1]);
+      auto col_2 = static_cast<const uint8_t*>(batch->children[2]->buffers[1]);
+      auto col_3 = static_cast<const float*>(batch->children[3]->buffers[1]);
+      auto keys_r = static_cast<const int32_t*>(batch->children[4]->buffers[1]);
+      for (int64_t row = 0; row < batch->length; ++row) {
+         const int32_t key = keys_r[row];
+         errors += keys_l[row] != key;
+         errors += col_1[row] != key;
+         errors += col_2[row] != key % 10;
+         errors += col_3[row] != static_cast<float>(key % 10000);
+      }
+      batch->release(batch);
+   });
+   auto& exporter = *root->exporter;
+   auto control_block = std::make_shared<PipelineExecutor::QueryControlBlock>(std::move(root));
+   ASSERT_EQ(control_block->dag.getPipelines().size(), 2);
+   // Run the query.
+   QueryExecutor::runQuery(control_block, GetParam(), "join_late_materialization", 4);
+   EXPECT_EQ(errors, 0);
+   // Every row on the probe side should have a match.
+   EXPECT_EQ(exporter.num_rows, PROBE_SIZE);
+}
+
 INSTANTIATE_TEST_CASE_P(PkJoinTest, PkJoinTestT, ::testing::Values(PipelineExecutor::ExecutionMode::Fused, PipelineExecutor::ExecutionMode::Interpreted, PipelineExecutor::ExecutionMode::ROF, PipelineExecutor::ExecutionMode::Hybrid));
 }
@@ -0,0 +1,149 @@
+#include "algebra/ArrowExport.h"
+#include "algebra/Sort.h"
+#include "algebra/TableScan.h"
+#include "exec/QueryExecutor.h"
+#include "gtest/gtest.h"
+#include <algorithm>
+#include <mutex>
+#include <optional>
+#include <tuple>
+
+namespace inkfuse {
+
+namespace {
+
+using Row = std::tuple<std::optional<int32_t>, std::string, uint64_t>;
+
+struct SortTestT : public ::testing::TestWithParam<PipelineExecutor::ExecutionMode> {
+   SortTestT() {
+      rel.attachPODColumn("a", IR::SignedInt::build(4), true);
+      rel.attachStringColumn("s");
+      rel.attachPODColumn("v", IR::UnsignedInt::build(8));
+      for (uint64_t k = 0; k < num_rows; ++k) {
+         std::optional<int32_t> a;
+         if (k % 13 != 0) {
+            a = static_cast<int32_t>((k * 7919) % 101) - 50;
+         }
+         std::string s = "str_" + std::to_string((k * 31) % 17);
+         rel.loadRow((a ? std::to_string(*a) : "") + "|" + s + "|" + std::to_string(k) + "|");
+         rows.emplace_back(a, s, k);
+      }
+      scan = TableScan::build(rel, {"a", "s", "v"}, "scan");
+      scan_out = scan->getOutput();
+   }
+
+   /// Run ORDER BY over the scan with the given keys and payload, export the output as columns a, s, v.
+   std::vector<Row> runSort(std::vector<Sort::Key> keys, std::vector<const IU*> payload, std::optional<size_t> limit, const std::vector<size_t>& export_order) {
+      std::vector<RelAlgOpPtr> sort_children;
+      sort_children.push_back(std::move(scan));
+      auto sort = Sort::build(std::move(sort_children), "sort", std::move(keys), std::move(payload), limit);
+      auto sort_out = sort->getOutput();
+      EXPECT_EQ(sort_out.size(), 3);
+      std::vector<const IU*> export_ius;
+      for (size_t idx : export_order) {
+         export_ius.push_back(sort_out[idx]);
+      }
+      std::vector<RelAlgOpPtr> export_children;
+      export_children.push_back(std::move(sort));
+      auto root = ArrowExport::build(std::move(export_children), export_ius, {"a", "s", "v"});
+
+      // Batches arrive in order, collect the produced rows.
+      std::mutex result_mut;
+      std::vector<Row> result;
+      root->exporter->setCallback([&](size_t, ArrowArray* batch) {
+         std::unique_lock lock(result_mut);
+         auto a = batch->children[0];
+         auto s = batch->children[1];
+         auto offsets = static_cast<const int32_t*>(s->buffers[1]);
+         auto v = static_cast<const uint64_t*>(batch->children[2]->buffers[1]);
+         for (int64_t row = 0; row < batch->length; ++row) {
+            std::optional<int32_t> a_val;
+            if (a->buffers[0] == nullptr || (static_cast<const uint8_t*>(a->buffers[0])[row / 8] >> (row % 8)) & 1) {
+               a_val = static_cast<const int32_t*>(a->buffers[1])[row];
+            }
+            std::string s_val(static_cast<const char*>(s->buffers[2]) + offsets[row], offsets[row + 1] - offsets[row]);
+            result.emplace_back(a_val, std::move(s_val), v[row]);
+         }
+         batch->release(batch);
+      });
+
+      auto control_block = std::make_shared<PipelineExecutor::QueryControlBlock>(std::move(root));
+      QueryExecutor::runQuery(control_block, GetParam(), "sort_order_by", 4);
+      return result;
+   }
+
+   /// Sort the expected rows by a DESC with NULLs first, then ascending on s, v.
+   void sortExpected() {
+      std::sort(rows.begin(), rows.end(), [](const Row& lhs, const Row& rhs) {
+         if (std::get<0>(lhs) != std::get<0>(rhs)) {
+            if (!std::get<0>(lhs) || !std::get<0>(rhs)) {
+               return !std::get<0>(lhs);
+            }
+            return *std::get<0>(lhs) > *std::get<0>(rhs);
+         }
+         return std::tie(std::get<1>(lhs), std::get<2>(lhs)) < std::tie(std::get<1>(rhs), std::get<2>(rhs));
+      });
+   }
+
+   const size_t num_rows = 10'000;
+   StoredRelation rel;
+   std::vector<Row> rows;
+   RelAlgOpPtr scan;
+   std::vector<const IU*> scan_out;
+};
+
+// SELECT a, s, v FROM t ORDER BY a DESC, s, v
+TEST_P(SortTestT, order_by) {
+   auto result = runSort({{scan_out[0], false}, {scan_out[1]}, {scan_out[2]}}, {}, {}, {0, 1, 2});
+   sortExpected();
+   ASSERT_EQ(result.size(), rows.size());
+   for (size_t k = 0; k < rows.size(); ++k) {
+      ASSERT_EQ(result[k], rows[k]) << "Mismatch in row " << k;
+   }
+}
+
+// SELECT a, s, v FROM t ORDER BY a DESC, s, v LIMIT 500
+// The first key is nullable, the Top-K runs without threshold filter.
+TEST_P(SortTestT, top_k) {
+   auto result = runSort({{scan_out[0], false}, {scan_out[1]}, {scan_out[2]}}, {}, 500, {0, 1, 2});
+   sortExpected();
+   ASSERT_EQ(result.size(), 500);
+   for (size_t k = 0; k < result.size(); ++k) {
+      ASSERT_EQ(result[k], rows[k]) << "Mismatch in row " << k;
+   }
+}
+
+// SELECT a, s, v FROM t ORDER BY v DESC LIMIT 100
+// Filters on the threshold of the thread-local heaps.
+TEST_P(SortTestT, top_k_threshold) {
+   auto result = runSort({{scan_out[2], false}}, {scan_out[0], scan_out[1]}, 100, {1, 2, 0});
+   std::sort(rows.begin(), rows.end(), [](const Row& lhs, const Row& rhs) {
+      return std::get<2>(lhs) > std::get<2>(rhs);
+   });
+   ASSERT_EQ(result.size(), 100);
+   for (size_t k = 0; k < result.size(); ++k) {
+      ASSERT_EQ(result[k], rows[k]) << "Mismatch in row " << k;
+   }
+}
+
+// SELECT a, s, v FROM t ORDER BY v LIMIT 20000
+// The limit exceeds the input.
+TEST_P(SortTestT, top_k_exceeds_input) {
+   auto result = runSort({{scan_out[2]}}, {scan_out[0], scan_out[1]}, 20'000, {1, 2, 0});
+   ASSERT_EQ(result.size(), rows.size());
+   for (size_t k = 0; k < rows.size(); ++k) {
+      ASSERT_EQ(result[k], rows[k]) << "Mismatch in row " << k;
+   }
+}
+
+INSTANTIATE_TEST_CASE_P(
+   SortTest,
+   SortTestT,
+   ::testing::Values(
+      PipelineExecutor::ExecutionMode::Fused,
+      PipelineExecutor::ExecutionMode::Interpreted,
+      PipelineExecutor::ExecutionMode::ROF,
+      PipelineExecutor::ExecutionMode::Hybrid));
+
+}
+}
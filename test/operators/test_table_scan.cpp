@@ -1,3 +1,4 @@
+#include "algebra/ArrowExport.h"
 #include "algebra/CompilationContext.h"
 #include "algebra/Pipeline.h"
 #include "algebra/RelAlgOp.h"
@@ -6,7 +7,10 @@
 #include "codegen/backend_c/BackendC.h"
 #include "exec/FuseChunk.h"
 #include "exec/PipelineExecutor.h"
+#include "exec/QueryExecutor.h"
 #include <gtest/gtest.h>
+#include <mutex>
+#include <thread>
 
 namespace inkfuse {
 
@@ -46,6 +50,66 @@ TEST(test_table_scan, scan_1) {
    }
 }
 
+struct AppendScanTestT : public ::testing::TestWithParam<PipelineExecutor::ExecutionMode> {};
+
+/// Scan a relation while another thread keeps appending to it. The scan has to see exactly its snapshot.
+TEST_P(AppendScanTestT, scan_snapshot) {
+   StoredRelation rel;
+   rel.attachPODColumn("val", IR::UnsignedInt::build(8));
+   rel.attachPODColumn("opt", IR::UnsignedInt::build(8), true);
+   auto append = [&](size_t k) {
+      rel.appendRow(std::to_string(k) + "|" + (k % 3 == 0 ? "" : "1") + "|");
+   };
+   size_t appended = 0;
+   for (; appended < StoredRelation::APPEND_SEGMENT_SIZE + 1000; ++appended) {
+      append(appended);
+   }
+
+   auto scan = TableScan::build(rel, {"val", "opt"}, "scan");
+   const auto snapshot = scan->getSnapshot();
+   ASSERT_EQ(snapshot.row_count, appended);
+   auto scan_out = scan->getOutput();
+   std::vector<RelAlgOpPtr> children;
+   children.push_back(std::move(scan));
+   auto root = ArrowExport::build(std::move(children), scan_out, {"val", "opt"});
+   std::mutex result_mut;
+   size_t val_sum = 0;
+   size_t null_count = 0;
+   root->exporter->setCallback([&](size_t, ArrowArray* batch) {
+      std::unique_lock lock(result_mut);
+      auto vals = static_cast<const uint64_t*>(batch->children[0]->buffers[1]);
+      for (int64_t row = 0; row < batch->length; ++row) {
+         val_sum += vals[row];
+      }
+      null_count += batch->children[1]->null_count;
+      batch->release(batch);
+   });
+   auto& exporter = *root->exporter;
+
+   // Keep appending while the query is running, also crossing into new segments.
+   std::thread appender([&]() {
+      for (size_t k = appended; k < appended + 2 * StoredRelation::APPEND_SEGMENT_SIZE; ++k) {
+         append(k);
+      }
+   });
+   auto control_block = std::make_shared<PipelineExecutor::QueryControlBlock>(std::move(root));
+   QueryExecutor::runQuery(control_block, GetParam(), "append_scan", 4);
+   appender.join();
+
+   EXPECT_EQ(exporter.num_rows, snapshot.row_count);
+   EXPECT_EQ(val_sum, snapshot.row_count * (snapshot.row_count - 1) / 2);
+   EXPECT_EQ(null_count, (snapshot.row_count + 2) / 3);
+   EXPECT_EQ(rel.snapshot().row_count, appended + 2 * StoredRelation::APPEND_SEGMENT_SIZE);
+}
+
+INSTANTIATE_TEST_CASE_P(
+   AppendScanTest,
+   AppendScanTestT,
+   ::testing::Values(
+      PipelineExecutor::ExecutionMode::Fused,
+      PipelineExecutor::ExecutionMode::Interpreted,
+      PipelineExecutor::ExecutionMode::Hybrid));
+
 }
 
 }
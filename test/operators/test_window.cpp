@@ -0,0 +1,170 @@
+#include "algebra/ArrowExport.h"
+#include "algebra/TableScan.h"
+#include "algebra/Window.h"
+#include "exec/QueryExecutor.h"
+#include "gtest/gtest.h"
+#include <algorithm>
+#include <mutex>
+#include <optional>
+#include <tuple>
+
+namespace inkfuse {
+
+namespace {
+
+/// An output row (p, o, v, row_number, rank, sum).
+using Row = std::tuple<std::optional<int32_t>, uint64_t, std::optional<int64_t>, int64_t, int64_t, std::optional<int64_t>>;
+
+struct WindowTestT : public ::testing::TestWithParam<PipelineExecutor::ExecutionMode> {
+   WindowTestT() {
+      rel.attachPODColumn("p", IR::SignedInt::build(4), true);
+      rel.attachPODColumn("o", IR::UnsignedInt::build(8));
+      rel.attachPODColumn("v", IR::SignedInt::build(8), true);
+      for (uint64_t k = 0; k < num_rows; ++k) {
+         std::optional<int32_t> p;
+         if (k % 97 != 0) {
+            p = static_cast<int32_t>((k * 7919) % 211);
+         }
+         const uint64_t o = (k * 31) % 50;
+         std::optional<int64_t> v;
+         if (k % 7 != 0) {
+            v = static_cast<int64_t>(k % 10) - 5;
+         }
+         rel.loadRow((p ? std::to_string(*p) : "") + "|" + std::to_string(o) + "|" + (v ? std::to_string(*v) : "") + "|");
+         input.emplace_back(p, o, v, 0, 0, std::nullopt);
+      }
+      scan = TableScan::build(rel, {"p", "o", "v"}, "scan");
+      scan_out = scan->getOutput();
+   }
+
+   /// Run ROW_NUMBER, RANK and SUM(v) with the given frame OVER (PARTITION BY p ORDER BY o, v) and collect the output rows.
+   std::vector<Row> runWindow(std::optional<size_t> preceding) {
+      std::vector<RelAlgOpPtr> window_children;
+      window_children.push_back(std::move(scan));
+      std::vector<Window::Function> functions{
+         {WindowFunction::Kind::RowNumber},
+         {WindowFunction::Kind::Rank},
+         {WindowFunction::Kind::Sum, scan_out[2], preceding},
+      };
+      auto window = Window::build(std::move(window_children), "window", {scan_out[0]}, {{scan_out[1]}, {scan_out[2]}}, {}, std::move(functions));
+      auto window_out = window->getOutput();
+      EXPECT_EQ(window_out.size(), 6);
+      std::vector<RelAlgOpPtr> export_children;
+      export_children.push_back(std::move(window));
+      auto root = ArrowExport::build(std::move(export_children), window_out, {"p", "o", "v", "row_number", "rank", "sum"});
+
+      // Batches arrive from all threads, collect the produced rows.
+      std::mutex result_mut;
+      std::vector<Row> result;
+      root->exporter->setCallback([&](size_t, ArrowArray* batch) {
+         std::unique_lock lock(result_mut);
+         auto read_nullable = [](const ArrowArray* col, int64_t row) -> std::optional<int64_t> {
+            if (col->buffers[0] == nullptr || (static_cast<const uint8_t*>(col->buffers[0])[row / 8] >> (row % 8)) & 1) {
+               return static_cast<const int64_t*>(col->buffers[1])[row];
+            }
+            return {};
+         };
+         auto p = batch->children[0];
+         auto o = static_cast<const uint64_t*>(batch->children[1]->buffers[1]);
+         auto row_number = static_cast<const int64_t*>(batch->children[3]->buffers[1]);
+         auto rank = static_cast<const int64_t*>(batch->children[4]->buffers[1]);
+         for (int64_t row = 0; row < batch->length; ++row) {
+            std::optional<int32_t> p_val;
+            if (p->buffers[0] == nullptr || (static_cast<const uint8_t*>(p->buffers[0])[row / 8] >> (row % 8)) & 1) {
+               p_val = static_cast<const int32_t*>(p->buffers[1])[row];
+            }
+            result.emplace_back(p_val, o[row], read_nullable(batch->children[2], row), row_number[row], rank[row], read_nullable(batch->children[5], row));
+         }
+         batch->release(batch);
+      });
+
+      auto control_block = std::make_shared<PipelineExecutor::QueryControlBlock>(std::move(root));
+      QueryExecutor::runQuery(control_block, GetParam(), "window_partitioned", 4);
+      return result;
+   }
+
+   /// Compute the expected output. Rows with the same (o, v) are interchangeable, which makes the result deterministic.
+   std::vector<Row> expected(std::optional<size_t> preceding) {
+      std::vector<Row> rows = input;
+      std::sort(rows.begin(), rows.end(), [](const Row& lhs, const Row& rhs) {
+         if (std::get<0>(lhs) != std::get<0>(rhs)) {
+            return std::get<0>(lhs) < std::get<0>(rhs);
+         }
+         if (std::get<1>(lhs) != std::get<1>(rhs)) {
+            return std::get<1>(lhs) < std::get<1>(rhs);
+         }
+         // NULLs last.
+         if (!std::get<2>(lhs) || !std::get<2>(rhs)) {
+            return std::get<2>(lhs) && !std::get<2>(rhs);
+         }
+         return *std::get<2>(lhs) < *std::get<2>(rhs);
+      });
+      size_t group_start = 0;
+      for (size_t k = 0; k < rows.size(); ++k) {
+         if (k > 0 && std::get<0>(rows[k - 1]) != std::get<0>(rows[k])) {
+            group_start = k;
+         }
+         std::get<3>(rows[k]) = k - group_start + 1;
+         const bool peer = k > group_start && std::tie(std::get<1>(rows[k - 1]), std::get<2>(rows[k - 1])) == std::tie(std::get<1>(rows[k]), std::get<2>(rows[k]));
+         std::get<4>(rows[k]) = peer ? std::get<4>(rows[k - 1]) : std::get<3>(rows[k]);
+         const size_t frame_start = preceding && k - group_start > *preceding ? k - *preceding : group_start;
+         std::optional<int64_t> sum;
+         for (size_t frame = frame_start; frame <= k; ++frame) {
+            if (std::get<2>(rows[frame])) {
+               sum = sum.value_or(0) + *std::get<2>(rows[frame]);
+            }
+         }
+         std::get<5>(rows[k]) = sum;
+      }
+      return rows;
+   }
+
+   /// Bring the result into the order of the expected rows.
+   static void sortResult(std::vector<Row>& result) {
+      std::sort(result.begin(), result.end(), [](const Row& lhs, const Row& rhs) {
+         return std::tie(std::get<0>(lhs), std::get<3>(lhs)) < std::tie(std::get<0>(rhs), std::get<3>(rhs));
+      });
+   }
+
+   const size_t num_rows = 10'000;
+   StoredRelation rel;
+   std::vector<Row> input;
+   RelAlgOpPtr scan;
+   std::vector<const IU*> scan_out;
+};
+
+// SELECT p, o, v, ROW_NUMBER() OVER w, RANK() OVER w, SUM(v) OVER w
+// FROM t WINDOW w AS (PARTITION BY p ORDER BY o, v ROWS BETWEEN UNBOUNDED PRECEDING AND CURRENT ROW)
+TEST_P(WindowTestT, running_sum) {
+   auto result = runWindow({});
+   auto rows = expected({});
+   sortResult(result);
+   ASSERT_EQ(result.size(), rows.size());
+   for (size_t k = 0; k < rows.size(); ++k) {
+      ASSERT_EQ(result[k], rows[k]) << "Mismatch in row " << k;
+   }
+}
+
+// SELECT p, o, v, ROW_NUMBER() OVER w, RANK() OVER w, SUM(v) OVER w
+// FROM t WINDOW w AS (PARTITION BY p ORDER BY o, v ROWS BETWEEN 3 PRECEDING AND CURRENT ROW)
+TEST_P(WindowTestT, framed_sum) {
+   auto result = runWindow(3);
+   auto rows = expected(3);
+   sortResult(result);
+   ASSERT_EQ(result.size(), rows.size());
+   for (size_t k = 0; k < rows.size(); ++k) {
+      ASSERT_EQ(result[k], rows[k]) << "Mismatch in row " << k;
+   }
+}
+
+INSTANTIATE_TEST_CASE_P(
+   WindowTest,
+   WindowTestT,
+   ::testing::Values(
+      PipelineExecutor::ExecutionMode::Fused,
+      PipelineExecutor::ExecutionMode::Interpreted,
+      PipelineExecutor::ExecutionMode::ROF,
+      PipelineExecutor::ExecutionMode::Hybrid));
+
+}
+}
@@ -141,6 +141,35 @@ TEST_P(AtomicHashTableTestT, inserts_lookups) {
    }
 }
 
+TEST_P(AtomicHashTableTestT, batch_hashes) {
+   const auto key_size = std::get<0>(GetParam());
+   const auto rows = std::get<1>(GetParam());
+   auto data = buildRandomData(rows);
+   std::vector<const char*> key_ptrs;
+   std::vector<uint64_t> expected;
+   for (size_t k = 0; k < rows; ++k) {
+      key_ptrs.push_back(&data.keys[k * key_size]);
+      expected.push_back(ht.compute_hash_and_prefetch(key_ptrs.back()));
+   }
+
+   // Dense and indirect key columns produce the hashes of the single key primitive.
+   std::vector<uint64_t> hashes(rows);
+   ht.compute_hash_and_prefetch_batch(data.keys.data(), key_size, /* indirect = */ false, rows, hashes.data());
+   EXPECT_EQ(hashes, expected);
+   std::fill(hashes.begin(), hashes.end(), 0);
+   ht.compute_hash_and_prefetch_batch(reinterpret_cast<const char*>(key_ptrs.data()), sizeof(char*), /* indirect = */ true, rows, hashes.data());
+   EXPECT_EQ(hashes, expected);
+
+   if (key_size == 8) {
+      // The fixed width kernel matches the fixed width primitive.
+      std::fill(hashes.begin(), hashes.end(), 0);
+      ht.compute_hash_and_prefetch_batch<8>(data.keys.data(), key_size, /* indirect = */ false, rows, hashes.data());
+      for (size_t k = 0; k < rows; ++k) {
+         EXPECT_EQ(hashes[k], ht.compute_hash_and_prefetch_fixed<8>(key_ptrs[k]));
+      }
+   }
+}
+
 // Tests on large key sizes.
 INSTANTIATE_TEST_CASE_P(
    AtomicHashTableTestsLargeKeys,
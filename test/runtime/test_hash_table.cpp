@@ -1,6 +1,8 @@
 #include "gtest/gtest.h"
 #include "runtime/HashTables.h"
 #include "xxhash.h"
+#include <algorithm>
+#include <array>
 #include <cstring>
 #include <random>
 
@@ -96,6 +98,100 @@ TEST(hash_table, bad_size) {
    EXPECT_ANY_THROW(HashTableSimpleKey(16, 3, 3));
 }
 
+// Direct lookup on a packed (int2, uint1) key with known value ranges.
+TEST(hash_table, direct_lookup_key_columns) {
+   // int2 in [-100, 99], uint1 in [3, 4].
+   HashTableDirectLookup ht(
+      {
+         {.offset = 0, .width = 2, .min = static_cast<uint64_t>(-100), .cardinality = 200},
+         {.offset = 2, .width = 1, .min = 3, .cardinality = 2},
+      },
+      3, 8);
+   EXPECT_EQ(ht.capacity(), 400);
+   auto pack = [](int16_t first, uint8_t second) {
+      std::array<char, 3> key;
+      std::memcpy(key.data(), &first, 2);
+      key[2] = static_cast<char>(second);
+      return key;
+   };
+   for (int16_t first = -100; first < 100; ++first) {
+      const auto key = pack(first, 3 + (first & 1));
+      EXPECT_EQ(ht.lookup(key.data()), nullptr);
+      char* slot = ht.lookupOrInsert(key.data());
+      // The key gets copied into the slot, the payload stays zero-initialized.
+      EXPECT_EQ(std::memcmp(slot, key.data(), 3), 0);
+      EXPECT_EQ(*reinterpret_cast<uint64_t*>(slot + 3), 0);
+      EXPECT_EQ(ht.lookupOrInsert(key.data()), slot);
+      EXPECT_EQ(ht.lookup(key.data()), slot);
+      EXPECT_LT(ht.computeHash(key.data()), ht.capacity());
+   }
+   EXPECT_EQ(ht.size(), 200);
+   // Keys within the ranges that were not inserted are not found.
+   for (int16_t first = -100; first < 100; ++first) {
+      const auto key = pack(first, 4 - (first & 1));
+      EXPECT_EQ(ht.lookup(key.data()), nullptr);
+   }
+   // The iterator visits every inserted key once.
+   char* it_data;
+   uint64_t it_idx;
+   size_t rows = 0;
+   for (ht.iteratorStart(&it_data, &it_idx); it_data; ht.iteratorAdvance(&it_data, &it_idx)) {
+      EXPECT_EQ(ht.computeHash(it_data), it_idx);
+      rows++;
+   }
+   EXPECT_EQ(rows, 200);
+}
+
+TEST(hash_table, adaptive_pass_through) {
+   HashTableSimpleKey ht(8, 8);
+   ht.enablePassThrough(4);
+   // Unique keys, pre-aggregation does not reduce anything.
+   const uint64_t num_keys = 4 * HashTableSimpleKey::PASS_THROUGH_MIN_GROUPS;
+   std::vector<char*> slots;
+   for (uint64_t key = 0; key < num_keys; ++key) {
+      char* slot = ht.lookupOrInsert(reinterpret_cast<const char*>(&key));
+      EXPECT_EQ(std::memcmp(slot, &key, 8), 0);
+      EXPECT_EQ(*reinterpret_cast<uint64_t*>(slot + 8), 0);
+      // Aggregate into the slot the same way the aggregation would.
+      *reinterpret_cast<uint64_t*>(slot + 8) += 1;
+   }
+   ASSERT_TRUE(ht.isPassThrough());
+   // The table stopped growing once it decided to pass rows through.
+   EXPECT_EQ(ht.size(), HashTableSimpleKey::PASS_THROUGH_MIN_GROUPS);
+   EXPECT_EQ(ht.size() + ht.passThroughSize(), num_keys);
+   // Pass-through rows are not aggregated anymore, every row gets its own slot.
+   const uint64_t last_key = num_keys - 1;
+   EXPECT_NE(ht.lookupOrInsert(reinterpret_cast<const char*>(&last_key)), ht.lookupOrInsert(reinterpret_cast<const char*>(&last_key)));
+   // Every partition only contains the keys hashing to it.
+   size_t partitioned = 0;
+   for (size_t partition = 0; partition < 4; ++partition) {
+      auto handle = ht.getPassThroughPartition(partition).getReadHandle();
+      while (auto chunk = handle->pullChunk()) {
+         for (const char* row = reinterpret_cast<const char*>(chunk->data.get()); row < chunk->end_ptr; row += 16) {
+            EXPECT_EQ(ht.computeHash(row) % 4, partition);
+            EXPECT_EQ(ht.lookup(row), nullptr);
+            partitioned++;
+         }
+      }
+   }
+   EXPECT_EQ(partitioned, num_keys - ht.size() + 2);
+}
+
+TEST(hash_table, adaptive_keeps_reducing) {
+   HashTableSimpleKey ht(8, 8);
+   ht.enablePassThrough(4);
+   // Every key is seen four times, pre-aggregation keeps paying off.
+   const uint64_t num_keys = 4 * HashTableSimpleKey::PASS_THROUGH_MIN_GROUPS;
+   for (uint64_t key = 0; key < num_keys; ++key) {
+      for (size_t repeat = 0; repeat < 4; ++repeat) {
+         *reinterpret_cast<uint64_t*>(ht.lookupOrInsert(reinterpret_cast<const char*>(&key)) + 8) += 1;
+      }
+   }
+   EXPECT_FALSE(ht.isPassThrough());
+   EXPECT_EQ(ht.size(), num_keys);
+   EXPECT_EQ(ht.passThroughSize(), 0);
+}
+
 TEST_P(HashTableTestT, inserts_lookups) {
    auto num_vals = std::get<1>(GetParam());
    auto data = buildRandomData(num_vals);
@@ -134,6 +230,34 @@ TEST_P(HashTableTestT, direct_inserts_lookups) {
    }
 }
 
+// Insert with hashes computed for a whole batch up front. The table grows in between.
+TEST_P(HashTableTestT, batch_hash_inserts_lookups) {
+   const size_t key_size = std::get<0>(GetParam());
+   auto num_vals = std::get<1>(GetParam());
+   auto data = buildRandomData(num_vals);
+   std::vector<uint64_t> hashes(num_vals);
+   for (size_t start = 0; start < num_vals; start += 512) {
+      const size_t count = std::min<size_t>(512, num_vals - start);
+      ht.computeHashAndPrefetchBatch(&data.keys[start * key_size], key_size, /* indirect = */ false, count, &hashes[start]);
+      for (size_t k = start; k < start + count; ++k) {
+         const char* key_ptr = &data.keys[k * key_size];
+         ASSERT_EQ(hashes[k], ht.computeHash(key_ptr));
+         ASSERT_EQ(ht.computeHashAndPrefetch(key_ptr), hashes[k]);
+         char* slot;
+         bool inserted;
+         ht.lookupOrInsert(&slot, &inserted, key_ptr, hashes[k]);
+         EXPECT_TRUE(inserted);
+         std::memcpy(slot + key_size, &data.payloads[k * 16], 16);
+         insert_counter++;
+      }
+   }
+   EXPECT_EQ(ht.size(), insert_counter);
+   for (uint64_t k = 0; k < num_vals; ++k) {
+      checkContains(data, k);
+      EXPECT_EQ(ht.lookupOrInsert(&data.keys[k * key_size], hashes[k]), ht.lookup(&data.keys[k * key_size]));
+   }
+}
+
 TEST_P(HashTableTestT, iterator) {
    // Iterator should have 0 entries.
    char* curr_it;
@@ -158,6 +282,40 @@ TEST_P(HashTableTestT, iterator) {
    EXPECT_EQ(curr_it, nullptr);
 }
 
+TEST_P(HashTableTestT, iterator_morsels) {
+   auto num_vals = std::get<1>(GetParam());
+   auto data = buildRandomData(num_vals);
+   for (uint64_t k = 0; k < num_vals; ++k) {
+      insertAt(data, k);
+   }
+   // Split the table into ranges and produce morsels from every range.
+   const uint64_t range_size = 1000;
+   size_t produced = 0;
+   for (uint64_t begin = 0; begin < ht.capacity(); begin += range_size) {
+      const uint64_t end = std::min<uint64_t>(begin + range_size, ht.capacity());
+      uint64_t cursor = begin;
+      while (cursor < end) {
+         const auto morsel = ht.iteratorMorsel(cursor, end, 100);
+         EXPECT_LE(morsel.rows, 100);
+         EXPECT_LE(morsel.end, end);
+         cursor = morsel.end;
+         // The bounded iterator produces exactly the rows of the morsel.
+         size_t rows = 0;
+         uint64_t it_idx = morsel.first;
+         char* it_data = morsel.rows ? ht.iteratorData(it_idx) : nullptr;
+         while (it_idx < morsel.end) {
+            EXPECT_NE(it_data, nullptr);
+            rows++;
+            ht.iteratorAdvance(&it_data, &it_idx, morsel.end);
+         }
+         EXPECT_EQ(it_data, nullptr);
+         EXPECT_EQ(rows, morsel.rows);
+         produced += rows;
+      }
+   }
+   EXPECT_EQ(produced, num_vals);
+}
+
 // Tests on large key sizes.
 INSTANTIATE_TEST_CASE_P(
    HashTableTestsLargeKeys,
@@ -87,11 +87,46 @@ struct ComplexHashTableTestT : public ::testing::TestWithParam<size_t> {
 
 // Simple test for failing hash table construction.
 TEST(complex_hash_table, bad_args) {
-   EXPECT_ANY_THROW(HashTableComplexKey(1, 1, 16, 4));
+   EXPECT_ANY_THROW(HashTableComplexKey(1, 2, 16, 4));
    EXPECT_ANY_THROW(HashTableComplexKey(0, 2, 16, 4));
    EXPECT_ANY_THROW(HashTableComplexKey(0, 1, 16, 5));
 }
 
+// The simple key behind the string is part of the key.
+TEST(complex_hash_table, simple_key) {
+   HashTableComplexKey ht(1, 1, 16, 4);
+   auto data = buildRandomStrings(64);
+   // Packed key [char*][uint8_t].
+   char key[9];
+   auto pack = [&](const std::string& str, uint8_t simple) {
+      const char* raw_string = str.data();
+      std::memcpy(key, &raw_string, 8);
+      key[8] = simple;
+      return key;
+   };
+   for (const auto& str : data) {
+      for (uint8_t simple : {0, 1}) {
+         char* slot;
+         bool inserted;
+         ht.lookupOrInsert(&slot, &inserted, pack(str, simple));
+         EXPECT_TRUE(inserted);
+         EXPECT_EQ(slot[8], simple);
+      }
+   }
+   EXPECT_EQ(ht.size(), 2 * data.size());
+   // Equal strings at different addresses find the same group.
+   for (const auto& str : data) {
+      const std::string copy = str;
+      for (uint8_t simple : {0, 1}) {
+         char* slot = ht.lookup(pack(copy, simple));
+         ASSERT_NE(slot, nullptr);
+         EXPECT_EQ(std::strcmp(*reinterpret_cast<char**>(slot), str.data()), 0);
+         EXPECT_EQ(slot[8], simple);
+      }
+      EXPECT_EQ(ht.lookup(pack(copy, 2)), nullptr);
+   }
+}
+
 TEST_P(ComplexHashTableTestT, inserts_lookups) {
    auto num_vals = GetParam();
    auto data = buildRandomStrings(num_vals);
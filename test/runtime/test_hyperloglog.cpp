@@ -0,0 +1,54 @@
+#include "runtime/HyperLogLog.h"
+#include <array>
+#include <cmath>
+#include <gtest/gtest.h>
+
+namespace inkfuse {
+
+namespace {
+
+using Sketch = std::array<uint8_t, HyperLogLog::num_registers>;
+
+TEST(test_hyperloglog, empty_and_small) {
+   Sketch sketch{};
+   EXPECT_EQ(HyperLogLog::estimate(sketch.data()), 0);
+   // Duplicates don't change the estimate.
+   for (size_t k = 0; k < 100; ++k) {
+      HyperLogLog::add(sketch.data(), HyperLogLog::hashBits(42));
+   }
+   EXPECT_EQ(HyperLogLog::estimate(sketch.data()), 1);
+   HyperLogLog::add(sketch.data(), HyperLogLog::hashString("inkfuse"));
+   EXPECT_EQ(HyperLogLog::estimate(sketch.data()), 2);
+}
+
+TEST(test_hyperloglog, accuracy) {
+   for (uint64_t distinct : {100, 1'000, 100'000, 1'000'000}) {
+      Sketch sketch{};
+      for (uint64_t k = 0; k < distinct; ++k) {
+         HyperLogLog::add(sketch.data(), HyperLogLog::hashBits(k));
+      }
+      const double error = std::abs(static_cast<double>(HyperLogLog::estimate(sketch.data())) - distinct) / distinct;
+      // Three times the standard error of 256 registers.
+      EXPECT_LT(error, 0.2) << "Distinct values: " << distinct;
+   }
+}
+
+TEST(test_hyperloglog, merge) {
+   // Two overlapping halves merge into the sketch of the union.
+   Sketch lhs{};
+   Sketch rhs{};
+   Sketch both{};
+   for (uint64_t k = 0; k < 30'000; ++k) {
+      HyperLogLog::add(k < 20'000 ? lhs.data() : rhs.data(), HyperLogLog::hashBits(k));
+      HyperLogLog::add(both.data(), HyperLogLog::hashBits(k));
+   }
+   for (uint64_t k = 10'000; k < 20'000; ++k) {
+      HyperLogLog::add(rhs.data(), HyperLogLog::hashBits(k));
+   }
+   HyperLogLog::merge(lhs.data(), rhs.data());
+   EXPECT_EQ(lhs, both);
+}
+
+}
+
+}
@@ -0,0 +1,52 @@
+#include "runtime/Quantiles.h"
+#include <algorithm>
+#include <random>
+#include <vector>
+#include <gtest/gtest.h>
+
+namespace inkfuse {
+
+namespace {
+
+/// Fraction of the values that are smaller than the estimate.
+double rank(const std::vector<double>& sorted, double estimate) {
+   return static_cast<double>(std::lower_bound(sorted.begin(), sorted.end(), estimate) - sorted.begin()) / sorted.size();
+}
+
+TEST(test_tdigest, empty_and_small) {
+   TDigest::Digest digest{};
+   EXPECT_EQ(TDigest::quantile(reinterpret_cast<char*>(&digest), 0.5), 0.0);
+   for (double val : {3.0, 1.0, 2.0}) {
+      TDigest::add(reinterpret_cast<char*>(&digest), val);
+   }
+   // Small digests are exact at the extremes and the median.
+   EXPECT_EQ(TDigest::quantile(reinterpret_cast<char*>(&digest), 0.0), 1.0);
+   EXPECT_EQ(TDigest::quantile(reinterpret_cast<char*>(&digest), 0.5), 2.0);
+   EXPECT_EQ(TDigest::quantile(reinterpret_cast<char*>(&digest), 1.0), 3.0);
+}
+
+TEST(test_tdigest, accuracy_and_merge) {
+   // Four digests over exponentially distributed values, merged into the first one.
+   std::mt19937_64 gen(42);
+   std::exponential_distribution<double> dist(0.01);
+   std::vector<TDigest::Digest> digests(4);
+   std::vector<double> values;
+   for (size_t k = 0; k < 200'000; ++k) {
+      const double val = dist(gen);
+      values.push_back(val);
+      TDigest::add(reinterpret_cast<char*>(&digests[k % 4]), val);
+   }
+   for (size_t k = 1; k < 4; ++k) {
+      TDigest::merge(reinterpret_cast<char*>(&digests[0]), reinterpret_cast<const char*>(&digests[k]));
+   }
+   std::sort(values.begin(), values.end());
+   EXPECT_EQ(TDigest::quantile(reinterpret_cast<char*>(&digests[0]), 0.0), values.front());
+   EXPECT_EQ(TDigest::quantile(reinterpret_cast<char*>(&digests[0]), 1.0), values.back());
+   for (double q : {0.01, 0.1, 0.25, 0.5, 0.75, 0.9, 0.99}) {
+      EXPECT_NEAR(rank(values, TDigest::quantile(reinterpret_cast<char*>(&digests[0]), q)), q, 0.01) << "Quantile " << q;
+   }
+}
+
+}
+
+}
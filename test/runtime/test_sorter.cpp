@@ -0,0 +1,132 @@
+#include "runtime/Sorter.h"
+#include <algorithm>
+#include <cstring>
+#include <deque>
+#include <random>
+#include <string>
+#include <thread>
+#include <tuple>
+#include <vector>
+#include <gtest/gtest.h>
+
+namespace inkfuse {
+
+namespace {
+
+/// Run both sorter phases with `num_threads` threads on the given materializers.
+void runSorter(Sorter& sorter, std::deque<TupleMaterializer>& mats) {
+   const size_t num_threads = mats.size();
+   std::vector<std::unique_ptr<TupleMaterializer::ReadHandle>> handles;
+   for (auto& mat : mats) {
+      handles.push_back(mat.getReadHandle());
+   }
+   sorter.prepareRuns(num_threads);
+   std::vector<std::thread> workers;
+   for (size_t thread_id = 0; thread_id < num_threads; ++thread_id) {
+      workers.emplace_back([&, thread_id]() { sorter.sortRun(thread_id, *handles[thread_id]); });
+   }
+   for (auto& worker : workers) {
+      worker.join();
+   }
+   workers.clear();
+   sorter.prepareMerge(num_threads);
+   for (size_t thread_id = 0; thread_id < num_threads; ++thread_id) {
+      workers.emplace_back([&, thread_id]() { sorter.mergePartition(thread_id); });
+   }
+   for (auto& worker : workers) {
+      worker.join();
+   }
+}
+
+TEST(test_sorter, signed_parallel) {
+   std::deque<TupleMaterializer> mats;
+   std::mt19937_64 gen(42);
+   std::vector<int64_t> expected;
+   for (size_t thread_id = 0; thread_id < 4; ++thread_id) {
+      auto& mat = mats.emplace_back(8);
+      // Skewed run sizes, one of the runs stays empty.
+      for (size_t k = 0; k < thread_id * 30'000; ++k) {
+         const int64_t val = static_cast<int64_t>(gen() % 100'000) - 50'000;
+         *reinterpret_cast<int64_t*>(mat.materialize()) = val;
+         expected.push_back(val);
+      }
+   }
+   Sorter sorter({SortKey{.kind = SortKey::Kind::Signed, .width = 8, .offset = 0}}, 8);
+   EXPECT_EQ(sorter.normalizedWidth(), 8);
+   runSorter(sorter, mats);
+
+   std::sort(expected.begin(), expected.end());
+   const auto& sorted = sorter.getSortedRows();
+   ASSERT_EQ(sorted.size(), expected.size());
+   for (size_t k = 0; k < sorted.size(); ++k) {
+      ASSERT_EQ(*reinterpret_cast<const int64_t*>(sorted[k]), expected[k]);
+   }
+}
+
+TEST(test_sorter, mixed_keys) {
+   // Row layout: [int4 a | char* s | float f | NULL indicator a].
+   // ORDER BY a DESC, s, f with a being nullable.
+   const size_t row_size = 17;
+   std::vector<SortKey> keys{
+      SortKey{.kind = SortKey::Kind::Signed, .width = 4, .offset = 0, .null_offset = 16, .ascending = false},
+      SortKey{.kind = SortKey::Kind::String, .width = 8, .offset = 4},
+      SortKey{.kind = SortKey::Kind::Float, .width = 4, .offset = 12},
+   };
+   // Strings sharing long prefixes need the tiebreak on the original values.
+   std::vector<std::string> strings{"", "a", "abcdefgh", "abcdefghb", "abcdefgha", "b", "zzzzzzzzzzzz"};
+
+   using Row = std::tuple<std::optional<int32_t>, std::string, float>;
+   std::vector<Row> expected;
+   std::deque<TupleMaterializer> mats;
+   std::mt19937 gen(7);
+   for (size_t thread_id = 0; thread_id < 3; ++thread_id) {
+      auto& mat = mats.emplace_back(row_size);
+      for (size_t k = 0; k < 5'000; ++k) {
+         char* row = mat.materialize();
+         const bool is_null = gen() % 10 == 0;
+         // Garbage in NULL rows must not influence the order.
+         const int32_t a = is_null ? static_cast<int32_t>(gen()) : static_cast<int32_t>(gen() % 7) - 3;
+         const std::string& s = strings[gen() % strings.size()];
+         const float f = static_cast<float>(static_cast<int32_t>(gen() % 200) - 100) / 4;
+         std::memcpy(row, &a, 4);
+         const char* s_ptr = s.c_str();
+         std::memcpy(row + 4, &s_ptr, 8);
+         std::memcpy(row + 12, &f, 4);
+         row[16] = is_null;
+         expected.emplace_back(is_null ? std::nullopt : std::optional<int32_t>{a}, s, f);
+      }
+   }
+   Sorter sorter(keys, row_size);
+   // NULL byte + int4 + string prefix, the float comes after the string.
+   EXPECT_EQ(sorter.normalizedWidth(), 1 + 4 + Sorter::STRING_PREFIX_SIZE);
+   runSorter(sorter, mats);
+
+   std::sort(expected.begin(), expected.end(), [](const Row& lhs, const Row& rhs) {
+      const auto& [l_a, l_s, l_f] = lhs;
+      const auto& [r_a, r_s, r_f] = rhs;
+      if (l_a != r_a) {
+         // Descending with NULLs first.
+         if (!l_a || !r_a) {
+            return !l_a;
+         }
+         return *l_a > *r_a;
+      }
+      return std::tie(l_s, l_f) < std::tie(r_s, r_f);
+   });
+   const auto& sorted = sorter.getSortedRows();
+   ASSERT_EQ(sorted.size(), expected.size());
+   for (size_t k = 0; k < sorted.size(); ++k) {
+      const char* row = sorted[k];
+      const auto& [a, s, f] = expected[k];
+      ASSERT_EQ(row[16] != 0, !a.has_value());
+      if (a) {
+         EXPECT_EQ(*reinterpret_cast<const int32_t*>(row), *a);
+      }
+      EXPECT_STREQ(*reinterpret_cast<char* const*>(row + 4), s.c_str());
+      EXPECT_EQ(*reinterpret_cast<const float*>(row + 12), f);
+   }
+}
+
+}
+
+}
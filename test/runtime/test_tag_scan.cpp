@@ -0,0 +1,46 @@
+#include "runtime/TagScan.h"
+#include <gtest/gtest.h>
+#include <vector>
+
+namespace inkfuse {
+
+namespace {
+
+const TagScan::Matcher matcher{.mask = 0xC0, .value = 0x80};
+
+TEST(test_tag_scan, next) {
+   std::vector<uint8_t> tags(100, 0);
+   EXPECT_EQ(TagScan::next(tags.data(), matcher, 0, 100), 100);
+   // Marked slots don't match.
+   tags[17] = 0xC3;
+   tags[42] = 0x85;
+   tags[99] = 0x80;
+   EXPECT_EQ(TagScan::next(tags.data(), matcher, 0, 100), 42);
+   EXPECT_EQ(TagScan::next(tags.data(), matcher, 43, 100), 99);
+   EXPECT_EQ(TagScan::next(tags.data(), matcher, 43, 99), 99);
+}
+
+TEST(test_tag_scan, morsel) {
+   // Every third slot is occupied.
+   std::vector<uint8_t> tags(200, 0);
+   for (size_t k = 1; k < tags.size(); k += 3) {
+      tags[k] = 0x80 | static_cast<uint8_t>(k & 0x3F);
+   }
+   auto morsel = TagScan::morsel(tags.data(), matcher, 0, 200, 10);
+   EXPECT_EQ(morsel.first, 1);
+   EXPECT_EQ(morsel.end, 29);
+   EXPECT_EQ(morsel.rows, 10);
+   morsel = TagScan::morsel(tags.data(), matcher, 29, 200, 100);
+   EXPECT_EQ(morsel.first, 31);
+   EXPECT_EQ(morsel.end, 200);
+   EXPECT_EQ(morsel.rows, 57);
+   // Empty ranges produce empty morsels.
+   morsel = TagScan::morsel(tags.data(), matcher, 2, 4, 100);
+   EXPECT_EQ(morsel.first, 4);
+   EXPECT_EQ(morsel.end, 4);
+   EXPECT_EQ(morsel.rows, 0);
+}
+
+}
+
+}
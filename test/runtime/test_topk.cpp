@@ -0,0 +1,103 @@
+#include "runtime/TopK.h"
+#include <algorithm>
+#include <cstring>
+#include <random>
+#include <thread>
+#include <vector>
+#include <gtest/gtest.h>
+
+namespace inkfuse {
+
+namespace {
+
+TEST(test_topk, threshold) {
+   TopK topk({SortKey{.kind = SortKey::Kind::Signed, .width = 8, .offset = 0}}, 8, 3);
+   topk.prepareHeaps(1);
+   auto& heap = topk.getHeap(0);
+   auto threshold = [&]() {
+      int64_t res;
+      std::memcpy(&res, &heap.threshold, 8);
+      return res;
+   };
+   // Everything passes until the heap is full.
+   EXPECT_EQ(threshold(), std::numeric_limits<int64_t>::max());
+   for (int64_t val : {10, 5, 7}) {
+      heap.insert(reinterpret_cast<const char*>(&val));
+   }
+   EXPECT_EQ(threshold(), 10);
+   // Rows behind the threshold are ignored, the others evict the top.
+   for (int64_t val : {12, 1, 10, 6}) {
+      heap.insert(reinterpret_cast<const char*>(&val));
+   }
+   EXPECT_EQ(threshold(), 6);
+
+   topk.merge();
+   const auto& sorted = topk.getSortedRows();
+   ASSERT_EQ(sorted.size(), 3);
+   EXPECT_EQ(*reinterpret_cast<const int64_t*>(sorted[0]), 1);
+   EXPECT_EQ(*reinterpret_cast<const int64_t*>(sorted[1]), 5);
+   EXPECT_EQ(*reinterpret_cast<const int64_t*>(sorted[2]), 6);
+   EXPECT_EQ(*topk.getSortedData(), reinterpret_cast<const char*>(sorted.data()));
+}
+
+TEST(test_topk, parallel_descending) {
+   // Row layout: [double key | uint4 payload].
+   const size_t row_size = 12;
+   const size_t k = 100;
+   TopK topk({SortKey{.kind = SortKey::Kind::Float, .width = 8, .offset = 0, .ascending = false}}, row_size, k);
+   topk.prepareHeaps(4);
+
+   std::vector<std::vector<double>> inputs(4);
+   std::vector<double> expected;
+   std::mt19937_64 gen(42);
+   for (size_t thread_id = 0; thread_id < 4; ++thread_id) {
+      // One of the threads does not see enough rows to fill its heap.
+      const size_t rows = thread_id == 0 ? 20 : thread_id * 10'000;
+      for (size_t r = 0; r < rows; ++r) {
+         const double val = static_cast<double>(gen() % 1'000'000) / 7;
+         inputs[thread_id].push_back(val);
+         expected.push_back(val);
+      }
+   }
+   std::vector<std::thread> workers;
+   for (size_t thread_id = 0; thread_id < 4; ++thread_id) {
+      workers.emplace_back([&, thread_id]() {
+         char row[row_size];
+         auto& heap = topk.getHeap(thread_id);
+         for (uint32_t r = 0; r < inputs[thread_id].size(); ++r) {
+            std::memcpy(row, &inputs[thread_id][r], 8);
+            std::memcpy(row + 8, &r, 4);
+            heap.insert(row);
+         }
+      });
+   }
+   for (auto& worker : workers) {
+      worker.join();
+   }
+   topk.merge();
+
+   std::sort(expected.begin(), expected.end(), std::greater<>());
+   const auto& sorted = topk.getSortedRows();
+   ASSERT_EQ(sorted.size(), k);
+   for (size_t r = 0; r < k; ++r) {
+      ASSERT_EQ(*reinterpret_cast<const double*>(sorted[r]), expected[r]);
+   }
+}
+
+TEST(test_topk, fewer_rows_than_k) {
+   TopK topk({SortKey{.kind = SortKey::Kind::Unsigned, .width = 4, .offset = 0}}, 4, 10);
+   topk.prepareHeaps(2);
+   for (uint32_t val : {3, 1, 2}) {
+      topk.getHeap(val % 2).insert(reinterpret_cast<const char*>(&val));
+   }
+   topk.merge();
+   const auto& sorted = topk.getSortedRows();
+   ASSERT_EQ(sorted.size(), 3);
+   for (uint32_t r = 0; r < 3; ++r) {
+      EXPECT_EQ(*reinterpret_cast<const uint32_t*>(sorted[r]), r + 1);
+   }
+}
+
+}
+
+}
@@ -0,0 +1,172 @@
+#include "runtime/WindowEvaluator.h"
+#include <algorithm>
+#include <cstring>
+#include <deque>
+#include <map>
+#include <optional>
+#include <random>
+#include <thread>
+#include <vector>
+#include <gtest/gtest.h>
+
+namespace inkfuse {
+
+namespace {
+
+/// Row layout: [p: int64 | o: int64 | v: int32 | v NULL | row_number | rank | running sum | NULL | framed sum | NULL].
+const size_t ROW_SIZE = 47;
+
+struct Row {
+   int64_t p;
+   int64_t o;
+   std::optional<int32_t> v;
+};
+
+/// Run both evaluator phases with `num_threads` threads on the given materializers.
+void runEvaluator(WindowEvaluator& evaluator, std::deque<TupleMaterializer>& mats) {
+   const size_t num_threads = mats.size();
+   std::vector<std::unique_ptr<TupleMaterializer::ReadHandle>> handles;
+   for (auto& mat : mats) {
+      handles.push_back(mat.getReadHandle());
+   }
+   evaluator.preparePartitioning(num_threads);
+   std::vector<std::thread> workers;
+   for (size_t thread_id = 0; thread_id < num_threads; ++thread_id) {
+      workers.emplace_back([&, thread_id]() { evaluator.partitionRows(thread_id, *handles[thread_id]); });
+   }
+   for (auto& worker : workers) {
+      worker.join();
+   }
+   workers.clear();
+   evaluator.prepareEvaluation();
+   for (size_t thread_id = 0; thread_id < num_threads; ++thread_id) {
+      workers.emplace_back([&]() { evaluator.evaluatePartitions(); });
+   }
+   for (auto& worker : workers) {
+      worker.join();
+   }
+}
+
+template <class T>
+T load(const char* row, size_t offset) {
+   T val;
+   std::memcpy(&val, row + offset, sizeof(T));
+   return val;
+}
+
+// ROW_NUMBER(), RANK(), SUM(v) and SUM(v) ROWS BETWEEN 2 PRECEDING AND CURRENT ROW
+// OVER (PARTITION BY p ORDER BY o)
+TEST(test_window_evaluator, partitioned_parallel) {
+   std::deque<TupleMaterializer> mats;
+   std::mt19937_64 gen(42);
+   std::vector<Row> input;
+   for (size_t thread_id = 0; thread_id < 4; ++thread_id) {
+      auto& mat = mats.emplace_back(ROW_SIZE);
+      for (size_t k = 0; k < 5'000; ++k) {
+         Row row{.p = static_cast<int64_t>(gen() % 300), .o = static_cast<int64_t>(gen() % 20)};
+         if (gen() % 5 != 0) {
+            row.v = static_cast<int32_t>(gen() % 1000) - 500;
+         }
+         char* dst = mat.materialize();
+         std::memcpy(dst, &row.p, 8);
+         std::memcpy(dst + 8, &row.o, 8);
+         const int32_t v = row.v.value_or(0);
+         std::memcpy(dst + 16, &v, 4);
+         dst[20] = !row.v;
+         input.push_back(row);
+      }
+   }
+
+   const SortKey p{.kind = SortKey::Kind::Signed, .width = 8, .offset = 0};
+   const SortKey o{.kind = SortKey::Kind::Signed, .width = 8, .offset = 8};
+   const SortKey v{.kind = SortKey::Kind::Signed, .width = 4, .offset = 16, .null_offset = 20};
+   WindowEvaluator evaluator(
+      {p}, {o},
+      {
+         WindowFunction{.kind = WindowFunction::Kind::RowNumber, .result_offset = 21},
+         WindowFunction{.kind = WindowFunction::Kind::Rank, .result_offset = 29},
+         WindowFunction{.kind = WindowFunction::Kind::Sum, .arg = v, .result_offset = 37, .result_null_offset = 41},
+         WindowFunction{.kind = WindowFunction::Kind::Sum, .arg = v, .preceding = 2, .result_offset = 42, .result_null_offset = 46},
+      },
+      ROW_SIZE);
+   runEvaluator(evaluator, mats);
+
+   const auto& rows = evaluator.getRows();
+   ASSERT_EQ(rows.size(), input.size());
+   // Collect the evaluated rows of every partition, they have to be contiguous and sorted on o.
+   std::map<int64_t, std::vector<const char*>> groups;
+   for (size_t k = 0; k < rows.size(); ++k) {
+      const int64_t group = load<int64_t>(rows[k], 0);
+      if (k > 0 && load<int64_t>(rows[k - 1], 0) != group) {
+         EXPECT_FALSE(groups.count(group)) << "Group " << group << " is not contiguous";
+      }
+      groups[group].push_back(rows[k]);
+   }
+   for (const auto& [group, group_rows] : groups) {
+      int64_t rank = 1;
+      int64_t running = 0;
+      size_t running_valid = 0;
+      for (size_t k = 0; k < group_rows.size(); ++k) {
+         const char* row = group_rows[k];
+         if (k > 0) {
+            ASSERT_LE(load<int64_t>(group_rows[k - 1], 8), load<int64_t>(row, 8));
+            if (load<int64_t>(group_rows[k - 1], 8) != load<int64_t>(row, 8)) {
+               rank = k + 1;
+            }
+         }
+         EXPECT_EQ(load<int64_t>(row, 21), k + 1);
+         EXPECT_EQ(load<int64_t>(row, 29), rank);
+         if (!row[20]) {
+            running += load<int32_t>(row, 16);
+            running_valid++;
+         }
+         EXPECT_EQ(row[41], running_valid == 0);
+         if (running_valid) {
+            EXPECT_EQ(load<int32_t>(row, 37), running);
+         }
+         int64_t framed = 0;
+         size_t framed_valid = 0;
+         for (size_t frame = k >= 2 ? k - 2 : 0; frame <= k; ++frame) {
+            if (!group_rows[frame][20]) {
+               framed += load<int32_t>(group_rows[frame], 16);
+               framed_valid++;
+            }
+         }
+         EXPECT_EQ(row[46], framed_valid == 0);
+         if (framed_valid) {
+            EXPECT_EQ(load<int32_t>(row, 42), framed);
+         }
+      }
+   }
+   EXPECT_EQ(groups.size(), 300);
+}
+
+// SUM(v) ROWS BETWEEN 100 PRECEDING AND CURRENT ROW OVER (ORDER BY o) without PARTITION BY.
+TEST(test_window_evaluator, single_group_framed_sum) {
+   std::deque<TupleMaterializer> mats;
+   for (size_t thread_id = 0; thread_id < 2; ++thread_id) {
+      auto& mat = mats.emplace_back(16);
+      for (uint64_t k = thread_id; k < 10'000; k += 2) {
+         std::memcpy(mat.materialize(), &k, 8);
+      }
+   }
+   const SortKey o{.kind = SortKey::Kind::Unsigned, .width = 8, .offset = 0};
+   WindowEvaluator evaluator(
+      {}, {o},
+      {WindowFunction{.kind = WindowFunction::Kind::Sum, .arg = o, .preceding = 100, .result_offset = 8}},
+      16);
+   runEvaluator(evaluator, mats);
+
+   const auto& rows = evaluator.getRows();
+   ASSERT_EQ(rows.size(), 10'000);
+   for (uint64_t k = 0; k < rows.size(); ++k) {
+      ASSERT_EQ(load<uint64_t>(rows[k], 0), k);
+      // Sum over [max(0, k - 100), k].
+      const uint64_t first = k >= 100 ? k - 100 : 0;
+      EXPECT_EQ(load<uint64_t>(rows[k], 8), (first + k) * (k - first + 1) / 2);
+   }
+}
+
+}
+
+}
@@ -4,7 +4,9 @@
 #include "algebra/suboperators/sources/TableScanSource.h"
 #include "algebra/suboperators/sinks/FuseChunkSink.h"
 #include "codegen/backend_c/BackendC.h"
+#include "exec/ExecutionContext.h"
 #include "exec/InterruptableJob.h"
+#include <algorithm>
 
 namespace inkfuse {
 
@@ -43,6 +45,40 @@ TEST(test_sources, table_scan) {
    program->compileToMachinecode(interrupt);
 }
 
+/// Test that a segmented table scan hands out every row exactly once.
+TEST(test_sources, table_scan_segments) {
+   Pipeline pipe;
+   // Segments don't line up with the chunk size and are in a different order than the nodes.
+   std::vector<RowSegment> segments{
+      {.begin = 0, .end = 1000, .node = 1},
+      {.begin = 1000, .end = 1100, .node = 0},
+      {.begin = 1100, .end = 5000, .node = 2},
+   };
+   auto& driver = pipe.attachSuboperator(TScanDriver::build(nullptr, segments));
+   ExecutionContext ctx(pipe, 1);
+   driver.setUpState(ctx);
+
+   std::vector<size_t> seen(5000);
+   double last_progress = 0.0;
+   while (true) {
+      auto morsel = driver.pickMorsel(0);
+      if (std::holds_alternative<Suboperator::NoMoreMorsels>(morsel)) {
+         break;
+      }
+      const auto& picked = std::get<Suboperator::PickedMorsel>(morsel);
+      const auto state = reinterpret_cast<LoopDriverState*>(driver.accessState(0));
+      EXPECT_LE(picked.morsel_size, DEFAULT_CHUNK_SIZE);
+      EXPECT_EQ(picked.morsel_size, state->end - state->start);
+      EXPECT_GT(picked.pipeline_progress, last_progress);
+      last_progress = picked.pipeline_progress;
+      for (size_t k = state->start; k < state->end; ++k) {
+         seen[k]++;
+      }
+   }
+   EXPECT_DOUBLE_EQ(last_progress, 1.0);
+   EXPECT_TRUE(std::all_of(seen.begin(), seen.end(), [](size_t count) { return count == 1; }));
+}
+
 }
 
 }
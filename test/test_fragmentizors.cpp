@@ -3,6 +3,7 @@
 #include "interpreter/FragmentCache.h"
 #include "codegen/backend_c/BackendC.h"
 #include "exec/InterruptableJob.h"
+#include "algebra/suboperators/ColumnFilter.h"
 
 namespace inkfuse {
 
@@ -35,6 +36,24 @@ TEST(test_fragmentizors, fragment_cache) {
    }
 }
 
+TEST(test_fragmentizors, branch_free_filter_fragments) {
+   auto& cache = FragmentCache::instance();
+   IU pseudo(IR::Void::build());
+   for (auto type : {IR::SignedInt::build(4), IR::UnsignedInt::build(8), IR::Float::build(8)}) {
+      IU in(type);
+      IU out(type);
+      // Regular filters can also be interpreted without branches.
+      auto logic = ColumnFilterLogic::build(nullptr, pseudo, in, out);
+      auto& as_logic = static_cast<ColumnFilterLogic&>(*logic);
+      EXPECT_NE(as_logic.branchFreeId(), as_logic.id());
+      EXPECT_NE(nullptr, cache.getFragment(as_logic.id()));
+      EXPECT_NE(nullptr, cache.getFragment(as_logic.branchFreeId()));
+      // Filters on themselves always branch.
+      auto self_logic = ColumnFilterLogic::build(nullptr, pseudo, in, out, IR::Bool::build(), true);
+      EXPECT_EQ(static_cast<ColumnFilterLogic&>(*self_logic).branchFreeId(), "");
+   }
+}
+
 }
 
 }
@@ -1,4 +1,5 @@
 #include "storage/Relation.h"
+#include "common/Helpers.h"
 #include <cstring>
 #include <random>
 #include <gtest/gtest.h>
@@ -113,6 +114,40 @@ TEST(test_storage, load_dates) {
    }
 }
 
+/// Test that decimals are loaded as scaled integers.
+TEST(test_storage, load_decimals) {
+   StoredRelation rel;
+   auto& narrow = rel.attachPODColumn("narrow", IR::Decimal::build(10, 2));
+   auto& wide = rel.attachPODColumn("wide", IR::Decimal::build(30, 3));
+   const std::vector<std::pair<std::string, int64_t>> narrow_vals{
+      {"12.34", 1234},
+      {"-0.5", -50},
+      {"7", 700},
+      // Digits beyond the scale are truncated.
+      {"1.239", 123},
+      {"00012345678.9", 1234567890},
+   };
+   for (auto& [str, val] : narrow_vals) {
+      narrow.loadValue(str.data(), str.size());
+   }
+   const std::string wide_str = "-123456789012345678901.5";
+   wide.loadValue(wide_str.data(), wide_str.size());
+
+   auto data = reinterpret_cast<int64_t*>(narrow.getRawData());
+   for (size_t k = 0; k < narrow_vals.size(); ++k) {
+      EXPECT_EQ(data[k], narrow_vals[k].second);
+   }
+   __int128 wide_val;
+   std::memcpy(&wide_val, wide.getRawData(), sizeof(wide_val));
+   EXPECT_EQ(helpers::decimalIntToStr(wide_val, 3), "-123456789012345678901.500");
+   EXPECT_EQ(helpers::decimalIntToStr(-5, 2), "-0.05");
+   EXPECT_EQ(helpers::decimalIntToStr(700, 0), "700");
+
+   // Values exceeding the precision are rejected.
+   const std::string too_large = "123456789.00";
+   EXPECT_THROW(narrow.loadValue(too_large.data(), too_large.size()), std::runtime_error);
+}
+
 /// Test that strings can be loaded from text.
 TEST(test_storage, load_strings) {
    StoredRelation rel;
@@ -132,6 +167,169 @@ TEST(test_storage, load_strings) {
       EXPECT_EQ(0, std::strcmp(data[k], strings[k].data()));
    }
 }
+
+/// Test that partitioning a relation across NUMA nodes retains the column contents.
+TEST(test_storage, partition_numa) {
+   const size_t num_rows = 3 * StoredRelation::SEGMENT_GRANULE + 17;
+   StoredRelation rel;
+   auto& ints = rel.attachPODColumn("ints", IR::UnsignedInt::build(4));
+   auto& strs = rel.attachStringColumn("strs");
+   for (size_t k = 0; k < num_rows; ++k) {
+      std::string val_str = std::to_string(k);
+      ints.loadValue(val_str.data(), val_str.size());
+      strs.loadValue(val_str.data(), val_str.size());
+   }
+   // Partition for more nodes than the machine might have, placement then simply wraps around.
+   rel.partitionNuma(2);
+   const auto segments = rel.getSegments();
+   ASSERT_EQ(segments.size(), 2);
+   EXPECT_EQ(segments[0].begin, 0);
+   EXPECT_EQ(segments[0].end, 2 * StoredRelation::SEGMENT_GRANULE);
+   EXPECT_EQ(segments[0].node, 0);
+   EXPECT_EQ(segments[1].begin, 2 * StoredRelation::SEGMENT_GRANULE);
+   EXPECT_EQ(segments[1].end, num_rows);
+   EXPECT_EQ(segments[1].node, 1);
+
+   EXPECT_EQ(ints.length(), num_rows);
+   EXPECT_EQ(strs.length(), num_rows);
+   auto int_data = reinterpret_cast<uint32_t*>(ints.getRawData());
+   auto str_data = reinterpret_cast<char**>(strs.getRawData());
+   for (size_t k = 0; k < num_rows; ++k) {
+      EXPECT_EQ(int_data[k], k);
+      EXPECT_EQ(std::to_string(k), str_data[k]);
+   }
+   // The relation is read-only after partitioning.
+   EXPECT_ANY_THROW(ints.loadValue("1", 1));
+}
+
+/// Test that empty fields of nullable columns are loaded as NULLs.
+TEST(test_storage, load_nulls) {
+   StoredRelation rel;
+   auto& ints = rel.attachPODColumn("ints", IR::SignedInt::build(4), true);
+   auto& strs = rel.attachStringColumn("strs", true);
+   auto& non_null = rel.attachPODColumn("non_null", IR::SignedInt::build(4));
+   // Span multiple bitmap words.
+   const size_t num_rows = 200;
+   for (size_t k = 0; k < num_rows; ++k) {
+      std::string val = k % 3 == 0 ? "" : std::to_string(k);
+      std::string str = k % 7 == 0 ? "" : std::to_string(k);
+      rel.loadRow(val + "|" + str + "|" + std::to_string(k) + "|");
+   }
+   EXPECT_EQ(ints.nullCount(), 67);
+   EXPECT_EQ(strs.nullCount(), 29);
+   EXPECT_EQ(non_null.nullCount(), 0);
+   EXPECT_ANY_THROW(non_null.loadNull());
+
+   auto int_data = reinterpret_cast<int32_t*>(ints.getRawData());
+   auto str_data = reinterpret_cast<char**>(strs.getRawData());
+   const uint64_t* int_valid = ints.getBlockValidity(0);
+   const uint64_t* str_valid = strs.getBlockValidity(0);
+   // Columns without NULLs get a fully valid bitmap once it is scanned.
+   const uint64_t* non_null_valid = non_null.getBlockValidity(0);
+   auto is_valid = [](const uint64_t* bits, size_t row) {
+      return static_cast<bool>((bits[row / 64] >> (row % 64)) & 1);
+   };
+   for (size_t k = 0; k < num_rows; ++k) {
+      EXPECT_EQ(ints.isNull(k), k % 3 == 0);
+      EXPECT_EQ(is_valid(int_valid, k), k % 3 != 0);
+      EXPECT_EQ(int_data[k], k % 3 == 0 ? 0 : k);
+      EXPECT_EQ(strs.isNull(k), k % 7 == 0);
+      EXPECT_EQ(is_valid(str_valid, k), k % 7 != 0);
+      // NULL strings still point to valid memory.
+      EXPECT_EQ(std::string(str_data[k]), k % 7 == 0 ? "" : std::to_string(k));
+      EXPECT_TRUE(is_valid(non_null_valid, k));
+   }
+}
+
+/// Test the value range statistics of integer columns.
+TEST(test_storage, value_range) {
+   StoredRelation rel;
+   auto& ints = rel.attachPODColumn("ints", IR::SignedInt::build(2), true);
+   auto& dates = rel.attachPODColumn("dates", IR::Date::build());
+   auto& floats = rel.attachPODColumn("floats", IR::Float::build(8));
+   auto& empty = rel.attachPODColumn("empty", IR::UnsignedInt::build(8), true);
+   for (int k = -20; k < 30; ++k) {
+      // NULLs are stored as zero but must not widen the range.
+      std::string val = k % 4 == 0 ? "" : std::to_string(k + 50);
+      rel.loadRow(val + "|1995-0" + std::to_string((k + 20) % 9 + 1) + "-01|" + std::to_string(k) + ".5||");
+   }
+   auto range = ints.valueRange();
+   ASSERT_TRUE(range);
+   EXPECT_EQ(range->min, 31);
+   EXPECT_EQ(range->max, 79);
+   auto date_range = dates.valueRange();
+   ASSERT_TRUE(date_range);
+   EXPECT_EQ(date_range->min, helpers::dateStrToInt("1995-01-01"));
+   EXPECT_EQ(date_range->max, helpers::dateStrToInt("1995-09-01"));
+   EXPECT_FALSE(floats.valueRange());
+   EXPECT_FALSE(empty.valueRange());
+
+   // Writes through the backing storage invalidate the cached range.
+   auto& storage = ints.getStorage();
+   reinterpret_cast<int16_t*>(storage.data())[1] = -7;
+   range = ints.valueRange();
+   ASSERT_TRUE(range);
+   EXPECT_EQ(range->min, -7);
+}
+
+/// Test that appended rows end up in fixed-size segments behind the bulk loaded ones.
+TEST(test_storage, append_segments) {
+   StoredRelation rel;
+   auto& ints = rel.attachPODColumn("ints", IR::UnsignedInt::build(8));
+   auto& strs = rel.attachStringColumn("strs", true);
+   const size_t bulk_rows = 100;
+   for (size_t k = 0; k < bulk_rows; ++k) {
+      rel.loadRow(std::to_string(k) + "|" + std::to_string(k) + "|");
+   }
+   const auto before = rel.snapshot();
+   EXPECT_EQ(before.segment_count, 0);
+   EXPECT_EQ(before.row_count, bulk_rows);
+
+   const size_t appended = 2 * StoredRelation::APPEND_SEGMENT_SIZE + 10;
+   for (size_t k = bulk_rows; k < bulk_rows + appended; ++k) {
+      // Only the last segment contains NULLs.
+      const bool is_null = k >= bulk_rows + 2 * StoredRelation::APPEND_SEGMENT_SIZE && k % 2 == 0;
+      rel.appendRow(std::to_string(k) + "|" + (is_null ? "" : std::to_string(k)) + "|");
+   }
+   // Bulk loading is no longer possible.
+   EXPECT_ANY_THROW(rel.loadRow("1|1|"));
+   EXPECT_ANY_THROW(rel.partitionNuma(1));
+
+   // Old snapshots don't see the appended rows.
+   const auto old_segments = rel.getSegments(before);
+   ASSERT_EQ(old_segments.size(), 1);
+   EXPECT_EQ(old_segments[0].end, bulk_rows);
+
+   const auto after = rel.snapshot();
+   EXPECT_EQ(after.segment_count, 3);
+   EXPECT_EQ(after.row_count, bulk_rows + appended);
+   const auto segments = rel.getSegments(after);
+   ASSERT_EQ(segments.size(), 4);
+   for (size_t k = 1; k < segments.size(); ++k) {
+      EXPECT_EQ(segments[k].begin, segments[k - 1].end);
+      EXPECT_EQ(segments[k].block, k);
+      EXPECT_EQ(segments[k].block_begin, segments[k].begin);
+   }
+   EXPECT_EQ(segments.back().end, bulk_rows + appended);
+
+   auto int_blocks = rel.getColumnBlocks("ints", after);
+   auto str_blocks = rel.getColumnBlocks("strs", after);
+   auto validity_blocks = rel.getValidityBlocks("strs", after);
+   ASSERT_EQ(int_blocks.size(), 4);
+   for (const auto& segment : segments) {
+      for (size_t row = segment.begin; row < segment.end; ++row) {
+         const size_t idx = row - segment.block_begin;
+         const bool is_null = strs.isNull(row);
+         EXPECT_EQ(reinterpret_cast<uint64_t*>(int_blocks[segment.block])[idx], row);
+         const auto bits = reinterpret_cast<uint64_t*>(validity_blocks[segment.block]);
+         EXPECT_EQ(static_cast<bool>((bits[idx / 64] >> (idx % 64)) & 1), !is_null);
+         EXPECT_EQ(std::string(reinterpret_cast<char**>(str_blocks[segment.block])[idx]), is_null ? "" : std::to_string(row));
+      }
+   }
+   EXPECT_EQ(strs.nullCount(), 5);
+   // Bulk loaded storage stays untouched.
+   EXPECT_EQ(ints.length(), bulk_rows);
+}
 }
 
 }
\ No newline at end of file
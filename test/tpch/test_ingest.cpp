@@ -1,5 +1,6 @@
 #include "common/TPCH.h"
 #include "common/Helpers.h"
+#include "common/Numa.h"
 #include "gtest/gtest.h"
 #include <cstring>
 
@@ -57,6 +58,13 @@ TEST(test_ingest, testdata) {
    helpers::loadDataInto(schema, "test/tpch/testdata", true);
    // Spot check the ingested tables.
    testLineitem(schema);
+   // The rows are spread across the NUMA nodes of the machine.
+   const auto segments = schema["lineitem"]->getSegments();
+   EXPECT_EQ(segments.size(), std::min<size_t>(numa::numNodes(), 2));
+   EXPECT_EQ(segments.back().end, 6005);
+   for (const auto& segment : segments) {
+      EXPECT_LT(segment.node, numa::numNodes());
+   }
 }
 
 }
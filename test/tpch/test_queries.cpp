@@ -34,11 +34,11 @@ const std::unordered_map<std::string, FunctionT> generator_map{
    {"q3", tpch::q3},
    {"q4", tpch::q4},
    {"q5", tpch::q5},
-   {"q6", tpch::q6},
+   {"q6", [](const Schema& schema) { return tpch::q6(schema); }},
    {"q13", tpch::q13},
    {"q14", tpch::q14},
    {"q18", tpch::q18},
-   {"q19", tpch::q19},
+   {"q19", [](const Schema& schema) { return tpch::q19(schema); }},
    {"q_bigjoin", tpch::q_bigjoin},
    {"l_count", tpch::l_count},
    {"l_point", tpch::l_point},
@@ -52,7 +52,7 @@ std::unordered_map<std::string, size_t> expected_rows{
    // One result for JAPAN
    {"q5", 1},
    {"q6", 1},
-   {"q13", 26},
+   {"q13", 27},
    {"q14", 1},
    {"q18", 0},
    {"q19", 0},
@@ -80,7 +80,7 @@ INSTANTIATE_TEST_CASE_P(
    tpch_queries,
    TPCHQueriesTestT,
    ::testing::Combine(
-      ::testing::Values("q1", "q3", "q4", "q5", "q6", "q14", "q18", "q19", "l_count", "q_bigjoin", "l_point"),
+      ::testing::Values("q1", "q3", "q4", "q5", "q6", "q13", "q14", "q18", "q19", "l_count", "q_bigjoin", "l_point"),
       ::testing::Values(
          PipelineExecutor::ExecutionMode::Fused,
          PipelineExecutor::ExecutionMode::Interpreted,
@@ -6,6 +6,7 @@
 #include "interpreter/FragmentCache.h"
 #include <chrono>
 #include <fstream>
+#include <functional>
 #include <iostream>
 #include <string>
 #include <vector>
@@ -33,17 +34,26 @@ If you want to demo inkfuse in a more interactive way try out the inkfuse_runner
 binary instead.
 )";
 
+/// Builds a query. Repetitions of a query share the statistics of its adaptive filters.
+using QueryBuilder = std::function<std::unique_ptr<Print>(const Schema&, tpch::FilterStatistics&)>;
+
+/// Build a query without adaptive filters.
+template <std::unique_ptr<Print> (*query)(const Schema&)>
+QueryBuilder plain() {
+   return [](const Schema& schema, tpch::FilterStatistics&) { return query(schema); };
+}
+
 /// The queries used for benchmarking.
-const std::vector<std::pair<std::string, decltype(tpch::q1)*>> queries = {
-   {"q1", tpch::q1},
-   {"q3", tpch::q3},
-   {"q4", tpch::q4},
-   {"q5", tpch::q5},
-   {"q6", tpch::q6},
-   {"q13", tpch::q13},
-   {"q14", tpch::q14},
-   {"q19", tpch::q19},
-   {"q_bigjoin", tpch::q_bigjoin},
+const std::vector<std::pair<std::string, QueryBuilder>> queries = {
+   {"q1", plain<tpch::q1>()},
+   {"q3", plain<tpch::q3>()},
+   {"q4", plain<tpch::q4>()},
+   {"q5", plain<tpch::q5>()},
+   {"q6", [](const Schema& schema, tpch::FilterStatistics& stats) { return tpch::q6(schema, &stats); }},
+   {"q13", plain<tpch::q13>()},
+   {"q14", plain<tpch::q14>()},
+   {"q19", [](const Schema& schema, tpch::FilterStatistics& stats) { return tpch::q19(schema, &stats); }},
+   {"q_bigjoin", plain<tpch::q_bigjoin>()},
 };
 
 /// The execution modes used for benchmarking.
@@ -52,6 +62,7 @@ const std::vector<std::pair<std::string, PipelineExecutor::ExecutionMode>> backe
    {"interpreted", PipelineExecutor::ExecutionMode::Interpreted},
    {"fused", PipelineExecutor::ExecutionMode::Fused},
    {"rof", PipelineExecutor::ExecutionMode::ROF},
+   {"cost_based", PipelineExecutor::ExecutionMode::CostBased},
 };
 }
 
@@ -108,8 +119,10 @@ int main(int argc, char* argv[]) {
          const auto& [q_name, query_f] = queries[k];
          params.setParam("query", q_name);
          std::cout << "Benchmarking query " << q_name << "\n";
+         // Fresh statistics for every backend, the repetitions learn from each other.
+         tpch::FilterStatistics filter_stats;
          for (int32_t rep = 0; rep < reps; ++rep) {
-            auto root = query_f(schema);
+            auto root = query_f(schema, filter_stats);
             auto control_block = std::make_shared<PipelineExecutor::QueryControlBlock>(std::move(root));
             const auto start = std::chrono::steady_clock::now();
             PipelineExecutor::PipelineStats query_stats;
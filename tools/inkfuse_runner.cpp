@@ -25,7 +25,7 @@ unmute - do show query text
 threads <K> - set number of worker threads to k, default 1  
 mode <ExecMode> - change default execution mode  
 run q<N> [mode <ExecMode>] - run TPC-H query <N> on the loaded sf<X>
-                             optional ExecMode in {Compiled, Interpreted, Hybrid, ROF}
+                             optional ExecMode in {Compiled, Interpreted, Hybrid, ROF, CostBased}
                              default Hybrid.
 )";
 
@@ -41,6 +41,22 @@ std::vector<std::string> splitCommand(const std::string& command) {
    return elems;
 }
 
+const char* modeName(PipelineExecutor::ExecutionMode mode) {
+   switch (mode) {
+      case PipelineExecutor::ExecutionMode::Fused:
+         return "Compiled";
+      case PipelineExecutor::ExecutionMode::Interpreted:
+         return "Interpreted";
+      case PipelineExecutor::ExecutionMode::ROF:
+         return "ROF";
+      case PipelineExecutor::ExecutionMode::Hybrid:
+         return "Hybrid";
+      case PipelineExecutor::ExecutionMode::CostBased:
+         return "CostBased";
+   }
+   return "Unknown";
+}
+
 void runQuery(const std::string& q_name, std::unique_ptr<Print> root, PipelineExecutor::ExecutionMode mode, size_t num_threads) {
    static size_t q_id = 0;
    std::ifstream input("q/" + q_name + ".sql");
@@ -61,6 +77,14 @@ void runQuery(const std::string& q_name, std::unique_ptr<Print> root, PipelineEx
    std::cout << " (" << stats.codegen_microseconds << " codegen micros; ";
    std::cout << stats.runtime_microseconds_st << " runtime micros st; ";
    std::cout << stats.runtime_microseconds_mt << " runtime micros mt)\n";
+   if (mode == PipelineExecutor::ExecutionMode::CostBased) {
+      // Show the modes the cost model picked.
+      std::cout << "Pipeline modes:";
+      for (auto pipe_mode : stats.modes) {
+         std::cout << " " << modeName(pipe_mode);
+      }
+      std::cout << "\n";
+   }
 }
 
 } // namespace
@@ -81,6 +105,8 @@ int main(int argc, char* argv[]) {
    // Only ingest data once and share it across tests.
    std::optional<Schema> loaded;
    std::string loaded_name;
+   // What the adaptive filters learned on the loaded data.
+   tpch::FilterStatistics filter_stats;
 
    size_t thread_count = 1;
    PipelineExecutor::ExecutionMode default_mode = PipelineExecutor::ExecutionMode::Hybrid;
@@ -93,6 +119,8 @@ int main(int argc, char* argv[]) {
          return PipelineExecutor::ExecutionMode::Hybrid;
       } else if (str == "ROF") {
          return PipelineExecutor::ExecutionMode::ROF;
+      } else if (str == "CostBased") {
+         return PipelineExecutor::ExecutionMode::CostBased;
       } else {
          return std::nullopt;
       }
@@ -143,7 +171,7 @@ int main(int argc, char* argv[]) {
             }
          } else if (split[0] == "mode") {
             if (split.size() < 2) {
-               std::cout << "invoke 'mode' as 'mode <ExecMode>' where <ExecMode> in {Compiled|Interpreted|Hybrid|ROF}\n"
+               std::cout << "invoke 'mode' as 'mode <ExecMode>' where <ExecMode> in {Compiled|Interpreted|Hybrid|ROF|CostBased}\n"
                          << std::endl;
             } else {
                std::optional<PipelineExecutor::ExecutionMode> res = parse_mode(split[1]);
@@ -151,7 +179,7 @@ int main(int argc, char* argv[]) {
                   std::cout << "Setting default mode to " << split[1] << std::endl;
                   default_mode = *res;
                } else {
-                  std::cout << "Unrecognized execution mode - we only support {Compiled|Interpreted|Hybrid|ROF}\n"
+                  std::cout << "Unrecognized execution mode - we only support {Compiled|Interpreted|Hybrid|ROF|CostBased}\n"
                             << std::endl;
                   continue;
                }
@@ -168,7 +196,7 @@ int main(int argc, char* argv[]) {
                if (split.size() > 2 && split[2] == "mode") {
                   std::optional<PipelineExecutor::ExecutionMode> res = parse_mode(split[3]);
                   if (!res) {
-                     std::cout << "Unrecognized execution mode - we only support {Compiled|Interpreted|Hybrid|ROF}\n"
+                     std::cout << "Unrecognized execution mode - we only support {Compiled|Interpreted|Hybrid|ROF|CostBased}\n"
                                << std::endl;
                      continue;
                   }
@@ -187,7 +215,7 @@ int main(int argc, char* argv[]) {
                   auto q = tpch::q5(*loaded);
                   runQuery("q5", std::move(q), mode, thread_count);
                } else if (split[1] == "q6") {
-                  auto q = tpch::q6(*loaded);
+                  auto q = tpch::q6(*loaded, &filter_stats);
                   runQuery("q6", std::move(q), mode, thread_count);
                } else if (split[1] == "q13") {
                   auto q = tpch::q13(*loaded);
@@ -199,7 +227,7 @@ int main(int argc, char* argv[]) {
                   auto q = tpch::q18(*loaded);
                   runQuery("q18", std::move(q), mode, thread_count);
                } else if (split[1] == "q19") {
-                  auto q = tpch::q19(*loaded);
+                  auto q = tpch::q19(*loaded, &filter_stats);
                   runQuery("q19", std::move(q), mode, thread_count);
                } else if (split[1] == "q_bigjoin") {
                   auto q = tpch::q_bigjoin(*loaded);